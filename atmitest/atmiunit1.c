@@ -695,6 +695,62 @@ Ensure(test089_tmrecover)
     assert_equal(ret, EXSUCCEED);
 }
 
+Ensure(test090_cmpcthdr)
+{
+    int ret;
+    ret=system_dbg("test090_cmpcthdr/run.sh");
+    assert_equal(ret, EXSUCCEED);
+}
+
+Ensure(test091_lmsgpool)
+{
+    int ret;
+    ret=system_dbg("test091_lmsgpool/run.sh");
+    assert_equal(ret, EXSUCCEED);
+}
+
+Ensure(test092_calltrace)
+{
+    int ret;
+    ret=system_dbg("test092_calltrace/run.sh");
+    assert_equal(ret, EXSUCCEED);
+}
+
+Ensure(test093_onephase)
+{
+    int ret;
+    ret=system_dbg("test093_onephase/run.sh");
+    assert_equal(ret, EXSUCCEED);
+}
+
+Ensure(test094_convpool)
+{
+    int ret;
+    ret=system_dbg("test094_convpool/run.sh");
+    assert_equal(ret, EXSUCCEED);
+}
+
+Ensure(test095_brcredit)
+{
+    int ret;
+    ret=system_dbg("test095_brcredit/run.sh");
+    assert_equal(ret, EXSUCCEED);
+}
+
+Ensure(test096_tmqsched)
+{
+    int ret;
+    ret=system_dbg("test096_tmqsched/run.sh");
+    assert_equal(ret, EXSUCCEED);
+}
+
+Ensure(test097_brcmpr)
+{
+    int ret;
+    ret=system_dbg("test097_brcmpr/run.sh");
+    assert_equal(ret, EXSUCCEED);
+}
+
 TestSuite *atmi_test_all(void)
 {
     TestSuite *suite = create_test_suite();
@@ -840,6 +896,14 @@ TestSuite *atmi_test_all(void)
     add_test(suite, test087_tmsrv);
     add_test(suite, test088_addlog);
     add_test(suite, test089_tmrecover);
+    add_test(suite, test090_cmpcthdr);
+    add_test(suite, test091_lmsgpool);
+    add_test(suite, test092_calltrace);
+    add_test(suite, test093_onephase);
+    add_test(suite, test094_convpool);
+    add_test(suite, test095_brcredit);
+    add_test(suite, test096_tmqsched);
+    add_test(suite, test097_brcmpr);
     
     return suite;
 }
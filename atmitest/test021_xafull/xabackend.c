@@ -431,6 +431,12 @@ expublic int xa_commit_entry(struct xa_switch_t *sw, XID *xid, int rmid, long fl
         return XAER_RMERR;
     }
     
+    /* one-phase commit, branch is not prepared */
+    if ((flags & TMONEPHASE) && 
+            EXSUCCEED!=file_move(xid, rmid, "active", "prepared"))
+    {
+        return XAER_RMERR;
+    }
     
     if (EXSUCCEED!=file_move(xid, rmid, "prepared", "committed"))
     {
@@ -0,0 +1,159 @@
+#!/bin/bash
+##
+## @brief @(#) See README. In-process L1 tier
+##
+## @file 23_run_l1.sh
+##
+## -----------------------------------------------------------------------------
+## Enduro/X Middleware Platform for Distributed Transaction Processing
+## Copyright (C) 2009-2016, ATR Baltic, Ltd. All Rights Reserved.
+## Copyright (C) 2017-2019, Mavimax, Ltd. All Rights Reserved.
+## This software is released under one of the following licenses:
+## AGPL (with Java and Go exceptions) or Mavimax's license for commercial use.
+## See LICENSE file for full text.
+## -----------------------------------------------------------------------------
+## AGPL license:
+##
+## This program is free software; you can redistribute it and/or modify it under
+## the terms of the GNU Affero General Public License, version 3 as published
+## by the Free Software Foundation;
+##
+## This program is distributed in the hope that it will be useful, but WITHOUT ANY
+## WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+## PARTICULAR PURPOSE. See the GNU Affero General Public License, version 3
+## for more details.
+##
+## You should have received a copy of the GNU Affero General Public License along 
+## with this program; if not, write to the Free Software Foundation, Inc.,
+## 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+##
+## -----------------------------------------------------------------------------
+## A commercial use license is available from Mavimax, Ltd
+## contact@mavimax.com
+## -----------------------------------------------------------------------------
+##
+
+export TESTNAME="test048_cache"
+
+PWD=`pwd`
+if [ `echo $PWD | grep $TESTNAME ` ]; then
+    # Do nothing 
+    echo > /dev/null
+else
+    # started from parent folder
+    pushd .
+    echo "Doing cd"
+    cd $TESTNAME
+fi;
+
+export NDRX_CCONFIG=`pwd`
+. ../testenv.sh
+
+export TESTDIR="$NDRX_APPHOME/atmitest/$TESTNAME"
+export PATH=$PATH:$TESTDIR
+export NDRX_TOUT=10
+export NDRX_ULOG=$TESTDIR
+
+source ./test-func-include.sh
+
+export TESTDIR_DB=$TESTDIR
+export TESTDIR_SHM=$TESTDIR
+#
+# Domain 1 - here client will live
+#
+set_dom1() {
+    echo "Setting domain 1"
+    . ../dom1.sh
+    export NDRX_CONFIG=$TESTDIR/ndrxconfig-dom1.xml
+    export NDRX_DMNLOG=$TESTDIR/ndrxd-dom1.log
+    export NDRX_LOG=$TESTDIR/ndrx-dom1.log
+    export NDRX_CCTAG=dom1
+}
+
+#
+# Generic exit function
+#
+function go_out {
+    echo "Test exiting with: $1"
+    
+    set_dom1;
+    xadmin stop -y
+    xadmin down -y
+
+
+
+    # If some alive stuff left...
+    xadmin killall atmiclt48
+
+    popd 2>/dev/null
+    exit $1
+}
+
+rm *.log
+# Any bridges that are live must be killed!
+xadmin killall tpbridge
+
+set_dom1;
+xadmin down -y
+xadmin start -y || go_out 1
+
+RET=0
+
+set_dom1;
+xadmin psc
+xadmin ppm
+xadmin pc
+
+
+echo "Running off client"
+
+echo "First call goes to service, next ones to cache (L1 after first db read)"
+(time NDRX_CCTAG=dom1/l1 ./testtool48 -sTESTSV23 -b '{"T_STRING_FLD":"KEY1"}' \
+    -m '{"T_STRING_FLD":"KEY1"}' \
+    -cY -n100 -fY 2>&1) > ./23_testtool48.log
+
+if [ $? -ne 0 ]; then
+    echo "testtool48 failed (1)"
+    go_out 1
+fi
+
+CNT=`grep "L1 hit \[SV23KEY1\]" 23_testtool48-l1.log | wc | awk '{ print $1 }'`
+echo "L1 hits: [$CNT]"
+
+if [[ $CNT -lt 90 ]]; then
+    echo "TESTERROR: L1 hits expected, got [$CNT]!"
+    go_out 2
+fi
+
+echo "New process starts with empty L1, data shall come from db"
+rm 23_testtool48-l1.log
+(time NDRX_CCTAG=dom1/l1 ./testtool48 -sTESTSV23 -b '{"T_STRING_FLD":"KEY1"}' \
+    -m '{"T_STRING_FLD":"KEY1"}' \
+    -cY -n1 -fN 2>&1) >> ./23_testtool48.log
+
+if [ $? -ne 0 ]; then
+    echo "testtool48 failed (2)"
+    go_out 3
+fi
+
+if [ "X`grep 'L1 hit' 23_testtool48-l1.log`" != "X" ]; then
+    echo "TESTERROR: L1 of new process must be empty!"
+    go_out 4
+fi
+
+echo "L1 with lru/hits db is config error - tpinit shall fail"
+(time NDRX_CCONFIG1=$TESTDIR/23_l1lru.bad ./testtool48 -sTESTSV23LRU \
+    -b '{"T_STRING_FLD":"KEY1"}' -m '{"T_STRING_FLD":"KEY1"}' \
+    -cN -n1 -fN 2>&1) >> ./23_testtool48.log
+
+if [ $? -eq 0 ]; then
+    echo "TESTERROR: testtool48 must fail on l1max with lru db!"
+    go_out 5
+fi
+
+ensure_keys db23 1
+ensure_field db23 SV23KEY1 T_STRING_FLD KEY1 1
+
+go_out $RET
+
+# vim: set ts=4 sw=4 et smartindent:
@@ -0,0 +1,180 @@
+#!/bin/bash
+##
+## @brief @(#) See README. Single-flight refresh of concurrent misses
+##
+## @file 24_run_singleflight.sh
+##
+## -----------------------------------------------------------------------------
+## Enduro/X Middleware Platform for Distributed Transaction Processing
+## Copyright (C) 2009-2016, ATR Baltic, Ltd. All Rights Reserved.
+## Copyright (C) 2017-2019, Mavimax, Ltd. All Rights Reserved.
+## This software is released under one of the following licenses:
+## AGPL (with Java and Go exceptions) or Mavimax's license for commercial use.
+## See LICENSE file for full text.
+## -----------------------------------------------------------------------------
+## AGPL license:
+##
+## This program is free software; you can redistribute it and/or modify it under
+## the terms of the GNU Affero General Public License, version 3 as published
+## by the Free Software Foundation;
+##
+## This program is distributed in the hope that it will be useful, but WITHOUT ANY
+## WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+## PARTICULAR PURPOSE. See the GNU Affero General Public License, version 3
+## for more details.
+##
+## You should have received a copy of the GNU Affero General Public License along 
+## with this program; if not, write to the Free Software Foundation, Inc.,
+## 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+##
+## -----------------------------------------------------------------------------
+## A commercial use license is available from Mavimax, Ltd
+## contact@mavimax.com
+## -----------------------------------------------------------------------------
+##
+
+export TESTNAME="test048_cache"
+
+PWD=`pwd`
+if [ `echo $PWD | grep $TESTNAME ` ]; then
+    # Do nothing 
+    echo > /dev/null
+else
+    # started from parent folder
+    pushd .
+    echo "Doing cd"
+    cd $TESTNAME
+fi;
+
+export NDRX_CCONFIG=`pwd`
+. ../testenv.sh
+
+export TESTDIR="$NDRX_APPHOME/atmitest/$TESTNAME"
+export PATH=$PATH:$TESTDIR
+export NDRX_TOUT=10
+export NDRX_ULOG=$TESTDIR
+
+source ./test-func-include.sh
+
+export TESTDIR_DB=$TESTDIR
+export TESTDIR_SHM=$TESTDIR
+#
+# Domain 1 - here client will live
+#
+set_dom1() {
+    echo "Setting domain 1"
+    . ../dom1.sh
+    export NDRX_CONFIG=$TESTDIR/ndrxconfig-dom1.xml
+    export NDRX_DMNLOG=$TESTDIR/ndrxd-dom1.log
+    export NDRX_LOG=$TESTDIR/ndrx-dom1.log
+    export NDRX_CCTAG=dom1
+}
+
+#
+# Generic exit function
+#
+function go_out {
+    echo "Test exiting with: $1"
+    
+    set_dom1;
+    xadmin stop -y
+    xadmin down -y
+
+
+
+    # If some alive stuff left...
+    xadmin killall atmiclt48
+
+    popd 2>/dev/null
+    exit $1
+}
+
+rm *.log
+# Any bridges that are live must be killed!
+xadmin killall tpbridge
+
+set_dom1;
+xadmin down -y
+xadmin start -y || go_out 1
+
+RET=0
+
+set_dom1;
+xadmin psc
+xadmin ppm
+xadmin pc
+
+
+echo "Running off client"
+
+#
+# SLOWSVC takes 3 sec, all the callers shall be started while the first one
+# is in the service. Only one backend call shall be made, the others wait
+# for the record and get the fresh data from cache.
+#
+echo "Concurrent misses: 2 processes x 5 threads"
+(time ./testtool48 -sTESTSV24 -b '{"T_STRING_FLD":"KEY1"}' \
+    -m '{"T_STRING_FLD":"KEY1"}' \
+    -cN -n1 -fY -t5 2>&1) > ./24_testtool48_1.log &
+
+(time ./testtool48 -sTESTSV24 -b '{"T_STRING_FLD":"KEY1"}' \
+    -m '{"T_STRING_FLD":"KEY1"}' \
+    -cN -n1 -fY -t5 2>&1) > ./24_testtool48_2.log &
+
+FAIL=0
+
+for job in `jobs -p`
+do
+echo $job
+    wait $job || let "FAIL+=1"
+done
+
+echo "FAIL=$FAIL"
+
+if [ $FAIL -ne 0 ]; then
+    echo "some process failed!!!"
+    go_out 1
+fi
+
+CNT=`grep "SLOWSVC call \[KEY1\]" atmisv48-dom1.log | wc | awk '{ print $1 }'`
+echo "Backend calls: [$CNT]"
+
+if [[ "X$CNT" != "X1" ]]; then
+    echo "TESTERROR: Expected single backend call for KEY1, got [$CNT]!"
+    go_out 2
+fi
+
+echo "Record is cached, no more backend calls"
+(time ./testtool48 -sTESTSV24 -b '{"T_STRING_FLD":"KEY1"}' \
+    -m '{"T_STRING_FLD":"KEY1"}' \
+    -cY -n10 -fN 2>&1) >> ./24_testtool48_1.log
+
+if [ $? -ne 0 ]; then
+    echo "testtool48 failed (3)"
+    go_out 3
+fi
+
+CNT=`grep "SLOWSVC call \[KEY1\]" atmisv48-dom1.log | wc | awk '{ print $1 }'`
+
+if [[ "X$CNT" != "X1" ]]; then
+    echo "TESTERROR: Expected no new backend calls for KEY1, got [$CNT]!"
+    go_out 4
+fi
+
+echo "Other key is not blocked by KEY1 claim"
+(time ./testtool48 -sTESTSV24 -b '{"T_STRING_FLD":"KEY2"}' \
+    -m '{"T_STRING_FLD":"KEY2"}' \
+    -cY -n2 -fY 2>&1) >> ./24_testtool48_1.log
+
+if [ $? -ne 0 ]; then
+    echo "testtool48 failed (5)"
+    go_out 5
+fi
+
+ensure_keys db24 2
+ensure_field db24 SV24KEY1 T_STRING_FLD KEY1 1
+ensure_field db24 SV24KEY2 T_STRING_FLD KEY2 1
+
+go_out $RET
+
+# vim: set ts=4 sw=4 et smartindent:
@@ -0,0 +1,187 @@
+#!/bin/bash
+##
+## @brief @(#) See README. Indexed expiry and limit eviction order
+##
+## @file 25_run_index.sh
+##
+## -----------------------------------------------------------------------------
+## Enduro/X Middleware Platform for Distributed Transaction Processing
+## Copyright (C) 2009-2016, ATR Baltic, Ltd. All Rights Reserved.
+## Copyright (C) 2017-2019, Mavimax, Ltd. All Rights Reserved.
+## This software is released under one of the following licenses:
+## AGPL (with Java and Go exceptions) or Mavimax's license for commercial use.
+## See LICENSE file for full text.
+## -----------------------------------------------------------------------------
+## AGPL license:
+##
+## This program is free software; you can redistribute it and/or modify it under
+## the terms of the GNU Affero General Public License, version 3 as published
+## by the Free Software Foundation;
+##
+## This program is distributed in the hope that it will be useful, but WITHOUT ANY
+## WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+## PARTICULAR PURPOSE. See the GNU Affero General Public License, version 3
+## for more details.
+##
+## You should have received a copy of the GNU Affero General Public License along 
+## with this program; if not, write to the Free Software Foundation, Inc.,
+## 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+##
+## -----------------------------------------------------------------------------
+## A commercial use license is available from Mavimax, Ltd
+## contact@mavimax.com
+## -----------------------------------------------------------------------------
+##
+
+export TESTNAME="test048_cache"
+
+PWD=`pwd`
+if [ `echo $PWD | grep $TESTNAME ` ]; then
+    # Do nothing 
+    echo > /dev/null
+else
+    # started from parent folder
+    pushd .
+    echo "Doing cd"
+    cd $TESTNAME
+fi;
+
+export NDRX_CCONFIG=`pwd`
+. ../testenv.sh
+
+export TESTDIR="$NDRX_APPHOME/atmitest/$TESTNAME"
+export PATH=$PATH:$TESTDIR
+export NDRX_TOUT=10
+export NDRX_ULOG=$TESTDIR
+
+source ./test-func-include.sh
+
+export TESTDIR_DB=$TESTDIR
+export TESTDIR_SHM=$TESTDIR
+#
+# Domain 1 - here client will live
+#
+set_dom1() {
+    echo "Setting domain 1"
+    . ../dom1.sh
+    export NDRX_CONFIG=$TESTDIR/ndrxconfig-dom1.xml
+    export NDRX_DMNLOG=$TESTDIR/ndrxd-dom1.log
+    export NDRX_LOG=$TESTDIR/ndrx-dom1.log
+    export NDRX_CCTAG=dom1
+}
+
+#
+# Generic exit function
+#
+function go_out {
+    echo "Test exiting with: $1"
+    
+    set_dom1;
+    xadmin stop -y
+    xadmin down -y
+
+
+
+    # If some alive stuff left...
+    xadmin killall atmiclt48
+
+    popd 2>/dev/null
+    exit $1
+}
+
+rm *.log
+# Any bridges that are live must be killed!
+xadmin killall tpbridge
+
+set_dom1;
+xadmin down -y
+xadmin start -y || go_out 1
+
+RET=0
+
+set_dom1;
+xadmin psc
+xadmin ppm
+xadmin pc
+
+
+echo "Running off client"
+
+#
+# Call the service for the key
+# $1 - service, $2 - key, $3 - Y if new record, N if from cache
+#
+call_key() {
+
+    FROM_CACHE=Y
+    if [ "$3" == "Y" ]; then
+        FROM_CACHE=N
+    fi
+
+    (time ./testtool48 -s$1 -b "{\"T_STRING_FLD\":\"$2\"}" \
+        -m "{\"T_STRING_FLD\":\"$2\"}" \
+        -c$FROM_CACHE -n1 -f$3 2>&1) >> ./25_testtool48.log
+
+    if [ $? -ne 0 ]; then
+        echo "testtool48 failed ($1 $2 $3)"
+        go_out 1
+    fi
+}
+
+echo "LRU: least recently used keys are evicted first"
+call_key TESTSV25L KEY1 Y
+call_key TESTSV25L KEY2 Y
+call_key TESTSV25L KEY3 Y
+call_key TESTSV25L KEY4 Y
+call_key TESTSV25L KEY1 N
+call_key TESTSV25L KEY5 Y
+call_key TESTSV25L KEY6 Y
+call_key TESTSV25L KEY3 N
+call_key TESTSV25L KEY7 Y
+
+echo "FIFO: oldest added keys are evicted first, hits do not matter"
+call_key TESTSV25F KEY1 Y
+call_key TESTSV25F KEY2 Y
+call_key TESTSV25F KEY3 Y
+call_key TESTSV25F KEY1 N
+call_key TESTSV25F KEY4 Y
+call_key TESTSV25F KEY5 Y
+
+echo "Expiry: only expired keys are removed"
+call_key TESTSV25X KEY1 Y
+call_key TESTSV25X KEY2 Y
+
+echo "wait for tpcached to complete scanning... (every 5 sec)"
+sleep 7
+
+ensure_keys db25l 5
+ensure_field db25l SV25LKEY1 T_STRING_FLD KEY1 1
+ensure_field db25l SV25LKEY2 T_STRING_FLD KEY2 0
+ensure_field db25l SV25LKEY3 T_STRING_FLD KEY3 1
+ensure_field db25l SV25LKEY4 T_STRING_FLD KEY4 0
+ensure_field db25l SV25LKEY5 T_STRING_FLD KEY5 1
+ensure_field db25l SV25LKEY6 T_STRING_FLD KEY6 1
+ensure_field db25l SV25LKEY7 T_STRING_FLD KEY7 1
+
+ensure_keys db25f 3
+ensure_field db25f SV25FKEY1 T_STRING_FLD KEY1 0
+ensure_field db25f SV25FKEY2 T_STRING_FLD KEY2 0
+ensure_field db25f SV25FKEY3 T_STRING_FLD KEY3 1
+ensure_field db25f SV25FKEY4 T_STRING_FLD KEY4 1
+ensure_field db25f SV25FKEY5 T_STRING_FLD KEY5 1
+
+# KEY3 is added ~16 sec after KEY1, KEY2
+sleep 8
+call_key TESTSV25X KEY3 Y
+
+# KEY1, KEY2 expire at 20 sec, KEY3 lives till ~35
+sleep 12
+
+ensure_keys db25x 1
+ensure_field db25x SV25XKEY1 T_STRING_FLD KEY1 0
+ensure_field db25x SV25XKEY2 T_STRING_FLD KEY2 0
+ensure_field db25x SV25XKEY3 T_STRING_FLD KEY3 1
+
+go_out $RET
+
+# vim: set ts=4 sw=4 et smartindent:
@@ -174,6 +174,50 @@ out:
                 0L);
 }
 
+/**
+ * Slow service entry, used for single-flight tests. Timestamp is set after
+ * the sleep, thus callers which waited for this call see the data as new.
+ * Each call is logged with the key, so that number of backend calls can be
+ * counted.
+ */
+void SLOWSVC (TPSVCINFO *p_svc)
+{
+    int ret=EXSUCCEED;
+    UBFH *p_ub = (UBFH *)p_svc->data;
+    char key[64] = "";
+    BFLDLEN len = sizeof(key);
+    long t, tusec;
+    
+    Bget(p_ub, T_STRING_FLD, 0, key, &len);
+    NDRX_LOG(log_error, "%s call [%s]", __func__, key);
+ 
+    if (NULL==(p_ub =(UBFH *)tprealloc((char *)p_ub, Bused(p_ub)+1024)))
+    {
+        NDRX_LOG(log_error, "TESTERROR: Failed to reallocate incoming buffer: %s",
+                tpstrerror(tperrno));
+        EXFAIL_OUT(ret);
+    }
+    
+    sleep(3);
+    
+    ndrx_utc_tstamp2(&t, &tusec);
+    
+    if (EXSUCCEED!=Bchg(p_ub, T_LONG_2_FLD, 0, (char *)&t, 0L) ||
+            EXSUCCEED!=Bchg(p_ub, T_LONG_2_FLD, 1, (char *)&tusec, 0L))
+    {
+        NDRX_LOG(log_error, "TESTERROR: Failed to set T_LONG_2_FLD fields: %s",
+            Bstrerror(Berror));
+        EXFAIL_OUT(ret);
+    }
+    
+out:
+    tpreturn(  ret==EXSUCCEED?TPSUCCESS:TPFAIL,
+                0L,
+                (char *)p_ub,
+                0L,
+                0L);
+}
+
 /**
  * Standard service entry, fail
  */
@@ -254,6 +298,12 @@ int NDRX_INTEGRA(tpsvrinit)(int argc, char **argv)
         EXFAIL_OUT(ret);
     }
     
+    if (EXSUCCEED!=tpadvertise("SLOWSVC", SLOWSVC))
+    {
+        NDRX_LOG(log_error, "Failed to initialize SLOWSVC!");
+        EXFAIL_OUT(ret);
+    }
+    
     if (EXSUCCEED!=tpadvertise("BENCH48", BENCH48))
     {
         NDRX_LOG(log_error, "Failed to initialize BENCH48!");
@@ -81,6 +81,9 @@ run_test "19_run_threads"
 run_test "20_run_delete"
 run_test "21_run_defaults"
 run_test "22_run_nospace"
+run_test "23_run_l1"
+run_test "24_run_singleflight"
+run_test "25_run_index"
 
 echo "*** SUMMARY $M_tests tests executed. $M_ok passes, $M_fail failures ($M_failstr)"
 
@@ -73,7 +73,7 @@ void TESTSV (TPSVCINFO *p_svc)
     }
     
     /* One from the Q must get call */
-    NDRX_LOG(log_debug, testbuf);
+    NDRX_LOG(log_debug, "%s", testbuf);
     
     sleep(5);
     
@@ -0,0 +1,185 @@
+/**
+ * @brief Compact call header, replies interleaved with unsolicited messages - client
+ *
+ * @file atmiclt90.c
+ */
+/* -----------------------------------------------------------------------------
+ * Enduro/X Middleware Platform for Distributed Transaction Processing
+ * Copyright (C) 2009-2016, ATR Baltic, Ltd. All Rights Reserved.
+ * Copyright (C) 2017-2019, Mavimax, Ltd. All Rights Reserved.
+ * This software is released under one of the following licenses:
+ * AGPL (with Java and Go exceptions) or Mavimax's license for commercial use.
+ * See LICENSE file for full text.
+ * -----------------------------------------------------------------------------
+ * AGPL license:
+ * 
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License, version 3 as published
+ * by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License, version 3
+ * for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program; if not, write to the Free Software Foundation, Inc., 
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * -----------------------------------------------------------------------------
+ * A commercial use license is available from Mavimax, Ltd
+ * contact@mavimax.com
+ * -----------------------------------------------------------------------------
+ */
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <memory.h>
+#include <unistd.h>
+
+#include <atmi.h>
+#include <ubf.h>
+#include <ndebug.h>
+#include <test.fd.h>
+#include <ndrstandard.h>
+#include <nstdutil.h>
+#include "test90.h"
+/*---------------------------Externs------------------------------------*/
+/*---------------------------Macros-------------------------------------*/
+/*---------------------------Enums--------------------------------------*/
+/*---------------------------Typedefs-----------------------------------*/
+/*---------------------------Globals------------------------------------*/
+/*---------------------------Statics------------------------------------*/
+exprivate long M_notifs = 0; /**< number of notifications received */
+/*---------------------------Prototypes---------------------------------*/
+
+/**
+ * Unsolicited message handler, counts notifications
+ */
+void notification_callback (char *data, long len, long flags)
+{
+    M_notifs++;
+}
+
+/**
+ * Issue calls, pick up notifications with tpchkunsol() (which
+ * queues the replies, received in between, to memq), then
+ * read the replies in reverse order.
+ */
+int main(int argc, char** argv)
+{
+    int ret=EXSUCCEED;
+    int cd[NR_CALLS];
+    UBFH *p_ub = NULL;
+    long rsplen;
+    long seq;
+    long expected;
+    char tmp[64];
+    char exp_str[64];
+    int i, j, tries;
+
+    if (NULL==(p_ub = (UBFH *)tpalloc("UBF", NULL, 1024)))
+    {
+        NDRX_LOG(log_error, "TESTERROR: tpalloc failed: %s",
+                tpstrerror(tperrno));
+        EXFAIL_OUT(ret);
+    }
+
+    if (NULL!=tpsetunsol(notification_callback))
+    {
+        NDRX_LOG(log_error, "TESTERROR: Previous unsol handler must be NULL!");
+        EXFAIL_OUT(ret);
+    }
+
+    for (i=0; i<NR_LOOPS; i++)
+    {
+        for (j=0; j<NR_CALLS; j++)
+        {
+            seq = i*NR_CALLS+j;
+
+            if (EXSUCCEED!=Bchg(p_ub, T_LONG_FLD, 0, (char *)&seq, 0L))
+            {
+                NDRX_LOG(log_error, "TESTERROR: Failed to set T_LONG_FLD: %s",
+                        Bstrerror(Berror));
+                EXFAIL_OUT(ret);
+            }
+
+            if (EXFAIL==(cd[j] = tpacall("CMPCTSV", (char *)p_ub, 0L, 0L)))
+            {
+                NDRX_LOG(log_error, "TESTERROR: tpacall failed: %s",
+                        tpstrerror(tperrno));
+                EXFAIL_OUT(ret);
+            }
+        }
+
+        /* wait for all notifications, replies goes to memq meanwhile */
+        expected = (i+1)*NR_CALLS;
+        tries = 0;
+
+        while (M_notifs < expected)
+        {
+            if (EXFAIL==tpchkunsol())
+            {
+                NDRX_LOG(log_error, "TESTERROR: tpchkunsol failed: %s",
+                        tpstrerror(tperrno));
+                EXFAIL_OUT(ret);
+            }
+
+            if (M_notifs < expected)
+            {
+                tries++;
+
+                if (tries > 1000)
+                {
+                    NDRX_LOG(log_error, "TESTERROR: Got %ld notifs, expected %ld",
+                            M_notifs, expected);
+                    EXFAIL_OUT(ret);
+                }
+                usleep(10000);
+            }
+        }
+
+        /* replies out of order (memq seek by cd) */
+        for (j=NR_CALLS-1; j>=0; j--)
+        {
+            if (EXFAIL==tpgetrply(&cd[j], (char **)&p_ub, &rsplen, 0L))
+            {
+                NDRX_LOG(log_error, "TESTERROR: tpgetrply failed: %s",
+                        tpstrerror(tperrno));
+                EXFAIL_OUT(ret);
+            }
+
+            if (EXSUCCEED!=Bget(p_ub, T_STRING_FLD, 0, tmp, 0L))
+            {
+                NDRX_LOG(log_error, "TESTERROR: Failed to get T_STRING_FLD: %s",
+                        Bstrerror(Berror));
+                EXFAIL_OUT(ret);
+            }
+
+            snprintf(exp_str, sizeof(exp_str), "%s%ld", VALUE_PFX,
+                    (long)(i*NR_CALLS+j));
+
+            if (0!=strcmp(tmp, exp_str))
+            {
+                NDRX_LOG(log_error, "TESTERROR: cd %d expected [%s] got [%s]",
+                        cd[j], exp_str, tmp);
+                EXFAIL_OUT(ret);
+            }
+        }
+    }
+
+    NDRX_LOG(log_info, "Got %ld notifications", M_notifs);
+
+out:
+    if (NULL!=p_ub)
+    {
+        tpfree((char *)p_ub);
+    }
+
+    tpterm();
+    fprintf(stderr, "Exit with %d\n", ret);
+
+    return ret;
+}
+
+/* vim: set ts=4 sw=4 et smartindent: */
@@ -0,0 +1,120 @@
+/**
+ * @brief Compact call header, replies interleaved with unsolicited messages - server
+ *
+ * @file atmisv90.c
+ */
+/* -----------------------------------------------------------------------------
+ * Enduro/X Middleware Platform for Distributed Transaction Processing
+ * Copyright (C) 2009-2016, ATR Baltic, Ltd. All Rights Reserved.
+ * Copyright (C) 2017-2019, Mavimax, Ltd. All Rights Reserved.
+ * This software is released under one of the following licenses:
+ * AGPL (with Java and Go exceptions) or Mavimax's license for commercial use.
+ * See LICENSE file for full text.
+ * -----------------------------------------------------------------------------
+ * AGPL license:
+ * 
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License, version 3 as published
+ * by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License, version 3
+ * for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program; if not, write to the Free Software Foundation, Inc., 
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * -----------------------------------------------------------------------------
+ * A commercial use license is available from Mavimax, Ltd
+ * contact@mavimax.com
+ * -----------------------------------------------------------------------------
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ndebug.h>
+#include <atmi.h>
+#include <ndrstandard.h>
+#include <ubf.h>
+#include <test.fd.h>
+#include "test90.h"
+/*---------------------------Externs------------------------------------*/
+/*---------------------------Macros-------------------------------------*/
+/*---------------------------Enums--------------------------------------*/
+/*---------------------------Typedefs-----------------------------------*/
+/*---------------------------Globals------------------------------------*/
+/*---------------------------Statics------------------------------------*/
+/*---------------------------Prototypes---------------------------------*/
+
+/**
+ * Send notification to the caller, then reply with the sequence number
+ * echoed in the T_STRING_FLD. Thus caller receives both messages in the
+ * same reply queue.
+ */
+void CMPCTSV (TPSVCINFO *p_svc)
+{
+    int ret=EXSUCCEED;
+    long seq;
+    char tmp[64];
+    UBFH *p_ub = (UBFH *)p_svc->data;
+
+    if (EXSUCCEED!=Bget(p_ub, T_LONG_FLD, 0, (char *)&seq, 0L))
+    {
+        NDRX_LOG(log_error, "TESTERROR: Failed to get T_LONG_FLD: %s",
+                Bstrerror(Berror));
+        EXFAIL_OUT(ret);
+    }
+
+    if (EXSUCCEED!=tpnotify(&p_svc->cltid, (char *)p_ub, 0L, 0L))
+    {
+        NDRX_LOG(log_error, "TESTERROR: failed to tpnotify(): %s",
+                tpstrerror(tperrno));
+        EXFAIL_OUT(ret);
+    }
+
+    snprintf(tmp, sizeof(tmp), "%s%ld", VALUE_PFX, seq);
+
+    if (EXSUCCEED!=Bchg(p_ub, T_STRING_FLD, 0, tmp, 0L))
+    {
+        NDRX_LOG(log_error, "TESTERROR: Failed to set T_STRING_FLD: %s",
+                Bstrerror(Berror));
+        EXFAIL_OUT(ret);
+    }
+
+out:
+    tpreturn(  ret==EXSUCCEED?TPSUCCESS:TPFAIL,
+                0L,
+                (char *)p_ub,
+                0L,
+                0L);
+}
+
+/*
+ * Do initialization
+ */
+int NDRX_INTEGRA(tpsvrinit)(int argc, char **argv)
+{
+    int ret = EXSUCCEED;
+    NDRX_LOG(log_debug, "tpsvrinit called");
+
+    if (EXSUCCEED!=tpadvertise("CMPCTSV", CMPCTSV))
+    {
+        NDRX_LOG(log_error, "TESTERROR: Failed to initialize CMPCTSV!");
+        EXFAIL_OUT(ret);
+    }
+
+out:
+    return ret;
+}
+
+/**
+ * Do de-initialization
+ */
+void NDRX_INTEGRA(tpsvrdone)(void)
+{
+    NDRX_LOG(log_debug, "tpsvrdone called");
+}
+
+/* vim: set ts=4 sw=4 et smartindent: */
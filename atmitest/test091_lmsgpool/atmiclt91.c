@@ -0,0 +1,233 @@
+/**
+ * @brief Large message pool transfers and slab reclaim - client
+ *
+ * @file atmiclt91.c
+ */
+/* -----------------------------------------------------------------------------
+ * Enduro/X Middleware Platform for Distributed Transaction Processing
+ * Copyright (C) 2009-2016, ATR Baltic, Ltd. All Rights Reserved.
+ * Copyright (C) 2017-2019, Mavimax, Ltd. All Rights Reserved.
+ * This software is released under one of the following licenses:
+ * AGPL (with Java and Go exceptions) or Mavimax's license for commercial use.
+ * See LICENSE file for full text.
+ * -----------------------------------------------------------------------------
+ * AGPL license:
+ * 
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License, version 3 as published
+ * by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License, version 3
+ * for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program; if not, write to the Free Software Foundation, Inc., 
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * -----------------------------------------------------------------------------
+ * A commercial use license is available from Mavimax, Ltd
+ * contact@mavimax.com
+ * -----------------------------------------------------------------------------
+ */
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <memory.h>
+#include <unistd.h>
+#include <signal.h>
+
+#include <atmi.h>
+#include <ndebug.h>
+#include <ndrstandard.h>
+#include "test91.h"
+/*---------------------------Externs------------------------------------*/
+/*---------------------------Macros-------------------------------------*/
+/*---------------------------Enums--------------------------------------*/
+/*---------------------------Typedefs-----------------------------------*/
+/*---------------------------Globals------------------------------------*/
+/*---------------------------Statics------------------------------------*/
+/*---------------------------Prototypes---------------------------------*/
+exprivate char *mkbuf(int seq, long len);
+exprivate int chkrply(int seq, char *buf, long len, long exp_len);
+
+/**
+ * Allocate request buffer with the pattern
+ * @param seq request number
+ * @param len buffer len
+ * @return buffer or NULL
+ */
+exprivate char *mkbuf(int seq, long len)
+{
+    char *buf;
+    long i;
+
+    if (NULL==(buf = tpalloc("CARRAY", NULL, len)))
+    {
+        NDRX_LOG(log_error, "TESTERROR: tpalloc failed: %s", 
+                tpstrerror(tperrno));
+        return NULL;
+    }
+
+    buf[0] = (char)seq;
+
+    for (i=1; i<len; i++)
+    {
+        buf[i] = PATTERN(seq, i);
+    }
+
+    return buf;
+}
+
+/**
+ * Check the reply pattern
+ * @param seq request number
+ * @param buf reply buffer
+ * @param len reply len
+ * @param exp_len expected len
+ * @return EXSUCCEED/EXFAIL
+ */
+exprivate int chkrply(int seq, char *buf, long len, long exp_len)
+{
+    int ret = EXSUCCEED;
+    long i;
+
+    if (len!=exp_len)
+    {
+        NDRX_LOG(log_error, "TESTERROR: seq %d reply len %ld expected %ld", 
+                seq, len, exp_len);
+        EXFAIL_OUT(ret);
+    }
+
+    for (i=1; i<len; i++)
+    {
+        if (PATTERN(seq+1, i)!=buf[i])
+        {
+            NDRX_LOG(log_error, "TESTERROR: seq %d invalid byte at %ld", seq, i);
+            EXFAIL_OUT(ret);
+        }
+    }
+
+out:
+    return ret;
+}
+
+/**
+ * Run calls through the pool. With "die" argument, issue TPNOTIME call
+ * and get killed before reading the reply, thus the reply slab is left for
+ * ndrxd to reclaim.
+ */
+int main(int argc, char** argv)
+{
+    int ret=EXSUCCEED;
+    char *buf = NULL;
+    char *bufs[NR_ASYNC];
+    int cd[NR_ASYNC];
+    long rsplen;
+    long len;
+    int i;
+
+    memset(bufs, 0, sizeof(bufs));
+
+    if (argc > 1 && 0==strcmp(argv[1], "die"))
+    {
+        if (NULL==(buf = mkbuf(1, MSG_MIN)))
+        {
+            EXFAIL_OUT(ret);
+        }
+
+        if (EXFAIL==tpacall("LMSGSV", buf, MSG_MIN, TPNOTIME))
+        {
+            NDRX_LOG(log_error, "TESTERROR: tpacall failed: %s", 
+                    tpstrerror(tperrno));
+            EXFAIL_OUT(ret);
+        }
+
+        /* let the reply to arrive */
+        sleep(2);
+        NDRX_LOG(log_info, "Dying with reply in queue");
+        kill(getpid(), SIGKILL);
+    }
+
+    /* synchronous calls, with and without time limit */
+    for (i=0; i<NR_SYNC; i++)
+    {
+        len = MSG_MIN + i*MSG_STEP;
+
+        if (NULL==(buf = mkbuf(i, len)))
+        {
+            EXFAIL_OUT(ret);
+        }
+
+        if (EXFAIL==tpcall("LMSGSV", buf, len, &buf, &rsplen, 
+                    (i%2)?TPNOTIME:0L))
+        {
+            NDRX_LOG(log_error, "TESTERROR: tpcall %d failed: %s", 
+                    i, tpstrerror(tperrno));
+            EXFAIL_OUT(ret);
+        }
+
+        if (EXSUCCEED!=chkrply(i, buf, rsplen, len))
+        {
+            EXFAIL_OUT(ret);
+        }
+
+        tpfree(buf);
+        buf = NULL;
+    }
+
+    /* more calls in flight than slabs, rest goes via queue */
+    for (i=0; i<NR_ASYNC; i++)
+    {
+        len = MSG_MIN + i*MSG_STEP;
+
+        if (NULL==(bufs[i] = mkbuf(i, len)))
+        {
+            EXFAIL_OUT(ret);
+        }
+
+        if (EXFAIL==(cd[i] = tpacall("LMSGSV", bufs[i], len, 0L)))
+        {
+            NDRX_LOG(log_error, "TESTERROR: tpacall %d failed: %s", 
+                    i, tpstrerror(tperrno));
+            EXFAIL_OUT(ret);
+        }
+    }
+
+    for (i=NR_ASYNC-1; i>=0; i--)
+    {
+        if (EXFAIL==tpgetrply(&cd[i], &bufs[i], &rsplen, 0L))
+        {
+            NDRX_LOG(log_error, "TESTERROR: tpgetrply %d failed: %s", 
+                    i, tpstrerror(tperrno));
+            EXFAIL_OUT(ret);
+        }
+
+        if (EXSUCCEED!=chkrply(i, bufs[i], rsplen, MSG_MIN + i*MSG_STEP))
+        {
+            EXFAIL_OUT(ret);
+        }
+    }
+
+out:
+    if (NULL!=buf)
+    {
+        tpfree(buf);
+    }
+
+    for (i=0; i<NR_ASYNC; i++)
+    {
+        if (NULL!=bufs[i])
+        {
+            tpfree(bufs[i]);
+        }
+    }
+
+    tpterm();
+    fprintf(stderr, "Exit with %d\n", ret);
+
+    return ret;
+}
+
+/* vim: set ts=4 sw=4 et smartindent: */
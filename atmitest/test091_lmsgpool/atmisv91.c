@@ -0,0 +1,113 @@
+/**
+ * @brief Large message pool transfers and slab reclaim - server
+ *
+ * @file atmisv91.c
+ */
+/* -----------------------------------------------------------------------------
+ * Enduro/X Middleware Platform for Distributed Transaction Processing
+ * Copyright (C) 2009-2016, ATR Baltic, Ltd. All Rights Reserved.
+ * Copyright (C) 2017-2019, Mavimax, Ltd. All Rights Reserved.
+ * This software is released under one of the following licenses:
+ * AGPL (with Java and Go exceptions) or Mavimax's license for commercial use.
+ * See LICENSE file for full text.
+ * -----------------------------------------------------------------------------
+ * AGPL license:
+ * 
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License, version 3 as published
+ * by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License, version 3
+ * for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program; if not, write to the Free Software Foundation, Inc., 
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * -----------------------------------------------------------------------------
+ * A commercial use license is available from Mavimax, Ltd
+ * contact@mavimax.com
+ * -----------------------------------------------------------------------------
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ndebug.h>
+#include <atmi.h>
+#include <ndrstandard.h>
+#include "test91.h"
+/*---------------------------Externs------------------------------------*/
+/*---------------------------Macros-------------------------------------*/
+/*---------------------------Enums--------------------------------------*/
+/*---------------------------Typedefs-----------------------------------*/
+/*---------------------------Globals------------------------------------*/
+/*---------------------------Statics------------------------------------*/
+/*---------------------------Prototypes---------------------------------*/
+
+/**
+ * Verify the pattern of the request and reply with the pattern shifted
+ * by one. Request seq number is the first byte.
+ */
+void LMSGSV (TPSVCINFO *p_svc)
+{
+    int ret=EXSUCCEED;
+    long i;
+    int seq;
+    char *buf = p_svc->data;
+
+    if (p_svc->len < MSG_MIN)
+    {
+        NDRX_LOG(log_error, "TESTERROR: Request too short: %ld", p_svc->len);
+        EXFAIL_OUT(ret);
+    }
+
+    seq = (unsigned char)buf[0];
+
+    for (i=1; i<p_svc->len; i++)
+    {
+        if (PATTERN(seq, i)!=buf[i])
+        {
+            NDRX_LOG(log_error, "TESTERROR: Invalid byte at %ld: %d vs %d", 
+                    i, (int)buf[i], (int)PATTERN(seq, i));
+            EXFAIL_OUT(ret);
+        }
+        buf[i] = PATTERN(seq+1, i);
+    }
+
+out:
+    tpreturn(  ret==EXSUCCEED?TPSUCCESS:TPFAIL,
+                0L,
+                buf,
+                p_svc->len,
+                0L);
+}
+
+/*
+ * Do initialization
+ */
+int NDRX_INTEGRA(tpsvrinit)(int argc, char **argv)
+{
+    int ret = EXSUCCEED;
+    NDRX_LOG(log_debug, "tpsvrinit called");
+
+    if (EXSUCCEED!=tpadvertise("LMSGSV", LMSGSV))
+    {
+        NDRX_LOG(log_error, "TESTERROR: Failed to initialize LMSGSV!");
+        EXFAIL_OUT(ret);
+    }
+
+out:
+    return ret;
+}
+
+/**
+ * Do de-initialization
+ */
+void NDRX_INTEGRA(tpsvrdone)(void)
+{
+    NDRX_LOG(log_debug, "tpsvrdone called");
+}
+
+/* vim: set ts=4 sw=4 et smartindent: */
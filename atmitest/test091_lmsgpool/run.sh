@@ -0,0 +1,137 @@
+#!/bin/bash
+##
+## @brief Large message pool transfers and slab reclaim - test launcher
+##
+## @file run.sh
+##
+## -----------------------------------------------------------------------------
+## Enduro/X Middleware Platform for Distributed Transaction Processing
+## Copyright (C) 2009-2016, ATR Baltic, Ltd. All Rights Reserved.
+## Copyright (C) 2017-2019, Mavimax, Ltd. All Rights Reserved.
+## This software is released under one of the following licenses:
+## AGPL (with Java and Go exceptions) or Mavimax's license for commercial use.
+## See LICENSE file for full text.
+## -----------------------------------------------------------------------------
+## AGPL license:
+## 
+## This program is free software; you can redistribute it and/or modify it under
+## the terms of the GNU Affero General Public License, version 3 as published
+## by the Free Software Foundation;
+##
+## This program is distributed in the hope that it will be useful, but WITHOUT ANY
+## WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+## PARTICULAR PURPOSE. See the GNU Affero General Public License, version 3
+## for more details.
+##
+## You should have received a copy of the GNU Affero General Public License along 
+## with this program; if not, write to the Free Software Foundation, Inc., 
+## 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+##
+## -----------------------------------------------------------------------------
+## A commercial use license is available from Mavimax, Ltd
+## contact@mavimax.com
+## -----------------------------------------------------------------------------
+##
+
+export TESTNAME="test091_lmsgpool"
+
+PWD=`pwd`
+if [ `echo $PWD | grep $TESTNAME ` ]; then
+    # Do nothing 
+    echo > /dev/null
+else
+    # started from parent folder
+    pushd .
+    echo "Doing cd"
+    cd $TESTNAME
+fi;
+
+. ../testenv.sh
+
+export TESTDIR="$NDRX_APPHOME/atmitest/$TESTNAME"
+export PATH=$PATH:$TESTDIR
+export NDRX_ULOG=$TESTDIR
+export NDRX_TOUT=10
+export NDRX_SILENT=Y
+# less slabs than calls in flight
+export NDRX_LMSGPOOL=4
+export NDRX_LMSGTHRES=10000
+
+. ../dom1.sh
+export NDRX_CONFIG=$TESTDIR/ndrxconfig-dom1.xml
+export NDRX_DMNLOG=$TESTDIR/ndrxd-dom1.log
+export NDRX_LOG=$TESTDIR/ndrx-dom1.log
+export NDRX_DEBUG_CONF=$TESTDIR/debug-dom1.conf
+
+#
+# Generic exit function
+#
+function go_out {
+    echo "Test exiting with: $1"
+    xadmin stop -y
+    xadmin down -y
+
+    popd 2>/dev/null
+    exit $1
+}
+
+rm *.log 2>/dev/null
+rm ULOG* 2>/dev/null
+
+xadmin down -y
+xadmin start -y || go_out 1
+
+RET=0
+
+xadmin psc
+echo "Running off client"
+(./atmiclt91 2>&1) > ./atmiclt-dom1.log
+
+RET=$?
+
+if [[ "X$RET" != "X0" ]]; then
+    go_out $RET
+fi
+
+if [ "X`grep 'placed in large message slab' atmiclt-dom1.log`" == "X" ]; then
+    echo "Calls not passed via large message pool!"
+    go_out -3
+fi
+
+if [ "X`grep 'placed in large message slab' atmisv-dom1.log`" == "X" ]; then
+    echo "Replies not passed via large message pool!"
+    go_out -4
+fi
+
+# replies not yet read hold the slabs
+if [ "X`grep 'No free large message slab' atmiclt-dom1.log atmisv-dom1.log`" == "X" ]; then
+    echo "Pool must be exhausted by async calls!"
+    go_out -5
+fi
+
+# all slabs shall be released by receivers
+if [ "X`grep 'Reclaiming large message slab' ndrxd-dom1.log`" != "X" ]; then
+    echo "Slabs reclaimed, but receivers were alive!"
+    go_out -6
+fi
+
+echo "Caller dies with TPNOTIME reply in the pool"
+(./atmiclt91 die 2>&1) >> ./atmiclt-dom1.log
+
+# let the sanity cycles to run
+sleep 5
+
+if [ "X`grep 'Reclaiming large message slab' ndrxd-dom1.log`" == "X" ]; then
+    echo "Reply slab of dead caller not reclaimed!"
+    go_out -7
+fi
+
+# Catch is there is test error!!!
+if [ "X`grep TESTERROR *.log`" != "X" ]; then
+        echo "Test error detected!"
+        RET=-2
+fi
+
+go_out $RET
+
+# vim: set ts=4 sw=4 et smartindent:
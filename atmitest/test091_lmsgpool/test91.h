@@ -0,0 +1,55 @@
+/**
+ * @brief Large message pool transfers and slab reclaim - common header
+ *
+ * @file test91.h
+ */
+/* -----------------------------------------------------------------------------
+ * Enduro/X Middleware Platform for Distributed Transaction Processing
+ * Copyright (C) 2009-2016, ATR Baltic, Ltd. All Rights Reserved.
+ * Copyright (C) 2017-2019, Mavimax, Ltd. All Rights Reserved.
+ * This software is released under one of the following licenses:
+ * AGPL (with Java and Go exceptions) or Mavimax's license for commercial use.
+ * See LICENSE file for full text.
+ * -----------------------------------------------------------------------------
+ * AGPL license:
+ * 
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License, version 3 as published
+ * by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License, version 3
+ * for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program; if not, write to the Free Software Foundation, Inc., 
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * -----------------------------------------------------------------------------
+ * A commercial use license is available from Mavimax, Ltd
+ * contact@mavimax.com
+ * -----------------------------------------------------------------------------
+ */
+#ifndef TEST91_H
+#define TEST91_H
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+#define MSG_MIN         20000   /**< above NDRX_LMSGTHRES of run.sh */
+#define MSG_STEP        100     /**< size increment per call */
+#define NR_SYNC         100     /**< number of tpcall() */
+#define NR_ASYNC        10      /**< calls in flight, more than slabs */
+
+/** test pattern byte */
+#define PATTERN(I, J)   ((char)(((I)+(J)) % 251))
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif  /* TEST91_H */
+
+/* vim: set ts=4 sw=4 et smartindent: */
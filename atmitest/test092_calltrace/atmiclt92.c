@@ -0,0 +1,294 @@
+/**
+ * @brief Call trace test - client. Checks the hops recorded over
+ *  tpcall/tpforward/tpreturn and bridges, nested calls and ring wraparound
+ *
+ * @file atmiclt92.c
+ */
+/* -----------------------------------------------------------------------------
+ * Enduro/X Middleware Platform for Distributed Transaction Processing
+ * Copyright (C) 2009-2016, ATR Baltic, Ltd. All Rights Reserved.
+ * Copyright (C) 2017-2019, Mavimax, Ltd. All Rights Reserved.
+ * This software is released under one of the following licenses:
+ * AGPL (with Java and Go exceptions) or Mavimax's license for commercial use.
+ * See LICENSE file for full text.
+ * -----------------------------------------------------------------------------
+ * AGPL license:
+ * 
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License, version 3 as published
+ * by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License, version 3
+ * for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program; if not, write to the Free Software Foundation, Inc., 
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * -----------------------------------------------------------------------------
+ * A commercial use license is available from Mavimax, Ltd
+ * contact@mavimax.com
+ * -----------------------------------------------------------------------------
+ */
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <ndebug.h>
+#include <atmi.h>
+#include <ndrstandard.h>
+#include <atmi_int.h>
+#include "test92.h"
+/*---------------------------Externs------------------------------------*/
+/*---------------------------Macros-------------------------------------*/
+/*---------------------------Enums--------------------------------------*/
+/*---------------------------Typedefs-----------------------------------*/
+
+/** Expected hop */
+typedef struct
+{
+    short kind;
+    short nodeid;
+} exp_hop_t;
+
+/*---------------------------Globals------------------------------------*/
+/*---------------------------Statics------------------------------------*/
+exprivate exp_hop_t M_root_hops[] = ROOT_HOPS;     /**< Forwarded call */
+exprivate exp_hop_t M_child_hops[] = CHILD_HOPS;   /**< Nested call    */
+/*---------------------------Prototypes---------------------------------*/
+
+/**
+ * Verify hops of the trace record
+ * @param rec record read from ring
+ * @param exp expected hops
+ * @param nexp number of expected hops
+ * @return EXSUCCEED/EXFAIL
+ */
+exprivate int check_hops(ndrx_calltrace_rec_t *rec, exp_hop_t *exp, int nexp)
+{
+    int ret = EXSUCCEED;
+    int i;
+
+    if (rec->nhops!=nexp)
+    {
+        NDRX_LOG(log_error, "TESTERROR: [%s] seq %lu: expected %d hops, got %d",
+                rec->svcnm, rec->seq, nexp, rec->nhops);
+        EXFAIL_OUT(ret);
+    }
+
+    for (i=0; i<nexp; i++)
+    {
+        if (rec->hops[i].kind!=exp[i].kind || rec->hops[i].nodeid!=exp[i].nodeid)
+        {
+            NDRX_LOG(log_error, "TESTERROR: [%s] seq %lu hop %d: expected "
+                    "kind %hd node %hd, got kind %hd node %hd",
+                    rec->svcnm, rec->seq, i, exp[i].kind, exp[i].nodeid, 
+                    rec->hops[i].kind, rec->hops[i].nodeid);
+            EXFAIL_OUT(ret);
+        }
+    }
+
+out:
+    return ret;
+}
+
+/**
+ * Call the forwarding service
+ * @param buf request buffer
+ * @return EXSUCCEED/EXFAIL
+ */
+exprivate int do_call(char **buf)
+{
+    int ret = EXSUCCEED;
+    long rsplen;
+
+    if (EXFAIL==tpcall("TRACEFWD", *buf, 0, buf, &rsplen, 0))
+    {
+        NDRX_LOG(log_error, "TESTERROR: TRACEFWD failed: %s", 
+                tpstrerror(tperrno));
+        EXFAIL_OUT(ret);
+    }
+
+    if (0!=strcmp(*buf, REQ_MSG))
+    {
+        NDRX_LOG(log_error, "TESTERROR: Invalid reply [%s]", *buf);
+        EXFAIL_OUT(ret);
+    }
+
+out:
+    return ret;
+}
+
+/**
+ * Trace the calls, read them from the ring
+ */
+int main(int argc, char** argv)
+{
+    int ret = EXSUCCEED;
+    char *buf = NULL;
+    ndrx_calltrace_rec_t *recs = NULL;
+    atmi_lib_env_t *env;
+    unsigned long seq = 0;
+    unsigned long start;
+    int i, n;
+
+    if (EXSUCCEED!=tpinit(NULL))
+    {
+        NDRX_LOG(log_error, "TESTERROR: tpinit failed: %s", tpstrerror(tperrno));
+        EXFAIL_OUT(ret);
+    }
+
+    env = ndrx_get_G_atmi_env();
+
+    if (NULL==(recs = NDRX_MALLOC(sizeof(ndrx_calltrace_rec_t)*NR_RECS)))
+    {
+        NDRX_LOG(log_error, "TESTERROR: malloc failed");
+        EXFAIL_OUT(ret);
+    }
+
+    if (NULL==(buf = tpalloc("STRING", NULL, 100)))
+    {
+        NDRX_LOG(log_error, "TESTERROR: tpalloc failed: %s", tpstrerror(tperrno));
+        EXFAIL_OUT(ret);
+    }
+
+    strcpy(buf, REQ_MSG);
+
+    /* skip anything in the ring */
+    while ((n=ndrx_calltrace_read(&seq, recs, NR_RECS)) > 0)
+    {
+    }
+
+    if (EXFAIL==n)
+    {
+        NDRX_LOG(log_error, "TESTERROR: Failed to read trace ring");
+        EXFAIL_OUT(ret);
+    }
+
+    start = seq;
+
+    /* not sampled - nothing recorded */
+    env->tracesample = 0;
+
+    if (EXSUCCEED!=do_call(&buf))
+    {
+        EXFAIL_OUT(ret);
+    }
+
+    if (0!=(n=ndrx_calltrace_read(&seq, recs, NR_RECS)))
+    {
+        NDRX_LOG(log_error, "TESTERROR: Untraced call recorded %d traces", n);
+        EXFAIL_OUT(ret);
+    }
+
+    /* every call traced, ring wraps around */
+    env->tracesample = 1;
+
+    for (i=0; i<NR_CALLS; i++)
+    {
+        if (EXSUCCEED!=do_call(&buf))
+        {
+            EXFAIL_OUT(ret);
+        }
+    }
+
+    n = ndrx_calltrace_read(&seq, recs, NR_RECS);
+
+    NDRX_LOG(log_info, "Read %d traces, seq %lu (start %lu)", n, seq, start);
+
+    if (NR_SLOTS!=n || start + NR_CALLS*2!=seq)
+    {
+        NDRX_LOG(log_error, "TESTERROR: expected %d traces up to seq %lu, "
+                "got %d up to %lu", NR_SLOTS, start + NR_CALLS*2, n, seq);
+        EXFAIL_OUT(ret);
+    }
+
+    for (i=0; i<n; i++)
+    {
+        /* oldest first, overwritten ones are lost */
+        if (recs[i].seq!=seq - NR_SLOTS + 1 + i)
+        {
+            NDRX_LOG(log_error, "TESTERROR: rec %d: expected seq %lu got %lu",
+                    i, seq - NR_SLOTS + 1 + i, recs[i].seq);
+            EXFAIL_OUT(ret);
+        }
+
+        if (0==strcmp(recs[i].svcnm, "TRACEECHO"))
+        {
+            /* root: forwarded to domain 2, replied over the bridge */
+            if (0!=recs[i].parent_id || EXSUCCEED!=check_hops(&recs[i], 
+                    M_root_hops, N_DIM(M_root_hops)))
+            {
+                NDRX_LOG(log_error, "TESTERROR: invalid root trace seq %lu "
+                        "parent %ld", recs[i].seq, recs[i].parent_id);
+                EXFAIL_OUT(ret);
+            }
+        }
+        else if (0==strcmp(recs[i].svcnm, "TRACELOCAL"))
+        {
+            /* nested call completes before the root */
+            if (i+1>=n || EXSUCCEED!=check_hops(&recs[i], 
+                    M_child_hops, N_DIM(M_child_hops)))
+            {
+                EXFAIL_OUT(ret);
+            }
+
+            if (recs[i].trace_id!=recs[i+1].trace_id ||
+                    recs[i].parent_id!=recs[i+1].span_id ||
+                    0==recs[i].parent_id)
+            {
+                NDRX_LOG(log_error, "TESTERROR: nested call seq %lu trace %ld "
+                        "parent %ld not linked to root trace %ld span %ld",
+                        recs[i].seq, recs[i].trace_id, recs[i].parent_id,
+                        recs[i+1].trace_id, recs[i+1].span_id);
+                EXFAIL_OUT(ret);
+            }
+        }
+        else
+        {
+            NDRX_LOG(log_error, "TESTERROR: unexpected trace of [%s]", 
+                    recs[i].svcnm);
+            EXFAIL_OUT(ret);
+        }
+    }
+
+    /* all read */
+    if (0!=(n=ndrx_calltrace_read(&seq, recs, NR_RECS)))
+    {
+        NDRX_LOG(log_error, "TESTERROR: expected no new traces, got %d", n);
+        EXFAIL_OUT(ret);
+    }
+
+    if (EXSUCCEED!=do_call(&buf))
+    {
+        EXFAIL_OUT(ret);
+    }
+
+    if (2!=(n=ndrx_calltrace_read(&seq, recs, NR_RECS)) ||
+            recs[0].trace_id!=recs[1].trace_id)
+    {
+        NDRX_LOG(log_error, "TESTERROR: expected 2 new traces, got %d", n);
+        EXFAIL_OUT(ret);
+    }
+
+out:
+
+    if (NULL!=buf)
+    {
+        tpfree(buf);
+    }
+
+    if (NULL!=recs)
+    {
+        NDRX_FREE(recs);
+    }
+
+    tpterm();
+
+    fprintf(stderr, "Exit with %d\n", ret);
+
+    return ret;
+}
+
+/* vim: set ts=4 sw=4 et smartindent: */
@@ -0,0 +1,122 @@
+/**
+ * @brief Call trace test - server
+ *
+ * @file atmisv92.c
+ */
+/* -----------------------------------------------------------------------------
+ * Enduro/X Middleware Platform for Distributed Transaction Processing
+ * Copyright (C) 2009-2016, ATR Baltic, Ltd. All Rights Reserved.
+ * Copyright (C) 2017-2019, Mavimax, Ltd. All Rights Reserved.
+ * This software is released under one of the following licenses:
+ * AGPL (with Java and Go exceptions) or Mavimax's license for commercial use.
+ * See LICENSE file for full text.
+ * -----------------------------------------------------------------------------
+ * AGPL license:
+ * 
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License, version 3 as published
+ * by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License, version 3
+ * for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program; if not, write to the Free Software Foundation, Inc., 
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * -----------------------------------------------------------------------------
+ * A commercial use license is available from Mavimax, Ltd
+ * contact@mavimax.com
+ * -----------------------------------------------------------------------------
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ndebug.h>
+#include <atmi.h>
+#include <ndrstandard.h>
+#include "test92.h"
+/*---------------------------Externs------------------------------------*/
+/*---------------------------Macros-------------------------------------*/
+/*---------------------------Enums--------------------------------------*/
+/*---------------------------Typedefs-----------------------------------*/
+/*---------------------------Globals------------------------------------*/
+/*---------------------------Statics------------------------------------*/
+/*---------------------------Prototypes---------------------------------*/
+
+/**
+ * Call local service (nested traced call), then forward to remote one
+ */
+void TRACEFWD (TPSVCINFO *p_svc)
+{
+    char *rsp = NULL;
+    long rsplen;
+
+    if (EXFAIL==tpcall("TRACELOCAL", p_svc->data, 0, &rsp, &rsplen, 0))
+    {
+        NDRX_LOG(log_error, "TESTERROR: TRACELOCAL failed: %s", 
+                tpstrerror(tperrno));
+        tpreturn(TPFAIL, 0L, p_svc->data, 0L, 0L);
+    }
+
+    tpfree(rsp);
+
+    tpforward("TRACEECHO", p_svc->data, 0L, 0L);
+}
+
+/**
+ * Local nested service
+ */
+void TRACELOCAL (TPSVCINFO *p_svc)
+{
+    tpreturn(TPSUCCESS, 0L, p_svc->data, 0L, 0L);
+}
+
+/**
+ * Remote service (domain 2), replies to the original caller
+ */
+void TRACEECHO (TPSVCINFO *p_svc)
+{
+    tpreturn(TPSUCCESS, 0L, p_svc->data, 0L, 0L);
+}
+
+/*
+ * Do initialization
+ */
+int NDRX_INTEGRA(tpsvrinit)(int argc, char **argv)
+{
+    int ret = EXSUCCEED;
+    NDRX_LOG(log_debug, "tpsvrinit called");
+
+    if (1==tpgetnodeid())
+    {
+        if (EXSUCCEED!=tpadvertise("TRACEFWD", TRACEFWD) ||
+                EXSUCCEED!=tpadvertise("TRACELOCAL", TRACELOCAL))
+        {
+            NDRX_LOG(log_error, "TESTERROR: Failed to advertise: %s", 
+                    tpstrerror(tperrno));
+            EXFAIL_OUT(ret);
+        }
+    }
+    else if (EXSUCCEED!=tpadvertise("TRACEECHO", TRACEECHO))
+    {
+        NDRX_LOG(log_error, "TESTERROR: Failed to advertise: %s", 
+                tpstrerror(tperrno));
+        EXFAIL_OUT(ret);
+    }
+
+out:
+    return ret;
+}
+
+/**
+ * Do de-initialization
+ */
+void NDRX_INTEGRA(tpsvrdone)(void)
+{
+    NDRX_LOG(log_debug, "tpsvrdone called");
+}
+
+/* vim: set ts=4 sw=4 et smartindent: */
@@ -0,0 +1,78 @@
+/**
+ * @brief Call trace test - common defines
+ *
+ * @file test92.h
+ */
+/* -----------------------------------------------------------------------------
+ * Enduro/X Middleware Platform for Distributed Transaction Processing
+ * Copyright (C) 2009-2016, ATR Baltic, Ltd. All Rights Reserved.
+ * Copyright (C) 2017-2019, Mavimax, Ltd. All Rights Reserved.
+ * This software is released under one of the following licenses:
+ * AGPL (with Java and Go exceptions) or Mavimax's license for commercial use.
+ * See LICENSE file for full text.
+ * -----------------------------------------------------------------------------
+ * AGPL license:
+ * 
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License, version 3 as published
+ * by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License, version 3
+ * for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program; if not, write to the Free Software Foundation, Inc., 
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * -----------------------------------------------------------------------------
+ * A commercial use license is available from Mavimax, Ltd
+ * contact@mavimax.com
+ * -----------------------------------------------------------------------------
+ */
+#ifndef TEST92_H
+#define TEST92_H
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+#define NR_CALLS        600     /**< Traced calls, two records per call */
+#define NR_SLOTS        1024    /**< Trace ring size, see calltrace.c */
+#define NR_RECS         2048    /**< Read buffer */
+
+#define REQ_MSG         "TRACE ME"
+
+/** Hops of the root call: local forward, then remote service over bridge */
+#define ROOT_HOPS   {\
+    {NDRX_TRACE_HOP_ENQ, 1},\
+    {NDRX_TRACE_HOP_DEQ, 1},\
+    {NDRX_TRACE_HOP_SVCSTART, 1},\
+    {NDRX_TRACE_HOP_FWD, 1},\
+    {NDRX_TRACE_HOP_BROUT, 1},\
+    {NDRX_TRACE_HOP_BRIN, 2},\
+    {NDRX_TRACE_HOP_DEQ, 2},\
+    {NDRX_TRACE_HOP_SVCSTART, 2},\
+    {NDRX_TRACE_HOP_SVCEND, 2},\
+    {NDRX_TRACE_HOP_BROUT, 2},\
+    {NDRX_TRACE_HOP_BRIN, 1},\
+    {NDRX_TRACE_HOP_RPLDEQ, 1}\
+}
+
+/** Hops of the nested call made by TRACEFWD */
+#define CHILD_HOPS  {\
+    {NDRX_TRACE_HOP_ENQ, 1},\
+    {NDRX_TRACE_HOP_DEQ, 1},\
+    {NDRX_TRACE_HOP_SVCSTART, 1},\
+    {NDRX_TRACE_HOP_SVCEND, 1},\
+    {NDRX_TRACE_HOP_RPLDEQ, 1}\
+}
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif  /* TEST92_H */
+
+/* vim: set ts=4 sw=4 et smartindent: */
@@ -0,0 +1,138 @@
+/**
+ * @brief One-phase commit test - client
+ *   Runs one transaction over the service, argument tells the expected
+ *   outcome of the tpcommit(): `commit' or `abort'.
+ *
+ * @file atmiclt93.c
+ */
+/* -----------------------------------------------------------------------------
+ * Enduro/X Middleware Platform for Distributed Transaction Processing
+ * Copyright (C) 2009-2016, ATR Baltic, Ltd. All Rights Reserved.
+ * Copyright (C) 2017-2019, Mavimax, Ltd. All Rights Reserved.
+ * This software is released under one of the following licenses:
+ * AGPL (with Java and Go exceptions) or Mavimax's license for commercial use.
+ * See LICENSE file for full text.
+ * -----------------------------------------------------------------------------
+ * AGPL license:
+ * 
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License, version 3 as published
+ * by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License, version 3
+ * for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program; if not, write to the Free Software Foundation, Inc., 
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * -----------------------------------------------------------------------------
+ * A commercial use license is available from Mavimax, Ltd
+ * contact@mavimax.com
+ * -----------------------------------------------------------------------------
+ */
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <memory.h>
+#include <errno.h>
+
+#include <atmi.h>
+#include <ndebug.h>
+#include <ndrstandard.h>
+#include "test93.h"
+/*---------------------------Externs------------------------------------*/
+/*---------------------------Macros-------------------------------------*/
+/*---------------------------Enums--------------------------------------*/
+/*---------------------------Typedefs-----------------------------------*/
+/*---------------------------Globals------------------------------------*/
+/*---------------------------Statics------------------------------------*/
+/*---------------------------Prototypes---------------------------------*/
+
+/**
+ * Do the test call to the server
+ */
+int main(int argc, char** argv)
+{
+    int ret = EXSUCCEED;
+    int expect_abort;
+    long rsplen;
+    char *buf = NULL;
+    
+    if (argc<2)
+    {
+        fprintf(stderr, "usage: %s commit|abort\n", argv[0]);
+        EXFAIL_OUT(ret);
+    }
+    
+    expect_abort = (0==strcmp(argv[1], "abort"));
+    
+    if (EXSUCCEED!=tpopen())
+    {
+        NDRX_LOG(log_error, "TESTERROR: tpopen() failed: %s", 
+                tpstrerror(tperrno));
+        EXFAIL_OUT(ret);
+    }
+    
+    if (NULL==(buf = tpalloc("STRING", NULL, 128)))
+    {
+        NDRX_LOG(log_error, "TESTERROR: tpalloc() failed: %s", 
+                tpstrerror(tperrno));
+        EXFAIL_OUT(ret);
+    }
+    
+    NDRX_STRCPY_SAFE_DST(buf, "HELLO", 128);
+    
+    if (EXSUCCEED!=tpbegin(60, 0))
+    {
+        NDRX_LOG(log_error, "TESTERROR: tpbegin() failed: %s", 
+                tpstrerror(tperrno));
+        EXFAIL_OUT(ret);
+    }
+    
+    if (EXFAIL==tpcall(TEST93_SVC, buf, 0L, &buf, &rsplen, 0))
+    {
+        NDRX_LOG(log_error, "TESTERROR: %s failed: %s", TEST93_SVC, 
+                tpstrerror(tperrno));
+        tpabort(0);
+        EXFAIL_OUT(ret);
+    }
+    
+    ret=tpcommit(0);
+    
+    if (expect_abort)
+    {
+        if (EXSUCCEED==ret || TPEABORT!=tperrno)
+        {
+            NDRX_LOG(log_error, "TESTERROR: tpcommit() expected TPEABORT, "
+                    "got ret=%d: %s", ret, tpstrerror(tperrno));
+            EXFAIL_OUT(ret);
+        }
+        
+        ret = EXSUCCEED;
+    }
+    else if (EXSUCCEED!=ret)
+    {
+        NDRX_LOG(log_error, "TESTERROR: tpcommit() failed: %s", 
+                tpstrerror(tperrno));
+        EXFAIL_OUT(ret);
+    }
+    
+out:
+
+    if (NULL!=buf)
+    {
+        tpfree(buf);
+    }
+
+    tpclose();
+    tpterm();
+    
+    fprintf(stderr, "Exit with %d\n", ret);
+
+    return ret;
+}
+
+/* vim: set ts=4 sw=4 et smartindent: */
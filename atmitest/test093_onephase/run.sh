@@ -0,0 +1,168 @@
+#!/bin/bash
+##
+## @brief One-phase commit test - launcher
+##
+## @file run.sh
+##
+## -----------------------------------------------------------------------------
+## Enduro/X Middleware Platform for Distributed Transaction Processing
+## Copyright (C) 2009-2016, ATR Baltic, Ltd. All Rights Reserved.
+## Copyright (C) 2017-2019, Mavimax, Ltd. All Rights Reserved.
+## This software is released under one of the following licenses:
+## AGPL (with Java and Go exceptions) or Mavimax's license for commercial use.
+## See LICENSE file for full text.
+## -----------------------------------------------------------------------------
+## AGPL license:
+## 
+## This program is free software; you can redistribute it and/or modify it under
+## the terms of the GNU Affero General Public License, version 3 as published
+## by the Free Software Foundation;
+##
+## This program is distributed in the hope that it will be useful, but WITHOUT ANY
+## WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+## PARTICULAR PURPOSE. See the GNU Affero General Public License, version 3
+## for more details.
+##
+## You should have received a copy of the GNU Affero General Public License along 
+## with this program; if not, write to the Free Software Foundation, Inc., 
+## 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+##
+## -----------------------------------------------------------------------------
+## A commercial use license is available from Mavimax, Ltd
+## contact@mavimax.com
+## -----------------------------------------------------------------------------
+##
+
+export TESTNAME="test093_onephase"
+
+PWD=`pwd`
+if [ `echo $PWD | grep $TESTNAME ` ]; then
+    # Do nothing 
+    echo > /dev/null
+else
+    # started from parent folder
+    pushd .
+    echo "Doing cd"
+    cd $TESTNAME
+fi;
+
+. ../testenv.sh
+
+export TESTDIR="$NDRX_APPHOME/atmitest/$TESTNAME"
+export PATH=$PATH:$TESTDIR
+export NDRX_ULOG=$TESTDIR
+export NDRX_TOUT=10
+export NDRX_SILENT=Y
+
+#
+# Domain 1 - here client will live
+#
+function set_dom1 {
+    echo "Setting domain 1"
+    . ../dom1.sh
+    export NDRX_CONFIG=$TESTDIR/ndrxconfig-dom1.xml
+    export NDRX_DMNLOG=$TESTDIR/ndrxd-dom1.log
+    export NDRX_LOG=$TESTDIR/ndrx-dom1.log
+    export NDRX_DEBUG_CONF=$TESTDIR/debug-dom1.conf
+    export NDRX_TEST_RM_DIR=$TESTDIR/RM
+
+    export NDRX_XA_RES_ID=1
+    export NDRX_XA_OPEN_STR="+"
+    export NDRX_XA_CLOSE_STR=$NDRX_XA_OPEN_STR
+    export NDRX_XA_DRIVERLIB=$TESTDIR/libxadrv93.so
+    
+    if [ "$(uname)" == "Darwin" ]; then
+        export NDRX_XA_DRIVERLIB=$TESTDIR/libxadrv93.dylib
+    fi
+    
+    export NDRX_XA_RMLIB=$NDRX_XA_DRIVERLIB
+    export NDRX_XA_LAZY_INIT=0
+}
+
+#
+# Generic exit function
+#
+function go_out {
+    echo "Test exiting with: $1"
+
+    set_dom1;
+    xadmin stop -y
+    xadmin down -y
+
+    popd 2>/dev/null
+    exit $1
+}
+
+#
+# Restart the domain with given tmsrv options
+#
+function restart_dom1 {
+    export TEST93_TMOPT=$1
+    echo "Starting tmsrv with [$TEST93_TMOPT]"
+    xadmin stop -y
+    xadmin start -y || go_out 1
+}
+
+#
+# Run single transaction and check the RM journal
+# $1 - expected outcome (commit/abort)
+# $2 - expected journal
+#
+function run_tran {
+    rm -f $NDRX_TEST_RM_DIR/ops 2>/dev/null
+    
+    (./atmiclt93 $1 2>&1) >> ./atmiclt-dom1.log
+    RET=$?
+    
+    if [[ "X$RET" != "X0" ]]; then
+        echo "atmiclt93 $1 failed"
+        go_out $RET
+    fi
+    
+    OPS=`cat $NDRX_TEST_RM_DIR/ops | tr '\n' ';'`
+    
+    echo "RM journal: [$OPS] expected: [$2]"
+    
+    if [ "X$OPS" != "X$2" ]; then
+        echo "TESTERROR: invalid RM operations!"
+        go_out -1
+    fi
+}
+
+rm *.log 2>/dev/null
+rm ULOG* 2>/dev/null
+rm -rf $TESTDIR/RM1 $TESTDIR/RM
+mkdir $TESTDIR/RM1 $TESTDIR/RM
+
+set_dom1;
+xadmin down -y
+restart_dom1 ""
+
+echo "Default - single branch uses prepare and commit"
+run_tran commit "prepare;commit;"
+
+restart_dom1 "-O"
+
+echo "One-phase commit enabled"
+run_tran commit "onephase commit;"
+
+echo "One-phase commit failure - branch rolled back"
+touch $NDRX_TEST_RM_DIR/fail_onephase
+run_tran abort "onephase rollback;"
+rm $NDRX_TEST_RM_DIR/fail_onephase
+
+echo "Nothing left in transaction log"
+if [ "X`ls $TESTDIR/RM1`" != "X" ]; then
+    echo "TESTERROR: transaction logs left in RM1!"
+    go_out -2
+fi
+
+# Catch is there is test error!!!
+if [ "X`grep TESTERROR *.log`" != "X" ]; then
+    echo "Test error detected!"
+    go_out -3
+fi
+
+go_out 0
+
+# vim: set ts=4 sw=4 et smartindent:
@@ -0,0 +1,209 @@
+/**
+ * @brief One-phase commit test - journaling XA resource manager
+ *   Every prepare/commit/rollback is appended to the journal file in
+ *   NDRX_TEST_RM_DIR. If `fail_onephase' file is present in the directory,
+ *   commit with TMONEPHASE rolls back the branch.
+ *
+ * @file xabackend93.c
+ */
+/* -----------------------------------------------------------------------------
+ * Enduro/X Middleware Platform for Distributed Transaction Processing
+ * Copyright (C) 2009-2016, ATR Baltic, Ltd. All Rights Reserved.
+ * Copyright (C) 2017-2019, Mavimax, Ltd. All Rights Reserved.
+ * This software is released under one of the following licenses:
+ * AGPL (with Java and Go exceptions) or Mavimax's license for commercial use.
+ * See LICENSE file for full text.
+ * -----------------------------------------------------------------------------
+ * AGPL license:
+ * 
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License, version 3 as published
+ * by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License, version 3
+ * for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program; if not, write to the Free Software Foundation, Inc., 
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * -----------------------------------------------------------------------------
+ * A commercial use license is available from Mavimax, Ltd
+ * contact@mavimax.com
+ * -----------------------------------------------------------------------------
+ */
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <memory.h>
+#include <errno.h>
+
+#include <atmi.h>
+#include <ndebug.h>
+#include <ndrstandard.h>
+
+#include <unistd.h>
+#include <xa.h>
+#include <atmi_int.h>
+#include "test93.h"
+/*---------------------------Externs------------------------------------*/
+/*---------------------------Macros-------------------------------------*/
+/*---------------------------Enums--------------------------------------*/
+/*---------------------------Typedefs-----------------------------------*/
+/*---------------------------Globals------------------------------------*/
+/*---------------------------Statics------------------------------------*/
+__thread int M_is_open = EXFALSE;
+/*---------------------------Prototypes---------------------------------*/
+
+expublic int xa_open_entry93(char *xa_info, int rmid, long flags);
+expublic int xa_close_entry93(char *xa_info, int rmid, long flags);
+expublic int xa_start_entry93(XID *xid, int rmid, long flags);
+expublic int xa_end_entry93(XID *xid, int rmid, long flags);
+expublic int xa_rollback_entry93(XID *xid, int rmid, long flags);
+expublic int xa_prepare_entry93(XID *xid, int rmid, long flags);
+expublic int xa_commit_entry93(XID *xid, int rmid, long flags);
+expublic int xa_recover_entry93(XID *xid, long count, int rmid, long flags);
+expublic int xa_forget_entry93(XID *xid, int rmid, long flags);
+expublic int xa_complete_entry93(int *handle, int *retval, int rmid, long flags);
+
+struct xa_switch_t ndrxstatsw93 = 
+{ 
+    .name = "ndrxstatsw93",
+    .flags = TMNOFLAGS,
+    .version = 0,
+    .xa_open_entry = xa_open_entry93,
+    .xa_close_entry = xa_close_entry93,
+    .xa_start_entry = xa_start_entry93,
+    .xa_end_entry = xa_end_entry93,
+    .xa_rollback_entry = xa_rollback_entry93,
+    .xa_prepare_entry = xa_prepare_entry93,
+    .xa_commit_entry = xa_commit_entry93,
+    .xa_recover_entry = xa_recover_entry93,
+    .xa_forget_entry = xa_forget_entry93,
+    .xa_complete_entry = xa_complete_entry93
+};
+
+/**
+ * Build file name in the RM directory
+ * @param buf output buffer
+ * @param bufsz buffer size
+ * @param name file name
+ */
+exprivate void rm_file(char *buf, size_t bufsz, char *name)
+{
+    snprintf(buf, bufsz, "%s/%s", getenv("NDRX_TEST_RM_DIR"), name);
+}
+
+/**
+ * Append operation to the journal
+ * @param op operation name
+ * @return EXSUCCEED/EXFAIL
+ */
+exprivate int journal(char *op)
+{
+    int ret = EXSUCCEED;
+    char fname[PATH_MAX+1];
+    FILE *f;
+    
+    rm_file(fname, sizeof(fname), TEST93_OPSFILE);
+    
+    if (NULL==(f=fopen(fname, "a")))
+    {
+        NDRX_LOG(log_error, "TESTERROR: failed to open [%s]: %s", 
+                fname, strerror(errno));
+        EXFAIL_OUT(ret);
+    }
+    
+    fprintf(f, "%s\n", op);
+    fclose(f);
+    
+out:
+    return ret;
+}
+
+expublic int xa_open_entry93(char *xa_info, int rmid, long flags)
+{
+    M_is_open = EXTRUE;
+    return XA_OK;
+}
+
+expublic int xa_close_entry93(char *xa_info, int rmid, long flags)
+{
+    M_is_open = EXFALSE;
+    return XA_OK;
+}
+
+expublic int xa_start_entry93(XID *xid, int rmid, long flags)
+{
+    if (!M_is_open)
+    {
+        NDRX_LOG(log_error, "TESTERROR!!! xa_start_entry93() - XA not open!");
+        return XAER_RMERR;
+    }
+    
+    return XA_OK;
+}
+
+expublic int xa_end_entry93(XID *xid, int rmid, long flags)
+{
+    return XA_OK;
+}
+
+expublic int xa_rollback_entry93(XID *xid, int rmid, long flags)
+{
+    return EXSUCCEED==journal("rollback")?XA_OK:XAER_RMERR;
+}
+
+expublic int xa_prepare_entry93(XID *xid, int rmid, long flags)
+{
+    return EXSUCCEED==journal("prepare")?XA_OK:XAER_RMERR;
+}
+
+expublic int xa_commit_entry93(XID *xid, int rmid, long flags)
+{
+    char fname[PATH_MAX+1];
+    
+    if (!(flags & TMONEPHASE))
+    {
+        return EXSUCCEED==journal("commit")?XA_OK:XAER_RMERR;
+    }
+    
+    rm_file(fname, sizeof(fname), TEST93_FAILFILE);
+    
+    if (EXSUCCEED==access(fname, F_OK))
+    {
+        NDRX_LOG(log_warn, "One-phase commit - rolling back");
+        return EXSUCCEED==journal("onephase rollback")?XA_RBROLLBACK:XAER_RMERR;
+    }
+    
+    return EXSUCCEED==journal("onephase commit")?XA_OK:XAER_RMERR;
+}
+
+expublic int xa_recover_entry93(XID *xid, long count, int rmid, long flags)
+{
+    return 0;
+}
+
+expublic int xa_forget_entry93(XID *xid, int rmid, long flags)
+{
+    return XA_OK;
+}
+
+expublic int xa_complete_entry93(int *handle, int *retval, int rmid, long flags)
+{
+    return XA_OK;
+}
+
+/**
+ * Driver entry, the switch is in the same library
+ * @return XA switch
+ */
+struct xa_switch_t *ndrx_get_xa_switch(void)
+{
+    NDRX_LOG(log_debug, "Loading one-phase test XA switch");
+    return &ndrxstatsw93;
+}
+
+/* vim: set ts=4 sw=4 et smartindent: */
@@ -0,0 +1,275 @@
+/**
+ * @brief Conversation queue pool test - client
+ *   Checks that listen queues are taken from the pool and reused, that
+ *   pool exhaustion falls back to own queue and that message of earlier
+ *   conversation left on the pooled queue is not delivered to the new one.
+ *
+ * @file atmiclt94.c
+ */
+/* -----------------------------------------------------------------------------
+ * Enduro/X Middleware Platform for Distributed Transaction Processing
+ * Copyright (C) 2009-2016, ATR Baltic, Ltd. All Rights Reserved.
+ * Copyright (C) 2017-2019, Mavimax, Ltd. All Rights Reserved.
+ * This software is released under one of the following licenses:
+ * AGPL (with Java and Go exceptions) or Mavimax's license for commercial use.
+ * See LICENSE file for full text.
+ * -----------------------------------------------------------------------------
+ * AGPL license:
+ * 
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License, version 3 as published
+ * by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License, version 3
+ * for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program; if not, write to the Free Software Foundation, Inc., 
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * -----------------------------------------------------------------------------
+ * A commercial use license is available from Mavimax, Ltd
+ * contact@mavimax.com
+ * -----------------------------------------------------------------------------
+ */
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <memory.h>
+#include <errno.h>
+
+#include <atmi.h>
+#include <ndebug.h>
+#include <ndrstandard.h>
+#include <atmi_int.h>
+#include <atmi_tls.h>
+#include <typed_buf.h>
+#include "test94.h"
+/*---------------------------Externs------------------------------------*/
+/*---------------------------Macros-------------------------------------*/
+/*---------------------------Enums--------------------------------------*/
+/*---------------------------Typedefs-----------------------------------*/
+/*---------------------------Globals------------------------------------*/
+/*---------------------------Statics------------------------------------*/
+/*---------------------------Prototypes---------------------------------*/
+
+/**
+ * Get conversation control block
+ * @param cd call descriptor
+ * @return conversation
+ */
+exprivate tp_conversation_control_t *get_conv(int cd)
+{
+    return &G_atmi_tls->G_tp_conversation_status[cd%MAX_CONNECTIONS];
+}
+
+/**
+ * Put message of earlier conversation to the listen queue of the current one
+ * @param conv current conversation
+ * @param callseq call sequence of earlier conversation
+ * @return EXSUCCEED/EXFAIL
+ */
+exprivate int send_stale(tp_conversation_control_t *conv, unsigned short callseq)
+{
+    int ret = EXSUCCEED;
+    char buf[sizeof(tp_command_call_t)+sizeof(STALE_MSG)];
+    tp_command_call_t *call = (tp_command_call_t *)buf;
+    
+    memset(buf, 0, sizeof(buf));
+    
+    call->command_id = ATMI_COMMAND_CONVDATA;
+    call->cd = conv->cd;
+    call->callseq = callseq;
+    call->msgseq = 0;
+    call->buffer_type_id = BUF_TYPE_STRING;
+    call->data_len = sizeof(STALE_MSG);
+    NDRX_STRCPY_SAFE(call->reply_to, conv->reply_q_str);
+    strcpy(call->data, STALE_MSG);
+    
+    if (EXSUCCEED!=ndrx_generic_q_send(conv->my_listen_q_str, buf, 
+            sizeof(buf), 0L, 0))
+    {
+        NDRX_LOG(log_error, "TESTERROR: failed to send stale message to [%s]",
+                conv->my_listen_q_str);
+        EXFAIL_OUT(ret);
+    }
+    
+out:
+    return ret;
+}
+
+/**
+ * Receive all messages of the conversation
+ * @param cd call descriptor
+ * @return EXSUCCEED/EXFAIL
+ */
+exprivate int recv_all(int cd)
+{
+    int ret = EXSUCCEED;
+    int i;
+    long revent;
+    long len;
+    char *buf = NULL;
+    char exp[32];
+    
+    if (NULL==(buf = tpalloc("STRING", NULL, 128)))
+    {
+        NDRX_LOG(log_error, "TESTERROR: tpalloc() failed: %s", 
+                tpstrerror(tperrno));
+        EXFAIL_OUT(ret);
+    }
+    
+    for (i=0; i<NR_MSGS; i++)
+    {
+        if (EXSUCCEED!=tprecv(cd, &buf, &len, 0L, &revent))
+        {
+            NDRX_LOG(log_error, "TESTERROR: tprecv() %d failed: %s revent: %ld", 
+                    i, tpstrerror(tperrno), revent);
+            EXFAIL_OUT(ret);
+        }
+        
+        snprintf(exp, sizeof(exp), "MSG %d", i);
+        
+        if (0!=strcmp(buf, exp))
+        {
+            NDRX_LOG(log_error, "TESTERROR: expected [%s] got [%s]", exp, buf);
+            EXFAIL_OUT(ret);
+        }
+    }
+    
+    if (EXFAIL!=tprecv(cd, &buf, &len, 0L, &revent) || 
+            TPEEVENT!=tperrno || TPEV_SVCSUCC!=revent)
+    {
+        NDRX_LOG(log_error, "TESTERROR: expected TPEV_SVCSUCC, got: %s "
+                "revent: %ld", tpstrerror(tperrno), revent);
+        EXFAIL_OUT(ret);
+    }
+    
+out:
+
+    if (NULL!=buf)
+    {
+        tpfree(buf);
+    }
+
+    return ret;
+}
+
+/**
+ * Run the conversations
+ */
+int main(int argc, char** argv)
+{
+    int ret = EXSUCCEED;
+    int i;
+    int cd;
+    int cds[POOL_SIZE+1];
+    char poolq[NDRX_MAX_Q_SIZE+1] = {EXEOS};
+    unsigned short prev_callseq = 0;
+    tp_conversation_control_t *conv;
+    
+    if (EXSUCCEED!=tpinit(NULL))
+    {
+        NDRX_LOG(log_error, "TESTERROR: tpinit() failed: %s", 
+                tpstrerror(tperrno));
+        EXFAIL_OUT(ret);
+    }
+    
+    /* sequential conversations reuse the same pooled queue, stale
+     * message of previous conversation shall be dropped
+     */
+    for (i=0; i<NR_LOOPS; i++)
+    {
+        if (EXFAIL==(cd=tpconnect(TEST94_SVC, NULL, 0L, TPRECVONLY)))
+        {
+            NDRX_LOG(log_error, "TESTERROR: tpconnect() failed: %s", 
+                    tpstrerror(tperrno));
+            EXFAIL_OUT(ret);
+        }
+        
+        conv = get_conv(cd);
+        
+        if (NULL==conv->pool_ent)
+        {
+            NDRX_LOG(log_error, "TESTERROR: loop %d: queue [%s] not pooled", 
+                    i, conv->my_listen_q_str);
+            EXFAIL_OUT(ret);
+        }
+        
+        if (0==i)
+        {
+            NDRX_STRCPY_SAFE(poolq, conv->my_listen_q_str);
+        }
+        else 
+        {
+            if (0!=strcmp(poolq, conv->my_listen_q_str))
+            {
+                NDRX_LOG(log_error, "TESTERROR: loop %d: queue [%s] not "
+                        "reused, expected [%s]", i, conv->my_listen_q_str, poolq);
+                EXFAIL_OUT(ret);
+            }
+            
+            if (prev_callseq==conv->callseq)
+            {
+                NDRX_LOG(log_error, "TESTERROR: loop %d: callseq %hu not "
+                        "changed", i, conv->callseq);
+                EXFAIL_OUT(ret);
+            }
+            
+            if (EXSUCCEED!=send_stale(conv, prev_callseq))
+            {
+                EXFAIL_OUT(ret);
+            }
+        }
+        
+        prev_callseq = conv->callseq;
+        
+        if (EXSUCCEED!=recv_all(cd))
+        {
+            NDRX_LOG(log_error, "TESTERROR: loop %d failed", i);
+            EXFAIL_OUT(ret);
+        }
+    }
+    
+    /* parallel conversations, pool exhausts to own queue */
+    for (i=0; i<POOL_SIZE+1; i++)
+    {
+        if (EXFAIL==(cds[i]=tpconnect(TEST94_SVC, NULL, 0L, TPRECVONLY)))
+        {
+            NDRX_LOG(log_error, "TESTERROR: tpconnect() %d failed: %s", 
+                    i, tpstrerror(tperrno));
+            EXFAIL_OUT(ret);
+        }
+        
+        conv = get_conv(cds[i]);
+        
+        if ((i<POOL_SIZE) != (NULL!=conv->pool_ent))
+        {
+            NDRX_LOG(log_error, "TESTERROR: conversation %d queue [%s] "
+                    "pooled=%d", i, conv->my_listen_q_str, 
+                    NULL!=conv->pool_ent);
+            EXFAIL_OUT(ret);
+        }
+    }
+    
+    for (i=0; i<POOL_SIZE+1; i++)
+    {
+        if (EXSUCCEED!=recv_all(cds[i]))
+        {
+            NDRX_LOG(log_error, "TESTERROR: parallel conversation %d failed", i);
+            EXFAIL_OUT(ret);
+        }
+    }
+    
+out:
+
+    tpterm();
+    
+    fprintf(stderr, "Exit with %d\n", ret);
+
+    return ret;
+}
+
+/* vim: set ts=4 sw=4 et smartindent: */
@@ -0,0 +1,118 @@
+/**
+ * @brief Conversation queue pool test - server
+ *
+ * @file atmisv94.c
+ */
+/* -----------------------------------------------------------------------------
+ * Enduro/X Middleware Platform for Distributed Transaction Processing
+ * Copyright (C) 2009-2016, ATR Baltic, Ltd. All Rights Reserved.
+ * Copyright (C) 2017-2019, Mavimax, Ltd. All Rights Reserved.
+ * This software is released under one of the following licenses:
+ * AGPL (with Java and Go exceptions) or Mavimax's license for commercial use.
+ * See LICENSE file for full text.
+ * -----------------------------------------------------------------------------
+ * AGPL license:
+ * 
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License, version 3 as published
+ * by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License, version 3
+ * for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program; if not, write to the Free Software Foundation, Inc., 
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * -----------------------------------------------------------------------------
+ * A commercial use license is available from Mavimax, Ltd
+ * contact@mavimax.com
+ * -----------------------------------------------------------------------------
+ */
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <memory.h>
+#include <errno.h>
+
+#include <atmi.h>
+#include <ndebug.h>
+#include <ndrstandard.h>
+#include "test94.h"
+/*---------------------------Externs------------------------------------*/
+/*---------------------------Macros-------------------------------------*/
+/*---------------------------Enums--------------------------------------*/
+/*---------------------------Typedefs-----------------------------------*/
+/*---------------------------Globals------------------------------------*/
+/*---------------------------Statics------------------------------------*/
+/*---------------------------Prototypes---------------------------------*/
+
+/**
+ * Send NR_MSGS messages to the client and finish the conversation
+ */
+void CONVSV94 (TPSVCINFO *p_svc)
+{
+    int ret = EXSUCCEED;
+    int i;
+    long revent;
+    char *buf = NULL;
+    
+    if (NULL==(buf = tpalloc("STRING", NULL, 128)))
+    {
+        NDRX_LOG(log_error, "TESTERROR: tpalloc() failed: %s", 
+                tpstrerror(tperrno));
+        EXFAIL_OUT(ret);
+    }
+    
+    for (i=0; i<NR_MSGS; i++)
+    {
+        snprintf(buf, 128, "MSG %d", i);
+        
+        if (EXFAIL==tpsend(p_svc->cd, buf, 0L, 0L, &revent))
+        {
+            NDRX_LOG(log_error, "TESTERROR: tpsend() failed: %s revent: %ld", 
+                    tpstrerror(tperrno), revent);
+            EXFAIL_OUT(ret);
+        }
+    }
+    
+out:
+
+    if (NULL!=buf)
+    {
+        tpfree(buf);
+    }
+
+    tpreturn(EXSUCCEED==ret?TPSUCCESS:TPFAIL, 0L, NULL, 0L, 0L);
+}
+
+/**
+ * Do initialisation
+ */
+int NDRX_INTEGRA(tpsvrinit)(int argc, char **argv)
+{
+    int ret = EXSUCCEED;
+    
+    NDRX_LOG(log_debug, "tpsvrinit called");
+
+    if (EXSUCCEED!=tpadvertise(TEST94_SVC, CONVSV94))
+    {
+        NDRX_LOG(log_error, "Failed to initialise %s!", TEST94_SVC);
+        EXFAIL_OUT(ret);
+    }
+    
+out:
+    return ret;
+}
+
+/**
+ * Do de-initialisation
+ */
+void NDRX_INTEGRA(tpsvrdone)(void)
+{
+    NDRX_LOG(log_debug, "tpsvrdone called");
+}
+
+/* vim: set ts=4 sw=4 et smartindent: */
@@ -0,0 +1,61 @@
+/**
+ * @brief Conversation queue pool test - common defines
+ *
+ * @file test94.h
+ */
+/* -----------------------------------------------------------------------------
+ * Enduro/X Middleware Platform for Distributed Transaction Processing
+ * Copyright (C) 2009-2016, ATR Baltic, Ltd. All Rights Reserved.
+ * Copyright (C) 2017-2019, Mavimax, Ltd. All Rights Reserved.
+ * This software is released under one of the following licenses:
+ * AGPL (with Java and Go exceptions) or Mavimax's license for commercial use.
+ * See LICENSE file for full text.
+ * -----------------------------------------------------------------------------
+ * AGPL license:
+ * 
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License, version 3 as published
+ * by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License, version 3
+ * for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program; if not, write to the Free Software Foundation, Inc., 
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * -----------------------------------------------------------------------------
+ * A commercial use license is available from Mavimax, Ltd
+ * contact@mavimax.com
+ * -----------------------------------------------------------------------------
+ */
+#ifndef TEST94_H
+#define TEST94_H
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+/*---------------------------Includes-----------------------------------*/
+/*---------------------------Externs------------------------------------*/
+/*---------------------------Macros-------------------------------------*/
+#define TEST94_SVC      "CONVSV94"  /**< Conversational service            */
+#define NR_MSGS         5           /**< Messages sent by server           */
+#define POOL_SIZE       2           /**< NDRX_CONVPOOL set by run.sh       */
+#define NR_LOOPS        20          /**< Sequential conversations          */
+#define STALE_MSG       "STALE"     /**< Message of earlier conversation   */
+/*---------------------------Enums--------------------------------------*/
+/*---------------------------Typedefs-----------------------------------*/
+/*---------------------------Globals------------------------------------*/
+/*---------------------------Statics------------------------------------*/
+/*---------------------------Prototypes---------------------------------*/
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif  /* TEST94_H */
+
+/* vim: set ts=4 sw=4 et smartindent: */
@@ -0,0 +1,228 @@
+/**
+ * @brief Bridge flow control test - client
+ *   Modes: `fill' - saturate the credit window of remote node, some calls
+ *   shall be rejected with TPELIMIT; `limit' - window is still full, call
+ *   is rejected; `free' - window is available, CR_WINDOW parallel calls pass.
+ *
+ * @file atmiclt95.c
+ */
+/* -----------------------------------------------------------------------------
+ * Enduro/X Middleware Platform for Distributed Transaction Processing
+ * Copyright (C) 2009-2016, ATR Baltic, Ltd. All Rights Reserved.
+ * Copyright (C) 2017-2019, Mavimax, Ltd. All Rights Reserved.
+ * This software is released under one of the following licenses:
+ * AGPL (with Java and Go exceptions) or Mavimax's license for commercial use.
+ * See LICENSE file for full text.
+ * -----------------------------------------------------------------------------
+ * AGPL license:
+ * 
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License, version 3 as published
+ * by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License, version 3
+ * for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program; if not, write to the Free Software Foundation, Inc., 
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * -----------------------------------------------------------------------------
+ * A commercial use license is available from Mavimax, Ltd
+ * contact@mavimax.com
+ * -----------------------------------------------------------------------------
+ */
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <memory.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include <atmi.h>
+#include <ndebug.h>
+#include <ndrstandard.h>
+#include "test95.h"
+/*---------------------------Externs------------------------------------*/
+/*---------------------------Macros-------------------------------------*/
+/*---------------------------Enums--------------------------------------*/
+/*---------------------------Typedefs-----------------------------------*/
+/*---------------------------Globals------------------------------------*/
+/*---------------------------Statics------------------------------------*/
+/*---------------------------Prototypes---------------------------------*/
+
+/**
+ * Send NR_FILL calls to slow service, rejects are collected, the rest is
+ * left in flight.
+ * @param buf call buffer
+ * @return EXSUCCEED/EXFAIL
+ */
+exprivate int do_fill(char *buf)
+{
+    int ret = EXSUCCEED;
+    int i;
+    int cd;
+    int rejects = 0;
+    long len;
+    
+    for (i=0; i<NR_FILL; i++)
+    {
+        if (EXFAIL==tpacall(HOLD_SVC, buf, 0L, 0L))
+        {
+            NDRX_LOG(log_error, "TESTERROR: tpacall() %d failed: %s", 
+                    i, tpstrerror(tperrno));
+            EXFAIL_OUT(ret);
+        }
+    }
+    
+    /* let the bridge reject */
+    sleep(3);
+    
+    while (EXSUCCEED!=tpgetrply(&cd, &buf, &len, TPGETANY|TPNOBLOCK))
+    {
+        if (TPEBLOCK==tperrno)
+        {
+            break;
+        }
+        else if (TPELIMIT==tperrno)
+        {
+            rejects++;
+        }
+        else
+        {
+            NDRX_LOG(log_error, "TESTERROR: unexpected error: %s", 
+                    tpstrerror(tperrno));
+            EXFAIL_OUT(ret);
+        }
+    }
+    
+    NDRX_LOG(log_info, "Calls rejected: %d accepted: %d", rejects, 
+            NR_FILL-rejects);
+    
+    if (0==rejects || NR_FILL-rejects < CR_WINDOW)
+    {
+        NDRX_LOG(log_error, "TESTERROR: invalid window use, rejects: %d, "
+                "accepted: %d window: %d", rejects, NR_FILL-rejects, CR_WINDOW);
+        EXFAIL_OUT(ret);
+    }
+    
+out:
+    return ret;
+}
+
+/**
+ * Window shall be still full
+ * @param buf call buffer
+ * @return EXSUCCEED/EXFAIL
+ */
+exprivate int do_limit(char *buf)
+{
+    int ret = EXSUCCEED;
+    long len;
+    
+    if (EXFAIL!=tpcall(FAST_SVC, buf, 0L, &buf, &len, 0L) || 
+            TPELIMIT!=tperrno)
+    {
+        NDRX_LOG(log_error, "TESTERROR: %s shall fail with TPELIMIT: %s", 
+                FAST_SVC, tpstrerror(tperrno));
+        EXFAIL_OUT(ret);
+    }
+    
+out:
+    return ret;
+}
+
+/**
+ * Full window shall be available
+ * @param buf call buffer
+ * @return EXSUCCEED/EXFAIL
+ */
+exprivate int do_free(char *buf)
+{
+    int ret = EXSUCCEED;
+    int i;
+    int cds[CR_WINDOW];
+    long len;
+    
+    for (i=0; i<CR_WINDOW; i++)
+    {
+        if (EXFAIL==(cds[i]=tpacall(FAST_SVC, buf, 0L, 0L)))
+        {
+            NDRX_LOG(log_error, "TESTERROR: tpacall() %d failed: %s", 
+                    i, tpstrerror(tperrno));
+            EXFAIL_OUT(ret);
+        }
+    }
+    
+    for (i=0; i<CR_WINDOW; i++)
+    {
+        if (EXSUCCEED!=tpgetrply(&cds[i], &buf, &len, 0L))
+        {
+            NDRX_LOG(log_error, "TESTERROR: call %d failed: %s", 
+                    i, tpstrerror(tperrno));
+            EXFAIL_OUT(ret);
+        }
+    }
+    
+out:
+    return ret;
+}
+
+/**
+ * Run the test mode
+ */
+int main(int argc, char** argv)
+{
+    int ret = EXSUCCEED;
+    char *buf = NULL;
+    
+    if (argc<2)
+    {
+        fprintf(stderr, "usage: %s fill|limit|free\n", argv[0]);
+        EXFAIL_OUT(ret);
+    }
+    
+    if (NULL==(buf = tpalloc("STRING", NULL, 128)))
+    {
+        NDRX_LOG(log_error, "TESTERROR: tpalloc() failed: %s", 
+                tpstrerror(tperrno));
+        EXFAIL_OUT(ret);
+    }
+    
+    NDRX_STRCPY_SAFE_DST(buf, "HELLO", 128);
+    
+    if (0==strcmp(argv[1], "fill"))
+    {
+        ret = do_fill(buf);
+    }
+    else if (0==strcmp(argv[1], "limit"))
+    {
+        ret = do_limit(buf);
+    }
+    else if (0==strcmp(argv[1], "free"))
+    {
+        ret = do_free(buf);
+    }
+    else
+    {
+        NDRX_LOG(log_error, "TESTERROR: invalid mode [%s]", argv[1]);
+        ret = EXFAIL;
+    }
+    
+out:
+
+    if (NULL!=buf)
+    {
+        tpfree(buf);
+    }
+
+    tpterm();
+    
+    fprintf(stderr, "Exit with %d\n", ret);
+
+    return ret;
+}
+
+/* vim: set ts=4 sw=4 et smartindent: */
@@ -0,0 +1,108 @@
+/**
+ * @brief Bridge flow control test - server
+ *   Instance with TEST95_HOLD env set advertises slow HOLDSV, others FASTSV.
+ *
+ * @file atmisv95.c
+ */
+/* -----------------------------------------------------------------------------
+ * Enduro/X Middleware Platform for Distributed Transaction Processing
+ * Copyright (C) 2009-2016, ATR Baltic, Ltd. All Rights Reserved.
+ * Copyright (C) 2017-2019, Mavimax, Ltd. All Rights Reserved.
+ * This software is released under one of the following licenses:
+ * AGPL (with Java and Go exceptions) or Mavimax's license for commercial use.
+ * See LICENSE file for full text.
+ * -----------------------------------------------------------------------------
+ * AGPL license:
+ * 
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License, version 3 as published
+ * by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License, version 3
+ * for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program; if not, write to the Free Software Foundation, Inc., 
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * -----------------------------------------------------------------------------
+ * A commercial use license is available from Mavimax, Ltd
+ * contact@mavimax.com
+ * -----------------------------------------------------------------------------
+ */
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <memory.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include <atmi.h>
+#include <ndebug.h>
+#include <ndrstandard.h>
+#include "test95.h"
+/*---------------------------Externs------------------------------------*/
+/*---------------------------Macros-------------------------------------*/
+/*---------------------------Enums--------------------------------------*/
+/*---------------------------Typedefs-----------------------------------*/
+/*---------------------------Globals------------------------------------*/
+/*---------------------------Statics------------------------------------*/
+/*---------------------------Prototypes---------------------------------*/
+
+/**
+ * Slow service, keeps the incoming calls in the bridge
+ */
+void HOLDSV (TPSVCINFO *p_svc)
+{
+    NDRX_LOG(log_debug, "%s got call, holding %d sec", __func__, HOLD_SECS);
+    sleep(HOLD_SECS);
+    tpreturn(TPSUCCESS, 0L, p_svc->data, 0L, 0L);
+}
+
+/**
+ * Echo service
+ */
+void FASTSV (TPSVCINFO *p_svc)
+{
+    NDRX_LOG(log_debug, "%s got call", __func__);
+    tpreturn(TPSUCCESS, 0L, p_svc->data, 0L, 0L);
+}
+
+/**
+ * Do initialisation
+ */
+int NDRX_INTEGRA(tpsvrinit)(int argc, char **argv)
+{
+    int ret = EXSUCCEED;
+    
+    NDRX_LOG(log_debug, "tpsvrinit called");
+    
+    if (NULL!=getenv("TEST95_HOLD"))
+    {
+        if (EXSUCCEED!=tpadvertise(HOLD_SVC, HOLDSV))
+        {
+            NDRX_LOG(log_error, "Failed to initialise %s!", HOLD_SVC);
+            EXFAIL_OUT(ret);
+        }
+    }
+    else if (EXSUCCEED!=tpadvertise(FAST_SVC, FASTSV))
+    {
+        NDRX_LOG(log_error, "Failed to initialise %s!", FAST_SVC);
+        EXFAIL_OUT(ret);
+    }
+    
+out:
+    return ret;
+}
+
+/**
+ * Do de-initialisation
+ */
+void NDRX_INTEGRA(tpsvrdone)(void)
+{
+    NDRX_LOG(log_debug, "tpsvrdone called");
+}
+
+/* vim: set ts=4 sw=4 et smartindent: */
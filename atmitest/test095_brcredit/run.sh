@@ -0,0 +1,164 @@
+#!/bin/bash
+##
+## @brief Bridge flow control test - launcher
+##
+## @file run.sh
+##
+## -----------------------------------------------------------------------------
+## Enduro/X Middleware Platform for Distributed Transaction Processing
+## Copyright (C) 2009-2016, ATR Baltic, Ltd. All Rights Reserved.
+## Copyright (C) 2017-2019, Mavimax, Ltd. All Rights Reserved.
+## This software is released under one of the following licenses:
+## AGPL (with Java and Go exceptions) or Mavimax's license for commercial use.
+## See LICENSE file for full text.
+## -----------------------------------------------------------------------------
+## AGPL license:
+## 
+## This program is free software; you can redistribute it and/or modify it under
+## the terms of the GNU Affero General Public License, version 3 as published
+## by the Free Software Foundation;
+##
+## This program is distributed in the hope that it will be useful, but WITHOUT ANY
+## WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+## PARTICULAR PURPOSE. See the GNU Affero General Public License, version 3
+## for more details.
+##
+## You should have received a copy of the GNU Affero General Public License along 
+## with this program; if not, write to the Free Software Foundation, Inc., 
+## 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+##
+## -----------------------------------------------------------------------------
+## A commercial use license is available from Mavimax, Ltd
+## contact@mavimax.com
+## -----------------------------------------------------------------------------
+##
+
+export TESTNAME="test095_brcredit"
+
+PWD=`pwd`
+if [ `echo $PWD | grep $TESTNAME ` ]; then
+    # Do nothing 
+    echo > /dev/null
+else
+    # started from parent folder
+    pushd .
+    echo "Doing cd"
+    cd $TESTNAME
+fi;
+
+. ../testenv.sh
+
+export TESTDIR="$NDRX_APPHOME/atmitest/$TESTNAME"
+export PATH=$PATH:$TESTDIR
+export NDRX_ULOG=$TESTDIR
+# calls parked in bridge temp queue live for timeout
+export NDRX_TOUT=30
+export NDRX_SILENT=Y
+
+#
+# Domain 1 - here client will live
+#
+function set_dom1 {
+    echo "Setting domain 1"
+    . ../dom1.sh
+    export NDRX_CONFIG=$TESTDIR/ndrxconfig-dom1.xml
+    export NDRX_DMNLOG=$TESTDIR/ndrxd-dom1.log
+    export NDRX_LOG=$TESTDIR/ndrx-dom1.log
+    export NDRX_DEBUG_CONF=$TESTDIR/debug-dom1.conf
+}
+
+#
+# Domain 2 - here server will live, grants window of 4 calls to dom1
+#
+function set_dom2 {
+    echo "Setting domain 2"
+    . ../dom2.sh
+    export NDRX_CONFIG=$TESTDIR/ndrxconfig-dom2.xml
+    export NDRX_DMNLOG=$TESTDIR/ndrxd-dom2.log
+    export NDRX_LOG=$TESTDIR/ndrx-dom2.log
+    export NDRX_DEBUG_CONF=$TESTDIR/debug-dom2.conf
+}
+
+#
+# Generic exit function
+#
+function go_out {
+    echo "Test exiting with: $1"
+
+    set_dom1;
+    xadmin stop -y
+    xadmin down -y
+
+    set_dom2;
+    xadmin stop -y
+    xadmin down -y
+
+    popd 2>/dev/null
+    exit $1
+}
+
+#
+# Run client in given mode
+#
+function run_clt {
+    echo "Running client: $1"
+    (./atmiclt95 $1 2>&1) >> ./atmiclt-dom1.log
+    RET=$?
+
+    if [[ "X$RET" != "X0" ]]; then
+        echo "atmiclt95 $1 failed"
+        go_out $RET
+    fi
+}
+
+rm *.log 2>/dev/null
+rm ULOG* 2>/dev/null
+
+set_dom1;
+xadmin down -y
+xadmin start -y || go_out 1
+
+set_dom2;
+xadmin down -y
+xadmin start -y || go_out 2
+
+set_dom1;
+echo "Wait for connection..."
+sleep 10
+
+xadmin psc
+
+echo "Window is available"
+run_clt free
+
+echo "Saturate the window"
+run_clt fill
+
+echo "Window is still full"
+run_clt limit
+
+if [ "X`grep 'No flow control credits' bridge-dom1.log`" == "X" ]; then
+    echo "TESTERROR: no rejects logged by bridge!"
+    go_out -1
+fi
+
+echo "Reconnect the bridge, window is negotiated again"
+set_dom2;
+xadmin stop -i 101
+xadmin start -i 101
+
+set_dom1;
+echo "Wait for connection..."
+sleep 10
+
+run_clt free
+
+# Catch is there is test error!!!
+if [ "X`grep TESTERROR *.log`" != "X" ]; then
+        echo "Test error detected!"
+        RET=-2
+fi
+
+go_out $RET
+
+# vim: set ts=4 sw=4 et smartindent:
@@ -0,0 +1,61 @@
+/**
+ * @brief Bridge flow control test - common defines
+ *
+ * @file test95.h
+ */
+/* -----------------------------------------------------------------------------
+ * Enduro/X Middleware Platform for Distributed Transaction Processing
+ * Copyright (C) 2009-2016, ATR Baltic, Ltd. All Rights Reserved.
+ * Copyright (C) 2017-2019, Mavimax, Ltd. All Rights Reserved.
+ * This software is released under one of the following licenses:
+ * AGPL (with Java and Go exceptions) or Mavimax's license for commercial use.
+ * See LICENSE file for full text.
+ * -----------------------------------------------------------------------------
+ * AGPL license:
+ * 
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License, version 3 as published
+ * by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License, version 3
+ * for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program; if not, write to the Free Software Foundation, Inc., 
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * -----------------------------------------------------------------------------
+ * A commercial use license is available from Mavimax, Ltd
+ * contact@mavimax.com
+ * -----------------------------------------------------------------------------
+ */
+#ifndef TEST95_H
+#define TEST95_H
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+/*---------------------------Includes-----------------------------------*/
+/*---------------------------Externs------------------------------------*/
+/*---------------------------Macros-------------------------------------*/
+#define HOLD_SVC        "HOLDSV"    /**< Slow service, fills the window    */
+#define FAST_SVC        "FASTSV"    /**< Echo service                      */
+#define HOLD_SECS       10          /**< HOLDSV processing time            */
+#define CR_WINDOW       4           /**< -W of the dom2 bridge             */
+#define NR_FILL         20          /**< Calls sent to fill the window     */
+/*---------------------------Enums--------------------------------------*/
+/*---------------------------Typedefs-----------------------------------*/
+/*---------------------------Globals------------------------------------*/
+/*---------------------------Statics------------------------------------*/
+/*---------------------------Prototypes---------------------------------*/
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif  /* TEST95_H */
+
+/* vim: set ts=4 sw=4 et smartindent: */
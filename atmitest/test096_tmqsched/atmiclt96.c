@@ -0,0 +1,473 @@
+/**
+ * @brief TMQ scheduling test client
+ *
+ * @file atmiclt96.c
+ */
+/* -----------------------------------------------------------------------------
+ * Enduro/X Middleware Platform for Distributed Transaction Processing
+ * Copyright (C) 2009-2016, ATR Baltic, Ltd. All Rights Reserved.
+ * Copyright (C) 2017-2019, Mavimax, Ltd. All Rights Reserved.
+ * This software is released under one of the following licenses:
+ * AGPL (with Java and Go exceptions) or Mavimax's license for commercial use.
+ * See LICENSE file for full text.
+ * -----------------------------------------------------------------------------
+ * AGPL license:
+ * 
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License, version 3 as published
+ * by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License, version 3
+ * for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program; if not, write to the Free Software Foundation, Inc., 
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * -----------------------------------------------------------------------------
+ * A commercial use license is available from Mavimax, Ltd
+ * contact@mavimax.com
+ * -----------------------------------------------------------------------------
+ */
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <memory.h>
+#include <unistd.h>
+#include <time.h>
+
+#include <atmi.h>
+#include <ubf.h>
+#include <ndebug.h>
+#include <test.fd.h>
+#include <ndrstandard.h>
+#include <nstopwatch.h>
+/*---------------------------Externs------------------------------------*/
+/*---------------------------Macros-------------------------------------*/
+#define FWD_ROUNDS          5       /**< Number of forward wake-up rounds   */
+#define FWD_MAX_WAIT        5       /**< Max sec to wait for forward, tmqueue
+                                      scan time is 60 sec                   */
+/*---------------------------Enums--------------------------------------*/
+/*---------------------------Typedefs-----------------------------------*/
+
+/**
+ * Message to enqueue for queue mode tests
+ */
+typedef struct
+{
+    char *data;     /**< message data, used to check the dequeue order */
+    long flags;     /**< TPQCTL flags */
+    long priority;  /**< TPQCTL priority */
+    long deq_time;  /**< TPQCTL dequeue time, relative to now for ABS */
+} test_msg_t;
+/*---------------------------Globals------------------------------------*/
+/*---------------------------Statics------------------------------------*/
+/*---------------------------Prototypes---------------------------------*/
+exprivate int fwd_wake_test(void);
+exprivate int prio_test(void);
+exprivate int time_test(void);
+exprivate int inval_test(void);
+
+int main(int argc, char** argv)
+{
+    int ret = EXSUCCEED;
+    
+    if (argc<=1)
+    {
+        NDRX_LOG(log_error, "usage: %s <test_case: fwdwake|prio|time|inval>", argv[0]);
+        return EXFAIL;
+    }
+    NDRX_LOG(log_error, "\n\n\n\n\n !!!!!!!!!!!!!! TEST CASE %s !!!!!!!! \n\n\n\n\n\n", argv[1]);
+    
+    if (EXSUCCEED!=tpopen())
+    {
+        EXFAIL_OUT(ret);
+    }
+    
+    if (0==strcmp(argv[1], "fwdwake"))
+    {
+        ret = fwd_wake_test();
+    }
+    else if (0==strcmp(argv[1], "prio"))
+    {
+        ret = prio_test();
+    }
+    else if (0==strcmp(argv[1], "time"))
+    {
+        ret = time_test();
+    }
+    else if (0==strcmp(argv[1], "inval"))
+    {
+        ret = inval_test();
+    }
+    else
+    {
+        NDRX_LOG(log_error, "Invalid test case!");
+        ret = EXFAIL;
+    }
+    
+out:
+
+    tpclose();
+    tpterm();
+
+    return ret;   
+}
+
+/**
+ * Enqueue to auto queue while forwarder sleeps, the reply must be in reply
+ * queue in few seconds, i.e. enqueue wakes up the forwarder and it does not
+ * wait for the scan time.
+ * @return EXSUCCEED/EXFAIL
+ */
+exprivate int fwd_wake_test(void)
+{
+    int ret = EXSUCCEED;
+    TPQCTL qc;
+    UBFH *buf = NULL;
+    long len = 0;
+    int i;
+    int got;
+    char *p;
+    ndrx_stopwatch_t w;
+    
+    for (i=0; i<FWD_ROUNDS; i++)
+    {
+        /* let forwarder to go to sleep */
+        sleep(2);
+        
+        if (NULL==(buf = (UBFH *)tpalloc("UBF", "", 1024)))
+        {
+            NDRX_LOG(log_error, "TESTERROR: tpalloc() failed %s", 
+                    tpstrerror(tperrno));
+            EXFAIL_OUT(ret);
+        }
+        
+        if (EXSUCCEED!=Bchg(buf, T_STRING_2_FLD, 0, "HELLO FWD", 0L))
+        {
+            NDRX_LOG(log_error, "TESTERROR: failed to set T_STRING_2_FLD %s", 
+                    Bstrerror(Berror));
+            EXFAIL_OUT(ret);
+        }
+        
+        memset(&qc, 0, sizeof(qc));
+        qc.flags|=TPQREPLYQ;
+        NDRX_STRCPY_SAFE(qc.replyqueue, "REPLYQ");
+        
+        if (EXSUCCEED!=tpenqueue("MYSPACE", "FWDQ", &qc, (char *)buf, 0, 
+                TPNOTRAN))
+        {
+            NDRX_LOG(log_error, "TESTERROR: tpenqueue() failed %s diag: %d:%s", 
+                    tpstrerror(tperrno), qc.diagnostic, qc.diagmsg);
+            EXFAIL_OUT(ret);
+        }
+        
+        ndrx_stopwatch_reset(&w);
+        got = EXFALSE;
+        
+        while (ndrx_stopwatch_get_delta_sec(&w) < FWD_MAX_WAIT)
+        {
+            memset(&qc, 0, sizeof(qc));
+            
+            if (EXSUCCEED==tpdequeue("MYSPACE", "REPLYQ", &qc, (char **)&buf, 
+                    &len, TPNOTRAN))
+            {
+                got = EXTRUE;
+                break;
+            }
+            
+            if (TPEDIAGNOSTIC!=tperrno || QMENOMSG!=qc.diagnostic)
+            {
+                NDRX_LOG(log_error, "TESTERROR: tpdequeue() failed %s diag: %d:%s", 
+                        tpstrerror(tperrno), qc.diagnostic, qc.diagmsg);
+                EXFAIL_OUT(ret);
+            }
+            
+            usleep(100000);
+        }
+        
+        if (!got)
+        {
+            NDRX_LOG(log_error, "TESTERROR: round %d: message not forwarded "
+                    "in %d sec", i, FWD_MAX_WAIT);
+            EXFAIL_OUT(ret);
+        }
+        
+        NDRX_LOG(log_info, "round %d: forwarded in %ld ms", i, 
+                ndrx_stopwatch_get_delta(&w));
+        
+        if (NULL==(p = Bfind(buf, T_STRING_FLD, 0, 0L)) || 0!=strcmp(p, "OK"))
+        {
+            NDRX_LOG(log_error, "TESTERROR: reply not processed by SVCOK");
+            EXFAIL_OUT(ret);
+        }
+        
+        tpfree((char *)buf);
+        buf = NULL;
+    }
+    
+out:
+    if (NULL!=buf)
+    {
+        tpfree((char *)buf);
+    }
+
+    return ret;
+}
+
+/**
+ * Enqueue test message
+ * @param qname queue name
+ * @param msg message to enqueue
+ * @param diag_exp EXSUCCEED if enqueue must succeed, else expected
+ *  TPQCTL diagnostic
+ * @return EXSUCCEED/EXFAIL
+ */
+exprivate int enq_msg(char *qname, test_msg_t *msg, long diag_exp)
+{
+    int ret = EXSUCCEED;
+    TPQCTL qc;
+    char *buf = NULL;
+    
+    if (NULL==(buf = tpalloc("STRING", "", strlen(msg->data)+1)))
+    {
+        NDRX_LOG(log_error, "TESTERROR: tpalloc() failed %s", 
+                tpstrerror(tperrno));
+        EXFAIL_OUT(ret);
+    }
+    
+    strcpy(buf, msg->data);
+    
+    memset(&qc, 0, sizeof(qc));
+    qc.flags = msg->flags;
+    qc.priority = msg->priority;
+    qc.deq_time = msg->deq_time;
+    
+    if (msg->flags & TPQTIME_ABS)
+    {
+        qc.deq_time += (long)time(NULL);
+    }
+    
+    if (EXSUCCEED==tpenqueue("MYSPACE", qname, &qc, buf, 0, TPNOTRAN))
+    {
+        if (EXSUCCEED!=diag_exp)
+        {
+            NDRX_LOG(log_error, "TESTERROR: [%s] enqueue to %s must fail "
+                    "with diag %ld", msg->data, qname, diag_exp);
+            EXFAIL_OUT(ret);
+        }
+    }
+    else if (EXSUCCEED==diag_exp)
+    {
+        NDRX_LOG(log_error, "TESTERROR: tpenqueue() [%s] failed %s diag: %d:%s", 
+                msg->data, tpstrerror(tperrno), qc.diagnostic, qc.diagmsg);
+        EXFAIL_OUT(ret);
+    }
+    else if (TPEDIAGNOSTIC!=tperrno || diag_exp!=qc.diagnostic)
+    {
+        NDRX_LOG(log_error, "TESTERROR: tpenqueue() [%s] expected diag %ld, "
+                "got %s diag: %d:%s", msg->data, diag_exp, 
+                tpstrerror(tperrno), qc.diagnostic, qc.diagmsg);
+        EXFAIL_OUT(ret);
+    }
+    
+out:
+    if (NULL!=buf)
+    {
+        tpfree(buf);
+    }
+
+    return ret;
+}
+
+/**
+ * Dequeue test message and check it
+ * @param qname queue name
+ * @param data_exp expected message data, NULL if queue must be empty
+ * @return EXSUCCEED/EXFAIL
+ */
+exprivate int deq_msg(char *qname, char *data_exp)
+{
+    int ret = EXSUCCEED;
+    TPQCTL qc;
+    char *buf = NULL;
+    long len = 0;
+    
+    if (NULL==(buf = tpalloc("STRING", "", 128)))
+    {
+        NDRX_LOG(log_error, "TESTERROR: tpalloc() failed %s", 
+                tpstrerror(tperrno));
+        EXFAIL_OUT(ret);
+    }
+    
+    memset(&qc, 0, sizeof(qc));
+    
+    if (EXSUCCEED!=tpdequeue("MYSPACE", qname, &qc, &buf, &len, TPNOTRAN))
+    {
+        if (NULL==data_exp && TPEDIAGNOSTIC==tperrno && 
+                QMENOMSG==qc.diagnostic)
+        {
+            NDRX_LOG(log_debug, "%s empty - ok", qname);
+        }
+        else
+        {
+            NDRX_LOG(log_error, "TESTERROR: tpdequeue() %s failed %s diag: %d:%s "
+                    "(expected [%s])", qname, tpstrerror(tperrno), 
+                    qc.diagnostic, qc.diagmsg, data_exp?data_exp:"<empty>");
+            EXFAIL_OUT(ret);
+        }
+    }
+    else if (NULL==data_exp)
+    {
+        NDRX_LOG(log_error, "TESTERROR: %s must be empty, got [%s]", 
+                qname, buf);
+        EXFAIL_OUT(ret);
+    }
+    else if (0!=strcmp(buf, data_exp))
+    {
+        NDRX_LOG(log_error, "TESTERROR: %s expected [%s] got [%s]", 
+                qname, data_exp, buf);
+        EXFAIL_OUT(ret);
+    }
+    
+out:
+    if (NULL!=buf)
+    {
+        tpfree(buf);
+    }
+
+    return ret;
+}
+
+/**
+ * Priority mode queue: highest priority first, equal priorities in fifo
+ * order, no TPQPRIORITY flag means priority 50.
+ * @return EXSUCCEED/EXFAIL
+ */
+exprivate int prio_test(void)
+{
+    int ret = EXSUCCEED;
+    int i;
+    test_msg_t msgs[] = {
+        {"P10",     TPQPRIORITY, 10,    0},
+        {"P90_1",   TPQPRIORITY, 90,    0},
+        {"PDFLT",   0,           0,     0},
+        {"P90_2",   TPQPRIORITY, 90,    0},
+        {"P100",    TPQPRIORITY, 100,   0},
+        {"P1",      TPQPRIORITY, 1,     0},
+        {"P50",     TPQPRIORITY, 50,    0}
+    };
+    char *order[] = {"P100", "P90_1", "P90_2", "PDFLT", "P50", "P10", "P1"};
+    
+    for (i=0; i<N_DIM(msgs); i++)
+    {
+        if (EXSUCCEED!=enq_msg("PRIOQ", &msgs[i], EXSUCCEED))
+        {
+            EXFAIL_OUT(ret);
+        }
+    }
+    
+    for (i=0; i<N_DIM(order); i++)
+    {
+        if (EXSUCCEED!=deq_msg("PRIOQ", order[i]))
+        {
+            EXFAIL_OUT(ret);
+        }
+    }
+    
+    if (EXSUCCEED!=deq_msg("PRIOQ", NULL))
+    {
+        EXFAIL_OUT(ret);
+    }
+    
+out:
+    return ret;
+}
+
+/**
+ * Time mode queue: message is not available before its dequeue time,
+ * available messages are dequeued by dequeue time. Message without dequeue
+ * time is available at once.
+ * @return EXSUCCEED/EXFAIL
+ */
+exprivate int time_test(void)
+{
+    int ret = EXSUCCEED;
+    int i;
+    test_msg_t msgs[] = {
+        {"REL6",    TPQTIME_REL, 0,     6},
+        {"ABS3",    TPQTIME_ABS, 0,     3},
+        {"NOW",     0,           0,     0},
+        {"REL3",    TPQTIME_REL, 0,     3}
+    };
+    
+    for (i=0; i<N_DIM(msgs); i++)
+    {
+        if (EXSUCCEED!=enq_msg("TIMEQ", &msgs[i], EXSUCCEED))
+        {
+            EXFAIL_OUT(ret);
+        }
+    }
+    
+    /* only message without dequeue time is available */
+    if (EXSUCCEED!=deq_msg("TIMEQ", "NOW") ||
+            EXSUCCEED!=deq_msg("TIMEQ", NULL))
+    {
+        EXFAIL_OUT(ret);
+    }
+    
+    sleep(4);
+    
+    /* both +3 messages are due, ABS3 was enqueued first */
+    if (EXSUCCEED!=deq_msg("TIMEQ", "ABS3") ||
+            EXSUCCEED!=deq_msg("TIMEQ", "REL3") ||
+            EXSUCCEED!=deq_msg("TIMEQ", NULL))
+    {
+        EXFAIL_OUT(ret);
+    }
+    
+    sleep(3);
+    
+    if (EXSUCCEED!=deq_msg("TIMEQ", "REL6") ||
+            EXSUCCEED!=deq_msg("TIMEQ", NULL))
+    {
+        EXFAIL_OUT(ret);
+    }
+    
+out:
+    return ret;
+}
+
+/**
+ * Invalid TPQCTL settings are rejected with QMEINVAL and nothing is enqueued
+ * @return EXSUCCEED/EXFAIL
+ */
+exprivate int inval_test(void)
+{
+    int ret = EXSUCCEED;
+    test_msg_t prio_low = {"P0",     TPQPRIORITY, 0,     0};
+    test_msg_t prio_high = {"P101",  TPQPRIORITY, 101,   0};
+    test_msg_t prio_neg = {"PNEG",   TPQPRIORITY, -5,    0};
+    test_msg_t time_both = {"BOTH",  TPQTIME_ABS|TPQTIME_REL, 0, 1};
+    
+    if (EXSUCCEED!=enq_msg("PRIOQ", &prio_low, QMEINVAL) ||
+            EXSUCCEED!=enq_msg("PRIOQ", &prio_high, QMEINVAL) ||
+            EXSUCCEED!=enq_msg("PRIOQ", &prio_neg, QMEINVAL) ||
+            EXSUCCEED!=enq_msg("TIMEQ", &time_both, QMEINVAL))
+    {
+        EXFAIL_OUT(ret);
+    }
+    
+    if (EXSUCCEED!=deq_msg("PRIOQ", NULL) ||
+            EXSUCCEED!=deq_msg("TIMEQ", NULL))
+    {
+        EXFAIL_OUT(ret);
+    }
+    
+out:
+    return ret;
+}
+
+/* vim: set ts=4 sw=4 et smartindent: */
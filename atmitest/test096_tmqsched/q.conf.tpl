@@ -0,0 +1,12 @@
+#
+# @(#) EnduroX Persistent Queue Configuration
+#
+@,svcnm=-,autoq=n,waitinit=0,waitretry=0,waitretryinc=0,waitretrymax=0,memonly=n
+# Where to put OK replies:
+REPLYQ
+# Auto Q, forwarded at once after enqueue
+FWDQ,svcnm=SVCOK,autoq=y,tries=3,waitinit=0,waitretry=1,waitretryinc=0,waitretrymax=1,memonly=n
+# Dequeued by TPQPRIORITY priority
+PRIOQ,svcnm=-,autoq=n,waitinit=0,waitretry=0,waitretryinc=0,waitretrymax=0,memonly=n,mode=prio
+# Dequeued by TPQTIME_ABS/TPQTIME_REL dequeue time
+TIMEQ,svcnm=-,autoq=n,waitinit=0,waitretry=0,waitretryinc=0,waitretrymax=0,memonly=n,mode=time
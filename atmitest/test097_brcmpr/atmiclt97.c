@@ -0,0 +1,141 @@
+/**
+ * @brief Bridge compression test - client
+ *   Sends large repetitive UBF buffer to remote echo service and checks
+ *   that reply is the same as the request
+ *
+ * @file atmiclt97.c
+ */
+/* -----------------------------------------------------------------------------
+ * Enduro/X Middleware Platform for Distributed Transaction Processing
+ * Copyright (C) 2009-2016, ATR Baltic, Ltd. All Rights Reserved.
+ * Copyright (C) 2017-2019, Mavimax, Ltd. All Rights Reserved.
+ * This software is released under one of the following licenses:
+ * AGPL (with Java and Go exceptions) or Mavimax's license for commercial use.
+ * See LICENSE file for full text.
+ * -----------------------------------------------------------------------------
+ * AGPL license:
+ * 
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License, version 3 as published
+ * by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License, version 3
+ * for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program; if not, write to the Free Software Foundation, Inc., 
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * -----------------------------------------------------------------------------
+ * A commercial use license is available from Mavimax, Ltd
+ * contact@mavimax.com
+ * -----------------------------------------------------------------------------
+ */
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <memory.h>
+#include <unistd.h>
+
+#include <atmi.h>
+#include <ubf.h>
+#include <ubfutil.h>
+#include <ndebug.h>
+#include <test.fd.h>
+#include <ndrstandard.h>
+#include "test97.h"
+/*---------------------------Externs------------------------------------*/
+/*---------------------------Macros-------------------------------------*/
+/*---------------------------Enums--------------------------------------*/
+/*---------------------------Typedefs-----------------------------------*/
+/*---------------------------Globals------------------------------------*/
+/*---------------------------Statics------------------------------------*/
+/*---------------------------Prototypes---------------------------------*/
+
+/**
+ * Build request, do the round trips
+ */
+int main(int argc, char** argv)
+{
+    int ret=EXSUCCEED;
+    UBFH *p_ub = NULL;
+    UBFH *p_rsp = NULL;
+    char occ[OCC_LEN+1];
+    long rsplen;
+    long seq;
+    int i;
+    
+    for (i=0; i<OCC_LEN; i++)
+    {
+        occ[i] = OCC_PATTERN[i % (sizeof(OCC_PATTERN)-1)];
+    }
+    occ[OCC_LEN] = EXEOS;
+
+    if (NULL==(p_ub = (UBFH *)tpalloc("UBF", NULL, NR_OCC*(OCC_LEN+64))) ||
+            NULL==(p_rsp = (UBFH *)tpalloc("UBF", NULL, 1024)))
+    {
+        NDRX_LOG(log_error, "TESTERROR: tpalloc failed: %s",
+                tpstrerror(tperrno));
+        EXFAIL_OUT(ret);
+    }
+    
+    for (i=0; i<NR_OCC; i++)
+    {
+        if (EXSUCCEED!=Bchg(p_ub, T_STRING_FLD, i, occ, 0L))
+        {
+            NDRX_LOG(log_error, "TESTERROR: Failed to set T_STRING_FLD[%d]: %s",
+                    i, Bstrerror(Berror));
+            EXFAIL_OUT(ret);
+        }
+    }
+    
+    for (seq=0; seq<NR_CALLS; seq++)
+    {
+        if (EXSUCCEED!=Bchg(p_ub, T_LONG_FLD, 0, (char *)&seq, 0L))
+        {
+            NDRX_LOG(log_error, "TESTERROR: Failed to set T_LONG_FLD: %s",
+                    Bstrerror(Berror));
+            EXFAIL_OUT(ret);
+        }
+        
+        if (EXFAIL==tpcall(ECHO_SVC, (char *)p_ub, 0L, 
+                (char **)&p_rsp, &rsplen, 0L))
+        {
+            NDRX_LOG(log_error, "TESTERROR: call %ld failed: %s",
+                    seq, tpstrerror(tperrno));
+            EXFAIL_OUT(ret);
+        }
+        
+        if (0!=Bcmp(p_ub, p_rsp))
+        {
+            NDRX_LOG(log_error, "TESTERROR: call %ld reply differs from "
+                    "request: %s", seq, Bstrerror(Berror));
+            ndrx_debug_dump_UBF(log_error, "Request", p_ub);
+            ndrx_debug_dump_UBF(log_error, "Reply", p_rsp);
+            EXFAIL_OUT(ret);
+        }
+    }
+    
+    NDRX_LOG(log_info, "%d round trips of %ld bytes OK", NR_CALLS, 
+            Bused(p_ub));
+
+out:
+    if (NULL!=p_ub)
+    {
+        tpfree((char *)p_ub);
+    }
+
+    if (NULL!=p_rsp)
+    {
+        tpfree((char *)p_rsp);
+    }
+
+    tpterm();
+    fprintf(stderr, "Exit with %d\n", ret);
+
+    return ret;
+}
+
+/* vim: set ts=4 sw=4 et smartindent: */
@@ -0,0 +1,206 @@
+#!/bin/bash
+##
+## @brief Bridge compression test - launcher
+##
+## @file run.sh
+##
+## -----------------------------------------------------------------------------
+## Enduro/X Middleware Platform for Distributed Transaction Processing
+## Copyright (C) 2009-2016, ATR Baltic, Ltd. All Rights Reserved.
+## Copyright (C) 2017-2019, Mavimax, Ltd. All Rights Reserved.
+## This software is released under one of the following licenses:
+## AGPL (with Java and Go exceptions) or Mavimax's license for commercial use.
+## See LICENSE file for full text.
+## -----------------------------------------------------------------------------
+## AGPL license:
+## 
+## This program is free software; you can redistribute it and/or modify it under
+## the terms of the GNU Affero General Public License, version 3 as published
+## by the Free Software Foundation;
+##
+## This program is distributed in the hope that it will be useful, but WITHOUT ANY
+## WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+## PARTICULAR PURPOSE. See the GNU Affero General Public License, version 3
+## for more details.
+##
+## You should have received a copy of the GNU Affero General Public License along 
+## with this program; if not, write to the Free Software Foundation, Inc., 
+## 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+##
+## -----------------------------------------------------------------------------
+## A commercial use license is available from Mavimax, Ltd
+## contact@mavimax.com
+## -----------------------------------------------------------------------------
+##
+
+export TESTNAME="test097_brcmpr"
+
+PWD=`pwd`
+if [ `echo $PWD | grep $TESTNAME ` ]; then
+    # Do nothing 
+    echo > /dev/null
+else
+    # started from parent folder
+    pushd .
+    echo "Doing cd"
+    cd $TESTNAME
+fi;
+
+. ../testenv.sh
+
+export TESTDIR="$NDRX_APPHOME/atmitest/$TESTNAME"
+export PATH=$PATH:$TESTDIR
+export NDRX_ULOG=$TESTDIR
+export NDRX_TOUT=30
+export NDRX_SILENT=Y
+
+#
+# Domain 1 - here client will live
+#
+function set_dom1 {
+    echo "Setting domain 1"
+    . ../dom1.sh
+    export NDRX_CONFIG=$TESTDIR/ndrxconfig-dom1.xml
+    export NDRX_DMNLOG=$TESTDIR/ndrxd-dom1.log
+    export NDRX_LOG=$TESTDIR/ndrx-dom1.log
+    export NDRX_DEBUG_CONF=$TESTDIR/debug-dom1.conf
+}
+
+#
+# Domain 2 - here server will live, bridge compression is driven
+# by TEST97_CMPR
+#
+function set_dom2 {
+    echo "Setting domain 2"
+    . ../dom2.sh
+    export NDRX_CONFIG=$TESTDIR/ndrxconfig-dom2.xml
+    export NDRX_DMNLOG=$TESTDIR/ndrxd-dom2.log
+    export NDRX_LOG=$TESTDIR/ndrx-dom2.log
+    export NDRX_DEBUG_CONF=$TESTDIR/debug-dom2.conf
+}
+
+#
+# Generic exit function
+#
+function go_out {
+    echo "Test exiting with: $1"
+
+    set_dom1;
+    xadmin stop -y
+    xadmin down -y
+
+    set_dom2;
+    xadmin stop -y
+    xadmin down -y
+
+    popd 2>/dev/null
+    exit $1
+}
+
+#
+# Run the round trips from dom1
+#
+function run_clt {
+    set_dom1;
+    (./atmiclt97 2>&1) >> ./atmiclt-dom1.log
+    RET=$?
+
+    if [[ "X$RET" != "X0" ]]; then
+        echo "atmiclt97 failed"
+        go_out $RET
+    fi
+}
+
+#
+# Read T_BRCON field of current domain:
+# 11 - TA_EX_CMPR, 12 - TA_EX_CMPRIN, 13 - TA_EX_CMPROUT
+#
+function brcon_fld {
+    xadmin mibget -c T_BRCON -m | cut -f $1 -d '|'
+}
+
+#
+# Start dom2 with given compression setting, wait for connection
+#
+function start_dom2 {
+    set_dom2;
+    export TEST97_CMPR=$1
+    xadmin down -y
+    xadmin start -y || go_out 2
+
+    set_dom1;
+    echo "Wait for connection..."
+    sleep 10
+    xadmin psc
+}
+
+rm *.log 2>/dev/null
+rm ULOG* 2>/dev/null
+
+set_dom1;
+xadmin down -y
+xadmin start -y || go_out 1
+
+echo "*** Compression on both nodes ***"
+start_dom2 "-C1024"
+run_clt
+
+for dom in 1 2; do
+    set_dom$dom;
+    xadmin mibget -c T_BRCON
+    CMPR=`brcon_fld 11`
+    CMPRIN=`brcon_fld 12`
+    CMPROUT=`brcon_fld 13`
+
+    if [[ "X$CMPR" != "XY" ]]; then
+        echo "TESTERROR: dom$dom compression not active ($CMPR)"
+        go_out -1
+    fi
+
+    if [[ $CMPRIN -le 0 || $CMPROUT -le 0 ]]; then
+        echo "TESTERROR: dom$dom no compression stats in=$CMPRIN out=$CMPROUT"
+        go_out -2
+    fi
+
+    if [[ $CMPROUT -ge $CMPRIN ]]; then
+        echo "TESTERROR: dom$dom frames not compressed in=$CMPRIN out=$CMPROUT"
+        go_out -3
+    fi
+done
+
+set_dom1;
+DOM1_CMPRIN=`brcon_fld 12`
+
+echo "*** Compression on dom1 only ***"
+start_dom2 ""
+run_clt
+
+set_dom1;
+xadmin mibget -c T_BRCON
+CMPR=`brcon_fld 11`
+CMPRIN=`brcon_fld 12`
+
+if [[ "X$CMPR" != "XN" || $CMPRIN -ne $DOM1_CMPRIN ]]; then
+    echo "TESTERROR: dom1 compresses for peer without -C: $CMPR $DOM1_CMPRIN -> $CMPRIN"
+    go_out -4
+fi
+
+set_dom2;
+xadmin mibget -c T_BRCON
+CMPR=`brcon_fld 11`
+CMPRIN=`brcon_fld 12`
+
+if [[ "X$CMPR" != "XN" || $CMPRIN -ne 0 ]]; then
+    echo "TESTERROR: dom2 compresses without -C: $CMPR $CMPRIN"
+    go_out -5
+fi
+
+# Catch is there is test error!!!
+if [ "X`grep TESTERROR *.log`" != "X" ]; then
+        echo "Test error detected!"
+        RET=-6
+fi
+
+go_out $RET
+
+# vim: set ts=4 sw=4 et smartindent:
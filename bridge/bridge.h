@@ -40,6 +40,7 @@ extern "C" {
 #endif
 
 /*---------------------------Includes-----------------------------------*/
+#include <stdint.h>
 #include <sys_unix.h>
 #include <exthpool.h>
 #include <pthread.h>
@@ -81,6 +82,9 @@ extern "C" {
 #define BR_MAX_ROUNDTRIP        200 /**< Allow 200 ms roundtrip for time default for timesync   */
 #define BR_PERIODIC_CLOCK_SND   600 /**< Send clocks every 10 minutes                           */
 #define BR_ADMININFO_TOUT       3   /**< Allow 3 seconds on full reply queue for metrics..      */
+
+#define BR_CMPR_MAGIC           "BRZ\001"  /**< Compressed frame magic (not a netcall/proto start) */
+#define BR_CMPR_MAGIC_LEN       4           /**< Magic len                                      */
 /*---------------------------Enums--------------------------------------*/
 /*---------------------------Typedefs-----------------------------------*/
 
@@ -123,8 +127,28 @@ typedef struct
     
     threadpool thpool_queue;    /**< Queue runner */
     
+    long cmprthres;               /**< Compress frames from this size, 0 - off  */
+    int peer_cmpr;                /**< Peer accepts compressed frames           */
+    NDRX_SPIN_LOCKDECL(cmpr_lock);/**< Compression stats lock                   */
+    long cmpr_in;                 /**< Bytes before compression                 */
+    long cmpr_out;                /**< Bytes after compression                  */
+    long cmpr_usec;               /**< CPU time spent compressing               */
+    long dcmpr_usec;              /**< CPU time spent decompressing             */
+    
+    int crwindow;                 /**< Credits granted to peer, 0 - off         */
+    int crwait;                   /**< Millis to wait for credit, 0 - reject    */
+    
 } bridge_cfg_t;
 
+/**
+ * Compressed frame header, followed by LZ block
+ */
+typedef struct
+{
+    char magic[BR_CMPR_MAGIC_LEN];  /**< BR_CMPR_MAGIC                  */
+    uint32_t len;                   /**< Original frame len, net order  */
+} br_cmpr_hdr_t;
+
 typedef struct in_msg in_msg_t;
 struct in_msg
 {
@@ -136,6 +160,7 @@ struct in_msg
     ndrx_stopwatch_t addedtime;   /**< Time in Q                               */
     ndrx_stopwatch_t updatetime;  /**< Last time when msg was processed        */
     int next_try_ms;              /**< When the next attempt is scheduled      */
+    int credit;                   /**< Message holds peer flow control credit  */
     in_msg_t *prev, *next;
 };
 
@@ -186,10 +211,10 @@ extern int br_submit_reply_to_q(tp_command_call_t *call, int len);
 extern int br_process_msg(exnetcon_t *net, char **buf, int len);
 extern int br_send_to_net(char *buf, int len, char msg_type, int command_id);
 
-extern int br_calc_clock_diff(command_call_t *call);
+extern int br_calc_clock_diff(command_call_t *call, int len);
 extern int br_coninfo(command_call_t *call);
 extern int br_send_clock(int mode, cmd_br_time_sync_t *rcv);
-extern void br_clock_adj(tp_command_call_t *call, int is_out);
+extern void br_clock_adj(tp_command_call_t *call, long len, int is_out);
 
 extern int br_tpcall_pushstack(tp_command_call_t *call);
 extern int br_get_conv_cd(char msg_type, char *buf, int *p_pool);
@@ -202,8 +227,21 @@ extern int br_process_error(char *buf, int len, int err, in_msg_t* from_q,
         int pack_type, char *destqstr, in_msg_hash_t * qhash);
 
 extern void br_tempq_init(void);
+
+extern int br_cmpr_frame(char *frame, long len, char **out, long *out_len);
+extern int br_dcmpr_frame(char **buf, int *len);
 extern int br_add_to_q(char *buf, int len, int pack_type, char *destq);
 
+extern void br_credit_init(void);
+extern void br_credit_reset(void);
+extern void br_credit_peer(int window);
+extern int br_credit_acquire(tp_command_call_t *call);
+extern void br_credit_putback(tp_command_call_t *call);
+extern int br_credit_take(tp_command_call_t *call);
+extern void br_credit_release(void);
+extern int br_credit_grant(command_call_t *call, int len);
+extern void br_credit_info(command_reply_brconinfo_t *infos);
+
 #ifdef	__cplusplus
 }
 #endif
@@ -143,6 +143,11 @@ expublic int br_disconnected(exnetcon_t *net)
      * - leave object in place...
     G_bridge_cfg.con = NULL;
     */
+    
+    /* compression is negotiated again on next connect */
+    G_bridge_cfg.peer_cmpr = EXFALSE;
+    /* and flow control window */
+    br_credit_reset();
     ret=br_send_status(EXFALSE);
     
     return ret;  
@@ -296,11 +301,17 @@ int NDRX_INTEGRA(tpsvrinit)(int argc, char **argv)
     /* Bug #689 */
     G_bridge_cfg.max_roundtrip = BR_MAX_ROUNDTRIP;
 
+    G_bridge_cfg.cmprthres = 0;
+    G_bridge_cfg.peer_cmpr = EXFALSE;
+    G_bridge_cfg.crwindow = 0;
+    G_bridge_cfg.crwait = 0;
+
     /* init the spinlock... */
     NDRX_SPIN_INIT_V(G_bridge_cfg.timediff_lock);
+    NDRX_SPIN_INIT_V(G_bridge_cfg.cmpr_lock);
 
     /* Parse command line  */
-    while ((c = getopt(argc, argv, "frn:i:p:t:T:z:c:g:s:P:R:a:6h:Q:q:L:M:B:m:A:k:K:")) != -1)
+    while ((c = getopt(argc, argv, "frn:i:p:t:T:z:c:g:s:P:R:a:6h:Q:q:L:M:B:m:A:k:K:C:W:w:")) != -1)
     {
         /* NDRX_LOG(log_debug, "%c = [%s]", c, optarg); - on solaris gets cores? */
         switch(c)
@@ -311,6 +322,21 @@ int NDRX_INTEGRA(tpsvrinit)(int argc, char **argv)
             case 'K':
                 G_bridge_cfg.net.periodic_clock_time = atoi(optarg);
                 break;
+            case 'C':
+                G_bridge_cfg.cmprthres = atol(optarg);
+                NDRX_LOG(log_debug, "Compress frames from, -C = [%ld] bytes", 
+                        G_bridge_cfg.cmprthres);
+                break;
+            case 'W':
+                G_bridge_cfg.crwindow = atoi(optarg);
+                NDRX_LOG(log_debug, "Flow control window, -W = [%d]", 
+                        G_bridge_cfg.crwindow);
+                break;
+            case 'w':
+                G_bridge_cfg.crwait = atoi(optarg);
+                NDRX_LOG(log_debug, "Flow control credit wait, -w = [%d] ms", 
+                        G_bridge_cfg.crwait);
+                break;
             case '6':
                 NDRX_LOG(log_debug, "Using IPv6 addresses");
                 G_bridge_cfg.net.is_ipv6=EXTRUE;
@@ -562,6 +588,10 @@ int NDRX_INTEGRA(tpsvrinit)(int argc, char **argv)
     NDRX_LOG(log_warn, "Temporary queue min sleep set to: %d", G_bridge_cfg.qminsleep);
     NDRX_LOG(log_warn, "Threadpool job queue size: %d", G_bridge_cfg.threadpoolbufsz);
     NDRX_LOG(log_warn, "Check interval is: %d seconds", G_bridge_cfg.check_interval);
+    NDRX_LOG(log_warn, "Compression threshold: %ld bytes (0 - off)", 
+            G_bridge_cfg.cmprthres);
+    NDRX_LOG(log_warn, "Flow control window: %d (0 - off), credit wait: %d ms", 
+            G_bridge_cfg.crwindow, G_bridge_cfg.crwait);
     
     if (0>G_bridge_cfg.net.recv_activity_timeout)
     {
@@ -600,6 +630,7 @@ int NDRX_INTEGRA(tpsvrinit)(int argc, char **argv)
     }
     
     br_tempq_init();
+    br_credit_init();
     
     /* Install call-backs */
     exnet_install_cb(&G_bridge_cfg.net, br_process_msg, br_connected, 
@@ -729,6 +760,7 @@ void NDRX_INTEGRA(tpsvrdone)(void)
     
     /* terminate spinlock.. */
     NDRX_SPIN_DESTROY_V(G_bridge_cfg.timediff_lock);
+    NDRX_SPIN_DESTROY_V(G_bridge_cfg.cmpr_lock);
 }
 
 /* vim: set ts=4 sw=4 et smartindent: */
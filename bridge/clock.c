@@ -54,6 +54,13 @@
 /*---------------------------Externs------------------------------------*/
 /*---------------------------Macros-------------------------------------*/
 #define CLOCK_DEBUG     1
+
+/**
+ * Is clock message field received? Fields added at the end of the struct are
+ * not sent by older peers.
+ */
+#define BR_TIME_HAS(LEN, FLD) ((LEN) >= EXOFFSET(cmd_br_time_sync_t, FLD) + \
+            (long)EXELEM_SIZE(cmd_br_time_sync_t, FLD))
 /*---------------------------Enums--------------------------------------*/
 /*---------------------------Typedefs-----------------------------------*/
 /*---------------------------Globals------------------------------------*/
@@ -134,6 +141,17 @@ expublic int br_coninfo(command_call_t *call)
     
     MUTEX_UNLOCK_V(M_timediff_lock);
     
+    infos.cmpr = (G_bridge_cfg.cmprthres > 0 && G_bridge_cfg.peer_cmpr)?'Y':'N';
+    
+    NDRX_SPIN_LOCK_V(G_bridge_cfg.cmpr_lock);
+    infos.cmprin = G_bridge_cfg.cmpr_in;
+    infos.cmprout = G_bridge_cfg.cmpr_out;
+    infos.cmprusec = G_bridge_cfg.cmpr_usec;
+    infos.dcmprusec = G_bridge_cfg.dcmpr_usec;
+    NDRX_SPIN_UNLOCK_V(G_bridge_cfg.cmpr_lock);
+    
+    br_credit_info(&infos);
+    
     ret = ndrx_generic_q_send_2(call->reply_queue, 
             (char *)&infos, sizeof(infos), 0, BR_ADMININFO_TOUT, 0);
     
@@ -143,9 +161,10 @@ out:
 /**
  * Initialize clock diff.
  * @param call
+ * @param len received message len
  * @return 
  */
-expublic int br_calc_clock_diff(command_call_t *call)
+expublic int br_calc_clock_diff(command_call_t *call, int len)
 {
     int ret=EXSUCCEED;
     ndrx_stopwatch_t our_time;
@@ -153,6 +172,32 @@ expublic int br_calc_clock_diff(command_call_t *call)
     long long diff=EXFAIL;
     long rountrip=0;
     int load_time=EXFALSE;
+    int cmpr = EXFALSE;
+    
+    if (!BR_TIME_HAS(len, orig_timestamp))
+    {
+        NDRX_LOG(log_error, "Invalid clock message len %d - dropped", len);
+        EXFAIL_OUT(ret);
+    }
+    
+    /* every clock message carries peer compression capability, peers
+     * not knowing the field do not decode compressed frames
+     */
+    if (BR_TIME_HAS(len, cmpr))
+    {
+        cmpr = their_time->cmpr;
+    }
+    
+    if (G_bridge_cfg.peer_cmpr!=cmpr)
+    {
+        NDRX_LOG(log_info, "Peer node %d compressed frames: %s, ours: %s",
+                call->caller_nodeid, cmpr?"yes":"no",
+                G_bridge_cfg.cmprthres > 0?"yes":"no");
+        G_bridge_cfg.peer_cmpr=cmpr;
+    }
+    
+    /* and the flow control window, older peers do not return credits */
+    br_credit_peer(BR_TIME_HAS(len, credits) ? their_time->credits : 0);
     
     /* if got request, just send reply */
     if (NDRX_BRCLOCK_MODE_REQ==their_time->mode)
@@ -278,6 +323,8 @@ expublic int br_send_clock(int mode, cmd_br_time_sync_t *rcv)
     }
     
     ourtime.mode=mode;
+    ourtime.cmpr=(G_bridge_cfg.cmprthres > 0);
+    ourtime.credits=G_bridge_cfg.crwindow;
     
     ret=br_send_to_net((char*)&ourtime, sizeof(ourtime), BR_NET_CALL_MSG_TYPE_NDRXD, 
             ourtime.call.command);
@@ -291,11 +338,14 @@ out:
 
 /**
  * Adjust clock in packet.
- * @return 
+ * @param call call or reply
+ * @param len message len (for trace section lookup)
+ * @param is_out message goes to network
  */
-expublic void br_clock_adj(tp_command_call_t *call, int is_out)
+expublic void br_clock_adj(tp_command_call_t *call, long len, int is_out)
 {
     long long diff;
+    ndrx_trace_t *trace;
     
     NDRX_SPIN_LOCK_V(G_bridge_cfg.timediff_lock);
     diff = G_bridge_cfg.timediff;
@@ -316,6 +366,19 @@ expublic void br_clock_adj(tp_command_call_t *call, int is_out)
     {
         ndrx_stopwatch_plus(&call->timer, diff);
     }
+    
+    /* hop stamps are relative to trace base, so shifting it is enough */
+    if (NULL!=(trace = ndrx_calltrace_get(call, len)))
+    {
+        if (is_out)
+        {
+            ndrx_stopwatch_minus(&trace->base, diff);
+        }
+        else
+        {
+            ndrx_stopwatch_plus(&trace->base, diff);
+        }
+    }
         
     NDRX_LOG(log_debug, "Clock diff: %lld ms", diff);
     N_TIMER_DUMP(log_info, "Adjusted call timer: ", call->timer);
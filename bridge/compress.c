@@ -0,0 +1,218 @@
+/**
+ * @brief Bridge frame compression. When both peers have compression
+ *   configured (announced in clock sync messages at connect), frames
+ *   from the threshold size are sent as LZ blocks prefixed by br_cmpr_hdr_t.
+ *   Compressed frames are recognized by magic, which differs from the first
+ *   bytes of the native netcall and of the common format frames.
+ *
+ * @file compress.c
+ */
+/* -----------------------------------------------------------------------------
+ * Enduro/X Middleware Platform for Distributed Transaction Processing
+ * Copyright (C) 2009-2016, ATR Baltic, Ltd. All Rights Reserved.
+ * Copyright (C) 2017-2019, Mavimax, Ltd. All Rights Reserved.
+ * This software is released under one of the following licenses:
+ * AGPL (with Java and Go exceptions) or Mavimax's license for commercial use.
+ * See LICENSE file for full text.
+ * -----------------------------------------------------------------------------
+ * AGPL license:
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License, version 3 as published
+ * by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License, version 3
+ * for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * -----------------------------------------------------------------------------
+ * A commercial use license is available from Mavimax, Ltd
+ * contact@mavimax.com
+ * -----------------------------------------------------------------------------
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <arpa/inet.h>
+
+#include <ndebug.h>
+#include <atmi.h>
+#include <atmi_int.h>
+#include <ndrstandard.h>
+#include <userlog.h>
+#include <exlz.h>
+
+#include <exnet.h>
+#include <ndrxdcmn.h>
+
+#include "bridge.h"
+/*---------------------------Externs------------------------------------*/
+/*---------------------------Macros-------------------------------------*/
+/*---------------------------Enums--------------------------------------*/
+/*---------------------------Typedefs-----------------------------------*/
+/*---------------------------Globals------------------------------------*/
+/*---------------------------Statics------------------------------------*/
+/*---------------------------Prototypes---------------------------------*/
+
+/**
+ * CPU time used by current thread
+ * @return microseconds
+ */
+exprivate long br_cpu_usec(void)
+{
+#ifdef CLOCK_THREAD_CPUTIME_ID
+    struct timespec ts;
+    
+    if (EXSUCCEED==clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts))
+    {
+        return (long)ts.tv_sec*1000000 + ts.tv_nsec/1000;
+    }
+#endif
+    /* no thread clock, use wall time */
+    {
+        ndrx_stopwatch_t w;
+        ndrx_stopwatch_reset(&w);
+        return (long)w.t.tv_sec*1000000 + w.t.tv_nsec/1000;
+    }
+}
+
+/**
+ * Compress outgoing frame if link has compression and frame is large enough.
+ * Frames which do not shrink are sent as is.
+ * @param frame frame to send (native netcall or common format)
+ * @param len frame len
+ * @param out compressed frame (sysbuf, caller frees) or NULL if not compressed
+ * @param out_len compressed frame len
+ * @return EXSUCCEED/EXFAIL
+ */
+expublic int br_cmpr_frame(char *frame, long len, char **out, long *out_len)
+{
+    int ret = EXSUCCEED;
+    char *buf = NULL;
+    size_t buf_len;
+    br_cmpr_hdr_t *hdr;
+    long clen;
+    long start;
+    long spent;
+    
+    *out = NULL;
+    
+    if (G_bridge_cfg.cmprthres <= 0 || !G_bridge_cfg.peer_cmpr || 
+            len < G_bridge_cfg.cmprthres)
+    {
+        goto out;
+    }
+    
+    NDRX_SYSBUF_MALLOC_OUT(buf, buf_len, ret);
+    
+    start = br_cpu_usec();
+    clen = ndrx_lz_compress(frame, len, buf+sizeof(br_cmpr_hdr_t), 
+            buf_len-sizeof(br_cmpr_hdr_t));
+    spent = br_cpu_usec() - start;
+    
+    if (EXFAIL==clen || clen+(long)sizeof(br_cmpr_hdr_t) >= len)
+    {
+        NDRX_LOG(log_debug, "Frame of %ld bytes not compressible - send as is", 
+                len);
+        clen = len;
+    }
+    else
+    {
+        hdr = (br_cmpr_hdr_t *)buf;
+        memcpy(hdr->magic, BR_CMPR_MAGIC, BR_CMPR_MAGIC_LEN);
+        hdr->len = htonl((uint32_t)len);
+        
+        clen+=sizeof(br_cmpr_hdr_t);
+        
+        NDRX_LOG(log_debug, "Frame compressed %ld -> %ld bytes", len, clen);
+        
+        *out = buf;
+        *out_len = clen;
+        buf = NULL;
+    }
+    
+    NDRX_SPIN_LOCK_V(G_bridge_cfg.cmpr_lock);
+    G_bridge_cfg.cmpr_in+=len;
+    G_bridge_cfg.cmpr_out+=clen;
+    G_bridge_cfg.cmpr_usec+=spent;
+    NDRX_SPIN_UNLOCK_V(G_bridge_cfg.cmpr_lock);
+    
+out:
+    
+    if (NULL!=buf)
+    {
+        NDRX_SYSBUF_FREE(buf);
+    }
+
+    return ret;
+}
+
+/**
+ * Decompress incoming frame (if compressed)
+ * @param buf frame received from net, on decompress replaced by new sysbuf
+ * @param len frame len, updated to decompressed len
+ * @return EXSUCCEED/EXFAIL (corrupted frame)
+ */
+expublic int br_dcmpr_frame(char **buf, int *len)
+{
+    int ret = EXSUCCEED;
+    br_cmpr_hdr_t *hdr = (br_cmpr_hdr_t *)*buf;
+    char *out = NULL;
+    size_t out_len;
+    long orig_len;
+    long dlen;
+    long start;
+    
+    if (*len < (int)sizeof(br_cmpr_hdr_t) || 
+            0!=memcmp(hdr->magic, BR_CMPR_MAGIC, BR_CMPR_MAGIC_LEN))
+    {
+        /* not compressed */
+        goto out;
+    }
+    
+    orig_len = (long)ntohl(hdr->len);
+    
+    NDRX_SYSBUF_MALLOC_OUT(out, out_len, ret);
+    
+    start = br_cpu_usec();
+    dlen = ndrx_lz_decompress(*buf+sizeof(br_cmpr_hdr_t), 
+            *len-sizeof(br_cmpr_hdr_t), out, out_len);
+    
+    NDRX_SPIN_LOCK_V(G_bridge_cfg.cmpr_lock);
+    G_bridge_cfg.dcmpr_usec+=br_cpu_usec() - start;
+    NDRX_SPIN_UNLOCK_V(G_bridge_cfg.cmpr_lock);
+    
+    if (dlen!=orig_len)
+    {
+        NDRX_LOG(log_error, "Corrupted compressed frame: %d bytes, "
+                "original len %ld, decompressed %ld", *len, orig_len, dlen);
+        userlog("Corrupted compressed frame: %d bytes, "
+                "original len %ld, decompressed %ld", *len, orig_len, dlen);
+        EXFAIL_OUT(ret);
+    }
+    
+    NDRX_LOG(log_debug, "Frame decompressed %d -> %ld bytes", *len, dlen);
+    
+    NDRX_SYSBUF_FREE(*buf);
+    *buf = out;
+    *len = (int)dlen;
+    out = NULL;
+    
+out:
+    
+    if (NULL!=out)
+    {
+        NDRX_SYSBUF_FREE(out);
+    }
+
+    return ret;
+}
+
+/* vim: set ts=4 sw=4 et smartindent: */
@@ -0,0 +1,344 @@
+/**
+ * @brief Credit based flow control between bridge peers. Receiver announces
+ *   its window in clock sync messages, sender spends one credit per request
+ *   (tpcall/connect) and receiver returns credits as requests are drained to
+ *   local services (or dropped). With no credits left, sender waits for
+ *   a while and then rejects the call locally with TPELIMIT.
+ *
+ * @file credit.c
+ */
+/* -----------------------------------------------------------------------------
+ * Enduro/X Middleware Platform for Distributed Transaction Processing
+ * Copyright (C) 2009-2016, ATR Baltic, Ltd. All Rights Reserved.
+ * Copyright (C) 2017-2019, Mavimax, Ltd. All Rights Reserved.
+ * This software is released under one of the following licenses:
+ * AGPL (with Java and Go exceptions) or Mavimax's license for commercial use.
+ * See LICENSE file for full text.
+ * -----------------------------------------------------------------------------
+ * AGPL license:
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License, version 3 as published
+ * by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License, version 3
+ * for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * -----------------------------------------------------------------------------
+ * A commercial use license is available from Mavimax, Ltd
+ * contact@mavimax.com
+ * -----------------------------------------------------------------------------
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/time.h>
+
+#include <ndebug.h>
+#include <atmi.h>
+#include <atmi_int.h>
+#include <ndrstandard.h>
+#include <gencall.h>
+#include <nstdutil.h>
+
+#include <exnet.h>
+#include <ndrxdcmn.h>
+
+#include "bridge.h"
+/*---------------------------Externs------------------------------------*/
+/*---------------------------Macros-------------------------------------*/
+/*---------------------------Enums--------------------------------------*/
+/*---------------------------Typedefs-----------------------------------*/
+/*---------------------------Globals------------------------------------*/
+/*---------------------------Statics------------------------------------*/
+
+exprivate MUTEX_LOCKDECL(M_cr_lock);    /**< Protects all credit counters       */
+exprivate pthread_cond_t M_cr_cond;     /**< Signaled when credits arrive       */
+
+/* sender side: */
+exprivate int M_peer_window = 0;        /**< Window granted by peer, 0 - off    */
+exprivate int M_avail = 0;              /**< Credits we may spend               */
+exprivate long M_waits = 0;             /**< Calls which waited for credit      */
+exprivate long M_rejects = 0;           /**< Calls rejected, no credit          */
+
+/* receiver side: */
+exprivate int M_outstanding = 0;        /**< Credited calls not yet drained     */
+exprivate int M_pending = 0;            /**< Drained, not yet returned to peer  */
+
+/*---------------------------Prototypes---------------------------------*/
+
+/**
+ * Init the credit condition
+ */
+expublic void br_credit_init(void)
+{
+    pthread_cond_init(&M_cr_cond, NULL);
+}
+
+/**
+ * Connection established or lost. Window is negotiated again by clock
+ * messages, calls in flight on old connection are not counted.
+ */
+expublic void br_credit_reset(void)
+{
+    MUTEX_LOCK_V(M_cr_lock);
+    
+    M_peer_window = 0;
+    M_avail = 0;
+    M_outstanding = 0;
+    M_pending = 0;
+    
+    /* waiters shall re-check the window */
+    pthread_cond_broadcast(&M_cr_cond);
+    MUTEX_UNLOCK_V(M_cr_lock);
+}
+
+/**
+ * Peer announced its window (in every clock message). Only the change
+ * is applied, so that periodic clock sync does not refill the credits.
+ * @param window peer window, 0 - peer does not use flow control
+ */
+expublic void br_credit_peer(int window)
+{
+    MUTEX_LOCK_V(M_cr_lock);
+    
+    if (window < 0)
+    {
+        window = 0;
+    }
+    
+    if (M_peer_window!=window)
+    {
+        NDRX_LOG(log_info, "Peer flow control window changed %d -> %d",
+                M_peer_window, window);
+        
+        M_avail+=window - M_peer_window;
+        M_peer_window=window;
+        pthread_cond_broadcast(&M_cr_cond);
+    }
+    
+    MUTEX_UNLOCK_V(M_cr_lock);
+}
+
+/**
+ * Get credit for the call sending to peer. If peer runs no flow control,
+ * call passes as is. Otherwise waits up to crwait ms for the credit and
+ * marks the call as credited.
+ * @param call call to send to network
+ * @return EXSUCCEED (may send), EXFAIL (no credit, call shall be rejected)
+ */
+expublic int br_credit_acquire(tp_command_call_t *call)
+{
+    int ret = EXSUCCEED;
+    int waited = EXFALSE;
+    struct timespec wait_time;
+    struct timeval now;
+    
+    MUTEX_LOCK_V(M_cr_lock);
+    
+    if (M_peer_window > 0 && M_avail <= 0 && G_bridge_cfg.crwait > 0)
+    {
+        waited = EXTRUE;
+        M_waits++;
+        
+        gettimeofday(&now, NULL);
+        wait_time.tv_sec = now.tv_sec;
+        wait_time.tv_nsec = now.tv_usec*1000;
+        ndrx_timespec_plus(&wait_time, G_bridge_cfg.crwait);
+        
+        while (M_peer_window > 0 && M_avail <= 0)
+        {
+            if (ETIMEDOUT==pthread_cond_timedwait(&M_cr_cond, &M_cr_lock, 
+                    &wait_time))
+            {
+                break;
+            }
+        }
+    }
+    
+    if (0==M_peer_window)
+    {
+        /* no flow control (or disconnected meanwhile) */
+        call->sysflags&=~SYS_FLAG_BRCREDIT;
+    }
+    else if (M_avail > 0)
+    {
+        M_avail--;
+        call->sysflags|=SYS_FLAG_BRCREDIT;
+    }
+    else
+    {
+        M_rejects++;
+        NDRX_LOG(log_error, "No flow control credits for node %d "
+                "(window: %d, waited: %s) - reject call to [%s]",
+                G_bridge_cfg.nodeid, M_peer_window, waited?"yes":"no", 
+                call->name);
+        ret = EXFAIL;
+    }
+    
+    MUTEX_UNLOCK_V(M_cr_lock);
+    
+    return ret;
+}
+
+/**
+ * Call was not sent to peer, give back its credit
+ * @param call call failed to send
+ */
+expublic void br_credit_putback(tp_command_call_t *call)
+{
+    if (!(call->sysflags & SYS_FLAG_BRCREDIT))
+    {
+        return;
+    }
+    
+    call->sysflags&=~SYS_FLAG_BRCREDIT;
+    
+    MUTEX_LOCK_V(M_cr_lock);
+    
+    if (M_peer_window > 0 && M_avail < M_peer_window)
+    {
+        M_avail++;
+        pthread_cond_signal(&M_cr_cond);
+    }
+    
+    MUTEX_UNLOCK_V(M_cr_lock);
+}
+
+/**
+ * Call received from network. Strip the credit mark, call is accounted
+ * until released (delivered or dropped).
+ * @param call call received
+ * @return EXTRUE call holds credit, EXFALSE no credit
+ */
+expublic int br_credit_take(tp_command_call_t *call)
+{
+    if (!(call->sysflags & SYS_FLAG_BRCREDIT))
+    {
+        return EXFALSE;
+    }
+    
+    call->sysflags&=~SYS_FLAG_BRCREDIT;
+    
+    MUTEX_LOCK_V(M_cr_lock);
+    M_outstanding++;
+    MUTEX_UNLOCK_V(M_cr_lock);
+    
+    return EXTRUE;
+}
+
+/**
+ * Credited call is drained (delivered to service or dropped). Credits are
+ * returned to peer in batches of quarter window.
+ */
+expublic void br_credit_release(void)
+{
+    int batch = G_bridge_cfg.crwindow/4;
+    int credits = 0;
+    cmd_br_credit_t grant;
+    
+    if (batch < 1)
+    {
+        batch = 1;
+    }
+    
+    MUTEX_LOCK_V(M_cr_lock);
+    
+    /* call from previous connection, not owed to peer any more */
+    if (M_outstanding > 0)
+    {
+        M_outstanding--;
+        M_pending++;
+        
+        if (M_pending >= batch)
+        {
+            credits = M_pending;
+            M_pending = 0;
+        }
+    }
+    
+    MUTEX_UNLOCK_V(M_cr_lock);
+    
+    if (credits > 0)
+    {
+        memset(&grant, 0, sizeof(grant));
+        cmd_generic_init(NDRXD_COM_BRCREDIT_RQ, NDRXD_SRC_BRIDGE, 
+                NDRXD_CALL_TYPE_BRCREDIT, (command_call_t *)&grant, 
+                ndrx_get_G_atmi_conf()->reply_q_str);
+        grant.credits = credits;
+        
+        NDRX_LOG(log_debug, "Returning %d credits to node %d", credits, 
+                G_bridge_cfg.nodeid);
+        
+        if (EXSUCCEED!=br_send_to_net((char *)&grant, sizeof(grant), 
+                BR_NET_CALL_MSG_TYPE_NDRXD, grant.call.command))
+        {
+            /* link is broken, window is renegotiated at reconnect */
+            NDRX_LOG(log_error, "Failed to return %d credits to node %d", 
+                    credits, G_bridge_cfg.nodeid);
+        }
+    }
+}
+
+/**
+ * Peer returned credits
+ * @param call cmd_br_credit_t message
+ * @param len message len
+ * @return EXSUCCEED/EXFAIL
+ */
+expublic int br_credit_grant(command_call_t *call, int len)
+{
+    int ret = EXSUCCEED;
+    cmd_br_credit_t *grant = (cmd_br_credit_t *)call;
+    
+    if (len < sizeof(cmd_br_credit_t) || grant->credits < 0)
+    {
+        NDRX_LOG(log_error, "Invalid credit message len=%d", len);
+        EXFAIL_OUT(ret);
+    }
+    
+    MUTEX_LOCK_V(M_cr_lock);
+    
+    if (M_peer_window > 0)
+    {
+        M_avail+=grant->credits;
+        
+        /* not more than window */
+        if (M_avail > M_peer_window)
+        {
+            M_avail = M_peer_window;
+        }
+        pthread_cond_broadcast(&M_cr_cond);
+    }
+    
+    MUTEX_UNLOCK_V(M_cr_lock);
+    
+out:
+    return ret;
+}
+
+/**
+ * Fill connection infos with flow control stats
+ * @param infos infos to fill
+ */
+expublic void br_credit_info(command_reply_brconinfo_t *infos)
+{
+    MUTEX_LOCK_V(M_cr_lock);
+    
+    infos->crwindow = G_bridge_cfg.crwindow;
+    infos->crpeer = M_peer_window;
+    infos->cravail = M_avail;
+    infos->crwaits = M_waits;
+    infos->crrejects = M_rejects;
+    
+    MUTEX_UNLOCK_V(M_cr_lock);
+}
+
+/* vim: set ts=4 sw=4 et smartindent: */
@@ -199,6 +199,12 @@ exprivate int br_process_msg_th(void *ptr, int *p_finish_off)
     char *tmp_clr=NULL;
     net_brmessage_t *p_netmsg = (net_brmessage_t *)ptr;
     
+    /* compressed frames are expanded first */
+    if (EXSUCCEED!=br_dcmpr_frame(&p_netmsg->buf, &p_netmsg->len))
+    {
+        EXFAIL_OUT(ret);
+    }
+    
     p_netmsg->call = (cmd_br_net_call_t *)p_netmsg->buf;
     
     
@@ -265,6 +271,8 @@ exprivate int br_process_msg_th(void *ptr, int *p_finish_off)
             case ATMI_COMMAND_CONNECT:
                 NDRX_LOG(log_debug, "tpcall or connect");
                 br_dump_tp_command_call(p_netmsg->call->buf);
+                ndrx_calltrace_msghop((tp_command_call_t *)gen_command, 
+                        &p_netmsg->call->len, NDRX_TRACE_HOP_BRIN);
                 /* If this is a call, then we should append caller address */
                 if (EXSUCCEED!=br_tpcall_pushstack((tp_command_call_t *)gen_command))
                 {
@@ -285,6 +293,8 @@ exprivate int br_process_msg_th(void *ptr, int *p_finish_off)
             case ATMI_COMMAND_CONVACK:
             case ATMI_COMMAND_SHUTDOWN:
                 br_dump_tp_command_call(p_netmsg->call->buf);
+                ndrx_calltrace_msghop((tp_command_call_t *)gen_command, 
+                        &p_netmsg->call->len, NDRX_TRACE_HOP_BRIN);
                 /* TODO: So this is reply... we should pop the stack and decide 
                  * where to send the message, either to service replyQ
                  * or other node 
@@ -332,11 +342,14 @@ exprivate int br_process_msg_th(void *ptr, int *p_finish_off)
         switch (icall->command)
         {
             case NDRXD_COM_BRCLOCK_RQ:
-                ret = br_calc_clock_diff(icall);
+                ret = br_calc_clock_diff(icall, call_len);
                 break;
             case NDRXD_COM_BRREFERSH_RQ:
                 ret = br_submit_to_ndrxd(icall, call_len);
                 break;
+            case NDRXD_COM_BRCREDIT_RQ:
+                ret = br_credit_grant(icall, call_len);
+                break;
             default:
                 NDRX_LOG(log_debug, "Unsupported bridge command: %d",
                             icall->command);
@@ -371,8 +384,8 @@ expublic int br_send_to_net(char *buf, int len, char msg_type, int command_id)
     size_t tmp_len;
     char *tmp2 = NULL;
     size_t tmp2_len;
-    char *tmp_enc = NULL; /* Not the best way, but we atleas we are clear... */
-    int tmp_enc_len;
+    char *tmp_cmpr = NULL;
+    long tmp_cmpr_len;
     char **snd;
     long snd_len;
     int use_hdr = EXFALSE;
@@ -409,7 +422,9 @@ expublic int br_send_to_net(char *buf, int len, char msg_type, int command_id)
         EXFAIL_OUT(ret);
     }
     
-    if (G_bridge_cfg.common_format)
+    if (G_bridge_cfg.common_format || 
+            (G_bridge_cfg.cmprthres > 0 && G_bridge_cfg.peer_cmpr &&
+            len+sizeof(cmd_br_net_call_t) >= G_bridge_cfg.cmprthres))
     {
         /* get away from this memcpy somehow? */
         memcpy(call->buf, buf, len);
@@ -445,6 +460,21 @@ expublic int br_send_to_net(char *buf, int len, char msg_type, int command_id)
         tmp = NULL;
     }
     
+    /* compress whole frame, if link has it */
+    if (!use_hdr)
+    {
+        if (EXSUCCEED!=br_cmpr_frame(*snd, snd_len, &tmp_cmpr, &tmp_cmpr_len))
+        {
+            EXFAIL_OUT(ret);
+        }
+        
+        if (NULL!=tmp_cmpr)
+        {
+            snd = &tmp_cmpr;
+            snd_len = tmp_cmpr_len;
+        }
+    }
+    
     /* Might want to move this stuff to Q */
     
     /* the connection object is created by main thread
@@ -510,9 +540,9 @@ out:
         NDRX_SYSBUF_FREE(tmp2);
     }
 
-    if (NULL!=tmp_enc)
+    if (NULL!=tmp_cmpr)
     {
-        NDRX_SYSBUF_FREE(tmp_enc);
+        NDRX_SYSBUF_FREE(tmp_cmpr);
     }
 
     return ret;
@@ -99,6 +99,7 @@ expublic int br_submit_to_service(tp_command_call_t *call, int len)
     int ret=EXSUCCEED;
     char svc_q[NDRX_MAX_Q_SIZE+1];
     int is_bridge = EXFALSE;
+    int credit = br_credit_take(call);
 
     /* Resolve the service in SHM 
      *   sprintf(svc_q, NDRX_SVC_QFMT, G_server_conf.q_prefix, call->name); */
@@ -117,11 +118,25 @@ expublic int br_submit_to_service(tp_command_call_t *call, int len)
     if (EXSUCCEED!=(ret=ndrx_generic_q_send(svc_q, (char *)call, len, TPNOBLOCK, 0)))
     {
         NDRX_LOG(log_error, "Failed to send message to local ATMI service!");
+        
+        /* parked in temp queue, credit is released by queue runner */
+        if (credit && (EAGAIN==ret || EINTR==ret))
+        {
+            call->sysflags|=SYS_FLAG_BRCREDIT;
+            credit = EXFALSE;
+        }
+        
         br_process_error((char *)call, len, ret, NULL, PACK_TYPE_TOSVC, svc_q, NULL);
     }
     /* TODO: Check the result, if called failed, then reply back with error? */
     
 out:
+    
+    if (credit)
+    {
+        br_credit_release();
+    }
+    
     return EXSUCCEED;    
 }
 
@@ -275,7 +290,7 @@ exprivate int br_got_message_from_q_th(void *ptr, int *p_finish_off)
     /* Get threaded data */
     xatmi_brmessage_t *p_xatmimsg = (xatmi_brmessage_t *)ptr;
     char *buf = p_xatmimsg->buf;
-    int len = p_xatmimsg->len;
+    long len = p_xatmimsg->len;
     char msg_type = p_xatmimsg->msg_type;
     
     BR_THREAD_ENTRY;
@@ -295,8 +310,23 @@ exprivate int br_got_message_from_q_th(void *ptr, int *p_finish_off)
             case ATMI_COMMAND_CONNECT:
                 
                 NDRX_LOG(log_debug, "TPCALL/CONNECT from Q");
+                
+                /* flow control, hold back or reject if peer is overloaded */
+                if (EXSUCCEED!=br_credit_acquire((tp_command_call_t *)buf))
+                {
+                    tp_command_call_t *call = (tp_command_call_t *)buf;
+                    
+                    if (!(call->flags & TPNOREPLY))
+                    {
+                        reply_with_failure(TPNOBLOCK, call, NULL, NULL, TPELIMIT);
+                    }
+                    break;
+                }
+                
                 /* Adjust the clock */
-                br_clock_adj((tp_command_call_t *)buf, EXTRUE);
+                ndrx_calltrace_msghop((tp_command_call_t *)buf, &len, 
+                        NDRX_TRACE_HOP_BROUT);
+                br_clock_adj((tp_command_call_t *)buf, len, EXTRUE);
                 /* Send stuff to network, adjust clock.*/
                 ret=br_send_to_net(buf, len, BR_NET_CALL_MSG_TYPE_ATMI, 
                         gen_command->command_id);
@@ -304,6 +334,7 @@ exprivate int br_got_message_from_q_th(void *ptr, int *p_finish_off)
                 if (EXSUCCEED!=ret)
                 {
                     /* Generate TPNOENT */
+                    br_credit_putback((tp_command_call_t *)buf);
                 }
                 
                 break;
@@ -320,7 +351,9 @@ exprivate int br_got_message_from_q_th(void *ptr, int *p_finish_off)
                 NDRX_LOG(log_debug, "TPREPLY/CONVERSATION from Q");
                 
                 /* Adjust the clock */
-                br_clock_adj((tp_command_call_t *)buf, EXTRUE);
+                ndrx_calltrace_msghop((tp_command_call_t *)buf, &len, 
+                        NDRX_TRACE_HOP_BROUT);
+                br_clock_adj((tp_command_call_t *)buf, len, EXTRUE);
                 
                 ret=br_send_to_net(buf, len, BR_NET_CALL_MSG_TYPE_ATMI, 
                         gen_command->command_id);
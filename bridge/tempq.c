@@ -61,8 +61,10 @@
 /**
  * Remove message from hash queue
  * and delete queue hash if there arn't any msgs in
+ * Flow control credit held by message is returned to peer.
  */
 #define RM_MSG(QHASH)  do {\
+                    int rm_credit = el->credit;\
                     /* locking here needed.. */\
                     MUTEX_LOCK_V(M_in_q_lock);\
                     /* remove from Q - ok */\
@@ -73,6 +75,7 @@
                     QHASH->nrmsg--;\
                     if (0==QHASH->nrmsg) {EXHASH_DEL(M_qstr_hash, QHASH); NDRX_FPFREE(QHASH);}\
                     MUTEX_UNLOCK_V(M_in_q_lock);\
+                    if (rm_credit) {br_credit_release();}\
                 } while (0);
                 
 #define DISCARD_CALL_LOG    do {NDRX_LOG(log_error, \
@@ -570,6 +573,13 @@ expublic int br_add_to_q(char *buf, int len, int pack_type, char *destq)
     in_msg_t *msg;
     in_msg_hash_t *qhash;
     int dropmsg = EXFALSE;
+    int credit = EXFALSE;
+    
+    if (PACK_TYPE_TOSVC==pack_type)
+    {
+        credit = !!(((tp_command_call_t *)buf)->sysflags & SYS_FLAG_BRCREDIT);
+    }
+    
     if (NULL==(msg=NDRX_FPMALLOC(sizeof(in_msg_t), 0)))
     {
         NDRX_ERR_MALLOC(sizeof(in_msg_t));
@@ -591,6 +601,13 @@ expublic int br_add_to_q(char *buf, int len, int pack_type, char *destq)
     NDRX_STRCPY_SAFE(msg->destqstr, destq);
     memcpy(msg->buffer, buf, len);
     
+    /* credit is held by queue entry, not passed to service */
+    msg->credit = credit;
+    if (credit)
+    {
+        ((tp_command_call_t *)msg->buffer)->sysflags&=~SYS_FLAG_BRCREDIT;
+    }
+    
     ndrx_stopwatch_reset(&msg->addedtime);
     ndrx_stopwatch_reset(&msg->updatetime);
     
@@ -647,6 +664,11 @@ expublic int br_add_to_q(char *buf, int len, int pack_type, char *destq)
                                 msg, pack_type, destq, NULL);
         NDRX_FPFREE(msg->buffer);
         NDRX_FPFREE(msg);
+        
+        if (credit)
+        {
+            br_credit_release();
+        }
     }
     else
     {
@@ -660,6 +682,11 @@ out:
     /* if not checking for ret, the queue sender may be already processed the msg... */
     if (EXSUCCEED!=ret)
     {
+        if (credit)
+        {
+            br_credit_release();
+        }
+        
         if (NULL!=msg->buffer)
         {
             NDRX_FPFREE(msg->buffer);
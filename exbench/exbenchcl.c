@@ -36,6 +36,9 @@
 #include <string.h>
 #include <errno.h>
 #include <signal.h>
+#include <math.h>
+#include <time.h>
+#include <sys/mman.h>
 
 #include <ndebug.h>
 #include <atmi.h>
@@ -44,6 +47,7 @@
 #include "atmi_int.h"
 #include "expr.h"
 #include <typed_buf.h>
+#include "exbenchhist.h"
 
 /*---------------------------Externs------------------------------------*/
 /*---------------------------Macros-------------------------------------*/
@@ -59,6 +63,11 @@
  */
 #define NDRX_WRITE 1
 
+/**
+ * Open loop: max sleep while waiting for replies / next send slot
+ */
+#define OPEN_LOOP_POLL_US   100
+
 /*---------------------------Enums--------------------------------------*/
 /*---------------------------Typedefs-----------------------------------*/
 /*---------------------------Globals------------------------------------*/
@@ -88,12 +97,158 @@ exprivate char M_qspace[XATMI_SERVICE_NAME_LENGTH+1] = {EXEOS};
 exprivate int M_autoq = EXFALSE;   /**< Use autoq testing                   */
 exprivate int M_enqonly = EXFALSE;   /**< Persisten q, enqueue only         */
 exprivate long M_numreq = EXFALSE;   /**< Number of requests                */
+exprivate double M_rate = 0;        /**< Open loop target calls/sec, 0 - closed */
+exprivate int M_poisson = EXFALSE;  /**< Open loop, Poisson arrivals        */
+exprivate int M_cocorrect = EXFALSE;/**< Measure from scheduled send time   */
+exprivate char *M_latfile = NULL;   /**< Latency percentiles output file    */
+exprivate exbench_hist_t M_hist;    /**< Merged latency histogram           */
+exprivate exbench_hist_t *M_proc_hist = NULL; /**< Fork mode, shared histograms */
 /* Lock  */
 /*---------------------------Prototypes---------------------------------*/
 
 
 /* need to synchronize function for starting the sending... */
 
+/**
+ * Monotonic time
+ * @return microseconds
+ */
+exprivate uint64_t now_us(void)
+{
+    struct timespec t;
+    
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    
+    return (uint64_t)t.tv_sec*1000000 + t.tv_nsec/1000;
+}
+
+/**
+ * Is benchmark still running
+ * @param w thread/process start time
+ * @param sent requests sent so far
+ * @return EXTRUE/EXFALSE
+ */
+exprivate int is_running(ndrx_stopwatch_t *w, long sent)
+{
+    if (M_numreq && sent >= M_numreq)
+    {
+        return EXFALSE;
+    }
+    
+    return (!M_fork && M_do_run) || 
+            (M_fork && ndrx_stopwatch_get_delta_sec(w) < M_runtime);
+}
+
+/**
+ * Open loop load: requests are issued with tpacall() at the target rate
+ * regardless of the replies. If we are behind schedule, requests are sent
+ * immediately, thus with coordinated omission correction the latency is
+ * measured from the time when the request was scheduled, not sent.
+ * @param thnum thread number
+ * @param svcnm service to call
+ * @param buf buffer to send
+ * @param w start time
+ * @param hist latency histogram
+ * @return number of requests sent
+ */
+exprivate long open_loop(long thnum, char *svcnm, char *buf, 
+        ndrx_stopwatch_t *w, exbench_hist_t *hist)
+{
+    double interval = 1000000.0 * M_nr_threads / M_rate;
+    uint64_t *sendtime = NDRX_CALLOC(MAX_ASYNC_CALLS, sizeof(uint64_t));
+    uint64_t now;
+    double next;
+    unsigned int seed;
+    long sent = 0;
+    long inflight = 0;
+    long waitus;
+    int cd;
+    char *rcv_buf;
+    long rcvlen;
+    
+    if (NULL==sendtime)
+    {
+        NDRX_LOG(log_error, "Failed to alloc send time table: %s", 
+                strerror(errno));
+        exit(-1);
+    }
+    
+    now = now_us();
+    next = (double)now;
+    seed = (unsigned int)(now ^ thnum);
+    
+    while (is_running(w, sent) || inflight > 0)
+    {
+        now = now_us();
+        
+        if (is_running(w, sent) && (double)now >= next && 
+                inflight < MAX_ASYNC_CALLS-1)
+        {
+            if (EXFAIL==(cd=tpacall(svcnm, buf, 0, 0)))
+            {
+                NDRX_LOG(log_error, "Failed to acall [%s]: %s", 
+                        svcnm, tpstrerror(tperrno));
+                exit(-1);
+            }
+            
+            sendtime[cd] = M_cocorrect ? (uint64_t)next : now_us();
+            inflight++;
+            sent++;
+            
+            if (M_poisson)
+            {
+                next += -log(1.0 - (double)rand_r(&seed) / 
+                        ((double)RAND_MAX + 1.0)) * interval;
+            }
+            else
+            {
+                next += interval;
+            }
+            continue;
+        }
+        
+        /* collect the replies, block only at the end of the run */
+        rcv_buf = NULL;
+        if (EXFAIL==tpgetrply(&cd, &rcv_buf, &rcvlen, 
+                TPGETANY | (is_running(w, sent) ? TPNOBLOCK : 0)))
+        {
+            if (TPEBLOCK!=tperrno)
+            {
+                NDRX_LOG(log_error, "Failed to get reply from [%s]: %s", 
+                        svcnm, tpstrerror(tperrno));
+                exit(-1);
+            }
+            
+            /* nothing to receive, wait for next slot */
+            waitus = (long)(next - (double)now_us());
+            
+            if (waitus > OPEN_LOOP_POLL_US || inflight >= MAX_ASYNC_CALLS-1)
+            {
+                waitus = OPEN_LOOP_POLL_US;
+            }
+            
+            if (waitus > 0)
+            {
+                usleep(waitus);
+            }
+        }
+        else
+        {
+            exbench_hist_record(hist, now_us() - sendtime[cd]);
+            inflight--;
+            
+            if (NULL!=rcv_buf)
+            {
+                tpfree(rcv_buf);
+            }
+        }
+    }
+    
+    NDRX_FREE(sendtime);
+    
+    return sent;
+}
+
 
 expublic void thread_process(void *ptr, int *p_finish_off)
 {
@@ -106,8 +261,10 @@ expublic void thread_process(void *ptr, int *p_finish_off)
     long sent=0;
     TPQCTL qc;
     ndrx_stopwatch_t w;
+    exbench_hist_t *hist = NDRX_MALLOC(sizeof(exbench_hist_t));
+    uint64_t t0;
     
-    if (NULL==buf)
+    if (NULL==buf || NULL==hist)
     {
         NDRX_LOG(log_error, "Failed to alloc send buf: %s", 
                 tpstrerror(tperrno));
@@ -134,9 +291,17 @@ expublic void thread_process(void *ptr, int *p_finish_off)
     MUTEX_UNLOCK_V(M_wait_mutex);
 
     ndrx_stopwatch_reset(&w);
+    exbench_hist_init(hist);
+    
+    if (M_rate > 0)
+    {
+        sent = open_loop(thnum, svcnm, buf, &w, hist);
+    }
     
-    while ((!M_fork && M_do_run) || (M_fork && ndrx_stopwatch_get_delta_sec(&w) < M_runtime))
+    while (M_rate <= 0 && is_running(&w, sent))
     {
+        t0 = now_us();
+        
         if (M_prio!=NDRX_MSGPRIO_DEFAULT)
         {
             tpsprio(M_prio, TPABSOLUTE);
@@ -183,17 +348,23 @@ expublic void thread_process(void *ptr, int *p_finish_off)
             tpfree(rcv_buf);
         }
         
+        exbench_hist_record(hist, now_us() - t0);
         sent++;
-        /* enqueue number of messages only... */
-        if (M_numreq && sent >= M_numreq)
-        {
-            break;
-        }
     }
     
     /* publish results... */
     MUTEX_LOCK_V(M_wait_mutex);
     M_msg_sent+=sent;
+    
+    if (M_fork)
+    {
+        /* parent merges from shared memory */
+        memcpy(&M_proc_hist[thnum], hist, sizeof(*hist));
+    }
+    else
+    {
+        exbench_hist_merge(&M_hist, hist);
+    }
     MUTEX_UNLOCK_V(M_wait_mutex);
 
     /* Wait on queue to finish ... 
@@ -245,6 +416,11 @@ out:
         tpfree(buf);
     }
 
+    if (NULL!=hist)
+    {
+        NDRX_FREE(hist);
+    }
+
     /* release resources */
     tpterm();
 
@@ -252,6 +428,57 @@ out:
     
 }
 
+/**
+ * Append latency percentiles to the -L file, or next to the plot data
+ * @return EXSUCCEED/EXFAIL
+ */
+exprivate int write_latency(void)
+{
+    int ret = EXSUCCEED;
+    char fname[PATH_MAX+1];
+    char *config_name = getenv("NDRX_BENCH_CONFIGNAME");
+    char *bench_file = getenv("NDRX_BENCH_FILE");
+    int format = EXBENCH_HIST_CSV;
+    int header;
+    size_t len;
+    FILE *f = NULL;
+    
+    if (NULL!=M_latfile)
+    {
+        NDRX_STRCPY_SAFE(fname, M_latfile);
+    }
+    else
+    {
+        snprintf(fname, sizeof(fname), "%s.lat.csv", 
+                NULL!=bench_file?bench_file:"test.out");
+    }
+    
+    len = strlen(fname);
+    if (len > 5 && 0==strcmp(fname+len-5, ".json"))
+    {
+        format = EXBENCH_HIST_JSON;
+    }
+    
+    header = (EXSUCCEED!=access(fname, F_OK));
+    
+    if (NULL==(f=NDRX_FOPEN(fname, "a")))
+    {
+        NDRX_LOG(log_error, "Failed to open [%s]: %s", fname, strerror(errno));
+        EXFAIL_OUT(ret);
+    }
+    
+    ret = exbench_hist_write(&M_hist, f, format, 
+            NULL!=config_name?config_name:"test", M_msgsize, M_rate, header);
+    
+out:
+    if (NULL!=f)
+    {
+        NDRX_FCLOSE(f);
+    }
+
+    return ret;
+}
+
 /**
  * Print usage
  * @param bin binary name
@@ -274,6 +501,11 @@ expublic void usage(char *bin)
     fprintf(stderr, "  -A               Auto queue testing (forwarding)\n");
     fprintf(stderr, "  -E               Persist only\n");
     fprintf(stderr, "  -R <msgnum>      Number of requests (time or nr first to stop)\n");
+    fprintf(stderr, "  -r <rate>        Open loop mode (tpacall), target calls/sec of all threads\n");
+    fprintf(stderr, "  -d <dist>        Open loop arrivals: fixed (default) or poisson\n");
+    fprintf(stderr, "  -C               Coordinated omission correction: latency from scheduled send time\n");
+    fprintf(stderr, "  -L <file>        Append latency percentiles to file (JSON if ends with .json, else CSV).\n");
+    fprintf(stderr, "                   With -P defaults to ${NDRX_BENCH_FILE}.lat.csv\n");
    
 }
 
@@ -309,7 +541,7 @@ expublic int main( int argc, char** argv )
      */
     M_buftype = ndrx_get_buffer_descr("UBF", NULL);
 
-    while ((c = getopt (argc, argv, "n:s:t:b:S:p:Pf:FN:Q:AER:")) != -1)
+    while ((c = getopt (argc, argv, "n:s:t:b:S:p:Pf:FN:Q:AER:r:d:CL:")) != -1)
     {
         switch (c)
         {
@@ -319,6 +551,27 @@ expublic int main( int argc, char** argv )
             case 'R':
                 M_numreq = atol(optarg);
                 break;
+            case 'r':
+                M_rate = atof(optarg);
+                break;
+            case 'd':
+                if (0==strcmp(optarg, "poisson"))
+                {
+                    M_poisson = EXTRUE;
+                }
+                else if (0!=strcmp(optarg, "fixed"))
+                {
+                    NDRX_LOG(log_error, "Invalid distribution [%s]", optarg);
+                    usage(argv[0]);
+                    EXFAIL_OUT(ret);
+                }
+                break;
+            case 'C':
+                M_cocorrect = EXTRUE;
+                break;
+            case 'L':
+                M_latfile = optarg;
+                break;
             case 'E':
                 M_enqonly = EXTRUE;
                 break;
@@ -400,6 +653,27 @@ expublic int main( int argc, char** argv )
     NDRX_LOG(log_info, "M_autoq=[%d]", M_autoq);
     NDRX_LOG(log_info, "M_enqonly=[%d]", M_autoq);
     NDRX_LOG(log_info, "M_numreq=[%ld]", M_numreq);
+    NDRX_LOG(log_info, "M_rate=[%lf]", M_rate);
+    NDRX_LOG(log_info, "M_poisson=[%d]", M_poisson);
+    NDRX_LOG(log_info, "M_cocorrect=[%d]", M_cocorrect);
+    NDRX_LOG(log_info, "M_latfile=[%s]", M_latfile?M_latfile:"NULL");
+    
+    if (M_rate > 0 && M_qspace[0])
+    {
+        NDRX_LOG(log_error, "Open loop mode (-r) is not supported for queues (-Q)");
+        usage(argv[0]);
+        EXFAIL_OUT(ret);
+    }
+    
+    if (M_cocorrect && M_rate <= 0)
+    {
+        NDRX_LOG(log_error, "Coordinated omission correction (-C) "
+                "requires open loop mode (-r)");
+        usage(argv[0]);
+        EXFAIL_OUT(ret);
+    }
+    
+    exbench_hist_init(&M_hist);
     
     /* allocate the buffer & fill with random data */
     
@@ -473,6 +747,19 @@ expublic int main( int argc, char** argv )
         signal(SIGCHLD, SIG_IGN); /* ignore childs, we will wait on pipe */
         
         NDRX_LOG(log_debug, "Fork mode");
+        
+        /* histograms are too large for atomic pipe writes, thus
+         * each process gets its own slot in shared memory
+         */
+        M_proc_hist = mmap(NULL, sizeof(exbench_hist_t)*M_nr_threads, 
+                PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        
+        if (MAP_FAILED==M_proc_hist)
+        {
+            NDRX_LOG(log_error, "Failed to mmap histograms: %s", strerror(errno));
+            M_proc_hist = NULL;
+            EXFAIL_OUT(ret);
+        }
 
         if (EXSUCCEED!=pipe ( M_fd ))
         {
@@ -535,6 +822,11 @@ expublic int main( int argc, char** argv )
             /* update totals */
             tps+=tpsproc;
         }
+        
+        for (i=0; i<M_nr_threads; i++)
+        {
+            exbench_hist_merge(&M_hist, &M_proc_hist[i]);
+        }
     }
     else
     {
@@ -597,6 +889,22 @@ expublic int main( int argc, char** argv )
         ndrx_bench_write_stats(M_msgsize, tps);
     }
     
+    NDRX_LOG(log_info, "Latency us: count=%llu p50=%llu p90=%llu p99=%llu "
+            "p999=%llu max=%llu", (unsigned long long)M_hist.count,
+            (unsigned long long)exbench_hist_percentile(&M_hist, 50),
+            (unsigned long long)exbench_hist_percentile(&M_hist, 90),
+            (unsigned long long)exbench_hist_percentile(&M_hist, 99),
+            (unsigned long long)exbench_hist_percentile(&M_hist, 99.9),
+            (unsigned long long)M_hist.max);
+    
+    if (NULL!=M_latfile || M_doplot)
+    {
+        if (EXSUCCEED!=write_latency())
+        {
+            EXFAIL_OUT(ret);
+        }
+    }
+    
 out:
     if (EXFAIL!=M_fd[NDRX_READ])
     {
@@ -623,6 +931,11 @@ out:
         NDRX_FREE(rnd_block);
     }
 
+    if (NULL!=M_proc_hist && parent)
+    {
+        munmap(M_proc_hist, sizeof(exbench_hist_t)*M_nr_threads);
+    }
+
     return ret;
     
 }
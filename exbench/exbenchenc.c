@@ -0,0 +1,236 @@
+/**
+ * @brief Encryption throughput benchmark. Compares AES-128 CBC (EXAES)
+ *   with AES-128 GCM, portable and AES-NI/PCLMUL versions, on 1KB..1MB
+ *   payloads.
+ *
+ * @file exbenchenc.c
+ */
+/* -----------------------------------------------------------------------------
+ * Enduro/X Middleware Platform for Distributed Transaction Processing
+ * Copyright (C) 2009-2016, ATR Baltic, Ltd. All Rights Reserved.
+ * Copyright (C) 2017-2019, Mavimax, Ltd. All Rights Reserved.
+ * This software is released under one of the following licenses:
+ * AGPL (with Java and Go exceptions) or Mavimax's license for commercial use.
+ * See LICENSE file for full text.
+ * -----------------------------------------------------------------------------
+ * AGPL license:
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License, version 3 as published
+ * by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License, version 3
+ * for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * -----------------------------------------------------------------------------
+ * A commercial use license is available from Mavimax, Ltd
+ * contact@mavimax.com
+ * -----------------------------------------------------------------------------
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <ndrstandard.h>
+#include <ndebug.h>
+#include <nstdutil.h>
+#include <nstopwatch.h>
+#include <exaes.h>
+#include <exaesgcm.h>
+/*---------------------------Externs------------------------------------*/
+/*---------------------------Macros-------------------------------------*/
+#define BENCH_MAXSZ     (1024*1024)     /**< largest payload            */
+
+#define BENCH_CBC       0x0001          /**< EXAES CBC                  */
+#define BENCH_GCMSW     0x0002          /**< GCM, portable              */
+#define BENCH_GCMHW     0x0004          /**< GCM, AES-NI/PCLMUL         */
+/*---------------------------Enums--------------------------------------*/
+/*---------------------------Typedefs-----------------------------------*/
+/*---------------------------Globals------------------------------------*/
+/*---------------------------Statics------------------------------------*/
+exprivate int M_runtime=2;              /**< seconds per measurement     */
+exprivate int M_doplot=EXFALSE;         /**< write stats for plotting    */
+exprivate long M_modes = BENCH_CBC | BENCH_GCMSW | BENCH_GCMHW;
+/*---------------------------Prototypes---------------------------------*/
+
+/**
+ * Print usage
+ * @param bin binary name
+ */
+expublic void usage(char *bin)
+{
+    fprintf(stderr, "Usage: %s [options]\n", bin);
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  -t <time>        Number of seconds per payload size, default 2\n");
+    fprintf(stderr, "  -m <mode>        Run only: cbc, gcmsw or gcmhw\n");
+    fprintf(stderr, "  -P               Plot results (MB/s per size). Needs NDRX_BENCH_FILE and NDRX_BENCH_CONFIGNAME\n");
+}
+
+/**
+ * Run single measurement
+ * @param mode BENCH_* mode
+ * @param ctx GCM context (for GCM modes)
+ * @param key CBC key
+ * @param in input data
+ * @param out output data
+ * @param size payload size
+ * @return MB/s
+ */
+exprivate double bench_run(int mode, ndrx_aesgcm_ctx_t *ctx, uint8_t *key, 
+        uint8_t *in, uint8_t *out, long size)
+{
+    uint8_t iv[NDRX_AESGCM_IVLEN] = {0};
+    uint8_t tag[NDRX_AESGCM_TAGLEN];
+    ndrx_stopwatch_t w;
+    long bytes = 0;
+    long ms;
+    int i;
+    
+    ndrx_stopwatch_reset(&w);
+    
+    while ((ms=ndrx_stopwatch_get_delta(&w)) < M_runtime*1000)
+    {
+        /* check the time once per few calls, as small payloads are fast */
+        for (i=0; i<16; i++)
+        {
+            if (BENCH_CBC==mode)
+            {
+                EXAES_CBC_encrypt_buffer(out, in, size, key, iv);
+            }
+            else
+            {
+                iv[NDRX_AESGCM_IVLEN-1]++;
+                ndrx_aesgcm_encrypt(ctx, iv, NULL, 0, in, size, out, tag);
+            }
+            bytes+=size;
+        }
+    }
+    
+    return ((double)bytes / (1024.0*1024.0)) / ((double)ms / 1000.0);
+}
+
+/**
+ * Benchmark entry
+ */
+expublic int main( int argc, char** argv )
+{
+    int ret = EXSUCCEED;
+    int c;
+    int i, j;
+    long sizes[] = {1024, 4096, 16384, 65536, 262144, BENCH_MAXSZ};
+    int modes[] = {BENCH_CBC, BENCH_GCMSW, BENCH_GCMHW};
+    char *names[] = {"CBC", "GCM (portable)", "GCM (AES-NI)"};
+    uint8_t key[NDRX_AESGCM_KEYLEN] = {0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 
+        0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c};
+    uint8_t *in = NULL;
+    uint8_t *out = NULL;
+    ndrx_aesgcm_ctx_t ctx_sw;
+    ndrx_aesgcm_ctx_t ctx_hw;
+    double mbs;
+    
+    while ((c = getopt (argc, argv, "t:m:P")) != -1)
+    {
+        switch (c)
+        {
+            case 't':
+                M_runtime = atoi(optarg);
+                break;
+            case 'm':
+                if (0==strcmp(optarg, "cbc"))
+                {
+                    M_modes = BENCH_CBC;
+                }
+                else if (0==strcmp(optarg, "gcmsw"))
+                {
+                    M_modes = BENCH_GCMSW;
+                }
+                else if (0==strcmp(optarg, "gcmhw"))
+                {
+                    M_modes = BENCH_GCMHW;
+                }
+                else
+                {
+                    usage(argv[0]);
+                    EXFAIL_OUT(ret);
+                }
+                break;
+            case 'P':
+                M_doplot = EXTRUE;
+                break;
+            default:
+                usage(argv[0]);
+                EXFAIL_OUT(ret);
+        }
+    }
+    
+    if (!ndrx_aesgcm_hw_supported() && (M_modes & BENCH_GCMHW))
+    {
+        fprintf(stderr, "AES-NI/PCLMULQDQ not supported by CPU - "
+                "skipping hardware GCM\n");
+        M_modes &= ~BENCH_GCMHW;
+    }
+    
+    in = NDRX_MALLOC(BENCH_MAXSZ);
+    out = NDRX_MALLOC(BENCH_MAXSZ);
+    
+    if (NULL==in || NULL==out)
+    {
+        fprintf(stderr, "Failed to malloc %d bytes\n", BENCH_MAXSZ);
+        EXFAIL_OUT(ret);
+    }
+    
+    for (i=0; i<BENCH_MAXSZ; i++)
+    {
+        in[i] = (uint8_t)rand();
+    }
+    
+    ndrx_aesgcm_init(&ctx_sw, key, NDRX_AESGCM_NOHW);
+    ndrx_aesgcm_init(&ctx_hw, key, 0);
+    
+    printf("%-16s %10s %12s\n", "Mode", "Size", "MB/s");
+    
+    for (j=0; j<N_DIM(modes); j++)
+    {
+        if (!(M_modes & modes[j]))
+        {
+            continue;
+        }
+        
+        for (i=0; i<N_DIM(sizes); i++)
+        {
+            mbs = bench_run(modes[j], BENCH_GCMHW==modes[j]?&ctx_hw:&ctx_sw, 
+                    key, in, out, sizes[i]);
+            
+            printf("%-16s %10ld %12.1lf\n", names[j], sizes[i], mbs);
+            fflush(stdout);
+            
+            if (M_doplot && EXSUCCEED!=ndrx_bench_write_stats((double)sizes[i], mbs))
+            {
+                EXFAIL_OUT(ret);
+            }
+        }
+    }
+    
+out:
+    
+    if (NULL!=in)
+    {
+        NDRX_FREE(in);
+    }
+
+    if (NULL!=out)
+    {
+        NDRX_FREE(out);
+    }
+
+    return ret;
+}
+
+/* vim: set ts=4 sw=4 et smartindent: */
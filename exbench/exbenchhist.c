@@ -0,0 +1,268 @@
+/**
+ * @brief Latency histogram (HDR style). Values are kept in log-linear
+ *   buckets: power of two ranges, each split in linear sub-buckets, thus
+ *   relative error is bounded while memory is fixed. Histograms of threads &
+ *   processes are merged by adding the bucket counts.
+ *
+ * @file exbenchhist.c
+ */
+/* -----------------------------------------------------------------------------
+ * Enduro/X Middleware Platform for Distributed Transaction Processing
+ * Copyright (C) 2009-2016, ATR Baltic, Ltd. All Rights Reserved.
+ * Copyright (C) 2017-2019, Mavimax, Ltd. All Rights Reserved.
+ * This software is released under one of the following licenses:
+ * AGPL (with Java and Go exceptions) or Mavimax's license for commercial use.
+ * See LICENSE file for full text.
+ * -----------------------------------------------------------------------------
+ * AGPL license:
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License, version 3 as published
+ * by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License, version 3
+ * for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * -----------------------------------------------------------------------------
+ * A commercial use license is available from Mavimax, Ltd
+ * contact@mavimax.com
+ * -----------------------------------------------------------------------------
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <ndrstandard.h>
+#include "exbenchhist.h"
+/*---------------------------Externs------------------------------------*/
+/*---------------------------Macros-------------------------------------*/
+#define HALF    (EXBENCH_HIST_SUB/2)
+/*---------------------------Enums--------------------------------------*/
+/*---------------------------Typedefs-----------------------------------*/
+/*---------------------------Globals------------------------------------*/
+/*---------------------------Statics------------------------------------*/
+/*---------------------------Prototypes---------------------------------*/
+
+/**
+ * Get bucket index for the value
+ * @param val value
+ * @return bucket index
+ */
+exprivate int hist_idx(uint64_t val)
+{
+    int msb = 63;
+    int e;
+    
+    if (val < EXBENCH_HIST_SUB)
+    {
+        return (int)val;
+    }
+    
+    while (!(val & (((uint64_t)1)<<msb)))
+    {
+        msb--;
+    }
+    
+    e = msb - EXBENCH_HIST_SUBBITS + 1;
+    
+    return e*HALF + (int)(val >> e);
+}
+
+/**
+ * Get highest value which maps to the bucket
+ * @param idx bucket index
+ * @return value
+ */
+exprivate uint64_t hist_val(int idx)
+{
+    int e;
+    
+    if (idx < EXBENCH_HIST_SUB)
+    {
+        return (uint64_t)idx;
+    }
+    
+    e = idx/HALF - 1;
+    
+    return ((uint64_t)(idx - e*HALF) << e) + (((uint64_t)1)<<e) - 1;
+}
+
+/**
+ * Reset histogram
+ * @param h histogram
+ */
+expublic void exbench_hist_init(exbench_hist_t *h)
+{
+    memset(h, 0, sizeof(*h));
+    h->min = EXBENCH_HIST_MAXVAL;
+}
+
+/**
+ * Record single value
+ * @param h histogram
+ * @param val value (microseconds)
+ */
+expublic void exbench_hist_record(exbench_hist_t *h, uint64_t val)
+{
+    if (val > EXBENCH_HIST_MAXVAL)
+    {
+        val = EXBENCH_HIST_MAXVAL;
+    }
+    
+    h->buckets[hist_idx(val)]++;
+    h->count++;
+    h->sum+=val;
+    
+    if (val < h->min)
+    {
+        h->min = val;
+    }
+    
+    if (val > h->max)
+    {
+        h->max = val;
+    }
+}
+
+/**
+ * Add histogram to other one
+ * @param dst destination
+ * @param src source
+ */
+expublic void exbench_hist_merge(exbench_hist_t *dst, exbench_hist_t *src)
+{
+    int i;
+    
+    if (0==src->count)
+    {
+        return;
+    }
+    
+    for (i=0; i<EXBENCH_HIST_BUCKETS; i++)
+    {
+        dst->buckets[i]+=src->buckets[i];
+    }
+    
+    dst->count+=src->count;
+    dst->sum+=src->sum;
+    
+    if (src->min < dst->min)
+    {
+        dst->min = src->min;
+    }
+    
+    if (src->max > dst->max)
+    {
+        dst->max = src->max;
+    }
+}
+
+/**
+ * Get value at percentile
+ * @param h histogram
+ * @param pct percentile 0..100
+ * @return value (highest equivalent of bucket, not above max)
+ */
+expublic uint64_t exbench_hist_percentile(exbench_hist_t *h, double pct)
+{
+    uint64_t rank;
+    double dr;
+    uint64_t seen = 0;
+    uint64_t val;
+    int i;
+    
+    if (0==h->count)
+    {
+        return 0;
+    }
+    
+    /* rank is rounded up, i.e. p50 of 3 values is the 2nd one */
+    dr = pct / 100.0 * (double)h->count;
+    rank = (uint64_t)dr;
+    
+    if ((double)rank < dr)
+    {
+        rank++;
+    }
+    
+    if (rank < 1)
+    {
+        rank = 1;
+    }
+    
+    for (i=0; i<EXBENCH_HIST_BUCKETS; i++)
+    {
+        seen+=h->buckets[i];
+        
+        if (seen >= rank)
+        {
+            val = hist_val(i);
+            return val > h->max ? h->max : val;
+        }
+    }
+    
+    return h->max;
+}
+
+/**
+ * Write percentiles
+ * @param h histogram
+ * @param f output file
+ * @param format EXBENCH_HIST_CSV or EXBENCH_HIST_JSON (one object per line)
+ * @param config_name configuration name
+ * @param msgsize message size
+ * @param rate target rate (0 - closed loop)
+ * @param header print CSV header
+ * @return EXSUCCEED/EXFAIL
+ */
+expublic int exbench_hist_write(exbench_hist_t *h, FILE *f, int format, 
+        char *config_name, double msgsize, double rate, int header)
+{
+    int ret;
+    double mean = h->count ? (double)h->sum / (double)h->count : 0;
+    
+    if (EXBENCH_HIST_JSON==format)
+    {
+        ret = fprintf(f, "{\"config\":\"%s\",\"msgsize\":%.0lf,\"rate\":%.0lf,"
+                "\"count\":%llu,\"unit\":\"us\",\"min\":%llu,\"mean\":%.1lf,"
+                "\"p50\":%llu,\"p90\":%llu,\"p99\":%llu,\"p999\":%llu,"
+                "\"max\":%llu}\n",
+                config_name, msgsize, rate, 
+                (unsigned long long)h->count,
+                (unsigned long long)(h->count ? h->min : 0), mean,
+                (unsigned long long)exbench_hist_percentile(h, 50),
+                (unsigned long long)exbench_hist_percentile(h, 90),
+                (unsigned long long)exbench_hist_percentile(h, 99),
+                (unsigned long long)exbench_hist_percentile(h, 99.9),
+                (unsigned long long)h->max);
+    }
+    else
+    {
+        if (header)
+        {
+            fprintf(f, "Configuration,MsgSize,Rate,Count,MinUs,MeanUs,"
+                    "P50Us,P90Us,P99Us,P999Us,MaxUs\n");
+        }
+        
+        ret = fprintf(f, "%s,%.0lf,%.0lf,%llu,%llu,%.1lf,%llu,%llu,%llu,%llu,%llu\n",
+                config_name, msgsize, rate, 
+                (unsigned long long)h->count,
+                (unsigned long long)(h->count ? h->min : 0), mean,
+                (unsigned long long)exbench_hist_percentile(h, 50),
+                (unsigned long long)exbench_hist_percentile(h, 90),
+                (unsigned long long)exbench_hist_percentile(h, 99),
+                (unsigned long long)exbench_hist_percentile(h, 99.9),
+                (unsigned long long)h->max);
+    }
+    
+    return ret < 0 ? EXFAIL : EXSUCCEED;
+}
+
+/* vim: set ts=4 sw=4 et smartindent: */
@@ -0,0 +1,94 @@
+/**
+ * @brief Latency histogram (HDR style, log-linear buckets)
+ *
+ * @file exbenchhist.h
+ */
+/* -----------------------------------------------------------------------------
+ * Enduro/X Middleware Platform for Distributed Transaction Processing
+ * Copyright (C) 2009-2016, ATR Baltic, Ltd. All Rights Reserved.
+ * Copyright (C) 2017-2019, Mavimax, Ltd. All Rights Reserved.
+ * This software is released under one of the following licenses:
+ * AGPL (with Java and Go exceptions) or Mavimax's license for commercial use.
+ * See LICENSE file for full text.
+ * -----------------------------------------------------------------------------
+ * AGPL license:
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License, version 3 as published
+ * by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License, version 3
+ * for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * -----------------------------------------------------------------------------
+ * A commercial use license is available from Mavimax, Ltd
+ * contact@mavimax.com
+ * -----------------------------------------------------------------------------
+ */
+
+#ifndef EXBENCHHIST_H
+#define	EXBENCHHIST_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/*---------------------------Includes-----------------------------------*/
+#include <stdio.h>
+#include <stdint.h>
+/*---------------------------Externs------------------------------------*/
+/*---------------------------Macros-------------------------------------*/
+/**
+ * Sub-buckets per power of two, 2^7 gives less than 1% value error
+ */
+#define EXBENCH_HIST_SUBBITS    7
+#define EXBENCH_HIST_SUB        (1<<EXBENCH_HIST_SUBBITS)
+/**
+ * Largest value tracked 2^40 microseconds (~12 days), larger are clamped
+ */
+#define EXBENCH_HIST_MAXBITS    40
+#define EXBENCH_HIST_MAXVAL     ((((uint64_t)1)<<EXBENCH_HIST_MAXBITS)-1)
+#define EXBENCH_HIST_BUCKETS    ((EXBENCH_HIST_MAXBITS-EXBENCH_HIST_SUBBITS+2) \
+                                    * (EXBENCH_HIST_SUB/2))
+    
+#define EXBENCH_HIST_CSV        1   /**< CSV output format  */
+#define EXBENCH_HIST_JSON       2   /**< JSON output format */
+/*---------------------------Enums--------------------------------------*/
+/*---------------------------Typedefs-----------------------------------*/
+
+/**
+ * Latency histogram, values in microseconds
+ */
+typedef struct
+{
+    uint64_t count;                         /**< number of values   */
+    uint64_t min;                           /**< smallest value     */
+    uint64_t max;                           /**< largest value      */
+    uint64_t sum;                           /**< sum, for mean      */
+    uint64_t buckets[EXBENCH_HIST_BUCKETS]; /**< value counts       */
+} exbench_hist_t;
+
+/*---------------------------Globals------------------------------------*/
+/*---------------------------Statics------------------------------------*/
+/*---------------------------Prototypes---------------------------------*/
+
+extern void exbench_hist_init(exbench_hist_t *h);
+extern void exbench_hist_record(exbench_hist_t *h, uint64_t val);
+extern void exbench_hist_merge(exbench_hist_t *dst, exbench_hist_t *src);
+extern uint64_t exbench_hist_percentile(exbench_hist_t *h, double pct);
+extern int exbench_hist_write(exbench_hist_t *h, FILE *f, int format, 
+        char *config_name, double msgsize, double rate, int header);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* EXBENCHHIST_H */
+
+/* vim: set ts=4 sw=4 et smartindent: */
@@ -807,5 +807,16 @@
 #define	TA_EX_TIMEDIFFF	((BFLDID32)33558039)	/* number: 3607	 type: long */
 #define	TA_EX_TIME	((BFLDID32)33558040)	/* number: 3608	 type: long */
 #define	TA_EX_TIMEF	((BFLDID32)33558041)	/* number: 3609	 type: long */
+#define	TA_EX_CMPR	((BFLDID32)67112474)	/* number: 3610	 type: char */
+#define	TA_EX_CMPRIN	((BFLDID32)33558043)	/* number: 3611	 type: long */
+#define	TA_EX_CMPROUT	((BFLDID32)33558044)	/* number: 3612	 type: long */
+#define	TA_EX_CMPRRATIO	((BFLDID32)33558045)	/* number: 3613	 type: long */
+#define	TA_EX_CMPRUSEC	((BFLDID32)33558046)	/* number: 3614	 type: long */
+#define	TA_EX_DCMPRUSEC	((BFLDID32)33558047)	/* number: 3615	 type: long */
+#define	TA_EX_CRWINDOW	((BFLDID32)33558048)	/* number: 3616	 type: long */
+#define	TA_EX_CRPEER	((BFLDID32)33558049)	/* number: 3617	 type: long */
+#define	TA_EX_CRAVAIL	((BFLDID32)33558050)	/* number: 3618	 type: long */
+#define	TA_EX_CRWAITS	((BFLDID32)33558051)	/* number: 3619	 type: long */
+#define	TA_EX_CRREJECTS	((BFLDID32)33558052)	/* number: 3620	 type: long */
 #endif
 /* vim: set ts=4 sw=4 et smartindent: */
@@ -45,6 +45,7 @@ extern "C" {
 #include <atmi_int.h>
 #include <exhash.h>
 #include <exdb.h>
+#include <thlock.h>
 
 /*---------------------------Externs------------------------------------*/
 /*---------------------------Macros-------------------------------------*/
@@ -69,6 +70,9 @@ extern "C" {
 #define NDRX_TPCACHE_KWC_NEXT                   "next"
 #define NDRX_TPCACHE_KWC_DELREG                 "delrex"
 #define NDRX_TPCACHE_KWC_DELFULL                "delfull"
+#define NDRX_TPCACHE_KWC_SINGLEFL               "singleflight"
+#define NDRX_TPCACHE_KWC_SFSTALE                "sfstale"
+#define NDRX_TPCACHE_KWC_SFWAIT                 "sfwait"
 #define NDRX_TPCACHE_KWC_DELSETOF               ""
 #define NDRX_TPCACHE_KWC_KEYITEMS               ""
     
@@ -103,6 +107,7 @@ extern "C" {
 #define NDRX_TPCACHE_KWD_PERMS                  "perms"
 #define NDRX_TPCACHE_KWD_LIMIT                  "limit"
 #define NDRX_TPCACHE_KWD_EXPIRY                 "expiry"
+#define NDRX_TPCACHE_KWD_L1MAX                  "l1max"
 #define NDRX_TPCACHE_KWD_FLAGS                  "flags"
     
 /* Database flags, keywords */
@@ -120,6 +125,7 @@ extern "C" {
 #define NDRX_TPCACHE_KWD_CLRNOSVC               "clrnosvc"
 #define NDRX_TPCACHE_KWD_NOSYNC                 "nosync"
 #define NDRX_TPCACHE_KWD_NOMETASYNC             "nometasync"
+#define NDRX_TPCACHE_KWD_INDEX                  "index"
 
 /* Database flags: */
     
@@ -142,6 +148,13 @@ extern "C" {
     
 #define NDRX_TPCACHE_FLAGS_KEYGRP    0x00001000   /**< Is this key group?               */
 #define NDRX_TPCACHE_FLAGS_KEYITEMS  0x00002000   /**< Is this key item?                */
+#define NDRX_TPCACHE_FLAGS_INDEX     0x00004000   /**< Keep time/rank index of records  */
+
+/* Index entry types of the "<db>.idx" db: */
+#define NDRX_TPCACHE_IDX_PUT         'E'          /**< by put time (expiry, fifo)       */
+#define NDRX_TPCACHE_IDX_LRU         'L'          /**< by last hit time (lru)           */
+#define NDRX_TPCACHE_IDX_HITS        'H'          /**< by hits, last hit time (hits)    */
+#define NDRX_TPCACHE_IDX_KEYLEN      25           /**< type + 2x be64 value + be64 hash */
     
 #define NDRX_TPCACHE_TPCF_SAVEREG    0x00000001   /**< Save record can be regexp        */
 #define NDRX_TPCACHE_TPCF_REPL       0x00000002   /**< Replace buf                      */
@@ -156,6 +169,14 @@ extern "C" {
 #define NDRX_TPCACHE_TPCF_KEYITEMS   0x00000400   /**< Cache is items for group         */
 #define NDRX_TPCACHE_TPCF_INVLKEYGRP 0x00000800   /**< invalidate whole group during op */
 #define NDRX_TPCACHE_TPCF_NOSVCOK    0x00001000   /**< No service OK, return data       */
+#define NDRX_TPCACHE_TPCF_SINGLEFL   0x00002000   /**< One caller refreshes missing key */
+#define NDRX_TPCACHE_TPCF_SFSTALE    0x00004000   /**< Serve expired rec during refresh */
+
+#define NDRX_TPCACHE_SFWAIT_DFLT     3000         /**< Single-flight wait, ms           */
+
+#define NDRX_TPCACHE_SF_OFF          0   /**< Single-flight not used for call    */
+#define NDRX_TPCACHE_SF_LEADER       1   /**< We refresh the key                 */
+#define NDRX_TPCACHE_SF_FOLLOWER     2   /**< Other process refreshes the key    */
 
 #define NDRX_TPCACH_INIT_NORMAL      0   /* Normal init (client & server)    */
 #define NDRX_TPCACH_INIT_BOOT        1   /* Boot mode init (ndrxd startst)   */
@@ -218,6 +239,7 @@ extern "C" {
     NDRX_LOG(LEV, "%s=[%s]", NDRX_TPCACHE_KWD_RESOURCE, CACHEDB->resource);\
     NDRX_LOG(LEV, "%s=[%ld]", NDRX_TPCACHE_KWD_LIMIT, CACHEDB->limit);\
     NDRX_LOG(LEV, "%s=[%ld] sec", NDRX_TPCACHE_KWD_EXPIRY, CACHEDB->expiry);\
+    NDRX_LOG(LEV, "%s=[%ld] bytes", NDRX_TPCACHE_KWD_L1MAX, CACHEDB->l1max);\
     NDRX_LOG(LEV, "%s=[%ld]", NDRX_TPCACHE_KWD_FLAGS, CACHEDB->flags);\
     NDRX_LOG(LEV, "flags, 'expiry' = [%d]", \
                     !!(CACHEDB->flags &  NDRX_TPCACHE_FLAGS_EXPIRY));\
@@ -247,6 +269,8 @@ extern "C" {
                     !!(CACHEDB->flags &  NDRX_TPCACHE_FLAGS_NOSYNC));\
     NDRX_LOG(LEV, "flags, '%s' = [%d]", NDRX_TPCACHE_KWD_NOMETASYNC, \
                     !!(CACHEDB->flags &  NDRX_TPCACHE_FLAGS_NOMETASYNC));\
+    NDRX_LOG(LEV, "flags, '%s' = [%d]", NDRX_TPCACHE_KWD_INDEX, \
+                    !!(CACHEDB->flags &  NDRX_TPCACHE_FLAGS_INDEX));\
     NDRX_LOG(LEV, "%s=[%ld]", NDRX_TPCACHE_KWD_MAX_READERS, CACHEDB->max_readers);\
     NDRX_LOG(LEV, "%s=[%ld]", NDRX_TPCACHE_KWD_MAP_SIZE, CACHEDB->map_size);\
     NDRX_LOG(LEV, "%s=[%o]", NDRX_TPCACHE_KWD_PERMS, CACHEDB->perms);\
@@ -303,6 +327,11 @@ extern "C" {
     NDRX_LOG(LEV, "flags, '%s' = [%d]", \
                     NDRX_TPCACHE_KWC_INVLKEYGRP, \
                     !!(TPCALLCACHE->flags &  NDRX_TPCACHE_TPCF_INVLKEYGRP));\
+    NDRX_LOG(LEV, "flags, '%s' = [%d]", NDRX_TPCACHE_KWC_SINGLEFL,\
+                    !!(TPCALLCACHE->flags &  NDRX_TPCACHE_TPCF_SINGLEFL));\
+    NDRX_LOG(LEV, "flags, '%s' = [%d]", NDRX_TPCACHE_KWC_SFSTALE,\
+                    !!(TPCALLCACHE->flags &  NDRX_TPCACHE_TPCF_SFSTALE));\
+    NDRX_LOG(LEV, "%s=[%ld] ms", NDRX_TPCACHE_KWC_SFWAIT, TPCALLCACHE->sfwait);\
     NDRX_LOG(LEV, "inval_cache=[%p]", TPCALLCACHE->inval_cache);\
     NDRX_LOG(LEV, "%s=[%s]", NDRX_TPCACHE_KWC_INVAL_SVC, TPCALLCACHE->inval_svc);\
     NDRX_LOG(LEV, "%s=[%d]", NDRX_TPCACHE_KWC_INVAL_IDX, TPCALLCACHE->inval_idx);\
@@ -420,6 +449,19 @@ struct ndrx_tpcache_phydb
 };
 
 
+/**
+ * In-process L1 copy of the cache db record
+ */
+typedef struct ndrx_tpcache_l1 ndrx_tpcache_l1_t;
+struct ndrx_tpcache_l1
+{
+    char *key;                  /**< cache key                                  */
+    struct ndrx_tpcache_data *exdata; /**< copy of the db record                */
+    long size;                  /**< bytes accounted for the entry              */
+    ndrx_tpcache_l1_t *prev, *next; /**< LRU list, most recent first            */
+    EX_hash_handle hh;          /**< hash by key                                */
+};
+
 /**
  * Cache database, logical
  */
@@ -444,6 +486,15 @@ struct ndrx_tpcache_db
     /* LMDB Related */
     
     EDB_dbi dbi;  /* named (unnamed) db */
+    EDB_dbi idxdbi;  /* time/rank index db, if flag index */
+    
+    /* In-process L1 tier */
+    long l1max;                 /* bytes for L1 records, 0 - L1 not used            */
+    long l1_bytes;              /* bytes used by L1 records                         */
+    edb_size_t l1_txnid;        /* env txn id for which L1 records are valid        */
+    ndrx_tpcache_l1_t *l1_hash; /* L1 records by key                                */
+    ndrx_tpcache_l1_t *l1_lru;  /* L1 records, most recently used first             */
+    MUTEX_LOCKDECLN(l1_lock);   /* protects the L1 of this db                       */
     
     /* Make structure hashable: */
     EX_hash_handle hh;
@@ -518,6 +569,8 @@ struct ndrx_tpcallcache
     int keygroupmtperrno;
     long keygroupmtpurcode;
     
+    long sfwait;        /* single-flight: max ms to wait for other's refresh */
+    
     /* this is linked list of caches */
     ndrx_tpcallcache_t *next, *prev;
 };
@@ -648,7 +701,7 @@ extern NDRX_API int ndrx_cache_save (char *svc, char *idata,
 extern NDRX_API int ndrx_cache_lookup(char *svc, char *idata, long ilen, 
         char **odata, long *olen, long flags, int *should_cache,
         int *saved_tperrno, long *saved_tpurcode, int seterror_not_found,
-        int notenterr);
+        int notenterr, ndrx_tpcache_sfref_t *sfref);
 extern NDRX_API int ndrx_cache_inval_their(char *svc, ndrx_tpcallcache_t *cache, 
         char *key, char *idata, long ilen);
 
@@ -745,6 +798,35 @@ extern NDRX_API int ndrx_cache_events_get(string_list_t **list);
 
 /* keygroup: */
 
+/* single-flight: */
+extern NDRX_API int ndrx_cache_sf_claim(ndrx_tpcallcache_t *cache, char *key, 
+        ndrx_tpcache_sfref_t *ref);
+extern NDRX_API int ndrx_cache_sf_busy(ndrx_tpcallcache_t *cache, 
+        ndrx_tpcache_sfref_t *ref);
+extern NDRX_API void ndrx_cache_sf_release(ndrx_tpcache_sfref_t *ref);
+extern NDRX_API void ndrx_cache_sf_pause(void);
+extern NDRX_API int ndrx_cache_sf_remove(void);
+
+/* time/rank index: */
+extern NDRX_API int ndrx_cache_idx_open(ndrx_tpcache_db_t *db, EDB_txn *txn);
+extern NDRX_API int ndrx_cache_idx_add(ndrx_tpcache_db_t *db, EDB_txn *txn,
+        char *key, EDB_val *data);
+extern NDRX_API int ndrx_cache_idx_del(ndrx_tpcache_db_t *db, EDB_txn *txn,
+        char *key, EDB_val *data);
+extern NDRX_API int ndrx_cache_idx_match(ndrx_tpcache_db_t *db, EDB_val *idxkey,
+        char *key, EDB_val *data);
+extern NDRX_API char ndrx_cache_idx_parse(EDB_val *idxkey, long *v1, long *v2);
+
+/* L1 tier: */
+extern NDRX_API int ndrx_cache_l1_lookup(ndrx_tpcallcache_t *cache, 
+        typed_buffer_descr_t *buf_type, char *key, char *idata, long ilen, 
+        char **odata, long *olen, long flags, int *saved_tperrno, 
+        long *saved_tpurcode, int *should_cache, int noenterr);
+extern NDRX_API void ndrx_cache_l1_add(ndrx_tpcache_db_t *db, char *key, 
+        ndrx_tpcache_data_t *exdata, long size, edb_size_t txnid);
+extern NDRX_API void ndrx_cache_l1_del(ndrx_tpcache_db_t *db, char *key);
+extern NDRX_API void ndrx_cache_l1_free(ndrx_tpcache_db_t *db);
+
 extern NDRX_API int ndrx_cache_keygrp_lookup(ndrx_tpcallcache_t *cache, 
             char *idata, long ilen, char **odata, long *olen, char *cachekey,
             long flags);
@@ -93,6 +93,39 @@ extern "C" {
 #define ATMI_COMMAND_TPNOTIFY   13      /* Notification message         */
 #define ATMI_COMMAND_BROADCAST  14      /* Broadcast notification       */
 
+/** proto_magic of tp_command_call_cmpct_t (compact call header) */
+#define NDRX_CALLHDR_CMPCT_MAGIC    0x63706374
+
+/* Compact call header optional section tags */
+#define NDRX_CALLHDR_TAG_REPLYTO    1   /**< reply_to                   */
+#define NDRX_CALLHDR_TAG_CALLSTACK  2   /**< callstack                  */
+#define NDRX_CALLHDR_TAG_MYID       3   /**< my_id                      */
+#define NDRX_CALLHDR_TAG_EXTRADATA  4   /**< extradata                  */
+#define NDRX_CALLHDR_TAG_TMXID      5   /**< tmxid                      */
+#define NDRX_CALLHDR_TAG_TMKNOWNRMS 6   /**< tmknownrms                 */
+#define NDRX_CALLHDR_TAG_TRACE      7   /**< trace (when traced)        */
+
+/* Call trace hop kinds, see calltrace.c */
+#define NDRX_TRACE_HOP_ENQ          1   /**< Request sent by caller     */
+#define NDRX_TRACE_HOP_DEQ          2   /**< Request taken by server    */
+#define NDRX_TRACE_HOP_SVCSTART     3   /**< Service function entered   */
+#define NDRX_TRACE_HOP_SVCEND       4   /**< tpreturn() called          */
+#define NDRX_TRACE_HOP_FWD          5   /**< tpforward() called         */
+#define NDRX_TRACE_HOP_BROUT        6   /**< Bridge sends to network    */
+#define NDRX_TRACE_HOP_BRIN         7   /**< Bridge got from network    */
+#define NDRX_TRACE_HOP_RPLDEQ       8   /**< Reply taken by caller      */
+
+/** Max hops recorded per call. Trace must fit in one compact header
+ * section (255 bytes) */
+#define NDRX_TRACE_HOPS_MAX         24
+
+/** Offset of the trace section from the call data (aligned after payload) */
+#define NDRX_TRACE_OFFSET(DATA_LEN) (((DATA_LEN)+7) & ~((long)7))
+
+/** Bytes of trace section sent, up to the last hop recorded */
+#define NDRX_TRACE_LEN(TRACE)       (EXOFFSET(ndrx_trace_t, hops) + \
+                                    sizeof(ndrx_trace_hop_t)*(TRACE)->nhops)
+
 /* Call states */
 #define CALL_NOT_ISSUED         0
 #define CALL_WAITING_FOR_ANS    1
@@ -262,6 +295,11 @@ extern "C" {
 #define SYS_SRV_CVT_JSON2VIEW   0x00000020 /**< Message is converted from JSON to VIEW */
 #define SYS_SRV_CVT_VIEW2JSON   0x00000040 /**< Message is converted from UBF to JSON (non NULL)*/
 #define SYS_FLAG_AUTOTRAN       0x00000100 /**< Auto transaction started               */
+#define SYS_FLAG_LMSG           0x00000200 /**< Payload is in large message pool slab  */
+#define SYS_FLAG_BRCREDIT       0x00000400 /**< Call holds bridge flow control credit  */
+#define SYS_FLAG_CONVPOOL       0x00000800 /**< Sender's conv queue is pooled, no unlink */
+#define SYS_FLAG_TRACE          0x00001000 /**< Call trace section follows the data    */
+#define SYS_FLAG_CMPCTHDR       0x00002000 /**< Caller decodes compact reply header    */
 /* Test is any flag set */
 #define SYS_SRV_CVT_ANY_SET(X) (X & SYS_SRV_CVT_JSON2UBF || X & SYS_SRV_CVT_UBF2JSON ||\
         X & SYS_SRV_CVT_JSON2VIEW || X & SYS_SRV_CVT_VIEW2JSON)
@@ -308,6 +346,12 @@ extern "C" {
  * Structure represents typed buffer instance
  */
 typedef struct buffer_obj buffer_obj_t;
+
+/**
+ * Buffer object is stored in the hidden header directly before the
+ * user data (see NDRX_TPBUF_OBJ()), and is registered in the buffer index
+ * (see typed_buf.c).
+ */
 struct buffer_obj
 {
     int type_id;
@@ -316,8 +360,6 @@ struct buffer_obj
     short autoalloc;  /**< Is buffer automatically allocated by tpcall? */
     char *buf;
     long size;        /**< Allocated size.... */
-    /* Move to hash by buf */
-    /* buffer_obj_t *prev, *next; */
     EX_hash_handle hh;         /**< makes this structure hashable */
 };
 
@@ -504,6 +546,12 @@ struct atmi_lib_env
     /**@}*/
     
     long xa_fsync_flags;            /** Special tmqueue flags                  */
+    
+    int     lmsgpool;   /**< Number of large message pool slabs, 0 - off */
+    long    lmsgthres;  /**< Buffer size from which pool is used        */
+    long    cmpcthdr;   /**< Max payload for compact call header, 0 - off */
+    int     convpool;   /**< Pooled conversation queues per role, 0 - off */
+    int     tracesample;/**< Trace every Nth root call, 0 - off       */
 };
 typedef struct  atmi_lib_env atmi_lib_env_t;
 
@@ -523,6 +571,54 @@ struct tp_command_generic
 };
 typedef struct tp_command_generic tp_command_generic_t;
 
+/**
+ * One hop of the traced call
+ */
+typedef struct
+{
+    int usec;       /**< Microseconds since trace base          */
+    short kind;     /**< NDRX_TRACE_HOP_* kind                  */
+    short nodeid;   /**< Node where hop was recorded            */
+} ndrx_trace_hop_t;
+
+/**
+ * Call trace context. Hop stamps are relative to \p base, which is the
+ * monotonic clock of the caller. Bridges shift \p base to the clock of
+ * the peer node, the same way as the call timer.
+ * Traced calls carry it after the payload (at NDRX_TRACE_OFFSET() from the
+ * data, up to the last hop) and have SYS_FLAG_TRACE set. Other calls do not
+ * carry it at all.
+ */
+typedef struct
+{
+    long trace_id;          /**< Trace id, 0 - call is not traced       */
+    long span_id;           /**< This call                              */
+    long parent_id;         /**< Call being served by caller, 0 - root  */
+    ndrx_stopwatch_t base;  /**< Time of the first hop                  */
+    int nhops;              /**< Hops recorded                          */
+    int padding;
+    ndrx_trace_hop_t hops[NDRX_TRACE_HOPS_MAX];
+} ndrx_trace_t;
+
+/**
+ * Completed call trace, as stored in the trace ring
+ */
+typedef struct
+{
+    unsigned long seq;      /**< Ring sequence, 0 - slot not written    */
+    long trace_id;          /**< Trace id                               */
+    long span_id;           /**< Call id                                */
+    long parent_id;         /**< Parent call id, 0 - root               */
+    char svcnm[XATMI_SERVICE_NAME_LENGTH+1]; /**< Service called        */
+    short nodeid;           /**< Node which completed the call          */
+    pid_t pid;              /**< Process which completed the call       */
+    int rval;               /**< Service return value                   */
+    long rcode;             /**< Service return code                    */
+    long tstamp;            /**< UTC seconds of completion              */
+    int nhops;              /**< Hops recorded                          */
+    ndrx_trace_hop_t hops[NDRX_TRACE_HOPS_MAX];
+} ndrx_calltrace_rec_t;
+
 /**
  * Call handler.
  * For storing the tppost associated timestamp, we could allow data to be installed
@@ -566,6 +662,10 @@ struct tp_command_call
     unsigned short callseq;
     /** message sequence for conversational over multithreaded bridges*/
     unsigned short msgseq;
+    /** conversation: receiver's listen queue generation, echoed by sender */
+    unsigned short convgen;
+    /** conversation: sender's listen queue generation, announced to peer */
+    unsigned short convgen_snd;
     /** call timer so that we do not operate with timed-out calls. */
     ndrx_stopwatch_t timer;    
     
@@ -587,6 +687,50 @@ struct tp_command_call
 };
 typedef struct tp_command_call tp_command_call_t;
 
+/**
+ * Compact form of the tp_command_call_t, see callhdr.c. Fields up to the
+ * service name are laid out the same as in full call (routing by name works
+ * on both forms). Fixed fields are followed by \p opt_len bytes of optional
+ * sections (tag, len, bytes) and then by the payload.
+ */
+struct tp_command_call_cmpct
+{
+    /* <standard comms header:> */
+#if defined(EX_USE_SYSVQ) || defined(EX_USE_SVAPOLL)
+    long mtype; /* mandatory for System V queues */
+#endif
+    short command_id;
+    char proto_ver[4];
+    int proto_magic; /**< NDRX_CALLHDR_CMPCT_MAGIC */
+    /* </standard comms header> */
+    
+    short buffer_type_id;
+    char name[XATMI_SERVICE_NAME_LENGTH+1];
+    
+    long sysflags;
+    int cd;
+    int rval;
+    long rcode;
+    int user3;
+    long user4;
+    int clttout;
+    long flags;
+    time_t timestamp;
+    unsigned short callseq;
+    unsigned short msgseq;
+    ndrx_stopwatch_t timer;
+    
+    short tmtxflags;
+    short tmrmid;
+    short tmnodeid;
+    short tmsrvid;
+    
+    int opt_len;    /**< Bytes of optional sections (aligned)   */
+    long data_len;  /**< Payload len                            */
+    char data[0];   /**< Optional sections, then payload        */
+};
+typedef struct tp_command_call_cmpct tp_command_call_cmpct_t;
+
 /*
  * Notification message
  */
@@ -664,6 +808,12 @@ struct tpconv_buffer
 /**
  * Structure for holding conversation details
  */
+/** Pooled conversation queues use this + pool index in place of cd in name */
+#define NDRX_CONV_POOL_CD        (NDRX_CONV_UPPER_CNT*2)
+
+/** Pooled conversation queue, see convpool.c */
+typedef struct ndrx_convpool_ent ndrx_convpool_ent_t;
+
 struct tp_conversation_control
 {
     int status;
@@ -694,6 +844,12 @@ struct tp_conversation_control
     
     tpconv_buffer_t *out_of_order_msgs; /* hash for out of the order messages */
     
+    ndrx_convpool_ent_t *pool_ent; /**< Listen queue from pool, NULL - own queue */
+    short reply_q_pooled;   /**< Their queue is pooled, must not be unlinked  */
+    unsigned short gen_in;  /**< Our listen queue generation, peer echoes it  */
+    unsigned short gen_out; /**< Their listen queue generation, we echo it    */
+    char their_id[NDRX_MAX_ID_SIZE+1]; /**< Peer's my_id, EOS - not known yet */
+    
 };
 typedef struct tp_conversation_control tp_conversation_control_t;
 
@@ -759,6 +915,18 @@ typedef struct ndrx_qdet ndrx_qdet_t;
  * because cache is transparent and shall not interfere with logic if service
  * does not exists.
  */
+/**
+ * Single-flight claim of the cache key. Held by the caller which refreshes
+ * the record, or points to the refresher's slot for the waiters.
+ */
+struct ndrx_tpcache_sfref
+{
+    int claimed;                /**< we hold the claim                      */
+    int slot;                   /**< slot in the in-flight table            */
+    unsigned gen;               /**< slot generation at claim               */
+};
+typedef struct ndrx_tpcache_sfref ndrx_tpcache_sfref_t;
+
 struct ndrx_tpcall_cache_ctl
 {
     int should_cache;           /**< should we cache response?              */
@@ -767,6 +935,7 @@ struct ndrx_tpcall_cache_ctl
     long saved_tpurcode;
     long *olen;
     char **odata;
+    ndrx_tpcache_sfref_t sfref; /**< single-flight claim, if refreshing     */
 };
 typedef struct ndrx_tpcall_cache_ctl ndrx_tpcall_cache_ctl_t;
 
@@ -775,6 +944,18 @@ typedef struct ndrx_tpcall_cache_ctl ndrx_tpcall_cache_ctl_t;
  * actual size smaller than 1 char */
 #define MAX_CALL_DATA_SIZE (NDRX_MSGSIZEMAX-sizeof(tp_command_call_t))
 
+/**
+ * Large message pool reference. When SYS_FLAG_LMSG is set in the call
+ * sysflags, this is the only data of the call, the payload is in the slab.
+ */
+struct ndrx_lmsg_ref
+{
+    int slot;       /**< slab number in the pool                */
+    unsigned gen;   /**< slab generation at allocation          */
+    long len;       /**< payload length in the slab             */
+};
+typedef struct ndrx_lmsg_ref ndrx_lmsg_ref_t;
+
 
 /* Indicators for  tpexportex() and tpimportex() */
 struct ndrx_expbufctl
@@ -967,6 +1148,7 @@ extern NDRX_API int ndrx_ndrxd_ping(int *p_seq, long *p_time_msec,
 /* Access to symbols: */
 
 extern NDRX_API tp_command_call_t *ndrx_get_G_last_call(void);
+extern NDRX_API ndrx_trace_t *ndrx_get_G_last_trace(void);
 extern NDRX_API atmi_lib_conf_t *ndrx_get_G_atmi_conf(void);
 extern NDRX_API atmi_lib_env_t *ndrx_get_G_atmi_env(void);
 extern NDRX_API tp_conversation_control_t *ndrx_get_G_accepted_connection(void);
@@ -982,6 +1164,47 @@ extern NDRX_API int ndrx_tpexportex(ndrx_expbufctl_t *bufctl, char *ibuf, long i
 /* export the symbol */
 extern NDRX_API struct xa_switch_t * ndrx_xa_builtin_get(void);
 
+/* compact call header: */
+extern NDRX_API long ndrx_callhdr_encode(tp_command_call_t *call, long len);
+extern NDRX_API int ndrx_callhdr_decode(char *buf, size_t buf_len, long *len);
+extern NDRX_API int ndrx_callhdr_q_send(char *queue, tp_command_call_t *call, 
+        long len, long flags, int msg_prio, int is_local);
+
+/* large message pool: */
+extern NDRX_API int ndrx_lmsg_prepare_outgoing(typed_buffer_descr_t *descr, 
+        buffer_obj_t *buffer_info, char *data, long len, 
+        tp_command_call_t *call, int ttl, char *rcv_myid, long flags);
+extern NDRX_API int ndrx_lmsg_resolve(tp_command_call_t *call, char **data, 
+        long *data_len);
+extern NDRX_API void ndrx_lmsg_release(tp_command_call_t *call);
+extern NDRX_API void ndrx_lmsg_sanity(void);
+
+/* Conversation queue pool: */
+extern NDRX_API int ndrx_convpool_get(tp_conversation_control_t *conv, int is_srv);
+extern NDRX_API void ndrx_convpool_put(tp_conversation_control_t *conv);
+extern NDRX_API void ndrx_convpool_close(void);
+extern NDRX_API int ndrx_lmsg_remove(int force);
+
+/* Call tracing: */
+extern NDRX_API ndrx_trace_t *ndrx_calltrace_get(tp_command_call_t *call, 
+        long len);
+extern NDRX_API long ndrx_calltrace_put(tp_command_call_t *call, 
+        ndrx_trace_t *trace);
+extern NDRX_API long ndrx_calltrace_begin(tp_command_call_t *call);
+extern NDRX_API void ndrx_calltrace_hop(ndrx_trace_t *trace, short kind);
+extern NDRX_API void ndrx_calltrace_msghop(tp_command_call_t *call, long *len, 
+        short kind);
+extern NDRX_API void ndrx_calltrace_serve(tp_command_call_t *call, long len);
+extern NDRX_API long ndrx_calltrace_reply(tp_command_call_t *reply, 
+        tp_command_call_t *last_call);
+extern NDRX_API long ndrx_calltrace_forward(tp_command_call_t *call);
+extern NDRX_API void ndrx_calltrace_noreply(tp_command_call_t *last_call);
+extern NDRX_API void ndrx_calltrace_emit(tp_command_call_t *call, 
+        ndrx_trace_t *trace);
+extern NDRX_API int ndrx_calltrace_read(unsigned long *seq, 
+        ndrx_calltrace_rec_t *recs, int max);
+extern NDRX_API int ndrx_calltrace_remove(void);
+
 /* tp encryption functions */
 extern NDRX_API int tpencrypt_int(char *input, long ilen, char *output, long *olen, long flags);
 extern NDRX_API int tpdecrypt_int(char *input, long ilen, char *output, long *olen, long flags);
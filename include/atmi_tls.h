@@ -130,6 +130,7 @@ typedef struct
     
     /* atmi.c */    
     tp_command_call_t G_last_call;
+    ndrx_trace_t G_last_trace; /**< Trace of the call served, see calltrace.c */
     /* conversation.c */
     int conv_cd;/*=1;  first available */
     /* unsigned callseq; - will be shared with tpcalls... global ...*//* = 0; */ 
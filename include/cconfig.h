@@ -54,6 +54,7 @@ extern "C" {
 #define NDRX_CCONFIG  "NDRX_CCONFIG"
     
 #define NDRX_CCTAG "NDRX_CCTAG" /* common-config tag */
+#define NDRX_CCONFIG_SNAP "NDRX_CCONFIG_SNAP" /* published config snapshot file */
     
 #define NDRX_CONF_SECTION_GLOBAL    "@global"
 #define NDRX_CONF_SECTION_DEBUG     "@debug"
@@ -81,6 +82,7 @@ extern NDRX_API int ndrx_cconfig_get(char *section, ndrx_inicfg_section_keyval_t
 extern NDRX_API int ndrx_cconfig_load(void);
 extern NDRX_API ndrx_inicfg_t *ndrx_get_G_cconfig(void);
 extern NDRX_API int ndrx_cconfig_reload(void);
+extern NDRX_API int ndrx_cconfig_snap_publish(int force);
 
 /* for user: */
 extern NDRX_API int ndrx_cconfig_load_general(ndrx_inicfg_t **cfg);
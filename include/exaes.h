@@ -22,6 +22,18 @@
 //#define EXAES192 1
 //#define EXAES256 1
 
+#if defined(EXAES256) && (EXAES256 == 1)
+  #define EXAES_KEYEXPSIZE 240
+#elif defined(EXAES192) && (EXAES192 == 1)
+  #define EXAES_KEYEXPSIZE 208
+#else
+  #define EXAES_KEYEXPSIZE 176
+#endif
+
+void EXAES_key_expand(const uint8_t* key, uint8_t* roundkey);
+void EXAES_key_load(const uint8_t* roundkey);
+void EXAES_encrypt_block(uint8_t* block);
+
 #if defined(ECB) && (ECB == 1)
 
 void EXAES_ECB_encrypt(const uint8_t* input, const uint8_t* key, uint8_t *output, const uint32_t length);
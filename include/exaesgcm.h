@@ -0,0 +1,90 @@
+/**
+ * @brief AES-128-GCM authenticated encryption
+ *
+ * @file exaesgcm.h
+ */
+/* -----------------------------------------------------------------------------
+ * Enduro/X Middleware Platform for Distributed Transaction Processing
+ * Copyright (C) 2009-2016, ATR Baltic, Ltd. All Rights Reserved.
+ * Copyright (C) 2017-2019, Mavimax, Ltd. All Rights Reserved.
+ * This software is released under one of the following licenses:
+ * AGPL (with Java and Go exceptions) or Mavimax's license for commercial use.
+ * See LICENSE file for full text.
+ * -----------------------------------------------------------------------------
+ * AGPL license:
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License, version 3 as published
+ * by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License, version 3
+ * for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * -----------------------------------------------------------------------------
+ * A commercial use license is available from Mavimax, Ltd
+ * contact@mavimax.com
+ * -----------------------------------------------------------------------------
+ */
+#ifndef EXAESGCM_H
+#define EXAESGCM_H
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+    
+/*---------------------------Includes-----------------------------------*/
+#include <ndrx_config.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <exaes.h>
+/*---------------------------Externs------------------------------------*/
+/*---------------------------Macros-------------------------------------*/
+#define NDRX_AESGCM_IVLEN       12  /**< nonce length                   */
+#define NDRX_AESGCM_TAGLEN      16  /**< authentication tag length      */
+#define NDRX_AESGCM_KEYLEN      16  /**< AES-128 key length             */
+    
+#define NDRX_AESGCM_NOHW        0x0001 /**< do not use AES-NI/PCLMUL    */
+/*---------------------------Enums--------------------------------------*/
+/*---------------------------Typedefs-----------------------------------*/
+    
+/**
+ * AES-GCM context, key dependent data
+ */
+typedef struct
+{
+    uint8_t roundkey[EXAES_KEYEXPSIZE]; /**< expanded AES key           */
+    uint8_t h[16];                      /**< hash key E(K, 0^128)       */
+    uint64_t hl[16];                    /**< GHASH table, low halves    */
+    uint64_t hh[16];                    /**< GHASH table, high halves   */
+    int is_hw;                          /**< AES-NI/PCLMUL is used      */
+} ndrx_aesgcm_ctx_t;
+    
+/*---------------------------Globals------------------------------------*/
+/*---------------------------Statics------------------------------------*/
+/*---------------------------Prototypes---------------------------------*/
+
+extern NDRX_API int ndrx_aesgcm_hw_supported(void);
+extern NDRX_API void ndrx_aesgcm_init(ndrx_aesgcm_ctx_t *ctx, const uint8_t *key,
+        long flags);
+extern NDRX_API void ndrx_aesgcm_encrypt(ndrx_aesgcm_ctx_t *ctx, const uint8_t *iv,
+        const uint8_t *aad, size_t aadlen, const uint8_t *input, size_t len,
+        uint8_t *output, uint8_t *tag);
+extern NDRX_API int ndrx_aesgcm_decrypt(ndrx_aesgcm_ctx_t *ctx, const uint8_t *iv,
+        const uint8_t *aad, size_t aadlen, const uint8_t *input, size_t len,
+        uint8_t *output, const uint8_t *tag);
+
+#if defined(__cplusplus)
+}
+#endif
+
+
+#endif
+/* vim: set ts=4 sw=4 et smartindent: */
@@ -0,0 +1,69 @@
+/**
+ * @brief Fast LZ77 class block compression (LZ4 block format)
+ *
+ * @file exlz.h
+ */
+/* -----------------------------------------------------------------------------
+ * Enduro/X Middleware Platform for Distributed Transaction Processing
+ * Copyright (C) 2009-2016, ATR Baltic, Ltd. All Rights Reserved.
+ * Copyright (C) 2017-2019, Mavimax, Ltd. All Rights Reserved.
+ * This software is released under one of the following licenses:
+ * AGPL (with Java and Go exceptions) or Mavimax's license for commercial use.
+ * See LICENSE file for full text.
+ * -----------------------------------------------------------------------------
+ * AGPL license:
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License, version 3 as published
+ * by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License, version 3
+ * for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * -----------------------------------------------------------------------------
+ * A commercial use license is available from Mavimax, Ltd
+ * contact@mavimax.com
+ * -----------------------------------------------------------------------------
+ */
+#ifndef EXLZ_H
+#define EXLZ_H
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+
+/*---------------------------Includes-----------------------------------*/
+#include <ndrx_config.h>
+/*---------------------------Externs------------------------------------*/
+/*---------------------------Macros-------------------------------------*/
+
+/** Max compressed size of X bytes (incompressible input) */
+#define NDRX_LZ_BOUND(X) ((X) + (X)/255 + 16)
+
+/*---------------------------Enums--------------------------------------*/
+/*---------------------------Typedefs-----------------------------------*/
+/*---------------------------Globals------------------------------------*/
+/*---------------------------Statics------------------------------------*/
+/*---------------------------Prototypes---------------------------------*/
+
+extern NDRX_API long ndrx_lz_compress(char *src, long src_len,
+        char *dst, long dst_cap);
+
+extern NDRX_API long ndrx_lz_decompress(char *src, long src_len,
+        char *dst, long dst_cap);
+
+#if defined(__cplusplus)
+}
+#endif
+
+
+#endif
+/* vim: set ts=4 sw=4 et smartindent: */
@@ -88,6 +88,11 @@ extern "C" {
 #define NDRX_FPA_SYSBUF_DNUM    10          /**< default cache size             */
 #define NDRX_FPA_SYSBUF_POOLNO    (NDRX_FPA_MAX-1)    /**< pool number of sysbuf*/
     
+#define NDRX_FPA_MAG_MAX        32          /**< max blocks in thread magazine  */
+#define NDRX_FPA_SYSBUF_MAG_MAX 1           /**< sysbufs are big, cache one only*/
+#define NDRX_FPA_ADAPT_WIN      256         /**< pool ops per adapt window      */
+#define NDRX_FPA_ADAPT_MULT     8           /**< max depth, times min blocks    */
+    
 /** print FPA statistics to ULOG  
 #define NDRX_FPA_STATS  1*/
 
@@ -109,6 +109,7 @@ struct ndrx_inicfg
     /* List of resources */
     string_hash_t *resource_hash;
     ndrx_inicfg_file_t *cfgfile;
+    int no_env_subs; /* keep values raw (${ENV} not substituted) */
 };
 
 typedef struct ndrx_inicfg ndrx_inicfg_t;
@@ -125,6 +126,10 @@ extern NDRX_API  int ndrx_inicfg_update_single_file(ndrx_inicfg_t *cfg,
         char *resource, char *fullname, char **section_start_with);
 extern NDRX_API  int ndrx_inicfg_add(ndrx_inicfg_t *cfg, char *resource, char **section_start_with);
 extern NDRX_API  int ndrx_inicfg_reload(ndrx_inicfg_t *cfg, char **section_start_with);
+extern NDRX_API  ndrx_inicfg_file_t * ndrx_inicfg_file_new(ndrx_inicfg_t *cfg, 
+        char *resource, char *fullname, struct stat *attr);
+extern NDRX_API  int ndrx_inicfg_file_keyval_add(ndrx_inicfg_file_t *cf, 
+        char *section, char *key, char *val);
 extern NDRX_API  int ndrx_keyval_hash_add(ndrx_inicfg_section_keyval_t **h, 
             ndrx_inicfg_section_keyval_t *src);
 extern NDRX_API  ndrx_inicfg_section_keyval_t * ndrx_keyval_hash_get(
@@ -74,6 +74,8 @@ extern "C" {
 #define NDRX_LCF_CMD_DISABLE            0   /**< Command is disabled        */
 #define NDRX_LCF_CMD_LOGROTATE          1   /**< Perfrom logrotated         */
 #define NDRX_LCF_CMD_LOGCHG             2   /**< Change logger params       */
+#define NDRX_LCF_CMD_FPASTATS           3   /**< Print FPA stats to ULOG    */
+#define NDRX_LCF_CMD_EXPRSTATS          4   /**< Print UBF expr cache stats */
 #define NDRX_LCF_CMD_MAX_PROD           999 /**< Maximum product command    */    
 #define NDRX_LCF_CMD_MIN_CUST           1000 /**< Minimum user command code */
 #define NDRX_LCF_CMD_MAX_CUST           1999 /**< Maximum user command code */
@@ -81,9 +83,13 @@ extern "C" {
 #define NDRX_LCF_CMDSTR_DISABLE         "disable"
 #define NDRX_LCF_CMDSTR_LOGROTATE       "logrotate"
 #define NDRX_LCF_CMDSTR_LOGCHG          "logchg"    
+#define NDRX_LCF_CMDSTR_FPASTATS        "fpastats"
+#define NDRX_LCF_CMDSTR_EXPRSTATS       "exprstats"
     
 #define NDRX_LCF_SLOT_LOGROTATE         0   /**< Default command slot for logrotate */
 #define NDRX_LCF_SLOT_LOGCHG            1   /**< Default slot for log re-configure  */
+#define NDRX_LCF_SLOT_FPASTATS          2   /**< Default slot for FPA stats         */
+#define NDRX_LCF_SLOT_EXPRSTATS         3   /**< Default slot for expr cache stats  */
 
 #define NDRX_NAME_MAX			64  /**< Name max	*/
     
@@ -184,13 +184,13 @@ extern NDRX_API volatile int G_ndrx_debug_first;
     {__ndrx_debug__(&G_ndrx_debug, lev, __FILE__, __LINE__, __func__, fmt, ##__VA_ARGS__);}} while (0)
 
 #define NDRX_LOGEX(lev, file, line, fmt, ...) do {NDRX_DBG_INIT_ENTRY; if (lev<=G_ndrx_debug.level)\
-    {__ndrx_debug__(&G_ndrx_debug, lev, file, line, __func__, fmt, ##__VA_ARGS__);}} while (0)
+    {__ndrx_debugex__(&G_ndrx_debug, lev, file, line, __func__, fmt, ##__VA_ARGS__);}} while (0)
 
 #define UBF_LOG(lev, fmt, ...) do {NDRX_DBG_INIT_ENTRY; if (lev<=G_ubf_debug.level)\
     {__ndrx_debug__(&G_ubf_debug, lev, __FILE__, __LINE__, __func__, fmt, ##__VA_ARGS__);}} while (0)
 
 #define UBF_LOGEX(lev, file, line, fmt, ...) do {NDRX_DBG_INIT_ENTRY; if (lev<=G_ubf_debug.level)\
-    {__ndrx_debug__(&G_ubf_debug, lev, file, line, __func__, fmt, ##__VA_ARGS__);}} while (0)
+    {__ndrx_debugex__(&G_ubf_debug, lev, file, line, __func__, fmt, ##__VA_ARGS__);}} while (0)
 
 /* User logging */
 #define TP_LOG(lev, fmt, ...) do {NDRX_DBG_INIT_ENTRY; if (lev<=G_tp_debug.level)\
@@ -198,7 +198,7 @@ extern NDRX_API volatile int G_ndrx_debug_first;
 
 /* Extended user logging, with filename name and line */
 #define TP_LOGEX(lev, file, line, fmt, ...) do {NDRX_DBG_INIT_ENTRY; if (lev<=G_tp_debug.level)\
-    {__ndrx_debug__(&G_tp_debug, lev, file, line, __func__, fmt, ##__VA_ARGS__);}} while (0)
+    {__ndrx_debugex__(&G_tp_debug, lev, file, line, __func__, fmt, ##__VA_ARGS__);}} while (0)
 
 #define TP_LOGGETIFLAGS do {NDRX_DBG_INIT_ENTRY; return G_tp_debug.iflags; } while (0)
 
@@ -423,6 +423,8 @@ extern NDRX_API ndrx_debug_t * debug_get_tp_ptr(void);
 
 extern NDRX_API void __ndrx_debug__(ndrx_debug_t *dbg_ptr, int lev, const char *file, 
         long line, const char *func, char *fmt, ...);
+extern NDRX_API void __ndrx_debugex__(ndrx_debug_t *dbg_ptr, int lev, const char *file, 
+        long line, const char *func, char *fmt, ...);
 
 extern NDRX_API void __ndrx_debug_dump_diff__(ndrx_debug_t *dbg_ptr, int lev, const char *file, 
         long line, const char *func, char *comment, void *ptr, void *ptr2, long len);
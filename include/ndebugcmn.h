@@ -92,6 +92,7 @@ typedef struct
     char iflags[16];        /**< integration flags                          */
     int is_threaded;        /**< are we separating logs by threads?         */
     int is_mkdir;           /**< shall we create directory if we get ENOFILE err */
+    int is_binary;          /**< binary trace records, text done by decoder */
     unsigned threadnr;      /**< thread number to which we are logging      */
     long flags;             /**< logger code initially                      */
     long swait;             /**< sync wait for close log files, ms          */
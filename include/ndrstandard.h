@@ -314,6 +314,12 @@ extern NDRX_API size_t ndrx_strnlen(char *str, size_t max);
 #define CONF_NDRX_RTSVCMAX       "NDRX_RTSVCMAX"
 
 #define CONF_NDRX_CLTMAX         "NDRX_CLTMAX"     /**< Max number of client, cpm */
+#define CONF_NDRX_LMSGPOOL       "NDRX_LMSGPOOL"   /**< Large message pool slabs, 0 - off */
+#define CONF_NDRX_LMSGTHRES      "NDRX_LMSGTHRES"  /**< Min buffer size for the pool */
+#define CONF_NDRX_LMSGTHRES_DFLT  65536            /**< Default pool threshold   */
+#define CONF_NDRX_CMPCTHDR       "NDRX_CMPCTHDR"   /**< Max payload for compact call header, 0 - off */
+#define CONF_NDRX_CONVPOOL       "NDRX_CONVPOOL"   /**< Pooled conversation queues, 0 - off */
+#define CONF_NDRX_TRACESAMPLE    "NDRX_TRACESAMPLE" /**< Trace every Nth root call, 0 - off */
 #define CONF_NDRX_CONFIG         "NDRX_CONFIG"
 #define CONF_NDRX_QPATH          "NDRX_QPATH"
 #define CONF_NDRX_SHMPATH        "NDRX_SHMPATH"
@@ -388,6 +394,9 @@ extern NDRX_API size_t ndrx_strnlen(char *str, size_t max);
 /** Feedback pool allocator options */
 #define CONF_NDRX_FPAOPTS               "NDRX_FPAOPTS"
     
+/** tpencrypt() data format: CBC (default) or GCM */
+#define CONF_NDRX_CRYPTOMODE            "NDRX_CRYPTOMODE"
+    
 /** Stack size for new threads produced by Enduro/X in kilobytes */
 #define CONF_NDRX_THREADSTACKSIZE       "NDRX_THREADSTACKSIZE"
 
@@ -538,6 +547,18 @@ extern NDRX_API size_t ndrx_strnlen(char *str, size_t max);
 #define NDRX_SHM_ROUTSVC_SFX     "shm,routsvc"        /**< Routing services              */
 #define NDRX_SHM_ROUTSVC         "%s," NDRX_SHM_ROUTSVC_SFX
 #define NDRX_SHM_ROUTSVC_KEYOFSZ    8                 /**< IPC Key offset                */
+
+#define NDRX_SHM_LMSG_SFX        "shm,lmsg"           /**< Large message pool            */
+#define NDRX_SHM_LMSG            "%s," NDRX_SHM_LMSG_SFX
+#define NDRX_SHM_LMSG_KEYOFSZ       9                 /**< IPC Key offset                */
+
+#define NDRX_SHM_CACHESF_SFX     "shm,cachesf"        /**< Cache in-flight keys          */
+#define NDRX_SHM_CACHESF         "%s," NDRX_SHM_CACHESF_SFX
+#define NDRX_SHM_CACHESF_KEYOFSZ    10                /**< IPC Key offset                */
+
+#define NDRX_SHM_CALLTRACE_SFX   "shm,calltrace"      /**< Completed call traces         */
+#define NDRX_SHM_CALLTRACE       "%s," NDRX_SHM_CALLTRACE_SFX
+#define NDRX_SHM_CALLTRACE_KEYOFSZ  11                /**< IPC Key offset                */
     
 #define NDRX_SEM_SVCOP          "%s,sem,svcop"      /**< Service operations...         */
 
@@ -67,6 +67,14 @@ extern "C" {
 #define SANITY_CNT_START           0  /**< Reset value of cycle counter        */
     
 #define MAX_SERVICE_LIST         1024 /**< MAX list of exportsvcs */
+
+/* Queue types known to sanity checks: */
+#define NDRXD_QOWNER_OTHER         0  /**< Not checked (service q, etc.)      */
+#define NDRXD_QOWNER_CLT           1  /**< Client reply queue                 */
+#define NDRXD_QOWNER_XADMIN        2  /**< xadmin reply queue                 */
+#define NDRXD_QOWNER_SRV           3  /**< Server reply queue                 */
+#define NDRXD_QOWNER_CNVCLT        4  /**< Conversation initiator queue       */
+#define NDRXD_QOWNER_CNVSRV        5  /**< Conversation server queue          */
 /*---------------------------Enums--------------------------------------*/
 /*---------------------------Typedefs-----------------------------------*/
 
@@ -121,6 +129,7 @@ struct conf_server_node
     int mindispatchthreads; /**< minimum dispatch threads                     */
     int maxdispatchthreads; /**< maximum dispatch threads                     */
     int threadstacksize;    /**< thread stack size in KB, 0 - default         */
+    int boottier;           /**< parallel boot tier, -1 - entry only          */
     
     /* have entries for environment */
     
@@ -271,6 +280,7 @@ typedef struct
     char default_rqaddr[MAXTIDENT+1];	/**< Default request address */
     
     int ddrreload;     /**< rote reload setting schedule upload if previous was loaded */
+    int bootparallel;  /**< max number of servers booting at the same time */
     
     long default_rssmax; /**< Default max resource memory size in bytes, -1 nochk */
     long default_vszmax; /**< Default max virtual memory size in bytes, -1 nochk */
@@ -407,6 +417,15 @@ extern int do_sanity_check(int isfinal);
 extern int self_notify(srv_status_t *status, int block);
 extern int remove_server_queues(char *process, pid_t pid, int srv_id, char *rplyq);
 
+/* Queue owner registry */
+extern int ndrx_qowner_seen(char *qname, unsigned sanity_cycle);
+extern int ndrx_qowner_add(char *qname, int qtype, pid_t pid, char *procname,
+        unsigned sanity_cycle);
+extern void ndrx_qowner_purge(unsigned sanity_cycle);
+extern int ndrx_qowner_check(unsigned sanity_cycle, int fullchk,
+        int (*p_dead_q)(char *qname, int qtype));
+extern void ndrx_qowner_free(void);
+
 /* Restart */
 extern int do_restart_actions(void);
 extern int do_restart_chk(void);
@@ -166,8 +166,11 @@ extern "C" {
     
 #define NDRXD_COM_BRCONINFO_RQ      74   /**< return bridge connection infos, req int */
 #define NDRXD_COM_BRCONINFO_RP      75   /**< return bridge connection infos, rsp int */
+    
+#define NDRXD_COM_BRCREDIT_RQ       76   /**< bridge flow control credits, req int  */
+#define NDRXD_COM_BRCREDIT_RP       77   /**< bridge flow control credits, rsp int  */
 
-#define NDRXD_COM_MAX               75
+#define NDRXD_COM_MAX               77
     
 /** This is sqv admin thread shutdown priv */
 #define NDRXD_COM_SVQADMIN_PRIV     NDRX_COM_SVQ_PRIV
@@ -234,6 +237,7 @@ extern "C" {
 #define NDRXD_CALL_TYPE_DSLEEP          19  /**< Put NDRXD in sleep mode      */
 #define NDRXD_CALL_TYPE_BLIST           20  /**< List bridge admin queues     */
 #define NDRXD_CALL_TYPE_BRCONINFO       21  /**< Connection info messages     */
+#define NDRXD_CALL_TYPE_BRCREDIT        22  /**< Bridge flow control credits  */
 
 #define NDRXD_SRC_NDRXD                 0   /**< Call source is daemon       */
 #define NDRXD_SRC_ADMIN                 1   /**< Call source is admin utility*/
@@ -280,6 +284,7 @@ extern "C" {
  * Indicates service info entry state.
  */
 #define NDRXD_SVCINFO_INIT              0x00000001  /**< initialized          */
+#define NDRXD_SVCINFO_CMPCTHDR          0x00000002  /**< local servers decode compact call hdr */
 
 
 #define NDRXD_SVC_STATUS_AVAIL          0       /**< Service is available     */
@@ -586,8 +591,20 @@ typedef struct
     long orig_seq;           /**< sequence number for the request (if with reply         */
     int orig_nodeid;    /**< originator of the message (or caller in case of reply  */
     time_t orig_timestamp;/**< Originatic clock (for the reply match)               */
+    int cmpr;           /**< Sender accepts compressed frames (is configured)       */
+    int credits;        /**< Credit window granted to receiver, 0 - no flow control */
 } cmd_br_time_sync_t;
 
+/**
+ * Flow control credits granted to peer bridge, sent as requests
+ * are drained from the receiving bridge.
+ */
+typedef struct
+{
+    command_call_t call;
+    int credits;        /**< Number of credits returned to the sender   */
+} cmd_br_credit_t;
+
 /**
  * Generic handler for bridge message
  */
@@ -700,6 +717,20 @@ typedef struct
     long timediffms; /**< time diff in milliseconds between hosts */
     long roundtrip; /**< roundtrip in milliseconds          */
     
+    /* Compression infos: */
+    char cmpr;      /**< Y - compression active, N - not    */
+    long cmprin;    /**< bytes before compression (out)    */
+    long cmprout;   /**< bytes after compression (out)     */
+    long cmprusec;  /**< CPU time compressing, microsec     */
+    long dcmprusec; /**< CPU time decompressing, microsec   */
+    
+    /* Flow control infos: */
+    int crwindow;   /**< Credits granted to peer, 0 - off   */
+    int crpeer;     /**< Credits granted by peer, 0 - off   */
+    int cravail;    /**< Credits available for sending     */
+    long crwaits;   /**< Calls waited for the credit        */
+    long crrejects; /**< Calls rejected with no credit      */
+    
 } command_reply_brconinfo_t;
 
 
@@ -40,6 +40,7 @@ extern "C" {
 #endif
 
 /*---------------------------Includes-----------------------------------*/
+#include <stdint.h>
 #include <ndrstandard.h>
 #include <inicfg.h>
 #include <sys_primitives.h>
@@ -76,6 +77,14 @@ struct  ndrx_fpastack
     volatile long allocs;            /**< number of allocs done, for stats           */
     volatile ndrx_fpablock_t *stack; /**< stack head                                 */
     NDRX_SPIN_LOCKDECL(spinlock);    /**< spinlock for protecting given size         */
+    int mag_size;                    /**< thread magazine size, 0 - not used         */
+    volatile int lim_blocks;         /**< adaptive limit of blocks in the pool       */
+    volatile long hits;              /**< allocs served from cache                   */
+    volatile long misses;            /**< allocs served by malloc                    */
+    volatile long contention;        /**< spinlock was busy at lock                  */
+    volatile long trims;             /**< blocks given back to system                */
+    int win_ops;                     /**< pool operations in adapt window            */
+    int win_misses;                  /**< misses in adapt window                     */
 };
 
 /**
@@ -109,10 +118,24 @@ typedef struct
     
     int org_is_mkdir;   /**< initial setting of mkdir, used for logrotate      */
     int org_buffer_size;/**< initail setting of io buffer size                 */
+    
+    void *bin_strs;     /**< binary trace interned strings, opaque             */
+    unsigned bin_nextid;/**< binary trace next string id                       */
+    pid_t bin_pid;      /**< binary trace session pid, 0 - no session          */
     EX_hash_handle hh; /**< makes this structure hashable                      */
     
 } ndrx_debug_file_sink_t;
 
+/**
+ * Attached common-config snapshot (see cconfsnap.c)
+ */
+typedef struct
+{
+    char *mem;          /**< read only mapping of the snapshot file         */
+    size_t len;         /**< mapping len                                    */
+    uint64_t gen;       /**< publish generation                             */
+} ndrx_ccsnap_t;
+
 /*---------------------------Globals------------------------------------*/
 /*---------------------------Statics------------------------------------*/
 /*---------------------------Prototypes---------------------------------*/
@@ -121,6 +144,7 @@ extern NDRX_API int ndrx_inicfg_get_subsect_int(ndrx_inicfg_t *cfg,
         char **resources, char *section, ndrx_inicfg_section_keyval_t **out);
 
 extern NDRX_API void ndrx_fpstats(int poolno, ndrx_fpapool_t *p_stats);
+extern NDRX_API void ndrx_fpstats_ulog(char *fbackmsg, size_t fbackmsgsz);
 
 extern NDRX_API void ndrx_init_fail_banner(void);
 
@@ -148,6 +172,23 @@ extern NDRX_API int ndrx_init_parse_line(char *in_tok1, char *in_tok2, int *p_fi
 extern NDRX_API void ndrx_debug_lock(ndrx_debug_file_sink_t* mysink);
 extern NDRX_API void ndrx_debug_unlock(ndrx_debug_file_sink_t* mysink);
 
+/* binary trace: */
+extern NDRX_API int ndrx_dbgbin_log(ndrx_debug_t *dbg_ptr, int lev, const char *file, 
+        int file_lit, long line, const char *func, uint64_t ostid, long thread_nr, 
+        char *fmt, va_list ap);
+extern NDRX_API int ndrx_dbgbin_dump(ndrx_debug_t *dbg_ptr, void *ptr, void *ptr2, 
+        long len);
+extern NDRX_API void ndrx_dbgbin_sink_reset(ndrx_debug_file_sink_t *sink);
+extern NDRX_API int ndrx_dbgbin_decode(FILE *in, FILE *out);
+
+extern NDRX_API ndrx_ccsnap_t *ndrx_ccsnap_attach(char *path, char **resources);
+extern NDRX_API void ndrx_ccsnap_detach(ndrx_ccsnap_t *snap);
+extern NDRX_API int ndrx_ccsnap_load(ndrx_ccsnap_t *snap, ndrx_inicfg_t *cfg, 
+        char **section_start_with);
+extern NDRX_API int ndrx_ccsnap_gen_get(char *path, uint64_t *gen);
+extern NDRX_API int ndrx_ccsnap_write(char *path, char **resources, 
+        char **sections);
+
 
 #ifdef	__cplusplus
 }
@@ -49,6 +49,9 @@ extern "C" {
 #define NDRX_SEM_SV5LOCKS            1   /**< System V message queue lockings           */
 #define NDRX_SEM_CPMLOCKS            2   /**< Client process monitor shm lock           */
 #define NDRX_SEM_LCFLOCKS            3   /**< Latent command framework locks            */
+#define NDRX_SEM_LMSGLOCKS           4   /**< Large message pool locks                  */
+#define NDRX_SEM_CACHESFLOCKS        5   /**< Cache in-flight table locks               */
+#define NDRX_SEM_CALLTRACELOCKS      6   /**< Call trace ring locks                     */
     
 #define NDRX_SEM_TYP_READ            0   /**< RW Lock - Read                */
 #define NDRX_SEM_TYP_WRITE           1   /**< RW Lock - Write               */
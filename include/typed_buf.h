@@ -73,10 +73,21 @@ extern "C" {
 /* others: VIEW X_COMMON X_C_TYPE X_OCTET FML32 VIEW32 - not supported currently */
 /* see G_buf_descr */
 #define BUF_IS_TYPEID_VALID(X) (BUF_TYPE_MIN<=X && X <= BUF_TYPE_MAX)
+
+/**
+ * Size of the hidden header in front of the user data. Rounded to 16 bytes,
+ * so that user data keeps the malloc() alignment.
+ */
+#define NDRX_TPBUF_HDRSIZE      ((sizeof(buffer_obj_t)+15) & ~((size_t)15))
+
+/**
+ * Get the buffer object from the user data pointer. Only for pointers
+ * already validated by ndrx_find_buffer().
+ */
+#define NDRX_TPBUF_OBJ(X)       ((buffer_obj_t *)((char *)(X) - NDRX_TPBUF_HDRSIZE))
 /*---------------------------Enums--------------------------------------*/
 /*---------------------------Typedefs-----------------------------------*/
 /*---------------------------Globals------------------------------------*/
-extern NDRX_API buffer_obj_t *ndrx_G_buffers;
 extern NDRX_API typed_buffer_descr_t G_buf_descr[];
 /*---------------------------Statics------------------------------------*/
 /*---------------------------Prototypes---------------------------------*/
@@ -88,6 +99,12 @@ extern NDRX_API buffer_obj_t * ndrx_find_buffer(char *ptr);
 extern NDRX_API typed_buffer_descr_t * ndrx_get_buffer_descr(char *type, 
         char *subtype);
 
+/* memory for the type handlers, with hidden header */
+extern NDRX_API char * ndrx_tpbuf_malloc(long len);
+extern NDRX_API char * ndrx_tpbuf_calloc(long len);
+extern NDRX_API char * ndrx_tpbuf_realloc(char *buf, long len);
+extern NDRX_API void ndrx_tpbuf_free(char *buf);
+
 /*extern NDRX_API void free_up_buffers(void);*/
 
 /* UBF support */
@@ -139,6 +139,9 @@ typedef int BFLDOCC;
 
 typedef struct Ubfh UBFH;
 
+/** Bulk buffer builder handle, see Bbldnew() */
+typedef struct ndrx_ubf_bld Bbld_t;
+
 /* Bnext state struct */
 struct Bnext_state
 {
@@ -159,6 +162,21 @@ struct Bvnext_state
 };
 typedef struct Bvnext_state Bvnext_state_t;
 
+/**
+ * Bgetmulti()/Bchgmulti() item. Items must be sorted by field id and
+ * occurrence.
+ */
+typedef struct
+{
+    BFLDID bfldid;      /**< field id                                       */
+    BFLDOCC occ;        /**< occurrence                                     */
+    int usrtype;        /**< user type of buf (BFLD_*), -1 field's type     */
+    char *buf;          /**< value to read to / change from                 */
+    BFLDLEN len;        /**< get: in buf size (0 not checked), out data len
+                         * (also if 0 given), chg: carray len               */
+    int err;            /**< out: 0 or B* error of the item                 */
+} Bfld_multi_t;
+
 /* get_loc state info */
 typedef struct
 {
@@ -259,6 +277,17 @@ extern NDRX_API int Bcmp(UBFH *p_ubf1, UBFH *p_ubf2);
 extern NDRX_API int Bsubset(UBFH *p_ubf1, UBFH *p_ubf2);
 extern NDRX_API BFLDOCC Bnum (UBFH * p_ub);
 extern NDRX_API long Bneeded(BFLDOCC nrfields, BFLDLEN totsize);
+extern NDRX_API int Bgetmulti(UBFH *p_ub, Bfld_multi_t *items, int n);
+extern NDRX_API int Bchgmulti(UBFH *p_ub, Bfld_multi_t *items, int n);
+
+/* Bulk builder */
+extern NDRX_API Bbld_t * Bbldnew(BFLDOCC nrfields, BFLDLEN totsize);
+extern NDRX_API int Bbldadd(Bbld_t *bld, BFLDID bfldid, char *buf, BFLDLEN len);
+extern NDRX_API int Bbldchg(Bbld_t *bld, BFLDID bfldid, BFLDOCC occ, char *buf, BFLDLEN len);
+extern NDRX_API long Bbldsize(Bbld_t *bld);
+extern NDRX_API int Bbldfinal(Bbld_t *bld, UBFH *p_ub);
+extern NDRX_API void Bbldreset(Bbld_t *bld);
+extern NDRX_API void Bbldfree(Bbld_t *bld);
 
 /* VIEW related */
 extern NDRX_API int Bvnull(char *cstruct, char *cname, BFLDOCC occ, char *view);
@@ -45,6 +45,7 @@ extern "C" {
 #include <stdio.h>
 #include <exhash.h>
 #include <ndrstandard.h>
+#include <regex.h>
 /*---------------------------Externs------------------------------------*/
 /*---------------------------Macros-------------------------------------*/
 #define UBFFLDMAX	BF_LENGTH
@@ -56,6 +57,7 @@ extern "C" {
     
 #define CONF_VIEWFILES  "VIEWFILES"         /* List of view files to load      */
 #define CONF_VIEWDIR    "VIEWDIR"           /* Folders with view files stored, ':' - sep   */
+#define CONF_NDRX_UBFEXPRCACHE  "NDRX_UBFEXPRCACHE" /* Max compiled expressions cached */
     
 #define UBFDEBUGLEV "UBF_E_"
 
@@ -146,6 +148,10 @@ extern "C" {
     __p_bufsz = __buf_size__;\
 }
 
+#define NDRX_UBFEXPRC_DFLT      128 /**< Default expression cache size      */
+#define NDRX_UBFEXPRC_UBF       'U' /**< Compiled UBF boolean expression    */
+#define NDRX_UBFEXPRC_REGEX     'R' /**< Compiled regular expression        */
+
 /*---------------------------Enums--------------------------------------*/
 /*---------------------------Typedefs-----------------------------------*/
 
@@ -156,12 +162,35 @@ typedef float UBF_FLOAT;
 typedef long UBF_LONG;
 typedef char UBF_CHAR;
 
+/**
+ * Compiled expression cache entry. Entry is shared by the threads,
+ * the compiled data is read only.
+ */
+typedef struct ndrx_ubf_exprc ndrx_ubf_exprc_t;
+struct ndrx_ubf_exprc
+{
+    char *key;              /**< kind + expression text                 */
+    int kind;               /**< NDRX_UBFEXPRC_* type                   */
+    char *tree;             /**< compiled UBF expression                */
+    regex_t re;             /**< compiled regex                         */
+    int refcnt;             /**< number of users                        */
+    int cached;             /**< entry is in the cache                  */
+    ndrx_ubf_exprc_t *prev, *next;  /**< LRU list, most recent first    */
+    EX_hash_handle hh;      /**< hash by key                            */
+};
+
 /*---------------------------Globals------------------------------------*/
 /*---------------------------Statics------------------------------------*/
 /*---------------------------Prototypes---------------------------------*/
 extern NDRX_API void ndrx_build_printable_string(char *out, int out_len, char *in, 
         int in_len);
 
+extern NDRX_API ndrx_ubf_exprc_t* ndrx_ubf_exprc_get(int kind, char *expr);
+extern NDRX_API void ndrx_ubf_exprc_release(ndrx_ubf_exprc_t *ent);
+extern NDRX_API void ndrx_ubf_exprc_stats(long *p_hits, long *p_misses, 
+        long *p_evictions, int *p_entries);
+extern NDRX_API void ndrx_ubf_exprc_stats_ulog(char *msg, size_t msgsz);
+
 
 #ifdef	__cplusplus
 }
@@ -263,8 +263,8 @@ extern "C" {
 #define	TPQTOP		0x00040		/**< RFU, enqueue at queue top */
 #define	TPQWAIT		0x00080		/**< RFU, wait for dequeuing */		
 #define	TPQREPLYQ	0x00100		/**< set/get reply queue */		
-#define	TPQTIME_ABS	0x00200		/**< RFU, set absolute time */		
-#define	TPQTIME_REL	0x00400		/**< RFU, set absolute time */		
+#define	TPQTIME_ABS	0x00200		/**< set absolute dequeue time */		
+#define	TPQTIME_REL	0x00400		/**< set relative dequeue time */		
 #define	TPQGETBYCORRIDOLD 0x00800	/**< deprecated */		
 #define	TPQPEEK		0x01000		/**< peek */		
 #define TPQDELIVERYQOS  0x02000         /**< RFU, delivery quality of service */		
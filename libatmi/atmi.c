@@ -1066,6 +1066,17 @@ expublic tp_command_call_t *ndrx_get_G_last_call(void)
     return &G_atmi_tls->G_last_call;
 }
 
+/**
+ * Trace of the call being served
+ * @return ptr to TLS trace, trace_id 0 - not traced
+ */
+expublic ndrx_trace_t *ndrx_get_G_last_trace(void)
+{
+    ATMI_TLS_ENTRY;
+    
+    return &G_atmi_tls->G_last_trace;
+}
+
 /**
  * Access to atmi lib conf
  * @return 
@@ -461,6 +461,11 @@ expublic int ndrx_cache_edb_del (ndrx_tpcache_db_t *db, EDB_txn *txn,
     
     KEY_DO_ALIGN;
     
+    if ((db->flags & NDRX_TPCACHE_FLAGS_INDEX) &&
+            EXSUCCEED!=(ret=ndrx_cache_idx_del(db, txn, key, data)))
+    {
+        goto out;
+    }
             
     if (EXSUCCEED!=(ret=edb_del(txn, db->dbi, &keydb, data)))
     {
@@ -494,6 +499,12 @@ expublic int ndrx_cache_edb_delfullkey (ndrx_tpcache_db_t *db, EDB_txn *txn,
         EDB_val *keydb, EDB_val *data)
 {
     int ret = EXSUCCEED;
+    
+    if ((db->flags & NDRX_TPCACHE_FLAGS_INDEX) &&
+            EXSUCCEED!=(ret=ndrx_cache_idx_del(db, txn, keydb->mv_data, data)))
+    {
+        goto out;
+    }
             
     if (EXSUCCEED!=(ret=edb_del(txn, db->dbi, keydb, data)))
     {
@@ -535,6 +546,14 @@ expublic int ndrx_cache_edb_put (ndrx_tpcache_db_t *db, EDB_txn *txn,
     
     KEY_DO_ALIGN;
     
+    /* replaced record (no dups) leaves its index entries */
+    if ((db->flags & NDRX_TPCACHE_FLAGS_INDEX) &&
+            !(db->flags & NDRX_TPCACHE_FLAGS_TIMESYNC) &&
+            EXSUCCEED!=(ret=ndrx_cache_idx_del(db, txn, key, NULL)))
+    {
+        goto out;
+    }
+    
     if (EXSUCCEED!=(ret=edb_put(txn, db->dbi, &keydb, data, flags)))
     {
         if (ignore_err)
@@ -548,6 +567,12 @@ expublic int ndrx_cache_edb_put (ndrx_tpcache_db_t *db, EDB_txn *txn,
                 "Failed to to put to db [%s] key [%s], data: %p: %s", 
                 db->cachedb, key, data, edb_strerror(ret));
         }
+        goto out;
+    }
+    
+    if (db->flags & NDRX_TPCACHE_FLAGS_INDEX)
+    {
+        ret=ndrx_cache_idx_add(db, txn, key, data);
     }
 out:
     
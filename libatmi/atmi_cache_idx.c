@@ -0,0 +1,462 @@
+/**
+ * @brief ATMI level cache - time/rank index of cache db records
+ *   For dbs flagged with `index' every record gets entries in the "<db>.idx"
+ *   named db of the same environment. Entry key is type byte, two big endian
+ *   64bit values and hash of the cache key (so that it sorts by value), entry
+ *   value is the cache key. Types: 'E' put time (expiry/fifo), 'L' last hit
+ *   time (lru) and 'H' hits+last hit time (hits). Entries are maintained by
+ *   the ndrx_cache_edb_put/del wrappers in the same transaction as the
+ *   record, thus tpcached may pop oldest/least used records without scanning
+ *   and sorting the whole db.
+ *
+ * @file atmi_cache_idx.c
+ */
+/* -----------------------------------------------------------------------------
+ * Enduro/X Middleware Platform for Distributed Transaction Processing
+ * Copyright (C) 2009-2016, ATR Baltic, Ltd. All Rights Reserved.
+ * Copyright (C) 2017-2019, Mavimax, Ltd. All Rights Reserved.
+ * This software is released under one of the following licenses:
+ * AGPL (with Java and Go exceptions) or Mavimax's license for commercial use.
+ * See LICENSE file for full text.
+ * -----------------------------------------------------------------------------
+ * AGPL license:
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License, version 3 as published
+ * by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License, version 3
+ * for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * -----------------------------------------------------------------------------
+ * A commercial use license is available from Mavimax, Ltd
+ * contact@mavimax.com
+ * -----------------------------------------------------------------------------
+ */
+#include <ndrx_config.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <stdint.h>
+#include <ndrstandard.h>
+#include <atmi.h>
+#include <atmi_tls.h>
+
+#include "userlog.h"
+#include <atmi_cache.h>
+/*---------------------------Externs------------------------------------*/
+/*---------------------------Macros-------------------------------------*/
+#define IDX_MAX_ENTRIES     3       /**< Max index entries per record     */
+/*---------------------------Enums--------------------------------------*/
+/*---------------------------Typedefs-----------------------------------*/
+/*---------------------------Globals------------------------------------*/
+/*---------------------------Statics------------------------------------*/
+/*---------------------------Prototypes---------------------------------*/
+
+/**
+ * Write big endian 64bit value
+ * @param p output
+ * @param v value
+ */
+exprivate void idx_put64(unsigned char *p, uint64_t v)
+{
+    int i;
+    
+    for (i=7; i>=0; i--)
+    {
+        p[i] = (unsigned char)(v & 0xff);
+        v>>=8;
+    }
+}
+
+/**
+ * Read big endian 64bit value
+ * @param p input
+ * @return value
+ */
+exprivate uint64_t idx_get64(unsigned char *p)
+{
+    uint64_t v = 0;
+    int i;
+    
+    for (i=0; i<8; i++)
+    {
+        v = (v<<8) | p[i];
+    }
+    
+    return v;
+}
+
+/**
+ * Build index entry key
+ * @param out output buffer of NDRX_TPCACHE_IDX_KEYLEN bytes
+ * @param type entry type
+ * @param v1 primary sort value
+ * @param v2 secondary sort value
+ * @param key cache key
+ */
+exprivate void idx_mkkey(unsigned char *out, char type, long v1, long v2, 
+        char *key)
+{
+    uint64_t h = 14695981039346656037ULL;
+    
+    while (EXEOS!=*key)
+    {
+        h^=(unsigned char)*key++;
+        h*=1099511628211ULL;
+    }
+    
+    out[0] = (unsigned char)type;
+    idx_put64(out+1, (uint64_t)v1);
+    idx_put64(out+9, (uint64_t)v2);
+    idx_put64(out+17, h);
+}
+
+/**
+ * Build the index entry keys of the db record
+ * @param db cache db
+ * @param key cache key
+ * @param data db record
+ * @param out output keys
+ * @return number of entries built
+ */
+exprivate int idx_entries(ndrx_tpcache_db_t *db, char *key, EDB_val *data,
+        unsigned char out[][NDRX_TPCACHE_IDX_KEYLEN])
+{
+    ndrx_tpcache_data_t hdr;
+    int n = 0;
+    
+    if (data->mv_size < sizeof(hdr))
+    {
+        NDRX_LOG(log_warn, "%s: db [%s] key [%s] record too short (%ld) - "
+                "not indexed", __func__, db->cachedb, key, (long)data->mv_size);
+        return 0;
+    }
+    
+    /* db data might be unaligned */
+    memcpy(&hdr, data->mv_data, sizeof(hdr));
+    
+    if (db->flags & (NDRX_TPCACHE_FLAGS_EXPIRY|NDRX_TPCACHE_FLAGS_FIFO))
+    {
+        idx_mkkey(out[n++], NDRX_TPCACHE_IDX_PUT, hdr.t, hdr.tusec, key);
+    }
+    
+    if (db->flags & NDRX_TPCACHE_FLAGS_LRU)
+    {
+        idx_mkkey(out[n++], NDRX_TPCACHE_IDX_LRU, hdr.hit_t, hdr.hit_tusec, key);
+    }
+    
+    if (db->flags & NDRX_TPCACHE_FLAGS_HITS)
+    {
+        idx_mkkey(out[n++], NDRX_TPCACHE_IDX_HITS, hdr.hits, hdr.hit_t, key);
+    }
+    
+    return n;
+}
+
+/**
+ * Add index entries for db record
+ * @param db cache db
+ * @param txn transaction
+ * @param key cache key
+ * @param data db record
+ * @return EXSUCCEED/edb error
+ */
+expublic int ndrx_cache_idx_add(ndrx_tpcache_db_t *db, EDB_txn *txn,
+        char *key, EDB_val *data)
+{
+    int ret = EXSUCCEED;
+    unsigned char ent[IDX_MAX_ENTRIES][NDRX_TPCACHE_IDX_KEYLEN];
+    int n;
+    int i;
+    EDB_val ikey, ival;
+    
+    n = idx_entries(db, key, data, ent);
+    
+    for (i=0; i<n; i++)
+    {
+        ikey.mv_data = ent[i];
+        ikey.mv_size = NDRX_TPCACHE_IDX_KEYLEN;
+        ival.mv_data = key;
+        ival.mv_size = strlen(key)+1;
+        
+        if (EXSUCCEED!=(ret=edb_put(txn, db->idxdbi, &ikey, &ival, 0)))
+        {
+            NDRX_CACHE_TPERROR(ndrx_cache_maperr(ret), 
+                "Failed to put index entry of db [%s] key [%s]: %s", 
+                db->cachedb, key, edb_strerror(ret));
+            goto out;
+        }
+    }
+    
+out:
+    return ret;
+}
+
+/**
+ * Remove index entries of single record
+ * @param db cache db
+ * @param txn transaction
+ * @param key cache key
+ * @param data db record
+ * @return EXSUCCEED/edb error
+ */
+exprivate int idx_del_rec(ndrx_tpcache_db_t *db, EDB_txn *txn,
+        char *key, EDB_val *data)
+{
+    int ret = EXSUCCEED;
+    unsigned char ent[IDX_MAX_ENTRIES][NDRX_TPCACHE_IDX_KEYLEN];
+    int n;
+    int i;
+    EDB_val ikey;
+    
+    n = idx_entries(db, key, data, ent);
+    
+    for (i=0; i<n; i++)
+    {
+        ikey.mv_data = ent[i];
+        ikey.mv_size = NDRX_TPCACHE_IDX_KEYLEN;
+        
+        if (EXSUCCEED!=(ret=edb_del(txn, db->idxdbi, &ikey, NULL)))
+        {
+            if (EDB_NOTFOUND==ret)
+            {
+                ret = EXSUCCEED;
+            }
+            else
+            {
+                NDRX_CACHE_TPERROR(ndrx_cache_maperr(ret), 
+                    "Failed to delete index entry of db [%s] key [%s]: %s", 
+                    db->cachedb, key, edb_strerror(ret));
+                goto out;
+            }
+        }
+    }
+    
+out:
+    return ret;
+}
+
+/**
+ * Remove index entries of the record(s)
+ * @param db cache db
+ * @param txn transaction
+ * @param key cache key
+ * @param data particular record, or NULL for all records of the key
+ * @return EXSUCCEED/edb error
+ */
+expublic int ndrx_cache_idx_del(ndrx_tpcache_db_t *db, EDB_txn *txn,
+        char *key, EDB_val *data)
+{
+    int ret = EXSUCCEED;
+    EDB_cursor *cursor;
+    int cursor_open = EXFALSE;
+    EDB_val val;
+    EDB_cursor_op op;
+    int align = 0;
+    
+    if (NULL!=data)
+    {
+        ret = idx_del_rec(db, txn, key, data);
+        goto out;
+    }
+    
+    if (EXSUCCEED!=(ret=ndrx_cache_edb_cursor_open(db, txn, &cursor)))
+    {
+        goto out;
+    }
+    cursor_open = EXTRUE;
+    
+    /* all dups of the key (single record if no timesync) */
+    op = EDB_SET_KEY;
+    while (EXSUCCEED==(ret=ndrx_cache_edb_cursor_get(db, cursor, key, &val, 
+            op, &align)))
+    {
+        ret = idx_del_rec(db, txn, key, &val);
+        
+        if (align)
+        {
+            NDRX_FREE(val.mv_data);
+            align = 0;
+        }
+        
+        if (EXSUCCEED!=ret)
+        {
+            goto out;
+        }
+        
+        op = EDB_NEXT_DUP;
+    }
+    
+    if (EDB_NOTFOUND==ret)
+    {
+        ret = EXSUCCEED;
+    }
+    
+out:
+    if (cursor_open)
+    {
+        edb_cursor_close(cursor);
+    }
+
+    return ret;
+}
+
+/**
+ * Check is index entry built from given record
+ * @param db cache db
+ * @param idxkey index entry key
+ * @param key cache key
+ * @param data db record
+ * @return EXTRUE - entry is current, EXFALSE - stale
+ */
+expublic int ndrx_cache_idx_match(ndrx_tpcache_db_t *db, EDB_val *idxkey,
+        char *key, EDB_val *data)
+{
+    unsigned char ent[IDX_MAX_ENTRIES][NDRX_TPCACHE_IDX_KEYLEN];
+    int n;
+    int i;
+    
+    n = idx_entries(db, key, data, ent);
+    
+    for (i=0; i<n; i++)
+    {
+        if (NDRX_TPCACHE_IDX_KEYLEN==idxkey->mv_size &&
+                0==memcmp(ent[i], idxkey->mv_data, NDRX_TPCACHE_IDX_KEYLEN))
+        {
+            return EXTRUE;
+        }
+    }
+    
+    return EXFALSE;
+}
+
+/**
+ * Decode index entry key
+ * @param idxkey index entry key
+ * @param v1 primary value (put/hit time or hits)
+ * @param v2 secondary value
+ * @return entry type or EXEOS if key is not index entry
+ */
+expublic char ndrx_cache_idx_parse(EDB_val *idxkey, long *v1, long *v2)
+{
+    unsigned char *p = (unsigned char *)idxkey->mv_data;
+    
+    if (NDRX_TPCACHE_IDX_KEYLEN!=idxkey->mv_size)
+    {
+        return EXEOS;
+    }
+    
+    *v1 = (long)idx_get64(p+1);
+    *v2 = (long)idx_get64(p+9);
+    
+    return (char)p[0];
+}
+
+/**
+ * Open the index db. If index is empty, but db has records (index flag
+ * added to existing db), index is built from the records.
+ * @param db cache db
+ * @param txn RW transaction
+ * @return EXSUCCEED/edb error
+ */
+expublic int ndrx_cache_idx_open(ndrx_tpcache_db_t *db, EDB_txn *txn)
+{
+    int ret = EXSUCCEED;
+    char idxnam[NDRX_CCTAG_MAX+5];
+    EDB_stat istat, stat;
+    EDB_cursor *cursor;
+    int cursor_open = EXFALSE;
+    EDB_val keydb, val;
+    EDB_cursor_op op;
+    int align = 0;
+    long cnt = 0;
+    
+    snprintf(idxnam, sizeof(idxnam), "%s.idx", db->cachedbnam);
+    
+    if (EXSUCCEED!=(ret=edb_dbi_open(txn, idxnam, EDB_CREATE, &db->idxdbi)))
+    {
+        NDRX_CACHE_TPERROR(ndrx_cache_maperr(ret), 
+                "Failed to open index db [%s] for [%s]: %s", 
+                idxnam, db->cachedb, edb_strerror(ret));
+        goto out;
+    }
+    
+    if (EXSUCCEED!=(ret=edb_stat(txn, db->idxdbi, &istat)))
+    {
+        NDRX_CACHE_TPERROR(ndrx_cache_maperr(ret), 
+                "Failed to stat index db [%s]: %s", idxnam, edb_strerror(ret));
+        goto out;
+    }
+    
+    if (EXSUCCEED!=(ret=ndrx_cache_edb_stat(db, txn, &stat)))
+    {
+        goto out;
+    }
+    
+    if (istat.ms_entries > 0 || 0==stat.ms_entries)
+    {
+        goto out;
+    }
+    
+    NDRX_LOG(log_warn, "Building index [%s] of %ld records", 
+            idxnam, (long)stat.ms_entries);
+    
+    if (EXSUCCEED!=(ret=ndrx_cache_edb_cursor_open(db, txn, &cursor)))
+    {
+        goto out;
+    }
+    cursor_open = EXTRUE;
+    
+    op = EDB_FIRST;
+    while (EXSUCCEED==(ret=ndrx_cache_edb_cursor_getfullkey(db, cursor, 
+            &keydb, &val, op, &align)))
+    {
+        if (EXEOS==((char *)keydb.mv_data)[keydb.mv_size-1])
+        {
+            ret = ndrx_cache_idx_add(db, txn, keydb.mv_data, &val);
+        }
+        else
+        {
+            NDRX_LOG(log_error, "Invalid cache key in [%s] - not indexed",
+                    db->cachedb);
+        }
+        
+        if (align)
+        {
+            NDRX_FREE(val.mv_data);
+            align = 0;
+        }
+        
+        if (EXSUCCEED!=ret)
+        {
+            goto out;
+        }
+        
+        cnt++;
+        op = EDB_NEXT;
+    }
+    
+    if (EDB_NOTFOUND==ret)
+    {
+        ret = EXSUCCEED;
+        NDRX_LOG(log_warn, "Index [%s] built from %ld records", idxnam, cnt);
+    }
+    
+out:
+    if (cursor_open)
+    {
+        edb_cursor_close(cursor);
+    }
+
+    return ret;
+}
+
+/* vim: set ts=4 sw=4 et smartindent: */
@@ -200,10 +200,17 @@ exprivate void ndrx_cache_phydb_free(ndrx_tpcache_phydb_t *phydb)
  */
 exprivate void ndrx_cache_db_free(ndrx_tpcache_db_t *db)
 {
+    ndrx_cache_l1_free(db);
+    
     /* func checks the dbi validity */
     if (NULL!=db->phy)
     {
         edb_dbi_close(db->phy->env, db->dbi);
+        
+        if (db->flags & NDRX_TPCACHE_FLAGS_INDEX)
+        {
+            edb_dbi_close(db->phy->env, db->idxdbi);
+        }
         ndrx_cache_phydb_free(db->phy);
         
     }
@@ -477,6 +484,7 @@ expublic ndrx_tpcache_db_t* ndrx_cache_dbresolve(char *cachedb, int mode)
     }
 
     NDRX_CALLOC_OUT(db, 1, sizeof(ndrx_tpcache_db_t), ndrx_tpcache_db_t);
+    MUTEX_VAR_INIT(db->l1_lock);
         
     /* Lookup the section from configuration */
     NDRX_STRCPY_SAFE(dbnametmp, cachedb);
@@ -574,6 +582,11 @@ expublic ndrx_tpcache_db_t* ndrx_cache_dbresolve(char *cachedb, int mode)
         {
             db->limit = (long)ndrx_num_dec_parsecfg(val->val);
         }
+        /* Bytes of in-process L1 tier: 100000, 100K, 1M */
+        else if (0==strcmp(val->key, NDRX_TPCACHE_KWD_L1MAX))
+        {
+            db->l1max = (long)ndrx_num_dec_parsecfg(val->val);
+        }
         else if (0==strcmp(val->key, NDRX_TPCACHE_KWD_EXPIRY))
         {
             db->expiry = (long)ndrx_num_time_parsecfg(val->val) / 1000L;
@@ -652,6 +665,10 @@ expublic ndrx_tpcache_db_t* ndrx_cache_dbresolve(char *cachedb, int mode)
                 {
                     db->flags|=NDRX_TPCACHE_FLAGS_NOMETASYNC;
                 }
+                else if (0==strcmp(p, NDRX_TPCACHE_KWD_INDEX))
+                {
+                    db->flags|=NDRX_TPCACHE_FLAGS_INDEX;
+                }
                 else
                 {
                     /* unknown flag */
@@ -737,6 +754,16 @@ expublic ndrx_tpcache_db_t* ndrx_cache_dbresolve(char *cachedb, int mode)
         EXFAIL_OUT(ret);
     }
     
+    /* L1 hits do not reach the db, thus lru/hits statistics would be wrong */
+    if (db->l1max > 0 && 
+            ((db->flags & NDRX_TPCACHE_FLAGS_LRU) ||
+            (db->flags & NDRX_TPCACHE_FLAGS_HITS)))
+    {
+        NDRX_CACHE_ERROR("For cache db [%s] `%s' cannot be used with "
+                "lru or hits flags!", cachedb, NDRX_TPCACHE_KWD_L1MAX);
+        EXFAIL_OUT(ret);
+    }
+    
     /* Dump the DB config and open it and if we run in boot mode  
      * we have to reset the 
      */
@@ -824,6 +851,13 @@ expublic ndrx_tpcache_db_t* ndrx_cache_dbresolve(char *cachedb, int mode)
         }
     }
     
+    if ((db->flags & NDRX_TPCACHE_FLAGS_INDEX) && 
+            EXSUCCEED!=(ret=ndrx_cache_idx_open(db, txn)))
+    {
+        NDRX_CACHE_ERROR("Failed to open index of [%s]", db->cachedb);
+        goto out;
+    }
+    
     NDRX_LOG(log_debug, "boot mode: %d  flags: %ld reset: %d",
             mode, db->flags, (int)(db->flags & NDRX_TPCACHE_FLAGS_BOOTRST));
     
@@ -1128,6 +1162,7 @@ expublic int ndrx_cache_init(int mode)
             array_object = exjson_array_get_object(array, i);
                 
             cache->idx = i;
+            cache->sfwait = NDRX_TPCACHE_SFWAIT_DFLT;
             NDRX_STRCPY_SAFE(cache->svcnm, cachesvc->svcnm);
             /* process flags.. by strtok.. but we need a temp buffer
              * Process flags first as some logic depends on them!
@@ -1192,6 +1227,16 @@ expublic int ndrx_cache_init(int mode)
                     {
                         cache->flags|=NDRX_TPCACHE_TPCF_INVLKEYGRP;
                     }
+                    else if (0==strcmp(p_flags, NDRX_TPCACHE_KWC_SINGLEFL))
+                    {
+                        cache->flags|=NDRX_TPCACHE_TPCF_SINGLEFL;
+                    }
+                    else if (0==strcmp(p_flags, NDRX_TPCACHE_KWC_SFSTALE))
+                    {
+                        /* stale serving works on top of single-flight */
+                        cache->flags|=(NDRX_TPCACHE_TPCF_SINGLEFL|
+                                NDRX_TPCACHE_TPCF_SFSTALE);
+                    }
                     else
                     {
                         NDRX_LOG(log_warn, "For service [%s] buffer index %d, "
@@ -1523,6 +1568,21 @@ expublic int ndrx_cache_init(int mode)
                 cache->keygroupmax = atol(tmp);
             }
             
+            /* single-flight wait time, ms */
+            if (NULL!=(tmp = exjson_object_get_string(array_object, 
+                    NDRX_TPCACHE_KWC_SFWAIT)))
+            {
+                cache->sfwait = atol(tmp);
+                
+                if (cache->sfwait <= 0)
+                {
+                    NDRX_CACHE_TPERROR(TPEINVAL, "CACHE: invalid [%s] value [%s] "
+                            "for service [%s], buffer index: %d", 
+                            NDRX_TPCACHE_KWC_SFWAIT, tmp, svc, i);
+                    EXFAIL_OUT(ret);
+                }
+            }
+            
             if (NULL!=ndrx_G_tpcache_types[cache->buf_type->type_id].pf_process_flags)
             {
                 if (EXSUCCEED!=ndrx_G_tpcache_types[cache->buf_type->type_id].pf_process_flags(cache, 
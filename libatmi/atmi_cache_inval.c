@@ -396,9 +396,20 @@ expublic int ndrx_cache_drop(char *cachedbnm, short nodeid)
         EXFAIL_OUT(ret);
     }
     
+    if ((db->flags & NDRX_TPCACHE_FLAGS_INDEX) && 
+            EXSUCCEED!=(ret=edb_drop(txn, db->idxdbi, 0)))
+    {
+        NDRX_CACHE_TPERROR(ndrx_cache_maperr(ret), 
+                "CACHE: Failed to clear index of db: [%s]: %s", 
+                db->cachedb, edb_strerror(ret));
+
+        EXFAIL_OUT(ret);
+    }
+    
     /* check if we should broadcast the drop */
     
     NDRX_LOG(log_warn, "Cache [%s] dropped", cachedbnm);
+    ndrx_cache_l1_del(db, NULL);
     
     if ( (db->flags & NDRX_TPCACHE_FLAGS_BCASTDEL) &&
             tpgetnodeid()==nodeid )
@@ -766,6 +777,9 @@ expublic int ndrx_cache_inval_by_key(char *cachedbnm, ndrx_tpcache_db_t* db_reso
         }
     }
     
+    /* local L1 copy goes away at once, others see the db commit */
+    ndrx_cache_l1_del(db, key);
+    
     /* start transaction */
     if (!ext_tran)
     {
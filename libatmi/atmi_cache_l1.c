@@ -0,0 +1,334 @@
+/**
+ * @brief ATMI level cache - in-process L1 tier
+ *   Copies of db records recently read by this process are kept in memory,
+ *   keyed by cache key, limited by `l1max' bytes per cache db and evicted in
+ *   LRU order. Records are valid only while the last committed transaction id
+ *   of the LMDB environment equals the one at which they were read, thus any
+ *   put/delete/drop by any process (incl. ones applied from events by tpcached
+ *   or tpcachesv) flushes the L1 of the db on next lookup.
+ *
+ * @file atmi_cache_l1.c
+ */
+/* -----------------------------------------------------------------------------
+ * Enduro/X Middleware Platform for Distributed Transaction Processing
+ * Copyright (C) 2009-2016, ATR Baltic, Ltd. All Rights Reserved.
+ * Copyright (C) 2017-2019, Mavimax, Ltd. All Rights Reserved.
+ * This software is released under one of the following licenses:
+ * AGPL (with Java and Go exceptions) or Mavimax's license for commercial use.
+ * See LICENSE file for full text.
+ * -----------------------------------------------------------------------------
+ * AGPL license:
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License, version 3 as published
+ * by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License, version 3
+ * for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * -----------------------------------------------------------------------------
+ * A commercial use license is available from Mavimax, Ltd
+ * contact@mavimax.com
+ * -----------------------------------------------------------------------------
+ */
+#include <ndrx_config.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <ndrstandard.h>
+#include <atmi.h>
+#include <atmi_tls.h>
+#include <typed_buf.h>
+
+#include "thlock.h"
+#include "userlog.h"
+#include "utlist.h"
+#include <atmi_cache.h>
+/*---------------------------Externs------------------------------------*/
+/*---------------------------Macros-------------------------------------*/
+/*---------------------------Enums--------------------------------------*/
+/*---------------------------Typedefs-----------------------------------*/
+/*---------------------------Globals------------------------------------*/
+/*---------------------------Statics------------------------------------*/
+/*---------------------------Prototypes---------------------------------*/
+
+/**
+ * Remove L1 entry. Lock must be held.
+ * @param db cache db
+ * @param el entry to remove
+ */
+exprivate void l1_remove(ndrx_tpcache_db_t *db, ndrx_tpcache_l1_t *el)
+{
+    EXHASH_DEL(db->l1_hash, el);
+    DL_DELETE(db->l1_lru, el);
+    db->l1_bytes-=el->size;
+    
+    NDRX_FREE(el->key);
+    NDRX_FREE(el->exdata);
+    NDRX_FREE(el);
+}
+
+/**
+ * Remove all L1 entries. Lock must be held.
+ * @param db cache db
+ */
+exprivate void l1_flush(ndrx_tpcache_db_t *db)
+{
+    ndrx_tpcache_l1_t *el, *elt;
+    
+    EXHASH_ITER(hh, db->l1_hash, el, elt)
+    {
+        l1_remove(db, el);
+    }
+}
+
+/**
+ * Check that L1 still matches the db. If any transaction is committed to the
+ * environment since records were read, L1 is flushed. Lock must be held.
+ * @param db cache db
+ * @return EXSUCCEED/EXFAIL (env info failed, L1 flushed)
+ */
+exprivate int l1_validate(ndrx_tpcache_db_t *db)
+{
+    int ret = EXSUCCEED;
+    EDB_envinfo info;
+    
+    if (EXSUCCEED!=(ret=edb_env_info(db->phy->env, &info)))
+    {
+        NDRX_LOG(log_error, "%s: failed to get env info for [%s]: %s", 
+                __func__, db->cachedb, edb_strerror(ret));
+        l1_flush(db);
+        db->l1_txnid = 0;
+        EXFAIL_OUT(ret);
+    }
+    
+    if (info.me_last_txnid!=db->l1_txnid)
+    {
+        if (NULL!=db->l1_hash)
+        {
+            NDRX_LOG(log_debug, "L1 of [%s] outdated (txnid %ld -> %ld) - flush",
+                    db->cachedb, (long)db->l1_txnid, (long)info.me_last_txnid);
+            l1_flush(db);
+        }
+        db->l1_txnid = info.me_last_txnid;
+    }
+    
+out:
+    return ret;
+}
+
+/**
+ * Lookup the record in L1 tier and if found, return the data to caller
+ * in the same way as db lookup does.
+ * @param cache tpcall cache
+ * @param buf_type input buffer type
+ * @param key cache key
+ * @param idata input buffer
+ * @param ilen input buffer len
+ * @param odata output buffer
+ * @param olen output buffer len
+ * @param flags tpcall flags
+ * @param saved_tperrno tperrno saved in cache
+ * @param saved_tpurcode tpurcode saved in cache
+ * @param should_cache reset if data must not be used
+ * @param noenterr service not available
+ * @return EXSUCCEED (hit), NDRX_TPCACHE_ENOCACHEDATA (miss) or EXFAIL
+ */
+expublic int ndrx_cache_l1_lookup(ndrx_tpcallcache_t *cache, 
+        typed_buffer_descr_t *buf_type, char *key, char *idata, long ilen, 
+        char **odata, long *olen, long flags, int *saved_tperrno, 
+        long *saved_tpurcode, int *should_cache, int noenterr)
+{
+    int ret = EXSUCCEED;
+    ndrx_tpcache_db_t *db = cache->cachedb;
+    ndrx_tpcache_l1_t *el = NULL;
+    long t;
+    long tusec;
+    
+    MUTEX_LOCK_V(db->l1_lock);
+    
+    if (EXSUCCEED!=l1_validate(db))
+    {
+        /* let db lookup to sort it out */
+        ret = NDRX_TPCACHE_ENOCACHEDATA;
+        goto out;
+    }
+    
+    EXHASH_FIND_STR(db->l1_hash, key, el);
+    
+    if (NULL==el)
+    {
+        ret = NDRX_TPCACHE_ENOCACHEDATA;
+        goto out;
+    }
+    
+    if (db->flags & NDRX_TPCACHE_FLAGS_EXPIRY)
+    {
+        ndrx_utc_tstamp2(&t, &tusec);
+        
+        if (t - el->exdata->t >= db->expiry)
+        {
+            NDRX_LOG(log_debug, "L1 record [%s] expired", key);
+            l1_remove(db, el);
+            ret = NDRX_TPCACHE_ENOCACHEDATA;
+            goto out;
+        }
+    }
+    
+    /* check that we are allowed to receive data */
+    if (noenterr && !(cache->flags & NDRX_TPCACHE_TPCF_NOSVCOK))
+    {
+        ndrx_TPset_error_fmt(TPENOENT, "%s: Data found in cache but nosvcok "
+                "no present", __func__);
+        *should_cache = EXFALSE;
+        EXFAIL_OUT(ret);
+    }
+    
+    if (EXSUCCEED!=ndrx_G_tpcache_types[cache->buf_type->type_id].pf_cache_get(
+            cache, el->exdata, buf_type, idata, ilen, odata, olen, flags))
+    {
+        NDRX_LOG(log_error, "%s: Failed to receive data", __func__);
+        EXFAIL_OUT(ret);
+    }
+    
+    *saved_tperrno = el->exdata->saved_tperrno;
+    *saved_tpurcode = el->exdata->saved_tpurcode;
+    
+    /* most recently used goes first */
+    DL_DELETE(db->l1_lru, el);
+    DL_PREPEND(db->l1_lru, el);
+    
+    NDRX_LOG(log_debug, "L1 hit [%s] cache tperrno: %d tpurcode: %ld",
+            key, *saved_tperrno, *saved_tpurcode);
+    
+out:
+    MUTEX_UNLOCK_V(db->l1_lock);
+
+    return ret;
+}
+
+/**
+ * Add record read from db to L1. Record is added only if db is not changed
+ * since given transaction. Least recently used records are evicted to fit
+ * in the `l1max' limit.
+ * @param db cache db
+ * @param key cache key
+ * @param exdata malloc'd copy of db record, ownership is taken
+ * @param size record size
+ * @param txnid transaction in which record was read (or written)
+ */
+expublic void ndrx_cache_l1_add(ndrx_tpcache_db_t *db, char *key, 
+        ndrx_tpcache_data_t *exdata, long size, edb_size_t txnid)
+{
+    ndrx_tpcache_l1_t *el = NULL;
+    long need = sizeof(ndrx_tpcache_l1_t) + strlen(key) + 1 + size;
+    
+    if (need > db->l1max)
+    {
+        NDRX_FREE(exdata);
+        return;
+    }
+    
+    MUTEX_LOCK_V(db->l1_lock);
+    
+    if (EXSUCCEED!=l1_validate(db) || txnid!=db->l1_txnid)
+    {
+        /* db moved on since record was read */
+        NDRX_FREE(exdata);
+        goto out;
+    }
+    
+    EXHASH_FIND_STR(db->l1_hash, key, el);
+    
+    if (NULL!=el)
+    {
+        l1_remove(db, el);
+    }
+    
+    while (db->l1_bytes + need > db->l1max && NULL!=db->l1_lru)
+    {
+        /* tail of the list is least recently used */
+        l1_remove(db, db->l1_lru->prev);
+    }
+    
+    if (NULL==(el = NDRX_MALLOC(sizeof(ndrx_tpcache_l1_t))))
+    {
+        NDRX_LOG(log_error, "%s: failed to malloc %d bytes: %s", 
+                __func__, (int)sizeof(ndrx_tpcache_l1_t), strerror(errno));
+        NDRX_FREE(exdata);
+        goto out;
+    }
+    
+    if (NULL==(el->key = NDRX_STRDUP(key)))
+    {
+        NDRX_LOG(log_error, "%s: failed to strdup key: %s", 
+                __func__, strerror(errno));
+        NDRX_FREE(el);
+        NDRX_FREE(exdata);
+        goto out;
+    }
+    
+    el->exdata = exdata;
+    el->size = need;
+    
+    EXHASH_ADD_KEYPTR(hh, db->l1_hash, el->key, strlen(el->key), el);
+    DL_PREPEND(db->l1_lru, el);
+    db->l1_bytes+=need;
+    
+out:
+    MUTEX_UNLOCK_V(db->l1_lock);
+}
+
+/**
+ * Remove record from L1 of this process
+ * @param db cache db
+ * @param key cache key, NULL - remove all records
+ */
+expublic void ndrx_cache_l1_del(ndrx_tpcache_db_t *db, char *key)
+{
+    ndrx_tpcache_l1_t *el = NULL;
+    
+    if (0>=db->l1max)
+    {
+        return;
+    }
+    
+    MUTEX_LOCK_V(db->l1_lock);
+    
+    if (NULL==key)
+    {
+        l1_flush(db);
+    }
+    else
+    {
+        EXHASH_FIND_STR(db->l1_hash, key, el);
+        
+        if (NULL!=el)
+        {
+            l1_remove(db, el);
+        }
+    }
+    
+    MUTEX_UNLOCK_V(db->l1_lock);
+}
+
+/**
+ * Free the L1 of the db (at db close)
+ * @param db cache db
+ */
+expublic void ndrx_cache_l1_free(ndrx_tpcache_db_t *db)
+{
+    MUTEX_LOCK_V(db->l1_lock);
+    l1_flush(db);
+    MUTEX_UNLOCK_V(db->l1_lock);
+    MUTEX_DESTROY_V(db->l1_lock);
+}
+
+/* vim: set ts=4 sw=4 et smartindent: */
@@ -468,12 +468,17 @@ out:
  * @param should_cache should record be cached?
  * @param seterror_not_found should we generate error if record is not found?
  * @param[in] noenterr is no entry error currently?
+ * @param[out] sfref single-flight claim. NULL - waiting for other's refresh,
+ *  do not claim, expired records are not returned
+ * @param[out] sfstate NDRX_TPCACHE_SF_FOLLOWER if shall wait for other's refresh
+ * @param[out] p_cache matched tpcall cache
  * @return EXSUCCEED/EXFAIL (syserr)/NDRX_TPCACHE_ENOKEYDATA (cannot build key)
  */
-expublic int ndrx_cache_lookup(char *svc, char *idata, long ilen, 
+exprivate int cache_lookup(char *svc, char *idata, long ilen, 
         char **odata, long *olen, long flags, int *should_cache, 
         int *saved_tperrno, long *saved_tpurcode, int seterror_not_found,
-        int noenterr)
+        int noenterr, ndrx_tpcache_sfref_t *sfref, int *sfstate,
+        ndrx_tpcallcache_t **p_cache)
 {
     int ret = EXSUCCEED;
     ndrx_tpcache_svc_t *svcc = NULL;
@@ -496,6 +501,11 @@ expublic int ndrx_cache_lookup(char *svc, char *idata, long ilen,
     char *defer_free = NULL;
     unsigned int flagsdb;
     int force_abort = EXFALSE;
+    ndrx_tpcache_data_t *l1_rec = NULL;
+    edb_size_t l1_txnid = 0;
+    int sf_miss = EXFALSE;
+    long t;
+    long tusec;
     /* Key size - assume 16K should be fine */
     /* get buffer type & sub-type */
     cachedata_update.mv_size = 0;
@@ -659,6 +669,7 @@ expublic int ndrx_cache_lookup(char *svc, char *idata, long ilen,
     /* LOOP END */
     
     *should_cache=EXTRUE;
+    *p_cache = cache;
     
     if (cache->flags & NDRX_TPCACHE_TPCF_INVAL)
     {
@@ -710,6 +721,18 @@ expublic int ndrx_cache_lookup(char *svc, char *idata, long ilen,
         }
     }
     
+    /* In-process L1 tier, db is not touched on hit */
+    if (cache->cachedb->l1max > 0)
+    {
+        if (NDRX_TPCACHE_ENOCACHEDATA!=(ret=ndrx_cache_l1_lookup(cache, buf_type, 
+                key, idata, ilen, odata, olen, flags, saved_tperrno, 
+                saved_tpurcode, should_cache, noenterr)))
+        {
+            goto out;
+        }
+        ret = EXSUCCEED;
+    }
+    
     /* Lookup DB - check the flags if with update, requires update, then no read
      * only */
     
@@ -757,6 +780,7 @@ expublic int ndrx_cache_lookup(char *svc, char *idata, long ilen,
             }
             /* no data found */
             ret = NDRX_TPCACHE_ENOCACHEDATA;
+            sf_miss = EXTRUE;
             goto out;
         }
         
@@ -771,6 +795,7 @@ expublic int ndrx_cache_lookup(char *svc, char *idata, long ilen,
         {
             /* error already provided by wrapper */
             NDRX_LOG(log_debug, "%s: failed to get cache by [%s]", __func__, key);
+            sf_miss = (EDB_NOTFOUND==ret);
             goto out;
         }
     }
@@ -795,6 +820,45 @@ expublic int ndrx_cache_lookup(char *svc, char *idata, long ilen,
     NDRX_TPCACHETPCALL_DBDATA(log_debug, exdata);
 #endif
     
+    /* single-flight: expired record is refreshed by one caller only */
+    if ((cache->flags & NDRX_TPCACHE_TPCF_SINGLEFL) && 
+            (cache->cachedb->flags & NDRX_TPCACHE_FLAGS_EXPIRY) && !noenterr)
+    {
+        ndrx_utc_tstamp2(&t, &tusec);
+        
+        if (t - exdata->t >= cache->cachedb->expiry)
+        {
+            NDRX_LOG(log_debug, "Record [%s] expired", key);
+            
+            if (NULL==sfref)
+            {
+                /* waiting for fresh one */
+                ret = NDRX_TPCACHE_ENOCACHEDATA;
+                goto out;
+            }
+            
+            switch (ndrx_cache_sf_claim(cache, key, sfref))
+            {
+                case NDRX_TPCACHE_SF_LEADER:
+                    ret = NDRX_TPCACHE_ENOCACHEDATA;
+                    goto out;
+                case NDRX_TPCACHE_SF_FOLLOWER:
+                    
+                    if (!(cache->flags & NDRX_TPCACHE_TPCF_SFSTALE))
+                    {
+                        *sfstate = NDRX_TPCACHE_SF_FOLLOWER;
+                        ret = NDRX_TPCACHE_ENOCACHEDATA;
+                        goto out;
+                    }
+                    NDRX_LOG(log_debug, "Refresh in progress - serve stale");
+                    break;
+                default:
+                    /* no single-flight, serve as before */
+                    break;
+            }
+        }
+    }
+    
     /* Error shall be set by func */
     
     /* check that we are allowed to receive data */
@@ -819,6 +883,14 @@ expublic int ndrx_cache_lookup(char *svc, char *idata, long ilen,
     NDRX_LOG(log_debug, "cache tperrno: %d tpurcode: %ld",
             *saved_tperrno, *saved_tpurcode);
     
+    /* keep copy for L1, added when tran is completed */
+    if (cache->cachedb->l1max > 0 && 
+            NULL!=(l1_rec = NDRX_MALLOC(cachedata.mv_size)))
+    {
+        memcpy(l1_rec, cachedata.mv_data, cachedata.mv_size);
+        l1_txnid = edb_txn_id(txn);
+    }
+    
     /* Update cache (if needed) */
     
     
@@ -966,20 +1038,99 @@ out:
     {
         if (EXSUCCEED==ret && !force_abort)
         {
-            ndrx_cache_edb_commit(cache->cachedb, txn);
+            if (EXSUCCEED==ndrx_cache_edb_commit(cache->cachedb, txn) && 
+                    NULL!=l1_rec)
+            {
+                ndrx_cache_l1_add(cache->cachedb, key, l1_rec, 
+                        (long)cachedata.mv_size, l1_txnid);
+                l1_rec = NULL;
+            }
         }
         else
         {
             ndrx_cache_edb_abort(cache->cachedb, txn);
         }
     }
+    
+    if (NULL!=l1_rec)
+    {
+        NDRX_FREE(l1_rec);
+    }
 
     if (defer_free)
     {
         NDRX_FREE(defer_free);
     }
+    
+    /* single-flight: first caller refreshes, others wait */
+    if (sf_miss && NULL!=sfref && !noenterr && 
+            (cache->flags & NDRX_TPCACHE_TPCF_SINGLEFL) &&
+            NDRX_TPCACHE_SF_FOLLOWER==ndrx_cache_sf_claim(cache, key, sfref))
+    {
+        *sfstate = NDRX_TPCACHE_SF_FOLLOWER;
+    }
 
     return ret;
 }
 
+/**
+ * Lookup service in cache. In case of single-flight cache and other caller
+ * refreshing the record, wait for it to appear in cache.
+ * @param svc service to call
+ * @param idata input data buffer
+ * @param ilen input len
+ * @param odata output data buffer
+ * @param olen output len
+ * @param flags flags
+ * @param should_cache should record be cached?
+ * @param seterror_not_found should we generate error if record is not found?
+ * @param[in] noenterr is no entry error currently?
+ * @param[out] sfref single-flight claim, caller shall release it after the
+ *  cache save (if claimed)
+ * @return EXSUCCEED/EXFAIL (syserr)/NDRX_TPCACHE_ENOKEYDATA (cannot build key)
+ */
+expublic int ndrx_cache_lookup(char *svc, char *idata, long ilen, 
+        char **odata, long *olen, long flags, int *should_cache, 
+        int *saved_tperrno, long *saved_tpurcode, int seterror_not_found,
+        int noenterr, ndrx_tpcache_sfref_t *sfref)
+{
+    int ret;
+    int sfstate = NDRX_TPCACHE_SF_OFF;
+    int busy;
+    ndrx_tpcallcache_t *cache = NULL;
+    ndrx_stopwatch_t w;
+    
+    sfref->claimed = EXFALSE;
+    
+    ret = cache_lookup(svc, idata, ilen, odata, olen, flags, should_cache, 
+            saved_tperrno, saved_tpurcode, seterror_not_found, noenterr, 
+            sfref, &sfstate, &cache);
+    
+    if (NDRX_TPCACHE_SF_FOLLOWER==sfstate)
+    {
+        NDRX_LOG(log_debug, "Waiting for refresh of [%s] cache (max %ld ms)",
+                svc, cache->sfwait);
+        
+        ndrx_stopwatch_reset(&w);
+        
+        do
+        {
+            ndrx_cache_sf_pause();
+            /* check before the lookup, so that last result is seen */
+            busy = ndrx_cache_sf_busy(cache, sfref);
+            
+            ret = cache_lookup(svc, idata, ilen, odata, olen, flags, should_cache, 
+                saved_tperrno, saved_tpurcode, seterror_not_found, noenterr, 
+                NULL, &sfstate, &cache);
+            
+        } while (EXSUCCEED!=ret && EXFAIL!=ret && busy && 
+                ndrx_stopwatch_get_delta(&w) < cache->sfwait);
+        
+        NDRX_LOG(log_debug, "Refresh wait done: %d (%ld ms)", ret, 
+                ndrx_stopwatch_get_delta(&w));
+    }
+    
+    return ret;
+}
+
 /* vim: set ts=4 sw=4 et smartindent: */
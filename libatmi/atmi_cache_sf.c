@@ -0,0 +1,400 @@
+/**
+ * @brief ATMI level cache - single-flight of cache misses
+ *   When `singleflight' flag is set for tpcall cache, the first process
+ *   which misses the key claims it in the shared in-flight table and
+ *   performs the service call. Concurrent callers of the same key wait
+ *   (bounded by `sfwait') for the record to appear in the cache db. With
+ *   `sfstale' flag expired record is served to them while first caller
+ *   refreshes it. Table is fixed size, keys are identified by 64bit hash of
+ *   the db name and the key. If no slot is available, call is performed as
+ *   usual.
+ *
+ * @file atmi_cache_sf.c
+ */
+/* -----------------------------------------------------------------------------
+ * Enduro/X Middleware Platform for Distributed Transaction Processing
+ * Copyright (C) 2009-2016, ATR Baltic, Ltd. All Rights Reserved.
+ * Copyright (C) 2017-2019, Mavimax, Ltd. All Rights Reserved.
+ * This software is released under one of the following licenses:
+ * AGPL (with Java and Go exceptions) or Mavimax's license for commercial use.
+ * See LICENSE file for full text.
+ * -----------------------------------------------------------------------------
+ * AGPL license:
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License, version 3 as published
+ * by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License, version 3
+ * for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * -----------------------------------------------------------------------------
+ * A commercial use license is available from Mavimax, Ltd
+ * contact@mavimax.com
+ * -----------------------------------------------------------------------------
+ */
+#include <ndrx_config.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/types.h>
+
+#include <ndrstandard.h>
+#include <ndebug.h>
+#include <atmi.h>
+#include <atmi_int.h>
+#include <userlog.h>
+#include <thlock.h>
+#include <nstd_shm.h>
+#include <sys_unix.h>
+#include <atmi_cache.h>
+/*---------------------------Externs------------------------------------*/
+/*---------------------------Macros-------------------------------------*/
+#define SF_SLOTS            1024    /**< In-flight table size           */
+#define SF_PROBE            8       /**< Slots probed from hash pos     */
+#define SF_POLL_USEC        5000    /**< Waiter poll interval           */
+
+#define SF_SLOT(IDX)        ((ndrx_sf_slot_t *)M_sf_shm.mem + (IDX))
+/*---------------------------Enums--------------------------------------*/
+/*---------------------------Typedefs-----------------------------------*/
+
+/**
+ * In-flight key slot
+ */
+typedef struct
+{
+    uint64_t hash;      /**< key hash, 0 - slot free                    */
+    unsigned gen;       /**< incremented on every claim                 */
+    pid_t owner;        /**< process refreshing the key                 */
+    long long t_claim;  /**< claim time, UTC milliseconds               */
+} ndrx_sf_slot_t;
+
+/*---------------------------Globals------------------------------------*/
+/*---------------------------Statics------------------------------------*/
+
+exprivate ndrx_shm_t M_sf_shm = {.fd=EXFAIL, .path="", .mem=NULL}; /**< Table shm */
+exprivate ndrx_sem_t M_sf_sem = {.semid=0};     /**< Protects the slots      */
+exprivate volatile int M_attached = EXFALSE;    /**< Are we attached ?       */
+exprivate int M_init_failed = EXFALSE;          /**< Do not retry the init   */
+exprivate MUTEX_LOCKDECL(M_sf_init_lock);       /**< Table attach lock       */
+
+/*---------------------------Prototypes---------------------------------*/
+
+/**
+ * Setup the table shm and semaphore keys
+ */
+exprivate void sf_keys_set(void)
+{
+    M_sf_shm.fd = EXFAIL;
+    M_sf_shm.key = G_atmi_env.ipckey + NDRX_SHM_CACHESF_KEYOFSZ;
+    M_sf_shm.size = sizeof(ndrx_sf_slot_t) * SF_SLOTS;
+    snprintf(M_sf_shm.path, sizeof(M_sf_shm.path), NDRX_SHM_CACHESF,
+            G_atmi_env.qprefix);
+
+    memset(&M_sf_sem, 0, sizeof(M_sf_sem));
+    M_sf_sem.key = G_atmi_env.ipckey + NDRX_SEM_CACHESFLOCKS;
+    M_sf_sem.nrsems = 1;
+    M_sf_sem.maxreaders = 1;
+}
+
+/**
+ * Open or attach the in-flight table. First process using single-flight
+ * creates it.
+ * @return EXSUCCEED/EXFAIL
+ */
+exprivate int sf_init(void)
+{
+    int ret = EXSUCCEED;
+
+    MUTEX_LOCK_V(M_sf_init_lock);
+
+    if (M_attached)
+    {
+        goto out;
+    }
+
+    if (M_init_failed)
+    {
+        EXFAIL_OUT(ret);
+    }
+
+    sf_keys_set();
+
+    if (EXSUCCEED!=ndrx_shm_open(&M_sf_shm, EXTRUE))
+    {
+        NDRX_LOG(log_error, "Failed to open cache in-flight table [%s]", 
+                M_sf_shm.path);
+        userlog("Failed to open cache in-flight table [%s] - single-flight "
+                "disabled", M_sf_shm.path);
+        M_init_failed = EXTRUE;
+        EXFAIL_OUT(ret);
+    }
+
+    if (EXSUCCEED!=ndrx_sem_open(&M_sf_sem, EXTRUE))
+    {
+        NDRX_LOG(log_error, "Failed to open cache in-flight table semaphore");
+        userlog("Failed to open cache in-flight table semaphore - single-flight "
+                "disabled");
+        ndrx_shm_close(&M_sf_shm);
+        M_init_failed = EXTRUE;
+        EXFAIL_OUT(ret);
+    }
+
+    NDRX_LOG(log_info, "Cache in-flight table [%s] attached, %d slots", 
+            M_sf_shm.path, SF_SLOTS);
+
+    M_attached = EXTRUE;
+
+out:
+    MUTEX_UNLOCK_V(M_sf_init_lock);
+    return ret;
+}
+
+/**
+ * Current UTC time in milliseconds
+ * @return time in ms
+ */
+exprivate long long sf_now(void)
+{
+    long t;
+    long tusec;
+    
+    ndrx_utc_tstamp2(&t, &tusec);
+    
+    return (long long)t*1000 + tusec/1000;
+}
+
+/**
+ * Hash of the db name and key (FNV-1a)
+ * @param db cache db
+ * @param key cache key
+ * @return hash, never 0
+ */
+exprivate uint64_t sf_hash(ndrx_tpcache_db_t *db, char *key)
+{
+    uint64_t h = 14695981039346656037ULL;
+    unsigned char *p;
+    
+    for (p=(unsigned char *)db->cachedb; *p; p++)
+    {
+        h = (h ^ *p) * 1099511628211ULL;
+    }
+    
+    /* separator */
+    h = h * 1099511628211ULL;
+    
+    for (p=(unsigned char *)key; *p; p++)
+    {
+        h = (h ^ *p) * 1099511628211ULL;
+    }
+    
+    return 0==h?1:h;
+}
+
+/**
+ * Is claim held in the slot still in effect. Lock must be held.
+ * @param slot slot to check
+ * @param now current time in ms
+ * @param sfwait max time in ms the claim is honoured
+ * @return EXTRUE/EXFALSE
+ */
+exprivate int sf_slot_live(ndrx_sf_slot_t *slot, long long now, long sfwait)
+{
+    return (0!=slot->hash && now - slot->t_claim < sfwait &&
+            ndrx_sys_is_process_running_by_pid(slot->owner));
+}
+
+/**
+ * Claim the key for refresh, or find out that somebody else refreshes it
+ * @param cache tpcall cache (single-flight configured)
+ * @param key cache key
+ * @param ref claim reference filled (claimed set, if we are the refresher),
+ *  in case of waiting, the slot of the refresher
+ * @return NDRX_TPCACHE_SF_OFF (table not available or full),
+ *  NDRX_TPCACHE_SF_LEADER (we shall call the service),
+ *  NDRX_TPCACHE_SF_FOLLOWER (other process calls the service)
+ */
+expublic int ndrx_cache_sf_claim(ndrx_tpcallcache_t *cache, char *key, 
+        ndrx_tpcache_sfref_t *ref)
+{
+    int ret = NDRX_TPCACHE_SF_OFF;
+    uint64_t hash;
+    ndrx_sf_slot_t *slot;
+    long long now;
+    int i, idx;
+    int free_idx = EXFAIL;
+    
+    ref->claimed = EXFALSE;
+    
+    if (!M_attached && EXSUCCEED!=sf_init())
+    {
+        goto out;
+    }
+    
+    hash = sf_hash(cache->cachedb, key);
+    
+    if (EXSUCCEED!=ndrx_sem_lock(&M_sf_sem, __func__, 0))
+    {
+        goto out;
+    }
+    
+    now = sf_now();
+    
+    for (i=0; i<SF_PROBE; i++)
+    {
+        idx = (int)((hash + i) % SF_SLOTS);
+        slot = SF_SLOT(idx);
+        
+        if (sf_slot_live(slot, now, cache->sfwait))
+        {
+            if (slot->hash==hash)
+            {
+                ref->slot = idx;
+                ref->gen = slot->gen;
+                ret = NDRX_TPCACHE_SF_FOLLOWER;
+                break;
+            }
+        }
+        else if (EXFAIL==free_idx)
+        {
+            free_idx = idx;
+        }
+    }
+    
+    if (NDRX_TPCACHE_SF_OFF==ret && EXFAIL!=free_idx)
+    {
+        slot = SF_SLOT(free_idx);
+        
+        slot->hash = hash;
+        slot->gen++;
+        slot->owner = getpid();
+        slot->t_claim = now;
+        
+        ref->slot = free_idx;
+        ref->gen = slot->gen;
+        ref->claimed = EXTRUE;
+        ret = NDRX_TPCACHE_SF_LEADER;
+    }
+    
+    ndrx_sem_unlock(&M_sf_sem, __func__, 0);
+    
+out:
+    NDRX_LOG(log_debug, "single-flight [%s] key [%s]: %s", 
+            cache->cachedb->cachedb, key, 
+            NDRX_TPCACHE_SF_LEADER==ret?"refresh":
+            (NDRX_TPCACHE_SF_FOLLOWER==ret?"wait":"off"));
+    
+    return ret;
+}
+
+/**
+ * Check is the claim still held (i.e. refresh is in progress)
+ * @param cache tpcall cache
+ * @param ref slot of the refresher
+ * @return EXTRUE - in progress, EXFALSE - released or lost
+ */
+expublic int ndrx_cache_sf_busy(ndrx_tpcallcache_t *cache, 
+        ndrx_tpcache_sfref_t *ref)
+{
+    int ret = EXFALSE;
+    ndrx_sf_slot_t *slot = SF_SLOT(ref->slot);
+    
+    if (EXSUCCEED!=ndrx_sem_lock(&M_sf_sem, __func__, 0))
+    {
+        goto out;
+    }
+    
+    ret = (slot->gen==ref->gen && sf_slot_live(slot, sf_now(), cache->sfwait));
+    
+    ndrx_sem_unlock(&M_sf_sem, __func__, 0);
+    
+out:
+    return ret;
+}
+
+/**
+ * Release the claim (refresh completed or failed)
+ * @param ref claim reference, reset
+ */
+expublic void ndrx_cache_sf_release(ndrx_tpcache_sfref_t *ref)
+{
+    ndrx_sf_slot_t *slot;
+    
+    if (!ref->claimed)
+    {
+        return;
+    }
+    
+    ref->claimed = EXFALSE;
+    slot = SF_SLOT(ref->slot);
+    
+    if (EXSUCCEED!=ndrx_sem_lock(&M_sf_sem, __func__, 0))
+    {
+        return;
+    }
+    
+    if (slot->gen==ref->gen && slot->owner==getpid())
+    {
+        slot->hash = 0;
+    }
+    
+    ndrx_sem_unlock(&M_sf_sem, __func__, 0);
+    
+    NDRX_LOG(log_debug, "single-flight slot %d gen %u released", 
+            ref->slot, ref->gen);
+}
+
+/**
+ * Sleep before next poll of the cache db
+ */
+expublic void ndrx_cache_sf_pause(void)
+{
+    usleep(SF_POLL_USEC);
+}
+
+/**
+ * Remove the in-flight table shared memory and semaphore (used by shutdown)
+ * @return EXSUCCEED/EXFAIL
+ */
+expublic int ndrx_cache_sf_remove(void)
+{
+    int ret = EXSUCCEED;
+
+    MUTEX_LOCK_V(M_sf_init_lock);
+
+    if (M_attached)
+    {
+        ndrx_shm_close(&M_sf_shm);
+        M_attached = EXFALSE;
+    }
+    else
+    {
+        sf_keys_set();
+    }
+
+    if (EXSUCCEED!=ndrx_shm_remove(&M_sf_shm))
+    {
+        ret = EXFAIL;
+    }
+
+    if (EXSUCCEED==ndrx_sem_attach(&M_sf_sem) &&
+            EXSUCCEED!=ndrx_sem_remove(&M_sf_sem, EXTRUE))
+    {
+        ret = EXFAIL;
+    }
+
+    MUTEX_UNLOCK_V(M_sf_init_lock);
+
+    return ret;
+}
+
+/* vim: set ts=4 sw=4 et smartindent: */
@@ -789,7 +789,7 @@ expublic int ndrx_cache_proc_flags_ubf(ndrx_tpcallcache_t *cache,
         {
             snprintf(errdet, errdetbufsz, "%s: Failed to parse json: [%s]", 
                     __func__, cache->keygroupmrej);
-            NDRX_LOG(log_error, errdet);
+            NDRX_LOG(log_error, "%s", errdet);
             EXFAIL_OUT(ret);
         }
         
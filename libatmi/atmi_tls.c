@@ -312,6 +312,7 @@ expublic void * ndrx_atmi_tls_new(void *tls_in, int auto_destroy, int auto_set)
     
     
     memset (tls->G_tp_conversation_status, 0, sizeof(tls->G_tp_conversation_status));
+    tls->G_last_trace.trace_id = 0;
     
     /* tpcall.c */
     tls->M_svc_return_code = 0;
@@ -1028,6 +1028,8 @@ expublic int reply_with_failure(long flags, tp_command_call_t *last_call,
     call->cd = last_call->cd;
     call->timestamp = last_call->timestamp;
     call->callseq = last_call->callseq;
+    /* conversation initiator checks the generation of its queue */
+    call->convgen = last_call->convgen_snd;
     /* Give some info which server replied - for bridge we need target put here! */
     NDRX_STRCPY_SAFE(call->reply_to, last_call->reply_to);
     call->sysflags |=SYS_FLAG_REPLY_ERROR;
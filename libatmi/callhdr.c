@@ -0,0 +1,371 @@
+/**
+ * @brief Compact call header. Local XATMI requests and replies may be sent
+ *   with tp_command_call_cmpct_t header, where only the scalar fields are
+ *   fixed and the non-empty strings (reply queue, caller id, call stack,
+ *   extra data, XA ids) are passed as length prefixed sections. Receivers
+ *   expand the message back to tp_command_call_t in place, thus the rest of
+ *   the code works with the full form only. The compact form is used when
+ *   NDRX_CMPCTHDR is set (max payload size) and receiver has announced that
+ *   it decodes it: servers by NDRXD_SVCINFO_CMPCTHDR in the shm service
+ *   entry, callers by SYS_FLAG_CMPCTHDR in the request. Others (i.e. binaries
+ *   of older version) get the full header.
+ *
+ * @file callhdr.c
+ */
+/* -----------------------------------------------------------------------------
+ * Enduro/X Middleware Platform for Distributed Transaction Processing
+ * Copyright (C) 2009-2016, ATR Baltic, Ltd. All Rights Reserved.
+ * Copyright (C) 2017-2019, Mavimax, Ltd. All Rights Reserved.
+ * This software is released under one of the following licenses:
+ * AGPL (with Java and Go exceptions) or Mavimax's license for commercial use.
+ * See LICENSE file for full text.
+ * -----------------------------------------------------------------------------
+ * AGPL license:
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License, version 3 as published
+ * by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License, version 3
+ * for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * -----------------------------------------------------------------------------
+ * A commercial use license is available from Mavimax, Ltd
+ * contact@mavimax.com
+ * -----------------------------------------------------------------------------
+ */
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <ndrstandard.h>
+#include <ndebug.h>
+#include <atmi.h>
+#include <atmi_int.h>
+#include <atmi_shm.h>
+/*---------------------------Externs------------------------------------*/
+/*---------------------------Macros-------------------------------------*/
+#define CALLHDR_ALIGN(X)    (((X)+7) & ~7)  /**< payload aligned to 8 */
+
+/**
+ * Put non empty string field as section
+ */
+#define CALLHDR_PUT_STR(P, TAG, FLD) do {\
+        size_t __l = strlen(FLD);\
+        if (__l > 0)\
+        {\
+            *(P)++ = (char)(TAG);\
+            *(P)++ = (char)(unsigned char)__l;\
+            memcpy((P), (FLD), __l);\
+            (P)+=__l;\
+        }\
+    } while (0)
+
+/**
+ * Load section into string field, too long values are dropped
+ */
+#define CALLHDR_GET_STR(FLD, P, L) do {\
+        if ((L) < sizeof(FLD))\
+        {\
+            memcpy((FLD), (P), (L));\
+            (FLD)[(L)] = EXEOS;\
+        }\
+    } while (0)
+
+/*---------------------------Enums--------------------------------------*/
+/*---------------------------Typedefs-----------------------------------*/
+
+/**
+ * Work space for compact header with all the sections
+ */
+typedef union
+{
+    tp_command_call_cmpct_t hdr;
+    char buf[sizeof(tp_command_call_t)*2 + sizeof(ndrx_trace_t)];
+} ndrx_callhdr_tmp_t;
+
+/*---------------------------Globals------------------------------------*/
+/*---------------------------Statics------------------------------------*/
+/*---------------------------Prototypes---------------------------------*/
+
+/**
+ * Convert call to compact form, in place
+ * @param call prepared call (data_len set)
+ * @param len full message len (with trace section, if traced)
+ * @return compact message len or EXFAIL if compact form is not smaller
+ */
+expublic long ndrx_callhdr_encode(tp_command_call_t *call, long len)
+{
+    ndrx_callhdr_tmp_t tmp;
+    tp_command_call_cmpct_t *hdr = &tmp.hdr;
+    ndrx_trace_t *trace = ndrx_calltrace_get(call, len);
+    char *p = hdr->data;
+    long opt_len;
+    long hdr_len;
+
+    memset(hdr, 0, sizeof(*hdr));
+
+#if defined(EX_USE_SYSVQ) || defined(EX_USE_SVAPOLL)
+    hdr->mtype = call->mtype;
+#endif
+    hdr->command_id = call->command_id;
+    memcpy(hdr->proto_ver, call->proto_ver, sizeof(hdr->proto_ver));
+    hdr->proto_magic = NDRX_CALLHDR_CMPCT_MAGIC;
+    hdr->buffer_type_id = call->buffer_type_id;
+    NDRX_STRCPY_SAFE(hdr->name, call->name);
+
+    hdr->sysflags = call->sysflags;
+    hdr->cd = call->cd;
+    hdr->rval = call->rval;
+    hdr->rcode = call->rcode;
+    hdr->user3 = call->user3;
+    hdr->user4 = call->user4;
+    hdr->clttout = call->clttout;
+    hdr->flags = call->flags;
+    hdr->timestamp = call->timestamp;
+    hdr->callseq = call->callseq;
+    hdr->msgseq = call->msgseq;
+    hdr->timer = call->timer;
+
+    hdr->tmtxflags = call->tmtxflags;
+    hdr->tmrmid = call->tmrmid;
+    hdr->tmnodeid = call->tmnodeid;
+    hdr->tmsrvid = call->tmsrvid;
+
+    CALLHDR_PUT_STR(p, NDRX_CALLHDR_TAG_REPLYTO, call->reply_to);
+    CALLHDR_PUT_STR(p, NDRX_CALLHDR_TAG_CALLSTACK, call->callstack);
+    CALLHDR_PUT_STR(p, NDRX_CALLHDR_TAG_MYID, call->my_id);
+    CALLHDR_PUT_STR(p, NDRX_CALLHDR_TAG_EXTRADATA, call->extradata);
+    CALLHDR_PUT_STR(p, NDRX_CALLHDR_TAG_TMXID, call->tmxid);
+    CALLHDR_PUT_STR(p, NDRX_CALLHDR_TAG_TMKNOWNRMS, call->tmknownrms);
+
+    /* trace section moves to the header, up to the last hop recorded */
+    if (NULL!=trace)
+    {
+        size_t trace_len = NDRX_TRACE_LEN(trace);
+
+        *p++ = (char)NDRX_CALLHDR_TAG_TRACE;
+        *p++ = (char)(unsigned char)trace_len;
+        memcpy(p, trace, trace_len);
+        p+=trace_len;
+    }
+
+    opt_len = CALLHDR_ALIGN(p - hdr->data);
+    memset(p, 0, opt_len - (p - hdr->data));
+
+    hdr->opt_len = (int)opt_len;
+    hdr->data_len = call->data_len;
+    hdr_len = sizeof(*hdr) + opt_len;
+
+    /* full header and trace section vs compact header */
+    if (hdr_len >= len - call->data_len)
+    {
+        return EXFAIL;
+    }
+
+    /* payload goes down, header is put in front */
+    memmove(((char *)call) + hdr_len, call->data, call->data_len);
+    memcpy(call, hdr, hdr_len);
+
+    NDRX_LOG(log_debug, "Compact call header: %ld bytes (full %ld)",
+            hdr_len, len - hdr->data_len);
+
+    return hdr_len + hdr->data_len;
+}
+
+/**
+ * Expand compact call header to tp_command_call_t, in place
+ * @param buf received message
+ * @param buf_len buffer size (must hold the full form)
+ * @param len received len, on return full message len
+ * @return EXTRUE - decoded, EXFALSE - message not in compact form,
+ *  EXFAIL - invalid compact message
+ */
+expublic int ndrx_callhdr_decode(char *buf, size_t buf_len, long *len)
+{
+    int ret = EXTRUE;
+    ndrx_callhdr_tmp_t tmp;
+    tp_command_call_cmpct_t *hdr = (tp_command_call_cmpct_t *)buf;
+    tp_command_call_t *call = (tp_command_call_t *)buf;
+    long hdr_len;
+    char *p, *end;
+    unsigned char tag;
+    size_t l;
+    ndrx_trace_t *trace;
+    long trace_len = 0;
+
+    if (*len < (long)sizeof(tp_command_call_cmpct_t) ||
+            NDRX_CALLHDR_CMPCT_MAGIC!=hdr->proto_magic)
+    {
+        ret = EXFALSE;
+        goto out;
+    }
+
+    hdr_len = sizeof(*hdr) + hdr->opt_len;
+
+    if (hdr->opt_len < 0 || hdr->data_len < 0 ||
+            hdr_len + hdr->data_len != *len ||
+            hdr_len > (long)sizeof(tmp) ||
+            sizeof(tp_command_call_t) + hdr->data_len > buf_len)
+    {
+        NDRX_LOG(log_error, "Invalid compact call header: len %ld opt_len %d "
+                "data_len %ld buf_len %ld", *len, hdr->opt_len, hdr->data_len,
+                (long)buf_len);
+        userlog("Invalid compact call header: len %ld opt_len %d "
+                "data_len %ld buf_len %ld", *len, hdr->opt_len, hdr->data_len,
+                (long)buf_len);
+        EXFAIL_OUT(ret);
+    }
+
+    memcpy(&tmp, buf, hdr_len);
+    hdr = &tmp.hdr;
+
+    /* payload goes up, then the header is rebuilt */
+    memmove(call->data, buf + hdr_len, hdr->data_len);
+    memset(call, 0, sizeof(*call));
+
+#if defined(EX_USE_SYSVQ) || defined(EX_USE_SVAPOLL)
+    call->mtype = hdr->mtype;
+#endif
+    call->command_id = hdr->command_id;
+    memcpy(call->proto_ver, hdr->proto_ver, sizeof(call->proto_ver));
+    call->buffer_type_id = hdr->buffer_type_id;
+    NDRX_STRCPY_SAFE(call->name, hdr->name);
+
+    call->sysflags = hdr->sysflags;
+    call->cd = hdr->cd;
+    call->rval = hdr->rval;
+    call->rcode = hdr->rcode;
+    call->user3 = hdr->user3;
+    call->user4 = hdr->user4;
+    call->clttout = hdr->clttout;
+    call->flags = hdr->flags;
+    call->timestamp = hdr->timestamp;
+    call->callseq = hdr->callseq;
+    call->msgseq = hdr->msgseq;
+    call->timer = hdr->timer;
+
+    call->tmtxflags = hdr->tmtxflags;
+    call->tmrmid = hdr->tmrmid;
+    call->tmnodeid = hdr->tmnodeid;
+    call->tmsrvid = hdr->tmsrvid;
+
+    call->data_len = hdr->data_len;
+
+    p = hdr->data;
+    end = hdr->data + hdr->opt_len;
+
+    /* tags with 0 len are alignment padding, unknown tags are skipped */
+    while (p + 2 <= end)
+    {
+        tag = (unsigned char)*p++;
+        l = (unsigned char)*p++;
+
+        if (p + l > end)
+        {
+            break;
+        }
+
+        switch (tag)
+        {
+            case NDRX_CALLHDR_TAG_REPLYTO:
+                CALLHDR_GET_STR(call->reply_to, p, l);
+                break;
+            case NDRX_CALLHDR_TAG_CALLSTACK:
+                CALLHDR_GET_STR(call->callstack, p, l);
+                break;
+            case NDRX_CALLHDR_TAG_MYID:
+                CALLHDR_GET_STR(call->my_id, p, l);
+                break;
+            case NDRX_CALLHDR_TAG_EXTRADATA:
+                CALLHDR_GET_STR(call->extradata, p, l);
+                break;
+            case NDRX_CALLHDR_TAG_TMXID:
+                CALLHDR_GET_STR(call->tmxid, p, l);
+                break;
+            case NDRX_CALLHDR_TAG_TMKNOWNRMS:
+                CALLHDR_GET_STR(call->tmknownrms, p, l);
+                break;
+            case NDRX_CALLHDR_TAG_TRACE:
+                trace = (ndrx_trace_t *)(call->data + 
+                        NDRX_TRACE_OFFSET(call->data_len));
+                
+                /* section is restored after the data, room for all hops */
+                if (l >= EXOFFSET(ndrx_trace_t, hops) && l <= sizeof(*trace) &&
+                        sizeof(tp_command_call_t) + 
+                        NDRX_TRACE_OFFSET(call->data_len) + sizeof(*trace) <= buf_len)
+                {
+                    memcpy(trace, p, l);
+
+                    if (trace->nhops >= 0 && NDRX_TRACE_LEN(trace) == l)
+                    {
+                        trace_len = NDRX_TRACE_OFFSET(call->data_len) - 
+                                call->data_len + l;
+                    }
+                }
+                break;
+        }
+
+        p+=l;
+    }
+
+    /* flag is kept only if the trace came along */
+    if (trace_len > 0)
+    {
+        call->sysflags |= SYS_FLAG_TRACE;
+    }
+    else
+    {
+        call->sysflags &= ~SYS_FLAG_TRACE;
+    }
+
+    *len = sizeof(tp_command_call_t) + call->data_len + trace_len;
+
+out:
+    return ret;
+}
+
+/**
+ * Send call or reply, using compact header if configured
+ * @param queue queue to send to
+ * @param call call to send (on success, buffer is left in compact form)
+ * @param len full message len
+ * @param flags ATMI flags
+ * @param msg_prio message priority
+ * @param is_local destination is local process (not a bridge)
+ * @return see ndrx_generic_q_send()
+ */
+expublic int ndrx_callhdr_q_send(char *queue, tp_command_call_t *call,
+        long len, long flags, int msg_prio, int is_local)
+{
+    int ret;
+    long cmpct_len = EXFAIL;
+
+    if (is_local && G_atmi_env.cmpcthdr > 0 &&
+            call->data_len <= G_atmi_env.cmpcthdr &&
+            (ATMI_COMMAND_TPREPLY==call->command_id ?
+                (call->sysflags & SYS_FLAG_CMPCTHDR) :
+                (ndrx_shm_get_svc_flags(call->name) & NDRXD_SVCINFO_CMPCTHDR)))
+    {
+        cmpct_len = ndrx_callhdr_encode(call, len);
+    }
+
+    ret = ndrx_generic_q_send(queue, (char *)call,
+            EXFAIL!=cmpct_len?cmpct_len:len, flags, msg_prio);
+
+    /* restore the call for callers error handling */
+    if (EXSUCCEED!=ret && EXFAIL!=cmpct_len)
+    {
+        ndrx_callhdr_decode((char *)call, NDRX_MSGSIZEMAX, &cmpct_len);
+    }
+
+    return ret;
+}
+
+/* vim: set ts=4 sw=4 et smartindent: */
@@ -0,0 +1,647 @@
+/**
+ * @brief Per-hop call latency tracing
+ *   Sampled tpacall() requests carry trace context (trace id, span id, parent
+ *   span id) and list of hop stamps: request enqueued, dequeued by server,
+ *   service function start/end, tpforward, bridge out/in and reply dequeued.
+ *   Stamps are microseconds relative to the monotonic base taken by the caller.
+ *   Bridges shift the base to the peer node clock (see bridge/clock.c), thus
+ *   stamps taken on different nodes are comparable. Calls made while serving
+ *   a traced request are traced too (same trace id, parent is the served
+ *   call). Sampling applies to root calls only, every NDRX_TRACESAMPLE-th
+ *   call is traced. Completed calls are written to the shared memory ring
+ *   of the application domain, from where they can be collected
+ *   (ndrx_calltrace_read(), xadmin `calltrace').
+ *   The trace goes as optional section after the call data, flagged by
+ *   SYS_FLAG_TRACE, thus calls not traced do not carry it. The server keeps
+ *   the trace of the call served in TLS (G_last_trace).
+ *
+ * @file calltrace.c
+ */
+/* -----------------------------------------------------------------------------
+ * Enduro/X Middleware Platform for Distributed Transaction Processing
+ * Copyright (C) 2009-2016, ATR Baltic, Ltd. All Rights Reserved.
+ * Copyright (C) 2017-2019, Mavimax, Ltd. All Rights Reserved.
+ * This software is released under one of the following licenses:
+ * AGPL (with Java and Go exceptions) or Mavimax's license for commercial use.
+ * See LICENSE file for full text.
+ * -----------------------------------------------------------------------------
+ * AGPL license:
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License, version 3 as published
+ * by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License, version 3
+ * for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * -----------------------------------------------------------------------------
+ * A commercial use license is available from Mavimax, Ltd
+ * contact@mavimax.com
+ * -----------------------------------------------------------------------------
+ */
+#include <ndrx_config.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/types.h>
+
+#include <ndrstandard.h>
+#include <ndebug.h>
+#include <atmi.h>
+#include <atmi_int.h>
+#include <userlog.h>
+#include <thlock.h>
+#include <nstd_shm.h>
+#include <nstdutil.h>
+/*---------------------------Externs------------------------------------*/
+/*---------------------------Macros-------------------------------------*/
+#define CT_SLOTS            1024    /**< Completed traces kept in ring  */
+
+#define CT_HDR              ((ndrx_calltrace_hdr_t *)M_ct_shm.mem)
+#define CT_REC(SEQ)         ((ndrx_calltrace_rec_t *)(M_ct_shm.mem + \
+                                sizeof(ndrx_calltrace_hdr_t)) + ((SEQ) % CT_SLOTS))
+/*---------------------------Enums--------------------------------------*/
+/*---------------------------Typedefs-----------------------------------*/
+
+/**
+ * Trace ring header, followed by CT_SLOTS records
+ */
+typedef struct
+{
+    unsigned long seq;  /**< Sequence of last record written, 0 - empty */
+    long padding;
+} ndrx_calltrace_hdr_t;
+
+/*---------------------------Globals------------------------------------*/
+/*---------------------------Statics------------------------------------*/
+
+exprivate ndrx_shm_t M_ct_shm = {.fd=EXFAIL, .path="", .mem=NULL}; /**< Ring shm */
+exprivate ndrx_sem_t M_ct_sem = {.semid=0};     /**< Protects the ring       */
+exprivate volatile int M_attached = EXFALSE;    /**< Are we attached ?       */
+exprivate int M_init_failed = EXFALSE;          /**< Do not retry the init   */
+exprivate MUTEX_LOCKDECL(M_ct_init_lock);       /**< Ring attach lock        */
+
+exprivate unsigned long M_idseq = 0;            /**< Id generator sequence   */
+exprivate unsigned long M_samplecnt = 0;        /**< Root calls seen         */
+exprivate MUTEX_LOCKDECL(M_ct_id_lock);         /**< Protects the counters   */
+
+/*---------------------------Prototypes---------------------------------*/
+
+/**
+ * Setup the ring shm and semaphore keys
+ */
+exprivate void ct_keys_set(void)
+{
+    M_ct_shm.fd = EXFAIL;
+    M_ct_shm.key = G_atmi_env.ipckey + NDRX_SHM_CALLTRACE_KEYOFSZ;
+    M_ct_shm.size = sizeof(ndrx_calltrace_hdr_t) +
+            sizeof(ndrx_calltrace_rec_t) * CT_SLOTS;
+    snprintf(M_ct_shm.path, sizeof(M_ct_shm.path), NDRX_SHM_CALLTRACE,
+            G_atmi_env.qprefix);
+
+    memset(&M_ct_sem, 0, sizeof(M_ct_sem));
+    M_ct_sem.key = G_atmi_env.ipckey + NDRX_SEM_CALLTRACELOCKS;
+    M_ct_sem.nrsems = 1;
+    M_ct_sem.maxreaders = 1;
+}
+
+/**
+ * Open or attach the trace ring. First process emitting the trace
+ * creates it.
+ * @return EXSUCCEED/EXFAIL
+ */
+exprivate int ct_init(void)
+{
+    int ret = EXSUCCEED;
+
+    MUTEX_LOCK_V(M_ct_init_lock);
+
+    if (M_attached)
+    {
+        goto out;
+    }
+
+    if (M_init_failed)
+    {
+        EXFAIL_OUT(ret);
+    }
+
+    ct_keys_set();
+
+    if (EXSUCCEED!=ndrx_shm_open(&M_ct_shm, EXTRUE))
+    {
+        NDRX_LOG(log_error, "Failed to open call trace ring [%s]",
+                M_ct_shm.path);
+        userlog("Failed to open call trace ring [%s] - traces are not "
+                "collected", M_ct_shm.path);
+        M_init_failed = EXTRUE;
+        EXFAIL_OUT(ret);
+    }
+
+    if (EXSUCCEED!=ndrx_sem_open(&M_ct_sem, EXTRUE))
+    {
+        NDRX_LOG(log_error, "Failed to open call trace ring semaphore");
+        userlog("Failed to open call trace ring semaphore - traces are not "
+                "collected");
+        ndrx_shm_close(&M_ct_shm);
+        M_init_failed = EXTRUE;
+        EXFAIL_OUT(ret);
+    }
+
+    NDRX_LOG(log_info, "Call trace ring [%s] attached, %d slots",
+            M_ct_shm.path, CT_SLOTS);
+
+    M_attached = EXTRUE;
+
+out:
+    MUTEX_UNLOCK_V(M_ct_init_lock);
+    return ret;
+}
+
+/**
+ * Generate trace/span id. Mix of node, pid, time and process sequence,
+ * thus unique within the cluster for practical purposes.
+ * @return positive id
+ */
+exprivate long ct_newid(void)
+{
+    unsigned long long h = 14695981039346656037ULL;
+    unsigned long long v[4];
+    unsigned char *p;
+    ndrx_stopwatch_t now;
+    size_t i;
+
+    ndrx_stopwatch_reset(&now);
+
+    MUTEX_LOCK_V(M_ct_id_lock);
+    v[0] = ++M_idseq;
+    MUTEX_UNLOCK_V(M_ct_id_lock);
+
+    v[1] = (unsigned long long)G_atmi_env.our_nodeid << 32 | (unsigned)getpid();
+    v[2] = (unsigned long long)now.t.tv_sec;
+    v[3] = (unsigned long long)now.t.tv_nsec;
+
+    /* FNV-1a */
+    for (p=(unsigned char *)v, i=0; i<sizeof(v); i++, p++)
+    {
+        h = (h ^ *p) * 1099511628211ULL;
+    }
+
+    h = (unsigned long long)((unsigned long)h & LONG_MAX);
+
+    return 0==h?1:(long)h;
+}
+
+/**
+ * Is root call sampled for tracing
+ * @return EXTRUE/EXFALSE
+ */
+exprivate int ct_sampled(void)
+{
+    int ret;
+
+    MUTEX_LOCK_V(M_ct_id_lock);
+    ret = (0==M_samplecnt++ % G_atmi_env.tracesample);
+    MUTEX_UNLOCK_V(M_ct_id_lock);
+
+    return ret;
+}
+
+/**
+ * Get trace section of the message
+ * @param call call or reply
+ * @param len message len, trace must fit in it
+ * @return trace or NULL if message is not traced
+ */
+expublic ndrx_trace_t *ndrx_calltrace_get(tp_command_call_t *call, long len)
+{
+    ndrx_trace_t *trace;
+    long off;
+
+    if (!(call->sysflags & SYS_FLAG_TRACE) || call->data_len < 0)
+    {
+        return NULL;
+    }
+
+    off = sizeof(tp_command_call_t) + NDRX_TRACE_OFFSET(call->data_len);
+
+    if (off + EXOFFSET(ndrx_trace_t, hops) > len)
+    {
+        NDRX_LOG(log_error, "Trace section missing: msg len %ld, trace at %ld",
+                len, off);
+        return NULL;
+    }
+
+    trace = (ndrx_trace_t *)(((char *)call) + off);
+
+    if (trace->nhops < 0 || trace->nhops > NDRX_TRACE_HOPS_MAX ||
+            off + NDRX_TRACE_LEN(trace) > len)
+    {
+        NDRX_LOG(log_error, "Invalid trace section: %d hops, msg len %ld",
+                trace->nhops, len);
+        return NULL;
+    }
+
+    return trace;
+}
+
+/**
+ * Put trace section after the call data. The message buffer (NDRX_MSGSIZEMAX)
+ * must hold full trace, as hops are added in place by bridges.
+ * @param call call or reply, data_len set
+ * @param trace trace to put
+ * @return bytes added to the message len, 0 - trace not put
+ */
+expublic long ndrx_calltrace_put(tp_command_call_t *call, ndrx_trace_t *trace)
+{
+    long off = NDRX_TRACE_OFFSET(call->data_len);
+
+    call->sysflags &= ~SYS_FLAG_TRACE;
+
+    if (0==trace->trace_id)
+    {
+        return 0;
+    }
+
+    if (sizeof(tp_command_call_t) + off + sizeof(ndrx_trace_t) > NDRX_MSGSIZEMAX)
+    {
+        NDRX_LOG(log_warn, "No space for trace after %ld bytes of data - "
+                "trace_id=%ld dropped", call->data_len, trace->trace_id);
+        return 0;
+    }
+
+    memcpy(call->data + off, trace, NDRX_TRACE_LEN(trace));
+    call->sysflags |= SYS_FLAG_TRACE;
+
+    return off - call->data_len + NDRX_TRACE_LEN(trace);
+}
+
+/**
+ * Start the trace of the outgoing call (ENQ hop). Call is traced if
+ * we serve traced call or if root call is sampled.
+ * @param call call being sent by tpacall(), data_len set
+ * @return bytes added to the message len
+ */
+expublic long ndrx_calltrace_begin(tp_command_call_t *call)
+{
+    ndrx_trace_t *last_trace = ndrx_get_G_last_trace();
+    ndrx_trace_t trace;
+
+    if (0!=last_trace->trace_id)
+    {
+        trace.trace_id = last_trace->trace_id;
+        trace.parent_id = last_trace->span_id;
+    }
+    else if (G_atmi_env.tracesample > 0 && ct_sampled())
+    {
+        trace.trace_id = ct_newid();
+        trace.parent_id = 0;
+    }
+    else
+    {
+        call->sysflags &= ~SYS_FLAG_TRACE;
+        return 0; /* <<<< RETURN, not traced */
+    }
+
+    trace.span_id = ct_newid();
+    trace.nhops = 0;
+    trace.padding = 0;
+    ndrx_stopwatch_reset(&trace.base);
+
+    ndrx_calltrace_hop(&trace, NDRX_TRACE_HOP_ENQ);
+
+    NDRX_LOG(log_debug, "Tracing call to [%s] trace_id=%ld span_id=%ld "
+            "parent_id=%ld", call->name, trace.trace_id, trace.span_id,
+            trace.parent_id);
+
+    return ndrx_calltrace_put(call, &trace);
+}
+
+/**
+ * Record hop of the traced call. Hops over NDRX_TRACE_HOPS_MAX are dropped.
+ * @param trace call trace (if not traced, nothing is done)
+ * @param kind hop kind, NDRX_TRACE_HOP_*
+ */
+expublic void ndrx_calltrace_hop(ndrx_trace_t *trace, short kind)
+{
+    ndrx_stopwatch_t now;
+    long long usec;
+    ndrx_trace_hop_t *hop;
+
+    if (0==trace->trace_id || trace->nhops >= NDRX_TRACE_HOPS_MAX ||
+            trace->nhops < 0)
+    {
+        return;
+    }
+
+    ndrx_stopwatch_reset(&now);
+
+    usec = ((long long)now.t.tv_sec - trace->base.t.tv_sec) * 1000000LL +
+            ((long long)now.t.tv_nsec - trace->base.t.tv_nsec) / 1000;
+
+    if (usec > INT_MAX)
+    {
+        usec = INT_MAX;
+    }
+    else if (usec < INT_MIN)
+    {
+        usec = INT_MIN;
+    }
+
+    hop = &trace->hops[trace->nhops];
+    hop->usec = (int)usec;
+    hop->kind = kind;
+    hop->nodeid = (short)G_atmi_env.our_nodeid;
+    trace->nhops++;
+}
+
+/**
+ * Record hop in the trace section of the message in transit (bridge).
+ * Message grows by the hop.
+ * @param call message, in buffer of NDRX_MSGSIZEMAX
+ * @param len message len, updated
+ * @param kind hop kind, NDRX_TRACE_HOP_*
+ */
+expublic void ndrx_calltrace_msghop(tp_command_call_t *call, long *len,
+        short kind)
+{
+    ndrx_trace_t *trace = ndrx_calltrace_get(call, *len);
+
+    if (NULL==trace)
+    {
+        return;
+    }
+
+    ndrx_calltrace_hop(trace, kind);
+
+    *len = sizeof(tp_command_call_t) + NDRX_TRACE_OFFSET(call->data_len) +
+            NDRX_TRACE_LEN(trace);
+}
+
+/**
+ * Server got the call (DEQ hop). Trace of the call is kept in TLS while
+ * the call is served.
+ * @param call call received
+ * @param len message len
+ */
+expublic void ndrx_calltrace_serve(tp_command_call_t *call, long len)
+{
+    ndrx_trace_t *last_trace = ndrx_get_G_last_trace();
+    ndrx_trace_t *trace = ndrx_calltrace_get(call, len);
+
+    if (NULL==trace)
+    {
+        last_trace->trace_id = 0;
+        return;
+    }
+
+    memcpy(last_trace, trace, NDRX_TRACE_LEN(trace));
+    ndrx_calltrace_hop(last_trace, NDRX_TRACE_HOP_DEQ);
+}
+
+/**
+ * Carry trace of the served call to the reply (SVCEND hop). Reply gets the
+ * service name, so that caller knows what was traced.
+ * @param reply reply being sent by tpreturn(), data_len set
+ * @param last_call call served
+ * @return bytes added to the message len
+ */
+expublic long ndrx_calltrace_reply(tp_command_call_t *reply,
+        tp_command_call_t *last_call)
+{
+    ndrx_trace_t *last_trace = ndrx_get_G_last_trace();
+    long ret;
+
+    if (0==last_trace->trace_id)
+    {
+        reply->sysflags &= ~SYS_FLAG_TRACE;
+        return 0;
+    }
+
+    ndrx_calltrace_hop(last_trace, NDRX_TRACE_HOP_SVCEND);
+    NDRX_STRCPY_SAFE(reply->name, last_call->name);
+    ret = ndrx_calltrace_put(reply, last_trace);
+
+    /* call served, do not trace calls made after the service */
+    last_trace->trace_id = 0;
+
+    return ret;
+}
+
+/**
+ * Carry trace of the served call to the forwarded call (FWD hop). Span
+ * stays the same, next service continues it.
+ * @param call call being sent by tpforward(), data_len set
+ * @return bytes added to the message len
+ */
+expublic long ndrx_calltrace_forward(tp_command_call_t *call)
+{
+    ndrx_trace_t *last_trace = ndrx_get_G_last_trace();
+    long ret;
+
+    if (0==last_trace->trace_id)
+    {
+        call->sysflags &= ~SYS_FLAG_TRACE;
+        return 0;
+    }
+
+    ndrx_calltrace_hop(last_trace, NDRX_TRACE_HOP_FWD);
+    ret = ndrx_calltrace_put(call, last_trace);
+
+    last_trace->trace_id = 0;
+
+    return ret;
+}
+
+/**
+ * Complete trace of the served TPNOREPLY call (SVCEND hop), as nobody
+ * waits for the reply.
+ * @param last_call call served
+ */
+expublic void ndrx_calltrace_noreply(tp_command_call_t *last_call)
+{
+    ndrx_trace_t *last_trace = ndrx_get_G_last_trace();
+
+    if (0==last_trace->trace_id)
+    {
+        return;
+    }
+
+    ndrx_calltrace_hop(last_trace, NDRX_TRACE_HOP_SVCEND);
+    ndrx_calltrace_emit(last_call, last_trace);
+
+    last_trace->trace_id = 0;
+}
+
+/**
+ * Write completed trace to the ring
+ * @param call completed call (reply for the caller, request for TPNOREPLY)
+ * @param trace trace of the call
+ */
+expublic void ndrx_calltrace_emit(tp_command_call_t *call, ndrx_trace_t *trace)
+{
+    ndrx_calltrace_rec_t *rec;
+    ndrx_calltrace_hdr_t *hdr;
+    long tusec;
+    int nhops;
+
+    if (0==trace->trace_id)
+    {
+        return;
+    }
+
+    if (!M_attached && EXSUCCEED!=ct_init())
+    {
+        return;
+    }
+
+    nhops = trace->nhops;
+
+    if (nhops < 0 || nhops > NDRX_TRACE_HOPS_MAX)
+    {
+        NDRX_LOG(log_error, "Invalid trace hops %d - not emitted", nhops);
+        return;
+    }
+
+    if (EXSUCCEED!=ndrx_sem_lock(&M_ct_sem, __func__, 0))
+    {
+        return;
+    }
+
+    hdr = CT_HDR;
+    hdr->seq++;
+
+    /* seq 0 marks free slot */
+    if (0==hdr->seq)
+    {
+        hdr->seq++;
+    }
+
+    rec = CT_REC(hdr->seq);
+
+    rec->seq = hdr->seq;
+    rec->trace_id = trace->trace_id;
+    rec->span_id = trace->span_id;
+    rec->parent_id = trace->parent_id;
+    NDRX_STRCPY_SAFE(rec->svcnm, call->name);
+    rec->nodeid = (short)G_atmi_env.our_nodeid;
+    rec->pid = getpid();
+    rec->rval = call->rval;
+    rec->rcode = call->rcode;
+    ndrx_utc_tstamp2(&rec->tstamp, &tusec);
+    rec->nhops = nhops;
+    memcpy(rec->hops, trace->hops, sizeof(ndrx_trace_hop_t)*nhops);
+
+    ndrx_sem_unlock(&M_ct_sem, __func__, 0);
+
+    NDRX_LOG(log_debug, "Trace trace_id=%ld span_id=%ld [%s] %d hops, "
+            "total %d usec emitted", trace->trace_id, trace->span_id, call->name,
+            nhops, nhops>0?trace->hops[nhops-1].usec:0);
+}
+
+/**
+ * Read completed traces from the ring, oldest first
+ * @param seq in: last sequence read (0 - read from the oldest),
+ *  out: last sequence returned
+ * @param recs records read
+ * @param max max records to read
+ * @return number of records read or EXFAIL
+ */
+expublic int ndrx_calltrace_read(unsigned long *seq,
+        ndrx_calltrace_rec_t *recs, int max)
+{
+    int ret = 0;
+    unsigned long head;
+    unsigned long cur;
+    ndrx_calltrace_rec_t *rec;
+
+    if (!M_attached && EXSUCCEED!=ct_init())
+    {
+        EXFAIL_OUT(ret);
+    }
+
+    if (EXSUCCEED!=ndrx_sem_lock(&M_ct_sem, __func__, 0))
+    {
+        EXFAIL_OUT(ret);
+    }
+
+    head = CT_HDR->seq;
+    cur = *seq + 1;
+
+    /* overwritten ones are lost */
+    if (head >= CT_SLOTS && cur <= head - CT_SLOTS)
+    {
+        cur = head - CT_SLOTS + 1;
+    }
+
+    /* ring restarted */
+    if (*seq > head || 0==cur)
+    {
+        cur = (head >= CT_SLOTS?head - CT_SLOTS + 1:1);
+    }
+
+    for (; cur <= head && ret < max; cur++)
+    {
+        rec = CT_REC(cur);
+
+        if (rec->seq!=cur)
+        {
+            continue;
+        }
+
+        memcpy(&recs[ret], rec, sizeof(*rec));
+        *seq = cur;
+        ret++;
+    }
+
+    ndrx_sem_unlock(&M_ct_sem, __func__, 0);
+
+out:
+    return ret;
+}
+
+/**
+ * Remove the trace ring (at application domain shutdown)
+ * @return EXSUCCEED/EXFAIL
+ */
+expublic int ndrx_calltrace_remove(void)
+{
+    int ret = EXSUCCEED;
+
+    MUTEX_LOCK_V(M_ct_init_lock);
+
+    if (M_attached)
+    {
+        ndrx_shm_close(&M_ct_shm);
+        M_attached = EXFALSE;
+    }
+    else
+    {
+        ct_keys_set();
+    }
+
+    if (EXSUCCEED!=ndrx_shm_remove(&M_ct_shm))
+    {
+        ret = EXFAIL;
+    }
+
+    if (EXSUCCEED==ndrx_sem_attach(&M_ct_sem) &&
+            EXSUCCEED!=ndrx_sem_remove(&M_ct_sem, EXTRUE))
+    {
+        ret = EXFAIL;
+    }
+
+    MUTEX_UNLOCK_V(M_ct_init_lock);
+
+    return ret;
+}
+
+/* vim: set ts=4 sw=4 et smartindent: */
@@ -215,6 +215,7 @@ expublic int ndrx_reject_connection(int err)
     call->data_len = 0;
     call->callseq = G_atmi_tls->G_last_call.callseq;
     call->msgseq = NDRX_CONF_MSGSEQ_START;
+    call->convgen = G_atmi_tls->G_last_call.convgen_snd;
     call->command_id = ATMI_COMMAND_CONNRPLY;
     call->flags = 0;
     call->sysflags|=SYS_FLAG_REPLY_ERROR;
@@ -271,25 +272,44 @@ expublic int accept_connection(void)
     conv->msgseqout = NDRX_CONF_MSGSEQ_START;
     conv->msgseqin = NDRX_CONF_MSGSEQ_START;
     conv->callseq = G_atmi_tls->G_last_call.callseq;
-    /* 1. Open listening queue */
-    snprintf(conv->my_listen_q_str, sizeof(conv->my_listen_q_str), 
-                    NDRX_CONV_SRV_Q,
-                    G_atmi_tls->G_atmi_conf.q_prefix, 
-                    G_atmi_tls->G_last_call.my_id, 
-                    conv->cd,
-                    /* In accepted connection we put their id */
-                    G_atmi_tls->G_atmi_conf.my_id
-                    );
     conv->reply_q = (mqd_t)EXFAIL;
+    conv->my_listen_q = (mqd_t)EXFAIL;
+    conv->pool_ent = NULL;
+    conv->reply_q_pooled = !!(G_atmi_tls->G_last_call.sysflags & SYS_FLAG_CONVPOOL);
+    conv->gen_in = 0;
+    conv->gen_out = G_atmi_tls->G_last_call.convgen_snd;
+    NDRX_STRCPY_SAFE(conv->their_id, G_atmi_tls->G_last_call.my_id);
     
-    /* TODO: Firstly we should open the queue on which to listen right? */
-    if ((mqd_t)EXFAIL==(conv->my_listen_q =
-                    open_conv_q(conv->my_listen_q_str, &conv->my_q_attr)))
+    /* 1. Open listening queue, pooled one if available */
+    if (EXFAIL==(ret=ndrx_convpool_get(conv, EXTRUE)))
     {
-        NDRX_LOG(log_error, "%s: Failed to open listen queue", __func__);
-        ret=EXFAIL;
+        NDRX_LOG(log_error, "%s: Failed to get pooled listen queue", __func__);
         goto out;
     }
+    else if (EXTRUE==ret)
+    {
+        ret=EXSUCCEED;
+    }
+    else
+    {
+        snprintf(conv->my_listen_q_str, sizeof(conv->my_listen_q_str), 
+                        NDRX_CONV_SRV_Q,
+                        G_atmi_tls->G_atmi_conf.q_prefix, 
+                        G_atmi_tls->G_last_call.my_id, 
+                        conv->cd,
+                        /* In accepted connection we put their id */
+                        G_atmi_tls->G_atmi_conf.my_id
+                        );
+
+        /* TODO: Firstly we should open the queue on which to listen right? */
+        if ((mqd_t)EXFAIL==(conv->my_listen_q =
+                        open_conv_q(conv->my_listen_q_str, &conv->my_q_attr)))
+        {
+            NDRX_LOG(log_error, "%s: Failed to open listen queue", __func__);
+            ret=EXFAIL;
+            goto out;
+        }
+    }
 
     /* 2. Connect to their reply queue */
     NDRX_STRCPY_SAFE(conv->reply_q_str, G_atmi_tls->G_last_call.reply_to);
@@ -355,7 +375,11 @@ expublic int accept_connection(void)
 out:
 
     /* Close down the queue if we fail but queue was opened! */
-    if (EXSUCCEED!=ret)
+    if (EXSUCCEED!=ret && NULL!=conv->pool_ent)
+    {
+        ndrx_convpool_put(conv);
+    }
+    else if (EXSUCCEED!=ret)
     {
         if ((mqd_t)EXFAIL!=conv->my_listen_q && 
             EXFAIL==ndrx_mq_close(conv->my_listen_q))
@@ -436,14 +460,20 @@ expublic int normal_connection_shutdown(tp_conversation_control_t *conv, int kil
         char *dbgmsg)
 {
     int ret=EXSUCCEED;
+    int pooled = (NULL!=conv->pool_ent);
     ATMI_TLS_ENTRY;
     
     NDRX_LOG(log_debug, "%s: %s: Closing [%s] killq=%d cd=%d my_listen_q=%p reply_q=%p",
 		 __func__, dbgmsg, conv->my_listen_q_str, killq, conv->cd,
 		(void *)(long)conv->my_listen_q, (void*)(long)conv->reply_q);
 
+    /* pooled queue stays open for the next conversation */
+    if (pooled)
+    {
+        ndrx_convpool_put(conv);
+    }
     /* close down the queue */
-    if ((mqd_t)EXFAIL!=conv->my_listen_q && EXSUCCEED!=ndrx_mq_close(conv->my_listen_q))
+    else if ((mqd_t)EXFAIL!=conv->my_listen_q && EXSUCCEED!=ndrx_mq_close(conv->my_listen_q))
     {
         NDRX_LOG(log_warn, "Failed to ndrx_mq_close [%s]: %s",
                                          conv->my_listen_q_str, strerror(errno));
@@ -454,7 +484,7 @@ expublic int normal_connection_shutdown(tp_conversation_control_t *conv, int kil
     }
     
     /* Remove the queue */
-    if (killq && EXSUCCEED!=ndrx_mq_unlink(conv->my_listen_q_str))
+    if (killq && !pooled && EXSUCCEED!=ndrx_mq_unlink(conv->my_listen_q_str))
     {
         NDRX_LOG(log_warn, "Failed to ndrx_mq_unlink [%s]: %s",
                                          conv->my_listen_q_str, strerror(errno));
@@ -480,8 +510,10 @@ expublic int normal_connection_shutdown(tp_conversation_control_t *conv, int kil
     }
     
     /* Remove the queue */
-    NDRX_LOG(log_warn, "UNLINKING: %s %d", conv->reply_q_str, killq);
-    if (killq && EXSUCCEED!=ndrx_mq_unlink(conv->reply_q_str))
+    NDRX_LOG(log_warn, "UNLINKING: %s %d", conv->reply_q_str, 
+            killq && !conv->reply_q_pooled);
+    if (killq && !conv->reply_q_pooled && 
+            EXSUCCEED!=ndrx_mq_unlink(conv->reply_q_str))
     {
         NDRX_LOG(log_warn, "Failed to ndrx_mq_unlink [%s]: %s",
                                          conv->reply_q_str, strerror(errno));
@@ -778,25 +810,50 @@ expublic int ndrx_tpconnect (char *svc, char *data, long len, long flags)
     data_len+=sizeof(tp_command_call_t);
     
 
-    /* Format the conversational reply queue */
-    snprintf(reply_qstr, sizeof(reply_qstr), NDRX_CONV_INITATOR_Q, 
-            G_atmi_tls->G_atmi_conf.q_prefix,  G_atmi_tls->G_atmi_conf.my_id, cd);
+    conv->pool_ent = NULL;
+    conv->reply_q_pooled = EXFALSE;
+    conv->gen_in = 0;
+    conv->gen_out = 0;
+    conv->their_id[0] = EXEOS;
     
-    NDRX_LOG(log_debug, "%s/%s/%d reply_qstr: [%s]",
-		G_atmi_tls->G_atmi_conf.q_prefix,  G_atmi_tls->G_atmi_conf.my_id, 
-                cd, reply_qstr);
-    NDRX_STRCPY_SAFE(call->reply_to, reply_qstr);
-
-    /* TODO: Firstly we should open the queue on which to listen right? */
-    if ((mqd_t)EXFAIL==(conv->my_listen_q =
-                    open_conv_q(reply_qstr, &conv->my_q_attr)))
+    /* Take the conversational reply queue from pool, if available */
+    if (EXFAIL==(ret=ndrx_convpool_get(conv, EXFALSE)))
     {
-        NDRX_LOG(log_error, "%s: Failed to open listen queue", __func__);
-        ret=EXFAIL;
+        NDRX_LOG(log_error, "%s: Failed to get pooled listen queue", __func__);
         goto out;
     }
+    else if (EXTRUE==ret)
+    {
+        ret=EXSUCCEED;
+        NDRX_STRCPY_SAFE(reply_qstr, conv->my_listen_q_str);
+        /* let server know that queue shall not be removed */
+        call->sysflags|=SYS_FLAG_CONVPOOL;
+    }
+    else
+    {
+        /* Format the conversational reply queue */
+        snprintf(reply_qstr, sizeof(reply_qstr), NDRX_CONV_INITATOR_Q, 
+                G_atmi_tls->G_atmi_conf.q_prefix,  G_atmi_tls->G_atmi_conf.my_id, cd);
+
+        NDRX_LOG(log_debug, "%s/%s/%d reply_qstr: [%s]",
+                    G_atmi_tls->G_atmi_conf.q_prefix,  G_atmi_tls->G_atmi_conf.my_id, 
+                    cd, reply_qstr);
 
-    NDRX_STRCPY_SAFE(conv->my_listen_q_str, reply_qstr);
+        /* TODO: Firstly we should open the queue on which to listen right? */
+        if ((mqd_t)EXFAIL==(conv->my_listen_q =
+                        open_conv_q(reply_qstr, &conv->my_q_attr)))
+        {
+            NDRX_LOG(log_error, "%s: Failed to open listen queue", __func__);
+            ret=EXFAIL;
+            goto out;
+        }
+
+        NDRX_STRCPY_SAFE(conv->my_listen_q_str, reply_qstr);
+    }
+    
+    NDRX_STRCPY_SAFE(call->reply_to, reply_qstr);
+    /* server echoes our queue generation */
+    call->convgen_snd = conv->gen_in;
 
     call->command_id = ATMI_COMMAND_CONNECT;
 
@@ -1140,12 +1197,24 @@ expublic int ndrx_tprecv (int cd, char **data,
         }
         else
         {
-            /* if answer is not expected, then we receive again! */
-            if (conv->cd!=rply->cd)
+            /* if answer is not expected, then we receive again! 
+             * generation tells apart earlier conversation on pooled queue,
+             * error replies may be generated by bridge or ndrxd, thus
+             * peer identity is checked for the others only.
+             */
+            if (conv->cd!=rply->cd || conv->callseq!=rply->callseq ||
+                    conv->gen_in!=rply->convgen ||
+                    (EXEOS!=conv->their_id[0] && 
+                        !(rply->sysflags & SYS_FLAG_REPLY_ERROR) &&
+                        0!=strcmp(conv->their_id, rply->my_id)))
             {
                 NDRX_LOG(log_warn, "Dropping incoming message (not expected): "
-                        "expected cd: %d, cd: %d, timestamp :%d, callseq: %hu, reply from [%s]",
-                        conv->cd, rply->cd, rply->timestamp, rply->callseq, rply->reply_to);
+                        "expected cd: %d, callseq: %hu, gen: %hu, peer: [%s], "
+                        "cd: %d, timestamp :%d, callseq: %hu, gen: %hu, "
+                        "peer: [%s], reply from [%s]",
+                        conv->cd, conv->callseq, conv->gen_in, conv->their_id,
+                        rply->cd, rply->timestamp, rply->callseq, 
+                        rply->convgen, rply->my_id, rply->reply_to);
                 /* clear the attributes we got... 
                 memset(rply_buf, 0, sizeof(*rply_buf));
                  * Really need a memset?
@@ -1230,6 +1299,10 @@ inject_message:
                  * so we do not use buffer management here!
                  */
                 strcpy((char *)*data, rply->data); /* return reply queue */
+                conv->reply_q_pooled = !!(rply->sysflags & SYS_FLAG_CONVPOOL);
+                /* server's queue generation and identity */
+                conv->gen_out = rply->convgen_snd;
+                NDRX_STRCPY_SAFE(conv->their_id, rply->my_id);
             }
             else
             {
@@ -1520,6 +1593,12 @@ expublic int ndrx_tpsend (int cd, char *data, long len, long flags, long *revent
         /* Indicate that this is string buffer! */
         call->buffer_type_id = BUF_TYPE_STRING;
         strcpy(call->data, conv->my_listen_q_str);
+        
+        /* client shall not remove our pooled queue */
+        if (NULL!=conv->pool_ent)
+        {
+            call->sysflags|=SYS_FLAG_CONVPOOL;
+        }
         data_len = strlen(call->data) + 1; /* Include EOS... */
     }
     else
@@ -1551,6 +1630,10 @@ expublic int ndrx_tpsend (int cd, char *data, long len, long flags, long *revent
 
     call->callseq = conv->callseq;
     call->msgseq = conv->msgseqout;
+    /* peer checks its queue generation and our identity */
+    call->convgen = conv->gen_out;
+    call->convgen_snd = conv->gen_in;
+    NDRX_STRCPY_SAFE(call->my_id, G_atmi_tls->G_atmi_conf.my_id);
     
     
     /* So here is little trick for bridge.
@@ -0,0 +1,439 @@
+/**
+ * @brief Conversation queue pool. Listening queues of tpconnect() initiator
+ *   and of accepted conversations are taken from per process pool instead of
+ *   being created and unlinked for each conversation. Pooled queue names
+ *   carry the owner's id (same format as normal conversation queues, with
+ *   the pool index in place of cd), thus ndrxd sanity checks remove them when
+ *   process dies. Peer is told with SYS_FLAG_CONVPOOL that queue must not be
+ *   unlinked at shutdown. Each reuse starts new generation: left over
+ *   messages are flushed. Generation is announced to the peer at connect
+ *   (convgen_snd) and peer echoes it in every message (convgen), thus late
+ *   messages of earlier conversation are dropped by receiver.
+ *   Pool is enabled by NDRX_CONVPOOL (number of queues per role).
+ *
+ * @file convpool.c
+ */
+/* -----------------------------------------------------------------------------
+ * Enduro/X Middleware Platform for Distributed Transaction Processing
+ * Copyright (C) 2009-2016, ATR Baltic, Ltd. All Rights Reserved.
+ * Copyright (C) 2017-2019, Mavimax, Ltd. All Rights Reserved.
+ * This software is released under one of the following licenses:
+ * AGPL (with Java and Go exceptions) or Mavimax's license for commercial use.
+ * See LICENSE file for full text.
+ * -----------------------------------------------------------------------------
+ * AGPL license:
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License, version 3 as published
+ * by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License, version 3
+ * for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * -----------------------------------------------------------------------------
+ * A commercial use license is available from Mavimax, Ltd
+ * contact@mavimax.com
+ * -----------------------------------------------------------------------------
+ */
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <pthread.h>
+
+#include <ndrstandard.h>
+#include <ndebug.h>
+#include <atmi.h>
+#include <atmi_int.h>
+#include <atmi_tls.h>
+#include <userlog.h>
+#include <thlock.h>
+#include <sys_unix.h>
+/*---------------------------Externs------------------------------------*/
+/*---------------------------Macros-------------------------------------*/
+#define CONVPOOL_INIT       0   /**< Role: conversation initiator       */
+#define CONVPOOL_SRV        1   /**< Role: accepted conversation        */
+/*---------------------------Enums--------------------------------------*/
+/*---------------------------Typedefs-----------------------------------*/
+
+/**
+ * Pooled conversation queue
+ */
+struct ndrx_convpool_ent
+{
+    int role;           /**< CONVPOOL_INIT or CONVPOOL_SRV              */
+    int idx;            /**< Index in role, used in the queue name      */
+    int in_use;         /**< Queue is given to conversation             */
+    unsigned gen;       /**< Generation, incremented on each use        */
+    mqd_t q;            /**< Open queue, EXFAIL - not created yet       */
+    struct mq_attr attr;/**< Current queue attributes                   */
+    char qstr[NDRX_MAX_Q_SIZE+1]; /**< Queue name                       */
+};
+
+/*---------------------------Globals------------------------------------*/
+/*---------------------------Statics------------------------------------*/
+
+exprivate MUTEX_LOCKDECL(M_pool_lock);          /**< Protects the pool       */
+exprivate ndrx_convpool_ent_t *M_pool = NULL;   /**< Both roles, INIT first  */
+exprivate int M_pool_size = 0;                  /**< Queues per role         */
+exprivate int M_atfork_first = EXTRUE;          /**< Fork handlers not set   */
+
+/*---------------------------Prototypes---------------------------------*/
+
+/**
+ * Hold the pool lock over the fork, so that child gets consistent pool
+ */
+exprivate void convpool_atfork_prepare(void)
+{
+    MUTEX_LOCK_V(M_pool_lock);
+}
+
+/**
+ * Parent continues with its pool
+ */
+exprivate void convpool_atfork_parent(void)
+{
+    MUTEX_UNLOCK_V(M_pool_lock);
+}
+
+/**
+ * Queues in the pool belong to the parent (named by parent's id), thus
+ * child starts with empty pool. Free queues are closed, queues given to
+ * conversations of the forking thread stay with them and are closed by
+ * the conversation (the old array is kept then, see ndrx_convpool_put()).
+ */
+exprivate void convpool_atfork_child(void)
+{
+    int i;
+    int in_use = EXFALSE;
+    
+    if (NULL!=M_pool)
+    {
+        for (i=0; i<M_pool_size*2; i++)
+        {
+            if (M_pool[i].in_use)
+            {
+                in_use = EXTRUE;
+            }
+            else if ((mqd_t)EXFAIL!=M_pool[i].q)
+            {
+                ndrx_mq_close(M_pool[i].q);
+            }
+        }
+        
+        if (!in_use)
+        {
+            NDRX_FREE(M_pool);
+        }
+        
+        M_pool = NULL;
+        M_pool_size = 0;
+    }
+    
+    MUTEX_UNLOCK_V(M_pool_lock);
+}
+
+/**
+ * Setup the pool on first use.
+ * Must be called with M_pool_lock locked.
+ * @return EXSUCCEED/EXFAIL
+ */
+exprivate int convpool_init(void)
+{
+    int ret = EXSUCCEED;
+    int i;
+    
+    if (NULL!=M_pool || G_atmi_env.convpool <= 0)
+    {
+        goto out;
+    }
+    
+    if (M_atfork_first)
+    {
+        if (0!=(ret=pthread_atfork(convpool_atfork_prepare, 
+                convpool_atfork_parent, convpool_atfork_child)))
+        {
+            NDRX_LOG(log_error, "Failed to register fork handlers: %s",
+                    strerror(ret));
+            userlog("Failed to register fork handlers: %s", strerror(ret));
+            EXFAIL_OUT(ret);
+        }
+        
+        M_atfork_first = EXFALSE;
+    }
+    
+    if (NULL==(M_pool=NDRX_CALLOC(G_atmi_env.convpool*2, 
+            sizeof(ndrx_convpool_ent_t))))
+    {
+        NDRX_LOG(log_error, "Failed to alloc conversation queue pool: %s",
+                strerror(errno));
+        userlog("Failed to alloc conversation queue pool: %s",
+                strerror(errno));
+        EXFAIL_OUT(ret);
+    }
+    
+    M_pool_size = G_atmi_env.convpool;
+    
+    for (i=0; i<M_pool_size*2; i++)
+    {
+        M_pool[i].role = i < M_pool_size?CONVPOOL_INIT:CONVPOOL_SRV;
+        M_pool[i].idx = i % M_pool_size;
+        M_pool[i].q = (mqd_t)EXFAIL;
+    }
+    
+    NDRX_LOG(log_debug, "Conversation queue pool: %d queues per role", 
+            M_pool_size);
+    
+out:
+    return ret;
+}
+
+/**
+ * Flush messages left from previous conversation
+ * @param ent pooled queue
+ * @return EXSUCCEED/EXFAIL
+ */
+exprivate int convpool_flush(ndrx_convpool_ent_t *ent)
+{
+    int ret = EXSUCCEED;
+    struct mq_attr attr;
+    char *buf = NULL;
+    size_t buf_len;
+    unsigned prio;
+    ssize_t len;
+    int nr = 0;
+    
+    if (EXFAIL==ndrx_mq_getattr(ent->q, &attr))
+    {
+        ndrx_TPset_error_fmt(TPEOS, "%s: Failed to read attributes "
+                "for queue [%s]: %s", __func__, ent->qstr, strerror(errno));
+        EXFAIL_OUT(ret);
+    }
+    
+    if (attr.mq_curmsgs <= 0)
+    {
+        goto out;
+    }
+    
+    if (EXSUCCEED!=ndrx_setup_queue_attrs(&ent->attr, ent->q, ent->qstr, 
+            TPNOBLOCK))
+    {
+        EXFAIL_OUT(ret);
+    }
+    
+    NDRX_SYSBUF_MALLOC_WERR_OUT(buf, buf_len, ret);
+    
+    while ((len=ndrx_generic_q_receive(ent->q, NULL, NULL, buf, buf_len, 
+            &prio, TPNOBLOCK)) > 0)
+    {
+        nr++;
+    }
+    
+    if (EXFAIL==len)
+    {
+        EXFAIL_OUT(ret);
+    }
+    
+    NDRX_LOG(log_info, "Dropped %d stale messages from [%s] gen %u", 
+            nr, ent->qstr, ent->gen);
+    
+out:
+    
+    if (NULL!=buf)
+    {
+        NDRX_SYSBUF_FREE(buf);
+    }
+
+    return ret;
+}
+
+/**
+ * Take listening queue for the conversation from the pool.
+ * @param conv conversation, on success listen queue fields and pool_ent are set
+ * @param is_srv EXTRUE - accepted conversation, EXFALSE - initiator
+ * @return EXTRUE - got pooled queue, EXFALSE - pool is not used or exhausted
+ *  (caller creates own queue), EXFAIL - error (TP error set)
+ */
+expublic int ndrx_convpool_get(tp_conversation_control_t *conv, int is_srv)
+{
+    int ret = EXFALSE;
+    int i;
+    int role = is_srv?CONVPOOL_SRV:CONVPOOL_INIT;
+    ndrx_convpool_ent_t *ent = NULL;
+    ATMI_TLS_ENTRY;
+    
+    if (G_atmi_env.convpool <= 0)
+    {
+        goto out;
+    }
+    
+    MUTEX_LOCK_V(M_pool_lock);
+    
+    if (EXSUCCEED!=convpool_init())
+    {
+        MUTEX_UNLOCK_V(M_pool_lock);
+        ndrx_TPset_error_msg(TPEOS, "Failed to init conversation queue pool");
+        EXFAIL_OUT(ret);
+    }
+    
+    for (i=role*M_pool_size; i<(role+1)*M_pool_size; i++)
+    {
+        if (!M_pool[i].in_use)
+        {
+            ent = &M_pool[i];
+            ent->in_use = EXTRUE;
+            break;
+        }
+    }
+    
+    MUTEX_UNLOCK_V(M_pool_lock);
+    
+    if (NULL==ent)
+    {
+        NDRX_LOG(log_info, "Conversation queue pool exhausted (%d) - "
+                "using own queue", M_pool_size);
+        goto out;
+    }
+    
+    if ((mqd_t)EXFAIL==ent->q)
+    {
+        if (is_srv)
+        {
+            /* our id in both halves, so that sanity checks us */
+            snprintf(ent->qstr, sizeof(ent->qstr), NDRX_CONV_SRV_Q,
+                    G_atmi_tls->G_atmi_conf.q_prefix, 
+                    G_atmi_tls->G_atmi_conf.my_id, 
+                    NDRX_CONV_POOL_CD+ent->idx,
+                    G_atmi_tls->G_atmi_conf.my_id);
+        }
+        else
+        {
+            snprintf(ent->qstr, sizeof(ent->qstr), NDRX_CONV_INITATOR_Q,
+                    G_atmi_tls->G_atmi_conf.q_prefix, 
+                    G_atmi_tls->G_atmi_conf.my_id, 
+                    NDRX_CONV_POOL_CD+ent->idx);
+        }
+        
+        ent->q = ndrx_mq_open_at(ent->qstr, O_RDWR | O_CREAT, 
+                S_IWUSR | S_IRUSR, NULL);
+        
+        if ((mqd_t)EXFAIL==ent->q || EXFAIL==ndrx_mq_getattr(ent->q, &ent->attr))
+        {
+            ndrx_TPset_error_fmt(TPEOS, "%s: Failed to open queue [%s]: %s",  
+                    __func__, ent->qstr, strerror(errno));
+            
+            if ((mqd_t)EXFAIL!=ent->q)
+            {
+                ndrx_mq_close(ent->q);
+                ndrx_mq_unlink(ent->qstr);
+                ent->q = (mqd_t)EXFAIL;
+            }
+            
+            MUTEX_LOCK_V(M_pool_lock);
+            ent->in_use = EXFALSE;
+            MUTEX_UNLOCK_V(M_pool_lock);
+            EXFAIL_OUT(ret);
+        }
+        
+        NDRX_LOG(log_debug, "Created pooled conversation queue [%s]", 
+                ent->qstr);
+    }
+    else if (EXSUCCEED!=convpool_flush(ent))
+    {
+        MUTEX_LOCK_V(M_pool_lock);
+        ent->in_use = EXFALSE;
+        MUTEX_UNLOCK_V(M_pool_lock);
+        EXFAIL_OUT(ret);
+    }
+    
+    ent->gen++;
+    
+    NDRX_STRCPY_SAFE(conv->my_listen_q_str, ent->qstr);
+    conv->my_listen_q = ent->q;
+    memcpy(&conv->my_q_attr, &ent->attr, sizeof(ent->attr));
+    conv->pool_ent = ent;
+    conv->gen_in = (unsigned short)ent->gen;
+    
+    NDRX_LOG(log_debug, "Using pooled conversation queue [%s] gen %u", 
+            ent->qstr, ent->gen);
+    
+    ret = EXTRUE;
+    
+out:
+    return ret;
+}
+
+/**
+ * Return conversation's listen queue to the pool. Queue is left open and
+ * linked, attributes changed by the conversation are kept.
+ * @param conv conversation holding pooled queue
+ */
+expublic void ndrx_convpool_put(tp_conversation_control_t *conv)
+{
+    ndrx_convpool_ent_t *ent = conv->pool_ent;
+    
+    MUTEX_LOCK_V(M_pool_lock);
+    
+    if (NULL!=M_pool && ent>=M_pool && ent<M_pool+M_pool_size*2)
+    {
+        memcpy(&ent->attr, &conv->my_q_attr, sizeof(conv->my_q_attr));
+        ent->in_use = EXFALSE;
+    }
+    else
+    {
+        /* parent's queue, pool was reset by fork */
+        NDRX_LOG(log_debug, "Closing parent's pooled queue [%s]", ent->qstr);
+        ndrx_mq_close(ent->q);
+    }
+    
+    MUTEX_UNLOCK_V(M_pool_lock);
+    
+    conv->pool_ent = NULL;
+    conv->my_listen_q = (mqd_t)EXFAIL;
+}
+
+/**
+ * Remove free pooled queues (client does tpterm). Queues used by other
+ * contexts are left in pool. Queues of dead processes are removed by ndrxd.
+ */
+expublic void ndrx_convpool_close(void)
+{
+    int i;
+    
+    MUTEX_LOCK_V(M_pool_lock);
+    
+    if (NULL==M_pool)
+    {
+        goto out;
+    }
+    
+    for (i=0; i<M_pool_size*2; i++)
+    {
+        if (!M_pool[i].in_use && (mqd_t)EXFAIL!=M_pool[i].q)
+        {
+            NDRX_LOG(log_debug, "Removing pooled conversation queue [%s]", 
+                    M_pool[i].qstr);
+            ndrx_mq_close(M_pool[i].q);
+            
+            if (EXSUCCEED!=ndrx_mq_unlink(M_pool[i].qstr))
+            {
+                NDRX_LOG(log_warn, "Failed to unlink [%s]: %s",
+                        M_pool[i].qstr, strerror(errno));
+            }
+            M_pool[i].q = (mqd_t)EXFAIL;
+        }
+    }
+    
+out:
+    MUTEX_UNLOCK_V(M_pool_lock);
+}
+
+/* vim: set ts=4 sw=4 et smartindent: */
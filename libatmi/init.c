@@ -630,6 +630,89 @@ expublic int ndrx_load_common_env(void)
     NDRX_LOG(log_debug, "routing criterion space: %d bytes, max services: %d", 
             G_atmi_env.rtcrtmax, G_atmi_env.rtsvcmax);
     
+    /* large message pool, off by default */
+    if (NULL!=(p=getenv(CONF_NDRX_LMSGPOOL)))
+    {
+        G_atmi_env.lmsgpool = atoi(p);
+        
+        if (G_atmi_env.lmsgpool<0)
+        {
+            G_atmi_env.lmsgpool = 0;
+        }
+    }
+    else
+    {
+        G_atmi_env.lmsgpool = 0;
+    }
+    
+    if (NULL!=(p=getenv(CONF_NDRX_LMSGTHRES)))
+    {
+        G_atmi_env.lmsgthres = atol(p);
+        
+        if (G_atmi_env.lmsgthres<1)
+        {
+            G_atmi_env.lmsgthres = CONF_NDRX_LMSGTHRES_DFLT;
+        }
+    }
+    else
+    {
+        G_atmi_env.lmsgthres = CONF_NDRX_LMSGTHRES_DFLT;
+    }
+    
+    NDRX_LOG(log_debug, "large message pool: %d slabs, threshold: %ld bytes", 
+            G_atmi_env.lmsgpool, G_atmi_env.lmsgthres);
+    
+    if (NULL!=(p=getenv(CONF_NDRX_CMPCTHDR)))
+    {
+        G_atmi_env.cmpcthdr = atol(p);
+        
+        if (G_atmi_env.cmpcthdr<0)
+        {
+            G_atmi_env.cmpcthdr = 0;
+        }
+    }
+    else
+    {
+        G_atmi_env.cmpcthdr = 0;
+    }
+    
+    NDRX_LOG(log_debug, "compact call header max payload: %ld bytes", 
+            G_atmi_env.cmpcthdr);
+    
+    if (NULL!=(p=getenv(CONF_NDRX_CONVPOOL)))
+    {
+        G_atmi_env.convpool = atoi(p);
+        
+        if (G_atmi_env.convpool<0)
+        {
+            G_atmi_env.convpool = 0;
+        }
+    }
+    else
+    {
+        G_atmi_env.convpool = 0;
+    }
+    
+    NDRX_LOG(log_debug, "conversation queue pool: %d queues per role", 
+            G_atmi_env.convpool);
+    
+    if (NULL!=(p=getenv(CONF_NDRX_TRACESAMPLE)))
+    {
+        G_atmi_env.tracesample = atoi(p);
+        
+        if (G_atmi_env.tracesample<0)
+        {
+            G_atmi_env.tracesample = 0;
+        }
+    }
+    else
+    {
+        G_atmi_env.tracesample = 0;
+    }
+    
+    NDRX_LOG(log_debug, "call trace sampling: every %d root call(s), 0 - off", 
+            G_atmi_env.tracesample);
+    
     if (NULL!=(p=getenv(CONF_NDRX_RTGRP)))
     {
         
@@ -713,6 +796,9 @@ expublic int ndrx_tpterm (void)
     
     /* Close XA  */
     atmi_xa_uninit();
+    
+    /* pooled conversation queues not used by other contexts */
+    ndrx_convpool_close();
 
     /* Shutdown client queues */
     if (0!=G_atmi_tls->G_atmi_conf.reply_q)
@@ -841,6 +927,7 @@ expublic int tp_internal_init(atmi_lib_conf_t *init_data)
     
     /* reset last call (server side stuff) */
     memset(&G_atmi_tls->G_last_call, 0, sizeof(G_atmi_tls->G_last_call));
+    G_atmi_tls->G_last_trace.trace_id = 0;
     
     /* reset conversation info */
     memset(&G_atmi_tls->G_tp_conversation_status, 0, 
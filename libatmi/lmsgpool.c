@@ -0,0 +1,583 @@
+/**
+ * @brief Large message pool. Shared memory slabs for passing big call
+ *   payloads between local processes. Only the small slab reference is sent
+ *   over the IPC queue, thus payload is not copied into and out of the kernel.
+ *   Pool is enabled by NDRX_LMSGPOOL (number of slabs). Each slab is
+ *   NDRX_MSGSIZEMAX big, buffers from NDRX_LMSGTHRES size are passed by the
+ *   pool. If pool is exhausted, message is sent via the queue as usual.
+ *
+ * @file lmsgpool.c
+ */
+/* -----------------------------------------------------------------------------
+ * Enduro/X Middleware Platform for Distributed Transaction Processing
+ * Copyright (C) 2009-2016, ATR Baltic, Ltd. All Rights Reserved.
+ * Copyright (C) 2017-2019, Mavimax, Ltd. All Rights Reserved.
+ * This software is released under one of the following licenses:
+ * AGPL (with Java and Go exceptions) or Mavimax's license for commercial use.
+ * See LICENSE file for full text.
+ * -----------------------------------------------------------------------------
+ * AGPL license:
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License, version 3 as published
+ * by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License, version 3
+ * for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * -----------------------------------------------------------------------------
+ * A commercial use license is available from Mavimax, Ltd
+ * contact@mavimax.com
+ * -----------------------------------------------------------------------------
+ */
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/types.h>
+
+#include <ndrstandard.h>
+#include <ndebug.h>
+#include <atmi.h>
+#include <atmi_int.h>
+#include <typed_buf.h>
+#include <userlog.h>
+#include <thlock.h>
+#include <nstd_shm.h>
+#include <sys_unix.h>
+/*---------------------------Externs------------------------------------*/
+/*---------------------------Macros-------------------------------------*/
+#define LMSG_SLAB_FREE      0   /**< Slab is free                       */
+#define LMSG_SLAB_USED      1   /**< Slab holds the message             */
+#define LMSG_SLAB_READ      2   /**< Receiver is reading the message    */
+
+#define LMSG_ALIGN(X)       (((X)+7) & ~((size_t)7)) /**< align to 8    */
+
+/** Slab header by index */
+#define LMSG_SLAB(IDX)      ((ndrx_lmsg_slab_t *)(M_lmsg_shm.mem + \
+                                sizeof(ndrx_lmsg_hdr_t)) + (IDX))
+/** Slab data by index */
+#define LMSG_DATA(IDX)      (M_lmsg_shm.mem + M_data_off + (size_t)(IDX)*M_slab_size)
+
+/*---------------------------Enums--------------------------------------*/
+/*---------------------------Typedefs-----------------------------------*/
+
+/**
+ * Pool header, at the start of the shm
+ */
+typedef struct
+{
+    int next;           /**< slab from which to start the free search   */
+} ndrx_lmsg_hdr_t;
+
+/**
+ * Slab descriptor, the header is followed by the array of these
+ */
+typedef struct
+{
+    int state;          /**< LMSG_SLAB_FREE or LMSG_SLAB_USED           */
+    unsigned gen;       /**< incremented on every allocation            */
+    pid_t owner;        /**< process which allocated the slab           */
+    pid_t receiver;     /**< receiver if known (replies) or the process
+                          reading the slab (LMSG_SLAB_READ), 0 - unknown */
+    time_t t_alloc;     /**< allocation time                            */
+    int ttl;            /**< seconds the message is valid, 0 - no limit */
+    long len;           /**< payload length                             */
+} ndrx_lmsg_slab_t;
+
+/*---------------------------Globals------------------------------------*/
+/*---------------------------Statics------------------------------------*/
+
+exprivate ndrx_shm_t M_lmsg_shm = {.fd=EXFAIL, .path="", .mem=NULL}; /**< Pool shm */
+exprivate ndrx_sem_t M_lmsg_sem = {.semid=0};   /**< Protects the slab states */
+exprivate volatile int M_attached = EXFALSE;    /**< Are we attached ?       */
+exprivate int M_init_failed = EXFALSE;          /**< Do not retry the init   */
+exprivate size_t M_slab_size = 0;               /**< Data bytes per slab     */
+exprivate size_t M_data_off = 0;                /**< Offset of slab data     */
+exprivate MUTEX_LOCKDECL(M_lmsg_init_lock);     /**< Pool shm attach lock    */
+
+/*---------------------------Prototypes---------------------------------*/
+
+/**
+ * Setup the pool shm and semaphore keys
+ */
+exprivate void lmsg_keys_set(void)
+{
+    M_lmsg_shm.fd = EXFAIL;
+    M_lmsg_shm.key = G_atmi_env.ipckey + NDRX_SHM_LMSG_KEYOFSZ;
+    snprintf(M_lmsg_shm.path, sizeof(M_lmsg_shm.path), NDRX_SHM_LMSG,
+            G_atmi_env.qprefix);
+
+    memset(&M_lmsg_sem, 0, sizeof(M_lmsg_sem));
+    M_lmsg_sem.key = G_atmi_env.ipckey + NDRX_SEM_LMSGLOCKS;
+    M_lmsg_sem.nrsems = 1;
+    M_lmsg_sem.maxreaders = 1;
+}
+
+/**
+ * Open or attach the large message pool. Any process configured with
+ * NDRX_LMSGPOOL creates the pool on first use, if it does not exist.
+ * @param attach_only attach only, if does not exists - fail
+ * @return EXSUCCEED/EXFAIL
+ */
+exprivate int lmsg_init(int attach_only)
+{
+    int ret = EXSUCCEED;
+    size_t tot;
+
+    MUTEX_LOCK_V(M_lmsg_init_lock);
+
+    if (M_attached)
+    {
+        goto out;
+    }
+
+    if (G_atmi_env.lmsgpool < 1 || (M_init_failed && !attach_only))
+    {
+        EXFAIL_OUT(ret);
+    }
+
+    M_slab_size = LMSG_ALIGN(NDRX_MSGSIZEMAX);
+    M_data_off = LMSG_ALIGN(sizeof(ndrx_lmsg_hdr_t) +
+            sizeof(ndrx_lmsg_slab_t)*G_atmi_env.lmsgpool);
+    tot = M_data_off + M_slab_size*G_atmi_env.lmsgpool;
+
+    if (tot > INT_MAX)
+    {
+        NDRX_LOG(log_error, "Large message pool too big: %d slabs of %ld bytes",
+                G_atmi_env.lmsgpool, (long)M_slab_size);
+        userlog("Large message pool too big: %d slabs of %ld bytes",
+                G_atmi_env.lmsgpool, (long)M_slab_size);
+        M_init_failed = EXTRUE;
+        EXFAIL_OUT(ret);
+    }
+
+    lmsg_keys_set();
+    M_lmsg_shm.size = (int)tot;
+
+    if (attach_only)
+    {
+        if (EXSUCCEED!=ndrx_shm_attach(&M_lmsg_shm))
+        {
+            NDRX_LOG(log_debug, "Large message pool [%s] not attached",
+                    M_lmsg_shm.path);
+            EXFAIL_OUT(ret);
+        }
+    }
+    else if (EXSUCCEED!=ndrx_shm_open(&M_lmsg_shm, EXTRUE))
+    {
+        NDRX_LOG(log_error, "Failed to open large message pool [%s] - "
+                "check NDRX_LMSGPOOL and NDRX_MSGSIZEMAX (all processes must "
+                "use the same settings)", M_lmsg_shm.path);
+        userlog("Failed to open large message pool [%s] - "
+                "check NDRX_LMSGPOOL and NDRX_MSGSIZEMAX (all processes must "
+                "use the same settings)", M_lmsg_shm.path);
+        M_init_failed = EXTRUE;
+        EXFAIL_OUT(ret);
+    }
+
+    if (attach_only)
+    {
+        if (EXSUCCEED!=ndrx_sem_attach(&M_lmsg_sem))
+        {
+            NDRX_LOG(log_error, "Failed to attach large message pool semaphore");
+            ndrx_shm_close(&M_lmsg_shm);
+            EXFAIL_OUT(ret);
+        }
+    }
+    else if (EXSUCCEED!=ndrx_sem_open(&M_lmsg_sem, EXTRUE))
+    {
+        NDRX_LOG(log_error, "Failed to open large message pool semaphore");
+        userlog("Failed to open large message pool semaphore");
+        ndrx_shm_close(&M_lmsg_shm);
+        M_init_failed = EXTRUE;
+        EXFAIL_OUT(ret);
+    }
+
+    NDRX_LOG(log_info, "Large message pool [%s] attached: %d slabs of %ld bytes, "
+            "threshold %ld", M_lmsg_shm.path, G_atmi_env.lmsgpool,
+            (long)M_slab_size, G_atmi_env.lmsgthres);
+
+    M_attached = EXTRUE;
+
+out:
+    MUTEX_UNLOCK_V(M_lmsg_init_lock);
+    return ret;
+}
+
+/**
+ * Allocate free slab
+ * @param ttl message time to live in seconds, 0 - no limit
+ * @param receiver receiving process if known, 0 - not known
+ * @param ref reference to fill (slot and generation)
+ * @return slab data or NULL if no free slab
+ */
+exprivate char *lmsg_alloc(int ttl, pid_t receiver, ndrx_lmsg_ref_t *ref)
+{
+    char *ret = NULL;
+    ndrx_lmsg_hdr_t *hdr = (ndrx_lmsg_hdr_t *)M_lmsg_shm.mem;
+    ndrx_lmsg_slab_t *slab;
+    int i, idx;
+
+    if (EXSUCCEED!=ndrx_sem_lock(&M_lmsg_sem, __func__, 0))
+    {
+        goto out;
+    }
+
+    for (i=0; i<G_atmi_env.lmsgpool; i++)
+    {
+        idx = (hdr->next + i) % G_atmi_env.lmsgpool;
+        slab = LMSG_SLAB(idx);
+
+        if (LMSG_SLAB_FREE==slab->state)
+        {
+            slab->state = LMSG_SLAB_USED;
+            slab->gen++;
+            slab->owner = getpid();
+            slab->receiver = receiver;
+            slab->t_alloc = time(NULL);
+            slab->ttl = ttl;
+            slab->len = 0;
+
+            hdr->next = (idx + 1) % G_atmi_env.lmsgpool;
+
+            ref->slot = idx;
+            ref->gen = slab->gen;
+            ref->len = 0;
+            ret = LMSG_DATA(idx);
+            break;
+        }
+    }
+
+    ndrx_sem_unlock(&M_lmsg_sem, __func__, 0);
+
+out:
+
+    if (NULL==ret)
+    {
+        NDRX_LOG(log_info, "No free large message slab - using queue");
+    }
+
+    return ret;
+}
+
+/**
+ * Free the slab, if it still belongs to the reference
+ * @param ref slab reference
+ */
+exprivate void lmsg_free(ndrx_lmsg_ref_t *ref)
+{
+    ndrx_lmsg_slab_t *slab;
+
+    if (ref->slot < 0 || ref->slot >= G_atmi_env.lmsgpool)
+    {
+        return;
+    }
+
+    slab = LMSG_SLAB(ref->slot);
+
+    if (EXSUCCEED!=ndrx_sem_lock(&M_lmsg_sem, __func__, 0))
+    {
+        return;
+    }
+
+    if ((LMSG_SLAB_USED==slab->state || LMSG_SLAB_READ==slab->state) && 
+            slab->gen==ref->gen)
+    {
+        slab->state = LMSG_SLAB_FREE;
+    }
+
+    ndrx_sem_unlock(&M_lmsg_sem, __func__, 0);
+}
+
+/**
+ * Prepare outgoing call data in the large message pool. Pool is used if
+ * it is configured, buffer is big enough and there is free slab. Otherwise
+ * caller shall prepare the data in the call as usual.
+ * @param descr buffer type descriptor
+ * @param buffer_info buffer object of \p data
+ * @param data user buffer
+ * @param len user buffer len
+ * @param call call to which reference is added (data_len, sysflags set)
+ * @param ttl message time to live in seconds, 0 - no limit
+ * @param rcv_myid my_id of receiving process if known (replies), else NULL.
+ *  Slab of message without time limit is reclaimed when receiver dies.
+ * @param flags ATMI flags
+ * @return EXTRUE - data is in pool, EXFALSE - pool not used,
+ *  EXFAIL - prepare failed (error set)
+ */
+expublic int ndrx_lmsg_prepare_outgoing(typed_buffer_descr_t *descr,
+        buffer_obj_t *buffer_info, char *data, long len,
+        tp_command_call_t *call, int ttl, char *rcv_myid, long flags)
+{
+    int ret = EXFALSE;
+    ndrx_lmsg_ref_t ref;
+    char *slab_data;
+    long data_len = MAX_CALL_DATA_SIZE;
+    TPMYID rcv;
+    pid_t receiver = 0;
+
+    if (G_atmi_env.lmsgpool < 1 || buffer_info->size < G_atmi_env.lmsgthres)
+    {
+        goto out;
+    }
+
+    if (!M_attached && EXSUCCEED!=lmsg_init(EXFALSE))
+    {
+        goto out;
+    }
+
+    if (NULL!=rcv_myid && EXSUCCEED==ndrx_myid_parse(rcv_myid, &rcv, EXFALSE))
+    {
+        receiver = rcv.pid;
+    }
+
+    if (NULL==(slab_data = lmsg_alloc(ttl, receiver, &ref)))
+    {
+        goto out;
+    }
+
+    if (EXSUCCEED!=descr->pf_prepare_outgoing(descr, data, len, slab_data,
+                &data_len, flags))
+    {
+        lmsg_free(&ref);
+        EXFAIL_OUT(ret);
+    }
+
+    ref.len = data_len;
+    LMSG_SLAB(ref.slot)->len = data_len;
+
+    memcpy(call->data, &ref, sizeof(ref));
+    call->data_len = sizeof(ref);
+    call->sysflags |= SYS_FLAG_LMSG;
+
+    NDRX_LOG(log_debug, "Payload of %ld bytes placed in large message slab %d "
+            "gen %u", data_len, ref.slot, ref.gen);
+    ret = EXTRUE;
+
+out:
+    return ret;
+}
+
+/**
+ * Resolve the call payload. For pool messages returns the slab data,
+ * otherwise the data of the call. Slab is marked as being read by current
+ * process, thus it is not reclaimed by time limit until ndrx_lmsg_release()
+ * is called.
+ * @param call received call
+ * @param data payload
+ * @param data_len payload len
+ * @return EXSUCCEED/EXFAIL (slab reclaimed or pool not available, error set)
+ */
+expublic int ndrx_lmsg_resolve(tp_command_call_t *call, char **data,
+        long *data_len)
+{
+    int ret = EXSUCCEED;
+    ndrx_lmsg_ref_t ref;
+    ndrx_lmsg_slab_t *slab;
+
+    if (!(call->sysflags & SYS_FLAG_LMSG))
+    {
+        *data = call->data;
+        *data_len = call->data_len;
+        goto out;
+    }
+
+    memcpy(&ref, call->data, sizeof(ref));
+
+    if (!M_attached && EXSUCCEED!=lmsg_init(EXFALSE))
+    {
+        ndrx_TPset_error_fmt(TPESYSTEM, "%s: large message pool not available "
+                "(check NDRX_LMSGPOOL)", __func__);
+        EXFAIL_OUT(ret);
+    }
+
+    if (ref.slot < 0 || ref.slot >= G_atmi_env.lmsgpool)
+    {
+        ndrx_TPset_error_fmt(TPESYSTEM, "%s: invalid large message slab %d",
+                __func__, ref.slot);
+        EXFAIL_OUT(ret);
+    }
+
+    slab = LMSG_SLAB(ref.slot);
+
+    if (EXSUCCEED!=ndrx_sem_lock(&M_lmsg_sem, __func__, 0))
+    {
+        ndrx_TPset_error_fmt(TPESYSTEM, "%s: failed to lock large message pool",
+                __func__);
+        EXFAIL_OUT(ret);
+    }
+
+    if (LMSG_SLAB_USED!=slab->state || slab->gen!=ref.gen)
+    {
+        ndrx_sem_unlock(&M_lmsg_sem, __func__, 0);
+        NDRX_LOG(log_error, "Large message slab %d gen %u reclaimed (state %d "
+                "gen %u)", ref.slot, ref.gen, slab->state, slab->gen);
+        userlog("Large message slab %d gen %u reclaimed (state %d "
+                "gen %u)", ref.slot, ref.gen, slab->state, slab->gen);
+        ndrx_TPset_error_fmt(TPESYSTEM, "%s: large message slab %d reclaimed",
+                __func__, ref.slot);
+        EXFAIL_OUT(ret);
+    }
+
+    /* pin the slab for the reader */
+    slab->state = LMSG_SLAB_READ;
+    slab->receiver = getpid();
+
+    ndrx_sem_unlock(&M_lmsg_sem, __func__, 0);
+
+    *data = LMSG_DATA(ref.slot);
+    *data_len = ref.len;
+
+out:
+    return ret;
+}
+
+/**
+ * Release the slab of the received call (if any). Payload shall be already
+ * converted to typed buffer. Clears the SYS_FLAG_LMSG, thus can be called
+ * several times.
+ * @param call received call
+ */
+expublic void ndrx_lmsg_release(tp_command_call_t *call)
+{
+    ndrx_lmsg_ref_t ref;
+
+    if (!(call->sysflags & SYS_FLAG_LMSG))
+    {
+        return;
+    }
+
+    call->sysflags &= ~SYS_FLAG_LMSG;
+
+    if (!M_attached && EXSUCCEED!=lmsg_init(EXFALSE))
+    {
+        return;
+    }
+
+    memcpy(&ref, call->data, sizeof(ref));
+    lmsg_free(&ref);
+
+    NDRX_LOG(log_debug, "Large message slab %d gen %u released",
+            ref.slot, ref.gen);
+}
+
+/**
+ * Reclaim slabs of lost messages, called by ndrxd sanity checks.
+ * Slab being read is reclaimed only if reader is dead. Otherwise slab is
+ * reclaimed when message time to live is exceeded or if message has no time
+ * limit and the receiver (if known, i.e. reply) or otherwise the process
+ * which allocated the slab is dead.
+ */
+expublic void ndrx_lmsg_sanity(void)
+{
+    ndrx_lmsg_slab_t *slab;
+    time_t now;
+    int i;
+    int reclaimed = 0;
+
+    if (G_atmi_env.lmsgpool < 1)
+    {
+        return;
+    }
+
+    /* pool is created by users, ndrxd only attaches */
+    if (!M_attached && EXSUCCEED!=lmsg_init(EXTRUE))
+    {
+        return;
+    }
+
+    if (EXSUCCEED!=ndrx_sem_lock(&M_lmsg_sem, __func__, 0))
+    {
+        return;
+    }
+
+    now = time(NULL);
+
+    for (i=0; i<G_atmi_env.lmsgpool; i++)
+    {
+        slab = LMSG_SLAB(i);
+
+        if (LMSG_SLAB_FREE==slab->state)
+        {
+            continue;
+        }
+
+        if ((LMSG_SLAB_READ==slab->state &&
+                !ndrx_sys_is_process_running_by_pid(slab->receiver)) ||
+            (LMSG_SLAB_USED==slab->state && 
+                ((slab->ttl > 0 && now - slab->t_alloc > slab->ttl) ||
+                (0==slab->ttl && !ndrx_sys_is_process_running_by_pid(
+                    slab->receiver > 0 ? slab->receiver : slab->owner)))))
+        {
+            NDRX_LOG(log_warn, "Reclaiming large message slab %d gen %u "
+                    "state %d owner %d receiver %d age %ld ttl %d", i, 
+                    slab->gen, slab->state, (int)slab->owner, 
+                    (int)slab->receiver, (long)(now - slab->t_alloc), slab->ttl);
+            slab->state = LMSG_SLAB_FREE;
+            reclaimed++;
+        }
+    }
+
+    ndrx_sem_unlock(&M_lmsg_sem, __func__, 0);
+
+    if (reclaimed)
+    {
+        userlog("Reclaimed %d large message slabs", reclaimed);
+    }
+}
+
+/**
+ * Remove the pool shared memory and semaphore. Does not require the pool
+ * to be attached (used by shutdown).
+ * @param force remove semaphore even if not attached
+ * @return EXSUCCEED/EXFAIL
+ */
+expublic int ndrx_lmsg_remove(int force)
+{
+    int ret = EXSUCCEED;
+
+    if (G_atmi_env.lmsgpool < 1)
+    {
+        return EXSUCCEED;
+    }
+
+    MUTEX_LOCK_V(M_lmsg_init_lock);
+
+    if (M_attached)
+    {
+        ndrx_shm_close(&M_lmsg_shm);
+        M_attached = EXFALSE;
+    }
+    else
+    {
+        lmsg_keys_set();
+    }
+
+    if (EXSUCCEED!=ndrx_shm_remove(&M_lmsg_shm))
+    {
+        ret = EXFAIL;
+    }
+
+    if (EXSUCCEED==ndrx_sem_attach(&M_lmsg_sem) &&
+            EXSUCCEED!=ndrx_sem_remove(&M_lmsg_sem, force))
+    {
+        ret = EXFAIL;
+    }
+
+    MUTEX_UNLOCK_V(M_lmsg_init_lock);
+
+    return ret;
+}
+
+/* vim: set ts=4 sw=4 et smartindent: */
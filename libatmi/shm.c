@@ -673,6 +673,26 @@ not_locked:
     return ret;
 }
 
+/**
+ * Return service flags from shared memory
+ * @param svc service name
+ * @return shm_svcinfo_t flags, 0 if service not found or shm not attached
+ */
+expublic int ndrx_shm_get_svc_flags(char *svc)
+{
+    int ret=0;
+    int pos=EXFAIL;
+    shm_svcinfo_t *svcinfo = (shm_svcinfo_t *) G_svcinfo.mem;
+    
+    if (ndrx_shm_is_attached(&G_svcinfo) && 
+            _ndrx_shm_get_svc(svc, &pos, NDRX_SVCINSTALL_NOT, NULL))
+    {
+        ret = SHM_SVCINFO_INDEX(svcinfo, pos)->flags;
+    }
+    
+    return ret;
+}
+
 /**
  * return number of service active in system
  * @return nr_services / EXFAIL
@@ -868,6 +888,19 @@ expublic int ndrx_shm_install_svc_br(char *svc, int flags,
         NDRX_LOG(log_debug, "Updating flags for [%s] from %d to %d",
                 svc, SHM_SVCINFO_INDEX(svcinfo, pos)->flags, flags);
         el = SHM_SVCINFO_INDEX(svcinfo, pos);
+        
+        /* compact call header only if all local servers decode it,
+         * bridges do not change it
+         */
+        if (is_bridge)
+        {
+            flags |= (el->flags & NDRXD_SVCINFO_CMPCTHDR);
+        }
+        else if (el->srvs > el->csrvs)
+        {
+            flags &= (el->flags | ~NDRXD_SVCINFO_CMPCTHDR);
+        }
+        
         /* service have been found at position, update flags */
         el->flags = flags | NDRXD_SVCINFO_INIT;
         
@@ -61,6 +61,7 @@
 #include <sys/shm.h>
 #include <cpm.h>
 #include "atmi_tls.h"
+#include <atmi_cache.h>
 /*---------------------------Externs------------------------------------*/
 /*---------------------------Macros-------------------------------------*/
 /*---------------------------Enums--------------------------------------*/
@@ -802,6 +803,18 @@ expublic int ndrx_down_sys(char *qprefix, char *qpath, int is_force, int user_re
     
     ndrxd_sem_delete_with_init(qprefix);
     
+    NDRX_LOG(log_warn, "Removing large message pool...");
+    
+    ndrx_lmsg_remove(EXTRUE);
+    
+    NDRX_LOG(log_warn, "Removing cache in-flight table...");
+    
+    ndrx_cache_sf_remove();
+    
+    NDRX_LOG(log_warn, "Removing call trace ring...");
+    
+    ndrx_calltrace_remove();
+    
     NDRX_LOG(log_warn, "Removing ndrxd pid file");
     
     if (NULL!=ndrxd_pid_file && EXEOS!=ndrxd_pid_file[0])
@@ -428,6 +428,7 @@ expublic int ndrx_tpacall (char *svc, char *data,
     int noenterr = EXFALSE;
     char svcddr[XATMI_SERVICE_NAME_LENGTH+1]; /**< routed service name */
     int prio = NDRX_MSGPRIO_DEFAULT;
+    int lmsg = EXFALSE;
     ATMI_TLS_ENTRY;
     
     NDRX_LOG(log_debug, "%s enter", __func__);
@@ -508,7 +509,8 @@ expublic int ndrx_tpacall (char *svc, char *data,
                 p_cachectl->odata, p_cachectl->olen, flags, 
                 &p_cachectl->should_cache, 
                 &p_cachectl->saved_tperrno, 
-                &p_cachectl->saved_tpurcode, EXFALSE, noenterr)))
+                &p_cachectl->saved_tpurcode, EXFALSE, noenterr,
+                &p_cachectl->sfref)))
         {
             /* failed to get cache data */
             if (EXFAIL==ret)
@@ -572,8 +574,21 @@ expublic int ndrx_tpacall (char *svc, char *data,
     if (NULL!=data)
     {
         descr = &G_buf_descr[buffer_info->type_id];
+        
+        /* large payload for local service goes via shm pool */
+        if (!is_bridge && EXFAIL==(lmsg=ndrx_lmsg_prepare_outgoing(descr, 
+                buffer_info, data, len, call, 
+                (flags & TPNOTIME)?0:G_atmi_env.time_out, NULL, flags)))
+        {
+            lmsg=EXFALSE;
+            EXFAIL_OUT(ret);
+        }
+        else if (lmsg)
+        {
+            data_len = call->data_len;
+        }
         /* prepare buffer for call */
-        if (EXSUCCEED!=descr->pf_prepare_outgoing(descr, data, len, call->data, 
+        else if (EXSUCCEED!=descr->pf_prepare_outgoing(descr, data, len, call->data, 
                 &data_len, flags))
         {
             /* not good - error should be already set */
@@ -600,7 +615,8 @@ expublic int ndrx_tpacall (char *svc, char *data,
     NDRX_STRCPY_SAFE(call->reply_to, G_atmi_tls->G_atmi_conf.reply_q_str);
     
     call->command_id = ATMI_COMMAND_TPCALL;
-    
+    /* we decode compact replies */
+    call->sysflags |= SYS_FLAG_CMPCTHDR;
     
     NDRX_STRCPY_SAFE(call->name, svcddr);
     call->flags = flags;
@@ -660,6 +676,9 @@ expublic int ndrx_tpacall (char *svc, char *data,
     /* Reset call timer */
     ndrx_stopwatch_reset(&call->timer);
     
+    /* trace the call if sampled or if we serve traced call */
+    data_len+=ndrx_calltrace_begin(call);
+    
     NDRX_STRCPY_SAFE(call->my_id, G_atmi_tls->G_atmi_conf.my_id); /* Setup my_id */
     NDRX_LOG(log_debug, "Sending request to: [%s] my_id=[%s] reply_to=[%s] cd=%d "
             "callseq=%u (user1=%d, user2=%ld, user3=%d, user4=%ld)", 
@@ -668,7 +687,8 @@ expublic int ndrx_tpacall (char *svc, char *data,
     
     NDRX_DUMP(log_dump, "Sending away...", (char *)call, data_len);
 
-    if (EXSUCCEED!=(ret=ndrx_generic_q_send(send_q, (char *)call, data_len, flags, prio)))
+    if (EXSUCCEED!=(ret=ndrx_callhdr_q_send(send_q, call, data_len, flags, 
+            prio, !is_bridge)))
     {
         int err;
 
@@ -693,6 +713,12 @@ expublic int ndrx_tpacall (char *svc, char *data,
     ret=tpcall_cd;
 
 out:
+    
+    /* message not sent, give back the slab */
+    if (EXFAIL==ret && lmsg)
+    {
+        ndrx_lmsg_release(call);
+    }
                 
     if (NULL!=buf)
     {
@@ -821,6 +847,7 @@ expublic int ndrx_tpgetrply (int *cd,
     size_t pbuf_len;
     tp_command_call_t *rply=NULL;
     typed_buffer_descr_t *call_type;
+    ndrx_trace_t *trace;
     int answ_ok = EXFALSE;
     int is_abort_only = EXFALSE; /* Should we abort global tx (if open) */
     ATMI_TLS_ENTRY;
@@ -874,8 +901,22 @@ expublic int ndrx_tpgetrply (int *cd,
                     G_atmi_tls->G_atmi_conf.reply_q_str,
                     &(G_atmi_tls->G_atmi_conf.reply_q_attr),
                     (char *)rply, pbuf_len, &prio, flags);
+
+            /* local servers may reply with compact call header */
+            if (rply_len > 0)
+            {
+                long cmpct_len = rply_len;
+
+                if (EXFAIL==ndrx_callhdr_decode(pbuf, pbuf_len, &cmpct_len))
+                {
+                    NDRX_LOG(log_error, "Dropping invalid compact reply");
+                    continue;
+                }
+
+                rply_len = cmpct_len;
+            }
         }
-        
+
         /* In case  if we did receive any response (in non blocked mode
          * or we did get fail in blocked mode with TPETIME, then we should
          * look up the table for which really we did get the time-out.
@@ -968,6 +1009,14 @@ expublic int ndrx_tpgetrply (int *cd,
                         rply->cd, rply->timestamp, rply->callseq, rply->reply_to,
                         rply->buffer_type_id, (G_buf_descr[rply->buffer_type_id].type));
                 answ_ok=EXTRUE;
+                
+                /* call completed, store the trace */
+                if (NULL!=(trace = ndrx_calltrace_get(rply, rply_len)))
+                {
+                    ndrx_calltrace_hop(trace, NDRX_TRACE_HOP_RPLDEQ);
+                    ndrx_calltrace_emit(rply, trace);
+                }
+                
                 /* Free up call descriptor!! */
                 unlock_call_descriptor(rply->cd, CALL_NOT_ISSUED);
             }
@@ -978,6 +1027,7 @@ expublic int ndrx_tpgetrply (int *cd,
                         rply->cd, rply->timestamp, rply->callseq, rply->reply_to,
                         G_atmi_tls->G_call_state[rply->cd].status);
                 
+                ndrx_lmsg_release(rply);
                 continue; /* Wait for next message! */
             }
 
@@ -992,23 +1042,35 @@ expublic int ndrx_tpgetrply (int *cd,
             *cd = rply->cd;
             if (rply->sysflags & SYS_FLAG_REPLY_ERROR)
             {
+                ndrx_lmsg_release(rply);
                 ndrx_TPset_error_msg(rply->rcode, "Server failed to generate reply");
                 ret=EXFAIL;
                 goto out;
             }
             else
             {
+                char *rply_data;
+                long rply_data_len;
+                
                 /* Convert all, including NULL buffers  */
                 
                 call_type = &G_buf_descr[rply->buffer_type_id];
+                
+                if (EXSUCCEED!=ndrx_lmsg_resolve(rply, &rply_data, &rply_data_len))
+                {
+                    ndrx_lmsg_release(rply);
+                    EXFAIL_OUT(ret);
+                }
 
                 ret=call_type->pf_prepare_incoming(call_type,
-                                rply->data,
-                                rply->data_len,
+                                rply_data,
+                                rply_data_len,
                                 data,
                                 len,
                                 flags);
                 
+                ndrx_lmsg_release(rply);
+                
                 /* put rcode in global */
                 G_atmi_tls->M_svc_return_code = rply->rcode;
 
@@ -1253,6 +1315,12 @@ out:
             }
         }
     }
+    
+    /* single-flight: let the waiters in */
+    if (cache_used)
+    {
+        ndrx_cache_sf_release(&cachectl.sfref);
+    }
 
     return ret;
 }
@@ -69,7 +69,7 @@
 
 /**
  * Encrypt data block.
- * Currently AES-128 is used, CBC mode
+ * Currently AES-128 is used, CBC mode or GCM (see NDRX_CRYPTOMODE)
  * In string mode (TPEX_STRING) - input is 0x0 terminated string, on output base64
  * encoded data (output buffer size is checked, but no len provided)
  * @param input input input data
@@ -114,7 +114,7 @@ out:
 
 /**
  * Decrypt data block.
- * Currently AES-128 is used, CBC mode
+ * Currently AES-128 is used, CBC mode or GCM (see NDRX_CRYPTOMODE)
  * In string mode (TPEX_STRING) - input is 0x0 terminated string with base64 data,
  * on output 0x0 terminate string is provided. No len is provided on output
  * but output buffer size is tested.
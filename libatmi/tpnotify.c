@@ -449,8 +449,20 @@ expublic int ndrx_tpchkunsol(void)
         }
         else
         {
+            long cmpct_len = rply_len;
+            
             NDRX_LOG(log_info, "got non unsol command - enqueue");
             
+            /* replies may come in compact form, memq keeps full headers
+             * as tpgetrply() matches them by cd */
+            if (EXFAIL==ndrx_callhdr_decode(pbuf, pbuf_len, &cmpct_len))
+            {
+                NDRX_LOG(log_error, "Dropping invalid compact reply");
+                continue;
+            }
+            
+            rply_len = cmpct_len;
+            
             if (EXSUCCEED!=ndrx_add_to_memq(&pbuf, pbuf_len, rply_len))
             {
                 EXFAIL_OUT(ret);
@@ -1,5 +1,10 @@
 /**
  * @brief General routines for handling buffer conversation
+ *   Buffer objects (type, size, etc.) are kept in hidden header directly
+ *   before the user data. Known buffers are registered in the hash index
+ *   split in shards by pointer value, each shard having its own lock, thus
+ *   lookups from different threads mostly do not contend. Pointer is accepted
+ *   only when found in the index, the header is read after that.
  *
  * @file typed_buf.c
  */
@@ -54,16 +59,26 @@
 #include <tpadm.h>
 /*---------------------------Externs------------------------------------*/
 /*---------------------------Macros-------------------------------------*/
+#define NDRX_TPBUF_SHARDS       64  /**< number of index shards, power of 2 */
+
+/**
+ * Index shard of the buffer ptr
+ */
+#define NDRX_TPBUF_SHARD(X)     (&M_shards[(((unsigned long)(X) >> 4) ^ \
+                ((unsigned long)(X) >> 12)) & (NDRX_TPBUF_SHARDS-1)])
 /*---------------------------Enums--------------------------------------*/
 /*---------------------------Typedefs-----------------------------------*/
-/*---------------------------Globals------------------------------------*/
-exprivate buffer_obj_t * find_buffer_int(char *ptr);
-/*
- * Buffers allocated by process
+
+/**
+ * Buffer index shard
  */
-expublic buffer_obj_t *ndrx_G_buffers=NULL;
+typedef struct
+{
+    NDRX_SPIN_LOCKDECL(lock);   /**< protects the hash                  */
+    buffer_obj_t *buffers;      /**< buffers hashed by user data ptr    */
+} ndrx_tpbuf_shard_t;
 
-exprivate MUTEX_LOCKDECL(M_lock); /* This will allow multiple reads */
+/*---------------------------Globals------------------------------------*/
 
 /*
  * Buffer descriptors
@@ -95,6 +110,10 @@ expublic typed_buffer_descr_t G_buf_descr[] =
 
 /*---------------------------Statics------------------------------------*/
 
+exprivate ndrx_tpbuf_shard_t M_shards[NDRX_TPBUF_SHARDS]; /**< buffer index */
+exprivate volatile int M_shards_first = EXTRUE; /**< shard locks not init */
+exprivate MUTEX_LOCKDECL(M_shards_init_lock); /**< shard init lock       */
+
 /**
  * This is generic NULL buffer object
  */
@@ -107,16 +126,140 @@ exprivate buffer_obj_t M_nullbuf = {.autoalloc = EXFALSE,
 /*---------------------------Prototypes---------------------------------*/
 
 /**
- * Compares two buffers in linked list (for search purposes)
- * @param a
- * @param b
- * @return 0 - equal/ -1 - not equal
+ * Init the index shard locks, once per process
+ */
+exprivate void shards_init(void)
+{
+    int i;
+    
+    MUTEX_LOCK_V(M_shards_init_lock);
+    
+    if (M_shards_first)
+    {
+        for (i=0; i<NDRX_TPBUF_SHARDS; i++)
+        {
+            NDRX_SPIN_INIT_V(M_shards[i].lock);
+        }
+        
+        M_shards_first = EXFALSE;
+    }
+    
+    MUTEX_UNLOCK_V(M_shards_init_lock);
+}
+
+/**
+ * Find buffer in the index and optionally remove it from there
+ * @param ptr user data ptr
+ * @param remove EXTRUE - remove found buffer from index
+ * @return buffer object or NULL if ptr is not known
+ */
+exprivate buffer_obj_t * index_find(char *ptr, int remove)
+{
+    buffer_obj_t *ret;
+    ndrx_tpbuf_shard_t *shard;
+    
+    if (NDRX_UNLIKELY(M_shards_first))
+    {
+        shards_init();
+    }
+    
+    shard = NDRX_TPBUF_SHARD(ptr);
+    
+    NDRX_SPIN_LOCK_V(shard->lock);
+    EXHASH_FIND_PTR(shard->buffers, ((void **)&ptr), ret);
+    
+    if (NULL!=ret && remove)
+    {
+        EXHASH_DEL(shard->buffers, ret);
+    }
+    NDRX_SPIN_UNLOCK_V(shard->lock);
+    
+    return ret;
+}
+
+/**
+ * Add buffer to the index
+ * @param node buffer object, with buf set
+ */
+exprivate void index_add(buffer_obj_t *node)
+{
+    ndrx_tpbuf_shard_t *shard;
+    
+    if (NDRX_UNLIKELY(M_shards_first))
+    {
+        shards_init();
+    }
+    
+    shard = NDRX_TPBUF_SHARD(node->buf);
+    
+    NDRX_SPIN_LOCK_V(shard->lock);
+    EXHASH_ADD_PTR(shard->buffers, buf, node);
+    NDRX_SPIN_UNLOCK_V(shard->lock);
+}
+
+/**
+ * Allocate memory for typed buffer, with space for hidden header.
+ * Used by the type handlers.
+ * @param len user data length
+ * @return ptr to user data or NULL (errno set)
+ */
+expublic char * ndrx_tpbuf_malloc(long len)
+{
+    char *ret;
+    
+    if (NULL==(ret = NDRX_MALLOC(NDRX_TPBUF_HDRSIZE+len)))
+    {
+        return NULL;
+    }
+    
+    memset(ret, 0, NDRX_TPBUF_HDRSIZE);
+    
+    return ret+NDRX_TPBUF_HDRSIZE;
+}
+
+/**
+ * Allocate zeroed memory for typed buffer
+ * @param len user data length
+ * @return ptr to user data or NULL (errno set)
+ */
+expublic char * ndrx_tpbuf_calloc(long len)
+{
+    char *ret;
+    
+    if (NULL==(ret = NDRX_CALLOC(1, NDRX_TPBUF_HDRSIZE+len)))
+    {
+        return NULL;
+    }
+    
+    return ret+NDRX_TPBUF_HDRSIZE;
+}
+
+/**
+ * Reallocate typed buffer memory, header is moved together with data
+ * @param buf user data ptr
+ * @param len new user data length
+ * @return new user data ptr or NULL (errno set, buf is not changed)
  */
-exprivate int buf_ptr_cmp_fn(buffer_obj_t *a, buffer_obj_t *b)
+expublic char * ndrx_tpbuf_realloc(char *buf, long len)
 {
-    return (a->buf==b->buf?EXSUCCEED:EXFAIL);
+    char *ret;
+    
+    if (NULL==(ret = NDRX_REALLOC(buf-NDRX_TPBUF_HDRSIZE, NDRX_TPBUF_HDRSIZE+len)))
+    {
+        return NULL;
+    }
+    
+    return ret+NDRX_TPBUF_HDRSIZE;
 }
 
+/**
+ * Free typed buffer memory
+ * @param buf user data ptr
+ */
+expublic void ndrx_tpbuf_free(char *buf)
+{
+    NDRX_FREE(buf-NDRX_TPBUF_HDRSIZE);
+}
 
 /**
  * List currently allocated XATMI buffers
@@ -127,17 +270,27 @@ expublic int ndrx_buffer_list(ndrx_growlist_t *list)
 {
     int ret = EXSUCCEED;
     int i = 0;
+    int j;
     buffer_obj_t *elt, *tmp;
     
     ndrx_growlist_init(list, 100, sizeof(void *));
     
-    MUTEX_LOCK_V(M_lock);
-    EXHASH_ITER(hh,ndrx_G_buffers,elt,tmp) 
+    if (M_shards_first)
     {
-        ndrx_growlist_add(list, elt->buf, i);
-        i++;
+        /* nothing allocated yet */
+        goto out;
+    }
+    
+    for (j=0; j<NDRX_TPBUF_SHARDS; j++)
+    {
+        NDRX_SPIN_LOCK_V(M_shards[j].lock);
+        EXHASH_ITER(hh, M_shards[j].buffers, elt, tmp)
+        {
+            ndrx_growlist_add(list, elt->buf, i);
+            i++;
+        }
+        NDRX_SPIN_UNLOCK_V(M_shards[j].lock);
     }
-    MUTEX_UNLOCK_V(M_lock);
     
 out:
         
@@ -149,56 +302,20 @@ out:
     return ret;
 }
 
-
 /**
- * Find the buffer in list of known buffers
- * Publick version, uses locking...
- * TODO: might want to optimize, so that multiple paralel reads are allowed
- * while there is no write...
- * @param ptr
+ * Find the buffer in the index of known buffers. Only the shard of the
+ * pointer is locked.
+ * @param ptr user data ptr
  * @return NULL - buffer not found/ptr - buffer found
  */
 expublic buffer_obj_t * ndrx_find_buffer(char *ptr)
 {
-    buffer_obj_t *ret;
-   
     if (NULL==ptr)
     {
         return &M_nullbuf;
     }
     
-    MUTEX_LOCK_V(M_lock);
-    EXHASH_FIND_PTR( ndrx_G_buffers, ((void **)&ptr), ret);
-    MUTEX_UNLOCK_V(M_lock);
-    
-    return ret;
-    
-}
-
-/**
- * Find the buffer in list of known buffers
- * Internal version, no locking used.
- * TODO: Move buffer registry to hash function
- * @param ptr
- * @return NULL - buffer not found/ptr - buffer found
- */
-exprivate buffer_obj_t * find_buffer_int(char *ptr)
-{
-    buffer_obj_t *ret=NULL;
-
-    /*
-    eltmp.buf = ptr;
-    DL_SEARCH(G_buffers, ret, &eltmp, buf_ptr_cmp_fn);
-    */
-    
-    if (NULL==ptr)
-    {
-        return &M_nullbuf;
-    }
-    
-    EXHASH_FIND_PTR( ndrx_G_buffers, ((void **)&ptr), ret);
-    
-    return ret;
+    return index_find(ptr, EXFALSE);
 }
 
 /**
@@ -268,18 +385,8 @@ expublic char * ndrx_tpalloc (typed_buffer_descr_t *known_type,
         goto out;
     }
 
-    /* now append the memory list with allocated block */
-    if (NULL==(node=(buffer_obj_t *)NDRX_FPMALLOC(sizeof(buffer_obj_t), 0)))
-    {
-        ndrx_TPset_error_fmt(TPEOS, "%s: Failed to allocate buffer list node: %s",  __func__,
-                                        strerror(errno));
-        ret=NULL;
-
-        goto out;
-    }
-
-    /* Now append the list */
-    memset(node, 0, sizeof(buffer_obj_t));
+    /* header is allocated by type handler in front of data */
+    node = NDRX_TPBUF_OBJ(ret);
 
     node->buf = ret;
     NDRX_LOG(log_debug, "%s: type=%s subtype=%s len=%d allocated=%p", 
@@ -299,11 +406,7 @@ expublic char * ndrx_tpalloc (typed_buffer_descr_t *known_type,
         NDRX_STRCPY_SAFE(node->subtype, subtype);
     }
 
-    MUTEX_LOCK_V(M_lock);
-    /* Save the allocated buffer in the list */
-    /* DL_APPEND(G_buffers, node); */
-    EXHASH_ADD_PTR(ndrx_G_buffers, buf, node);
-    MUTEX_UNLOCK_V(M_lock);
+    index_add(node);
 
 out:
     
@@ -330,9 +433,11 @@ expublic char * ndrx_tprealloc (char *buf, long len)
         goto out_nolock;
     }
     
-    if (NULL==(node=ndrx_find_buffer(buf)))
+    /* header moves together with the data, thus buffer is taken out
+     * of the index while reallocating
+     */
+    if (NULL==(node=index_find(buf, EXTRUE)))
     {
-        MUTEX_UNLOCK_V(M_lock);
          ndrx_TPset_error_fmt(TPEINVAL, "%s: Buffer %p is not know to system",  
                  __func__, buf);
         ret=NULL;
@@ -349,19 +454,14 @@ expublic char * ndrx_tprealloc (char *buf, long len)
      */
     if (NULL==(ret=buf_type->pf_realloc(buf_type, buf, len)))
     {
-        ret=NULL;
+        index_add(node);
         goto out;
     }
 
+    node = NDRX_TPBUF_OBJ(ret);
     node->buf = ret;
-    
-    /* update the hash list */
-    MUTEX_LOCK_V(M_lock);
-    EXHASH_DEL(ndrx_G_buffers, node);
-    EXHASH_ADD_PTR(ndrx_G_buffers, buf, node);
-    MUTEX_UNLOCK_V(M_lock);
-    
     node->size = len;
+    index_add(node);
 
 out:
     
@@ -373,6 +473,7 @@ out_nolock:
 /**
  * Remove the buffer
  * @param buf
+ * @param known_buffer not used, buffer is always taken from the index
  */
 expublic void ndrx_tpfree (char *buf, buffer_obj_t *known_buffer)
 {
@@ -388,13 +489,10 @@ expublic void ndrx_tpfree (char *buf, buffer_obj_t *known_buffer)
         return;
     }
     
-    /* Work out the buffer */
-    if (NULL!=known_buffer)
-        elt=known_buffer;
-    else
-    {
-        elt=ndrx_find_buffer(buf);
-    }
+    /* Work out the buffer, the index decides, thus double free or
+     * foreign pointer is ignored
+     */
+    elt=index_find(buf, EXTRUE);
 
     if (NULL!=elt)
     {
@@ -410,17 +508,10 @@ expublic void ndrx_tpfree (char *buf, buffer_obj_t *known_buffer)
         }
              
         buf_type = &G_buf_descr[elt->type_id];
+        
+        /* elt is freed together with data */
         /* Remove it! */
         buf_type->pf_free(buf_type, elt->buf);
-        
-        /* Remove that stuff from our linked list!! */
-        /* DL_DELETE(G_buffers,elt); */
-        MUTEX_LOCK_V(M_lock);
-        EXHASH_DEL(ndrx_G_buffers, elt);
-        MUTEX_UNLOCK_V(M_lock);
-        
-        /* delete elt by it self */
-        NDRX_FPFREE(elt);
     }
     
 }
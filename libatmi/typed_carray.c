@@ -223,7 +223,7 @@ expublic char * CARRAY_tpalloc (typed_buffer_descr_t *descr, char *subtype, long
     }
 
     /* Allocate CARRAY buffer */
-    ret=(char *)NDRX_MALLOC(*len);
+    ret=ndrx_tpbuf_malloc(*len);
     
     if (NULL!=ret)
     {
@@ -255,7 +255,7 @@ expublic char * CARRAY_tprealloc(typed_buffer_descr_t *descr, char *cur_ptr, lon
     }
 
     /* Allocate CARRAY buffer */
-    ret=(char *)NDRX_REALLOC(cur_ptr, len);
+    ret=ndrx_tpbuf_realloc(cur_ptr, len);
     
     if (NULL==ret)
     {
@@ -273,7 +273,7 @@ expublic char * CARRAY_tprealloc(typed_buffer_descr_t *descr, char *cur_ptr, lon
  */
 expublic void CARRAY_tpfree(typed_buffer_descr_t *descr, char *buf)
 {
-    NDRX_FREE(buf);
+    ndrx_tpbuf_free(buf);
 }
 
 /**
@@ -44,6 +44,7 @@
 #include <typed_buf.h>
 #include <ndebug.h>
 #include <fdatatype.h>
+#include <ubf_int.h>
 #include <userlog.h>
 /*---------------------------Externs------------------------------------*/
 /*---------------------------Macros-------------------------------------*/
@@ -224,7 +225,7 @@ expublic char * STRING_tpalloc (typed_buffer_descr_t *descr, char *subtype, long
     }
 
     /* Allocate STRING buffer */
-    ret=(char *)NDRX_MALLOC(*len);
+    ret=ndrx_tpbuf_malloc(*len);
     if (NULL!=ret)
     {
         ret[0] = EXEOS;
@@ -255,7 +256,7 @@ expublic char * STRING_tprealloc(typed_buffer_descr_t *descr, char *cur_ptr, lon
     }
 
     /* Allocate STRING buffer */
-    ret=(char *)NDRX_REALLOC(cur_ptr, len);
+    ret=ndrx_tpbuf_realloc(cur_ptr, len);
     
     if (NULL==ret)
     {
@@ -273,7 +274,7 @@ expublic char * STRING_tprealloc(typed_buffer_descr_t *descr, char *cur_ptr, lon
  */
 expublic void STRING_tpfree(typed_buffer_descr_t *descr, char *buf)
 {
-    NDRX_FREE(buf);
+    ndrx_tpbuf_free(buf);
 }
 
 /**
@@ -287,15 +288,15 @@ expublic void STRING_tpfree(typed_buffer_descr_t *descr, char *buf)
 expublic int STRING_test(typed_buffer_descr_t *descr, char *buf, BFLDLEN len, char *expr)
 {
     int ret=EXFALSE;
-    regex_t re; /* compiled regex */
+    ndrx_ubf_exprc_t *ent; /* compiled regex */
     
-    if (EXSUCCEED==(ret=regcomp(&re, expr, REG_EXTENDED | REG_NOSUB)))
+    if (NULL!=(ent=ndrx_ubf_exprc_get(NDRX_UBFEXPRC_REGEX, expr)))
     {
-        if (EXSUCCEED==regexec(&re, buf, (size_t) 0, NULL, 0))
+        if (EXSUCCEED==regexec(&ent->re, buf, (size_t) 0, NULL, 0))
         {
             ret = EXTRUE;
         }
-        regfree(&re);
+        ndrx_ubf_exprc_release(ent);
     }
     else
     {
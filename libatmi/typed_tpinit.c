@@ -60,7 +60,7 @@ expublic char * TPINIT_tpalloc (typed_buffer_descr_t *descr, char *subtype, long
     char fn[] = "UBF_tpalloc";
 
     /* Allocate UBF buffer */
-    ret=NDRX_MALLOC(sizeof(TPINIT));
+    ret=ndrx_tpbuf_malloc(sizeof(TPINIT));
 
     if (NULL==ret)
     {
@@ -80,6 +80,6 @@ out:
  */
 expublic void TPINIT_tpfree(typed_buffer_descr_t *descr, char *buf)
 {
-    NDRX_FREE(buf);
+    ndrx_tpbuf_free(buf);
 }
 /* vim: set ts=4 sw=4 et smartindent: */
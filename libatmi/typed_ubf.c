@@ -248,13 +248,28 @@ expublic char * UBF_tpalloc (typed_buffer_descr_t *descr, char *subtype, long *l
         *len = UBF_DEFAULT_SIZE;
     }
 
-    /* Allocate UBF buffer */
-    ret=(char *)ndrx_Balloc(0, 0, *len);
+    if (*len > MAXUBFLEN)
+    {
+        ndrx_TPset_error_fmt(TPEINVAL, "%s: Requesting %ld, but max is %ld bytes",
+                __func__, *len, (long)MAXUBFLEN);
+        goto out;
+    }
 
-    if (NULL==ret)
+    /* Allocate UBF buffer */
+    if (NULL==(ret=ndrx_tpbuf_malloc(*len)))
     {
         NDRX_LOG(log_error, "%s: Failed to allocate UBF buffer!", __func__);
-        ndrx_TPset_error_msg(TPEOS, Bstrerror(Berror));
+        ndrx_TPset_error_fmt(TPEOS, "%s: Failed to allocate UBF buffer "
+                "(len=%ld): %s", __func__, *len, strerror(errno));
+        goto out;
+    }
+
+    if (EXSUCCEED!=Binit((UBFH *)ret, *len))
+    {
+        NDRX_LOG(log_error, "%s: Failed to init UBF buffer!", __func__);
+        ndrx_TPset_error_msg(TPEINVAL, Bstrerror(Berror));
+        ndrx_tpbuf_free(ret);
+        ret=NULL;
         goto out;
     }
 
@@ -273,7 +288,7 @@ out:
 expublic char * UBF_tprealloc(typed_buffer_descr_t *descr, char *cur_ptr, long len)
 {
     char *ret=NULL;
-    UBFH *p_ub = (UBFH *)cur_ptr;
+    UBF_header_t *hdr = (UBF_header_t *)cur_ptr;
     char fn[] = "UBF_tprealloc";
 
     if (UBF_DEFAULT_SIZE > len)
@@ -281,15 +296,29 @@ expublic char * UBF_tprealloc(typed_buffer_descr_t *descr, char *cur_ptr, long l
         len = UBF_DEFAULT_SIZE;
     }
 
-    /* Allocate UBF buffer */
-    ret=(char *)ndrx_Brealloc(p_ub, 0, 0, len);
+    /* New buffer size should not be smaller that used. */
+    if (len < hdr->bytes_used || len > MAXUBFLEN)
+    {
+        ndrx_TPset_error_fmt(TPEINVAL, "%s: Requesting %ld, but min is %ld "
+                "and max is %ld bytes", fn, len, (long)hdr->bytes_used, 
+                (long)MAXUBFLEN);
+        goto out;
+    }
 
-    if (NULL==ret)
+    /* Reallocate UBF buffer */
+    if (NULL==(ret=ndrx_tpbuf_realloc(cur_ptr, len)))
     {
         NDRX_LOG(log_error, "%s: Failed to allocate UBF buffer!", fn);
-        ndrx_TPset_error_msg(TPEOS, Bstrerror(Berror));
+        ndrx_TPset_error_fmt(TPEOS, "%s: Failed to reallocate UBF buffer "
+                "(len=%ld): %s", fn, len, strerror(errno));
+        goto out;
     }
 
+    /* Update UBF to new size. */
+    hdr = (UBF_header_t *)ret;
+    hdr->buf_len = len;
+
+out:
     return ret;
 }
 
@@ -300,7 +329,7 @@ expublic char * UBF_tprealloc(typed_buffer_descr_t *descr, char *cur_ptr, long l
  */
 expublic void UBF_tpfree(typed_buffer_descr_t *descr, char *buf)
 {
-    Bfree((UBFH *)buf);
+    ndrx_tpbuf_free(buf);
 }
 
 /**
@@ -314,19 +343,20 @@ expublic void UBF_tpfree(typed_buffer_descr_t *descr, char *buf)
 expublic int UBF_test(typed_buffer_descr_t *descr, char *buf, BFLDLEN len, char *expr)
 {
     int ret=EXFALSE;
-    char *tree;
+    ndrx_ubf_exprc_t *ent;
 
-    /* compile the xpression */
-    if (NULL==(tree=Bboolco (expr)))
+    /* get the compiled expression from the cache */
+    if (NULL==(ent=ndrx_ubf_exprc_get(NDRX_UBFEXPRC_UBF, expr)))
     {
         NDRX_LOG(log_error, "Failed to compile expression [%s], err: %s",
-                                    Bstrerror(Berror));
+                                    expr, Bstrerror(Berror));
+        EXFAIL_OUT(ret);
     }
 
-    ret=Bboolev((UBFH *)buf, tree);
+    ret=Bboolev((UBFH *)buf, ent->tree);
     
-    /* Free up the buffer */
-    Btreefree(tree);
+    /* Release the cache entry */
+    ndrx_ubf_exprc_release(ent);
 
 out:
     return ret;
@@ -126,7 +126,7 @@ expublic char * VIEW_tpalloc (typed_buffer_descr_t *descr, char *subtype, long *
     
     /* Allocate VIEW buffer */
     /* Maybe still malloc? */
-    ret=(char *)NDRX_CALLOC(1, *len);
+    ret=ndrx_tpbuf_calloc(*len);
 
     if (NULL==ret)
     {
@@ -166,7 +166,7 @@ expublic char * VIEW_tprealloc(typed_buffer_descr_t *descr, char *cur_ptr, long
     }
 
     /* Allocate CARRAY buffer */
-    ret=(char *)NDRX_REALLOC(cur_ptr, len);
+    ret=ndrx_tpbuf_realloc(cur_ptr, len);
     
 
     return ret;
@@ -817,7 +817,7 @@ out:
  */
 expublic void VIEW_tpfree(typed_buffer_descr_t *descr, char *buf)
 {
-    NDRX_FREE(buf);
+    ndrx_tpbuf_free(buf);
 }
 
 
@@ -442,9 +442,11 @@ expublic int dynamic_advertise(svc_entry_fn_t *entry_new,
     if (G_shm_srv)
     {
 #ifdef EX_USE_SYSVQ
-        ret=ndrx_shm_install_svc(entry_new->svc_nm, 0, ndrx_epoll_resid_get());
+        ret=ndrx_shm_install_svc(entry_new->svc_nm, NDRXD_SVCINFO_CMPCTHDR, 
+                ndrx_epoll_resid_get());
 #else
-        ret=ndrx_shm_install_svc(entry_new->svc_nm, 0, G_server_conf.srv_id);
+        ret=ndrx_shm_install_svc(entry_new->svc_nm, NDRXD_SVCINFO_CMPCTHDR, 
+                G_server_conf.srv_id);
 #endif
     }
     
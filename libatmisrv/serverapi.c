@@ -277,6 +277,7 @@ expublic char * tpsrvgetctxdata2 (char *p_buf, long *p_len)
 {
     server_ctx_info_t *ret = NULL;
     tp_command_call_t *last_call = ndrx_get_G_last_call();
+    ndrx_trace_t *last_trace = ndrx_get_G_last_trace();
     tp_conversation_control_t *p_accept_con;
     
     API_ENTRY;
@@ -327,6 +328,9 @@ expublic char * tpsrvgetctxdata2 (char *p_buf, long *p_len)
     memcpy(&ret->G_last_call, last_call, sizeof(ret->G_last_call));
     memset(last_call, 0, sizeof(ret->G_last_call));
     
+    memcpy(&ret->G_last_trace, last_trace, sizeof(ret->G_last_trace));
+    last_trace->trace_id = 0;
+    
     p_accept_con = ndrx_get_G_accepted_connection();
     memcpy(&ret->G_accepted_connection, p_accept_con, sizeof(*p_accept_con));
     memset(p_accept_con, 0, sizeof(*p_accept_con));
@@ -393,6 +397,8 @@ expublic int tpsrvsetctxdata (char *data, long flags)
     }
 #endif
     memcpy(last_call, &ctxdata->G_last_call, sizeof(ctxdata->G_last_call));
+    memcpy(ndrx_get_G_last_trace(), &ctxdata->G_last_trace, 
+            sizeof(ctxdata->G_last_trace));
     
     p_accept_con = ndrx_get_G_accepted_connection();
     memcpy(p_accept_con, &ctxdata->G_accepted_connection, 
@@ -207,6 +207,7 @@ struct server_ctx_info
 {
     tp_conversation_control_t G_accepted_connection;
     tp_command_call_t         G_last_call;
+    ndrx_trace_t              G_last_trace;     /* Trace of the call served  */
     int                       is_in_global_tx;  /* Running in global tx      */
     TPTRANID                  tranid;           /* Transaction ID  (if used) */
 };
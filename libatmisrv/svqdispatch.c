@@ -203,9 +203,11 @@ expublic int sv_open_queue(void)
         if (use_sem)
         {
 #ifdef EX_USE_SYSVQ
-            ret=ndrx_shm_install_svc(entry->svc_nm, 0, ndrx_epoll_resid_get());
+            ret=ndrx_shm_install_svc(entry->svc_nm, NDRXD_SVCINFO_CMPCTHDR, 
+                    ndrx_epoll_resid_get());
 #else
-            ret=ndrx_shm_install_svc(entry->svc_nm, 0, G_server_conf.srv_id);
+            ret=ndrx_shm_install_svc(entry->svc_nm, NDRXD_SVCINFO_CMPCTHDR, 
+                    G_server_conf.srv_id);
 #endif
         }
 
@@ -302,6 +304,8 @@ expublic int sv_serve_call(int *service, int *status,
     int generate_rply = EXFALSE;
     tp_command_call_t * last_call=NULL;
     long error_code = TPESVCERR; /**< Default error in case if cannot process */
+    char *call_data;
+    long call_data_len;
     *status=EXSUCCEED;
     G_atmisrv_reply_type = 0;
     
@@ -329,6 +333,7 @@ expublic int sv_serve_call(int *service, int *status,
                     	call->cd, call->timestamp, call->callseq, 
 		    call->name, call->flags, call_age, call->data_len,
                         call->my_id, call->reply_to, call->clttout);
+        ndrx_lmsg_release(call);
         *status=EXFAIL;
         goto out;
     }
@@ -347,6 +352,7 @@ expublic int sv_serve_call(int *service, int *status,
             NDRX_LOG(log_always, "Invalid buffer type received %hd"
                                         "min = %d max %d",
                             call->buffer_type_id, BUF_TYPE_MIN, BUF_TYPE_MAX);
+            ndrx_lmsg_release(call);
             *status=EXFAIL;
             generate_rply = EXTRUE;
             error_code = TPEITYPE;
@@ -354,12 +360,25 @@ expublic int sv_serve_call(int *service, int *status,
         }
         call_type = &G_buf_descr[call->buffer_type_id];
         
+        /* payload may be in the large message pool */
+        if (EXSUCCEED!=ndrx_lmsg_resolve(call, &call_data, &call_data_len))
+        {
+            ndrx_lmsg_release(call);
+            *status=EXFAIL;
+            generate_rply = EXTRUE;
+            error_code = TPESYSTEM;
+            goto out;
+        }
+        
         ret=call_type->pf_prepare_incoming(call_type,
-                        call->data,
-                        call->data_len,
+                        call_data,
+                        call_data_len,
                         &request_buffer,
                         &req_len,
                         0L);
+        
+        /* slab is not needed any more, data is in typed buffer */
+        ndrx_lmsg_release(call);
 
         if (EXSUCCEED!=ret)
         {
@@ -403,6 +422,8 @@ expublic int sv_serve_call(int *service, int *status,
         memcpy(last_call, call, sizeof(tp_command_call_t));
                              /* save last call info to ATMI library
                               * (this does excludes data by default) */
+        /* trace is not part of the header, keep it too */
+        ndrx_calltrace_serve(call, call_len);
         
         /* Register global tx */
         if (EXEOS!=call->tmxid[0])
@@ -536,6 +557,7 @@ expublic int sv_serve_call(int *service, int *status,
         
         if (EXFAIL!=*status) /* Dot not invoke if failed! */
         {
+            ndrx_calltrace_hop(ndrx_get_G_last_trace(), NDRX_TRACE_HOP_SVCSTART);
             G_server_conf.service_array[call_no]->p_func(&svcinfo);
         }
         
@@ -951,7 +973,13 @@ expublic int sv_server_request(char **call_buf, long call_len, int call_no)
         /* go out, nothing to do new... */
         goto out;
     }
-    
+
+    /* local callers may send compact call header */
+    if (EXFAIL==ndrx_callhdr_decode(*call_buf, NDRX_MSGSIZEMAX, &call_len))
+    {
+        NDRX_LOG(log_error, "Dropping invalid compact call");
+        EXFAIL_OUT(ret);
+    }
 
     NDRX_LOG(log_debug, "Got command: %hd", gen_command->command_id);
 
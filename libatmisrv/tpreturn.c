@@ -86,6 +86,7 @@ expublic void _tpreturn (int rval, long rcode, char *data, long len, long flags)
     tp_conversation_control_t *p_accept_conn = ndrx_get_G_accepted_connection();
     tp_command_call_t * last_call;
     int was_auto_buf = EXFALSE;
+    int lmsg = EXFALSE;
     
     last_call = ndrx_get_G_last_call();
     
@@ -94,6 +95,9 @@ expublic void _tpreturn (int rval, long rcode, char *data, long len, long flags)
         NDRX_LOG(log_debug, "No reply required (TPNOREPLY) - return to main() "
                 "flags: %ld", last_call->flags);
         
+        /* nobody waits for reply, trace completes here */
+        ndrx_calltrace_noreply(last_call);
+        
         /* commit or abort .. if autotran was started */
         if (last_call->sysflags & SYS_FLAG_AUTOTRAN
             && tpgetlev())
@@ -148,6 +152,9 @@ expublic void _tpreturn (int rval, long rcode, char *data, long len, long flags)
         call->cd-=NDRX_CONV_UPPER_CNT;
         call->msgseq = p_accept_conn->msgseqout;
         p_accept_conn->msgseqout++;
+        /* initiator checks queue generation and our identity */
+        call->convgen = p_accept_conn->gen_out;
+        NDRX_STRCPY_SAFE(call->my_id, p_atmi_lib_conf->my_id);
     }
 
     call->timestamp = last_call->timestamp;
@@ -277,8 +284,28 @@ expublic void _tpreturn (int rval, long rcode, char *data, long len, long flags)
                 
                 /* otherwise cannot generate error */
                 call->data_len = MAX_CALL_DATA_SIZE;
+                
+                /* large reply to local caller goes via shm pool */
+                if (EXEOS==last_call->callstack[0] && 
+                        CONV_IN_CONVERSATION!=p_accept_conn->status &&
+                        EXFAIL==(lmsg=ndrx_lmsg_prepare_outgoing(descr, 
+                            buffer_info, data, len, call, 
+                            (last_call->flags & TPNOTIME)?0:last_call->clttout, 
+                            last_call->my_id, flags)))
+                {
+                    lmsg = EXFALSE;
+                    /* set reply fail FLAG */
+                    call->sysflags |=SYS_FLAG_REPLY_ERROR;
+                    call->rcode = TPESYSTEM;
+                    call->data_len = 0;
+                    ret=EXFAIL;
+                }
+                else if (lmsg)
+                {
+                    call->buffer_type_id = buffer_info->type_id;
+                }
                 /* build reply data here */
-                if (EXFAIL==descr->pf_prepare_outgoing(descr, data, 
+                else if (EXFAIL==descr->pf_prepare_outgoing(descr, data, 
                         len, call->data, &call->data_len, flags))
                 {
                     /* set reply fail FLAG */
@@ -312,6 +339,8 @@ out_send:
 
     data_len = sizeof(tp_command_call_t)+call->data_len;
     call->command_id = ATMI_COMMAND_TPREPLY;
+    /* compact header only if caller decodes it */
+    call->sysflags |= (last_call->sysflags & SYS_FLAG_CMPCTHDR);
     
     /* If this is gateway timeout, then set the flags accordingly */
     
@@ -340,11 +369,19 @@ out_send:
     /* keep the timer from last call. */
     call->timer = last_call->timer;
     
+    /* and the trace */
+    data_len+=ndrx_calltrace_reply(call, last_call);
+    
     /* Get the reply order... */
     NDRX_STRCPY_SAFE(call->callstack, last_call->callstack);
     if (EXSUCCEED!=fill_reply_queue(call->callstack, last_call->reply_to, reply_to))
     {
         NDRX_LOG(log_error, "ATTENTION!! Failed to get reply queue");
+        
+        if (lmsg)
+        {
+            ndrx_lmsg_release(call);
+        }
         goto out;
     }
     
@@ -374,10 +411,17 @@ out_send:
      * the closest reply node... We might event not to pop the stack.
      * But each node searches for closest path, from right to left.
      */
-    if (EXFAIL==ndrx_generic_q_send(reply_to, (char *)call, data_len, flags, 0))
+    if (EXFAIL==ndrx_callhdr_q_send(reply_to, call, data_len, flags, 0, 
+            EXEOS==last_call->callstack[0] && 
+            CONV_IN_CONVERSATION!=p_accept_conn->status))
     {
         NDRX_LOG(log_error, "ATTENTION!! Reply to queue [%s] failed!",
                                             reply_to);
+        
+        if (lmsg)
+        {
+            ndrx_lmsg_release(call);
+        }
         goto out;
     }
 
@@ -491,6 +535,7 @@ expublic void _tpforward (char *svc, char *data,
     int prio = NDRX_MSGPRIO_DEFAULT;
     tp_conversation_control_t *p_accept_conn = ndrx_get_G_accepted_connection();
     char svcddr[XATMI_SERVICE_NAME_LENGTH+1]; /**< routed service name */
+    int lmsg = EXFALSE;
     
     NDRX_LOG(log_debug, "%s enter", fn);
     
@@ -572,12 +617,40 @@ expublic void _tpforward (char *svc, char *data,
         }
     }
     
+    /* Check is service available? 
+     * (known before data prepare, as local destinations may use shm pool)
+     */
+    if (EXSUCCEED!=ndrx_shm_get_svc(svcddr, send_q, &is_bridge, NULL))
+    {
+        NDRX_LOG(log_error, "Service is not available %s by shm", 
+                svcddr);
+        ret=EXFAIL;
+        ndrx_TPset_error_fmt(TPENOENT, "%s: Service is not available %s by shm", 
+                fn, svcddr);
+                /* we should reply back, that call failed, so that client does not wait */
+        reply_with_failure(flags, last_call, NULL, NULL, TPESVCERR);
+        goto out;
+    }
+    
     descr = &G_buf_descr[buffer_info->type_id];
 
+    /* large payload for local service goes via shm pool */
+    if (!is_bridge && EXFAIL==(lmsg=ndrx_lmsg_prepare_outgoing(descr, 
+            buffer_info, data, len, call, 
+            (last_call->flags & TPNOTIME)?0:last_call->clttout, NULL, flags)))
+    {
+        lmsg=EXFALSE;
+        ret=EXFAIL;
+        goto out;
+    }
+    else if (lmsg)
+    {
+        data_len = call->data_len;
+    }
     /* prepare buffer for call 
      * TODO: should we check call/buf (buf_len) buffer output size?
      */
-    if (EXSUCCEED!=descr->pf_prepare_outgoing(descr, data, len, call->data, &data_len, flags))
+    else if (EXSUCCEED!=descr->pf_prepare_outgoing(descr, data, len, call->data, &data_len, flags))
     {
         /* not good - error should be already set */
         ret=EXFAIL;
@@ -605,6 +678,8 @@ expublic void _tpforward (char *svc, char *data,
     
     /* TODO: forward the indication of syste but only if we are in the transaction at the momment */
     call->sysflags|= (last_call->sysflags & SYS_FLAG_AUTOTRAN);
+    /* reply goes to the original caller */
+    call->sysflags|= (last_call->sysflags & SYS_FLAG_CMPCTHDR);
     
     /* work out the XA data */
     if (ndrx_get_G_atmi_xa_curtx()->txinfo)
@@ -628,6 +703,9 @@ expublic void _tpforward (char *svc, char *data,
     /* Want to keep original call time... */
     memcpy(&call->timer, &last_call->timer, sizeof(call->timer));
     
+    /* next service continues the trace */
+    data_len+=ndrx_calltrace_forward(call);
+    
     /* Hmm we can free up the data? - do it here because we still need buffer_info!
      * ???? NOTE HERE! Bug #250 - all job is done bellow!
     if (NULL!=data)
@@ -636,19 +714,6 @@ expublic void _tpforward (char *svc, char *data,
     }
     *
     */
-    /* Check is service available? */
-    if (EXSUCCEED!=ndrx_shm_get_svc(call->name, send_q, &is_bridge, NULL))
-    {
-        NDRX_LOG(log_error, "Service is not available %s by shm", 
-                call->name);
-        ret=EXFAIL;
-        ndrx_TPset_error_fmt(TPENOENT, "%s: Service is not available %s by shm", 
-                fn, call->name);
-                /* we should reply back, that call failed, so that client does not wait */
-        reply_with_failure(flags, last_call, NULL, NULL, TPESVCERR);
-        goto out;
-    }
-    
     if (ndrx_get_G_atmi_xa_curtx()->txinfo)
     {
         _tp_srv_disassoc_tx();
@@ -657,7 +722,8 @@ expublic void _tpforward (char *svc, char *data,
     NDRX_LOG(log_debug, "Forwarding cd %d, timestamp %d, callseq %u to %s, buffer_type_id %hd",
                     call->cd, call->timestamp, call->callseq, send_q, call->buffer_type_id);
         
-    if (EXSUCCEED!=(ret=ndrx_generic_q_send(send_q, (char *)call, data_len, flags, prio)))
+    if (EXSUCCEED!=(ret=ndrx_callhdr_q_send(send_q, call, data_len, flags, 
+            prio, !is_bridge)))
     {
         /* reply FAIL back to caller! */
         int err;
@@ -682,6 +748,12 @@ expublic void _tpforward (char *svc, char *data,
 
 out:
 
+    /* message not sent, give back the slab */
+    if (EXFAIL==ret && lmsg)
+    {
+        ndrx_lmsg_release(call);
+    }
+
     if (NULL!=buf)
     {
         NDRX_SYSBUF_FREE(buf);
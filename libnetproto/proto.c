@@ -91,6 +91,7 @@
 #define XINC           0x04               /* Include table          */
 #define XLOOP          0x05               /* Loop construction      */
 #define XATMIBUF       0x06               /* ATMI buffer type...    */
+#define XTRACE         0x07               /* Call trace after ATMI buffer, optional */
 
 #define XTAB1(e1)           1, e1, NULL, NULL, NULL
 #define XTAB2(e1,e2)        2, e1, e2, NULL, NULL
@@ -268,6 +269,8 @@ static cproto_t M_cmd_br_time_sync_x[] =
     {TST, 0x10B1,  "seq",        OFSZ(cmd_br_time_sync_t,orig_seq),         EXF_LONG,XFLD, 1, 20},
     {TST, 0x10B2,  "orig_nodeid",OFSZ(cmd_br_time_sync_t,orig_nodeid),      EXF_INT, XFLD, 1, 3},
     {TST, 0x11B3,  "orig_timestamp", OFSZ(cmd_br_time_sync_t,orig_timestamp),EXF_LONG,XFLD, 1, 20},
+    {TST, 0x11B4,  "cmpr",       OFSZ(cmd_br_time_sync_t,cmpr),             EXF_INT, XFLD, 1, 1},
+    {TST, 0x11B5,  "credits",    OFSZ(cmd_br_time_sync_t,credits),          EXF_INT, XFLD, 1, 10},
     
     {TST, EXFAIL}
 };
@@ -352,6 +355,30 @@ static cproto_t M_ubf_field[] =
     {TUF, EXFAIL}
 };
 
+/* Convert for ndrx_trace_hop_t */
+#define TTH        10 /* call trace hop */
+static cproto_t M_trace_hop_x[] = 
+{
+    {TTH, 0x1343,  "usec",      OFSZ(ndrx_trace_hop_t,usec),      EXF_INT,    XFLD, 1, 10},
+    {TTH, 0x134D,  "kind",      OFSZ(ndrx_trace_hop_t,kind),      EXF_SHORT,  XFLD, 1, 5},
+    {TTH, 0x1357,  "nodeid",    OFSZ(ndrx_trace_hop_t,nodeid),    EXF_SHORT,  XFLD, 1, 5},
+    {TTH, EXFAIL}
+};
+
+/* Convert for ndrx_trace_t */
+#define TTR        11 /* call trace */
+static cproto_t M_trace_x[] = 
+{
+    {TTR, 0x1361,  "trace_id",  OFSZ(ndrx_trace_t,trace_id),      EXF_LONG,   XFLD, 1, 20},
+    {TTR, 0x136B,  "span_id",   OFSZ(ndrx_trace_t,span_id),       EXF_LONG,   XFLD, 1, 20},
+    {TTR, 0x1375,  "parent_id", OFSZ(ndrx_trace_t,parent_id),     EXF_LONG,   XFLD, 1, 20},
+    {TTR, 0x137F,  "base",      OFSZ(ndrx_trace_t,base),          EXF_NTIMER, XFLD, 20, 20},
+    {TTR, 0x1389,  "nhops",     OFSZ(ndrx_trace_t,nhops),         EXF_INT,    XFLD, 1, 10},
+    {TTR, 0x1393,  "hops",      OFSZ(ndrx_trace_t,hops),          EXF_NONE,   XLOOP, 0, PMSGMAX, M_trace_hop_x, 
+                            EXOFFSET(ndrx_trace_t,nhops), sizeof(ndrx_trace_hop_t)},
+    {TTR, EXFAIL}
+};
+
 /* Converter for  tp_command_call_t */
 #define TTC        7 /* tpcall */
 static cproto_t M_tp_command_call_x[] = 
@@ -374,6 +401,8 @@ static cproto_t M_tp_command_call_x[] =
     {TTC, 0x11D1,  "timestamp", OFSZ(tp_command_call_t,timestamp),EXF_LONG,   XFLD, 1, 20},
     {TTC, 0x11DB,  "callseq",   OFSZ(tp_command_call_t,callseq),  EXF_USHORT,   XFLD, 1, 5},
     {TTC, 0x11DC,  "msgseq",    OFSZ(tp_command_call_t,msgseq),   EXF_USHORT,   XFLD, 1, 5},
+    {TTC, 0x11DD,  "convgen",   OFSZ(tp_command_call_t,convgen),  EXF_USHORT,   XFLD, 1, 5},
+    {TTC, 0x11DE,  "convgen_snd",OFSZ(tp_command_call_t,convgen_snd),EXF_USHORT, XFLD, 1, 5},
     {TTC, 0x11E5,  "timer",     OFSZ(tp_command_call_t,timer),    EXF_NTIMER, XFLD, 20, 20},
     {TTC, 0x11EF,  "data_len",  OFSZ(tp_command_call_t,data_len), EXF_LONG,   XSBL, 1, 10},
     {TTC, 0x11F9,  "data",      OFSZ(tp_command_call_t,data),     EXF_NONE,  XATMIBUF, 0, PMSGMAX, NULL, 
@@ -386,6 +415,10 @@ static cproto_t M_tp_command_call_x[] =
     {TTC, 0x122B,  "tmknownrms",OFSZ(tp_command_call_t,tmknownrms),    EXF_STRING, XFLD, 0, (NDRX_MAX_RMS+1)},
     /* Is transaction marked as abort only? */
     {TTC, 0x1235,  "tmtxflags", OFSZ(tp_command_call_t, tmtxflags), EXF_SHORT,   XFLD, 1, 1},
+    /* Call trace section after the data, sent only if SYS_FLAG_TRACE is set
+     * (buftype_offset points to sysflags) */
+    {TTC, 0x1236,  "trace",     OFSZ(tp_command_call_t,data),     EXF_NONE, XTRACE, 0, PMSGMAX, M_trace_x, 
+                            EXOFFSET(tp_command_call_t,data_len), EXFAIL, NULL, EXOFFSET(tp_command_call_t,sysflags)},
     {TTC, EXFAIL}
 };
 
@@ -427,6 +460,15 @@ static cproto_t M_tp_notif_call_x[] =
     {TPN, EXFAIL}
 };
 
+/* Convert for cmd_br_credit_t */
+#define TCR        9 /* bridge credits */
+static cproto_t M_cmd_br_credit_x[] = 
+{
+    {TCR, 0x132F,  "call",      OFSZ0,                            EXF_NONE,   XINC, 1, PMSGMAX, M_command_call_x},
+    {TCR, 0x1339,  "credits",   OFSZ(cmd_br_credit_t,credits),    EXF_INT,    XFLD, 1, 10},
+    {TCR, EXFAIL}
+};
+
 /**
  * Get the number of elements in array.
  */
@@ -440,7 +482,10 @@ static ptinfo_t M_ptinfo[] =
     {TBR, N_DIM(M_bridge_refresh_x)},
     {TUF, N_DIM(M_ubf_field)},
     {TTC, N_DIM(M_tp_command_call_x)},
-    {TPN, N_DIM(M_tp_notif_call_x)}
+    {TPN, N_DIM(M_tp_notif_call_x)},
+    {TCR, N_DIM(M_cmd_br_credit_x)},
+    {TTH, N_DIM(M_trace_hop_x)},
+    {TTR, N_DIM(M_trace_x)}
 };
 
 /* Message conversion tables */
@@ -453,6 +498,7 @@ static xmsg_t M_ndrxd_x[] =
     {'N', ATMI_COMMAND_BROADCAST, "broadcast",  XTAB2(M_cmd_br_net_call_x, M_tp_notif_call_x)},
     {'X', NDRXD_COM_BRCLOCK_RQ,  "brclockreq",  XTAB2(M_cmd_br_net_call_x, M_cmd_br_time_sync_x)},
     {'X', NDRXD_COM_BRREFERSH_RQ,"brrefreshreq",XTAB2(M_cmd_br_net_call_x, M_bridge_refresh_x)},
+    {'X', NDRXD_COM_BRCREDIT_RQ, "brcreditreq", XTAB2(M_cmd_br_net_call_x, M_cmd_br_credit_x)},
     {EXFAIL, EXFAIL}
 };
 
@@ -1558,6 +1604,60 @@ expublic int exproto_build_ex2proto(xmsg_t *cv, int level, long offset,
                 }
             }
                 break;
+            case XTRACE:
+            {
+                /* Optional section, placed after the ATMI buffer */
+                long *sysflags = (long *)(ex_buf+offset+p->buftype_offset);
+                long *buf_len = (long *)(ex_buf+offset+p->counter_offset);
+                xmsg_t tmp_cv;
+                long len_offset;
+                long off_start;
+                
+                if (!(*sysflags & SYS_FLAG_TRACE))
+                {
+                    goto tag_continue;
+                }
+                
+                memcpy(&tmp_cv, cv, sizeof(tmp_cv));
+                tmp_cv.tab[0] = p->include;
+                
+                if (EXSUCCEED!=write_tag((short)p->tag, proto_buf, 
+                        proto_buf_offset, proto_bufsz))
+                {
+                    EXFAIL_OUT(ret);
+                }
+
+                len_offset = *proto_buf_offset;
+
+                CHECK_PROTO_BUFSZ(ret, *proto_buf_offset, proto_bufsz, LEN_BYTES);
+                *proto_buf_offset=*proto_buf_offset+LEN_BYTES;
+
+                off_start = *proto_buf_offset;
+                
+                ret = exproto_build_ex2proto(&tmp_cv, 0, 
+                            offset+p->offset + NDRX_TRACE_OFFSET(*buf_len),
+                            ex_buf, ex_len, proto_buf, proto_buf_offset,
+                            NULL, NULL, proto_bufsz);
+
+                if (EXSUCCEED!=ret)
+                {
+                    NDRX_LOG(log_error, "Failed to convert "
+                            "sub/tag %x: [%s] %ld"
+                            "at offset %ld", 
+                            p->tag, p->cname, p->offset);
+                    ret=EXFAIL;
+                    goto out;
+                }
+                
+                len_written = (int)(*proto_buf_offset - off_start);
+
+                if (EXSUCCEED!=write_len(len_written, proto_buf, &len_offset,
+                        proto_bufsz))
+                {
+                    EXFAIL_OUT(ret);
+                }
+            }
+                break;
         }
         
         /* Verify data length (currently at warning level!) - it should be
@@ -1942,6 +2042,17 @@ exprivate int _exproto_proto2ex(cproto_t *cur, char *proto_buf, long proto_len,
                 {
                     NDRX_LOG(log_debug, "XLOOP, array elem: %d", 
                             loop_keeper);
+                    
+                    /* fixed size arrays are bounded */
+                    if (fld->len > 0 && 
+                            (loop_keeper+1)*fld->elem_size > fld->len)
+                    {
+                        NDRX_LOG(log_error, "Too many elements for tag 0x%x [%s]: "
+                                "max %ld", net_tag, fld->cname, 
+                                (long)(fld->len/fld->elem_size));
+                        ret=EXFAIL;
+                        goto out;
+                    }
                     ret = _exproto_proto2ex(fld->include, 
                                     (char *)(proto_buf+int_pos), net_len, 
                                     ex_buf, (ex_offset+fld->offset + fld->elem_size*loop_keeper),
@@ -2061,6 +2172,43 @@ exprivate int _exproto_proto2ex(cproto_t *cur, char *proto_buf, long proto_len,
                 }
                     break;
                 
+                case XTRACE:
+                {
+                    long *buf_len = (long *)(ex_buf+ex_offset+fld->counter_offset);
+                    long *sysflags = (long *)(ex_buf+ex_offset+fld->buftype_offset);
+                    long trace_off = fld->offset + NDRX_TRACE_OFFSET(*buf_len);
+                    ndrx_trace_t *trace = (ndrx_trace_t *)(ex_buf+ex_offset+trace_off);
+                    long prev_max = *max_struct;
+                    
+                    loop_keeper = 0;
+                    NDRX_LOG(log_debug, "XTRACE");
+                    
+                    /* room for all the hops, bridges add them in place */
+                    CHECK_EX_BUFSZ(ret, ex_offset, trace_off, ex_bufsz, 
+                            sizeof(ndrx_trace_t));
+                    
+                    trace->nhops = 0;
+                    
+                    ret = _exproto_proto2ex(fld->include, 
+                                    (char *)(proto_buf+int_pos), net_len, 
+                                    ex_buf, ex_offset+trace_off,
+                                    max_struct, level+1, NULL, NULL, ex_bufsz);
+
+                    if (EXSUCCEED!=ret)
+                    {
+                        goto out;
+                    }
+                    
+                    *sysflags |= SYS_FLAG_TRACE;
+                    
+                    /* message ends with the last hop, not with the array */
+                    *max_struct = prev_max;
+                    xatmi_fld_len = (int)(trace_off - fld->offset + 
+                            NDRX_TRACE_LEN(trace));
+                    p_fld_len = &xatmi_fld_len;
+                }
+                    break;
+                
                 default:
                     NDRX_LOG(log_error, "Unknown subfield type!");
                     ret=EXFAIL;
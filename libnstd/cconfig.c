@@ -78,10 +78,13 @@ exprivate char *M_sections_first_pass[] = {NDRX_CONF_SECTION_GLOBAL,
                         NULL};
 
 exprivate MUTEX_LOCKDECL(M_load_lock);
+
+/** generation of snapshot from which G_cconfig is built (or tried) */
+exprivate uint64_t M_snap_gen = 0;
 /*---------------------------Prototypes---------------------------------*/
 
 exprivate int _ndrx_cconfig_load_pass(ndrx_inicfg_t **cfg, int is_internal, 
-        char **section_start_with);
+        char **section_start_with, ndrx_ccsnap_t *snap);
 
 /**
  * Split up the CCTAG (by tokens)
@@ -197,6 +200,48 @@ expublic int ndrx_cconfig_get(char *section, ndrx_inicfg_section_keyval_t **out)
     return ndrx_cconfig_get_cf(G_cconfig, section,  out);
 }
 
+/**
+ * Collect config resources from environment, in the load order
+ * @param config_resources array of NDRX_INICFG_RESOURCES_MAX+2, NULL terminated
+ * @return number of resources
+ */
+exprivate int cconfig_resources(char **config_resources)
+{
+    int slot = 0;
+    
+    if (NULL!=(config_resources[slot] = getenv(NDRX_CCONFIG5)))
+    {
+        slot++;
+    }
+    
+    if (NULL!=(config_resources[slot] = getenv(NDRX_CCONFIG4)))
+    {
+        slot++;
+    }
+    
+    if (NULL!=(config_resources[slot] = getenv(NDRX_CCONFIG3)))
+    {
+        slot++;
+    }
+    
+    if (NULL!=(config_resources[slot] = getenv(NDRX_CCONFIG2)))
+    {
+        slot++;
+    }
+    if (NULL!=(config_resources[slot] = getenv(NDRX_CCONFIG1)))
+    {
+        slot++;
+    }
+    if (NULL!=(config_resources[slot] = getenv(NDRX_CCONFIG)))
+    {
+        slot++;
+    }
+    
+    config_resources[slot] = NULL;
+    
+    return slot;
+}
+
 /**
  * Two pass config load orchestrator
  * First pass will load global variables (environment)
@@ -204,6 +249,8 @@ expublic int ndrx_cconfig_get(char *section, ndrx_inicfg_section_keyval_t **out)
  * section.
  * Firstly we will load dummy value (${XXX} not substituted as empty), but second
  * pass will once again load the actual resolved values.
+ * If published config snapshot is valid, both passes are built from it,
+ * with out parsing the ini files.
  * @param cfg
  * @param is_internal
  * @return 
@@ -212,16 +259,28 @@ exprivate int _ndrx_cconfig_load(ndrx_inicfg_t **cfg, int is_internal)
 {
     int ret = EXSUCCEED;
     
+    ndrx_ccsnap_t *snap = NULL;
+    char *snap_path;
+    char *config_resources[NDRX_INICFG_RESOURCES_MAX+2];
+    
     if (is_internal)
     {
         ndrx_inicfg_t *cfg_first_pass = NULL;
+        
+        if (NULL!=(snap_path=getenv(NDRX_CCONFIG_SNAP)) && 
+                cconfig_resources(config_resources) > 0 &&
+                NULL!=(snap=ndrx_ccsnap_attach(snap_path, config_resources)))
+        {
+            M_snap_gen = snap->gen;
+        }
+        
         /* two pass loading */
         
         /* first pass will go with dummy config, then we make it free... 
          * and we are interested only in global section
          */
         if (EXSUCCEED!=_ndrx_cconfig_load_pass(&cfg_first_pass, EXTRUE, 
-                M_sections_first_pass))
+                M_sections_first_pass, snap))
         {
             userlog("Failed to load first pass config!");
             EXFAIL_OUT(ret);
@@ -233,26 +292,33 @@ exprivate int _ndrx_cconfig_load(ndrx_inicfg_t **cfg, int is_internal)
         if (NULL!=cfg_first_pass)
         {
             ndrx_inicfg_free(cfg_first_pass);
-            ret = _ndrx_cconfig_load_pass(cfg, EXTRUE, M_sections);
+            ret = _ndrx_cconfig_load_pass(cfg, EXTRUE, M_sections, snap);
         }
         
     }
     else
     {
         /* single pass */
-        ret = _ndrx_cconfig_load_pass(cfg, EXFALSE, NULL);
+        ret = _ndrx_cconfig_load_pass(cfg, EXFALSE, NULL, NULL);
     }
     
 out:
+
+    if (NULL!=snap)
+    {
+        ndrx_ccsnap_detach(snap);
+    }
+
     return ret;
 }
 
 /**
  * Load config (for Enduro/X only)
+ * @param snap validated config snapshot to use instead of ini files, or NULL
  * @return 
  */
 exprivate int _ndrx_cconfig_load_pass(ndrx_inicfg_t **cfg, int is_internal, 
-        char **section_start_with)
+        char **section_start_with, ndrx_ccsnap_t *snap)
 {
     int ret = EXSUCCEED;
     int slot = 0;
@@ -275,33 +341,7 @@ exprivate int _ndrx_cconfig_load_pass(ndrx_inicfg_t **cfg, int is_internal,
     ndrx_inicfg_section_keyval_t *keyvals = NULL, *keyvals_iter = NULL, 
                 *keyvals_iter_tmp = NULL;
     
-    if (NULL!=(config_resources[slot] = getenv(NDRX_CCONFIG5)))
-    {
-        slot++;
-    }
-    
-    if (NULL!=(config_resources[slot] = getenv(NDRX_CCONFIG4)))
-    {
-        slot++;
-    }
-    
-    if (NULL!=(config_resources[slot] = getenv(NDRX_CCONFIG3)))
-    {
-        slot++;
-    }
-    
-    if (NULL!=(config_resources[slot] = getenv(NDRX_CCONFIG2)))
-    {
-        slot++;
-    }
-    if (NULL!=(config_resources[slot] = getenv(NDRX_CCONFIG1)))
-    {
-        slot++;
-    }
-    if (NULL!=(config_resources[slot] = getenv(NDRX_CCONFIG)))
-    {
-        slot++;
-    }
+    cconfig_resources(config_resources);
         
     /* Check if envs are set before try to load */
     if (NULL==(*cfg = ndrx_inicfg_new2(EXTRUE)))
@@ -312,8 +352,22 @@ exprivate int _ndrx_cconfig_load_pass(ndrx_inicfg_t **cfg, int is_internal,
     
     /* Load the stuff */
     slot = 0;
-
-    while (NULL!=config_resources[slot])
+    
+    if (NULL!=snap && NULL!=config_resources[0])
+    {
+        /* published & validated by attach, just substitute env */
+        NDRX_LOG_EARLY(log_debug, "Loading config from snapshot gen %llu",
+                (unsigned long long)snap->gen);
+        
+        have_config = EXTRUE;
+        
+        if (EXSUCCEED!=ndrx_ccsnap_load(snap, *cfg, section_start_with))
+        {
+            userlog("%s: failed to load config snapshot", fn);
+            EXFAIL_OUT(ret);
+        }
+    }
+    else while (NULL!=config_resources[slot])
     {
 #ifdef CCONFIG_ENABLE_DEBUG
         userlog("have config at slot [%d] [%s]", slot, config_resources[slot]);
@@ -462,12 +516,55 @@ expublic int ndrx_cconfig_load_general(ndrx_inicfg_t **cfg)
 }
 
 /**
- * Reload Enduro/X CConfig
+ * Reload Enduro/X CConfig.
+ * If snapshot is used and newer generation is published, config is replaced
+ * from the snapshot. Otherwise files are checked for changes and changed
+ * ones are parsed.
  * @return 
  */
 expublic int ndrx_cconfig_reload(void)
 {
     char fn[]="ndrx_cconfig_reload";
+    char *snap_path;
+    char *config_resources[NDRX_INICFG_RESOURCES_MAX+2];
+    uint64_t gen;
+    ndrx_ccsnap_t *snap = NULL;
+    ndrx_inicfg_t *cfg = NULL;
+    ndrx_inicfg_t tmp;
+    
+    if (NULL!=G_cconfig && NULL!=(snap_path=getenv(NDRX_CCONFIG_SNAP)) &&
+            EXSUCCEED==ndrx_ccsnap_gen_get(snap_path, &gen) && gen!=M_snap_gen)
+    {
+        /* stale snapshot will not become valid, do not retry same gen */
+        M_snap_gen = gen;
+        
+        if (cconfig_resources(config_resources) > 0 &&
+                NULL!=(snap=ndrx_ccsnap_attach(snap_path, config_resources)))
+        {
+            if (NULL!=(cfg = ndrx_inicfg_new2(EXTRUE)) && 
+                    EXSUCCEED==ndrx_ccsnap_load(snap, cfg, M_sections))
+            {
+                /* swap the content, G_cconfig handle stays the same */
+                tmp = *G_cconfig;
+                *G_cconfig = *cfg;
+                *cfg = tmp;
+                
+                NDRX_LOG(log_info, "Config reloaded from snapshot gen %llu",
+                        (unsigned long long)gen);
+                
+                ndrx_inicfg_free(cfg);
+                ndrx_ccsnap_detach(snap);
+                return EXSUCCEED;
+            }
+            
+            if (NULL!=cfg)
+            {
+                ndrx_inicfg_free(cfg);
+            }
+            ndrx_ccsnap_detach(snap);
+        }
+    }
+    
     if (EXSUCCEED!=ndrx_inicfg_reload(G_cconfig, M_sections))
     {
         userlog("%s: %s lookup to reload: %s", fn, 
@@ -478,6 +575,37 @@ expublic int ndrx_cconfig_reload(void)
     return EXSUCCEED;
 }
 
+/**
+ * Publish config snapshot (if NDRX_CCONFIG_SNAP is set)
+ * @param force EXTRUE - write always, EXFALSE - only if current snapshot
+ *  is missing or stale
+ * @return EXSUCCEED/EXFAIL
+ */
+expublic int ndrx_cconfig_snap_publish(int force)
+{
+    int ret = EXSUCCEED;
+    char *snap_path;
+    char *config_resources[NDRX_INICFG_RESOURCES_MAX+2];
+    ndrx_ccsnap_t *snap;
+    
+    if (NULL==(snap_path=getenv(NDRX_CCONFIG_SNAP)) || 
+            0==cconfig_resources(config_resources))
+    {
+        goto out;
+    }
+    
+    if (!force && NULL!=(snap=ndrx_ccsnap_attach(snap_path, config_resources)))
+    {
+        ndrx_ccsnap_detach(snap);
+        goto out;
+    }
+    
+    ret = ndrx_ccsnap_write(snap_path, config_resources, M_sections);
+    
+out:
+    return ret;
+}
+
 /**
  * Access to to atmi lib env globals
  * @return 
@@ -0,0 +1,795 @@
+/**
+ * @brief Common-config snapshot. ndrxd parses the ini files once and publishes
+ *   the parsed content (sections/keys with raw, not substituted values) in
+ *   flat file, which processes map in and load into ndrx_inicfg_t with out
+ *   ini parsing and directory scanning. Environment is substituted by each
+ *   reader (so process env and ${dec=} values are handled as for text load,
+ *   no decrypted data is stored on disk). Snapshot carries the stat data of
+ *   resources and files, if anything differs, the snapshot is not used and
+ *   config is parsed from text. New snapshot is written to temp file and
+ *   renamed over, thus mapped copies stay valid.
+ *
+ * @file cconfsnap.c
+ */
+/* -----------------------------------------------------------------------------
+ * Enduro/X Middleware Platform for Distributed Transaction Processing
+ * Copyright (C) 2009-2016, ATR Baltic, Ltd. All Rights Reserved.
+ * Copyright (C) 2017-2019, Mavimax, Ltd. All Rights Reserved.
+ * This software is released under one of the following licenses:
+ * AGPL (with Java and Go exceptions) or Mavimax's license for commercial use.
+ * See LICENSE file for full text.
+ * -----------------------------------------------------------------------------
+ * AGPL license:
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License, version 3 as published
+ * by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License, version 3
+ * for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * -----------------------------------------------------------------------------
+ * A commercial use license is available from Mavimax, Ltd
+ * contact@mavimax.com
+ * -----------------------------------------------------------------------------
+ */
+#include <ndrx_config.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+
+#include <ndrstandard.h>
+#include <ndebug.h>
+#include <userlog.h>
+#include <inicfg.h>
+#include <cconfig.h>
+#include <nstd_int.h>
+/*---------------------------Externs------------------------------------*/
+/*---------------------------Macros-------------------------------------*/
+#define CCSNAP_MAGIC        "NDRXCCS1"  /**< file magic, incl format version */
+#define CCSNAP_MAGIC_LEN    8
+#define CCSNAP_WR_INIT      4096        /**< initial write buffer size       */
+/*---------------------------Enums--------------------------------------*/
+/*---------------------------Typedefs-----------------------------------*/
+
+/**
+ * Snapshot file header
+ */
+typedef struct
+{
+    char magic[CCSNAP_MAGIC_LEN];   /**< CCSNAP_MAGIC                         */
+    uint32_t hdrlen;                /**< sizeof this header                   */
+    uint32_t nres;                  /**< number of resources                  */
+    uint64_t gen;                   /**< publish generation                   */
+    uint64_t len;                   /**< full file len                        */
+} ccsnap_hdr_t;
+
+/**
+ * File attributes used for change detection
+ */
+typedef struct
+{
+    int64_t mtime;
+    int64_t size;
+    uint64_t ino;
+} ccsnap_stat_t;
+
+/**
+ * Read cursor over the mapping
+ */
+typedef struct
+{
+    char *p;
+    char *end;
+} ccsnap_rd_t;
+
+/**
+ * Write buffer
+ */
+typedef struct
+{
+    char *buf;
+    size_t len;
+    size_t size;
+} ccsnap_wr_t;
+
+/*---------------------------Globals------------------------------------*/
+/*---------------------------Statics------------------------------------*/
+/*---------------------------Prototypes---------------------------------*/
+
+/**
+ * Convert stat to snapshot attributes
+ * @param st stat data
+ * @param out attributes
+ */
+exprivate void ccsnap_stat_conv(struct stat *st, ccsnap_stat_t *out)
+{
+    out->mtime = (int64_t)st->st_mtime;
+    out->size = (int64_t)st->st_size;
+    out->ino = (uint64_t)st->st_ino;
+}
+
+/**
+ * Check that path still has the recorded attributes
+ * @param path file or folder
+ * @param rec recorded attributes
+ * @return EXTRUE - not changed, EXFALSE - changed or missing
+ */
+exprivate int ccsnap_stat_same(char *path, ccsnap_stat_t *rec)
+{
+    struct stat st;
+    ccsnap_stat_t cur;
+    
+    if (EXSUCCEED!=stat(path, &st))
+    {
+        return EXFALSE;
+    }
+    
+    ccsnap_stat_conv(&st, &cur);
+    
+    return (cur.mtime==rec->mtime && cur.size==rec->size && cur.ino==rec->ino);
+}
+
+/**
+ * Read 32bit unsigned
+ * @param rd cursor
+ * @param v value out
+ * @return EXSUCCEED/EXFAIL (truncated)
+ */
+exprivate int rd_u32(ccsnap_rd_t *rd, uint32_t *v)
+{
+    if (rd->end - rd->p < (long)sizeof(*v))
+    {
+        return EXFAIL;
+    }
+    
+    memcpy(v, rd->p, sizeof(*v));
+    rd->p+=sizeof(*v);
+    
+    return EXSUCCEED;
+}
+
+/**
+ * Read string, string is returned in place (mapping)
+ * @param rd cursor
+ * @param s string out
+ * @return EXSUCCEED/EXFAIL (truncated or not terminated)
+ */
+exprivate int rd_str(ccsnap_rd_t *rd, char **s)
+{
+    uint32_t len;
+    
+    if (EXSUCCEED!=rd_u32(rd, &len) || rd->end - rd->p < (long)len+1 
+            || EXEOS!=rd->p[len])
+    {
+        return EXFAIL;
+    }
+    
+    *s = rd->p;
+    rd->p+=len+1;
+    
+    return EXSUCCEED;
+}
+
+/**
+ * Read file attributes
+ * @param rd cursor
+ * @param st attributes out
+ * @return EXSUCCEED/EXFAIL
+ */
+exprivate int rd_stat(ccsnap_rd_t *rd, ccsnap_stat_t *st)
+{
+    if (rd->end - rd->p < (long)sizeof(*st))
+    {
+        return EXFAIL;
+    }
+    
+    memcpy(st, rd->p, sizeof(*st));
+    rd->p+=sizeof(*st);
+    
+    return EXSUCCEED;
+}
+
+/**
+ * Append data to write buffer
+ * @param wr write buffer
+ * @param data data to add
+ * @param len data len
+ * @return EXSUCCEED/EXFAIL (malloc)
+ */
+exprivate int wr_put(ccsnap_wr_t *wr, void *data, size_t len)
+{
+    int ret = EXSUCCEED;
+    size_t size = wr->size;
+    char *tmp;
+    
+    while (wr->len + len > size)
+    {
+        size = (0==size ? CCSNAP_WR_INIT : size*2);
+    }
+    
+    if (size!=wr->size)
+    {
+        if (NULL==(tmp = NDRX_REALLOC(wr->buf, size)))
+        {
+            userlog("%s: failed to realloc %ld bytes: %s", __func__, 
+                    (long)size, strerror(errno));
+            EXFAIL_OUT(ret);
+        }
+        wr->buf = tmp;
+        wr->size = size;
+    }
+    
+    memcpy(wr->buf + wr->len, data, len);
+    wr->len+=len;
+    
+out:
+    return ret;
+}
+
+/**
+ * Append 32bit unsigned
+ */
+exprivate int wr_u32(ccsnap_wr_t *wr, uint32_t v)
+{
+    return wr_put(wr, &v, sizeof(v));
+}
+
+/**
+ * Append string: len, data, EOS
+ */
+exprivate int wr_str(ccsnap_wr_t *wr, char *s)
+{
+    uint32_t len = strlen(s);
+    
+    if (EXSUCCEED!=wr_u32(wr, len))
+    {
+        return EXFAIL;
+    }
+    
+    return wr_put(wr, s, len+1);
+}
+
+/**
+ * Is section needed, same rules as for ini parser section filter
+ * @param section section name
+ * @param section_start_with list of prefixes, NULL - all
+ * @return EXTRUE/EXFALSE
+ */
+exprivate int ccsnap_section_needed(char *section, char **section_start_with)
+{
+    int len;
+    
+    if (NULL==section_start_with)
+    {
+        return EXTRUE;
+    }
+    
+    while (NULL!=*section_start_with)
+    {
+        len = NDRX_MIN(strlen(*section_start_with), strlen(section));
+        
+        if (0 == strncmp(*section_start_with, section, len))
+        {
+            return EXTRUE;
+        }
+        section_start_with++;
+    }
+    
+    return EXFALSE;
+}
+
+/**
+ * Walk over the files of the snapshot. Either checks that files are not
+ * changed (cfg is NULL) or loads the content into config.
+ * @param snap attached snapshot
+ * @param cfg config to fill or NULL for validation only
+ * @param section_start_with sections to load
+ * @return EXSUCCEED - ok, EXFAIL - corrupted, changed or load failed
+ */
+exprivate int ccsnap_walk(ndrx_ccsnap_t *snap, ndrx_inicfg_t *cfg, 
+        char **section_start_with)
+{
+    int ret = EXSUCCEED;
+    ccsnap_rd_t rd;
+    ccsnap_hdr_t *hdr = (ccsnap_hdr_t *)snap->mem;
+    ccsnap_stat_t st;
+    uint32_t nfiles, nsect, nvals, i, j, k;
+    char *resource, *fullname, *section, *key, *val;
+    struct stat attr;
+    ndrx_inicfg_file_t *cf = NULL;
+    int needed;
+    
+    rd.p = snap->mem + hdr->hdrlen;
+    rd.end = snap->mem + snap->len;
+    
+    /* resources */
+    for (i=0; i<hdr->nres; i++)
+    {
+        if (EXSUCCEED!=rd_str(&rd, &resource) || EXSUCCEED!=rd_stat(&rd, &st))
+        {
+            NDRX_LOG_EARLY(log_error, "Config snapshot corrupted (resources)");
+            EXFAIL_OUT(ret);
+        }
+        
+        if (NULL!=cfg && NULL==ndrx_string_hash_get(cfg->resource_hash, resource)
+                && EXSUCCEED!=ndrx_string_hash_add(&(cfg->resource_hash), resource))
+        {
+            userlog("%s: ndrx_string_hash_add - malloc failed", __func__);
+            EXFAIL_OUT(ret);
+        }
+    }
+    
+    if (EXSUCCEED!=rd_u32(&rd, &nfiles))
+    {
+        NDRX_LOG_EARLY(log_error, "Config snapshot corrupted (files)");
+        EXFAIL_OUT(ret);
+    }
+    
+    for (i=0; i<nfiles; i++)
+    {
+        if (EXSUCCEED!=rd_str(&rd, &resource) 
+                || EXSUCCEED!=rd_str(&rd, &fullname)
+                || EXSUCCEED!=rd_stat(&rd, &st)
+                || EXSUCCEED!=rd_u32(&rd, &nsect))
+        {
+            NDRX_LOG_EARLY(log_error, "Config snapshot corrupted (file %u)", i);
+            EXFAIL_OUT(ret);
+        }
+        
+        if (NULL==cfg)
+        {
+            if (!ccsnap_stat_same(fullname, &st))
+            {
+                NDRX_LOG_EARLY(log_info, "Config snapshot stale: [%s] changed", 
+                        fullname);
+                EXFAIL_OUT(ret);
+            }
+        }
+        else
+        {
+            /* only attributes used by reload checks */
+            memset(&attr, 0, sizeof(attr));
+            attr.st_mtime = (time_t)st.mtime;
+            attr.st_size = (off_t)st.size;
+            attr.st_ino = (ino_t)st.ino;
+            
+            if (NULL==(cf=ndrx_inicfg_file_new(cfg, resource, fullname, &attr)))
+            {
+                userlog("%s: %s", __func__, Nstrerror(Nerror));
+                EXFAIL_OUT(ret);
+            }
+        }
+        
+        for (j=0; j<nsect; j++)
+        {
+            if (EXSUCCEED!=rd_str(&rd, &section) || EXSUCCEED!=rd_u32(&rd, &nvals))
+            {
+                NDRX_LOG_EARLY(log_error, "Config snapshot corrupted (section)");
+                EXFAIL_OUT(ret);
+            }
+            
+            needed = (NULL!=cfg && ccsnap_section_needed(section, 
+                    section_start_with));
+            
+            for (k=0; k<nvals; k++)
+            {
+                if (EXSUCCEED!=rd_str(&rd, &key) || EXSUCCEED!=rd_str(&rd, &val))
+                {
+                    NDRX_LOG_EARLY(log_error, "Config snapshot corrupted (value)");
+                    EXFAIL_OUT(ret);
+                }
+                
+                if (needed && EXSUCCEED!=ndrx_inicfg_file_keyval_add(cf, 
+                        section, key, val))
+                {
+                    userlog("%s: %s", __func__, Nstrerror(Nerror));
+                    EXFAIL_OUT(ret);
+                }
+            }
+        }
+    }
+    
+out:
+    return ret;
+}
+
+/**
+ * Attach to snapshot and check that it matches the current resources and
+ * that none of the resources or files are changed since publish.
+ * @param path snapshot file
+ * @param resources NULL terminated list of config resources (NDRX_CCONFIG*)
+ * @return snapshot or NULL if not present or not usable (use text config)
+ */
+expublic ndrx_ccsnap_t *ndrx_ccsnap_attach(char *path, char **resources)
+{
+    int fd = EXFAIL;
+    struct stat st;
+    ndrx_ccsnap_t *snap = NULL;
+    ccsnap_hdr_t *hdr;
+    ccsnap_rd_t rd;
+    ccsnap_stat_t rst;
+    char *resource;
+    uint32_t i;
+    int ok = EXFALSE;
+    
+    if (EXFAIL==(fd=open(path, O_RDONLY)))
+    {
+        NDRX_LOG_EARLY(log_debug, "Config snapshot [%s] not available: %s", 
+                path, strerror(errno));
+        goto out;
+    }
+    
+    if (EXSUCCEED!=fstat(fd, &st) || st.st_size < (off_t)sizeof(ccsnap_hdr_t))
+    {
+        NDRX_LOG_EARLY(log_error, "Config snapshot [%s] invalid size", path);
+        goto out;
+    }
+    
+    if (NULL==(snap=NDRX_CALLOC(1, sizeof(ndrx_ccsnap_t))))
+    {
+        userlog("%s: failed to malloc: %s", __func__, strerror(errno));
+        goto out;
+    }
+    
+    snap->len = (size_t)st.st_size;
+    
+    if (MAP_FAILED==(snap->mem=mmap(NULL, snap->len, PROT_READ, MAP_PRIVATE, 
+            fd, 0)))
+    {
+        NDRX_LOG_EARLY(log_error, "Failed to map config snapshot [%s]: %s", 
+                path, strerror(errno));
+        snap->mem = NULL;
+        goto out;
+    }
+    
+    hdr = (ccsnap_hdr_t *)snap->mem;
+    
+    if (0!=memcmp(hdr->magic, CCSNAP_MAGIC, CCSNAP_MAGIC_LEN)
+            || sizeof(ccsnap_hdr_t)!=hdr->hdrlen
+            || snap->len!=hdr->len)
+    {
+        NDRX_LOG_EARLY(log_error, "Config snapshot [%s] invalid header", path);
+        goto out;
+    }
+    
+    snap->gen = hdr->gen;
+    
+    /* resource list must be the same, and resources not changed */
+    rd.p = snap->mem + hdr->hdrlen;
+    rd.end = snap->mem + snap->len;
+    
+    for (i=0; i<hdr->nres; i++)
+    {
+        if (NULL==resources[i] || EXSUCCEED!=rd_str(&rd, &resource)
+                || EXSUCCEED!=rd_stat(&rd, &rst) || 0!=strcmp(resource, resources[i]))
+        {
+            NDRX_LOG_EARLY(log_info, "Config snapshot [%s] resources differ", 
+                    path);
+            goto out;
+        }
+        
+        if (!ccsnap_stat_same(resource, &rst))
+        {
+            NDRX_LOG_EARLY(log_info, "Config snapshot stale: [%s] changed", 
+                    resource);
+            goto out;
+        }
+    }
+    
+    if (NULL!=resources[i])
+    {
+        NDRX_LOG_EARLY(log_info, "Config snapshot [%s] resources differ", path);
+        goto out;
+    }
+    
+    if (EXSUCCEED!=ccsnap_walk(snap, NULL, NULL))
+    {
+        goto out;
+    }
+    
+    ok = EXTRUE;
+    NDRX_LOG_EARLY(log_debug, "Attached to config snapshot [%s] gen %llu", 
+            path, (unsigned long long)snap->gen);
+    
+out:
+
+    if (EXFAIL!=fd)
+    {
+        close(fd);
+    }
+
+    if (!ok && NULL!=snap)
+    {
+        ndrx_ccsnap_detach(snap);
+        snap = NULL;
+    }
+
+    return snap;
+}
+
+/**
+ * Unmap the snapshot
+ * @param snap snapshot to free
+ */
+expublic void ndrx_ccsnap_detach(ndrx_ccsnap_t *snap)
+{
+    if (NULL!=snap->mem)
+    {
+        munmap(snap->mem, snap->len);
+    }
+    
+    NDRX_FREE(snap);
+}
+
+/**
+ * Load the snapshot content into config (the same what ndrx_inicfg_add()
+ * would do for the resources). Env is substituted at this point.
+ * @param snap attached snapshot
+ * @param cfg config to fill
+ * @param section_start_with sections to load, NULL - all
+ * @return EXSUCCEED/EXFAIL
+ */
+expublic int ndrx_ccsnap_load(ndrx_ccsnap_t *snap, ndrx_inicfg_t *cfg, 
+        char **section_start_with)
+{
+    return ccsnap_walk(snap, cfg, section_start_with);
+}
+
+/**
+ * Read the generation of published snapshot, no mapping done.
+ * @param path snapshot file
+ * @param gen generation out
+ * @return EXSUCCEED/EXFAIL (no snapshot)
+ */
+expublic int ndrx_ccsnap_gen_get(char *path, uint64_t *gen)
+{
+    int ret = EXSUCCEED;
+    int fd = EXFAIL;
+    ccsnap_hdr_t hdr;
+    
+    if (EXFAIL==(fd=open(path, O_RDONLY)))
+    {
+        EXFAIL_OUT(ret);
+    }
+    
+    if (sizeof(hdr)!=read(fd, &hdr, sizeof(hdr))
+            || 0!=memcmp(hdr.magic, CCSNAP_MAGIC, CCSNAP_MAGIC_LEN))
+    {
+        EXFAIL_OUT(ret);
+    }
+    
+    *gen = hdr.gen;
+    
+out:
+    
+    if (EXFAIL!=fd)
+    {
+        close(fd);
+    }
+
+    return ret;
+}
+
+/**
+ * Parse the resources (values kept raw) and publish the snapshot.
+ * File is written to temp file and renamed over the old one.
+ * @param path snapshot file
+ * @param resources NULL terminated list of resources
+ * @param sections sections to include
+ * @return EXSUCCEED/EXFAIL
+ */
+expublic int ndrx_ccsnap_write(char *path, char **resources, char **sections)
+{
+    int ret = EXSUCCEED;
+    ndrx_inicfg_t *cfg = NULL;
+    ccsnap_wr_t wr;
+    ccsnap_hdr_t hdr;
+    ccsnap_stat_t st;
+    struct stat attr;
+    ndrx_inicfg_file_t *f, *ftmp;
+    ndrx_inicfg_section_t *s, *stmp;
+    ndrx_inicfg_section_keyval_t *v, *vtmp;
+    uint32_t cnt;
+    size_t cnt_pos, pos;
+    char tmpname[PATH_MAX+1];
+    struct timeval tv;
+    uint64_t prev_gen = 0;
+    int fd = EXFAIL;
+    int i;
+    
+    memset(&wr, 0, sizeof(wr));
+    memset(&hdr, 0, sizeof(hdr));
+    tmpname[0] = EXEOS;
+    
+    if (NULL==(cfg = ndrx_inicfg_new2(EXTRUE)))
+    {
+        userlog("%s: %s", __func__, Nstrerror(Nerror));
+        EXFAIL_OUT(ret);
+    }
+    
+    cfg->no_env_subs = EXTRUE;
+    
+    if (EXSUCCEED!=wr_put(&wr, &hdr, sizeof(hdr)))
+    {
+        EXFAIL_OUT(ret);
+    }
+    
+    /* resources are stat'ed before scan, thus any later change is seen
+     * as stale snapshot
+     */
+    for (i=0; NULL!=resources[i]; i++)
+    {
+        if (EXSUCCEED!=stat(resources[i], &attr))
+        {
+            NDRX_LOG(log_error, "Failed to stat config resource [%s]: %s", 
+                    resources[i], strerror(errno));
+            EXFAIL_OUT(ret);
+        }
+        
+        ccsnap_stat_conv(&attr, &st);
+        
+        if (EXSUCCEED!=wr_str(&wr, resources[i]) 
+                || EXSUCCEED!=wr_put(&wr, &st, sizeof(st)))
+        {
+            EXFAIL_OUT(ret);
+        }
+        
+        if (EXSUCCEED!=ndrx_inicfg_add(cfg, resources[i], sections))
+        {
+            NDRX_LOG(log_error, "Failed to parse [%s]: %s", 
+                    resources[i], Nstrerror(Nerror));
+            EXFAIL_OUT(ret);
+        }
+    }
+    
+    hdr.nres = i;
+    
+    /* files, count patched afterwards */
+    cnt_pos = wr.len;
+    cnt = 0;
+    
+    if (EXSUCCEED!=wr_u32(&wr, cnt))
+    {
+        EXFAIL_OUT(ret);
+    }
+    
+    EXHASH_ITER(hh, cfg->cfgfile, f, ftmp)
+    {
+        ccsnap_stat_conv(&f->attr, &st);
+        
+        if (EXSUCCEED!=wr_str(&wr, f->resource) 
+                || EXSUCCEED!=wr_str(&wr, f->fullname)
+                || EXSUCCEED!=wr_put(&wr, &st, sizeof(st))
+                || EXSUCCEED!=wr_u32(&wr, EXHASH_COUNT(f->sections)))
+        {
+            EXFAIL_OUT(ret);
+        }
+        
+        EXHASH_ITER(hh, f->sections, s, stmp)
+        {
+            if (EXSUCCEED!=wr_str(&wr, s->section)
+                    || EXSUCCEED!=wr_u32(&wr, EXHASH_COUNT(s->values)))
+            {
+                EXFAIL_OUT(ret);
+            }
+            
+            EXHASH_ITER(hh, s->values, v, vtmp)
+            {
+                if (EXSUCCEED!=wr_str(&wr, v->key) 
+                        || EXSUCCEED!=wr_str(&wr, v->val))
+                {
+                    EXFAIL_OUT(ret);
+                }
+            }
+        }
+        cnt++;
+    }
+    
+    memcpy(wr.buf + cnt_pos, &cnt, sizeof(cnt));
+    
+    /* generation must differ from the previous one */
+    gettimeofday(&tv, NULL);
+    hdr.gen = (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+    
+    if (EXSUCCEED==ndrx_ccsnap_gen_get(path, &prev_gen) && hdr.gen<=prev_gen)
+    {
+        hdr.gen = prev_gen+1;
+    }
+    
+    memcpy(hdr.magic, CCSNAP_MAGIC, CCSNAP_MAGIC_LEN);
+    hdr.hdrlen = sizeof(hdr);
+    hdr.len = wr.len;
+    memcpy(wr.buf, &hdr, sizeof(hdr));
+    
+    snprintf(tmpname, sizeof(tmpname), "%s.%d", path, (int)getpid());
+    
+    if (EXFAIL==(fd=open(tmpname, O_WRONLY|O_CREAT|O_TRUNC, 0600)))
+    {
+        NDRX_LOG(log_error, "Failed to open [%s]: %s", tmpname, strerror(errno));
+        userlog("Failed to open [%s]: %s", tmpname, strerror(errno));
+        tmpname[0] = EXEOS;
+        EXFAIL_OUT(ret);
+    }
+    
+    for (pos=0; pos<wr.len;)
+    {
+        ssize_t w = write(fd, wr.buf+pos, wr.len-pos);
+        
+        if (w<0)
+        {
+            if (EINTR==errno)
+            {
+                continue;
+            }
+            NDRX_LOG(log_error, "Failed to write [%s]: %s", tmpname, 
+                    strerror(errno));
+            userlog("Failed to write [%s]: %s", tmpname, strerror(errno));
+            EXFAIL_OUT(ret);
+        }
+        pos+=w;
+    }
+    
+    if (EXSUCCEED!=close(fd))
+    {
+        fd = EXFAIL;
+        NDRX_LOG(log_error, "Failed to close [%s]: %s", tmpname, strerror(errno));
+        EXFAIL_OUT(ret);
+    }
+    fd = EXFAIL;
+    
+    if (EXSUCCEED!=rename(tmpname, path))
+    {
+        NDRX_LOG(log_error, "Failed to rename [%s] to [%s]: %s", 
+                tmpname, path, strerror(errno));
+        userlog("Failed to rename [%s] to [%s]: %s", 
+                tmpname, path, strerror(errno));
+        EXFAIL_OUT(ret);
+    }
+    
+    tmpname[0] = EXEOS;
+    
+    NDRX_LOG(log_info, "Config snapshot [%s] published: gen %llu, "
+            "%u files, %ld bytes", path, (unsigned long long)hdr.gen, cnt, 
+            (long)wr.len);
+    
+out:
+    
+    if (EXFAIL!=fd)
+    {
+        close(fd);
+    }
+
+    if (EXEOS!=tmpname[0])
+    {
+        unlink(tmpname);
+    }
+
+    if (NULL!=wr.buf)
+    {
+        NDRX_FREE(wr.buf);
+    }
+
+    if (NULL!=cfg)
+    {
+        ndrx_inicfg_free(cfg);
+    }
+
+    return ret;
+}
+
+/* vim: set ts=4 sw=4 et smartindent: */
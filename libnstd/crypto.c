@@ -49,6 +49,7 @@
 #include <stdarg.h>
 #include <arpa/inet.h>
 #include <errno.h>
+#include <pthread.h>
 
 #include <ndrstandard.h>
 #include <ndebug.h>
@@ -59,6 +60,7 @@
 #include <userlog.h>
 #include <expluginbase.h>
 #include <exaes.h>
+#include <exaesgcm.h>
 #include <exbase64.h>
 
 #include "atmi_int.h"
@@ -77,12 +79,41 @@
 
 #define CRYPTO_LEN_PFX_BYTES    4
 
+/**
+ * High bit of length prefix marks AES-GCM format:
+ * [len|flag:4][nonce:12][cipher text:len][tag:16]
+ * Older format (CBC) never has the bit set, as data len is less than 2GB.
+ */
+#define CRYPTO_GCM_FLAG         0x80000000
+#define CRYPTO_GCM_OVERHEAD     (NDRX_AESGCM_IVLEN+NDRX_AESGCM_TAGLEN)
+#define CRYPTO_GCM_NONCE_PFX    8   /**< random part of the nonce         */
+
 #define API_ENTRY {_Nunset_error();}
 
 /*---------------------------Enums--------------------------------------*/
 /*---------------------------Typedefs-----------------------------------*/
+
+/**
+ * Per thread AES-GCM state. Key schedule & GHASH tables are rebuilt only
+ * when the key changes. Nonce is random prefix + counter, thus unique
+ * per thread without any locking. Forked child gets copy of the forking
+ * thread's state, thus prefix is reloaded in the child (see gcm_atfork_child()).
+ */
+typedef struct
+{
+    int is_init;                        /**< ctx is built for sha1key     */
+    char sha1key[NDRX_ENCKEY_BUFSZ];    /**< key for which ctx is built   */
+    ndrx_aesgcm_ctx_t ctx;              /**< cipher context               */
+    int nonce_ok;                       /**< nonce prefix is loaded       */
+    uint8_t nonce_pfx[CRYPTO_GCM_NONCE_PFX]; /**< random nonce part       */
+    uint32_t nonce_cnt;                 /**< nonce counter part           */
+} crypto_gcm_t;
+
 /*---------------------------Globals------------------------------------*/
 /*---------------------------Statics------------------------------------*/
+exprivate __thread crypto_gcm_t M_gcm;
+exprivate MUTEX_LOCKDECL(M_gcm_atfork_lock);
+exprivate volatile int M_gcm_atfork_first = EXTRUE; /**< handler not set  */
 /*---------------------------Prototypes---------------------------------*/
 
 
@@ -164,6 +195,120 @@ out:
     return ret;
 }
 
+/**
+ * Is GCM format requested for encryption (NDRX_CRYPTOMODE=GCM)
+ * @return EXTRUE/EXFALSE
+ */
+exprivate int ndrx_crypto_is_gcm(void)
+{
+    char *p = getenv(CONF_NDRX_CRYPTOMODE);
+    
+    return (NULL!=p && 0==strcasecmp(p, "GCM"));
+}
+
+/**
+ * Get GCM context for the key. GCM key is derived from the SHA1 key,
+ * so that the same key is not used by two cipher modes.
+ * @param sha1key final key
+ * @return context
+ */
+exprivate ndrx_aesgcm_ctx_t *ndrx_crypto_gcm_ctx(char *sha1key)
+{
+    char buf[NDRX_ENCKEY_BUFSZ+3];
+    char gcmkey[NDRX_ENCKEY_BUFSZ];
+    
+    if (!M_gcm.is_init || 0!=memcmp(M_gcm.sha1key, sha1key, NDRX_ENCKEY_BUFSZ))
+    {
+        memcpy(buf, sha1key, NDRX_ENCKEY_BUFSZ);
+        memcpy(buf+NDRX_ENCKEY_BUFSZ, "GCM", 3);
+        EXSHA1(gcmkey, buf, sizeof(buf));
+        
+        ndrx_aesgcm_init(&M_gcm.ctx, (uint8_t *)gcmkey, 0);
+        memcpy(M_gcm.sha1key, sha1key, NDRX_ENCKEY_BUFSZ);
+        M_gcm.is_init = EXTRUE;
+        
+        NDRX_LOG_EARLY(log_debug, "AES-GCM context built, hardware: %s",
+                M_gcm.ctx.is_hw?"yes":"no");
+    }
+    
+    return &M_gcm.ctx;
+}
+
+/**
+ * Child after fork continues with copy of parent thread's nonce state,
+ * which would repeat parent's nonces. Only forking thread exists in the
+ * child, thus reset of its state is enough.
+ */
+exprivate void gcm_atfork_child(void)
+{
+    M_gcm.nonce_ok = EXFALSE;
+}
+
+/**
+ * Generate next nonce for GCM encryption. Random prefix is loaded from
+ * /dev/urandom at first use, when counter is exhausted and in forked child.
+ * @param iv output nonce, NDRX_AESGCM_IVLEN bytes
+ * @return EXSUCCEED/EXFAIL (no random source, GCM cannot be used)
+ */
+exprivate int ndrx_crypto_gcm_nonce(uint8_t *iv)
+{
+    int ret = EXSUCCEED;
+    FILE *f = NULL;
+    
+    if (!M_gcm.nonce_ok || UINT32_MAX==M_gcm.nonce_cnt)
+    {
+        if (NDRX_UNLIKELY(M_gcm_atfork_first))
+        {
+            MUTEX_LOCK_V(M_gcm_atfork_lock);
+            
+            if (M_gcm_atfork_first)
+            {
+                if (0!=(ret=pthread_atfork(NULL, NULL, gcm_atfork_child)))
+                {
+                    MUTEX_UNLOCK_V(M_gcm_atfork_lock);
+                    NDRX_LOG_EARLY(log_error, "Failed to register fork "
+                            "handler: %s", strerror(ret));
+                    EXFAIL_OUT(ret);
+                }
+                M_gcm_atfork_first = EXFALSE;
+            }
+            
+            MUTEX_UNLOCK_V(M_gcm_atfork_lock);
+        }
+        
+        if (NULL==(f=NDRX_FOPEN("/dev/urandom", "rb")))
+        {
+            NDRX_LOG_EARLY(log_error, "Failed to open /dev/urandom: %s", 
+                    strerror(errno));
+            EXFAIL_OUT(ret);
+        }
+        
+        if (1!=fread(M_gcm.nonce_pfx, sizeof(M_gcm.nonce_pfx), 1, f))
+        {
+            NDRX_LOG_EARLY(log_error, "Failed to read /dev/urandom");
+            EXFAIL_OUT(ret);
+        }
+        
+        M_gcm.nonce_cnt = 0;
+        M_gcm.nonce_ok = EXTRUE;
+    }
+    
+    memcpy(iv, M_gcm.nonce_pfx, CRYPTO_GCM_NONCE_PFX);
+    M_gcm.nonce_cnt++;
+    iv[8] = (uint8_t)(M_gcm.nonce_cnt >> 24);
+    iv[9] = (uint8_t)(M_gcm.nonce_cnt >> 16);
+    iv[10] = (uint8_t)(M_gcm.nonce_cnt >> 8);
+    iv[11] = (uint8_t)M_gcm.nonce_cnt;
+    
+out:
+    if (NULL!=f)
+    {
+        NDRX_FCLOSE(f);
+    }
+
+    return ret;
+}
+
 /**
  * Decrypt data block (internal version, no API entry)
  * @param input input data block
@@ -179,6 +324,8 @@ exprivate int ndrx_crypto_enc_int(char *input, long ilen, char *output, long *ol
     long size_estim;
     uint32_t *len_ind = (uint32_t *)output;
     uint8_t  iv[]  = IV_INIT;
+    uint8_t nonce[NDRX_AESGCM_IVLEN];
+    int is_gcm = EXFALSE;
     
     /* encrypt data block */
     
@@ -187,11 +334,31 @@ exprivate int ndrx_crypto_enc_int(char *input, long ilen, char *output, long *ol
         EXFAIL_OUT(ret);
     }
     
-    /* estimate the encrypted data len round to */
-    size_estim = 
-            ((ilen + NDRX_ENC_BLOCK_SIZE - 1) / NDRX_ENC_BLOCK_SIZE) 
-            * NDRX_ENC_BLOCK_SIZE  
-            + CRYPTO_LEN_PFX_BYTES;
+    /* GCM is used only if requested, as older peers cannot read it */
+    if (ndrx_crypto_is_gcm())
+    {
+        if (EXSUCCEED==ndrx_crypto_gcm_nonce(nonce))
+        {
+            is_gcm = EXTRUE;
+        }
+        else
+        {
+            userlog("No random source for AES-GCM nonce - using CBC");
+        }
+    }
+    
+    if (is_gcm)
+    {
+        size_estim = CRYPTO_LEN_PFX_BYTES + ilen + CRYPTO_GCM_OVERHEAD;
+    }
+    else
+    {
+        /* estimate the encrypted data len round to */
+        size_estim = 
+                ((ilen + NDRX_ENC_BLOCK_SIZE - 1) / NDRX_ENC_BLOCK_SIZE) 
+                * NDRX_ENC_BLOCK_SIZE  
+                + CRYPTO_LEN_PFX_BYTES;
+    }
     
 #ifdef CRYPTODEBUG
     NDRX_LOG_EARLY(log_debug, "%s: Data size: %ld, estimated: %ld, output buffer: %ld",
@@ -215,11 +382,25 @@ exprivate int ndrx_crypto_enc_int(char *input, long ilen, char *output, long *ol
     }
     *olen = size_estim;
     
-    /* so data len will not be encrypted */
-    *len_ind = htonl((uint32_t)ilen);
-    
-    EXAES_CBC_encrypt_buffer((uint8_t*)(output+CRYPTO_LEN_PFX_BYTES), 
-            (uint8_t*)input, ilen, (const uint8_t*)sha1key, (const uint8_t*) iv);
+    if (is_gcm)
+    {
+        /* length prefix is authenticated as AAD */
+        *len_ind = htonl((uint32_t)ilen | CRYPTO_GCM_FLAG);
+        memcpy(output+CRYPTO_LEN_PFX_BYTES, nonce, NDRX_AESGCM_IVLEN);
+        
+        ndrx_aesgcm_encrypt(ndrx_crypto_gcm_ctx(sha1key), nonce, 
+                (uint8_t *)output, CRYPTO_LEN_PFX_BYTES, (uint8_t *)input, ilen,
+                (uint8_t *)output+CRYPTO_LEN_PFX_BYTES+NDRX_AESGCM_IVLEN,
+                (uint8_t *)output+CRYPTO_LEN_PFX_BYTES+NDRX_AESGCM_IVLEN+ilen);
+    }
+    else
+    {
+        /* so data len will not be encrypted */
+        *len_ind = htonl((uint32_t)ilen);
+
+        EXAES_CBC_encrypt_buffer((uint8_t*)(output+CRYPTO_LEN_PFX_BYTES), 
+                (uint8_t*)input, ilen, (const uint8_t*)sha1key, (const uint8_t*) iv);
+    }
     
 #ifdef CRYPTODEBUG_DUMP
     
@@ -260,7 +441,9 @@ expublic int ndrx_crypto_dec_int(char *input, long ilen, char *output, long *ole
     char sha1key[NDRX_ENCKEY_BUFSZ];
     uint32_t *len_ind = (uint32_t *)input;
     uint8_t  iv[]  = IV_INIT;
-    long data_size = ntohl(*len_ind);
+    uint32_t len_pfx = ntohl(*len_ind);
+    long data_size = len_pfx & ~CRYPTO_GCM_FLAG;
+    int is_gcm = !!(len_pfx & CRYPTO_GCM_FLAG);
     
     /* encrypt data block */
     
@@ -292,9 +475,33 @@ expublic int ndrx_crypto_dec_int(char *input, long ilen, char *output, long *ole
     }
     *olen = data_size;
     
-    EXAES_CBC_decrypt_buffer((uint8_t*)(output), 
-            (uint8_t*)(input+CRYPTO_LEN_PFX_BYTES), ilen-CRYPTO_LEN_PFX_BYTES, 
-            (const uint8_t*)sha1key, (const uint8_t*) iv);
+    if (is_gcm)
+    {
+        if (ilen!=CRYPTO_LEN_PFX_BYTES + data_size + CRYPTO_GCM_OVERHEAD)
+        {
+            _Nset_error_fmt(NEFORMAT, "Invalid AES-GCM block size: %ld, "
+                    "data: %ld", ilen, data_size);
+            EXFAIL_OUT(ret);
+        }
+        
+        if (EXSUCCEED!=ndrx_aesgcm_decrypt(ndrx_crypto_gcm_ctx(sha1key), 
+                (uint8_t *)input+CRYPTO_LEN_PFX_BYTES, 
+                (uint8_t *)input, CRYPTO_LEN_PFX_BYTES,
+                (uint8_t *)input+CRYPTO_LEN_PFX_BYTES+NDRX_AESGCM_IVLEN, 
+                data_size, (uint8_t *)output,
+                (uint8_t *)input+CRYPTO_LEN_PFX_BYTES+NDRX_AESGCM_IVLEN+data_size))
+        {
+            _Nset_error_fmt(NEINVALKEY, "AES-GCM authentication failed - "
+                    "invalid key or data modified");
+            EXFAIL_OUT(ret);
+        }
+    }
+    else
+    {
+        EXAES_CBC_decrypt_buffer((uint8_t*)(output), 
+                (uint8_t*)(input+CRYPTO_LEN_PFX_BYTES), ilen-CRYPTO_LEN_PFX_BYTES, 
+                (const uint8_t*)sha1key, (const uint8_t*) iv);
+    }
     
     /* DUMP the data block */
     
@@ -444,7 +651,7 @@ expublic int ndrx_crypto_dec_string(char *input, char *output, long *olen)
 #endif
     
     /* Check the output buffer len */
-    data_size = ntohl(*len_ind);
+    data_size = ntohl(*len_ind) & ~CRYPTO_GCM_FLAG;
     
     if (data_size +1 > *olen)
     {
@@ -467,6 +674,7 @@ expublic int ndrx_crypto_dec_string(char *input, char *output, long *olen)
         NDRX_LOG_EARLY(log_error, "%s: Failed to decrypt [%s]!", __func__, input);
 #endif
         userlog("%s: Failed to decrypt [%s]!", __func__, input);
+        EXFAIL_OUT(ret);
     }
     
     output[*olen] = EXEOS;
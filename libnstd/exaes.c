@@ -502,6 +502,27 @@ void EXAES_ECB_decrypt(const uint8_t* input, const uint8_t* key, uint8_t *output
 
 #endif // #if defined(ECB) && (ECB == 1)
 
+// Expand the key into caller's storage (EXAES_KEYEXPSIZE bytes), so that
+// it can be reused for many blocks (e.g. by counter modes)
+void EXAES_key_expand(const uint8_t* key, uint8_t* roundkey)
+{
+  Key = key;
+  KeyExpansion();
+  memcpy(roundkey, RoundKey, keyExpSize);
+}
+
+// Load the expanded key for EXAES_encrypt_block() calls in current thread
+void EXAES_key_load(const uint8_t* roundkey)
+{
+  memcpy(RoundKey, roundkey, keyExpSize);
+}
+
+// Encrypt single block in place with the key loaded by EXAES_key_load()
+void EXAES_encrypt_block(uint8_t* block)
+{
+  state = (state_t*)block;
+  Cipher();
+}
 
 
 
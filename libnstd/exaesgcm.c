@@ -0,0 +1,628 @@
+/**
+ * @brief AES-128-GCM (NIST SP 800-38D) authenticated encryption.
+ *   Portable implementation uses the EXAES block cipher and 4-bit table
+ *   GHASH. On x86_64 AES-NI & PCLMULQDQ instructions are used when the CPU
+ *   supports them (detected at run-time with CPUID).
+ *
+ * @file exaesgcm.c
+ */
+/* -----------------------------------------------------------------------------
+ * Enduro/X Middleware Platform for Distributed Transaction Processing
+ * Copyright (C) 2009-2016, ATR Baltic, Ltd. All Rights Reserved.
+ * Copyright (C) 2017-2019, Mavimax, Ltd. All Rights Reserved.
+ * This software is released under one of the following licenses:
+ * AGPL (with Java and Go exceptions) or Mavimax's license for commercial use.
+ * See LICENSE file for full text.
+ * -----------------------------------------------------------------------------
+ * AGPL license:
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License, version 3 as published
+ * by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License, version 3
+ * for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * -----------------------------------------------------------------------------
+ * A commercial use license is available from Mavimax, Ltd
+ * contact@mavimax.com
+ * -----------------------------------------------------------------------------
+ */
+#include <ndrx_config.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <memory.h>
+#include <time.h>
+#include <stdint.h>
+
+#include <ndrstandard.h>
+#include <exaes.h>
+#include <exaesgcm.h>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define EXAESGCM_X86    1
+#include <cpuid.h>
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#include <wmmintrin.h>
+#endif
+/*---------------------------Externs------------------------------------*/
+/*---------------------------Macros-------------------------------------*/
+#define AESGCM_BLOCK    16  /**< AES block size */
+
+#define GET_BE32(b, i)  ( ((uint32_t)(b)[(i)] << 24) \
+                        | ((uint32_t)(b)[(i)+1] << 16) \
+                        | ((uint32_t)(b)[(i)+2] << 8) \
+                        | ((uint32_t)(b)[(i)+3]) )
+
+#define PUT_BE32(n, b, i) do { \
+        (b)[(i)] = (uint8_t)((n) >> 24); \
+        (b)[(i)+1] = (uint8_t)((n) >> 16); \
+        (b)[(i)+2] = (uint8_t)((n) >> 8); \
+        (b)[(i)+3] = (uint8_t)(n); \
+    } while (0)
+
+#define AESGCM_HW_AES       0x02000000  /**< CPUID.1:ECX.AES       */
+#define AESGCM_HW_PCLMUL    0x00000002  /**< CPUID.1:ECX.PCLMULQDQ */
+#define AESGCM_HW_SSSE3     0x00000200  /**< CPUID.1:ECX.SSSE3     */
+/*---------------------------Enums--------------------------------------*/
+/*---------------------------Typedefs-----------------------------------*/
+/*---------------------------Globals------------------------------------*/
+/*---------------------------Statics------------------------------------*/
+
+/**
+ * Reduction table for 4-bit GHASH multiplication
+ */
+exprivate const uint64_t M_last4[16] =
+{
+    0x0000, 0x1c20, 0x3840, 0x2460, 0x7080, 0x6ca0, 0x48c0, 0x54e0,
+    0xe100, 0xfd20, 0xd940, 0xc560, 0x9180, 0x8da0, 0xa9c0, 0xb5e0
+};
+/*---------------------------Prototypes---------------------------------*/
+
+/**
+ * Check is AES-NI & PCLMULQDQ available on this CPU
+ * @return EXTRUE - hardware path can be used, EXFALSE - portable only
+ */
+expublic int ndrx_aesgcm_hw_supported(void)
+{
+#ifdef EXAESGCM_X86
+    unsigned int eax, ebx, ecx, edx;
+    unsigned int need = AESGCM_HW_AES | AESGCM_HW_PCLMUL | AESGCM_HW_SSSE3;
+    
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+    {
+        return EXFALSE;
+    }
+    
+    return ((ecx & need) == need);
+#else
+    return EXFALSE;
+#endif
+}
+
+/**
+ * Build 4-bit multiplication tables for the hash key H
+ * @param ctx context with ctx->h set
+ */
+exprivate void aesgcm_gen_table(ndrx_aesgcm_ctx_t *ctx)
+{
+    int i, j;
+    uint64_t vh, vl;
+    uint32_t t;
+    
+    vh = ((uint64_t)GET_BE32(ctx->h, 0) << 32) | GET_BE32(ctx->h, 4);
+    vl = ((uint64_t)GET_BE32(ctx->h, 8) << 32) | GET_BE32(ctx->h, 12);
+    
+    ctx->hl[8] = vl;
+    ctx->hh[8] = vh;
+    ctx->hl[0] = 0;
+    ctx->hh[0] = 0;
+    
+    for (i = 4; i > 0; i >>= 1)
+    {
+        t = (uint32_t)(vl & 1) * 0xe1000000U;
+        vl = (vh << 63) | (vl >> 1);
+        vh = (vh >> 1) ^ ((uint64_t)t << 32);
+        
+        ctx->hl[i] = vl;
+        ctx->hh[i] = vh;
+    }
+    
+    for (i = 2; i <= 8; i *= 2)
+    {
+        vh = ctx->hh[i];
+        vl = ctx->hl[i];
+        
+        for (j = 1; j < i; j++)
+        {
+            ctx->hh[i+j] = vh ^ ctx->hh[j];
+            ctx->hl[i+j] = vl ^ ctx->hl[j];
+        }
+    }
+}
+
+/**
+ * GHASH multiplication x = x * H in GF(2^128), portable version
+ * @param ctx context with tables
+ * @param x block to multiply (in/out)
+ */
+exprivate void aesgcm_mult(ndrx_aesgcm_ctx_t *ctx, uint8_t *x)
+{
+    int i;
+    uint8_t lo, hi, rem;
+    uint64_t zh, zl;
+    
+    lo = x[15] & 0x0f;
+    zh = ctx->hh[lo];
+    zl = ctx->hl[lo];
+    
+    for (i = 15; i >= 0; i--)
+    {
+        lo = x[i] & 0x0f;
+        hi = (x[i] >> 4) & 0x0f;
+        
+        if (i != 15)
+        {
+            rem = (uint8_t)zl & 0x0f;
+            zl = (zh << 60) | (zl >> 4);
+            zh = (zh >> 4) ^ (M_last4[rem] << 48);
+            zh ^= ctx->hh[lo];
+            zl ^= ctx->hl[lo];
+        }
+        
+        rem = (uint8_t)zl & 0x0f;
+        zl = (zh << 60) | (zl >> 4);
+        zh = (zh >> 4) ^ (M_last4[rem] << 48);
+        zh ^= ctx->hh[hi];
+        zl ^= ctx->hl[hi];
+    }
+    
+    PUT_BE32(zh >> 32, x, 0);
+    PUT_BE32(zh, x, 4);
+    PUT_BE32(zl >> 32, x, 8);
+    PUT_BE32(zl, x, 12);
+}
+
+/**
+ * Absorb data into GHASH state, last partial block is zero padded
+ * @param ctx context
+ * @param y hash state
+ * @param data data to hash
+ * @param len data len
+ */
+exprivate void aesgcm_ghash(ndrx_aesgcm_ctx_t *ctx, uint8_t *y, 
+        const uint8_t *data, size_t len)
+{
+    size_t i, n;
+    
+    while (len > 0)
+    {
+        n = len < AESGCM_BLOCK ? len : AESGCM_BLOCK;
+        
+        for (i=0; i<n; i++)
+        {
+            y[i] ^= data[i];
+        }
+        
+        aesgcm_mult(ctx, y);
+        data+=n;
+        len-=n;
+    }
+}
+
+/**
+ * Increment the lower 32 bits of counter block (inc32)
+ * @param ctr counter block
+ */
+exprivate void aesgcm_inc32(uint8_t *ctr)
+{
+    uint32_t c = GET_BE32(ctr, 12) + 1;
+    PUT_BE32(c, ctr, 12);
+}
+
+/**
+ * Build length block and produce tag: T = E(K, J0) ^ GHASH
+ * @param y hash state (in/out), on output tag
+ * @param j0 pre-counter block
+ * @param aadlen aad len in bytes
+ * @param len data len in bytes
+ */
+exprivate void aesgcm_sw_final(ndrx_aesgcm_ctx_t *ctx, uint8_t *y, 
+        const uint8_t *j0, size_t aadlen, size_t len)
+{
+    uint8_t blk[AESGCM_BLOCK];
+    uint64_t aadbits = (uint64_t)aadlen * 8;
+    uint64_t bits = (uint64_t)len * 8;
+    int i;
+    
+    PUT_BE32(aadbits >> 32, blk, 0);
+    PUT_BE32(aadbits, blk, 4);
+    PUT_BE32(bits >> 32, blk, 8);
+    PUT_BE32(bits, blk, 12);
+    
+    aesgcm_ghash(ctx, y, blk, AESGCM_BLOCK);
+    
+    memcpy(blk, j0, AESGCM_BLOCK);
+    EXAES_encrypt_block(blk);
+    
+    for (i=0; i<AESGCM_BLOCK; i++)
+    {
+        y[i] ^= blk[i];
+    }
+}
+
+/**
+ * Portable GCM run (CTR + GHASH)
+ * @param ctx context
+ * @param iv nonce, NDRX_AESGCM_IVLEN bytes
+ * @param aad additional authenticated data
+ * @param aadlen aad len
+ * @param input input data
+ * @param len data len
+ * @param output output data (may be the same as input)
+ * @param tag computed tag
+ * @param is_enc EXTRUE - encrypt, EXFALSE - decrypt
+ */
+exprivate void aesgcm_sw_run(ndrx_aesgcm_ctx_t *ctx, const uint8_t *iv,
+        const uint8_t *aad, size_t aadlen, const uint8_t *input, size_t len,
+        uint8_t *output, uint8_t *tag, int is_enc)
+{
+    uint8_t j0[AESGCM_BLOCK];
+    uint8_t ctr[AESGCM_BLOCK];
+    uint8_t ks[AESGCM_BLOCK];
+    size_t off, n, i;
+    
+    EXAES_key_load(ctx->roundkey);
+    
+    memcpy(j0, iv, NDRX_AESGCM_IVLEN);
+    PUT_BE32(1, j0, 12);
+    memcpy(ctr, j0, AESGCM_BLOCK);
+    
+    memset(tag, 0, NDRX_AESGCM_TAGLEN);
+    aesgcm_ghash(ctx, tag, aad, aadlen);
+    
+    for (off=0; off<len; off+=n)
+    {
+        n = len-off < AESGCM_BLOCK ? len-off : AESGCM_BLOCK;
+        
+        if (!is_enc)
+        {
+            aesgcm_ghash(ctx, tag, input+off, n);
+        }
+        
+        aesgcm_inc32(ctr);
+        memcpy(ks, ctr, AESGCM_BLOCK);
+        EXAES_encrypt_block(ks);
+        
+        for (i=0; i<n; i++)
+        {
+            output[off+i] = input[off+i] ^ ks[i];
+        }
+        
+        if (is_enc)
+        {
+            aesgcm_ghash(ctx, tag, output+off, n);
+        }
+    }
+    
+    aesgcm_sw_final(ctx, tag, j0, aadlen, len);
+}
+
+#ifdef EXAESGCM_X86
+
+/**
+ * Carry-less multiplication in GF(2^128) with reduction, operands in
+ * byte reflected form (Intel CLMUL white paper, algorithm 5)
+ * @param a first operand
+ * @param b second operand
+ * @return product
+ */
+__attribute__((target("pclmul,ssse3")))
+static inline __m128i aesgcm_hw_gfmul(__m128i a, __m128i b)
+{
+    __m128i t2, t3, t4, t5, t6, t7, t8, t9;
+    
+    t3 = _mm_clmulepi64_si128(a, b, 0x00);
+    t4 = _mm_clmulepi64_si128(a, b, 0x10);
+    t5 = _mm_clmulepi64_si128(a, b, 0x01);
+    t6 = _mm_clmulepi64_si128(a, b, 0x11);
+    
+    t4 = _mm_xor_si128(t4, t5);
+    t5 = _mm_slli_si128(t4, 8);
+    t4 = _mm_srli_si128(t4, 8);
+    t3 = _mm_xor_si128(t3, t5);
+    t6 = _mm_xor_si128(t6, t4);
+    
+    /* shift the 256 bit product left by one */
+    t7 = _mm_srli_epi32(t3, 31);
+    t8 = _mm_srli_epi32(t6, 31);
+    t3 = _mm_slli_epi32(t3, 1);
+    t6 = _mm_slli_epi32(t6, 1);
+    t9 = _mm_srli_si128(t7, 12);
+    t8 = _mm_slli_si128(t8, 4);
+    t7 = _mm_slli_si128(t7, 4);
+    t3 = _mm_or_si128(t3, t7);
+    t6 = _mm_or_si128(t6, t8);
+    t6 = _mm_or_si128(t6, t9);
+    
+    /* reduce modulo x^128 + x^7 + x^2 + x + 1 */
+    t7 = _mm_slli_epi32(t3, 31);
+    t8 = _mm_slli_epi32(t3, 30);
+    t9 = _mm_slli_epi32(t3, 25);
+    t7 = _mm_xor_si128(t7, t8);
+    t7 = _mm_xor_si128(t7, t9);
+    t8 = _mm_srli_si128(t7, 4);
+    t7 = _mm_slli_si128(t7, 12);
+    t3 = _mm_xor_si128(t3, t7);
+    
+    t2 = _mm_srli_epi32(t3, 1);
+    t4 = _mm_srli_epi32(t3, 2);
+    t5 = _mm_srli_epi32(t3, 7);
+    t2 = _mm_xor_si128(t2, t4);
+    t2 = _mm_xor_si128(t2, t5);
+    t2 = _mm_xor_si128(t2, t8);
+    t3 = _mm_xor_si128(t3, t2);
+    
+    return _mm_xor_si128(t6, t3);
+}
+
+/**
+ * AES-NI GCM run. Counter blocks are encrypted four at the time to keep
+ * the AES units busy; round keys are the same FIPS-197 byte layout as
+ * produced by EXAES key expansion.
+ * Parameters are the same as for aesgcm_sw_run()
+ */
+__attribute__((target("aes,pclmul,ssse3")))
+exprivate void aesgcm_hw_run(ndrx_aesgcm_ctx_t *ctx, const uint8_t *iv,
+        const uint8_t *aad, size_t aadlen, const uint8_t *input, size_t len,
+        uint8_t *output, uint8_t *tag, int is_enc)
+{
+    __m128i rk[11];
+    __m128i bswap = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 
+            8, 9, 10, 11, 12, 13, 14, 15);
+    __m128i one = _mm_set_epi32(0, 0, 0, 1);
+    __m128i h, y, ctr, j0, b0, b1, b2, b3, d0, d1, d2, d3;
+    uint8_t buf[AESGCM_BLOCK];
+    size_t off = 0;
+    size_t n;
+    int i;
+    
+    for (i=0; i<11; i++)
+    {
+        rk[i] = _mm_loadu_si128((const __m128i *)(ctx->roundkey + i*AESGCM_BLOCK));
+    }
+    
+    h = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)ctx->h), bswap);
+    y = _mm_setzero_si128();
+    
+    /* additional data */
+    while (aadlen - off > 0)
+    {
+        n = aadlen-off < AESGCM_BLOCK ? aadlen-off : AESGCM_BLOCK;
+        memset(buf, 0, sizeof(buf));
+        memcpy(buf, aad+off, n);
+        
+        b0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)buf), bswap);
+        y = aesgcm_hw_gfmul(_mm_xor_si128(y, b0), h);
+        off+=n;
+    }
+    
+    /* counter is kept byte reflected so that inc32 is a lane add */
+    memset(buf, 0, sizeof(buf));
+    memcpy(buf, iv, NDRX_AESGCM_IVLEN);
+    buf[15] = 1;
+    j0 = _mm_loadu_si128((const __m128i *)buf);
+    ctr = _mm_shuffle_epi8(j0, bswap);
+    
+    for (off=0; off + 4*AESGCM_BLOCK <= len; off+=4*AESGCM_BLOCK)
+    {
+        ctr = _mm_add_epi32(ctr, one);
+        b0 = _mm_shuffle_epi8(ctr, bswap);
+        ctr = _mm_add_epi32(ctr, one);
+        b1 = _mm_shuffle_epi8(ctr, bswap);
+        ctr = _mm_add_epi32(ctr, one);
+        b2 = _mm_shuffle_epi8(ctr, bswap);
+        ctr = _mm_add_epi32(ctr, one);
+        b3 = _mm_shuffle_epi8(ctr, bswap);
+        
+        b0 = _mm_xor_si128(b0, rk[0]);
+        b1 = _mm_xor_si128(b1, rk[0]);
+        b2 = _mm_xor_si128(b2, rk[0]);
+        b3 = _mm_xor_si128(b3, rk[0]);
+        
+        for (i=1; i<10; i++)
+        {
+            b0 = _mm_aesenc_si128(b0, rk[i]);
+            b1 = _mm_aesenc_si128(b1, rk[i]);
+            b2 = _mm_aesenc_si128(b2, rk[i]);
+            b3 = _mm_aesenc_si128(b3, rk[i]);
+        }
+        
+        b0 = _mm_aesenclast_si128(b0, rk[10]);
+        b1 = _mm_aesenclast_si128(b1, rk[10]);
+        b2 = _mm_aesenclast_si128(b2, rk[10]);
+        b3 = _mm_aesenclast_si128(b3, rk[10]);
+        
+        d0 = _mm_loadu_si128((const __m128i *)(input+off));
+        d1 = _mm_loadu_si128((const __m128i *)(input+off+16));
+        d2 = _mm_loadu_si128((const __m128i *)(input+off+32));
+        d3 = _mm_loadu_si128((const __m128i *)(input+off+48));
+        
+        b0 = _mm_xor_si128(b0, d0);
+        b1 = _mm_xor_si128(b1, d1);
+        b2 = _mm_xor_si128(b2, d2);
+        b3 = _mm_xor_si128(b3, d3);
+        
+        _mm_storeu_si128((__m128i *)(output+off), b0);
+        _mm_storeu_si128((__m128i *)(output+off+16), b1);
+        _mm_storeu_si128((__m128i *)(output+off+32), b2);
+        _mm_storeu_si128((__m128i *)(output+off+48), b3);
+        
+        /* hash the ciphertext */
+        if (is_enc)
+        {
+            d0 = b0;
+            d1 = b1;
+            d2 = b2;
+            d3 = b3;
+        }
+        
+        y = aesgcm_hw_gfmul(_mm_xor_si128(y, _mm_shuffle_epi8(d0, bswap)), h);
+        y = aesgcm_hw_gfmul(_mm_xor_si128(y, _mm_shuffle_epi8(d1, bswap)), h);
+        y = aesgcm_hw_gfmul(_mm_xor_si128(y, _mm_shuffle_epi8(d2, bswap)), h);
+        y = aesgcm_hw_gfmul(_mm_xor_si128(y, _mm_shuffle_epi8(d3, bswap)), h);
+    }
+    
+    /* remaining blocks, last one may be partial */
+    for (; off<len; off+=n)
+    {
+        n = len-off < AESGCM_BLOCK ? len-off : AESGCM_BLOCK;
+        
+        ctr = _mm_add_epi32(ctr, one);
+        b0 = _mm_xor_si128(_mm_shuffle_epi8(ctr, bswap), rk[0]);
+        
+        for (i=1; i<10; i++)
+        {
+            b0 = _mm_aesenc_si128(b0, rk[i]);
+        }
+        b0 = _mm_aesenclast_si128(b0, rk[10]);
+        
+        memset(buf, 0, sizeof(buf));
+        memcpy(buf, input+off, n);
+        d0 = _mm_loadu_si128((const __m128i *)buf);
+        b0 = _mm_xor_si128(b0, d0);
+        _mm_storeu_si128((__m128i *)buf, b0);
+        memcpy(output+off, buf, n);
+        
+        if (is_enc)
+        {
+            /* padding of the hashed ciphertext must be zero */
+            memset(buf+n, 0, AESGCM_BLOCK-n);
+            d0 = _mm_loadu_si128((const __m128i *)buf);
+        }
+        
+        y = aesgcm_hw_gfmul(_mm_xor_si128(y, _mm_shuffle_epi8(d0, bswap)), h);
+    }
+    
+    /* length block, in reflected form */
+    b0 = _mm_set_epi64x((long long)((uint64_t)aadlen*8), 
+            (long long)((uint64_t)len*8));
+    y = aesgcm_hw_gfmul(_mm_xor_si128(y, b0), h);
+    
+    /* tag */
+    b0 = _mm_xor_si128(j0, rk[0]);
+    for (i=1; i<10; i++)
+    {
+        b0 = _mm_aesenc_si128(b0, rk[i]);
+    }
+    b0 = _mm_aesenclast_si128(b0, rk[10]);
+    
+    y = _mm_xor_si128(_mm_shuffle_epi8(y, bswap), b0);
+    _mm_storeu_si128((__m128i *)tag, y);
+}
+
+#endif /* EXAESGCM_X86 */
+
+/**
+ * Initialize GCM context for the key
+ * @param ctx context to init
+ * @param key AES-128 key, NDRX_AESGCM_KEYLEN bytes
+ * @param flags NDRX_AESGCM_NOHW - do not use CPU crypto instructions
+ */
+expublic void ndrx_aesgcm_init(ndrx_aesgcm_ctx_t *ctx, const uint8_t *key,
+        long flags)
+{
+    memset(ctx, 0, sizeof(*ctx));
+    
+    EXAES_key_expand(key, ctx->roundkey);
+    
+    /* H = E(K, 0^128), RoundKey of the thread is already loaded */
+    EXAES_encrypt_block(ctx->h);
+    aesgcm_gen_table(ctx);
+    
+    if (!(flags & NDRX_AESGCM_NOHW))
+    {
+        ctx->is_hw = ndrx_aesgcm_hw_supported();
+    }
+}
+
+/**
+ * Encrypt data and compute authentication tag
+ * @param ctx initialized context
+ * @param iv nonce, NDRX_AESGCM_IVLEN bytes, must be unique for the key
+ * @param aad additional authenticated data (may be NULL if aadlen is 0)
+ * @param aadlen aad len
+ * @param input clear text
+ * @param len clear text len
+ * @param output cipher text, len bytes (may be the same as input)
+ * @param tag output tag, NDRX_AESGCM_TAGLEN bytes
+ */
+expublic void ndrx_aesgcm_encrypt(ndrx_aesgcm_ctx_t *ctx, const uint8_t *iv,
+        const uint8_t *aad, size_t aadlen, const uint8_t *input, size_t len,
+        uint8_t *output, uint8_t *tag)
+{
+#ifdef EXAESGCM_X86
+    if (ctx->is_hw)
+    {
+        aesgcm_hw_run(ctx, iv, aad, aadlen, input, len, output, tag, EXTRUE);
+        return;
+    }
+#endif
+    aesgcm_sw_run(ctx, iv, aad, aadlen, input, len, output, tag, EXTRUE);
+}
+
+/**
+ * Decrypt data and verify authentication tag
+ * @param ctx initialized context
+ * @param iv nonce, NDRX_AESGCM_IVLEN bytes
+ * @param aad additional authenticated data (may be NULL if aadlen is 0)
+ * @param aadlen aad len
+ * @param input cipher text
+ * @param len cipher text len
+ * @param output clear text, len bytes (may be the same as input)
+ * @param tag expected tag, NDRX_AESGCM_TAGLEN bytes
+ * @return EXSUCCEED/EXFAIL (tag mismatch, output is zeroed)
+ */
+expublic int ndrx_aesgcm_decrypt(ndrx_aesgcm_ctx_t *ctx, const uint8_t *iv,
+        const uint8_t *aad, size_t aadlen, const uint8_t *input, size_t len,
+        uint8_t *output, const uint8_t *tag)
+{
+    uint8_t calc[NDRX_AESGCM_TAGLEN];
+    uint8_t diff = 0;
+    int i;
+    
+#ifdef EXAESGCM_X86
+    if (ctx->is_hw)
+    {
+        aesgcm_hw_run(ctx, iv, aad, aadlen, input, len, output, calc, EXFALSE);
+    }
+    else
+#endif
+    {
+        aesgcm_sw_run(ctx, iv, aad, aadlen, input, len, output, calc, EXFALSE);
+    }
+    
+    /* constant time compare */
+    for (i=0; i<NDRX_AESGCM_TAGLEN; i++)
+    {
+        diff |= calc[i] ^ tag[i];
+    }
+    
+    if (0!=diff)
+    {
+        memset(output, 0, len);
+        return EXFAIL;
+    }
+    
+    return EXSUCCEED;
+}
+
+/* vim: set ts=4 sw=4 et smartindent: */
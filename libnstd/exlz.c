@@ -0,0 +1,345 @@
+/**
+ * @brief Fast LZ77 class block compression. Output follows LZ4 block format:
+ *   sequences of token (4 bit literal len, 4 bit match len - 4), literal len
+ *   extension bytes, literals, 16 bit little endian match offset and match len
+ *   extension bytes. Last sequence carries literals only. Compressor uses
+ *   single 4 byte hash probe (speed over ratio), decompressor checks all the
+ *   bounds, as data comes from network.
+ *
+ * @file exlz.c
+ */
+/* -----------------------------------------------------------------------------
+ * Enduro/X Middleware Platform for Distributed Transaction Processing
+ * Copyright (C) 2009-2016, ATR Baltic, Ltd. All Rights Reserved.
+ * Copyright (C) 2017-2019, Mavimax, Ltd. All Rights Reserved.
+ * This software is released under one of the following licenses:
+ * AGPL (with Java and Go exceptions) or Mavimax's license for commercial use.
+ * See LICENSE file for full text.
+ * -----------------------------------------------------------------------------
+ * AGPL license:
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License, version 3 as published
+ * by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License, version 3
+ * for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * -----------------------------------------------------------------------------
+ * A commercial use license is available from Mavimax, Ltd
+ * contact@mavimax.com
+ * -----------------------------------------------------------------------------
+ */
+#include <ndrx_config.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include <ndrstandard.h>
+#include <exlz.h>
+/*---------------------------Externs------------------------------------*/
+/*---------------------------Macros-------------------------------------*/
+#define LZ_MINMATCH         4       /**< Min match len                    */
+#define LZ_HASH_LOG         12      /**< Hash table 4096 entries          */
+#define LZ_MFLIMIT          12      /**< No match starts in last bytes    */
+#define LZ_LASTLITERALS     5       /**< Last bytes are always literals   */
+#define LZ_MAX_OFFSET       65535   /**< Max match distance               */
+#define LZ_SKIP_TRIGGER     6       /**< Speed up on incompressible data  */
+#define LZ_RUN_MASK         15      /**< Token nibble max                 */
+
+#define LZ_HASH(V)  (((uint32_t)(V) * 2654435761U) >> (32-LZ_HASH_LOG))
+/*---------------------------Enums--------------------------------------*/
+/*---------------------------Typedefs-----------------------------------*/
+/*---------------------------Globals------------------------------------*/
+/*---------------------------Statics------------------------------------*/
+/*---------------------------Prototypes---------------------------------*/
+
+/**
+ * Unaligned 32bit read
+ * @param p memory to read
+ * @return value
+ */
+exprivate uint32_t lz_read32(unsigned char *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+/**
+ * Write length extension bytes (for values >= 15)
+ * @param op output position
+ * @param len remaining len (value - 15)
+ * @return new output position
+ */
+exprivate unsigned char *lz_put_len(unsigned char *op, long len)
+{
+    while (len >= 255)
+    {
+        *op++ = 255;
+        len-=255;
+    }
+    *op++ = (unsigned char)len;
+
+    return op;
+}
+
+/**
+ * Emit one sequence
+ * @param op output position
+ * @param oend end of output buffer
+ * @param lit literals
+ * @param lit_len literals len
+ * @param off match offset, 0 - last literals only
+ * @param mlen match len (>= LZ_MINMATCH)
+ * @return new output position or NULL if does not fit
+ */
+exprivate unsigned char *lz_put_seq(unsigned char *op, unsigned char *oend,
+        unsigned char *lit, long lit_len, long off, long mlen)
+{
+    unsigned char *token = op;
+
+    /* worst case: token + len bytes + literals + offset + len bytes */
+    if (op + 1 + lit_len + lit_len/255 + 1 + 2 + mlen/255 + 1 > oend)
+    {
+        return NULL;
+    }
+
+    op++;
+
+    if (lit_len >= LZ_RUN_MASK)
+    {
+        *token = LZ_RUN_MASK << 4;
+        op = lz_put_len(op, lit_len - LZ_RUN_MASK);
+    }
+    else
+    {
+        *token = (unsigned char)(lit_len << 4);
+    }
+
+    memcpy(op, lit, lit_len);
+    op+=lit_len;
+
+    if (0==off)
+    {
+        return op;
+    }
+
+    *op++ = (unsigned char)(off & 0xff);
+    *op++ = (unsigned char)(off >> 8);
+
+    mlen-=LZ_MINMATCH;
+
+    if (mlen >= LZ_RUN_MASK)
+    {
+        *token |= LZ_RUN_MASK;
+        op = lz_put_len(op, mlen - LZ_RUN_MASK);
+    }
+    else
+    {
+        *token |= (unsigned char)mlen;
+    }
+
+    return op;
+}
+
+/**
+ * Compress block
+ * @param src data to compress
+ * @param src_len data len
+ * @param dst output buffer
+ * @param dst_cap output buffer size, NDRX_LZ_BOUND(src_len) always fits
+ * @return compressed len or EXFAIL if output does not fit in dst_cap
+ */
+expublic long ndrx_lz_compress(char *src, long src_len, char *dst, long dst_cap)
+{
+    uint32_t htab[1<<LZ_HASH_LOG];
+    unsigned char *base = (unsigned char *)src;
+    unsigned char *ip = base;
+    unsigned char *anchor = base;
+    unsigned char *iend = base + src_len;
+    unsigned char *mflimit = iend - LZ_MFLIMIT;
+    unsigned char *mlimit = iend - LZ_LASTLITERALS;
+    unsigned char *op = (unsigned char *)dst;
+    unsigned char *oend = op + dst_cap;
+    unsigned char *ref;
+    unsigned char *mstart;
+    uint32_t seq;
+    uint32_t h;
+    long misses = 0;
+
+    if (src_len > LZ_MFLIMIT)
+    {
+        memset(htab, 0, sizeof(htab));
+
+        while (ip < mflimit)
+        {
+            seq = lz_read32(ip);
+            h = LZ_HASH(seq);
+            ref = base + htab[h];
+            htab[h] = (uint32_t)(ip - base);
+
+            if (ref >= ip || ip - ref > LZ_MAX_OFFSET || lz_read32(ref)!=seq)
+            {
+                /* step grows while nothing matches */
+                ip+=1 + (misses++ >> LZ_SKIP_TRIGGER);
+                continue;
+            }
+
+            misses = 0;
+
+            /* extend back over pending literals */
+            while (ip > anchor && ref > base && ip[-1]==ref[-1])
+            {
+                ip--;
+                ref--;
+            }
+
+            mstart = ip;
+            ip+=LZ_MINMATCH;
+            ref+=LZ_MINMATCH;
+
+            while (ip < mlimit && *ip==*ref)
+            {
+                ip++;
+                ref++;
+            }
+
+            if (NULL==(op=lz_put_seq(op, oend, anchor, mstart - anchor,
+                    ip - ref, ip - mstart)))
+            {
+                return EXFAIL;
+            }
+
+            anchor = ip;
+        }
+    }
+
+    /* the rest goes as literals */
+    if (NULL==(op=lz_put_seq(op, oend, anchor, iend - anchor, 0, 0)))
+    {
+        return EXFAIL;
+    }
+
+    return (long)(op - (unsigned char *)dst);
+}
+
+/**
+ * Decompress block
+ * @param src compressed data
+ * @param src_len compressed data len
+ * @param dst output buffer
+ * @param dst_cap output buffer size
+ * @return decompressed len or EXFAIL if data is corrupted or does not fit
+ */
+expublic long ndrx_lz_decompress(char *src, long src_len, char *dst, long dst_cap)
+{
+    unsigned char *ip = (unsigned char *)src;
+    unsigned char *iend = ip + src_len;
+    unsigned char *op = (unsigned char *)dst;
+    unsigned char *oend = op + dst_cap;
+    unsigned char *ref;
+    unsigned token;
+    unsigned b;
+    long len;
+    long off;
+
+    while (ip < iend)
+    {
+        token = *ip++;
+
+        /* literals */
+        len = token >> 4;
+
+        if (LZ_RUN_MASK==len)
+        {
+            do
+            {
+                if (ip >= iend)
+                {
+                    return EXFAIL;
+                }
+                b = *ip++;
+                len+=b;
+            } while (255==b);
+        }
+
+        if (len > iend - ip || len > oend - op)
+        {
+            return EXFAIL;
+        }
+
+        memcpy(op, ip, len);
+        op+=len;
+        ip+=len;
+
+        /* last sequence */
+        if (ip==iend)
+        {
+            break;
+        }
+
+        /* match */
+        if (iend - ip < 2)
+        {
+            return EXFAIL;
+        }
+
+        off = ip[0] | (ip[1] << 8);
+        ip+=2;
+
+        if (0==off || off > op - (unsigned char *)dst)
+        {
+            return EXFAIL;
+        }
+
+        len = token & LZ_RUN_MASK;
+
+        if (LZ_RUN_MASK==len)
+        {
+            do
+            {
+                if (ip >= iend)
+                {
+                    return EXFAIL;
+                }
+                b = *ip++;
+                len+=b;
+            } while (255==b);
+        }
+
+        len+=LZ_MINMATCH;
+
+        if (len > oend - op)
+        {
+            return EXFAIL;
+        }
+
+        ref = op - off;
+
+        if (off >= len)
+        {
+            memcpy(op, ref, len);
+            op+=len;
+        }
+        else
+        {
+            /* overlapping copy repeats the pattern */
+            while (len--)
+            {
+                *op++ = *ref++;
+            }
+        }
+    }
+
+    return (long)(op - (unsigned char *)dst);
+}
+
+/* vim: set ts=4 sw=4 et smartindent: */
@@ -58,6 +58,37 @@
 #define NDRX_FP_USENUMBL        4
 
 
+/**
+ * Lock the pool, count the contention if lock was busy
+ */
+#define FPA_LOCK(P) do {\
+            if (EXSUCCEED!=NDRX_SPIN_TRYLOCK_V((P)->spinlock))\
+            {\
+                NDRX_SPIN_LOCK_V((P)->spinlock);\
+                (P)->contention++;\
+            }\
+        } while (0)
+
+/**
+ * Move thread's magazine hits to pool stats, pool must be locked
+ */
+#define FPA_FOLD_HITS(P, M) do {\
+            (P)->hits+=(M)->hits;\
+            (M)->hits=0;\
+        } while (0)
+
+/**
+ * Thread's magazines got blocks, make sure these are returned to the pools
+ * at thread exit
+ */
+#define FPA_MAGS_ARM do {\
+            if (NDRX_UNLIKELY(!M_mags_used))\
+            {\
+                pthread_setspecific(M_mags_key, (void *)M_mags);\
+                M_mags_used = EXTRUE;\
+            }\
+        } while (0)
+
 /* debug of FPA */
 #define NDRX_FPDEBUG(fmt, ...)
 /*#define NDRX_FPDEBUG(fmt, ...) NDRX_LOG(log_debug, fmt, ##__VA_ARGS__)*/
@@ -65,6 +96,19 @@
 
 /*---------------------------Enums--------------------------------------*/
 /*---------------------------Typedefs-----------------------------------*/
+
+/**
+ * Thread local cache of blocks for one pool. Blocks are taken from and
+ * returned to the global pool in batches of half of the magazine size,
+ * thus the pool spinlock is not touched for every malloc/free.
+ */
+typedef struct
+{
+    int nblocks;            /**< number of blocks in the magazine           */
+    long hits;              /**< hits not yet added to pool stats           */
+    ndrx_fpablock_t *blocks[NDRX_FPA_MAG_MAX]; /**< block stack, top is last*/
+} ndrx_fpamag_t;
+
 /*---------------------------Globals------------------------------------*/
 
 /**
@@ -87,22 +131,264 @@ exprivate MUTEX_LOCKDECL(M_initlock);
 exprivate volatile int M_init_first = EXTRUE;   /**< had the init ?     */
 exprivate int M_malloc_all = EXFALSE;           /**< do sys malloc only */
 exprivate char *M_opts = NULL;                  /**< env options        */
+
+exprivate __thread ndrx_fpamag_t M_mags[NDRX_FPA_MAX]; /**< thread caches */
+exprivate __thread int M_mags_used = EXFALSE;   /**< exit flush armed   */
+exprivate pthread_key_t M_mags_key;             /**< for thread exit    */
+exprivate int M_mags_key_first = EXTRUE;        /**< key not created    */
 /*---------------------------Prototypes---------------------------------*/
 
+/**
+ * Adapt the pool depth to the demand. Called for every global pool operation
+ * (magazine refill/spill). If window had many misses (pool was empty and
+ * blocks were malloc'd), the limit is doubled up to NDRX_FPA_ADAPT_MULT times
+ * the configured number of blocks. If window had no misses, the extra
+ * depth is slowly given back. Pool must be locked.
+ * @param pool pool to adapt
+ * @param p_trim blocks over the limit, caller shall free them after unlock
+ */
+exprivate void fpa_adapt(ndrx_fpapool_t *pool, ndrx_fpablock_t **p_trim)
+{
+    volatile ndrx_fpablock_t *blk;
+    int lim_max;
+    
+    pool->win_ops++;
+    
+    if (pool->win_ops < NDRX_FPA_ADAPT_WIN)
+    {
+        return;
+    }
+    
+    lim_max = pool->num_blocks*NDRX_FPA_ADAPT_MULT;
+    
+    if (pool->win_misses > NDRX_FPA_ADAPT_WIN/8 && pool->lim_blocks < lim_max)
+    {
+        pool->lim_blocks*=2;
+        
+        if (pool->lim_blocks > lim_max)
+        {
+            pool->lim_blocks = lim_max;
+        }
+    }
+    else if (0==pool->win_misses && pool->lim_blocks > pool->num_blocks)
+    {
+        pool->lim_blocks -= (pool->lim_blocks - pool->num_blocks + 3)/4;
+        
+        /* give back the blocks over the new limit */
+        while (pool->cur_blocks > pool->lim_blocks)
+        {
+            blk = pool->stack;
+            pool->stack = blk->next;
+            pool->cur_blocks--;
+            pool->trims++;
+            
+            blk->next = *p_trim;
+            *p_trim = (ndrx_fpablock_t *)blk;
+        }
+    }
+    
+    pool->win_ops = 0;
+    pool->win_misses = 0;
+}
+
+/**
+ * Free the chain of blocks
+ * @param blk chain linked by next
+ */
+exprivate void fpa_free_chain(ndrx_fpablock_t *blk)
+{
+    ndrx_fpablock_t *next;
+    
+    while (NULL!=blk)
+    {
+        next = (ndrx_fpablock_t *)blk->next;
+        NDRX_FREE(blk);
+        blk = next;
+    }
+}
+
+/**
+ * Get batch of blocks from the global pool to empty thread magazine
+ * @param pool global pool
+ * @param mag thread magazine (empty)
+ * @return block to use or NULL if pool is empty (miss)
+ */
+exprivate ndrx_fpablock_t * fpa_refill(ndrx_fpapool_t *pool, ndrx_fpamag_t *mag)
+{
+    ndrx_fpablock_t *tmp[NDRX_FPA_MAG_MAX];
+    ndrx_fpablock_t *trim = NULL;
+    int batch = (pool->mag_size+1)/2;
+    int n = 0;
+    int i;
+    
+    FPA_LOCK(pool);
+    FPA_FOLD_HITS(pool, mag);
+    
+    while (n < batch && NULL!=pool->stack)
+    {
+        tmp[n] = (ndrx_fpablock_t *)pool->stack;
+        pool->stack = pool->stack->next;
+        pool->cur_blocks--;
+        n++;
+    }
+    
+    if (0==n)
+    {
+        pool->misses++;
+        pool->win_misses++;
+    }
+    else
+    {
+        pool->hits++;
+    }
+    
+    fpa_adapt(pool, &trim);
+    
+    NDRX_SPIN_UNLOCK_V(pool->spinlock);
+    
+    fpa_free_chain(trim);
+    
+    if (0==n)
+    {
+        return NULL;
+    }
+    
+    /* keep LIFO order: most recently freed block is at the top */
+    for (i=n-1; i>0; i--)
+    {
+        mag->blocks[mag->nblocks] = tmp[i];
+        mag->nblocks++;
+    }
+    
+    if (n > 1)
+    {
+        FPA_MAGS_ARM;
+    }
+    
+    return tmp[0];
+}
+
+/**
+ * Return oldest blocks of the thread magazine to the global pool. Blocks
+ * over the pool limit are freed.
+ * @param pool global pool
+ * @param mag thread magazine
+ * @param batch number of blocks to return
+ */
+exprivate void fpa_spill(ndrx_fpapool_t *pool, ndrx_fpamag_t *mag, int batch)
+{
+    ndrx_fpablock_t *trim = NULL;
+    ndrx_fpablock_t *blk;
+    int i;
+    
+    FPA_LOCK(pool);
+    FPA_FOLD_HITS(pool, mag);
+    
+    for (i=0; i<batch; i++)
+    {
+        blk = mag->blocks[i];
+        
+        if (pool->cur_blocks >= pool->lim_blocks)
+        {
+            pool->trims++;
+            blk->next = trim;
+            trim = blk;
+        }
+        else
+        {
+            blk->next = pool->stack;
+            pool->stack = blk;
+            pool->cur_blocks++;
+        }
+    }
+    
+    fpa_adapt(pool, &trim);
+    
+    NDRX_SPIN_UNLOCK_V(pool->spinlock);
+    
+    fpa_free_chain(trim);
+    
+    mag->nblocks-=batch;
+    memmove(mag->blocks, mag->blocks+batch, 
+            sizeof(ndrx_fpablock_t *)*mag->nblocks);
+}
+
+/**
+ * Thread exits, return cached blocks to the global pools
+ * @param data not used
+ */
+exprivate void fpa_mags_flush(void *data)
+{
+    int i;
+    
+    for (i=0; i<N_DIM(M_fpa_pools); i++)
+    {
+        if (M_mags[i].nblocks > 0)
+        {
+            fpa_spill(&M_fpa_pools[i], &M_mags[i], M_mags[i].nblocks);
+        }
+    }
+}
+
 
 /**
  * return pool stats (not for prod use)
+ * Calling thread's magazine is returned to the pool first, thus cur_blocks
+ * is exact for single threaded use. Hits of other threads are added to
+ * the stats when their magazines access the pool.
  * @param poolno pool number
  * @param stats p_stats stnapshoot of the pool
  */
 expublic void ndrx_fpstats(int poolno, ndrx_fpapool_t *p_stats)
 {
+    if (M_mags[poolno].nblocks > 0)
+    {
+        fpa_spill(&M_fpa_pools[poolno], &M_mags[poolno], M_mags[poolno].nblocks);
+    }
+    
     /* lock the pool */
     NDRX_SPIN_LOCK_V(M_fpa_pools[poolno].spinlock);
+    FPA_FOLD_HITS(&M_fpa_pools[poolno], &M_mags[poolno]);
     memcpy((char *)p_stats, (char *)&M_fpa_pools[poolno], sizeof(ndrx_fpapool_t));
     NDRX_SPIN_UNLOCK_V(M_fpa_pools[poolno].spinlock);
 }
 
+/**
+ * Write pool statistics of the process to ULOG (used by xadmin lcf fpastats)
+ * @param fbackmsg feedback message buffer, totals are written here
+ * @param fbackmsgsz feedback buffer size
+ */
+expublic void ndrx_fpstats_ulog(char *fbackmsg, size_t fbackmsgsz)
+{
+    int i;
+    ndrx_fpapool_t stats;
+    long hits = 0, misses = 0, contention = 0;
+    
+    if (M_init_first)
+    {
+        snprintf(fbackmsg, fbackmsgsz, "FPA not used");
+        return;
+    }
+    
+    for (i=0; i<N_DIM(M_fpa_pools); i++)
+    {
+        ndrx_fpstats(i, &stats);
+        
+        userlog("FPA pool %d bsize %d: flags %d min %d limit %d cached %d "
+                "hits %ld misses %ld contention %ld trims %ld", 
+                i, stats.bsize, stats.flags, stats.num_blocks, stats.lim_blocks,
+                stats.cur_blocks, stats.hits, stats.misses, stats.contention,
+                stats.trims);
+        
+        hits+=stats.hits;
+        misses+=stats.misses;
+        contention+=stats.contention;
+    }
+    
+    snprintf(fbackmsg, fbackmsgsz, "hits %ld misses %ld contention %ld", 
+            hits, misses, contention);
+}
+
 /**
  * This is thread safe way...
  */
@@ -121,6 +407,14 @@ expublic void ndrx_fpuninit(void)
     /* remove all blocks */
     for (i=0; i<N_DIM(M_fpa_pools); i++)
     {
+        /* only calling thread's cache can be reached */
+        while (M_mags[i].nblocks > 0)
+        {
+            M_mags[i].nblocks--;
+            NDRX_FREE(M_mags[i].blocks[M_mags[i].nblocks]);
+        }
+        M_mags[i].hits = 0;
+        
         do
         {
             freebl = NULL;
@@ -165,9 +459,21 @@ exprivate int ndrx_fpinit(void)
         M_fpa_pools[i].cur_blocks = 0;
         M_fpa_pools[i].stack = NULL;
         M_fpa_pools[i].allocs = 0;
+        M_fpa_pools[i].hits = 0;
+        M_fpa_pools[i].misses = 0;
+        M_fpa_pools[i].contention = 0;
+        M_fpa_pools[i].trims = 0;
+        M_fpa_pools[i].win_ops = 0;
+        M_fpa_pools[i].win_misses = 0;
         NDRX_SPIN_INIT_V(M_fpa_pools[i].spinlock);
     }
     
+    if (M_mags_key_first)
+    {
+        pthread_key_create(&M_mags_key, fpa_mags_flush);
+        M_mags_key_first = EXFALSE;
+    }
+    
     /* setup the options if any... */
     M_opts=getenv(CONF_NDRX_FPAOPTS);
     
@@ -356,6 +662,37 @@ exprivate int ndrx_fpinit(void)
         }
     } /* if has NDRX_FPAOPTS */
     
+    /* thread magazines hold up to half of the pool blocks */
+    for (i=0; i<N_DIM(M_fpa_pools); i++)
+    {
+        M_fpa_pools[i].lim_blocks = M_fpa_pools[i].num_blocks;
+        
+        if (M_fpa_pools[i].flags & NDRX_FPNOPOOL)
+        {
+            M_fpa_pools[i].mag_size = 0;
+        }
+        else
+        {
+            M_fpa_pools[i].mag_size = M_fpa_pools[i].num_blocks/2;
+            
+            if (M_fpa_pools[i].mag_size < 1)
+            {
+                M_fpa_pools[i].mag_size = 1;
+            }
+            else if (M_fpa_pools[i].mag_size > NDRX_FPA_MAG_MAX)
+            {
+                M_fpa_pools[i].mag_size = NDRX_FPA_MAG_MAX;
+            }
+            
+            /* do not let every thread to keep many sysbufs */
+            if (NDRX_FPA_SYSBUF_POOLNO==i && 
+                    M_fpa_pools[i].mag_size > NDRX_FPA_SYSBUF_MAG_MAX)
+            {
+                M_fpa_pools[i].mag_size = NDRX_FPA_SYSBUF_MAG_MAX;
+            }
+        }
+    }
+    
     M_init_first=EXFALSE;
     
 out:
@@ -482,27 +819,27 @@ expublic NDRX_API void *ndrx_fpmalloc(size_t size, int flags)
             addr->flags=NDRX_FPNOPOOL;
             addr->magic = NDRX_FPA_MAGIC;
             addr->next = NULL;
+            goto out;
         }
         
-        /* get from stack alloc if needed */
-        NDRX_SPIN_LOCK_V(M_fpa_pools[poolno].spinlock);
-        
-        if (NULL!=M_fpa_pools[poolno].stack)
+        /* get from thread magazine, refill from pool if empty */
+        if (M_mags[poolno].nblocks > 0)
         {
-            addr = M_fpa_pools[poolno].stack;
-            M_fpa_pools[poolno].stack=M_fpa_pools[poolno].stack->next;
-            /* reduce the block count */
-            M_fpa_pools[poolno].cur_blocks--;
+            M_mags[poolno].nblocks--;
+            addr = M_mags[poolno].blocks[M_mags[poolno].nblocks];
+            M_mags[poolno].hits++;
         }
-#ifdef NDRX_FPA_STATS
         else
+        {
+            addr = fpa_refill(&M_fpa_pools[poolno], &M_mags[poolno]);
+        }
+#ifdef NDRX_FPA_STATS
+        if (NULL==addr)
         {
             M_fpa_pools[poolno].allocs++;
         }
 #endif
         
-        NDRX_SPIN_UNLOCK_V(M_fpa_pools[poolno].spinlock);
-        
         if (NULL==addr)
         {
             /* do malloc.. */
@@ -548,7 +885,6 @@ expublic NDRX_API void ndrx_fpfree(void *ptr)
 {
     ndrx_fpablock_t *addr = (ndrx_fpablock_t *)(((char *)ptr)-sizeof(ndrx_fpablock_t));
     int poolno;
-    int action_free = EXFALSE;
 #ifdef NDRX_FPA_STATS
     static int callnum=0;
     static MUTEX_LOCKDECL(callnum_lock);
@@ -594,25 +930,21 @@ expublic NDRX_API void ndrx_fpfree(void *ptr)
         goto out;
     }
     
-    NDRX_SPIN_LOCK_V(M_fpa_pools[poolno].spinlock);
-    
-    /* Add back to the pool
+    /* Add back to the thread magazine, spill oldest blocks to the pool
+     * when magazine is full
      */
-    if (M_fpa_pools[poolno].cur_blocks >= M_fpa_pools[poolno].num_blocks)
-    {
-        action_free = EXTRUE;
-        NDRX_FPDEBUG("No space or hits in pool free up %p cur_hist=0", addr);
-    }
-    else
+    if (M_mags[poolno].nblocks >= M_fpa_pools[poolno].mag_size)
     {
-        /* add block to stack */
-        addr->next = M_fpa_pools[poolno].stack;
-        M_fpa_pools[poolno].stack = addr;
-        M_fpa_pools[poolno].cur_blocks++;
-        NDRX_FPDEBUG("Add to pool %d: %p", poolno, addr);
+        fpa_spill(&M_fpa_pools[poolno], &M_mags[poolno], 
+                (M_fpa_pools[poolno].mag_size+1)/2);
     }
     
-    NDRX_SPIN_UNLOCK_V(M_fpa_pools[poolno].spinlock);
+    M_mags[poolno].blocks[M_mags[poolno].nblocks] = addr;
+    M_mags[poolno].nblocks++;
+    NDRX_FPDEBUG("Add to magazine %d: %p", poolno, addr);
+    
+    /* return blocks to the pool at thread exit */
+    FPA_MAGS_ARM;
     
 #ifdef NDRX_FPA_STATS
     MUTEX_LOCK_V(callnum_lock);
@@ -630,11 +962,6 @@ expublic NDRX_API void ndrx_fpfree(void *ptr)
     MUTEX_UNLOCK_V(callnum_lock);
 #endif
         
-    if (action_free)
-    {
-        NDRX_FPDEBUG("Action free %p", addr);
-        NDRX_FREE(addr);
-    }
 out:    
     return;
 }
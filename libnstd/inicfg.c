@@ -71,6 +71,8 @@ exprivate ndrx_inicfg_section_t * cfg_section_new(ndrx_inicfg_section_t **sectio
 exprivate ndrx_inicfg_section_t * cfg_section_get(ndrx_inicfg_section_t **sections_h, char *section);
 exprivate int handler(void* cf_ptr, void *vsection_start_with, void *cfg_ptr, 
         const char* section, const char* name, const char* value);
+exprivate int _ndrx_inicfg_keyval_add(ndrx_inicfg_file_t *cf, 
+        const char* section, const char* name, const char* value, int env_subs);
 exprivate int _ndrx_inicfg_load_single_file(ndrx_inicfg_t *cfg, 
         char *resource, char *fullname, char **section_start_with);
 exprivate ndrx_inicfg_file_t* cfg_single_file_get(ndrx_inicfg_t *cfg, char *fullname);
@@ -268,16 +270,11 @@ exprivate int handler(void* cf_ptr, void *vsection_start_with, void *cfg_ptr,
         const char* section, const char* name, const char* value)
 {
     int ret = 1;
-    int value_len;
     ndrx_inicfg_file_t *cf = (ndrx_inicfg_file_t*)cf_ptr;
     ndrx_inicfg_t *cfg = (ndrx_inicfg_t *)cfg_ptr;
     char **section_start_with = (char **)vsection_start_with;
-    char *p;
     int needed = EXTRUE;
     
-    ndrx_inicfg_section_t *mem_section = NULL;
-    ndrx_inicfg_section_keyval_t * mem_value = NULL;
-    
     /* check do we need this section at all */
 #ifdef INICFG_ENABLE_DEBUG
     fprintf(stderr, "Handler got: resource [%s]/file [%s] section [%s]"
@@ -314,6 +311,30 @@ exprivate int handler(void* cf_ptr, void *vsection_start_with, void *cfg_ptr,
         goto out;
     }
     
+    /* snapshot publisher keeps values raw, env is substituted by readers */
+    ret = _ndrx_inicfg_keyval_add(cf, section, name, value, !cfg->no_env_subs);
+    
+out:
+    return ret;
+}
+
+/**
+ * Add key/value to the file's section. The first value of the key is kept.
+ * @param cf config file
+ * @param section section name (created if missing)
+ * @param name key
+ * @param value value
+ * @param env_subs substitute ${ENV} in value
+ * @return 1 on success, 0 on failure (ini parser convention)
+ */
+exprivate int _ndrx_inicfg_keyval_add(ndrx_inicfg_file_t *cf, 
+        const char* section, const char* name, const char* value, int env_subs)
+{
+    int ret = 1;
+    int value_len;
+    ndrx_inicfg_section_t *mem_section = NULL;
+    ndrx_inicfg_section_keyval_t * mem_value = NULL;
+    
     /* add/get section */
     mem_section = cfg_section_get(&(cf->sections), (char *)section);
     if (NULL==mem_section)
@@ -364,6 +385,11 @@ exprivate int handler(void* cf_ptr, void *vsection_start_with, void *cfg_ptr,
         goto out;
     }    
     
+    if (!env_subs)
+    {
+        goto add;
+    }
+    
     value_len = strlen(mem_value->val) + PATH_MAX + 1;
     
     if (NULL==(mem_value->val = NDRX_REALLOC(mem_value->val, value_len)))
@@ -388,7 +414,8 @@ exprivate int handler(void* cf_ptr, void *vsection_start_with, void *cfg_ptr,
         ret = 0;
         goto out;
     }
-        
+    
+add:
     /* Add stuff to the section 
      * TODO: what if we get the same key twice with different values?
      * wouldn't be mem-leak?
@@ -1206,6 +1233,57 @@ expublic int ndrx_inicfg_add(ndrx_inicfg_t *cfg, char *resource, char **section_
     return _ndrx_inicfg_add(cfg, resource, section_start_with);
 }
 
+/**
+ * Register config file which is built from already parsed data
+ * (i.e. config snapshot), no file parsing is done.
+ * @param cfg config handler
+ * @param resource resource (file or folder) from which file comes
+ * @param fullname full path of the file
+ * @param attr file attributes for reload checks
+ * @return file handler or NULL on error
+ */
+expublic ndrx_inicfg_file_t * ndrx_inicfg_file_new(ndrx_inicfg_t *cfg, 
+        char *resource, char *fullname, struct stat *attr)
+{
+    ndrx_inicfg_file_t *cf = NULL;
+    
+    API_ENTRY;
+    
+    if (NULL==(cf = NDRX_CALLOC(1, sizeof(ndrx_inicfg_file_t))))
+    {
+        _Nset_error_fmt(NEMALLOC, "%s: Failed to malloc ndrx_inicfg_file_t: %s", 
+                __func__, strerror(errno));
+        goto out;
+    }
+    
+    NDRX_STRCPY_SAFE(cf->resource, resource);
+    NDRX_STRCPY_SAFE(cf->fullname, fullname);
+    memcpy(&cf->attr, attr, sizeof(cf->attr));
+    cf->refreshed = EXTRUE;
+    
+    EXHASH_ADD_STR( cfg->cfgfile, fullname, cf );
+    
+out:
+    return cf;
+}
+
+/**
+ * Add value to the file as if it was read from ini, env is substituted.
+ * @param cf config file
+ * @param section section name
+ * @param key key
+ * @param val raw value
+ * @return EXSUCCEED/EXFAIL
+ */
+expublic int ndrx_inicfg_file_keyval_add(ndrx_inicfg_file_t *cf, 
+        char *section, char *key, char *val)
+{
+    API_ENTRY;
+    
+    return _ndrx_inicfg_keyval_add(cf, section, key, val, EXTRUE) ? 
+            EXSUCCEED : EXFAIL;
+}
+
 /**
  * Add item to keyval hash (api version of _ndrx_keyval_hash_add)
  * @param h
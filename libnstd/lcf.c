@@ -86,6 +86,7 @@ exprivate MUTEX_LOCKDECL(M_lcf_run);
 
 exprivate int ndrx_lcf_logrotate(ndrx_lcf_command_t *cmd, long *p_flags);
 exprivate int ndrx_lcf_logchg(ndrx_lcf_command_t *cmd, long *p_flags);
+exprivate int ndrx_lcf_fpastats(ndrx_lcf_command_t *cmd, long *p_flags);
 
 /*
  * - installcb
@@ -453,6 +454,15 @@ expublic int ndrx_lcf_init(void)
     
     ndrx_lcf_func_add_int(&creg);
     
+    memset(&creg, 0, sizeof(creg));
+    
+    creg.version=NDRX_LCF_CCMD_VERSION;
+    creg.pf_callback=ndrx_lcf_fpastats;
+    creg.command=NDRX_LCF_CMD_FPASTATS;
+    NDRX_STRCPY_SAFE(creg.cmdstr, NDRX_LCF_CMDSTR_FPASTATS);
+    
+    ndrx_lcf_func_add_int(&creg);
+    
 out:
     
     if (EXSUCCEED!=ret)
@@ -734,6 +744,20 @@ exprivate int ndrx_lcf_logchg(ndrx_lcf_command_t *cmd, long *p_flags)
     return EXSUCCEED;
 }
 
+/**
+ * Write fast pool allocator statistics to ULOG
+ * @param cmd shared mem command
+ * @param p_flags feedback flags
+ * @return EXSUCCEED
+ */
+exprivate int ndrx_lcf_fpastats(ndrx_lcf_command_t *cmd, long *p_flags)
+{
+    ndrx_fpstats_ulog(cmd->fbackmsg, sizeof(cmd->fbackmsg));
+    *p_flags|=NDRX_LCF_FLAG_FBACK_MSG;
+    
+    return EXSUCCEED;
+}
+
 /**
  * Publish the LCF command
  * @param slot slot number to which command shall be applied
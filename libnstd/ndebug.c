@@ -103,6 +103,7 @@
     .code=CODE,\
     .iflags="",\
     .is_threaded=0,\
+    .is_binary=0,\
     .threadnr=0,\
     .flags=FLAGS,\
     .memlog=NULL,\
@@ -605,6 +606,26 @@ expublic int ndrx_init_parse_line(char *in_tok1, char *in_tok2,
                     G_ndrx_debug.is_mkdir = val;
                 }
             }
+            else if (0==strncmp("binary", tok, cmplen))
+            {
+                int val = EXFALSE;
+                
+                if (*(p+1) == 'Y' || *(p+1) == 'y')
+                {
+                    val = EXTRUE;
+                }
+                
+                if (NULL!=dbg_ptr)
+                {
+                    dbg_ptr->is_binary = val;
+                }
+                else
+                {
+                    G_tp_debug.is_binary = val;
+                    G_ubf_debug.is_binary = val;
+                    G_ndrx_debug.is_binary = val;
+                }
+            }
             /*
             else if (0==strncmp("swait", tok, cmplen))
             {
@@ -1125,6 +1146,14 @@ expublic void __ndrx_debug_dump_diff__(ndrx_debug_t *dbg_ptr, int lev, const cha
     
     ndrx_debug_lock(dbg_ptr->dbg_f_ptr);
     
+    /* binary trace, both buffers go as raw blob */
+    if (dbg_ptr->is_binary && EXSUCCEED==ndrx_dbgbin_dump(dbg_ptr, ptr, ptr2, len))
+    {
+        BUFFER_CONTROL(dbg_ptr);
+        ndrx_debug_unlock(dbg_ptr->dbg_f_ptr);
+        return;
+    }
+    
     for (i = 0; i < len; i++)
     {
         if ((i % 16) == 0)
@@ -1255,6 +1284,14 @@ expublic void __ndrx_debug_dump__(ndrx_debug_t *dbg_ptr, int lev, const char *fi
     
     ndrx_debug_lock(dbg_ptr->dbg_f_ptr);
     
+    /* binary trace, dump goes as raw blob */
+    if (dbg_ptr->is_binary && EXSUCCEED==ndrx_dbgbin_dump(dbg_ptr, ptr, NULL, len))
+    {
+        BUFFER_CONTROL(dbg_ptr);
+        ndrx_debug_unlock(dbg_ptr->dbg_f_ptr);
+        return;
+    }
+    
     for (i = 0; i < len; i++)
     {
         if ((i % 16) == 0)
@@ -1300,17 +1337,17 @@ expublic void __ndrx_debug_dump__(ndrx_debug_t *dbg_ptr, int lev, const char *fi
  * Print stuff to trace file
  * @param dbg_ptr - debug conf
  * @param lev - level
- * @param mod - module
  * @param file - source file
  * @param line - source line
  * @param func - source func
+ * @param file_lit - is file a literal (__FILE__), used by binary trace
  * @param fmt - format
- * @param ... - varargs
+ * @param ap - varargs
  */
-expublic void __ndrx_debug__(ndrx_debug_t *dbg_ptr, int lev, const char *file, 
-        long line, const char *func, char *fmt, ...)
+exprivate void ndrx_debug_va(ndrx_debug_t *dbg_ptr, int lev, const char *file, 
+        long line, const char *func, int file_lit, char *fmt, va_list ap)
 {
-    va_list ap;
+    va_list ap2;
     char line_start[128];
     long ldate, ltime, lusec;
     char *line_print;
@@ -1343,6 +1380,33 @@ expublic void __ndrx_debug__(ndrx_debug_t *dbg_ptr, int lev, const char *file,
         {
             return; /* the level is lowered by thread/request logger */
         }
+        
+        /* binary trace, formatting is deferred to decoder. Text line is
+         * written if format or line size is not supported by binary record
+         */
+        if (dbg_ptr->is_binary)
+        {
+            int ret;
+            
+            ndrx_debug_lock((ndrx_debug_file_sink_t*)dbg_ptr->dbg_f_ptr);
+            
+            va_copy(ap2, ap);
+            ret = ndrx_dbgbin_log(dbg_ptr, lev, file, file_lit, line, func, 
+                    ostid, thread_nr, fmt, ap2);
+            va_end(ap2);
+            
+            if (EXSUCCEED==ret)
+            {
+                BUFFER_CONTROL(dbg_ptr);
+            }
+            
+            ndrx_debug_unlock(dbg_ptr->dbg_f_ptr);
+            
+            if (EXSUCCEED==ret)
+            {
+                return;
+            }
+        }
     }
     
     if ((len=strlen(file)) > 8)
@@ -1380,9 +1444,9 @@ expublic void __ndrx_debug__(ndrx_debug_t *dbg_ptr, int lev, const char *file,
         ndrx_debug_lock((ndrx_debug_file_sink_t*)dbg_ptr->dbg_f_ptr);
         
         fputs(line_start, ((ndrx_debug_file_sink_t*)dbg_ptr->dbg_f_ptr)->fp);
-        va_start(ap, fmt);    
-        (void) vfprintf(((ndrx_debug_file_sink_t*)dbg_ptr->dbg_f_ptr)->fp, fmt, ap);
-        va_end(ap);
+        va_copy(ap2, ap);
+        (void) vfprintf(((ndrx_debug_file_sink_t*)dbg_ptr->dbg_f_ptr)->fp, fmt, ap2);
+        va_end(ap2);
         fputs("\n", ((ndrx_debug_file_sink_t*)dbg_ptr->dbg_f_ptr)->fp);
         
         /* Handle some buffering... */
@@ -1409,9 +1473,9 @@ expublic void __ndrx_debug__(ndrx_debug_t *dbg_ptr, int lev, const char *file,
             
             len = strlen(memline->line);
             
-            va_start(ap, fmt);    
-            (void) vsnprintf(memline->line+len, sizeof(memline->line)-len, fmt, ap);
-            va_end(ap);
+            va_copy(ap2, ap);
+            (void) vsnprintf(memline->line+len, sizeof(memline->line)-len, fmt, ap2);
+            va_end(ap2);
             
             
             /* Add line to the logger */
@@ -1423,6 +1487,47 @@ expublic void __ndrx_debug__(ndrx_debug_t *dbg_ptr, int lev, const char *file,
     }
 }
 
+/**
+ * Print stuff to trace file, source location from the compiler
+ * @param dbg_ptr - debug conf
+ * @param lev - level
+ * @param file - source file (__FILE__)
+ * @param line - source line
+ * @param func - source func
+ * @param fmt - format
+ * @param ... - varargs
+ */
+expublic void __ndrx_debug__(ndrx_debug_t *dbg_ptr, int lev, const char *file, 
+        long line, const char *func, char *fmt, ...)
+{
+    va_list ap;
+    
+    va_start(ap, fmt);
+    ndrx_debug_va(dbg_ptr, lev, file, line, func, EXTRUE, fmt, ap);
+    va_end(ap);
+}
+
+/**
+ * Print stuff to trace file, source file name given by caller (*_LOGEX
+ * macros), i.e. it might not be a literal.
+ * @param dbg_ptr - debug conf
+ * @param lev - level
+ * @param file - source file
+ * @param line - source line
+ * @param func - source func
+ * @param fmt - format
+ * @param ... - varargs
+ */
+expublic void __ndrx_debugex__(ndrx_debug_t *dbg_ptr, int lev, const char *file, 
+        long line, const char *func, char *fmt, ...)
+{
+    va_list ap;
+    
+    va_start(ap, fmt);
+    ndrx_debug_va(dbg_ptr, lev, file, line, func, EXFALSE, fmt, ap);
+    va_end(ap);
+}
+
 /**
  * Initialize debug library
  * Currently default level is to use maximum.
@@ -0,0 +1,1384 @@
+/**
+ * @brief Binary trace log. With `binary=Y' the logger does not format the
+ *   lines, but writes compact records: format, file and function strings are
+ *   interned per file sink (written once as string records, referenced by id
+ *   later), arguments are written as raw 64 bit words, strings by length,
+ *   dumps as raw blobs. Text is produced off-line by ndrx_dbgbin_decode()
+ *   (`xadmin logdec'), in the same format as the text logger writes.
+ *
+ * @file ndebugbin.c
+ */
+/* -----------------------------------------------------------------------------
+ * Enduro/X Middleware Platform for Distributed Transaction Processing
+ * Copyright (C) 2009-2016, ATR Baltic, Ltd. All Rights Reserved.
+ * Copyright (C) 2017-2019, Mavimax, Ltd. All Rights Reserved.
+ * This software is released under one of the following licenses:
+ * AGPL (with Java and Go exceptions) or Mavimax's license for commercial use.
+ * See LICENSE file for full text.
+ * -----------------------------------------------------------------------------
+ * AGPL license:
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License, version 3 as published
+ * by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License, version 3
+ * for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * -----------------------------------------------------------------------------
+ * A commercial use license is available from Mavimax, Ltd
+ * contact@mavimax.com
+ * -----------------------------------------------------------------------------
+ */
+
+/*---------------------------Includes-----------------------------------*/
+#include <ndrx_config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include <sys/time.h>
+
+#include <ndrstandard.h>
+#include <ndebug.h>
+#include <nstdutil.h>
+#include <nstd_int.h>
+#include <exhash.h>
+/*---------------------------Externs------------------------------------*/
+/*---------------------------Macros-------------------------------------*/
+
+/* record sync, first byte NUL never appears in text logs */
+#define DBGBIN_SYNC0        0x00
+#define DBGBIN_SYNC1        0xEB
+#define DBGBIN_SYNC2        'N'
+#define DBGBIN_SYNC3        'B'
+
+#define DBGBIN_MAGIC        0x3154424eU /**< "NBT1"                           */
+#define DBGBIN_BYTEORD      0x0102      /**< detect other endian writers      */
+
+#define DBGBIN_REC_HDR      'H'     /**< session start, resets pid strings    */
+#define DBGBIN_REC_STR      'S'     /**< string definition                    */
+#define DBGBIN_REC_LOG      'L'     /**< log line                             */
+#define DBGBIN_REC_DUMP     'B'     /**< hex dump blob                        */
+#define DBGBIN_REC_DIFF     'D'     /**< hex dump diff, two blobs             */
+
+/* record prefix: sync[4] type[1] rsvd[3] len[4] pid[4] */
+#define DBGBIN_OFF_TYPE     4
+#define DBGBIN_OFF_LEN      8
+#define DBGBIN_OFF_PID      12
+#define DBGBIN_PFX_LEN      16
+
+/* header: magic[4] byteord[2] sizeof(long)[1] sizeof(void *)[1] */
+#define DBGBIN_HDR_LEN      (DBGBIN_PFX_LEN+8)
+/* string: id[4] text */
+#define DBGBIN_STR_LEN      (DBGBIN_PFX_LEN+4)
+
+/* log line body offsets (from the start of body) */
+#define DBGBIN_L_LEV        0   /**< [1] level                                */
+#define DBGBIN_L_CODE       1   /**< [1] logger code                          */
+#define DBGBIN_L_MODULE     2   /**< [4] module                               */
+#define DBGBIN_L_HOSTCRC    8   /**< [4] hostname crc32                       */
+#define DBGBIN_L_THREADNR   12  /**< [4] Enduro/X thread number               */
+#define DBGBIN_L_OSTID      16  /**< [8] OS thread id                         */
+#define DBGBIN_L_SEC        24  /**< [8] gettimeofday() seconds               */
+#define DBGBIN_L_USEC       32  /**< [4] gettimeofday() microseconds          */
+#define DBGBIN_L_LINE       36  /**< [4] source line                          */
+#define DBGBIN_L_FILE       40  /**< [4] file string id                       */
+#define DBGBIN_L_FUNC       44  /**< [4] function string id                   */
+#define DBGBIN_L_FMT        48  /**< [4] format string id                     */
+#define DBGBIN_L_ARGS       52  /**< arguments, 8 bytes each, strings by len  */
+#define DBGBIN_LOG_LEN      (DBGBIN_PFX_LEN+DBGBIN_L_ARGS)
+
+#define DBGBIN_BUFSZ        4096        /**< line encode buffer, more -> text */
+#define DBGBIN_TLSBUFSZ     (DBGBIN_BUFSZ*2) /**< thread staging buffer      */
+#define DBGBIN_MAXARGS      64          /**< max conversions in format        */
+#define DBGBIN_MAXSTRS      65536       /**< restart session when reached     */
+#define DBGBIN_MAXREC       0x40000000  /**< max record accepted (1GB)        */
+#define DBGBIN_NULLSTR      0xffffffffU /**< string len for NULL ptr          */
+#define DBGBIN_NOTPARSED    -2          /**< format signature not parsed yet  */
+#define DBGBIN_SPECSZ       64          /**< max single conversion spec len   */
+
+#define DBGBIN_PREC_NONE    -1          /**< no string precision              */
+#define DBGBIN_PREC_STAR    -2          /**< string precision from arg        */
+
+#define DBGBIN_PUT(P, V)    memcpy((P), &(V), sizeof(V))
+#define DBGBIN_GET(V, P)    memcpy(&(V), (P), sizeof(V))
+
+/**
+ * Add argument to signature
+ */
+#define DBGBIN_ADD_ARG(T, PREC) do {\
+        if (n>=maxargs)\
+        {\
+            return EXFAIL;\
+        }\
+        args[n].type = (T);\
+        args[n].prec = (PREC);\
+        n++;\
+    } while (0)
+
+/**
+ * Print single conversion with star width/precision args
+ */
+#define DBGBIN_FPRINTF(V) do {\
+        if (0==nstars)\
+        {\
+            fprintf(out, spec, V);\
+        }\
+        else if (1==nstars)\
+        {\
+            fprintf(out, spec, st[0], V);\
+        }\
+        else\
+        {\
+            fprintf(out, spec, st[0], st[1], V);\
+        }\
+    } while (0)
+
+/*---------------------------Enums--------------------------------------*/
+
+/**
+ * Argument word types (C types after default promotion)
+ */
+enum
+{
+    DBGBIN_ARG_INT = 1,
+    DBGBIN_ARG_LONG,
+    DBGBIN_ARG_LLONG,
+    DBGBIN_ARG_SIZE,
+    DBGBIN_ARG_IMAX,
+    DBGBIN_ARG_PTRDIFF,
+    DBGBIN_ARG_DBL,
+    DBGBIN_ARG_LDBL,
+    DBGBIN_ARG_PTR,
+    DBGBIN_ARG_STR
+};
+
+/*---------------------------Typedefs-----------------------------------*/
+
+/**
+ * Format argument
+ */
+typedef struct
+{
+    char type;      /**< DBGBIN_ARG_*                                       */
+    int prec;       /**< string precision or DBGBIN_PREC_NONE/STAR          */
+} ndrx_dbgbin_arg_t;
+
+/**
+ * Interned string. Writer hashes by call site pointer, decoder by
+ * pid and string id.
+ */
+typedef struct
+{
+    const char *key;            /**< writer: string address                 */
+    uint64_t dkey;              /**< decoder: pid << 32 | id                */
+    uint32_t id;                /**< string id in the session               */
+    int nargs;                  /**< format args, EXFAIL - not supported    */
+    ndrx_dbgbin_arg_t *args;    /**< format signature                       */
+    char *str;                  /**< string copy                            */
+    EX_hash_handle hh;          /**< makes this structure hashable          */
+} ndrx_dbgbin_str_t;
+
+/*---------------------------Globals------------------------------------*/
+/*---------------------------Statics------------------------------------*/
+exprivate unsigned char M_sync[] = {DBGBIN_SYNC0, DBGBIN_SYNC1, 
+                                    DBGBIN_SYNC2, DBGBIN_SYNC3};
+
+/**
+ * Thread staging buffer: session header, new string definitions and the
+ * record are encoded here and are passed to the sink with one fwrite()
+ */
+exprivate __thread char M_recbuf[DBGBIN_TLSBUFSZ];
+/*---------------------------Prototypes---------------------------------*/
+
+/**
+ * Parse printf format into argument signature
+ * @param fmt format string
+ * @param args output signature
+ * @param maxargs signature size
+ * @return number of args or EXFAIL if format cannot be deferred
+ *  (%n, %m, wide chars, too many args)
+ */
+exprivate int dbgbin_parse_fmt(const char *fmt, ndrx_dbgbin_arg_t *args, int maxargs)
+{
+    const char *p = fmt;
+    int n = 0;
+    int lmod;
+    int is_ldbl;
+    int prec;
+    
+    while (EXEOS!=*p)
+    {
+        if ('%'!=*p++)
+        {
+            continue;
+        }
+        
+        if ('%'==*p)
+        {
+            p++;
+            continue;
+        }
+        
+        /* flags */
+        while (EXEOS!=*p && NULL!=strchr("-+ #0'", *p))
+        {
+            p++;
+        }
+        
+        /* width */
+        if ('*'==*p)
+        {
+            DBGBIN_ADD_ARG(DBGBIN_ARG_INT, DBGBIN_PREC_NONE);
+            p++;
+        }
+        else
+        {
+            while (isdigit((unsigned char)*p))
+            {
+                p++;
+            }
+        }
+        
+        /* precision */
+        prec = DBGBIN_PREC_NONE;
+        
+        if ('.'==*p)
+        {
+            p++;
+            
+            if ('*'==*p)
+            {
+                DBGBIN_ADD_ARG(DBGBIN_ARG_INT, DBGBIN_PREC_NONE);
+                prec = DBGBIN_PREC_STAR;
+                p++;
+            }
+            else
+            {
+                prec = 0;
+                while (isdigit((unsigned char)*p))
+                {
+                    prec = prec*10 + (*p - '0');
+                    p++;
+                }
+            }
+        }
+        
+        /* length modifier */
+        lmod = DBGBIN_ARG_INT;
+        is_ldbl = EXFALSE;
+        
+        switch (*p)
+        {
+            case 'h':
+                p++;
+                if ('h'==*p)
+                {
+                    p++;
+                }
+                break;
+            case 'l':
+                p++;
+                if ('l'==*p)
+                {
+                    p++;
+                    lmod = DBGBIN_ARG_LLONG;
+                }
+                else
+                {
+                    lmod = DBGBIN_ARG_LONG;
+                }
+                break;
+            case 'L':
+                is_ldbl = EXTRUE;
+                /*@fallthrough@*/
+            case 'q':
+                p++;
+                lmod = DBGBIN_ARG_LLONG;
+                break;
+            case 'j':
+                p++;
+                lmod = DBGBIN_ARG_IMAX;
+                break;
+            case 'z':
+                p++;
+                lmod = DBGBIN_ARG_SIZE;
+                break;
+            case 't':
+                p++;
+                lmod = DBGBIN_ARG_PTRDIFF;
+                break;
+        }
+        
+        /* conversion */
+        switch (*p)
+        {
+            case 'd':
+            case 'i':
+            case 'o':
+            case 'u':
+            case 'x':
+            case 'X':
+                DBGBIN_ADD_ARG(lmod, DBGBIN_PREC_NONE);
+                break;
+            case 'c':
+                if (DBGBIN_ARG_INT!=lmod)
+                {
+                    return EXFAIL;
+                }
+                DBGBIN_ADD_ARG(DBGBIN_ARG_INT, DBGBIN_PREC_NONE);
+                break;
+            case 'e':
+            case 'E':
+            case 'f':
+            case 'F':
+            case 'g':
+            case 'G':
+            case 'a':
+            case 'A':
+                DBGBIN_ADD_ARG((is_ldbl?DBGBIN_ARG_LDBL:DBGBIN_ARG_DBL), 
+                        DBGBIN_PREC_NONE);
+                break;
+            case 's':
+                if (DBGBIN_ARG_INT!=lmod)
+                {
+                    return EXFAIL;
+                }
+                DBGBIN_ADD_ARG(DBGBIN_ARG_STR, prec);
+                break;
+            case 'p':
+                DBGBIN_ADD_ARG(DBGBIN_ARG_PTR, DBGBIN_PREC_NONE);
+                break;
+            default:
+                /* %n, %m, wide and unknown conversions go as text */
+                return EXFAIL;
+        }
+        
+        p++;
+    }
+    
+    return n;
+}
+
+/**
+ * Resolve format signature of the interned string
+ * @param ent string entry
+ */
+exprivate void dbgbin_str_sig(ndrx_dbgbin_str_t *ent)
+{
+    ndrx_dbgbin_arg_t args[DBGBIN_MAXARGS];
+    int n = dbgbin_parse_fmt(ent->str, args, N_DIM(args));
+    
+    if (n > 0)
+    {
+        if (NULL==(ent->args = NDRX_MALLOC(sizeof(ndrx_dbgbin_arg_t)*n)))
+        {
+            n = EXFAIL;
+        }
+        else
+        {
+            memcpy(ent->args, args, sizeof(ndrx_dbgbin_arg_t)*n);
+        }
+    }
+    
+    ent->nargs = n;
+}
+
+/**
+ * Allocate string entry
+ * @param str string
+ * @param len string len
+ * @return entry or NULL (OOM)
+ */
+exprivate ndrx_dbgbin_str_t *dbgbin_str_new(const char *str, size_t len)
+{
+    ndrx_dbgbin_str_t *ent = NDRX_MALLOC(sizeof(ndrx_dbgbin_str_t) + len + 1);
+    
+    if (NULL!=ent)
+    {
+        memset(ent, 0, sizeof(ndrx_dbgbin_str_t));
+        ent->str = (char *)(ent+1);
+        memcpy(ent->str, str, len);
+        ent->str[len] = EXEOS;
+        ent->nargs = DBGBIN_NOTPARSED;
+    }
+    
+    return ent;
+}
+
+/**
+ * Free string entry
+ * @param ent entry
+ */
+exprivate void dbgbin_str_free(ndrx_dbgbin_str_t *ent)
+{
+    if (NULL!=ent->args)
+    {
+        NDRX_FREE(ent->args);
+    }
+    
+    NDRX_FREE(ent);
+}
+
+/**
+ * Fill record prefix
+ * @param buf record start
+ * @param type record type
+ * @param len full record len
+ * @param pid writer pid
+ */
+exprivate void dbgbin_prefix(char *buf, char type, uint32_t len, uint32_t pid)
+{
+    memcpy(buf, M_sync, sizeof(M_sync));
+    buf[DBGBIN_OFF_TYPE] = type;
+    buf[DBGBIN_OFF_TYPE+1] = buf[DBGBIN_OFF_TYPE+2] = buf[DBGBIN_OFF_TYPE+3] = 0;
+    DBGBIN_PUT(buf+DBGBIN_OFF_LEN, len);
+    DBGBIN_PUT(buf+DBGBIN_OFF_PID, pid);
+}
+
+/**
+ * Drop interned strings of the sink. Called when file is (re)opened, closed
+ * or new session is started. Caller must exclude writers.
+ * @param sink file sink
+ */
+expublic void ndrx_dbgbin_sink_reset(ndrx_debug_file_sink_t *sink)
+{
+    ndrx_dbgbin_str_t *strs = (ndrx_dbgbin_str_t *)sink->bin_strs;
+    ndrx_dbgbin_str_t *el, *elt;
+    
+    EXHASH_ITER(hh, strs, el, elt)
+    {
+        EXHASH_DEL(strs, el);
+        dbgbin_str_free(el);
+    }
+    
+    sink->bin_strs = NULL;
+    sink->bin_nextid = 0;
+    sink->bin_pid = 0;
+}
+
+/**
+ * Write staged part of the thread buffer to the sink. On failure the
+ * strings are dropped (their definitions might be lost), next write
+ * starts new session.
+ * @param sink file sink
+ * @param p staging position, reset to buffer start
+ * @return EXSUCCEED/EXFAIL
+ */
+exprivate int dbgbin_flush(ndrx_debug_file_sink_t *sink, char **p)
+{
+    int ret = EXSUCCEED;
+    
+    if (*p > M_recbuf && 1!=fwrite(M_recbuf, *p-M_recbuf, 1, sink->fp))
+    {
+        ndrx_dbgbin_sink_reset(sink);
+        ret = EXFAIL;
+    }
+    
+    *p = M_recbuf;
+    
+    return ret;
+}
+
+/**
+ * Start new session in the sink: drop strings, stage header record.
+ * This is the only point where interned strings are dropped, thus
+ * addresses are re-verified here. Called with file locked.
+ * @param sink file sink
+ * @param pid writer pid
+ * @param p staging position (at buffer start), advanced
+ */
+exprivate void dbgbin_session(ndrx_debug_file_sink_t *sink, pid_t pid, char **p)
+{
+    char *buf = *p;
+    uint32_t magic = DBGBIN_MAGIC;
+    uint16_t byteord = DBGBIN_BYTEORD;
+    
+    ndrx_dbgbin_sink_reset(sink);
+    
+    dbgbin_prefix(buf, DBGBIN_REC_HDR, DBGBIN_HDR_LEN, (uint32_t)pid);
+    DBGBIN_PUT(buf+DBGBIN_PFX_LEN, magic);
+    DBGBIN_PUT(buf+DBGBIN_PFX_LEN+4, byteord);
+    buf[DBGBIN_PFX_LEN+6] = (char)sizeof(long);
+    buf[DBGBIN_PFX_LEN+7] = (char)sizeof(void *);
+    
+    *p+=DBGBIN_HDR_LEN;
+    sink->bin_pid = pid;
+}
+
+/**
+ * Get string id, stage the definition record on first use. Strings are
+ * hashed by address: format, __FILE__ and __func__ are literals, thus
+ * the text is not compared on the hit, the session reset drops the table.
+ * Caller provided (non-literal) strings are verified by text.
+ * Called with file locked.
+ * @param sink file sink
+ * @param str string to intern
+ * @param verify compare text on the hit
+ * @param p staging position, advanced
+ * @return string entry or NULL on failure
+ */
+exprivate ndrx_dbgbin_str_t *dbgbin_intern(ndrx_debug_file_sink_t *sink, 
+        const char *str, int verify, char **p)
+{
+    ndrx_dbgbin_str_t *strs = (ndrx_dbgbin_str_t *)sink->bin_strs;
+    ndrx_dbgbin_str_t *ent = NULL;
+    size_t len;
+    
+    EXHASH_FIND_PTR(strs, &str, ent);
+    
+    if (NULL!=ent)
+    {
+        if (!verify || 0==strcmp(ent->str, str))
+        {
+            goto out;
+        }
+        
+        /* address reused for other text */
+        EXHASH_DEL(strs, ent);
+        dbgbin_str_free(ent);
+        ent = NULL;
+    }
+    
+    len = strlen(str);
+    
+    if (len > DBGBIN_BUFSZ-DBGBIN_STR_LEN)
+    {
+        goto out;
+    }
+    
+    if (M_recbuf+DBGBIN_TLSBUFSZ-*p < (long)(DBGBIN_STR_LEN+len) &&
+            EXSUCCEED!=dbgbin_flush(sink, p))
+    {
+        goto out;
+    }
+    
+    if (NULL==(ent = dbgbin_str_new(str, len)))
+    {
+        goto out;
+    }
+    
+    ent->key = str;
+    ent->id = sink->bin_nextid++;
+    
+    dbgbin_prefix(*p, DBGBIN_REC_STR, (uint32_t)(DBGBIN_STR_LEN+len), 
+            (uint32_t)sink->bin_pid);
+    DBGBIN_PUT(*p+DBGBIN_PFX_LEN, ent->id);
+    memcpy(*p+DBGBIN_STR_LEN, str, len);
+    *p+=DBGBIN_STR_LEN+len;
+    
+    EXHASH_ADD_PTR(strs, key, ent);
+    
+out:
+    sink->bin_strs = strs;
+    return ent;
+}
+
+/**
+ * Write log line as binary record. The text is not formatted, arguments are
+ * taken by format signature (parsed once per format string) and are
+ * written as raw words. The record, with new string definitions, is built
+ * in the thread buffer and goes to the sink with one fwrite().
+ * Caller holds logger lock (ndrx_debug_lock()).
+ * @param dbg_ptr logger
+ * @param lev log level
+ * @param file source file
+ * @param file_lit file is literal (__FILE__), else verified by text
+ * @param line source line
+ * @param func source function
+ * @param ostid OS thread id
+ * @param thread_nr Enduro/X thread number
+ * @param fmt format string
+ * @param ap format arguments
+ * @return EXSUCCEED or EXFAIL if line shall be written as text (format not 
+ *  supported or line too long)
+ */
+expublic int ndrx_dbgbin_log(ndrx_debug_t *dbg_ptr, int lev, const char *file, 
+        int file_lit, long line, const char *func, uint64_t ostid, long thread_nr, 
+        char *fmt, va_list ap)
+{
+    int ret = EXSUCCEED;
+    ndrx_debug_file_sink_t *sink = (ndrx_debug_file_sink_t *)dbg_ptr->dbg_f_ptr;
+    char *buf = NULL;
+    char *body;
+    char *p = M_recbuf;
+    char *end;
+    ndrx_dbgbin_str_t *fmt_e;
+    ndrx_dbgbin_str_t *file_e;
+    ndrx_dbgbin_str_t *func_e;
+    struct timeval tv;
+    long long last_int = EXFAIL;
+    int64_t i64 = 0;
+    uint64_t u64;
+    uint32_t u32;
+    double dbl;
+    char *s;
+    int i;
+    
+    gettimeofday(&tv, NULL);
+    
+    flockfile(sink->fp);
+    
+    if (sink->bin_pid!=dbg_ptr->pid || sink->bin_nextid > DBGBIN_MAXSTRS)
+    {
+        dbgbin_session(sink, dbg_ptr->pid, &p);
+    }
+    
+    if (NULL==(fmt_e = dbgbin_intern(sink, fmt, EXFALSE, &p)))
+    {
+        EXFAIL_OUT(ret);
+    }
+    
+    if (DBGBIN_NOTPARSED==fmt_e->nargs)
+    {
+        dbgbin_str_sig(fmt_e);
+    }
+    
+    if (EXFAIL==fmt_e->nargs || 
+            NULL==(file_e = dbgbin_intern(sink, file, !file_lit, &p)) ||
+            NULL==(func_e = dbgbin_intern(sink, func, EXFALSE, &p)))
+    {
+        EXFAIL_OUT(ret);
+    }
+    
+    /* record follows the staged definitions, DBGBIN_BUFSZ max */
+    if (M_recbuf+DBGBIN_TLSBUFSZ-p < DBGBIN_BUFSZ && 
+            EXSUCCEED!=dbgbin_flush(sink, &p))
+    {
+        EXFAIL_OUT(ret);
+    }
+    
+    buf = p;
+    body = buf+DBGBIN_PFX_LEN;
+    end = buf+DBGBIN_BUFSZ;
+    p = buf+DBGBIN_LOG_LEN;
+    
+    for (i=0; i<fmt_e->nargs; i++)
+    {
+        switch (fmt_e->args[i].type)
+        {
+            case DBGBIN_ARG_STR:
+                
+                s = va_arg(ap, char *);
+                
+                if (NULL==s)
+                {
+                    u32 = DBGBIN_NULLSTR;
+                }
+                else if (fmt_e->args[i].prec >= 0)
+                {
+                    u32 = (uint32_t)strnlen(s, fmt_e->args[i].prec);
+                }
+                else if (DBGBIN_PREC_STAR==fmt_e->args[i].prec && last_int >= 0)
+                {
+                    u32 = (uint32_t)strnlen(s, (size_t)last_int);
+                }
+                else
+                {
+                    u32 = (uint32_t)strlen(s);
+                }
+                
+                if (end - p < (long)sizeof(u32) + 
+                        (DBGBIN_NULLSTR==u32 ? 0 : (long)u32))
+                {
+                    EXFAIL_OUT(ret);
+                }
+                
+                DBGBIN_PUT(p, u32);
+                p+=sizeof(u32);
+                
+                if (DBGBIN_NULLSTR!=u32)
+                {
+                    memcpy(p, s, u32);
+                    p+=u32;
+                }
+                
+                continue;
+            case DBGBIN_ARG_INT:
+                i64 = va_arg(ap, int);
+                last_int = i64;
+                break;
+            case DBGBIN_ARG_LONG:
+                i64 = va_arg(ap, long);
+                break;
+            case DBGBIN_ARG_LLONG:
+                i64 = va_arg(ap, long long);
+                break;
+            case DBGBIN_ARG_SIZE:
+                i64 = (int64_t)va_arg(ap, size_t);
+                break;
+            case DBGBIN_ARG_IMAX:
+                i64 = (int64_t)va_arg(ap, intmax_t);
+                break;
+            case DBGBIN_ARG_PTRDIFF:
+                i64 = (int64_t)va_arg(ap, ptrdiff_t);
+                break;
+            case DBGBIN_ARG_DBL:
+                dbl = va_arg(ap, double);
+                memcpy(&i64, &dbl, sizeof(i64));
+                break;
+            case DBGBIN_ARG_LDBL:
+                /* precision above double is lost */
+                dbl = (double)va_arg(ap, long double);
+                memcpy(&i64, &dbl, sizeof(i64));
+                break;
+            case DBGBIN_ARG_PTR:
+                i64 = (int64_t)(uintptr_t)va_arg(ap, void *);
+                break;
+        }
+        
+        if (end - p < (long)sizeof(i64))
+        {
+            EXFAIL_OUT(ret);
+        }
+        
+        DBGBIN_PUT(p, i64);
+        p+=sizeof(i64);
+    }
+    
+    dbgbin_prefix(buf, DBGBIN_REC_LOG, (uint32_t)(p-buf), (uint32_t)dbg_ptr->pid);
+    
+    body[DBGBIN_L_LEV] = (char)lev;
+    body[DBGBIN_L_CODE] = dbg_ptr->code;
+    memcpy(body+DBGBIN_L_MODULE, dbg_ptr->module, NDRX_LOG_MODULE_LEN);
+    body[DBGBIN_L_MODULE+NDRX_LOG_MODULE_LEN] = 0;
+    body[DBGBIN_L_MODULE+NDRX_LOG_MODULE_LEN+1] = 0;
+    u32 = (uint32_t)dbg_ptr->hostnamecrc32;
+    DBGBIN_PUT(body+DBGBIN_L_HOSTCRC, u32);
+    u32 = (uint32_t)thread_nr;
+    DBGBIN_PUT(body+DBGBIN_L_THREADNR, u32);
+    DBGBIN_PUT(body+DBGBIN_L_OSTID, ostid);
+    u64 = (uint64_t)tv.tv_sec;
+    DBGBIN_PUT(body+DBGBIN_L_SEC, u64);
+    u32 = (uint32_t)tv.tv_usec;
+    DBGBIN_PUT(body+DBGBIN_L_USEC, u32);
+    u32 = (uint32_t)line;
+    DBGBIN_PUT(body+DBGBIN_L_LINE, u32);
+    DBGBIN_PUT(body+DBGBIN_L_FILE, file_e->id);
+    DBGBIN_PUT(body+DBGBIN_L_FUNC, func_e->id);
+    DBGBIN_PUT(body+DBGBIN_L_FMT, fmt_e->id);
+    
+out:
+    /* string definitions are in the table already, thus written also if 
+     * the line goes as text */
+    if (EXSUCCEED!=ret && NULL!=buf)
+    {
+        p = buf;
+    }
+    
+    if (EXSUCCEED!=dbgbin_flush(sink, &p))
+    {
+        ret = EXFAIL;
+    }
+    
+    funlockfile(sink->fp);
+    
+    return ret;
+}
+
+/**
+ * Write hex dump data as raw blob. Decoder prints it in the same layout as
+ * text logger does. Caller holds logger lock (ndrx_debug_lock()).
+ * @param dbg_ptr logger
+ * @param ptr data
+ * @param ptr2 second data for diff dump, or NULL for plain dump
+ * @param len data len (each)
+ * @return EXSUCCEED/EXFAIL (dump shall be written as text)
+ */
+expublic int ndrx_dbgbin_dump(ndrx_debug_t *dbg_ptr, void *ptr, void *ptr2, long len)
+{
+    int ret = EXSUCCEED;
+    ndrx_debug_file_sink_t *sink = (ndrx_debug_file_sink_t *)dbg_ptr->dbg_f_ptr;
+    char *p = M_recbuf;
+    long reclen = DBGBIN_PFX_LEN + (NULL==ptr2 ? len : len*2);
+    
+    if (len < 0 || reclen > DBGBIN_MAXREC)
+    {
+        return EXFAIL;
+    }
+    
+    flockfile(sink->fp);
+    
+    if (sink->bin_pid!=dbg_ptr->pid)
+    {
+        dbgbin_session(sink, dbg_ptr->pid, &p);
+    }
+    
+    dbgbin_prefix(p, (NULL==ptr2 ? DBGBIN_REC_DUMP : DBGBIN_REC_DIFF), 
+            (uint32_t)reclen, (uint32_t)dbg_ptr->pid);
+    p+=DBGBIN_PFX_LEN;
+    
+    /* small dumps go with one write, large ones after the header */
+    if (M_recbuf+DBGBIN_TLSBUFSZ-p >= reclen-DBGBIN_PFX_LEN)
+    {
+        memcpy(p, ptr, len);
+        p+=len;
+        
+        if (NULL!=ptr2)
+        {
+            memcpy(p, ptr2, len);
+            p+=len;
+        }
+        
+        if (EXSUCCEED!=dbgbin_flush(sink, &p))
+        {
+            EXFAIL_OUT(ret);
+        }
+    }
+    else if (EXSUCCEED!=dbgbin_flush(sink, &p) ||
+            1!=fwrite(ptr, len, 1, sink->fp) ||
+            (NULL!=ptr2 && 1!=fwrite(ptr2, len, 1, sink->fp)))
+    {
+        EXFAIL_OUT(ret);
+    }
+    
+out:
+    funlockfile(sink->fp);
+    
+    return ret;
+}
+
+/**
+ * Build one hex dump line, as text logger prints it
+ * @param line output buffer (at least 128 bytes)
+ * @param p data of the line
+ * @param off line offset in dump
+ * @param cnt bytes in the line (1..16)
+ */
+exprivate void dbgbin_dump_line(char *line, unsigned char *p, long off, long cnt)
+{
+    char asc[17];
+    int n;
+    int i;
+    
+    n = sprintf(line, "  %04x ", (unsigned)off);
+    
+    for (i=0; i<16; i++)
+    {
+        if (i<cnt)
+        {
+            n+=sprintf(line+n, " %02x", p[i]);
+            asc[i] = ((p[i] < 0x20) || (p[i] > 0x7e)) ? '.' : (char)p[i];
+        }
+        else
+        {
+            n+=sprintf(line+n, "   ");
+        }
+    }
+    
+    asc[cnt] = EXEOS;
+    sprintf(line+n, "  %s", asc);
+}
+
+/**
+ * Print hex dump or dump diff of the blob
+ * @param out output stream
+ * @param p data
+ * @param p2 second data for diff or NULL
+ * @param len data len
+ */
+exprivate void dbgbin_dec_dump(FILE *out, unsigned char *p, unsigned char *p2, 
+        long len)
+{
+    char line[128];
+    char line2[128];
+    long off;
+    long cnt;
+    
+    for (off=0; off<len; off+=16)
+    {
+        cnt = (len - off > 16 ? 16 : len - off);
+        
+        dbgbin_dump_line(line, p+off, off, cnt);
+        
+        if (NULL==p2)
+        {
+            fprintf(out, "%s\n", line);
+        }
+        else
+        {
+            dbgbin_dump_line(line2, p2+off, off, cnt);
+            
+            if (0!=strcmp(line, line2))
+            {
+                fprintf(out, "<%s\n>%s\n", line, line2);
+            }
+        }
+    }
+}
+
+/**
+ * Read next argument word
+ * @param cur data cursor
+ * @param end data end
+ * @param v output value
+ * @return EXSUCCEED/EXFAIL (truncated)
+ */
+exprivate int dbgbin_dec_word(char **cur, char *end, int64_t *v)
+{
+    if (end - *cur < (long)sizeof(*v))
+    {
+        return EXFAIL;
+    }
+    
+    DBGBIN_GET(*v, *cur);
+    *cur+=sizeof(*v);
+    
+    return EXSUCCEED;
+}
+
+/**
+ * Format the line from format string and argument words
+ * @param fmt_e format string entry (with signature)
+ * @param cur argument data
+ * @param end argument data end
+ * @param out output stream
+ * @return EXSUCCEED/EXFAIL (arguments do not match)
+ */
+exprivate int dbgbin_dec_format(ndrx_dbgbin_str_t *fmt_e, char *cur, char *end, 
+        FILE *out)
+{
+    int ret = EXSUCCEED;
+    const char *p = fmt_e->str;
+    const char *start;
+    char spec[DBGBIN_SPECSZ];
+    char *s = NULL;
+    int nstars;
+    int st[2];
+    int k = 0;
+    int64_t v;
+    double dbl;
+    uint32_t slen;
+    
+    while (EXEOS!=*p)
+    {
+        if ('%'!=*p)
+        {
+            fputc(*p, out);
+            p++;
+            continue;
+        }
+        
+        if ('%'==p[1])
+        {
+            fputc('%', out);
+            p+=2;
+            continue;
+        }
+        
+        start = p++;
+        nstars = 0;
+        
+        /* up to conversion, signature is already validated */
+        while (NULL==strchr("diouxXcfFeEgGaAsp", *p))
+        {
+            if ('*'==*p)
+            {
+                if (k>=fmt_e->nargs || nstars>=2 || 
+                        EXSUCCEED!=dbgbin_dec_word(&cur, end, &v))
+                {
+                    EXFAIL_OUT(ret);
+                }
+                st[nstars++] = (int)v;
+                k++;
+            }
+            p++;
+        }
+        
+        if (EXEOS==*p || p+1-start >= (long)sizeof(spec) || k>=fmt_e->nargs)
+        {
+            EXFAIL_OUT(ret);
+        }
+        
+        p++;
+        memcpy(spec, start, p-start);
+        spec[p-start] = EXEOS;
+        
+        if (DBGBIN_ARG_STR==fmt_e->args[k].type)
+        {
+            if (end - cur < (long)sizeof(slen))
+            {
+                EXFAIL_OUT(ret);
+            }
+            
+            DBGBIN_GET(slen, cur);
+            cur+=sizeof(slen);
+            
+            if (DBGBIN_NULLSTR==slen)
+            {
+                s = NULL;
+            }
+            else
+            {
+                if (end - cur < (long)slen || NULL==(s = NDRX_MALLOC(slen+1)))
+                {
+                    EXFAIL_OUT(ret);
+                }
+                
+                memcpy(s, cur, slen);
+                s[slen] = EXEOS;
+                cur+=slen;
+            }
+            
+            DBGBIN_FPRINTF(s);
+            
+            if (NULL!=s)
+            {
+                NDRX_FREE(s);
+                s = NULL;
+            }
+        }
+        else
+        {
+            if (EXSUCCEED!=dbgbin_dec_word(&cur, end, &v))
+            {
+                EXFAIL_OUT(ret);
+            }
+            
+            switch (fmt_e->args[k].type)
+            {
+                case DBGBIN_ARG_INT:
+                    DBGBIN_FPRINTF((int)v);
+                    break;
+                case DBGBIN_ARG_LONG:
+                    DBGBIN_FPRINTF((long)v);
+                    break;
+                case DBGBIN_ARG_LLONG:
+                    DBGBIN_FPRINTF((long long)v);
+                    break;
+                case DBGBIN_ARG_SIZE:
+                    DBGBIN_FPRINTF((size_t)v);
+                    break;
+                case DBGBIN_ARG_IMAX:
+                    DBGBIN_FPRINTF((intmax_t)v);
+                    break;
+                case DBGBIN_ARG_PTRDIFF:
+                    DBGBIN_FPRINTF((ptrdiff_t)v);
+                    break;
+                case DBGBIN_ARG_DBL:
+                    memcpy(&dbl, &v, sizeof(dbl));
+                    DBGBIN_FPRINTF(dbl);
+                    break;
+                case DBGBIN_ARG_LDBL:
+                    memcpy(&dbl, &v, sizeof(dbl));
+                    DBGBIN_FPRINTF((long double)dbl);
+                    break;
+                case DBGBIN_ARG_PTR:
+                    DBGBIN_FPRINTF((void *)(uintptr_t)v);
+                    break;
+            }
+        }
+        
+        k++;
+    }
+    
+out:
+    return ret;
+}
+
+/**
+ * Lookup string by pid and id
+ * @param strs decoder string hash
+ * @param pid writer pid
+ * @param id string id
+ * @return string entry or NULL
+ */
+exprivate ndrx_dbgbin_str_t *dbgbin_dec_str(ndrx_dbgbin_str_t *strs, 
+        uint32_t pid, uint32_t id)
+{
+    ndrx_dbgbin_str_t *ent = NULL;
+    uint64_t dkey = ((uint64_t)pid << 32) | id;
+    
+    EXHASH_FIND(hh, strs, &dkey, sizeof(dkey), ent);
+    
+    return ent;
+}
+
+/**
+ * Print log line record
+ * @param strs decoder strings
+ * @param pid writer pid
+ * @param body record body
+ * @param len body len
+ * @param out output stream
+ */
+exprivate void dbgbin_dec_log(ndrx_dbgbin_str_t *strs, uint32_t pid, 
+        char *body, long len, FILE *out)
+{
+    char module[NDRX_LOG_MODULE_LEN+1];
+    ndrx_dbgbin_str_t *file_e;
+    ndrx_dbgbin_str_t *func_e;
+    ndrx_dbgbin_str_t *fmt_e;
+    uint32_t hostcrc;
+    uint32_t thread_nr;
+    uint64_t ostid;
+    uint64_t sec;
+    uint32_t usec;
+    uint32_t line;
+    uint32_t id;
+    char *file;
+    char *func;
+    size_t slen;
+    struct tm stm;
+    time_t t;
+    
+    if (len < DBGBIN_L_ARGS)
+    {
+        fprintf(out, "*** logdec: truncated log record of pid %u\n", 
+                (unsigned)pid);
+        return;
+    }
+    
+    memcpy(module, body+DBGBIN_L_MODULE, NDRX_LOG_MODULE_LEN);
+    module[NDRX_LOG_MODULE_LEN] = EXEOS;
+    DBGBIN_GET(hostcrc, body+DBGBIN_L_HOSTCRC);
+    DBGBIN_GET(thread_nr, body+DBGBIN_L_THREADNR);
+    DBGBIN_GET(ostid, body+DBGBIN_L_OSTID);
+    DBGBIN_GET(sec, body+DBGBIN_L_SEC);
+    DBGBIN_GET(usec, body+DBGBIN_L_USEC);
+    DBGBIN_GET(line, body+DBGBIN_L_LINE);
+    
+    DBGBIN_GET(id, body+DBGBIN_L_FILE);
+    file_e = dbgbin_dec_str(strs, pid, id);
+    DBGBIN_GET(id, body+DBGBIN_L_FUNC);
+    func_e = dbgbin_dec_str(strs, pid, id);
+    DBGBIN_GET(id, body+DBGBIN_L_FMT);
+    fmt_e = dbgbin_dec_str(strs, pid, id);
+    
+    file = (NULL!=file_e ? file_e->str : "?");
+    func = (NULL!=func_e ? func_e->str : "?");
+    
+    if ((slen=strlen(file)) > 8)
+    {
+        file+=slen-8;
+    }
+    
+    if ((slen=strlen(func)) > 12)
+    {
+        func+=slen-12;
+    }
+    
+    t = (time_t)sec;
+    localtime_r(&t, &stm);
+    
+    fprintf(out, 
+        "%c:%s:%d:%08x:%05d:%08llx:%03ld:%08ld:%06ld%06d:%-12.12s:%-8.8s:%04ld:",
+        body[DBGBIN_L_CODE], module, (int)body[DBGBIN_L_LEV], (unsigned int)hostcrc, 
+        (int)pid, (unsigned long long)ostid, (long)thread_nr, 
+        10000L*(1900 + stm.tm_year)+100*(1+stm.tm_mon)+1*(stm.tm_mday),
+        10000L*stm.tm_hour+100*stm.tm_min+1*stm.tm_sec,
+        (int)usec, func, file, (long)line);
+    
+    if (NULL==fmt_e)
+    {
+        fprintf(out, "*** logdec: missing format string %u", (unsigned)id);
+    }
+    else
+    {
+        if (DBGBIN_NOTPARSED==fmt_e->nargs)
+        {
+            dbgbin_str_sig(fmt_e);
+        }
+        
+        if (EXFAIL==fmt_e->nargs || EXSUCCEED!=dbgbin_dec_format(fmt_e, 
+                body+DBGBIN_L_ARGS, body+len, out))
+        {
+            fprintf(out, "*** logdec: arguments do not match format [%s]", 
+                    fmt_e->str);
+        }
+    }
+    
+    fputs("\n", out);
+}
+
+/**
+ * Decode binary trace file to the text log format. Text found between the
+ * records (early in-memory log, lines that did not fit in binary record)
+ * is copied as is.
+ * @param in binary trace stream
+ * @param out text output
+ * @return EXSUCCEED/EXFAIL (file written on other platform, or OOM)
+ */
+expublic int ndrx_dbgbin_decode(FILE *in, FILE *out)
+{
+    int ret = EXSUCCEED;
+    ndrx_dbgbin_str_t *strs = NULL;
+    ndrx_dbgbin_str_t *ent, *elt;
+    char pfx[DBGBIN_PFX_LEN];
+    char *rec = NULL;
+    long recsz = 0;
+    uint32_t len;
+    uint32_t pid;
+    uint32_t id;
+    uint32_t magic;
+    uint16_t byteord;
+    int c;
+    int i;
+    
+    while (EOF!=(c=fgetc(in)))
+    {
+        if (DBGBIN_SYNC0!=c)
+        {
+            fputc(c, out);
+            continue;
+        }
+        
+        /* match the rest of sync */
+        for (i=1; i<(int)sizeof(M_sync); i++)
+        {
+            if (M_sync[i]!=(c=fgetc(in)))
+            {
+                break;
+            }
+        }
+        
+        if (i<(int)sizeof(M_sync))
+        {
+            /* not a record, give out what was consumed */
+            fwrite(M_sync, i, 1, out);
+            
+            if (EOF!=c)
+            {
+                ungetc(c, in);
+            }
+            continue;
+        }
+        
+        if (1!=fread(pfx+sizeof(M_sync), DBGBIN_PFX_LEN-sizeof(M_sync), 1, in))
+        {
+            fprintf(out, "*** logdec: truncated record at the end of file\n");
+            break;
+        }
+        
+        DBGBIN_GET(len, pfx+DBGBIN_OFF_LEN);
+        DBGBIN_GET(pid, pfx+DBGBIN_OFF_PID);
+        
+        if (len < DBGBIN_PFX_LEN || len > DBGBIN_MAXREC)
+        {
+            fprintf(out, "*** logdec: corrupted record (len %lu)\n", 
+                    (unsigned long)len);
+            continue;
+        }
+        
+        len-=DBGBIN_PFX_LEN;
+        
+        if ((long)len+1 > recsz)
+        {
+            char *tmp = NDRX_REALLOC(rec, len+1);
+            
+            if (NULL==tmp)
+            {
+                userlog("Failed to realloc %lu bytes: %s", 
+                        (unsigned long)len+1, strerror(errno));
+                EXFAIL_OUT(ret);
+            }
+            
+            rec = tmp;
+            recsz = len+1;
+        }
+        
+        if (len > 0 && 1!=fread(rec, len, 1, in))
+        {
+            fprintf(out, "*** logdec: truncated record at the end of file\n");
+            break;
+        }
+        
+        switch (pfx[DBGBIN_OFF_TYPE])
+        {
+            case DBGBIN_REC_HDR:
+                
+                if (len < DBGBIN_HDR_LEN-DBGBIN_PFX_LEN)
+                {
+                    break;
+                }
+                
+                DBGBIN_GET(magic, rec);
+                DBGBIN_GET(byteord, rec+4);
+                
+                if (DBGBIN_MAGIC!=magic || DBGBIN_BYTEORD!=byteord ||
+                        sizeof(long)!=(size_t)rec[6] || 
+                        sizeof(void *)!=(size_t)rec[7])
+                {
+                    fprintf(stderr, "Trace written on other platform "
+                            "(byte order/word size), cannot decode\n");
+                    EXFAIL_OUT(ret);
+                }
+                
+                /* new session of the pid */
+                EXHASH_ITER(hh, strs, ent, elt)
+                {
+                    if ((uint32_t)(ent->dkey >> 32)==pid)
+                    {
+                        EXHASH_DEL(strs, ent);
+                        dbgbin_str_free(ent);
+                    }
+                }
+                break;
+            case DBGBIN_REC_STR:
+                
+                if (len < sizeof(id))
+                {
+                    break;
+                }
+                
+                DBGBIN_GET(id, rec);
+                
+                if (NULL!=(ent = dbgbin_dec_str(strs, pid, id)))
+                {
+                    EXHASH_DEL(strs, ent);
+                    dbgbin_str_free(ent);
+                }
+                
+                if (NULL==(ent = dbgbin_str_new(rec+sizeof(id), len-sizeof(id))))
+                {
+                    userlog("Failed to malloc string: %s", strerror(errno));
+                    EXFAIL_OUT(ret);
+                }
+                
+                ent->id = id;
+                ent->dkey = ((uint64_t)pid << 32) | id;
+                EXHASH_ADD(hh, strs, dkey, sizeof(ent->dkey), ent);
+                break;
+            case DBGBIN_REC_LOG:
+                dbgbin_dec_log(strs, pid, rec, len, out);
+                break;
+            case DBGBIN_REC_DUMP:
+                dbgbin_dec_dump(out, (unsigned char *)rec, NULL, len);
+                break;
+            case DBGBIN_REC_DIFF:
+                dbgbin_dec_dump(out, (unsigned char *)rec, 
+                        (unsigned char *)rec+len/2, len/2);
+                break;
+            default:
+                /* unknown record, skip */
+                break;
+        }
+    }
+    
+out:
+    
+    EXHASH_ITER(hh, strs, ent, elt)
+    {
+        EXHASH_DEL(strs, ent);
+        dbgbin_str_free(ent);
+    }
+    
+    if (NULL!=rec)
+    {
+        NDRX_FREE(rec);
+    }
+    
+    return ret;
+}
+
+/* vim: set ts=4 sw=4 et smartindent: */
@@ -172,6 +172,9 @@ expublic ndrx_debug_file_sink_t* ndrx_debug_get_sink(char *fname,
         ret->chwait=0;
         ret->refcount=1;
         ret->flags=flags;
+        ret->bin_strs=NULL;
+        ret->bin_nextid=0;
+        ret->bin_pid=0;
         
         EXHASH_ADD_STR( M_sink_hash, fname, ret );
 
@@ -236,6 +239,7 @@ expublic int ndrx_debug_unset_sink(ndrx_debug_file_sink_t* mysink, int do_lock,
     if ((mysink->refcount == 0 && ! (mysink->flags & NDRX_LOG_FPROC)) || force)
     {
         NDRX_FCLOSE(mysink->fp);
+        ndrx_dbgbin_sink_reset(mysink);
         
         /* un-init the resources */
         pthread_cond_destroy(&mysink->change_wait);
@@ -539,6 +543,9 @@ expublic int ndrx_debug_changename(char *toname, int do_lock, ndrx_debug_t *dbg_
         }
     }
 
+    /* binary trace strings must be written again to new file */
+    ndrx_dbgbin_sink_reset(mysink);
+    
     /* unlock originals */
     mysink->chwait=EXFALSE;
     
@@ -81,6 +81,9 @@ exprivate segmap_t M_map[] = {
         ,{NDRX_SHM_LCF_SFX, NDRX_SHM_LCF_KEYOFSZ}
         ,{NDRX_SHM_ROUTCRIT_SFX, NDRX_SHM_ROUTCRIT_KEYOFSZ}
         ,{NDRX_SHM_ROUTSVC_SFX, NDRX_SHM_ROUTSVC_KEYOFSZ}
+        ,{NDRX_SHM_LMSG_SFX, NDRX_SHM_LMSG_KEYOFSZ}
+        ,{NDRX_SHM_CACHESF_SFX, NDRX_SHM_CACHESF_KEYOFSZ}
+        ,{NDRX_SHM_CALLTRACE_SFX, NDRX_SHM_CALLTRACE_KEYOFSZ}
         ,{NULL}
     };
 /*---------------------------Prototypes---------------------------------*/    
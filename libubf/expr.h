@@ -82,6 +82,8 @@ typedef long (*functionPtr2_t)(UBFH *p_ub, char *funcname, char *arg1);
 #define	NODE_TYPE_FLOAT		10
 #define	NODE_TYPE_LONG		11
 #define	NODE_TYPE_FUNC		12
+/* Compiled program, wraps the root of the tree */
+#define	NODE_TYPE_PROG		13
 
 /************* AST SUB-NODE TYPES **************/
 /* Each sub-type we will have it's own identifier! */
@@ -121,6 +123,39 @@ typedef long (*functionPtr2_t)(UBFH *p_ub, char *funcname, char *arg1);
 #define VALUE_TYPE_FLD_STR	3
 /* String value in ' ' in expression */
 #define VALUE_TYPE_STRING	4
+
+/* Value kinds of the operands, resolved at compile time */
+#define NDRX_EXPR_KIND_DYN      0   /**< Decided by values at run-time  */
+#define NDRX_EXPR_KIND_LONG     1   /**< Long compare/math              */
+#define NDRX_EXPR_KIND_FLOAT    2   /**< Float compare/math             */
+#define NDRX_EXPR_KIND_STR      3   /**< String compare                 */
+
+/* Bytecode instructions */
+#define NDRX_EXPR_OP_CONST      0   /**< Push folded constant           */
+#define NDRX_EXPR_OP_FLDL       1   /**< Push short/long field          */
+#define NDRX_EXPR_OP_FLDD       2   /**< Push float/double field        */
+#define NDRX_EXPR_OP_FLDS       3   /**< Push string field, in place    */
+#define NDRX_EXPR_OP_FLD        4   /**< Push other field (copy)        */
+#define NDRX_EXPR_OP_FUNC       5   /**< Push callback function result  */
+#define NDRX_EXPR_OP_BINOP      6   /**< Compare/math op on two values  */
+#define NDRX_EXPR_OP_REGEX      7   /**< Regex match                    */
+#define NDRX_EXPR_OP_UNARY      8   /**< Unary op                       */
+#define NDRX_EXPR_OP_ORJ        9   /**< || short circuit jump          */
+#define NDRX_EXPR_OP_ANDJ       10  /**< && short circuit jump          */
+#define NDRX_EXPR_OP_BOOL       11  /**< Convert top to boolean long    */
+#define NDRX_EXPR_OP_XOR        12  /**< ^ of two values                */
+
+/** Max evaluation stack depth of compiled program */
+#define NDRX_EXPR_STACK_MAX     64
+
+/** Free up field string value, which was allocated by Bgetsa() */
+#define FREE_UP_UB_BUF(v) \
+if (v->dyn_alloc && NULL!=v->strval)\
+{\
+free(v->strval);\
+v->strval=NULL;\
+v->dyn_alloc=0;\
+}
 /*---------------------------Enums--------------------------------------*/
 /*---------------------------Typedefs-----------------------------------*/
 /*
@@ -228,6 +263,36 @@ typedef struct {
     char *strval;
 } value_block_t;
 
+/**
+ * Compiled expression instruction
+ */
+typedef struct
+{
+    int op;             /**< NDRX_EXPR_OP_* instruction                 */
+    int type;           /**< node type for binary ops                   */
+    int sub_type;       /**< node sub-type                              */
+    int kind;           /**< NDRX_EXPR_KIND_* of the operands           */
+    int inv;            /**< invert the result (!=, !%)                 */
+    int jmp;            /**< jump target for short circuits             */
+    BFLDID bfldid;      /**< field id for field loads                   */
+    BFLDOCC occ;        /**< field occurrence                           */
+    struct ast *a;      /**< source node                                */
+    value_block_t cval; /**< folded constant value                      */
+} ndrx_expr_instr_t;
+
+/**
+ * Compiled program, this is returned by Bboolco() as the tree root.
+ * Original tree is kept for printing and for the free up.
+ */
+struct ast_prog {
+    int nodetype;
+    int sub_type;
+    int nodeid;
+    struct ast *root;           /**< parsed tree                        */
+    int ninstr;                 /**< number of instructions             */
+    ndrx_expr_instr_t *code;    /**< instructions                       */
+};
+
 /*************** Dynamic list for allocated resources ***********************/
 struct list_node {
     char *mem;
@@ -250,6 +315,19 @@ struct ast *newfunc(ndrx_symbfunc_t *funcname);
 /* evaluate an AST */
 int eval(UBFH *p_ub, struct ast *a, value_block_t *v);
 
+/* evaluate already evaluated operands */
+int op_equal_val(int type, int sub_type, int kind, value_block_t *p_lval, 
+        value_block_t *p_rval, value_block_t *v);
+int process_unary_val(int op, value_block_t *p_pri, value_block_t *v);
+int regexp_eval(UBFH *p_ub, struct ast *l, struct ast *r, value_block_t *v);
+int read_unary_fb(UBFH *p_ub, struct ast *a, value_block_t * v);
+int read_unary_func(UBFH *p_ub, struct ast *a, value_block_t * v);
+
+/* compiled program */
+extern struct ast *ndrx_expr_compile(struct ast *root);
+extern int ndrx_expr_exec(UBFH *p_ub, struct ast_prog *prog, value_block_t *v);
+extern void ndrx_expr_prog_free(struct ast_prog *prog);
+
 /* delete and free an AST */
 void treefree(struct ast *);
 
@@ -0,0 +1,376 @@
+/**
+ * @brief UBF library
+ *   Cache of compiled expressions (UBF boolean expressions and regular
+ *   expressions) used by typed buffer filters. Bounded LRU, entries are
+ *   reference counted so that evicted entries are freed by the last user.
+ *
+ * @file expr_cache.c
+ */
+/* -----------------------------------------------------------------------------
+ * Enduro/X Middleware Platform for Distributed Transaction Processing
+ * Copyright (C) 2009-2016, ATR Baltic, Ltd. All Rights Reserved.
+ * Copyright (C) 2017-2019, Mavimax, Ltd. All Rights Reserved.
+ * This software is released under one of the following licenses:
+ * AGPL (with Java and Go exceptions) or Mavimax's license for commercial use.
+ * See LICENSE file for full text.
+ * -----------------------------------------------------------------------------
+ * AGPL license:
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License, version 3 as published
+ * by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License, version 3
+ * for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * -----------------------------------------------------------------------------
+ * A commercial use license is available from Mavimax, Ltd
+ * contact@mavimax.com
+
+/*---------------------------Includes-----------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <regex.h>
+#include <ndrstandard.h>
+#include <ubf.h>
+#include <ubf_int.h>
+#include <utlist.h>
+#include <thlock.h>
+#include <lcf.h>
+#include <userlog.h>
+#include "ndebug.h"
+#include "ferror.h"
+/*---------------------------Externs------------------------------------*/
+/*---------------------------Macros-------------------------------------*/
+/*---------------------------Enums--------------------------------------*/
+/*---------------------------Typedefs-----------------------------------*/
+/*---------------------------Globals------------------------------------*/
+/*---------------------------Statics------------------------------------*/
+exprivate MUTEX_LOCKDECL(M_exprc_lock);
+exprivate MUTEX_LOCKDECL(M_init_lock);
+exprivate volatile int M_first = EXTRUE;         /**< config not loaded              */
+exprivate int M_max = NDRX_UBFEXPRC_DFLT;/**< max entries, 0 - disabled     */
+exprivate ndrx_ubf_exprc_t *M_hash = NULL;  /**< entries by key             */
+exprivate ndrx_ubf_exprc_t *M_lru = NULL;   /**< most recently used first   */
+exprivate int M_entries = 0;            /**< entries in cache               */
+exprivate long M_hits = 0;              /**< lookups found in cache         */
+exprivate long M_misses = 0;            /**< lookups compiled               */
+exprivate long M_evictions = 0;         /**< entries removed by LRU         */
+/*---------------------------Prototypes---------------------------------*/
+
+/**
+ * LCF callback, write cache stats to ULOG
+ * @param cmd shared mem command
+ * @param p_flags feedback flags
+ * @return EXSUCCEED
+ */
+exprivate int exprc_lcf_stats(ndrx_lcf_command_t *cmd, long *p_flags)
+{
+    ndrx_ubf_exprc_stats_ulog(cmd->fbackmsg, sizeof(cmd->fbackmsg));
+    *p_flags|=NDRX_LCF_FLAG_FBACK_MSG;
+    
+    return EXSUCCEED;
+}
+
+/**
+ * Load the cache settings and register the LCF stats command.
+ * Cache lock is not held here, as LCF commands may be run from the
+ * debug logging.
+ */
+exprivate void exprc_init(void)
+{
+    char *p;
+    ndrx_lcf_reg_func_t creg;
+    
+    MUTEX_LOCK_V(M_init_lock);
+    
+    if (!M_first)
+    {
+        MUTEX_UNLOCK_V(M_init_lock);
+        return; /* <<< RETURN */
+    }
+    
+    if (NULL!=(p=getenv(CONF_NDRX_UBFEXPRCACHE)))
+    {
+        M_max = atoi(p);
+        
+        if (M_max < 0)
+        {
+            M_max = 0;
+        }
+    }
+    
+    UBF_LOG(log_debug, "Using %s: %d", CONF_NDRX_UBFEXPRCACHE, M_max);
+    
+    memset(&creg, 0, sizeof(creg));
+    creg.version=NDRX_LCF_CCMD_VERSION;
+    creg.pf_callback=exprc_lcf_stats;
+    creg.command=NDRX_LCF_CMD_EXPRSTATS;
+    NDRX_STRCPY_SAFE(creg.cmdstr, NDRX_LCF_CMDSTR_EXPRSTATS);
+    
+    if (EXSUCCEED!=ndrx_lcf_func_add(&creg))
+    {
+        UBF_LOG(log_warn, "Failed to register [%s] LCF command: %s", 
+                NDRX_LCF_CMDSTR_EXPRSTATS, Nstrerror(Nerror));
+    }
+    
+    M_first = EXFALSE;
+    MUTEX_UNLOCK_V(M_init_lock);
+}
+
+/**
+ * Free up the entry
+ * @param ent entry not used and not in cache
+ */
+exprivate void exprc_free(ndrx_ubf_exprc_t *ent)
+{
+    if (NDRX_UBFEXPRC_UBF==ent->kind)
+    {
+        Btreefree(ent->tree);
+    }
+    else
+    {
+        regfree(&ent->re);
+    }
+    
+    NDRX_FREE(ent->key);
+    NDRX_FREE(ent);
+}
+
+/**
+ * Compile the expression to new entry
+ * @param kind NDRX_UBFEXPRC_* type
+ * @param key kind + expression text
+ * @return entry (refcnt 1) or NULL on error (Berror set)
+ */
+exprivate ndrx_ubf_exprc_t* exprc_compile(int kind, char *key)
+{
+    ndrx_ubf_exprc_t *ent = NULL;
+    int err;
+    char errbuf[256];
+    
+    if (NULL==(ent=NDRX_CALLOC(1, sizeof(ndrx_ubf_exprc_t))) ||
+            NULL==(ent->key=NDRX_STRDUP(key)))
+    {
+        ndrx_Bset_error_fmt(BMALLOC, "Failed to malloc expression cache entry: %s",
+                strerror(errno));
+        goto out;
+    }
+    
+    ent->kind = kind;
+    ent->refcnt = 1;
+    
+    if (NDRX_UBFEXPRC_UBF==kind)
+    {
+        if (NULL==(ent->tree=Bboolco(key+1)))
+        {
+            UBF_LOG(log_error, "Failed to compile expression [%s]: %s",
+                    key+1, Bstrerror(Berror));
+            goto out;
+        }
+    }
+    else if (EXSUCCEED!=(err=regcomp(&ent->re, key+1, REG_EXTENDED | REG_NOSUB)))
+    {
+        regerror(err, &ent->re, errbuf, sizeof(errbuf));
+        ndrx_Bset_error_fmt(BSYNTAX, "Failed to compile regex [%s]: %s", 
+                key+1, errbuf);
+        UBF_LOG(log_error, "Failed to compile regex [%s]: %s", key+1, errbuf);
+        goto out;
+    }
+    
+    return ent; /* <<< RETURN */
+    
+out:
+    
+    if (NULL!=ent)
+    {
+        if (NULL!=ent->key)
+        {
+            NDRX_FREE(ent->key);
+        }
+        NDRX_FREE(ent);
+    }
+
+    return NULL;
+}
+
+/**
+ * Get compiled expression. Expression is compiled on cache miss. Entry
+ * shall be released by ndrx_ubf_exprc_release() when evaluation is done.
+ * @param kind NDRX_UBFEXPRC_UBF or NDRX_UBFEXPRC_REGEX
+ * @param expr expression text
+ * @return entry or NULL on error (Berror set)
+ */
+expublic ndrx_ubf_exprc_t* ndrx_ubf_exprc_get(int kind, char *expr)
+{
+    ndrx_ubf_exprc_t *ent = NULL;
+    ndrx_ubf_exprc_t *ent2 = NULL;
+    ndrx_ubf_exprc_t *tmp;
+    ndrx_ubf_exprc_t *evicted = NULL;
+    size_t len = strlen(expr)+2;
+    char keybuf[256];
+    char *key = keybuf;
+    
+    if (len > sizeof(keybuf) && NULL==(key=NDRX_MALLOC(len)))
+    {
+        ndrx_Bset_error_fmt(BMALLOC, "Failed to malloc %d bytes: %s", 
+                (int)len, strerror(errno));
+        return NULL; /* <<< RETURN */
+    }
+    
+    key[0] = (char)kind;
+    strcpy(key+1, expr);
+    
+    if (M_first)
+    {
+        exprc_init();
+    }
+    
+    MUTEX_LOCK_V(M_exprc_lock);
+    
+    EXHASH_FIND_STR(M_hash, key, ent);
+    
+    if (NULL!=ent)
+    {
+        M_hits++;
+        ent->refcnt++;
+        
+        if (M_lru!=ent)
+        {
+            DL_DELETE(M_lru, ent);
+            DL_PREPEND(M_lru, ent);
+        }
+        
+        MUTEX_UNLOCK_V(M_exprc_lock);
+        goto out;
+    }
+    
+    M_misses++;
+    MUTEX_UNLOCK_V(M_exprc_lock);
+    
+    /* compile out of the lock, parser is locked by the Bboolco() */
+    if (NULL==(ent=exprc_compile(kind, key)) || 0==M_max)
+    {
+        goto out;
+    }
+    
+    MUTEX_LOCK_V(M_exprc_lock);
+    
+    /* other thread might compile the same */
+    EXHASH_FIND_STR(M_hash, key, ent2);
+    
+    if (NULL!=ent2)
+    {
+        ent2->refcnt++;
+        MUTEX_UNLOCK_V(M_exprc_lock);
+        
+        exprc_free(ent);
+        ent = ent2;
+        goto out;
+    }
+    
+    ent->cached = EXTRUE;
+    EXHASH_ADD_KEYPTR(hh, M_hash, ent->key, strlen(ent->key), ent);
+    DL_PREPEND(M_lru, ent);
+    M_entries++;
+    
+    /* evict least recently used, unused entries are freed out of the lock */
+    while (M_entries > M_max)
+    {
+        ent2 = M_lru->prev;
+        
+        EXHASH_DEL(M_hash, ent2);
+        DL_DELETE(M_lru, ent2);
+        ent2->cached = EXFALSE;
+        M_entries--;
+        M_evictions++;
+        
+        if (0==ent2->refcnt)
+        {
+            DL_APPEND(evicted, ent2);
+        }
+    }
+    
+    MUTEX_UNLOCK_V(M_exprc_lock);
+    
+    DL_FOREACH_SAFE(evicted, ent2, tmp)
+    {
+        UBF_LOG(log_debug, "Expression [%s] evicted", ent2->key+1);
+        DL_DELETE(evicted, ent2);
+        exprc_free(ent2);
+    }
+    
+out:
+    
+    if (key!=keybuf)
+    {
+        NDRX_FREE(key);
+    }
+
+    return ent;
+}
+
+/**
+ * Release the entry. Entry removed from the cache is freed by the last user.
+ * @param ent entry got by ndrx_ubf_exprc_get()
+ */
+expublic void ndrx_ubf_exprc_release(ndrx_ubf_exprc_t *ent)
+{
+    int do_free;
+    
+    MUTEX_LOCK_V(M_exprc_lock);
+    ent->refcnt--;
+    do_free = (!ent->cached && 0==ent->refcnt);
+    MUTEX_UNLOCK_V(M_exprc_lock);
+    
+    if (do_free)
+    {
+        exprc_free(ent);
+    }
+}
+
+/**
+ * Return cache statistics
+ * @param p_hits lookups served from cache
+ * @param p_misses lookups compiled
+ * @param p_evictions entries removed by LRU
+ * @param p_entries current number of entries
+ */
+expublic void ndrx_ubf_exprc_stats(long *p_hits, long *p_misses, 
+        long *p_evictions, int *p_entries)
+{
+    MUTEX_LOCK_V(M_exprc_lock);
+    *p_hits = M_hits;
+    *p_misses = M_misses;
+    *p_evictions = M_evictions;
+    *p_entries = M_entries;
+    MUTEX_UNLOCK_V(M_exprc_lock);
+}
+
+/**
+ * Write cache statistics to ULOG
+ * @param msg feedback message
+ * @param msgsz feedback message buffer size
+ */
+expublic void ndrx_ubf_exprc_stats_ulog(char *msg, size_t msgsz)
+{
+    long hits, misses, evictions;
+    int entries;
+    
+    ndrx_ubf_exprc_stats(&hits, &misses, &evictions, &entries);
+    
+    snprintf(msg, msgsz, "hits %ld misses %ld evictions %ld entries %d/%d", 
+            hits, misses, evictions, entries, M_max);
+    
+    userlog("UBF expression cache: %s", msg);
+}
+
+/* vim: set ts=4 sw=4 et smartindent: */
@@ -54,20 +54,13 @@
 #include <expr.tab.h>
 #include <exhash.h>
 #include <ubf_impl.h>
+#include <thlock.h>
 /*---------------------------Externs------------------------------------*/
 /* make llvm silent.. */
 extern void yy_scan_string (char *yy_str  );
 extern void _free_parser(void);
 extern int yyparse (void);
 /*---------------------------Macros-------------------------------------*/
-#define FREE_UP_UB_BUF(v) \
-if (v->dyn_alloc && NULL!=v->strval)\
-{\
-free(v->strval);\
-v->strval=NULL;\
-v->dyn_alloc=0;\
-}
-
 #ifdef UBF_DEBUG
 #define DUMP_VALUE_BLOCK(TEXT, V) if (EXSUCCEED==ret) dump_val(TEXT, V)
 #else
@@ -92,6 +85,9 @@ static __thread struct list_node *M_first_mem;
 func_hash_t *M_func_hash = NULL;    /* Hash of customer functions regi */
 /*---------------------------Statics------------------------------------*/
 
+/** Lock for regex compile on first use */
+exprivate MUTEX_LOCKDECL(M_regex_lock);
+
 /*
  * Listing of types
  */
@@ -109,7 +105,8 @@ char *M_nodetypes[] =
     "[STR   (9) ]",
     "[FLOAT (10)]",
     "[LONG  (11)]",
-    "[FUNC  (12)]"
+    "[FUNC  (12)]",
+    "[PROG  (13)]"
 };
 
 /*
@@ -1041,6 +1038,102 @@ int op_equal_str_cmp(int type, int sub_type, value_block_t *lval,
     return ret;
 }
 
+/**
+ * Compare or do math op on two already evaluated values.
+ * As by specification ' ' VS NUM, we convert NUM to str
+ * if FLD(STR) VS NUM, we convert FDL to NUM
+ * @param type node type (EQOP, RELOP, ADDOP, MULTOP)
+ * @param sub_type operation sub-type
+ * @param kind value kind resolved at compile time (NDRX_EXPR_KIND_*), if
+ *  NDRX_EXPR_KIND_DYN, then comparison type is selected by the values
+ * @param p_lval left value
+ * @param p_rval right value
+ * @param v result
+ * @return SUCCEED/FAIL
+ */
+int op_equal_val(int type, int sub_type, int kind, value_block_t *p_lval, 
+        value_block_t *p_rval, value_block_t *v)
+{
+    int ret=EXSUCCEED;
+    
+    if (p_lval->is_null || p_rval->is_null)
+    {
+        /* Not equal... */
+        UBF_LOG(log_debug, "LVAR or LVAL is NULL => False");
+        v->longval = v->boolval = EXFALSE;
+        goto out;
+    }
+    
+    switch (kind)
+    {
+        case NDRX_EXPR_KIND_LONG:
+            ret=op_equal_long_cmp(type, sub_type, p_lval, p_rval, v);
+            goto out;
+        case NDRX_EXPR_KIND_FLOAT:
+            ret=op_equal_float_cmp(type, sub_type, p_lval, p_rval, v);
+            goto out;
+        case NDRX_EXPR_KIND_STR:
+            ret=op_equal_str_cmp(type, sub_type, p_lval, p_rval, v);
+            goto out;
+    }
+
+    if (( (VALUE_TYPE_STRING==p_lval->value_type &&
+        VALUE_TYPE_STRING==p_rval->value_type)
+        ||
+        (VALUE_TYPE_FLD_STR==p_lval->value_type &&
+        VALUE_TYPE_FLD_STR==p_rval->value_type)
+        ||
+        (VALUE_TYPE_STRING==p_lval->value_type &&
+        VALUE_TYPE_FLD_STR==p_rval->value_type)
+        ||
+        (VALUE_TYPE_FLD_STR==p_lval->value_type &&
+        VALUE_TYPE_STRING==p_rval->value_type)) &&
+            !(type==NODE_TYPE_ADDOP || type==NODE_TYPE_MULTOP) /* do not run math ops */
+            )
+    {
+        ret=op_equal_str_cmp(type, sub_type, p_lval, p_rval, v);
+
+    }
+    else if ((VALUE_TYPE_STRING==p_lval->value_type ||
+        VALUE_TYPE_STRING==p_rval->value_type) && !(type==NODE_TYPE_ADDOP || 
+            type==NODE_TYPE_MULTOP))
+    {
+        ret=op_equal_str_cmp(type, sub_type, p_lval, p_rval, v);
+    }
+    /* if both are longs, then compare them */
+    else if (VALUE_TYPE_LONG==p_lval->value_type && VALUE_TYPE_LONG==p_rval->value_type)
+    {
+        ret=op_equal_long_cmp(type, sub_type, p_lval, p_rval, v);
+    }
+    else /* limit the scope for is_float_val call */
+    {
+        int is_lval_float = is_float_val(p_lval);
+        int is_rval_float = is_float_val(p_rval);
+#if 0
+        /* If any is long and other is not containing float symbols - convert longs & cmp*/
+        if (VALUE_TYPE_LONG==p_lval->value_type && !is_rval_float ||
+                 VALUE_TYPE_LONG==p_rval->value_type && !is_lval_float)
+        {
+            ret=op_equal_long_cmp(type, sub_type, p_lval, p_rval, v);
+        }
+        /* If both strings are not floats, then do the long cmp */
+        else
+#endif      /* mode (%) we will process as long. */
+        if ((!is_lval_float && !is_rval_float) || 
+                (NODE_TYPE_MULTOP==type && MULOP_MOD==sub_type))
+        {
+            ret=op_equal_long_cmp(type, sub_type, p_lval, p_rval, v);
+        }
+        else /* Nothing to do:- downgrade to float compare */
+        {
+            ret=op_equal_float_cmp(type, sub_type, p_lval, p_rval, v);
+        } /* else */
+    }
+
+out:
+    return ret;
+}
+
 /**
  * As by specification ' ' VS NUM, we convert NUM to str
  * if FLD(STR) VS NUM, we convert FDL to NUM
@@ -1064,70 +1157,9 @@ int op_equal(UBFH *p_ub, int type, int sub_type, struct ast *l, struct ast *r, v
 
     if (EXSUCCEED==ret)
     {
-        if (lval.is_null || rval.is_null)
-        {
-            /* Not equal... */
-            UBF_LOG(log_debug, "LVAR or LVAL is NULL => False");
-            v->longval = v->boolval = EXFALSE;
-            goto out;
-        }
-	
-        if (( (VALUE_TYPE_STRING==lval.value_type &&
-            VALUE_TYPE_STRING==rval.value_type)
-            ||
-            (VALUE_TYPE_FLD_STR==lval.value_type &&
-            VALUE_TYPE_FLD_STR==rval.value_type)
-            ||
-            (VALUE_TYPE_STRING==lval.value_type &&
-            VALUE_TYPE_FLD_STR==rval.value_type)
-            ||
-            (VALUE_TYPE_FLD_STR==lval.value_type &&
-            VALUE_TYPE_STRING==rval.value_type)) &&
-                !(type==NODE_TYPE_ADDOP || type==NODE_TYPE_MULTOP) /* do not run math ops */
-                )
-        {
-            ret=op_equal_str_cmp(type, sub_type, &lval, &rval, v);
-
-        }
-        else if ((VALUE_TYPE_STRING==lval.value_type ||
-            VALUE_TYPE_STRING==rval.value_type) && !(type==NODE_TYPE_ADDOP || 
-                type==NODE_TYPE_MULTOP))
-        {
-            ret=op_equal_str_cmp(type, sub_type, &lval, &rval, v);
-        }
-        /* if both are longs, then compare them */
-        else if (VALUE_TYPE_LONG==lval.value_type && VALUE_TYPE_LONG==rval.value_type)
-        {
-            ret=op_equal_long_cmp(type, sub_type, &lval, &rval, v);
-        }
-        else /* limit the scope for is_float_val call */
-        {
-            int is_lval_float = is_float_val(&lval);
-            int is_rval_float = is_float_val(&rval);
-#if 0
-            /* If any is long and other is not containing float symbols - convert longs & cmp*/
-            if (VALUE_TYPE_LONG==lval.value_type && !is_rval_float ||
-                     VALUE_TYPE_LONG==rval.value_type && !is_lval_float)
-            {
-                ret=op_equal_long_cmp(type, sub_type, &lval, &rval, v);
-            }
-            /* If both strings are not floats, then do the long cmp */
-            else
-#endif      /* mode (%) we will process as long. */
-            if ((!is_lval_float && !is_rval_float) || 
-                    (NODE_TYPE_MULTOP==type && MULOP_MOD==sub_type))
-            {
-                ret=op_equal_long_cmp(type, sub_type, &lval, &rval, v);
-            }
-            else /* Nothing to do:- downgrade to float compare */
-            {
-                ret=op_equal_float_cmp(type, sub_type, &lval, &rval, v);
-            } /* else */
-        }
-
-    } /* main SUCCEED==ret */
+        ret=op_equal_val(type, sub_type, NDRX_EXPR_KIND_DYN, &lval, &rval, v);
+    }
 
-out:
     /* Ensure that we clean up dynamically allocated FB resources! */
     FREE_UP_UB_BUF((&lval));
     FREE_UP_UB_BUF((&rval));
@@ -1234,20 +1266,29 @@ int regexp_eval(UBFH *p_ub, struct ast *l, struct ast *r, value_block_t *v)
         UBF_LOG(log_debug, "Regex left  [%s]", p_l);
         UBF_LOG(log_debug, "Regex right [%s]", p_r);
 
-        /* Now see do we need to compile  */
+        /* Now see do we need to compile. Tree may be shared by threads
+         * (expression cache), thus compile under lock. */
         if (!rs->regex.compiled)
         {
-            UBF_LOG(log_debug, "Compiling regex");
-            if (EXSUCCEED!=(err=regcomp(re, p_r, REG_EXTENDED | REG_NOSUB)))
-            {
-                ndrx_report_regexp_error("regcomp", err, re);
-                ret=EXFAIL;
-            }
-            else
+            MUTEX_LOCK_V(M_regex_lock);
+            
+            if (!rs->regex.compiled)
             {
-                UBF_LOG(log_debug, "REGEX: Compiled OK");
-                rs->regex.compiled = 1;
+                UBF_LOG(log_debug, "Compiling regex");
+                if (EXSUCCEED!=(err=regcomp(re, p_r, REG_EXTENDED | REG_NOSUB)))
+                {
+                    ndrx_report_regexp_error("regcomp", err, re);
+                    ret=EXFAIL;
+                }
+                else
+                {
+                    UBF_LOG(log_debug, "REGEX: Compiled OK");
+                    __sync_synchronize();
+                    rs->regex.compiled = 1;
+                }
             }
+            
+            MUTEX_UNLOCK_V(M_regex_lock);
         }
 
         if (EXSUCCEED==ret && EXSUCCEED==regexec(re, p_l, (size_t) 0, NULL, 0))
@@ -1477,153 +1518,166 @@ int is_float_val(value_block_t *v)
 }
 
 /**
- * Process unary operation.
+ * Process unary operation on already evaluated value.
  * This may have some differences from orginal system when operating
  * with FB fields.
- * @param p_ub - pointer to FB
  * @param op - unary operation (ADDOP_PLUS, ADDOP_MINUS, UNARY_CMPL, UNARY_INV)
- * @param a - tree node containing unary operation (left side node contains the value of)
+ * @param p_pri - value of the operand
  * @param v - return value block
  * @return SUCCEED/FAIL
  */
-int process_unary(UBFH *p_ub, int op, struct ast *a, value_block_t *v)
+int process_unary_val(int op, value_block_t *p_pri, value_block_t *v)
 {
     int ret=EXSUCCEED;
-    value_block_t pri;
     /* Data keepers */
     double f;
     long  l;
     int is_long=EXTRUE;
-    char fn[] = "process_unary()";
+    char fn[] = "process_unary_val()";
 
-    memset(&pri, 0, sizeof(pri));
-	
     UBF_LOG(log_debug, "Entering %s", fn);
 
-    if (EXSUCCEED==eval(p_ub, a->r, &pri))
+    if (VALUE_TYPE_FLD_STR==p_pri->value_type || 
+            VALUE_TYPE_STRING==p_pri->value_type)
     {
-
-        if (VALUE_TYPE_FLD_STR==pri.value_type || 
-                VALUE_TYPE_STRING==pri.value_type)
+        if (is_float(p_pri->strval))
         {
-            if (is_float(pri.strval))
-            {
-                f = atof(pri.strval);
-                is_long = EXFALSE;
-                UBF_LOG(log_warn, "Treating unary field as "
-                                    "float [%f]!", f);
-            }
-            else
-            {
-                l = atol(pri.strval);
-                is_long = EXTRUE;
-                UBF_LOG(log_warn, "Treating unary "
-                        "field as long [%ld]", l);
-            }
+            f = atof(p_pri->strval);
+            is_long = EXFALSE;
+            UBF_LOG(log_warn, "Treating unary field as "
+                                "float [%f]!", f);
         }
-        else if (VALUE_TYPE_FLOAT==pri.value_type)
-        {
-            is_long=EXFALSE;
-            f = pri.floatval;
-        }
-        else if (VALUE_TYPE_LONG==pri.value_type)
-        {
-            /* it must be long */
-            is_long=EXTRUE;
-            l = pri.longval;
-        } /* Bug #325 */
-        else if (VALUE_TYPE_BOOL!=pri.value_type)
+        else
         {
-            UBF_LOG(log_warn, "Unknown value type %d op: %d", 
-                                pri.value_type, op);
-            return EXFAIL;
+            l = atol(p_pri->strval);
+            is_long = EXTRUE;
+            UBF_LOG(log_warn, "Treating unary "
+                    "field as long [%ld]", l);
         }
-        
+    }
+    else if (VALUE_TYPE_FLOAT==p_pri->value_type)
+    {
+        is_long=EXFALSE;
+        f = p_pri->floatval;
+    }
+    else if (VALUE_TYPE_LONG==p_pri->value_type)
+    {
+        /* it must be long */
+        is_long=EXTRUE;
+        l = p_pri->longval;
+    } /* Bug #325 */
+    else if (VALUE_TYPE_BOOL!=p_pri->value_type)
+    {
+        UBF_LOG(log_warn, "Unknown value type %d op: %d", 
+                            p_pri->value_type, op);
+        return EXFAIL;
+    }
+    
 #if 0
-        - Bug #325
-        if (((op==UNARY_CMPL || op==UNARY_INV) && !is_long) 
-                && VALUE_TYPE_BOOL!=pri.value_type)
-        {
-            /* Convert to long */
-            UBF_LOG(log_warn, "! or ~ converting double to long!");
-            l = (long) f;
-        }
+    - Bug #325
+    if (((op==UNARY_CMPL || op==UNARY_INV) && !is_long) 
+            && VALUE_TYPE_BOOL!=p_pri->value_type)
+    {
+        /* Convert to long */
+        UBF_LOG(log_warn, "! or ~ converting double to long!");
+        l = (long) f;
+    }
 #endif
-        
-        v->boolval = pri.boolval;
+    
+    v->boolval = p_pri->boolval;
 
-        switch (op)
-        {
-            case ADDOP_PLUS:
-                /* actually do nothing here! */
-                if (is_long)
-                {
-                    v->value_type=VALUE_TYPE_LONG;
-                    v->longval = l;
-                    
-                    if (v->longval)
-                        v->boolval=EXTRUE;
-                    else
-                        v->boolval=EXFALSE;
-                    
-                }
-                else /* float */
-                {
-                    v->value_type=VALUE_TYPE_FLOAT;
-                    v->floatval = f;
-                    if (!IS_FLOAT_0(v->floatval))
-                        v->boolval=EXTRUE;
-                    else
-                        v->boolval=EXFALSE;
-                }
-                break;
-            case ADDOP_MINUS:
-                /* actually do nothing here! */
-                if (is_long)
-                {
-                    v->value_type=VALUE_TYPE_LONG;
-                    v->longval = -l;
-                    
-                    if (v->longval)
-                        v->boolval=EXTRUE;
-                    else
-                        v->boolval=EXFALSE;
-                    
-                }
-                else /* float */
-                {
-                    v->value_type=VALUE_TYPE_FLOAT;
-                    v->floatval = -f;
-                    
-                    if (!IS_FLOAT_0(v->floatval))
-                        v->boolval=EXTRUE;
-                    else
-                        v->boolval=EXFALSE;
-                }
-                break;
-            case UNARY_CMPL:
-                /* Works only on longs! */
+    switch (op)
+    {
+        case ADDOP_PLUS:
+            /* actually do nothing here! */
+            if (is_long)
+            {
                 v->value_type=VALUE_TYPE_LONG;
-                v->boolval = ~pri.boolval;
-                /* Assuming long as final bool*/
-                v->longval = v->boolval;
-                break;
-            case UNARY_INV:
+                v->longval = l;
+                
+                if (v->longval)
+                    v->boolval=EXTRUE;
+                else
+                    v->boolval=EXFALSE;
+                
+            }
+            else /* float */
+            {
+                v->value_type=VALUE_TYPE_FLOAT;
+                v->floatval = f;
+                if (!IS_FLOAT_0(v->floatval))
+                    v->boolval=EXTRUE;
+                else
+                    v->boolval=EXFALSE;
+            }
+            break;
+        case ADDOP_MINUS:
+            /* actually do nothing here! */
+            if (is_long)
+            {
                 v->value_type=VALUE_TYPE_LONG;
-                v->boolval = !pri.boolval;
-                v->longval = v->boolval;
-                break;
-        }
+                v->longval = -l;
+                
+                if (v->longval)
+                    v->boolval=EXTRUE;
+                else
+                    v->boolval=EXFALSE;
+                
+            }
+            else /* float */
+            {
+                v->value_type=VALUE_TYPE_FLOAT;
+                v->floatval = -f;
+                
+                if (!IS_FLOAT_0(v->floatval))
+                    v->boolval=EXTRUE;
+                else
+                    v->boolval=EXFALSE;
+            }
+            break;
+        case UNARY_CMPL:
+            /* Works only on longs! */
+            v->value_type=VALUE_TYPE_LONG;
+            v->boolval = ~p_pri->boolval;
+            /* Assuming long as final bool*/
+            v->longval = v->boolval;
+            break;
+        case UNARY_INV:
+            v->value_type=VALUE_TYPE_LONG;
+            v->boolval = !p_pri->boolval;
+            v->longval = v->boolval;
+            break;
     }
-    else
+    /* Dump out the final value */
+    DUMP_VALUE_BLOCK("process_unary", v);
+    UBF_LOG(log_debug, "Return %s %d", fn, ret);
+    return ret;
+}
+
+/**
+ * Process unary operation.
+ * @param p_ub - pointer to FB
+ * @param op - unary operation (ADDOP_PLUS, ADDOP_MINUS, UNARY_CMPL, UNARY_INV)
+ * @param a - tree node containing unary operation (left side node contains the value of)
+ * @param v - return value block
+ * @return SUCCEED/FAIL
+ */
+int process_unary(UBFH *p_ub, int op, struct ast *a, value_block_t *v)
+{
+    int ret=EXSUCCEED;
+    value_block_t pri;
+
+    memset(&pri, 0, sizeof(pri));
+
+    if (EXSUCCEED!=eval(p_ub, a->r, &pri) || 
+            EXSUCCEED!=process_unary_val(op, &pri, v))
     {
         ret=EXFAIL;
     }
+
     /* Ensure that we clean up dynamically allocated FB resources! */
     FREE_UP_UB_BUF((&pri));
-    /* Dump out the final value */
-    DUMP_VALUE_BLOCK("process_unary", v);
-    UBF_LOG(log_debug, "Return %s %d", fn, ret);
+
     return ret;
 }
 
@@ -1768,6 +1822,10 @@ int eval(UBFH *p_ub, struct ast *a, value_block_t *v)
             /* Get func unary... */
             ret=read_unary_func(p_ub, a, v);
             break;
+        case NODE_TYPE_PROG:
+            /* Run the compiled program */
+            ret=ndrx_expr_exec(p_ub, (struct ast_prog *)a, v);
+            break;
         case NODE_TYPE_STR:
             /* In this case we assume it is TRUE 
              * We do not use string value block so that we do not get
@@ -1860,8 +1918,9 @@ expublic char * ndrx_Bboolco (char * expr)
 
         if (EXSUCCEED==yyparse() && NULL!=G_p_root_node && EXFAIL!=G_error)
         {
-            ret=(char *)G_p_root_node;
             remove_resouce_list();
+            /* compile to bytecode, on failure tree is evaluated as is */
+            ret=(char *)ndrx_expr_compile(G_p_root_node);
         }
         else
         {
@@ -1992,6 +2051,9 @@ expublic void ndrx_Btreefree (char *tree)
         case NODE_TYPE_LONG:
             /* nothing to do */
             break;
+        case NODE_TYPE_PROG:
+            ndrx_expr_prog_free((struct ast_prog *)tree);
+            return; /* <<<< RETURN! Program frees it self */
         default:
             if (a->l)
             {
@@ -2099,6 +2161,11 @@ expublic void ndrx_Bboolpr (char * tree, FILE *outf,
                 NDRX_BBOOLPR_FMT("%ld", a_long->l);
             }
             break;
+        case NODE_TYPE_PROG:
+            /* print the original tree */
+            ndrx_Bboolpr ((char *)((struct ast_prog *)tree)->root, outf, 
+                    p_writef, dataptr1);
+            break;
         default:
             NDRX_BBOOLPR_FMT("(");
             if (a->l)
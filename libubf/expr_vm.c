@@ -0,0 +1,761 @@
+/**
+ * @brief UBF library
+ *   Compile boolean expression tree to flat bytecode and evaluate it.
+ *   Constant sub-trees are folded at compile time, field types are resolved
+ *   at compile time, string fields are compared in place. Evaluation uses
+ *   fixed value stack, && and || are compiled to short circuit jumps.
+ *
+ * @file expr_vm.c
+ */
+/* -----------------------------------------------------------------------------
+ * Enduro/X Middleware Platform for Distributed Transaction Processing
+ * Copyright (C) 2009-2016, ATR Baltic, Ltd. All Rights Reserved.
+ * Copyright (C) 2017-2019, Mavimax, Ltd. All Rights Reserved.
+ * This software is released under one of the following licenses:
+ * AGPL (with Java and Go exceptions) or Mavimax's license for commercial use.
+ * See LICENSE file for full text.
+ * -----------------------------------------------------------------------------
+ * AGPL license:
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License, version 3 as published
+ * by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License, version 3
+ * for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * -----------------------------------------------------------------------------
+ * A commercial use license is available from Mavimax, Ltd
+ * contact@mavimax.com
+ * -----------------------------------------------------------------------------
+ */
+
+
+/*---------------------------Includes-----------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <ndrstandard.h>
+#include <ubf.h>
+#include "expr.h"
+#include "ndebug.h"
+#include "ferror.h"
+#include <ubf_impl.h>
+/*---------------------------Externs------------------------------------*/
+/*---------------------------Macros-------------------------------------*/
+/** Initial number of instructions allocated */
+#define EXPR_CODE_INIT          16
+/*---------------------------Enums--------------------------------------*/
+/*---------------------------Typedefs-----------------------------------*/
+
+/**
+ * Compiler state
+ */
+typedef struct
+{
+    ndrx_expr_instr_t *code;    /**< instructions generated             */
+    int ninstr;                 /**< number of instructions             */
+    int nalloc;                 /**< instructions allocated             */
+    int depth;                  /**< current stack depth                */
+    int maxdepth;               /**< max stack depth reached            */
+    int inplace;                /**< string fields may be used in place */
+} expr_cc_t;
+
+/*---------------------------Globals------------------------------------*/
+/*---------------------------Statics------------------------------------*/
+/*---------------------------Prototypes---------------------------------*/
+
+exprivate int expr_gen(expr_cc_t *cc, struct ast *a, int *p_vtype);
+
+/**
+ * Does the tree have function calls? User functions get the UBF buffer
+ * and may change it, thus field data pointers cannot be kept on the stack.
+ * @param a tree node
+ * @return EXTRUE/EXFALSE
+ */
+exprivate int expr_has_func(struct ast *a)
+{
+    switch (a->nodetype)
+    {
+        case NODE_TYPE_FUNC:
+            return EXTRUE;
+        case NODE_TYPE_FLD:
+        case NODE_TYPE_STR:
+        case NODE_TYPE_FLOAT:
+        case NODE_TYPE_LONG:
+            return EXFALSE;
+        default:
+            return (NULL!=a->l && expr_has_func(a->l)) || 
+                    (NULL!=a->r && expr_has_func(a->r));
+    }
+}
+
+/**
+ * Is sub-tree constant (no fields and no functions)?
+ * @param a tree node
+ * @return EXTRUE/EXFALSE
+ */
+exprivate int expr_is_const(struct ast *a)
+{
+    switch (a->nodetype)
+    {
+        case NODE_TYPE_FUNC:
+        case NODE_TYPE_FLD:
+            return EXFALSE;
+        case NODE_TYPE_STR:
+        case NODE_TYPE_FLOAT:
+        case NODE_TYPE_LONG:
+            return EXTRUE;
+        default:
+            return (NULL==a->l || expr_is_const(a->l)) && 
+                    (NULL==a->r || expr_is_const(a->r));
+    }
+}
+
+/**
+ * Resolve the compare/math kind from the operand value types known at
+ * compile time. Follows the run-time selection of op_equal_val().
+ * @param type node type
+ * @param sub_type node sub-type
+ * @param lt left value type or EXFAIL if not known
+ * @param rt right value type or EXFAIL if not known
+ * @return NDRX_EXPR_KIND_*
+ */
+exprivate int expr_kind(int type, int sub_type, int lt, int rt)
+{
+    int is_math = (NODE_TYPE_ADDOP==type || NODE_TYPE_MULTOP==type);
+    int l_str = (VALUE_TYPE_STRING==lt || VALUE_TYPE_FLD_STR==lt);
+    int r_str = (VALUE_TYPE_STRING==rt || VALUE_TYPE_FLD_STR==rt);
+
+    if (EXFAIL==lt || EXFAIL==rt)
+    {
+        return NDRX_EXPR_KIND_DYN;
+    }
+
+    if (!is_math && ((l_str && r_str) || 
+            VALUE_TYPE_STRING==lt || VALUE_TYPE_STRING==rt))
+    {
+        return NDRX_EXPR_KIND_STR;
+    }
+
+    if (VALUE_TYPE_LONG==lt && VALUE_TYPE_LONG==rt)
+    {
+        return NDRX_EXPR_KIND_LONG;
+    }
+
+    /* field string vs number depends on the field value */
+    if (l_str || r_str)
+    {
+        return NDRX_EXPR_KIND_DYN;
+    }
+
+    if (NODE_TYPE_MULTOP==type && MULOP_MOD==sub_type)
+    {
+        return NDRX_EXPR_KIND_LONG;
+    }
+
+    return NDRX_EXPR_KIND_FLOAT;
+}
+
+/**
+ * Add instruction to the program
+ * @param cc compiler state
+ * @param op NDRX_EXPR_OP_* instruction
+ * @param a source node
+ * @param stack_chg stack depth change by the instruction
+ * @return instruction or NULL on malloc failure
+ */
+exprivate ndrx_expr_instr_t * expr_emit(expr_cc_t *cc, int op, struct ast *a, 
+        int stack_chg)
+{
+    ndrx_expr_instr_t *in = NULL;
+
+    if (cc->ninstr>=cc->nalloc)
+    {
+        int nalloc = (0==cc->nalloc?EXPR_CODE_INIT:cc->nalloc*2);
+        ndrx_expr_instr_t *code = NDRX_REALLOC(cc->code, 
+                sizeof(ndrx_expr_instr_t)*nalloc);
+
+        if (NULL==code)
+        {
+            ndrx_Bset_error_fmt(BMALLOC, "Failed to realloc %d bytes: %s",
+                    (int)(sizeof(ndrx_expr_instr_t)*nalloc), strerror(errno));
+            goto out;
+        }
+
+        cc->code = code;
+        cc->nalloc = nalloc;
+    }
+
+    in = &cc->code[cc->ninstr];
+    memset(in, 0, sizeof(*in));
+    in->op = op;
+    in->a = a;
+    cc->ninstr++;
+
+    cc->depth+=stack_chg;
+    if (cc->depth > cc->maxdepth)
+    {
+        cc->maxdepth = cc->depth;
+    }
+
+out:
+    return in;
+}
+
+/**
+ * Try to fold the constant sub-tree
+ * @param cc compiler state
+ * @param a sub-tree
+ * @param p_vtype value type of the result, EXFAIL if not known
+ * @return EXTRUE - folded, EXFALSE - not folded, EXFAIL - error
+ */
+exprivate int expr_fold(expr_cc_t *cc, struct ast *a, int *p_vtype)
+{
+    int ret = EXFALSE;
+    value_block_t v;
+    ndrx_expr_instr_t *in;
+
+    if (EXSUCCEED!=eval(NULL, a, &v))
+    {
+        /* let it fail at run-time, the same way as tree does */
+        UBF_LOG(log_debug, "Node %d not folded: %s", a->nodeid, 
+                Bstrerror(Berror));
+        ndrx_Bunset_error();
+        goto out;
+    }
+
+    /* field values only are allocated */
+    if (v.dyn_alloc)
+    {
+        FREE_UP_UB_BUF((&v));
+        goto out;
+    }
+
+    if (NULL==(in=expr_emit(cc, NDRX_EXPR_OP_CONST, a, 1)))
+    {
+        EXFAIL_OUT(ret);
+    }
+
+    in->cval = v;
+    *p_vtype = (VALUE_TYPE_BOOL==v.value_type?EXFAIL:v.value_type);
+    ret = EXTRUE;
+
+out:
+    return ret;
+}
+
+/**
+ * Generate the binary op, left and right values are evaluated first
+ * @param cc compiler state
+ * @param a tree node
+ * @param op instruction
+ * @param p_lt left value type
+ * @param p_rt right value type
+ * @return instruction or NULL on failure
+ */
+exprivate ndrx_expr_instr_t * expr_gen_bin(expr_cc_t *cc, struct ast *a, int op,
+        int *p_lt, int *p_rt)
+{
+    if (EXSUCCEED!=expr_gen(cc, a->l, p_lt) || 
+            EXSUCCEED!=expr_gen(cc, a->r, p_rt))
+    {
+        return NULL;
+    }
+
+    return expr_emit(cc, op, a, -1);
+}
+
+/**
+ * Generate the code for the tree
+ * @param cc compiler state
+ * @param a tree node
+ * @param p_vtype value type of the result (VALUE_TYPE_*), EXFAIL if not known
+ *  only at run-time
+ * @return EXSUCCEED/EXFAIL
+ */
+exprivate int expr_gen(expr_cc_t *cc, struct ast *a, int *p_vtype)
+{
+    int ret = EXSUCCEED;
+    int lt = EXFAIL;
+    int rt = EXFAIL;
+    int fld_type;
+    int jmp;
+    ndrx_expr_instr_t *in;
+
+    *p_vtype = EXFAIL;
+
+    if (expr_is_const(a))
+    {
+        if (EXFAIL==(ret=expr_fold(cc, a, p_vtype)))
+        {
+            goto out;
+        }
+        else if (EXTRUE==ret)
+        {
+            ret = EXSUCCEED;
+            goto out;
+        }
+
+        ret = EXSUCCEED;
+    }
+
+    switch (a->nodetype)
+    {
+        case NODE_TYPE_OR:
+        case NODE_TYPE_AND:
+            if (EXSUCCEED!=expr_gen(cc, a->l, &lt))
+            {
+                EXFAIL_OUT(ret);
+            }
+
+            /* jump keeps the left value, otherwise it is dropped */
+            jmp = cc->ninstr;
+            if (NULL==expr_emit(cc, NODE_TYPE_OR==a->nodetype?
+                    NDRX_EXPR_OP_ORJ:NDRX_EXPR_OP_ANDJ, a, -1))
+            {
+                EXFAIL_OUT(ret);
+            }
+
+            if (EXSUCCEED!=expr_gen(cc, a->r, &rt) ||
+                    NULL==expr_emit(cc, NDRX_EXPR_OP_BOOL, a, 0))
+            {
+                EXFAIL_OUT(ret);
+            }
+
+            cc->code[jmp].jmp = cc->ninstr;
+            *p_vtype = VALUE_TYPE_LONG;
+            break;
+        case NODE_TYPE_XOR:
+            if (NULL==expr_gen_bin(cc, a, NDRX_EXPR_OP_XOR, &lt, &rt))
+            {
+                EXFAIL_OUT(ret);
+            }
+            *p_vtype = VALUE_TYPE_LONG;
+            break;
+        case NODE_TYPE_EQOP:
+            
+            if (EQOP_REGEX_EQUAL==a->sub_type || EQOP_REGEX_NOT_EQUAL==a->sub_type)
+            {
+                /* regexp_eval() reads the operands by it self */
+                if (NULL==(in=expr_emit(cc, NDRX_EXPR_OP_REGEX, a, 1)))
+                {
+                    EXFAIL_OUT(ret);
+                }
+                in->inv = (EQOP_REGEX_NOT_EQUAL==a->sub_type);
+                *p_vtype = VALUE_TYPE_LONG;
+                break;
+            }
+            
+            if (NULL==(in=expr_gen_bin(cc, a, NDRX_EXPR_OP_BINOP, &lt, &rt)))
+            {
+                EXFAIL_OUT(ret);
+            }
+            in->type = NODE_TYPE_EQOP;
+            in->sub_type = NODE_SUB_TYPE_DEF;
+            in->inv = (EQOP_NOT_EQUAL==a->sub_type);
+            in->kind = expr_kind(in->type, in->sub_type, lt, rt);
+            break;
+        case NODE_TYPE_RELOP:
+        case NODE_TYPE_ADDOP:
+        case NODE_TYPE_MULTOP:
+            if (NULL==(in=expr_gen_bin(cc, a, NDRX_EXPR_OP_BINOP, &lt, &rt)))
+            {
+                EXFAIL_OUT(ret);
+            }
+            in->type = a->nodetype;
+            in->sub_type = a->sub_type;
+            in->kind = expr_kind(in->type, in->sub_type, lt, rt);
+            break;
+        case NODE_TYPE_UNARY:
+            if (EXSUCCEED!=expr_gen(cc, a->r, &rt) ||
+                    NULL==(in=expr_emit(cc, NDRX_EXPR_OP_UNARY, a, 0)))
+            {
+                EXFAIL_OUT(ret);
+            }
+            in->sub_type = a->sub_type;
+            break;
+        case NODE_TYPE_FLD:
+            {
+                struct ast_fld *fld = (struct ast_fld *)a;
+                int op;
+                
+                fld_type = Bfldtype(fld->fld.bfldid);
+                
+                switch (fld_type)
+                {
+                    case BFLD_SHORT:
+                    case BFLD_LONG:
+                        op = NDRX_EXPR_OP_FLDL;
+                        *p_vtype = VALUE_TYPE_LONG;
+                        break;
+                    case BFLD_FLOAT:
+                    case BFLD_DOUBLE:
+                        op = NDRX_EXPR_OP_FLDD;
+                        *p_vtype = VALUE_TYPE_FLOAT;
+                        break;
+                    case BFLD_STRING:
+                        op = (cc->inplace?NDRX_EXPR_OP_FLDS:NDRX_EXPR_OP_FLD);
+                        *p_vtype = VALUE_TYPE_FLD_STR;
+                        break;
+                    case BFLD_CHAR:
+                    case BFLD_CARRAY:
+                        op = NDRX_EXPR_OP_FLD;
+                        *p_vtype = VALUE_TYPE_FLD_STR;
+                        break;
+                    default:
+                        op = NDRX_EXPR_OP_FLD;
+                        break;
+                }
+                
+                if (NULL==(in=expr_emit(cc, op, a, 1)))
+                {
+                    EXFAIL_OUT(ret);
+                }
+                
+                in->kind = fld_type;
+                in->bfldid = fld->fld.bfldid;
+                in->occ = fld->fld.occ;
+            }
+            break;
+        case NODE_TYPE_FUNC:
+            if (NULL==expr_emit(cc, NDRX_EXPR_OP_FUNC, a, 1))
+            {
+                EXFAIL_OUT(ret);
+            }
+            *p_vtype = VALUE_TYPE_LONG;
+            break;
+        default:
+            /* constants are folded */
+            ndrx_Bset_error_fmt(BSYNTAX, "Cannot compile node %d type %d", 
+                    a->nodeid, a->nodetype);
+            EXFAIL_OUT(ret);
+            break;
+    }
+
+out:
+    return ret;
+}
+
+/**
+ * Compile the expression tree to bytecode.
+ * @param root parsed tree
+ * @return program node (owns the tree). If compile fails or tree is too deep
+ *  for the value stack, then tree is returned as is and it is evaluated
+ *  by recursive eval().
+ */
+expublic struct ast *ndrx_expr_compile(struct ast *root)
+{
+    struct ast_prog *prog = NULL;
+    expr_cc_t cc;
+    int vtype;
+
+    memset(&cc, 0, sizeof(cc));
+    cc.inplace = !expr_has_func(root);
+
+    if (EXSUCCEED!=expr_gen(&cc, root, &vtype))
+    {
+        UBF_LOG(log_warn, "Failed to compile expression: %s - using tree", 
+                Bstrerror(Berror));
+        ndrx_Bunset_error();
+        goto out;
+    }
+
+    if (cc.maxdepth > NDRX_EXPR_STACK_MAX)
+    {
+        UBF_LOG(log_info, "Expression needs %d stack values, max %d - using tree",
+                cc.maxdepth, NDRX_EXPR_STACK_MAX);
+        goto out;
+    }
+
+    if (NULL==(prog=NDRX_CALLOC(1, sizeof(struct ast_prog))))
+    {
+        UBF_LOG(log_warn, "Failed to malloc %d bytes: %s - using tree",
+                (int)sizeof(struct ast_prog), strerror(errno));
+        goto out;
+    }
+
+    prog->nodetype = NODE_TYPE_PROG;
+    prog->sub_type = NODE_SUB_TYPE_DEF;
+    prog->nodeid = EXFAIL;
+    prog->root = root;
+    prog->ninstr = cc.ninstr;
+    prog->code = cc.code;
+    cc.code = NULL;
+
+    UBF_LOG(log_debug, "Expression compiled to %d instructions, stack %d",
+            prog->ninstr, cc.maxdepth);
+
+out:
+
+    if (NULL!=cc.code)
+    {
+        NDRX_FREE(cc.code);
+    }
+
+    if (NULL==prog)
+    {
+        return root;
+    }
+
+    return (struct ast *)prog;
+}
+
+/**
+ * Read field to the value block, the same way as read_unary_fb() does
+ * @param p_ub UBF buffer
+ * @param in field load instruction
+ * @param v value block (zeroed)
+ * @return EXSUCCEED/EXFAIL
+ */
+exprivate int expr_fld(UBFH *p_ub, ndrx_expr_instr_t *in, value_block_t *v)
+{
+    int ret = EXSUCCEED;
+    char *data;
+    short s;
+    float f;
+
+    if (NDRX_EXPR_OP_FLD==in->op)
+    {
+        ret = read_unary_fb(p_ub, in->a, v);
+        goto out;
+    }
+
+    if (NULL==(data=ndrx_Bfind(p_ub, in->bfldid, in->occ, NULL, NULL)))
+    {
+        if (BNOTPRES!=Berror)
+        {
+            EXFAIL_OUT(ret);
+        }
+
+        ndrx_Bunset_error();
+        v->value_type = VALUE_TYPE_LONG;
+        v->is_null = EXTRUE;
+        goto out;
+    }
+
+    /* present fields are true */
+    v->boolval = EXTRUE;
+
+    switch (in->kind)
+    {
+        case BFLD_SHORT:
+            memcpy(&s, data, sizeof(s));
+            v->longval = s;
+            v->value_type = VALUE_TYPE_LONG;
+            break;
+        case BFLD_LONG:
+            memcpy(&v->longval, data, sizeof(v->longval));
+            v->value_type = VALUE_TYPE_LONG;
+            break;
+        case BFLD_FLOAT:
+            memcpy(&f, data, sizeof(f));
+            v->floatval = f;
+            v->value_type = VALUE_TYPE_FLOAT;
+            break;
+        case BFLD_DOUBLE:
+            memcpy(&v->floatval, data, sizeof(v->floatval));
+            v->value_type = VALUE_TYPE_FLOAT;
+            break;
+        case BFLD_STRING:
+            /* string is compared in place, no copy */
+            v->strval = data;
+            v->value_type = VALUE_TYPE_FLD_STR;
+            break;
+    }
+
+out:
+    return ret;
+}
+
+/**
+ * Evaluate the compiled program
+ * @param p_ub UBF buffer
+ * @param prog compiled program
+ * @param v result value
+ * @return EXSUCCEED/EXFAIL
+ */
+expublic int ndrx_expr_exec(UBFH *p_ub, struct ast_prog *prog, value_block_t *v)
+{
+    int ret = EXSUCCEED;
+    value_block_t stack[NDRX_EXPR_STACK_MAX];
+    value_block_t *top;
+    ndrx_expr_instr_t *in;
+    int sp = 0; /* number of values in stack */
+    int pc = 0;
+    int i;
+
+    if (NULL==prog->code)
+    {
+        return eval(p_ub, prog->root, v); /* <<< RETURN */
+    }
+
+    while (pc < prog->ninstr)
+    {
+        in = &prog->code[pc];
+        pc++;
+
+        switch (in->op)
+        {
+            case NDRX_EXPR_OP_CONST:
+                stack[sp] = in->cval;
+                sp++;
+                break;
+            case NDRX_EXPR_OP_FLDL:
+            case NDRX_EXPR_OP_FLDD:
+            case NDRX_EXPR_OP_FLDS:
+            case NDRX_EXPR_OP_FLD:
+                top = &stack[sp];
+                memset(top, 0, sizeof(*top));
+                sp++;
+
+                if (EXSUCCEED!=expr_fld(p_ub, in, top))
+                {
+                    EXFAIL_OUT(ret);
+                }
+                break;
+            case NDRX_EXPR_OP_FUNC:
+                top = &stack[sp];
+                memset(top, 0, sizeof(*top));
+                sp++;
+
+                if (EXSUCCEED!=read_unary_func(p_ub, in->a, top))
+                {
+                    EXFAIL_OUT(ret);
+                }
+                break;
+            case NDRX_EXPR_OP_REGEX:
+                top = &stack[sp];
+                memset(top, 0, sizeof(*top));
+                sp++;
+
+                if (EXSUCCEED!=regexp_eval(p_ub, in->a->l, in->a->r, top))
+                {
+                    EXFAIL_OUT(ret);
+                }
+
+                if (in->inv)
+                {
+                    top->boolval = !top->boolval;
+                    top->longval = !top->longval;
+                }
+                break;
+            case NDRX_EXPR_OP_BINOP:
+                {
+                    value_block_t res;
+                    memset(&res, 0, sizeof(res));
+
+                    if (EXSUCCEED!=op_equal_val(in->type, in->sub_type, in->kind,
+                            &stack[sp-2], &stack[sp-1], &res))
+                    {
+                        EXFAIL_OUT(ret);
+                    }
+
+                    if (in->inv)
+                    {
+                        res.boolval = !res.boolval;
+                        res.longval = !res.longval;
+                    }
+
+                    sp--;
+                    FREE_UP_UB_BUF((&stack[sp]));
+                    FREE_UP_UB_BUF((&stack[sp-1]));
+                    stack[sp-1] = res;
+                }
+                break;
+            case NDRX_EXPR_OP_UNARY:
+                {
+                    value_block_t res;
+                    memset(&res, 0, sizeof(res));
+
+                    if (EXSUCCEED!=process_unary_val(in->sub_type, 
+                            &stack[sp-1], &res))
+                    {
+                        EXFAIL_OUT(ret);
+                    }
+
+                    FREE_UP_UB_BUF((&stack[sp-1]));
+                    stack[sp-1] = res;
+                }
+                break;
+            case NDRX_EXPR_OP_ORJ:
+            case NDRX_EXPR_OP_ANDJ:
+                top = &stack[sp-1];
+                
+                if ((NDRX_EXPR_OP_ORJ==in->op && top->boolval) ||
+                        (NDRX_EXPR_OP_ANDJ==in->op && !top->boolval))
+                {
+                    /* result is known, right side is not evaluated */
+                    FREE_UP_UB_BUF(top);
+                    memset(top, 0, sizeof(*top));
+                    top->value_type = VALUE_TYPE_LONG;
+                    top->longval = top->boolval = (NDRX_EXPR_OP_ORJ==in->op);
+                    pc = in->jmp;
+                }
+                else
+                {
+                    FREE_UP_UB_BUF(top);
+                    sp--;
+                }
+                break;
+            case NDRX_EXPR_OP_BOOL:
+                top = &stack[sp-1];
+                i = (top->boolval?EXTRUE:EXFALSE);
+                FREE_UP_UB_BUF(top);
+                memset(top, 0, sizeof(*top));
+                top->value_type = VALUE_TYPE_LONG;
+                top->longval = top->boolval = i;
+                break;
+            case NDRX_EXPR_OP_XOR:
+                /* as tree evaluation does, only bool value is set */
+                i = ((stack[sp-2].boolval && !stack[sp-1].boolval) || 
+                        (!stack[sp-2].boolval && stack[sp-1].boolval));
+                sp--;
+                FREE_UP_UB_BUF((&stack[sp]));
+                top = &stack[sp-1];
+                FREE_UP_UB_BUF(top);
+                memset(top, 0, sizeof(*top));
+                top->value_type = VALUE_TYPE_LONG;
+                top->boolval = i;
+                break;
+        }
+    }
+
+    /* result is moved to the caller (may hold allocated field string) */
+    *v = stack[0];
+    sp = 0;
+
+out:
+
+    /* free up the stack on error */
+    for (i=0; i<sp; i++)
+    {
+        FREE_UP_UB_BUF((&stack[i]));
+    }
+
+    return ret;
+}
+
+/**
+ * Free up the compiled program and the tree
+ * @param prog program
+ */
+expublic void ndrx_expr_prog_free(struct ast_prog *prog)
+{
+    if (NULL!=prog->code)
+    {
+        NDRX_FREE(prog->code);
+    }
+
+    ndrx_Btreefree((char *)prog->root);
+    NDRX_FREE(prog);
+}
+
+/* vim: set ts=4 sw=4 et smartindent: */
@@ -0,0 +1,442 @@
+/**
+ * @brief Batch read & change of known fields (Bgetmulti/Bchgmulti)
+ *   Items are sorted by field id & occurrence, thus whole list is processed
+ *   in single forward pass over the buffer, instead of searching each field
+ *   from the start of the buffer.
+ *
+ * @file multi_impl.c
+ */
+/* -----------------------------------------------------------------------------
+ * Enduro/X Middleware Platform for Distributed Transaction Processing
+ * Copyright (C) 2009-2016, ATR Baltic, Ltd. All Rights Reserved.
+ * Copyright (C) 2017-2019, Mavimax, Ltd. All Rights Reserved.
+ * This software is released under one of the following licenses:
+ * AGPL (with Java and Go exceptions) or Mavimax's license for commercial use.
+ * See LICENSE file for full text.
+ * -----------------------------------------------------------------------------
+ * AGPL license:
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License, version 3 as published
+ * by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License, version 3
+ * for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * -----------------------------------------------------------------------------
+ * A commercial use license is available from Mavimax, Ltd
+ * contact@mavimax.com
+ * -----------------------------------------------------------------------------
+ */
+
+/*---------------------------Includes-----------------------------------*/
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <memory.h>
+#include <limits.h>
+
+#include <ubf.h>
+#include <ubf_int.h>
+#include <fdatatype.h>
+#include <ferror.h>
+#include <ndrstandard.h>
+#include <ndebug.h>
+#include <cf.h>
+#include <ubf_impl.h>
+/*---------------------------Externs------------------------------------*/
+/*---------------------------Macros-------------------------------------*/
+#define FLD_AT(P)       (*((BFLDID *)(P)))  /**< field id at position */
+
+/**
+ * Copy pending run of unchanged fields to the output
+ */
+#define MULTI_FLUSH \
+    if (src > run)\
+    {\
+        if (dst + (src - run) > dst_end)\
+        {\
+            ndrx_Bset_error_fmt(BNOSPACE, "No space for field %d", \
+                    items[i].bfldid);\
+            items[i].err = BNOSPACE;\
+            EXFAIL_OUT(ret);\
+        }\
+        memcpy(dst, run, src - run);\
+        dst+=(src - run);\
+        run = src;\
+    }
+/*---------------------------Enums--------------------------------------*/
+/*---------------------------Typedefs-----------------------------------*/
+/*---------------------------Globals------------------------------------*/
+/*---------------------------Statics------------------------------------*/
+/*---------------------------Prototypes---------------------------------*/
+
+/**
+ * Validate the item list
+ * @param items items to check
+ * @param n number of items
+ * @param chg EXTRUE - validate for change
+ * @return EXSUCCEED/EXFAIL (BEINVAL if list is not sorted)
+ */
+exprivate int multi_validate(Bfld_multi_t *items, int n, int chg)
+{
+    int ret = EXSUCCEED;
+    int i;
+
+    for (i=0; i<n; i++)
+    {
+        items[i].err = 0;
+
+        if (i > 0 && (items[i].bfldid < items[i-1].bfldid ||
+                (items[i].bfldid==items[i-1].bfldid &&
+                    items[i].occ<=items[i-1].occ)))
+        {
+            ndrx_Bset_error_fmt(BEINVAL, "Items not sorted at %d (fld %d occ %d)",
+                    i, items[i].bfldid, items[i].occ);
+            items[i].err = BEINVAL;
+            EXFAIL_OUT(ret);
+        }
+
+        if (BBADFLDID==items[i].bfldid ||
+                IS_TYPE_INVALID(items[i].bfldid>>EFFECTIVE_BITS))
+        {
+            items[i].err = BBADFLD;
+        }
+        else if (items[i].occ < 0 || NULL==items[i].buf)
+        {
+            items[i].err = BEINVAL;
+        }
+        else if (EXFAIL!=items[i].usrtype && IS_TYPE_INVALID(items[i].usrtype))
+        {
+            items[i].err = BTYPERR;
+        }
+
+        /* change is all or nothing */
+        if (chg && 0!=items[i].err)
+        {
+            ndrx_Bset_error_fmt(items[i].err, "Invalid item %d (fld %d occ %d)",
+                    i, items[i].bfldid, items[i].occ);
+            EXFAIL_OUT(ret);
+        }
+    }
+
+out:
+    return ret;
+}
+
+/**
+ * Read the list of fields. Fields are located by forward scan, continued
+ * from the position of the previous item. When next item is of other type,
+ * scan jumps to the start of the type (from the type offset cache).
+ * @param p_ub UBF buffer
+ * @param items items to read, sorted by field id & occurrence
+ * @param n number of items
+ * @return number of items read, EXFAIL on error. Item which was not read
+ *  has the error code set in err field.
+ */
+expublic int ndrx_Bgetmulti(UBFH *p_ub, Bfld_multi_t *items, int n)
+{
+    int ret = EXSUCCEED;
+    UBF_header_t *hdr = (UBF_header_t *)p_ub;
+    char *p = (char *)&hdr->bfldid;
+    char *end = (char *)hdr + hdr->bytes_used;
+    char *fld;
+    char *start;
+    BFLDID cur_fld = BBADFLDID;
+    BFLDOCC cur_occ = 0;
+    BFLDLEN dlen;
+    BFLDLEN len;
+    int i;
+    int type;
+    int got = 0;
+    dtype_str_t *dtype;
+    dtype_ext1_t *ext1;
+
+    if (EXSUCCEED!=multi_validate(items, n, EXFALSE))
+    {
+        EXFAIL_OUT(ret);
+    }
+
+    for (i=0; i<n; i++)
+    {
+        if (0!=items[i].err)
+        {
+            continue;
+        }
+
+        type = items[i].bfldid>>EFFECTIVE_BITS;
+        fld = NULL;
+
+        if (items[i].bfldid!=cur_fld)
+        {
+            /* skip to the type, if not there yet */
+            start = ndrx_ubf_type_start(p_ub, type);
+
+            if (start > p)
+            {
+                p = start;
+            }
+
+            while (p < end && FLD_AT(p) < items[i].bfldid)
+            {
+                dtype = &G_dtype_str_map[FLD_AT(p)>>EFFECTIVE_BITS];
+                p+=dtype->p_next(dtype, p, NULL);
+            }
+
+            cur_fld = items[i].bfldid;
+            cur_occ = 0;
+        }
+
+        /* p is at cur_occ of the field (if present) */
+        dtype = &G_dtype_str_map[type];
+
+        while (p < end && FLD_AT(p)==cur_fld && cur_occ < items[i].occ)
+        {
+            p+=dtype->p_next(dtype, p, NULL);
+            cur_occ++;
+        }
+
+        if (p < end && FLD_AT(p)==cur_fld)
+        {
+            fld = p;
+        }
+
+        if (NULL==fld)
+        {
+            items[i].err = BNOTPRES;
+            continue;
+        }
+
+        /* 0 - buffer size not checked, but data len is returned anyway */
+        len = items[i].len > 0 ? items[i].len : INT_MAX;
+
+        if (EXFAIL==items[i].usrtype || items[i].usrtype==type)
+        {
+            if (EXSUCCEED!=dtype->p_get_data(dtype, fld, items[i].buf, &len))
+            {
+                items[i].err = Berror;
+                continue;
+            }
+        }
+        else
+        {
+            ext1 = &G_dtype_ext1_map[type];
+            dtype->p_next(dtype, fld, &dlen);
+
+            if (NULL==ndrx_ubf_convert(type, CNV_DIR_OUT, fld+ext1->hdr_size,
+                    dlen, items[i].usrtype, items[i].buf, &len))
+            {
+                items[i].err = Berror;
+                continue;
+            }
+        }
+
+        items[i].len = len;
+        got++;
+    }
+
+    ret = got;
+
+    UBF_LOG(log_debug, "Bgetmulti: %d of %d items read", got, n);
+
+out:
+    /* item errors are reported in items */
+    if (ret >= 0)
+    {
+        ndrx_Bunset_error();
+    }
+
+    return ret;
+}
+
+/**
+ * Change the list of fields. The buffer is rebuilt in single pass to the
+ * temporary buffer: unchanged fields are copied in runs, changed fields are
+ * written in place of the old values, missing occurrences are filled with
+ * empty values (as Bchg() does). Buffer is not changed if any of the items
+ * fails.
+ * @param p_ub UBF buffer
+ * @param items items to change, sorted by field id & occurrence
+ * @param n number of items
+ * @return EXSUCCEED/EXFAIL
+ */
+expublic int ndrx_Bchgmulti(UBFH *p_ub, Bfld_multi_t *items, int n)
+{
+    int ret = EXSUCCEED;
+    UBF_header_t *hdr = (UBF_header_t *)p_ub;
+    char *data = (char *)&hdr->bfldid;
+    char *end = (char *)hdr + hdr->bytes_used;
+    char *src = data;
+    char *run = data;
+    char *tmp = NULL;
+    char *dst;
+    char *dst_end;
+    char *start;
+    char *val;
+    char *alloc_buf = NULL;
+    char tmp_buf[CF_TEMP_BUF_MAX];
+    int cvn_len;
+    int i;
+    int type;
+    int sz;
+    BFLDOCC occ = 0;
+    dtype_str_t *dtype;
+    dtype_ext1_t *ext1;
+
+    if (EXSUCCEED!=multi_validate(items, n, EXTRUE))
+    {
+        EXFAIL_OUT(ret);
+    }
+
+    if (0==n)
+    {
+        goto out;
+    }
+
+    if (NULL==(tmp = NDRX_MALLOC(hdr->buf_len)))
+    {
+        ndrx_Bset_error_fmt(BMALLOC, "Failed to malloc %d bytes", hdr->buf_len);
+        EXFAIL_OUT(ret);
+    }
+
+    dst = tmp + (data - (char *)hdr);
+    dst_end = tmp + hdr->buf_len;
+
+    for (i=0; i<n; i++)
+    {
+        type = items[i].bfldid>>EFFECTIVE_BITS;
+        dtype = &G_dtype_str_map[type];
+        ext1 = &G_dtype_ext1_map[type];
+
+        if (0==i || items[i].bfldid!=items[i-1].bfldid)
+        {
+            /* skip to the field, skipped ones are copied as is */
+            start = ndrx_ubf_type_start(p_ub, type);
+
+            if (start > src)
+            {
+                src = start;
+            }
+
+            while (src < end && FLD_AT(src) < items[i].bfldid)
+            {
+                dtype_str_t *t = &G_dtype_str_map[FLD_AT(src)>>EFFECTIVE_BITS];
+                src+=t->p_next(t, src, NULL);
+            }
+
+            occ = 0;
+        }
+
+        /* keep old occurrences before the changed one, or add empties */
+        while (occ < items[i].occ)
+        {
+            if (src < end && FLD_AT(src)==items[i].bfldid)
+            {
+                src+=dtype->p_next(dtype, src, NULL);
+            }
+            else
+            {
+                MULTI_FLUSH;
+                sz = ext1->p_empty_sz(ext1);
+
+                if (dst + sz > dst_end)
+                {
+                    ndrx_Bset_error_fmt(BNOSPACE, "No space for field %d",
+                            items[i].bfldid);
+                    items[i].err = BNOSPACE;
+                    EXFAIL_OUT(ret);
+                }
+
+                ext1->p_put_empty(ext1, dst, items[i].bfldid);
+                dst+=sz;
+            }
+
+            occ++;
+        }
+
+        MULTI_FLUSH;
+
+        /* drop old value */
+        if (src < end && FLD_AT(src)==items[i].bfldid)
+        {
+            src+=dtype->p_next(dtype, src, NULL);
+            run = src;
+        }
+
+        val = items[i].buf;
+        cvn_len = items[i].len;
+
+        if (EXFAIL!=items[i].usrtype && items[i].usrtype!=type)
+        {
+            char *p;
+
+            if (NULL==(p=ndrx_ubf_get_cbuf(items[i].usrtype, type, tmp_buf,
+                    items[i].buf, items[i].len, &alloc_buf, &cvn_len,
+                    CB_MODE_DEFAULT, 0)) ||
+                NULL==(val=ndrx_ubf_convert(items[i].usrtype, CNV_DIR_IN,
+                    items[i].buf, items[i].len, type, p, &cvn_len)))
+            {
+                items[i].err = Berror;
+                EXFAIL_OUT(ret);
+            }
+        }
+
+        sz = dtype->p_get_data_size(dtype, val, cvn_len, NULL);
+
+        if (dst + sz > dst_end)
+        {
+            ndrx_Bset_error_fmt(BNOSPACE, "No space for field %d",
+                    items[i].bfldid);
+            items[i].err = BNOSPACE;
+            EXFAIL_OUT(ret);
+        }
+
+        dtype->p_put_data(dtype, dst, items[i].bfldid, val, cvn_len);
+        dst+=sz;
+        occ++;
+
+        if (NULL!=alloc_buf)
+        {
+            NDRX_FREE(alloc_buf);
+            alloc_buf = NULL;
+        }
+    }
+
+    /* rest of the buffer */
+    src = end;
+    i = n-1;
+    MULTI_FLUSH;
+
+    /* install the new data */
+    memcpy(data, tmp + (data - (char *)hdr), dst - (tmp + (data - (char *)hdr)));
+    hdr->bytes_used = (BFLDLEN)(dst - tmp);
+
+    if (EXSUCCEED!=ubf_cache_update(p_ub))
+    {
+        EXFAIL_OUT(ret);
+    }
+
+    UBF_LOG(log_debug, "Bchgmulti: %d items changed, bytes used %d",
+            n, hdr->bytes_used);
+
+out:
+    if (NULL!=alloc_buf)
+    {
+        NDRX_FREE(alloc_buf);
+    }
+
+    if (NULL!=tmp)
+    {
+        NDRX_FREE(tmp);
+    }
+
+    return ret;
+}
+
+/* vim: set ts=4 sw=4 et smartindent: */
@@ -221,6 +221,58 @@ expublic int Bget (UBFH * p_ub, BFLDID bfldid, BFLDOCC occ,
     return ndrx_Bget (p_ub, bfldid, occ, buf, buflen);
 }
 
+/**
+ * Read list of fields in single pass
+ * @param p_ub UBF buffer
+ * @param items items to read, sorted by field id & occurrence
+ * @param n number of items
+ * @return number of items read or EXFAIL
+ */
+expublic int Bgetmulti(UBFH *p_ub, Bfld_multi_t *items, int n)
+{
+    API_ENTRY;
+
+    if (EXSUCCEED!=validate_entry(p_ub, 0, 0, VALIDATE_MODE_NO_FLD))
+    {
+        UBF_LOG(log_warn, "Bgetmulti: arguments fail!");
+        return EXFAIL; /* <<<< RETURN HERE! */
+    }
+    
+    if (n < 0 || (n > 0 && NULL==items))
+    {
+        ndrx_Bset_error_fmt(BEINVAL, "Invalid items %p / n %d", items, n);
+        return EXFAIL; /* <<<< RETURN HERE! */
+    }
+
+    return ndrx_Bgetmulti(p_ub, items, n);
+}
+
+/**
+ * Change list of fields in single pass
+ * @param p_ub UBF buffer
+ * @param items items to change, sorted by field id & occurrence
+ * @param n number of items
+ * @return EXSUCCEED/EXFAIL
+ */
+expublic int Bchgmulti(UBFH *p_ub, Bfld_multi_t *items, int n)
+{
+    API_ENTRY;
+
+    if (EXSUCCEED!=validate_entry(p_ub, 0, 0, VALIDATE_MODE_NO_FLD))
+    {
+        UBF_LOG(log_warn, "Bchgmulti: arguments fail!");
+        return EXFAIL; /* <<<< RETURN HERE! */
+    }
+    
+    if (n < 0 || (n > 0 && NULL==items))
+    {
+        ndrx_Bset_error_fmt(BEINVAL, "Invalid items %p / n %d", items, n);
+        return EXFAIL; /* <<<< RETURN HERE! */
+    }
+
+    return ndrx_Bchgmulti(p_ub, items, n);
+}
+
 /**
  * Delete specific field from buffer
  * @param p_ub
@@ -0,0 +1,700 @@
+/**
+ * @brief UBF bulk builder - collect fields in any order, lay out buffer once
+ *   Builder keeps (field id, occurrence, value) tuples in the scratch arena.
+ *   When finalized, tuples are radix sorted by field id (insertion order is
+ *   kept for the occurrences of the same field), the buffer size is computed
+ *   precisely and the fields are written to the buffer in single pass.
+ *   Resulting buffer has the same layout (field offsets and values) as the
+ *   buffer produced by the sequence of Bchg()/Badd() calls with the same
+ *   arguments, and it is byte-for-byte the same as the buffer built by
+ *   appending the final values to an empty buffer.
+ *
+ * @file ubf_bld.c
+ */
+/* -----------------------------------------------------------------------------
+ * Enduro/X Middleware Platform for Distributed Transaction Processing
+ * Copyright (C) 2009-2016, ATR Baltic, Ltd. All Rights Reserved.
+ * Copyright (C) 2017-2019, Mavimax, Ltd. All Rights Reserved.
+ * This software is released under one of the following licenses:
+ * AGPL (with Java and Go exceptions) or Mavimax's license for commercial use.
+ * See LICENSE file for full text.
+ * -----------------------------------------------------------------------------
+ * AGPL license:
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License, version 3 as published
+ * by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License, version 3
+ * for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * -----------------------------------------------------------------------------
+ * A commercial use license is available from Mavimax, Ltd
+ * contact@mavimax.com
+ * -----------------------------------------------------------------------------
+ */
+
+/*---------------------------Includes-----------------------------------*/
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <memory.h>
+
+#include <ubf.h>
+#include <ubf_int.h>
+#include <fdatatype.h>
+#include <ferror.h>
+#include <ndrstandard.h>
+#include <ndebug.h>
+#include <ubf_impl.h>
+/*---------------------------Externs------------------------------------*/
+/*---------------------------Macros-------------------------------------*/
+#define API_ENTRY {ndrx_Bunset_error(); \
+}\
+
+#define BLD_ENTS_DFLT       64      /**< initial number of tuples           */
+#define BLD_ARENA_DFLT      1024    /**< initial arena size                 */
+#define BLD_ARENA_ALIGN     8       /**< value alignment in arena           */
+#define BLD_RADIX_BITS      8       /**< bits sorted per radix pass         */
+#define BLD_RADIX           (1<<BLD_RADIX_BITS)
+#define BLD_RADIX_PASSES    ((int)sizeof(uint64_t)*8/BLD_RADIX_BITS)
+
+/** sort key: field id in high half, insertion order in low half */
+#define BLD_KEY(FLD, SEQ)   (((uint64_t)(unsigned)(FLD))<<32 | (uint64_t)(unsigned)(SEQ))
+#define BLD_KEY_FLD(KEY)    ((BFLDID)((KEY)>>32))
+#define BLD_KEY_SEQ(KEY)    ((int)((KEY) & 0xffffffff))
+/*---------------------------Enums--------------------------------------*/
+/*---------------------------Typedefs-----------------------------------*/
+
+/**
+ * Single value added to the builder
+ */
+typedef struct
+{
+    BFLDID bfldid;          /**< field id                               */
+    BFLDOCC occ;            /**< occurrence, -1 for add                 */
+    BFLDLEN len;            /**< value length in arena                  */
+    long off;               /**< value offset in arena                  */
+} ndrx_ubf_bld_ent_t;
+
+/**
+ * Builder handle
+ */
+struct ndrx_ubf_bld
+{
+    ndrx_ubf_bld_ent_t *ents;   /**< tuples added, in insertion order   */
+    uint64_t *keys;             /**< sort keys of tuples                */
+    uint64_t *keys_tmp;         /**< radix sort scratch                 */
+    int nents;                  /**< tuples used                        */
+    int nents_alloc;            /**< tuples allocated                   */
+
+    char *arena;                /**< value storage                      */
+    long arena_used;            /**< bytes used in arena                */
+    long arena_alloc;           /**< arena size                         */
+
+    ndrx_ubf_bld_ent_t **slots; /**< per field occurrence scratch      */
+    int nslots_alloc;           /**< scratch size                       */
+
+    int sorted;                 /**< keys are sorted                    */
+    long datasz;                /**< laid out data size, EXFAIL unknown */
+};
+
+/*---------------------------Globals------------------------------------*/
+/*---------------------------Statics------------------------------------*/
+/*---------------------------Prototypes---------------------------------*/
+
+/**
+ * LSD radix sort of the tuple keys. Sort is stable, thus the insertion
+ * order of the same field tuples is kept. Passes where all keys have the
+ * same digit (e.g. high bits of insertion order) are skipped.
+ * @param bld builder
+ */
+exprivate void bld_sort(Bbld_t *bld)
+{
+    int cnt[BLD_RADIX_PASSES][BLD_RADIX];
+    int pass, i, d;
+    int sum, tmp;
+    int shift;
+    uint64_t *src = bld->keys;
+    uint64_t *dst = bld->keys_tmp;
+    uint64_t *swp;
+
+    memset(cnt, 0, sizeof(cnt));
+
+    for (i=0; i<bld->nents; i++)
+    {
+        for (pass=0; pass<BLD_RADIX_PASSES; pass++)
+        {
+            cnt[pass][(src[i]>>(pass*BLD_RADIX_BITS)) & (BLD_RADIX-1)]++;
+        }
+    }
+
+    for (pass=0; pass<BLD_RADIX_PASSES; pass++)
+    {
+        shift = pass*BLD_RADIX_BITS;
+
+        if (cnt[pass][(src[0]>>shift) & (BLD_RADIX-1)]==bld->nents)
+        {
+            continue;
+        }
+
+        for (sum=0, d=0; d<BLD_RADIX; d++)
+        {
+            tmp = cnt[pass][d];
+            cnt[pass][d] = sum;
+            sum+=tmp;
+        }
+
+        for (i=0; i<bld->nents; i++)
+        {
+            dst[cnt[pass][(src[i]>>shift) & (BLD_RADIX-1)]++] = src[i];
+        }
+
+        swp = src;
+        src = dst;
+        dst = swp;
+    }
+
+    /* result shall be in the keys array */
+    bld->keys = src;
+    bld->keys_tmp = dst;
+}
+
+/**
+ * Resolve the occurrences of single field in the order of Bchg()/Badd()
+ * calls. Empty slots (NULL) are the occurrences which Bchg() would fill
+ * with empty values.
+ * @param bld builder
+ * @param keys sorted keys of the field tuples
+ * @param n number of tuples
+ * @param nslots number of occurrences resolved
+ * @return EXSUCCEED/EXFAIL (malloc error)
+ */
+exprivate int bld_resolve(Bbld_t *bld, uint64_t *keys, int n,
+        int *nslots)
+{
+    int ret = EXSUCCEED;
+    int i;
+    int cnt = 0;
+    BFLDOCC occ;
+    ndrx_ubf_bld_ent_t *ent;
+
+    for (i=0; i<n; i++)
+    {
+        ent = &bld->ents[BLD_KEY_SEQ(keys[i])];
+        occ = ent->occ;
+
+        if (EXFAIL==occ)
+        {
+            occ = cnt;
+        }
+
+        if (occ >= bld->nslots_alloc)
+        {
+            int newsz = bld->nslots_alloc*2;
+            ndrx_ubf_bld_ent_t **tmp;
+
+            if (newsz <= occ)
+            {
+                newsz = occ+1;
+            }
+
+            tmp = NDRX_REALLOC(bld->slots, sizeof(ndrx_ubf_bld_ent_t *)*newsz);
+
+            if (NULL==tmp)
+            {
+                ndrx_Bset_error_fmt(BMALLOC, "Failed to realloc %ld bytes",
+                        (long)sizeof(ndrx_ubf_bld_ent_t *)*newsz);
+                EXFAIL_OUT(ret);
+            }
+
+            bld->slots = tmp;
+            bld->nslots_alloc = newsz;
+        }
+
+        while (cnt < occ)
+        {
+            bld->slots[cnt] = NULL;
+            cnt++;
+        }
+
+        bld->slots[occ] = ent;
+
+        if (occ==cnt)
+        {
+            cnt++;
+        }
+    }
+
+    *nslots = cnt;
+
+out:
+    return ret;
+}
+
+/**
+ * Walk the sorted tuples, compute the data size and optionally write the
+ * fields to the buffer.
+ * @param bld builder
+ * @param p where to write the fields, NULL if only size is needed
+ * @param p_datasz data size of the fields
+ * @return EXSUCCEED/EXFAIL
+ */
+exprivate int bld_layout(Bbld_t *bld, char *p, long *p_datasz)
+{
+    int ret = EXSUCCEED;
+    int i, j, k;
+    int nslots;
+    int type;
+    long datasz = 0;
+    int sz;
+    dtype_str_t *dtype;
+    dtype_ext1_t *ext1;
+    ndrx_ubf_bld_ent_t *ent;
+    BFLDID bfldid;
+
+    if (!bld->sorted)
+    {
+        bld_sort(bld);
+        bld->sorted = EXTRUE;
+    }
+
+    for (i=0; i<bld->nents; i=j)
+    {
+        bfldid = BLD_KEY_FLD(bld->keys[i]);
+
+        for (j=i+1; j<bld->nents && BLD_KEY_FLD(bld->keys[j])==bfldid; j++)
+        {
+            /* find end of the field group */
+        }
+
+        type = bfldid>>EFFECTIVE_BITS;
+        dtype = &G_dtype_str_map[type];
+        ext1 = &G_dtype_ext1_map[type];
+
+        if (EXSUCCEED!=bld_resolve(bld, &bld->keys[i], j-i, &nslots))
+        {
+            EXFAIL_OUT(ret);
+        }
+
+        for (k=0; k<nslots; k++)
+        {
+            ent = bld->slots[k];
+
+            if (NULL==ent)
+            {
+                sz = ext1->p_empty_sz(ext1);
+
+                if (NULL!=p)
+                {
+                    ext1->p_put_empty(ext1, p, bfldid);
+                }
+            }
+            else
+            {
+                sz = dtype->p_get_data_size(dtype, bld->arena+ent->off,
+                        ent->len, NULL);
+
+                if (NULL!=p && EXSUCCEED!=dtype->p_put_data(dtype, p,
+                        ent->bfldid, bld->arena+ent->off, ent->len))
+                {
+                    ndrx_Bset_error_fmt(BEUNIX, "Failed to put field %d data",
+                            ent->bfldid);
+                    EXFAIL_OUT(ret);
+                }
+            }
+
+            datasz+=sz;
+
+            if (NULL!=p)
+            {
+                p+=sz;
+            }
+        }
+    }
+
+    *p_datasz = datasz;
+
+out:
+    return ret;
+}
+
+/**
+ * Double the tuple arrays
+ * @param bld builder
+ * @return EXSUCCEED/EXFAIL (BMALLOC)
+ */
+exprivate int bld_grow(Bbld_t *bld)
+{
+    int ret = EXSUCCEED;
+    int newsz = bld->nents_alloc*2;
+    void *tmp;
+
+    if (NULL==(tmp = NDRX_REALLOC(bld->ents, sizeof(ndrx_ubf_bld_ent_t)*newsz)))
+    {
+        ndrx_Bset_error_fmt(BMALLOC, "Failed to grow builder to %d tuples", newsz);
+        EXFAIL_OUT(ret);
+    }
+    bld->ents = tmp;
+
+    if (NULL==(tmp = NDRX_REALLOC(bld->keys, sizeof(uint64_t)*newsz)))
+    {
+        ndrx_Bset_error_fmt(BMALLOC, "Failed to grow builder to %d tuples", newsz);
+        EXFAIL_OUT(ret);
+    }
+    bld->keys = tmp;
+
+    if (NULL==(tmp = NDRX_REALLOC(bld->keys_tmp, sizeof(uint64_t)*newsz)))
+    {
+        ndrx_Bset_error_fmt(BMALLOC, "Failed to grow builder to %d tuples", newsz);
+        EXFAIL_OUT(ret);
+    }
+    bld->keys_tmp = tmp;
+
+    bld->nents_alloc = newsz;
+
+out:
+    return ret;
+}
+
+/**
+ * Allocate new builder
+ * @param nrfields expected number of fields, 0 for default
+ * @param totsize expected data size, 0 for default
+ * @return builder handle or NULL (BMALLOC)
+ */
+expublic Bbld_t * Bbldnew(BFLDOCC nrfields, BFLDLEN totsize)
+{
+    Bbld_t *bld = NULL;
+    API_ENTRY;
+
+    if (nrfields<=0)
+    {
+        nrfields = BLD_ENTS_DFLT;
+    }
+
+    if (totsize<=0)
+    {
+        totsize = BLD_ARENA_DFLT;
+    }
+
+    if (NULL==(bld = NDRX_CALLOC(1, sizeof(Bbld_t))))
+    {
+        ndrx_Bset_error_fmt(BMALLOC, "Failed to alloc %ld bytes",
+                (long)sizeof(Bbld_t));
+        goto out;
+    }
+
+    bld->ents = NDRX_MALLOC(sizeof(ndrx_ubf_bld_ent_t)*nrfields);
+    bld->keys = NDRX_MALLOC(sizeof(uint64_t)*nrfields);
+    bld->keys_tmp = NDRX_MALLOC(sizeof(uint64_t)*nrfields);
+    bld->arena = NDRX_MALLOC(totsize);
+
+    if (NULL==bld->ents || NULL==bld->keys || NULL==bld->keys_tmp ||
+            NULL==bld->arena)
+    {
+        ndrx_Bset_error_fmt(BMALLOC, "Failed to alloc builder for %d fields "
+                "/ %d bytes", nrfields, totsize);
+        Bbldfree(bld);
+        bld = NULL;
+        goto out;
+    }
+
+    bld->nents_alloc = nrfields;
+    bld->arena_alloc = totsize;
+    bld->sorted = EXTRUE;
+    bld->datasz = 0;
+
+out:
+    return bld;
+}
+
+/**
+ * Add or change the field value in the builder. Semantics are the same as
+ * for the Bchg(), i.e. occ -1 adds new occurrence, occurrence over the
+ * current count fills the missing ones with empty values and existing
+ * occurrence is replaced. Value is copied to the builder.
+ * @param bld builder
+ * @param bfldid field id
+ * @param occ occurrence, -1 to add
+ * @param buf value, must not be NULL (field deletion is not supported)
+ * @param len value len (for carray)
+ * @return EXSUCCEED/EXFAIL
+ */
+expublic int Bbldchg(Bbld_t *bld, BFLDID bfldid, BFLDOCC occ,
+        char *buf, BFLDLEN len)
+{
+    int ret = EXSUCCEED;
+    int type;
+    long valsz;
+    long off;
+    ndrx_ubf_bld_ent_t *ent;
+    API_ENTRY;
+
+    type = bfldid>>EFFECTIVE_BITS;
+
+    if (NULL==bld)
+    {
+        ndrx_Bset_error_msg(BEINVAL, "Builder is NULL");
+        EXFAIL_OUT(ret);
+    }
+    else if (BBADFLDID==bfldid || IS_TYPE_INVALID(type))
+    {
+        ndrx_Bset_error_fmt(BBADFLD, "Invalid bfldid %d", bfldid);
+        EXFAIL_OUT(ret);
+    }
+    else if (occ < -1)
+    {
+        ndrx_Bset_error_msg(BEINVAL, "occ < -1");
+        EXFAIL_OUT(ret);
+    }
+    else if (NULL==buf)
+    {
+        ndrx_Bset_error_msg(BEINVAL, "buf is NULL (delete not supported)");
+        EXFAIL_OUT(ret);
+    }
+
+    switch (type)
+    {
+        case BFLD_STRING:
+            valsz = strlen(buf)+1;
+            break;
+        case BFLD_CARRAY:
+
+            if (len < 0)
+            {
+                ndrx_Bset_error_fmt(BEINVAL, "Invalid carray len %d", len);
+                EXFAIL_OUT(ret);
+            }
+
+            valsz = len;
+            break;
+        default:
+            valsz = G_dtype_str_map[type].size;
+            break;
+    }
+
+    if (bld->nents==bld->nents_alloc && EXSUCCEED!=bld_grow(bld))
+    {
+        EXFAIL_OUT(ret);
+    }
+
+    off = (bld->arena_used + BLD_ARENA_ALIGN - 1) & ~((long)BLD_ARENA_ALIGN - 1);
+
+    if (off+valsz > bld->arena_alloc)
+    {
+        long newsz = bld->arena_alloc*2;
+        char *tmp;
+
+        if (newsz < off+valsz)
+        {
+            newsz = off+valsz;
+        }
+
+        if (NULL==(tmp = NDRX_REALLOC(bld->arena, newsz)))
+        {
+            ndrx_Bset_error_fmt(BMALLOC, "Failed to realloc %ld bytes", newsz);
+            EXFAIL_OUT(ret);
+        }
+
+        bld->arena = tmp;
+        bld->arena_alloc = newsz;
+    }
+
+    memcpy(bld->arena+off, buf, valsz);
+    bld->arena_used = off+valsz;
+
+    ent = &bld->ents[bld->nents];
+    ent->bfldid = bfldid;
+    ent->occ = occ;
+    ent->len = (BFLDLEN)valsz;
+    ent->off = off;
+
+    bld->keys[bld->nents] = BLD_KEY(bfldid, bld->nents);
+
+    if (bld->sorted && bld->nents > 0 &&
+            BLD_KEY_FLD(bld->keys[bld->nents-1]) > bfldid)
+    {
+        bld->sorted = EXFALSE;
+    }
+
+    bld->nents++;
+    bld->datasz = EXFAIL;
+
+out:
+    return ret;
+}
+
+/**
+ * Add field occurrence to the builder, same as Badd()
+ * @param bld builder
+ * @param bfldid field id
+ * @param buf value
+ * @param len value len (for carray)
+ * @return EXSUCCEED/EXFAIL
+ */
+expublic int Bbldadd(Bbld_t *bld, BFLDID bfldid, char *buf, BFLDLEN len)
+{
+    return Bbldchg(bld, bfldid, EXFAIL, buf, len);
+}
+
+/**
+ * Return the exact UBF buffer size needed to hold the builder's fields.
+ * Value can be used for Balloc()/tpalloc() sizing.
+ * @param bld builder
+ * @return buffer size in bytes or EXFAIL
+ */
+expublic long Bbldsize(Bbld_t *bld)
+{
+    long sz;
+    API_ENTRY;
+
+    if (NULL==bld)
+    {
+        ndrx_Bset_error_msg(BEINVAL, "Builder is NULL");
+        return EXFAIL;
+    }
+
+    if (EXFAIL==bld->datasz &&
+            EXSUCCEED!=bld_layout(bld, NULL, &bld->datasz))
+    {
+        bld->datasz = EXFAIL;
+        return EXFAIL;
+    }
+
+    /* Bneeded() keeps space for the terminating field id, but sequential
+     * API fills the buffer up to the last byte, thus use the same limit
+     */
+    sz = ndrx_Bneeded(0, bld->datasz) - FF_USED_BYTES;
+
+    if (sz < sizeof(UBF_header_t))
+    {
+        sz = sizeof(UBF_header_t);
+    }
+
+    return sz;
+}
+
+/**
+ * Write the builder's fields to the empty UBF buffer
+ * @param bld builder
+ * @param p_ub empty UBF buffer (just initialized/allocated)
+ * @return EXSUCCEED/EXFAIL (BEINVAL if buffer not empty, BNOSPACE if
+ *  buffer is too short)
+ */
+expublic int Bbldfinal(Bbld_t *bld, UBFH *p_ub)
+{
+    int ret = EXSUCCEED;
+    UBF_header_t *hdr = (UBF_header_t *)p_ub;
+    long datasz;
+    char *p;
+    API_ENTRY;
+
+    if (EXSUCCEED!=validate_entry(p_ub, 0, 0, VALIDATE_MODE_NO_FLD))
+    {
+        UBF_LOG(log_warn, "Bbldfinal: arguments fail!");
+        EXFAIL_OUT(ret);
+    }
+
+    if (hdr->bytes_used!=sizeof(UBF_header_t) - FF_USED_BYTES)
+    {
+        ndrx_Bset_error_msg(BEINVAL, "Target buffer is not empty");
+        EXFAIL_OUT(ret);
+    }
+
+    if (EXFAIL==Bbldsize(bld))
+    {
+        EXFAIL_OUT(ret);
+    }
+
+    datasz = bld->datasz;
+
+    if (!have_buffer_size(p_ub, datasz, EXTRUE))
+    {
+        UBF_LOG(log_warn, "Bbldfinal failed - out of buffer memory!");
+        EXFAIL_OUT(ret);
+    }
+
+    p = (char *)p_ub + hdr->bytes_used;
+
+    /* padding is not written by data put functions */
+    memset(p, 0, datasz);
+
+    if (EXSUCCEED!=bld_layout(bld, p, &datasz))
+    {
+        EXFAIL_OUT(ret);
+    }
+
+    hdr->bytes_used+=datasz;
+
+    if (EXSUCCEED!=ubf_cache_update(p_ub))
+    {
+        EXFAIL_OUT(ret);
+    }
+
+    UBF_LOG(log_debug, "Bbldfinal: %d tuples, %ld bytes of data",
+            bld->nents, datasz);
+
+out:
+    return ret;
+}
+
+/**
+ * Remove all fields from the builder, keep the allocated memory
+ * @param bld builder
+ */
+expublic void Bbldreset(Bbld_t *bld)
+{
+    if (NULL!=bld)
+    {
+        bld->nents = 0;
+        bld->arena_used = 0;
+        bld->sorted = EXTRUE;
+        bld->datasz = 0;
+    }
+}
+
+/**
+ * Free up the builder
+ * @param bld builder
+ */
+expublic void Bbldfree(Bbld_t *bld)
+{
+    if (NULL!=bld)
+    {
+        if (NULL!=bld->ents)
+        {
+            NDRX_FREE(bld->ents);
+        }
+
+        if (NULL!=bld->keys)
+        {
+            NDRX_FREE(bld->keys);
+        }
+
+        if (NULL!=bld->keys_tmp)
+        {
+            NDRX_FREE(bld->keys_tmp);
+        }
+
+        if (NULL!=bld->arena)
+        {
+            NDRX_FREE(bld->arena);
+        }
+
+        if (NULL!=bld->slots)
+        {
+            NDRX_FREE(bld->slots);
+        }
+
+        NDRX_FREE(bld);
+    }
+}
+
+/* vim: set ts=4 sw=4 et smartindent: */
@@ -188,6 +188,27 @@ out:
     return ret;
 }
 
+/**
+ * Get the start of the fields of given type, from the type offset cache.
+ * If there are no fields of the type, it points to the next type fields
+ * (or the end of the buffer).
+ * @param p_ub UBF buffer
+ * @param type BFLD_* type
+ * @return ptr to first field of the type
+ */
+expublic char * ndrx_ubf_type_start(UBFH *p_ub, int type)
+{
+    UBF_header_t *hdr = (UBF_header_t *)p_ub;
+    char *p = (char *)&hdr->bfldid;
+    
+    if (type > BFLD_SHORT)
+    {
+        p+=*((BFLDLEN *)(((char *)hdr) + M_ubf_type_cache[type].cache_offset));
+    }
+    
+    return p;
+}
+
 /**
  * Set cache absolute values
  * @param p_ub UBF buffer
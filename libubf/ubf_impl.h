@@ -74,6 +74,7 @@ extern char * get_fld_loc(UBFH * p_ub, BFLDID bfldid, BFLDOCC occ,
 extern void ubf_cache_shift(UBFH *p_ub, BFLDID fldid, int size_diff);
 extern void ubf_cache_dump(UBFH *p_ub, char *msg);
 extern int ubf_cache_update(UBFH *p_ub);
+extern char * ndrx_ubf_type_start(UBFH *p_ub, int type);
 
 extern int ndrx_Bget (UBFH * p_ub, BFLDID bfldid, BFLDOCC occ,
                             char * buf, BFLDLEN * buflen);
@@ -143,6 +144,9 @@ extern UBFH * ndrx_Brealloc (UBFH *p_ub, BFLDOCC f, BFLDLEN v, long len_set);
 
 extern long ndrx_Bneeded(BFLDOCC nrfields, BFLDLEN totsize);
 
+extern int ndrx_Bgetmulti(UBFH *p_ub, Bfld_multi_t *items, int n);
+extern int ndrx_Bchgmulti(UBFH *p_ub, Bfld_multi_t *items, int n);
+
 #ifdef	__cplusplus
 }
 #endif
@@ -759,6 +759,14 @@ exprivate int parse_appconfig(config_t *config, xmlDocPtr doc, xmlNodePtr cur)
                                                   p, config->ddrreload);
                 xmlFree(p);
             }
+            else if (0==strcmp((char*)cur->name, "bootparallel"))
+            {
+                p = (char *)xmlNodeGetContent(cur);
+                config->bootparallel = atoi(p);
+                NDRX_LOG(log_debug, "bootparallel: [%s] - %d",
+                                                  p, config->bootparallel);
+                xmlFree(p);
+            }
             
             last_line=cur->line;
             cur = cur->next;
@@ -840,6 +848,12 @@ exprivate int parse_appconfig(config_t *config, xmlDocPtr doc, xmlNodePtr cur)
         NDRX_LOG(log_debug, "`routereload' not set using "
                 "default %d sty!", config->ddrreload);
     }
+    
+    if (0>= config->bootparallel)
+    {
+        /* one by one boot */
+        config->bootparallel = 1;
+    }
 
 out:
     return ret;
@@ -886,6 +900,7 @@ exprivate int parse_server(config_t *config, xmlDocPtr doc, xmlNodePtr cur)
     p_srvnode->isprotected = EXFAIL;
     p_srvnode->reloadonchange = EXFAIL;
     p_srvnode->respawn = EXFAIL;
+    p_srvnode->boottier = EXFAIL;
     
     p_srvnode->rssmax = config->default_rssmax;
     p_srvnode->vszmax = config->default_vszmax;
@@ -952,6 +967,13 @@ exprivate int parse_server(config_t *config, xmlDocPtr doc, xmlNodePtr cur)
             p_srvnode->sleep_after = atoi(p);
             xmlFree(p);
         }
+        else if (0==strcmp("boottier", (char *)cur->name))
+        {
+            p = (char *)xmlNodeGetContent(cur);
+            p_srvnode->boottier = atoi(p);
+            NDRX_LOG(log_debug, "boottier: [%s] - %d", p, p_srvnode->boottier);
+            xmlFree(p);
+        }
         /* Startup control moved here...: */
         else if (0==strcmp((char*)cur->name, "start_max"))
         {
@@ -163,7 +163,11 @@ command_map_t M_command_map [] =
     {NDRXD_COM_DSLEEP_RQ,   cmd_dsleep,        "dsleep",  ",-1,", 0,NDRXD_CTX_NOCHG},
     {NDRXD_COM_DSLEEP_RP,   cmd_dummy,         "dsleep",  ",-1,", 0,NDRXD_CTX_NOCHG},
     {NDRXD_COM_BLIST_RQ,    cmd_blist,         "blist",   ",-1,", 0,NDRXD_CTX_NOCHG},
-    {NDRXD_COM_BLIST_RP,    cmd_dummy,         "blist",   "",  0,NDRXD_CTX_NOCHG}
+    {NDRXD_COM_BLIST_RP,    cmd_dummy,         "blist",   "",  0,NDRXD_CTX_NOCHG},
+    {NDRXD_COM_BRCONINFO_RQ,cmd_dummy,         "brconinfo","", 0,NDRXD_CTX_NOCHG},
+    {NDRXD_COM_BRCONINFO_RP,cmd_dummy,         "brconinfo","", 0,NDRXD_CTX_NOCHG},
+    {NDRXD_COM_BRCREDIT_RQ, cmd_dummy,         "brcredit","",  0,NDRXD_CTX_NOCHG},
+    {NDRXD_COM_BRCREDIT_RP, cmd_dummy,         "brcredit","",  0,NDRXD_CTX_NOCHG}
     
 };
 
@@ -243,6 +243,13 @@ int main_init(int argc, char** argv)
         EXFAIL_OUT(ret);
     }
     
+    /* let the processes load config with out parsing */
+    if (EXSUCCEED!=ndrx_cconfig_snap_publish(EXTRUE))
+    {
+        NDRX_LOG(log_warn, "Failed to publish config snapshot - "
+                "processes will parse the config");
+    }
+    
     /* Bug #375 check the ndrxd process existence by pid file */
     ndrxd_pid = ndrx_ndrxd_pid_get();
     
@@ -450,6 +457,15 @@ int main_uninit(void)
 
     /* Remove any shared memory segments (even if was not open!) */
     ndrxd_shm_delete();
+    
+    /* Remove large message pool */
+    ndrx_lmsg_remove(EXTRUE);
+    
+    /* Remove cache in-flight table */
+    ndrx_cache_sf_remove();
+    
+    /* Remove call trace ring */
+    ndrx_calltrace_remove();
 
     /* close & unlink message queue */
     cmd_close_queue();
@@ -100,8 +100,21 @@
                                     NDRX_LOG(lev, fmt, ##__VA_ARGS__);\
                                     MUTEX_UNLOCK_V(M_forklock);
 
+/** start_process() mode for parallel boot, fork only, no progress */
+#define PM_START_FORKONLY       2
+
 /*---------------------------Enums--------------------------------------*/
 /*---------------------------Typedefs-----------------------------------*/
+
+/**
+ * Process being started in parallel boot mode
+ */
+typedef struct
+{
+    pm_node_t *p_pm;            /**< process started                */
+    ndrx_stopwatch_t timer;     /**< time since fork                */
+} pm_boot_slot_t;
+
 /*---------------------------Globals------------------------------------*/
 exprivate pthread_t M_signal_thread; /* Signalled thread */
 exprivate int M_signal_thread_set = EXFALSE; /* Signal thread is set */
@@ -834,10 +847,42 @@ out:
     return ret;
 }
 
+/**
+ * Check that process is started after the startup wait (or it did fail)
+ * @param p_pm process to check
+ * @param p_processes_started counter of started processes
+ */
+exprivate void start_process_chk(pm_node_t *p_pm, long *p_processes_started)
+{
+    /* Check for process name & pid */
+    if (ndrx_sys_is_process_running(p_pm->svpid, p_pm->binary_name_real))
+    {
+        /*Should be set at info: p_pm->state = NDRXD_PM_RUNNING;*/
+        NDRX_LOG(log_debug, "binary %s/%s, srvid %d started with pid %d/%d",
+                    p_pm->binary_name,p_pm->binary_name_real, p_pm->srvid, 
+                p_pm->pid, p_pm->svpid);
+        (*p_processes_started)++;
+    }
+    else if (NDRXD_PM_NOT_STARTED==p_pm->state)
+    {
+        /* Assume died? 
+         * we should normally get self notification...
+         */
+        p_pm->state = NDRXD_PM_DIED;
+        p_pm->state_changed = SANITY_CNT_START;
+        NDRX_LOG(log_debug, "binary %s, srvid %d failed to start",
+                    p_pm->binary_name, p_pm->srvid, p_pm->pid);
+    }
+}
+
 /**
  * Start single process...
+
  * TODO: Add SIGCHLD handler here!
  * @param pm
+ * @param no_wait EXTRUE - do not wait for the process to report in,
+ *  PM_START_FORKONLY - only fork, caller waits & reports the progress
+ *  (see start_process_chk())
  * @return SUCCEED/FAIL
  */
 expublic int start_process(command_startstop_t *cmd_call, pm_node_t *p_pm,
@@ -1182,25 +1227,12 @@ expublic int start_process(command_startstop_t *cmd_call, pm_node_t *p_pm,
                 
             }
             
-            /* Check for process name & pid */
-            if (ndrx_sys_is_process_running(p_pm->svpid, p_pm->binary_name_real))
-            {
-                /*Should be set at info: p_pm->state = NDRXD_PM_RUNNING;*/
-                NDRX_LOG(log_debug, "binary %s/%s, srvid %d started with pid %d/%d",
-                            p_pm->binary_name,p_pm->binary_name_real, p_pm->srvid, 
-                        pid, p_pm->svpid);
-                (*p_processes_started)++;
-            }
-            else if (NDRXD_PM_NOT_STARTED==p_pm->state)
-            {
-                /* Assume died? 
-                 * we should normally get self notification...
-                 */
-                p_pm->state = NDRXD_PM_DIED;
-                p_pm->state_changed = SANITY_CNT_START;
-                NDRX_LOG(log_debug, "binary %s, srvid %d failed to start",
-                            p_pm->binary_name, p_pm->srvid, pid);
-            }
+            start_process_chk(p_pm, p_processes_started);
+        }
+        else if (PM_START_FORKONLY==no_wait)
+        {
+            /* caller waits for the process & reports the progress */
+            goto out;
         }
     }
     else
@@ -1361,6 +1393,205 @@ out:
     return ret;
 }
 
+/**
+ * Is given process requested for boot?
+ * Bug #306 auto start affects also server boot by name
+ * Only autostart instances needs to be booted.
+ * @param call start request
+ * @param p_pm process to check
+ * @return EXTRUE/EXFALSE
+ */
+exprivate int is_boot_requested(command_startstop_t *call, pm_node_t *p_pm)
+{
+    return p_pm->autostart &&
+        ((EXEOS!=call->binary_name[0] && 0==strcmp(call->binary_name, p_pm->binary_name)) ||
+        /* Do full startup if requested autostart! */
+        (EXEOS==call->binary_name[0] )); /* or If full shutdown requested */
+}
+
+/**
+ * Does the process belong to the same boot tier as the first one?
+ * Instances of the same server entry are always in the same tier, other
+ * entries only if <boottier> is set and matches.
+ * @param p_first first process in the tier
+ * @param p_pm process to test
+ * @return EXTRUE/EXFALSE
+ */
+exprivate int is_same_boottier(pm_node_t *p_first, pm_node_t *p_pm)
+{
+    return p_first->conf==p_pm->conf || (EXFAIL!=p_first->conf->boottier &&
+            p_first->conf->boottier==p_pm->conf->boottier);
+}
+
+/**
+ * Wait for any of the booting processes to report in (or to time out),
+ * report progress for completed ones and release their slots.
+ * @param call start call
+ * @param p_startup_progress progress callback
+ * @param p_processes_started started processes counter
+ * @param slots booting processes
+ * @param nslots number of used slots (updated)
+ * @param doabort abort flag
+ */
+exprivate void app_startup_parallel_wait(command_startstop_t *call,
+        void (*p_startup_progress)(command_startstop_t *call, pm_node_t *pm, int calltype),
+        long *p_processes_started, pm_boot_slot_t *slots, int *nslots, int *doabort)
+{
+    int finished = EXFALSE;
+    int i;
+    
+    NDRX_LOG(log_debug, "Waiting for response from %d servers...", *nslots);
+    command_wait_and_run(&finished, doabort);
+    
+    for (i=0; i<*nslots; i++)
+    {
+        pm_node_t *p_pm = slots[i].p_pm;
+        
+        if (NDRXD_PM_STARTING!=p_pm->state || *doabort ||
+                ndrx_stopwatch_get_delta(&slots[i].timer) >= p_pm->conf->srvstartwait)
+        {
+            start_process_chk(p_pm, p_processes_started);
+            
+            NDRX_LOG(log_debug, "PID of started process is %d", p_pm->pid);
+            if (NULL!=p_startup_progress)
+            {
+                p_startup_progress(call, p_pm, NDRXD_CALL_TYPE_PM_STARTED);
+            }
+            
+            /* slot is free, move last one in */
+            (*nslots)--;
+            slots[i] = slots[*nslots];
+            i--;
+        }
+    }
+}
+
+/**
+ * Boot the processes in parallel. Processes are started in config order
+ * by tiers (see is_same_boottier()), up to <bootparallel> processes are
+ * starting at the same time. Next tier is started when all processes of the
+ * current tier have reported in (or <srvstartwait> expired). <sleep_after> is
+ * applied after the tier, using the max value of the tier.
+ * @param call start call
+ * @param p_startup_progress progress callback
+ * @param p_processes_started started processes counter
+ * @param doabort abort flag
+ * @return EXSUCCEED/EXFAIL
+ */
+exprivate int app_startup_parallel(command_startstop_t *call,
+        void (*p_startup_progress)(command_startstop_t *call, pm_node_t *pm, int calltype),
+        long *p_processes_started, int *doabort)
+{
+    int ret = EXSUCCEED;
+    pm_boot_slot_t *slots = NULL;
+    int nslots = 0;
+    pm_node_t *p_pm;
+    pm_node_t *p_first = NULL;
+    int sleep_after = 0;
+    int finished = EXFALSE;
+    ndrx_stopwatch_t sleep_timer;
+    
+    NDRX_LOG(log_info, "Parallel boot, max %d servers at a time", 
+            G_app_config->bootparallel);
+    
+    slots = NDRX_CALLOC(G_app_config->bootparallel, sizeof(pm_boot_slot_t));
+    
+    if (NULL==slots)
+    {
+        NDRXD_set_error_fmt(NDRXD_EOS, "Failed to malloc boot slots: %s", 
+                strerror(errno));
+        EXFAIL_OUT(ret);
+    }
+    
+    /* NULL entry closes the last tier */
+    for (p_pm=G_process_model; !(*doabort); p_pm=p_pm->next)
+    {
+        if (NULL!=p_pm && !is_boot_requested(call, p_pm))
+        {
+            continue;
+        }
+        
+        /* tier changed, wait for all to report in */
+        if (NULL!=p_first && (NULL==p_pm || !is_same_boottier(p_first, p_pm)))
+        {
+            while (nslots > 0)
+            {
+                app_startup_parallel_wait(call, p_startup_progress, 
+                        p_processes_started, slots, &nslots, doabort);
+            }
+            
+            if (sleep_after > 0 && !(*doabort))
+            {
+                ndrx_stopwatch_reset(&sleep_timer);
+                
+                do
+                {
+                    NDRX_LOG(log_debug, "In boot tier after start sleep...");
+                    command_wait_and_run(&finished, doabort);
+                } while (ndrx_stopwatch_get_delta_sec(&sleep_timer) < sleep_after);
+            }
+            
+            p_first = NULL;
+            sleep_after = 0;
+        }
+        
+        if (NULL==p_pm)
+        {
+            break;
+        }
+        
+        if (NULL==p_first)
+        {
+            p_first = p_pm;
+            NDRX_LOG(log_debug, "Boot tier %d starts with %s/%d", 
+                    p_pm->conf->boottier, p_pm->binary_name, p_pm->srvid);
+        }
+        
+        while (nslots >= G_app_config->bootparallel && !(*doabort))
+        {
+            app_startup_parallel_wait(call, p_startup_progress, 
+                        p_processes_started, slots, &nslots, doabort);
+        }
+        
+        if (*doabort)
+        {
+            break;
+        }
+        
+        /* if fork fails, start_process() reports the progress */
+        start_process(call, p_pm, p_startup_progress, 
+                        p_processes_started, PM_START_FORKONLY, doabort);
+        
+        if (NDRXD_PM_STARTING==p_pm->state)
+        {
+            slots[nslots].p_pm = p_pm;
+            ndrx_stopwatch_reset(&slots[nslots].timer);
+            nslots++;
+            
+            if (p_pm->conf->sleep_after > sleep_after)
+            {
+                sleep_after = p_pm->conf->sleep_after;
+            }
+        }
+    }
+    
+    /* report the ones left, if aborted */
+    while (nslots > 0)
+    {
+        app_startup_parallel_wait(call, p_startup_progress, 
+                p_processes_started, slots, &nslots, doabort);
+    }
+    
+out:
+    
+    if (NULL!=slots)
+    {
+        NDRX_FREE(slots);
+    }
+    
+    return ret;
+}
+
 /**
  * Start whole application. If configuration is not loaded, then this will
  * initiate configuration load.
@@ -1417,30 +1648,39 @@ expublic int app_startup(command_startstop_t *call,
             G_sys_config.fullstart=EXTRUE;
         }
         
-        DL_FOREACH(G_process_model, p_pm)
+        if (G_app_config->bootparallel > 1)
         {
-            /* if particular binary shutdown requested (probably we could add some index!?) */
-            
-            /* Bug #306 auto start affects also server boot by name
-             * Only autostart instances needs to be booted.
-             */
-            if (p_pm->autostart &&
-                    ((EXEOS!=call->binary_name[0] && 0==strcmp(call->binary_name, p_pm->binary_name)) ||
-                    /* Do full startup if requested autostart! */
-                    (EXEOS==call->binary_name[0] ))) /* or If full shutdown requested */
+            if (EXSUCCEED!=app_startup_parallel(call, p_startup_progress, 
+                    p_processes_started, &abort))
             {
-                start_process(call, p_pm, p_startup_progress, 
-                        p_processes_started, EXFALSE, &abort);
-                
+                EXFAIL_OUT(ret);
+            }
+        }
+        else
+        {
+            DL_FOREACH(G_process_model, p_pm)
+            {
+                /* if particular binary shutdown requested (probably we could add some index!?) */
+                if (is_boot_requested(call, p_pm))
+                {
+                    start_process(call, p_pm, p_startup_progress, 
+                            p_processes_started, EXFALSE, &abort);
+                }
+
                 if (abort)
                 {
-                    NDRX_LOG(log_warn, "Aborting app domain startup!");
-                    NDRXD_set_error_fmt(NDRXD_EABORT, "App domain startup aborted!");
-                    ret=EXFAIL;
-                    goto out;
+                    break;
                 }
-            }
-        } /* DL_FORACH pm. */
+            } /* DL_FORACH pm. */
+        }
+        
+        if (abort)
+        {
+            NDRX_LOG(log_warn, "Aborting app domain startup!");
+            NDRXD_set_error_fmt(NDRXD_EABORT, "App domain startup aborted!");
+            ret=EXFAIL;
+            goto out;
+        }
         
         if (G_sys_config.fullstart)
         {
@@ -74,6 +74,8 @@ exprivate int check_cnvsrv(char *qname);
 exprivate int check_long_startup(void);
 exprivate int check_dead_processes(void);
 exprivate void check_memlimits(void);
+exprivate int check_dead_q(char *qname, int qtype);
+exprivate void qowner_add(char *qname, int qtype);
 /**
  * Master process for sanity checking.
  * @param[in] finalchk perform final checks? Remove dread resources...
@@ -163,35 +165,56 @@ expublic int do_sanity_check(int finalchk)
 
         LL_FOREACH(qlist,elt)
         {
-            NDRX_LOG(6, "Checking... [%s]", elt->qname);
+            /* known queues are checked by their owners bellow */
+            if (ndrx_qowner_seen(elt->qname, G_sanity_cycle))
+            {
+                continue;
+            }
+            
+            NDRX_LOG(6, "New queue... [%s]", elt->qname);
             
             if (0==strncmp(elt->qname, client_prefix, 
                     client_prefix_len))
             {
-                check_client(elt->qname, EXFALSE, G_sanity_cycle);
+                qowner_add(elt->qname, NDRXD_QOWNER_CLT);
             }
             else if (0==strncmp(elt->qname, xadmin_prefix, 
                     xadmin_prefix_len)) 
             {
-                check_client(elt->qname, EXTRUE, G_sanity_cycle);
+                qowner_add(elt->qname, NDRXD_QOWNER_XADMIN);
             } 
             /* TODO: We might want to monitor admin queues too! */
             else if (0==strncmp(elt->qname, server_prefix, 
                     server_prefix_len)) 
             {
-                check_server(elt->qname);
+                qowner_add(elt->qname, NDRXD_QOWNER_SRV);
             } /*  Bug #112 */
 	    else if (0==strncmp(elt->qname, cnvclt_prefix, 
                     cnvclt_prefix_len)) 
             {
-                check_cnvclt(elt->qname);
+                qowner_add(elt->qname, NDRXD_QOWNER_CNVCLT);
             } /*  Bug #112 */
 	    else if (0==strncmp(elt->qname, cnvsrv_prefix, 
                     cnvsrv_prefix_len)) 
             {
-                check_cnvsrv(elt->qname);
+                qowner_add(elt->qname, NDRXD_QOWNER_CNVSRV);
+            }
+            else
+            {
+                /* remember the name, so that it is not parsed again */
+                qowner_add(elt->qname, NDRXD_QOWNER_OTHER);
             }
         }
+        
+        /* drop the queues removed by their owners */
+        ndrx_qowner_purge(G_sanity_cycle);
+        
+        /* check the owners, queues of dead ones are checked in full */
+        if (EXSUCCEED!=ndrx_qowner_check(G_sanity_cycle, finalchk, check_dead_q))
+        {
+            NDRX_LOG(log_warn, "Dead process queue checks failed - "
+                    "continue with a next cycle");
+        }
 
         /* Will check programs with long startup they will get killed if, 
          * not started in time! */
@@ -219,6 +242,15 @@ expublic int do_sanity_check(int finalchk)
         /* Perform any routing related checks */
         ndrx_ddr_apply_sanity();
         
+        /* Reclaim large message slabs of lost messages */
+        ndrx_lmsg_sanity();
+        
+        /* Republish config snapshot if ini files are changed */
+        if (!finalchk && EXSUCCEED!=ndrx_cconfig_snap_publish(EXFALSE))
+        {
+            NDRX_LOG(log_warn, "Failed to republish config snapshot");
+        }
+        
         /* Respawn any dead processes */
         if (!finalchk)
         {
@@ -302,6 +334,89 @@ exprivate void parse_q(char *qname, int is_server, char *process, int processsz,
     NDRX_LOG(6, "got process: pid: %d name: [%s]", 
                         *p_pid, process);
 }
+/**
+ * Register new queue with its owner process
+ * @param qname queue name
+ * @param qtype queue type, see NDRXD_QOWNER_*
+ */
+exprivate void qowner_add(char *qname, int qtype)
+{
+    char process[NDRX_MAX_Q_SIZE+1] = {EXEOS};
+    pid_t pid = EXFAIL;
+    int srv_id;
+    TPMYID myid, myid2;
+    
+    switch (qtype)
+    {
+        case NDRXD_QOWNER_CLT:
+        case NDRXD_QOWNER_XADMIN:
+            parse_q(qname, EXFALSE, process, sizeof(process), &pid, 0, 
+                    NDRXD_QOWNER_XADMIN==qtype);
+            break;
+        case NDRXD_QOWNER_SRV:
+            parse_q(qname, EXTRUE, process, sizeof(process), &pid, &srv_id, 
+                    EXFALSE);
+            break;
+        case NDRXD_QOWNER_CNVCLT:
+            /* remote processes are not checked */
+            if (EXSUCCEED==ndrx_cvnq_parse_client(qname, &myid) &&
+                    myid.nodeid==G_atmi_env.our_nodeid)
+            {
+                pid = myid.pid;
+                NDRX_STRCPY_SAFE(process, myid.binary_name);
+            }
+            break;
+        case NDRXD_QOWNER_CNVSRV:
+            /* the queue is owned by the other half of the name */
+            if (EXSUCCEED==ndrx_cvnq_parse_server(qname, &myid, &myid2) &&
+                    myid2.nodeid==G_atmi_env.our_nodeid)
+            {
+                pid = myid2.pid;
+                NDRX_STRCPY_SAFE(process, myid2.binary_name);
+            }
+            break;
+    }
+    
+    if (EXSUCCEED!=ndrx_qowner_add(qname, qtype, pid, process, G_sanity_cycle))
+    {
+        NDRX_LOG(log_error, "Failed to register queue [%s]", qname);
+    }
+}
+
+/**
+ * Check the queue which owner is found to be dead
+ * @param qname queue name
+ * @param qtype queue type, see NDRXD_QOWNER_*
+ * @return EXSUCCEED/EXFAIL
+ */
+exprivate int check_dead_q(char *qname, int qtype)
+{
+    int ret = EXSUCCEED;
+    
+    NDRX_LOG(6, "Checking... [%s]", qname);
+    
+    switch (qtype)
+    {
+        case NDRXD_QOWNER_CLT:
+            ret = check_client(qname, EXFALSE, G_sanity_cycle);
+            break;
+        case NDRXD_QOWNER_XADMIN:
+            ret = check_client(qname, EXTRUE, G_sanity_cycle);
+            break;
+        case NDRXD_QOWNER_SRV:
+            ret = check_server(qname);
+            break;
+        case NDRXD_QOWNER_CNVCLT:
+            ret = check_cnvclt(qname);
+            break;
+        case NDRXD_QOWNER_CNVSRV:
+            ret = check_cnvsrv(qname);
+            break;
+    }
+    
+    return ret;
+}
+
 /**
  * Remove dead process queue from system!
  * @param qname
@@ -1000,6 +1115,8 @@ expublic int ndrxd_sanity_finally(void)
     
     ret = do_sanity_check(EXTRUE);
     
+    ndrx_qowner_free();
+    
 out:
     return ret;
 }
@@ -0,0 +1,325 @@
+/**
+ * @brief Queue ownership registry used by sanity checks.
+ *   Queues are created by the client & server processes, thus ndrxd learns
+ *   about them from the queue listing. Each queue name is parsed only once,
+ *   when it first appears, and is attached to the owner process (pid + name).
+ *   Subsequent sanity cycles only check owners for liveness (one check per
+ *   process, not per queue), and only queues of dead owners are passed to
+ *   the full queue checks (which unlink the leftovers).
+ *
+ * @file sanity_qowner.c
+ */
+/* -----------------------------------------------------------------------------
+ * Enduro/X Middleware Platform for Distributed Transaction Processing
+ * Copyright (C) 2009-2016, ATR Baltic, Ltd. All Rights Reserved.
+ * Copyright (C) 2017-2019, Mavimax, Ltd. All Rights Reserved.
+ * This software is released under one of the following licenses:
+ * AGPL (with Java and Go exceptions) or Mavimax's license for commercial use.
+ * See LICENSE file for full text.
+ * -----------------------------------------------------------------------------
+ * AGPL license:
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License, version 3 as published
+ * by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License, version 3
+ * for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * -----------------------------------------------------------------------------
+ * A commercial use license is available from Mavimax, Ltd
+ * contact@mavimax.com
+ * -----------------------------------------------------------------------------
+ */
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <memory.h>
+#include <sys/types.h>
+#include <signal.h>
+#include <utlist.h>
+
+#include <ndrstandard.h>
+#include <ndrxd.h>
+#include <atmi_int.h>
+
+#include <ndebug.h>
+#include "userlog.h"
+#include "sys_unix.h"
+
+/*---------------------------Externs------------------------------------*/
+/*---------------------------Macros-------------------------------------*/
+/**
+ * Between full checks owners are tested with kill(pid, 0) only. Full check
+ * (process name match) is done every so many cycles to detect pid reuse.
+ */
+#define QOWNER_FULLCHK_CYCLES       10
+/*---------------------------Enums--------------------------------------*/
+/*---------------------------Typedefs-----------------------------------*/
+
+typedef struct ndrx_qowner_proc ndrx_qowner_proc_t;
+typedef struct ndrx_qowner_q ndrx_qowner_q_t;
+
+/**
+ * Queue known to the registry
+ */
+struct ndrx_qowner_q
+{
+    char qname[NDRX_MAX_Q_SIZE+1];  /**< queue name as listed         */
+    int qtype;                      /**< NDRXD_QOWNER_* type          */
+    unsigned sanity_cycle;          /**< last cycle queue was listed  */
+    ndrx_qowner_proc_t *owner;      /**< owner, NULL if not local     */
+
+    ndrx_qowner_q_t *next, *prev;   /**< owner's queue list           */
+    EX_hash_handle hh;              /**< hash by qname                */
+};
+
+/**
+ * Owner process of the queues
+ */
+struct ndrx_qowner_proc
+{
+    char key[NDRX_MAX_Q_SIZE+32];   /**< pid,procname                 */
+    pid_t pid;                      /**< owner pid                    */
+    char procname[NDRX_MAX_Q_SIZE+1];/**< process name                */
+    unsigned chk_cycle;             /**< last full check cycle        */
+    int fullchk;                    /**< full check is pending        */
+
+    ndrx_qowner_q_t *queues;        /**< queues owned                 */
+    EX_hash_handle hh;              /**< hash by key                  */
+};
+
+/*---------------------------Globals------------------------------------*/
+/*---------------------------Statics------------------------------------*/
+exprivate ndrx_qowner_q_t *M_queues = NULL;     /**< registry by queue  */
+exprivate ndrx_qowner_proc_t *M_owners = NULL;  /**< registry by owner  */
+/*---------------------------Prototypes---------------------------------*/
+
+/**
+ * Remove queue from registry, remove owner if it was last queue
+ * @param q queue to remove
+ */
+exprivate void qowner_q_remove(ndrx_qowner_q_t *q)
+{
+    ndrx_qowner_proc_t *owner = q->owner;
+
+    EXHASH_DEL(M_queues, q);
+
+    if (NULL!=owner)
+    {
+        DL_DELETE(owner->queues, q);
+
+        if (NULL==owner->queues)
+        {
+            EXHASH_DEL(M_owners, owner);
+            NDRX_FREE(owner);
+        }
+    }
+
+    NDRX_FREE(q);
+}
+
+/**
+ * Mark the queue as seen in current cycle
+ * @param qname queue name from the listing
+ * @param sanity_cycle current sanity cycle
+ * @return EXTRUE - queue is known, EXFALSE - queue is new (needs to be added)
+ */
+expublic int ndrx_qowner_seen(char *qname, unsigned sanity_cycle)
+{
+    ndrx_qowner_q_t *q = NULL;
+
+    EXHASH_FIND_STR(M_queues, qname, q);
+
+    if (NULL==q)
+    {
+        return EXFALSE;
+    }
+
+    q->sanity_cycle = sanity_cycle;
+
+    return EXTRUE;
+}
+
+/**
+ * Add queue to registry
+ * @param qname queue name
+ * @param qtype queue type, see NDRXD_QOWNER_*
+ * @param pid owner pid, EXFAIL if queue has no local owner
+ * @param procname owner process name
+ * @param sanity_cycle current sanity cycle
+ * @return EXSUCCEED/EXFAIL (malloc failure)
+ */
+expublic int ndrx_qowner_add(char *qname, int qtype, pid_t pid, char *procname,
+        unsigned sanity_cycle)
+{
+    int ret = EXSUCCEED;
+    ndrx_qowner_q_t *q = NULL;
+    ndrx_qowner_proc_t *owner = NULL;
+    char key[NDRX_MAX_Q_SIZE+32];
+
+    if (NULL==(q=NDRX_CALLOC(1, sizeof(ndrx_qowner_q_t))))
+    {
+        NDRX_LOG(log_error, "Failed to malloc %d bytes: %s",
+                (int)sizeof(ndrx_qowner_q_t), strerror(errno));
+        userlog("Failed to malloc %d bytes: %s",
+                (int)sizeof(ndrx_qowner_q_t), strerror(errno));
+        EXFAIL_OUT(ret);
+    }
+
+    NDRX_STRCPY_SAFE(q->qname, qname);
+    q->qtype = qtype;
+    q->sanity_cycle = sanity_cycle;
+
+    if (EXFAIL!=pid)
+    {
+        snprintf(key, sizeof(key), "%d,%s", (int)pid, procname);
+
+        EXHASH_FIND_STR(M_owners, key, owner);
+
+        if (NULL==owner)
+        {
+            if (NULL==(owner=NDRX_CALLOC(1, sizeof(ndrx_qowner_proc_t))))
+            {
+                NDRX_LOG(log_error, "Failed to malloc %d bytes: %s",
+                        (int)sizeof(ndrx_qowner_proc_t), strerror(errno));
+                userlog("Failed to malloc %d bytes: %s",
+                        (int)sizeof(ndrx_qowner_proc_t), strerror(errno));
+                EXFAIL_OUT(ret);
+            }
+
+            NDRX_STRCPY_SAFE(owner->key, key);
+            NDRX_STRCPY_SAFE(owner->procname, procname);
+            owner->pid = pid;
+            /* new owner gets full check in this cycle */
+            owner->fullchk = EXTRUE;
+
+            EXHASH_ADD_STR(M_owners, key, owner);
+        }
+
+        q->owner = owner;
+        DL_APPEND(owner->queues, q);
+    }
+
+    EXHASH_ADD_STR(M_queues, qname, q);
+
+    NDRX_LOG(6, "Queue [%s] type %d registered, owner [%s]",
+            qname, qtype, NULL!=owner?owner->key:"(none)");
+
+out:
+
+    if (EXSUCCEED!=ret && NULL!=q)
+    {
+        NDRX_FREE(q);
+    }
+
+    return ret;
+}
+
+/**
+ * Remove queues which are not listed any more (removed by their owners)
+ * @param sanity_cycle current sanity cycle
+ */
+expublic void ndrx_qowner_purge(unsigned sanity_cycle)
+{
+    ndrx_qowner_q_t *q, *qtmp;
+
+    EXHASH_ITER(hh, M_queues, q, qtmp)
+    {
+        if (q->sanity_cycle!=sanity_cycle)
+        {
+            NDRX_LOG(6, "Queue [%s] is gone", q->qname);
+            qowner_q_remove(q);
+        }
+    }
+}
+
+/**
+ * Check owners of the registered queues. Queues of dead owners are passed
+ * to the callback and are removed from the registry.
+ * @param sanity_cycle current sanity cycle
+ * @param fullchk check all owners with process name match
+ * @param p_dead_q callback for queues which owner is dead
+ * @return EXSUCCEED/EXFAIL (callback failed)
+ */
+expublic int ndrx_qowner_check(unsigned sanity_cycle, int fullchk,
+        int (*p_dead_q)(char *qname, int qtype))
+{
+    int ret = EXSUCCEED;
+    ndrx_qowner_proc_t *owner, *otmp;
+    ndrx_qowner_q_t *q, *qtmp;
+    int alive;
+    int checked = 0;
+    int dead = 0;
+
+    EXHASH_ITER(hh, M_owners, owner, otmp)
+    {
+        if (fullchk || owner->fullchk ||
+                sanity_cycle - owner->chk_cycle >= QOWNER_FULLCHK_CYCLES)
+        {
+            alive = ndrx_sys_is_process_running(owner->pid, owner->procname);
+            owner->chk_cycle = sanity_cycle;
+            owner->fullchk = EXFALSE;
+            checked++;
+        }
+        else
+        {
+            alive = (EXSUCCEED==kill(owner->pid, 0) || EPERM==errno);
+        }
+
+        if (alive)
+        {
+            continue;
+        }
+
+        NDRX_LOG(log_debug, "Queue owner [%s] is dead - checking its queues",
+                owner->key);
+        dead++;
+
+        /* callback may unlink the queues, list is not changed by it.
+         * owner is freed together with its last queue.
+         */
+        DL_FOREACH_SAFE(owner->queues, q, qtmp)
+        {
+            if (EXSUCCEED!=p_dead_q(q->qname, q->qtype))
+            {
+                ret = EXFAIL;
+            }
+
+            qowner_q_remove(q);
+        }
+
+        if (EXSUCCEED!=ret)
+        {
+            goto out;
+        }
+    }
+
+out:
+    NDRX_LOG(log_debug, "Queue owners: %d fully checked, %d dead, "
+            "%d owners left", checked, dead, EXHASH_COUNT(M_owners));
+
+    return ret;
+}
+
+/**
+ * Free up the registry
+ */
+expublic void ndrx_qowner_free(void)
+{
+    ndrx_qowner_q_t *q, *qtmp;
+
+    EXHASH_ITER(hh, M_queues, q, qtmp)
+    {
+        qowner_q_remove(q);
+    }
+}
+
+/* vim: set ts=4 sw=4 et smartindent: */
@@ -189,6 +189,17 @@ expublic int remove_service_q(char *svc, short srvid, mqd_t in_qd, char *in_qstr
         if (ATMI_COMMAND_TPCALL==gen_command->command_id)
         {
             tp_command_call_t *tp_call = (tp_command_call_t *)gen_command;
+            long call_len = len;
+            
+            /* caller details are needed for reply */
+            if (EXFAIL==ndrx_callhdr_decode(msg_buf, msg_buf_len, &call_len))
+            {
+                NDRX_LOG(log_warn, "Skipping invalid compact call");
+                continue;
+            }
+            
+            /* payload is not delivered, free the slab */
+            ndrx_lmsg_release(tp_call);
             
             /* Bug #425: Check is process wait for reply? */
             reply_with_failure(TPNOBLOCK, tp_call, NULL, NULL, TPENOENT);
@@ -1,8 +1,10 @@
 /**
  * @brief Queue forward processing
  *   We will have a separate thread pool for processing automatic queue .
- *   the main forward thread will periodically scan the Q and submit the jobs to
- *   the threads (if any will be free).
+ *   the main forward thread takes due messages from the queues (one per queue
+ *   in round) and submits the jobs to the threads (if any will be free).
+ *   When nothing is due, thread sleeps till the next try time of the
+ *   scheduled messages or till woken up by enqueue/unlock of the message.
  *   During the shutdown we will issue for every pool thread
  *
  * @file forward.c
@@ -80,6 +82,8 @@ exprivate __thread int M_is_xa_open = EXFALSE; /* Init flag for thread. */
 
 exprivate fwd_qlist_t *M_next_fwd_q_list = NULL;    /**< list of queues to check msgs to fwd */
 exprivate fwd_qlist_t *M_next_fwd_q_cur = NULL;     /**< current position in linked list... */
+exprivate int M_round_msgs = 0;     /**< messages taken in current round      */
+exprivate unsigned M_wake_gen = 0;  /**< wake up requests, protected by M_wait_mutex */
     
 
 exprivate MUTEX_LOCKDECL(M_forward_lock); /* Q Forward operations sync        */
@@ -104,35 +108,81 @@ expublic void forward_unlock(void)
 }
 
 /**
- * Sleep the thread, with option to wake up (by shutdown).
- * @param sleep_sec
+ * Get current wake up generation (read before queues are scanned)
+ * @return wake generation
  */
-exprivate void thread_sleep(int sleep_sec)
+exprivate unsigned thread_wake_gen(void)
+{
+    unsigned ret;
+    
+    MUTEX_LOCK_V(M_wait_mutex);
+    ret = M_wake_gen;
+    MUTEX_UNLOCK_V(M_wait_mutex);
+    
+    return ret;
+}
+
+/**
+ * Sleep the thread till next message is due, but not longer than scan time.
+ * Sleep is skipped if wake up was requested after the queues were scanned.
+ * @param wake_gen wake generation read before the scan
+ * @param due UTC epoch second when next message is due, EXFAIL if none
+ */
+exprivate void thread_sleep(unsigned wake_gen, long due)
 {
     struct timespec wait_time;
     struct timeval now;
     int rt;
 
     gettimeofday(&now,NULL);
+    
+    if (EXFAIL!=due && due <= now.tv_sec)
+    {
+        NDRX_LOG(log_debug, "background - message due, no sleep");
+        return;
+    }
 
-    wait_time.tv_sec = now.tv_sec+sleep_sec;
+    wait_time.tv_sec = now.tv_sec+G_tmqueue_cfg.scan_time;
     wait_time.tv_nsec = now.tv_usec*1000;
+    
+    if (EXFAIL!=due && due < wait_time.tv_sec)
+    {
+        wait_time.tv_sec = due;
+        wait_time.tv_nsec = 0;
+    }
+    
+    NDRX_LOG(log_debug, "background - sleep %ld sec",
+            (long)(wait_time.tv_sec - now.tv_sec));
 
     MUTEX_LOCK_V(M_wait_mutex);
-    rt = pthread_cond_timedwait(&M_wait_cond, &M_wait_mutex, &wait_time);
+    
+    if (wake_gen==M_wake_gen && !G_forward_req_shutdown)
+    {
+        rt = pthread_cond_timedwait(&M_wait_cond, &M_wait_mutex, &wait_time);
+    }
+    
     MUTEX_UNLOCK_V(M_wait_mutex);
 }
 
 /**
- * Wake up the sleeping thread.
+ * Wake up the sleeping thread (message available for forward).
  */
-expublic void forward_shutdown_wake(void)
+expublic void forward_wake(void)
 {
     MUTEX_LOCK_V(M_wait_mutex);
+    M_wake_gen++;
     pthread_cond_signal(&M_wait_cond);
     MUTEX_UNLOCK_V(M_wait_mutex);
 }
 
+/**
+ * Wake up the sleeping thread.
+ */
+expublic void forward_shutdown_wake(void)
+{
+    forward_wake();
+}
+
 /**
  * Remove forward queue list before next lookup or at un-init
  */
@@ -153,7 +203,9 @@ exprivate void fwd_q_list_rm(void)
 /**
  * Get next message to forward
  * So basically we iterate over the all Qs, then regenerate the Q list and
- * and iterate over again.
+ * and iterate over again. Thus queues are served in parallel, one message
+ * per queue in the round. If round gave some messages, next round is started
+ * at once, NULL is returned only if whole round had no due messages.
  * 
  * @return 
  */
@@ -163,45 +215,47 @@ exprivate tmq_msg_t * get_next_msg(void)
     long qerr = EXSUCCEED;
     char msgbuf[128];
 
-    if (NULL==M_next_fwd_q_list || NULL == M_next_fwd_q_cur)
+    do
     {
-        fwd_q_list_rm();
-        
-        /* Generate new list */
-        M_next_fwd_q_list = tmq_get_qlist(EXTRUE, EXFALSE);
-        
-        if (NULL!=M_next_fwd_q_list)
+        if (NULL==M_next_fwd_q_list || NULL == M_next_fwd_q_cur)
         {
+            fwd_q_list_rm();
+
+            /* Generate new list */
+            M_next_fwd_q_list = tmq_get_qlist(EXTRUE, EXFALSE);
             M_next_fwd_q_cur = M_next_fwd_q_list;
+            M_round_msgs = 0;
         }
-    }
-    
-    /*
-     * get the message
-     */
-    while (NULL!=M_next_fwd_q_cur)
-    {
-        /* OK, so we peek for a message */
-        if (NULL==(ret=tmq_msg_dequeue(M_next_fwd_q_cur->qname, 0, EXTRUE, 
-                &qerr, msgbuf, sizeof(msgbuf))))
-        {
-            NDRX_LOG(log_debug, "Not messages for dequeue qerr=%ld: %s", qerr, msgbuf);
-        }
-        else
+
+        /*
+         * get the message
+         */
+        while (NULL!=M_next_fwd_q_cur)
         {
-            NDRX_LOG(log_debug, "Dequeued message");
-        }
+            /* OK, so we peek for a message */
+            if (NULL==(ret=tmq_msg_dequeue(M_next_fwd_q_cur->qname, 0, EXTRUE, 
+                    &qerr, msgbuf, sizeof(msgbuf))))
+            {
+                NDRX_LOG(log_debug, "Not messages for dequeue qerr=%ld: %s", qerr, msgbuf);
+            }
+            else
+            {
+                NDRX_LOG(log_debug, "Dequeued message");
+                M_round_msgs++;
+            }
 
-        /* schedule next queue ... */
-        M_next_fwd_q_cur = M_next_fwd_q_cur->next;
+            /* schedule next queue ... */
+            M_next_fwd_q_cur = M_next_fwd_q_cur->next;
     
-        /* done with this loop if having msg.. */
-        if (NULL!=ret)
-        {
-            break;
-        }
+            /* done with this loop if having msg.. */
+            if (NULL!=ret)
+            {
+                break;
+            }
 
+        }
     }
+    while (NULL==ret && M_round_msgs > 0);
     
 out:
     return ret;
@@ -561,6 +615,7 @@ expublic int forward_loop(void)
 {
     int ret = EXSUCCEED;
     tmq_msg_t * msg;
+    unsigned wake_gen;
     /*
      * We need to get the list of queues to monitor.
      * Note that list can be dynamic. So at some periods we need to refresh
@@ -573,6 +628,9 @@ expublic int forward_loop(void)
         /* wait for one slot to become free.. */
         ndrx_thpool_wait_one(G_tmqueue_cfg.fwdthpool);
         
+        /* wake ups after this point will not let us sleep */
+        wake_gen = thread_wake_gen();
+        
         /* 2. get the message from Q */
         msg = get_next_msg();
         
@@ -586,12 +644,10 @@ expublic int forward_loop(void)
         {
             /* sleep only when did not have a message 
              * So that if we have batch, we try to use all resources...
+             * Sleep till the next try time, enqueue or unlock will wake us up
              */
-            NDRX_LOG(log_debug, "background - sleep %d", 
-                    G_tmqueue_cfg.scan_time);
-            
             if (!G_forward_req_shutdown)
-                thread_sleep(G_tmqueue_cfg.scan_time);
+                thread_sleep(wake_gen, tmq_fwd_due());
         }
     }
     
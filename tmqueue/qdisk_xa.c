@@ -954,6 +954,15 @@ expublic int xa_commit_entry(struct xa_switch_t *sw, XID *xid, int rmid, long fl
         NDRX_LOG(log_error, "ERROR! xa_commit_entry() - XA not open!");
         return XAER_RMERR;
     }
+    
+    /* one-phase commit, branch is not prepared yet */
+    if ((flags & TMONEPHASE) && XA_OK!=xa_prepare_entry(sw, xid, rmid, TMNOFLAGS))
+    {
+        NDRX_LOG(log_error, "ERROR! xa_commit_entry() - one-phase prepare "
+                "failed, rolling back");
+        xa_rollback_entry(sw, xid, rmid, TMNOFLAGS);
+        return XA_RBROLLBACK;
+    }
 
     set_filename_base(xid, rmid);
     names_max = get_filenames_max();
@@ -0,0 +1,575 @@
+/**
+ * @brief Forward & dequeue scheduling of the queue messages
+ *   Automatic queues and queues in priority or time mode keep two heaps of the
+ *   unlocked messages: the wait heap ordered by the next try time, and the
+ *   ready heap ordered by the queue mode (message time fifo/lifo, priority or
+ *   dequeue time). Dequeue moves the messages which try time has come
+ *   from wait heap to ready heap and takes the top of ready heap, thus it does
+ *   not need to scan all the messages of the queue.
+ *   Next try time is the retry time for automatic queues, and for time mode
+ *   queues, not earlier than the dequeue time of the message.
+ *   Messages locked by other operations are not removed from the heaps, these
+ *   are dropped when they get to the top. Unlocked messages are put back.
+ *   All functions here must be called with queue space lock held.
+ *
+ * @file qsched.c
+ */
+/* -----------------------------------------------------------------------------
+ * Enduro/X Middleware Platform for Distributed Transaction Processing
+ * Copyright (C) 2009-2016, ATR Baltic, Ltd. All Rights Reserved.
+ * Copyright (C) 2017-2019, Mavimax, Ltd. All Rights Reserved.
+ * This software is released under one of the following licenses:
+ * AGPL (with Java and Go exceptions) or Mavimax's license for commercial use.
+ * See LICENSE file for full text.
+ * -----------------------------------------------------------------------------
+ * AGPL license:
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License, version 3 as published
+ * by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License, version 3
+ * for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * -----------------------------------------------------------------------------
+ * A commercial use license is available from Mavimax, Ltd
+ * contact@mavimax.com
+ * -----------------------------------------------------------------------------
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <ndebug.h>
+#include <atmi.h>
+#include <atmi_int.h>
+#include <ndrstandard.h>
+#include <utlist.h>
+
+#include "tmqd.h"
+#include "nstdutil.h"
+#include "userlog.h"
+/*---------------------------Externs------------------------------------*/
+/*---------------------------Macros-------------------------------------*/
+#define SCHED_HEAP_MIN          64  /**< Initial heap size                  */
+/*---------------------------Enums--------------------------------------*/
+/*---------------------------Typedefs-----------------------------------*/
+/*---------------------------Globals------------------------------------*/
+/*---------------------------Statics------------------------------------*/
+
+/**
+ * Queue config generation, heaps of the queues with other generation are
+ * rebuilt on next use (keys depend on the config).
+ */
+exprivate int M_sched_gen = 1;
+/*---------------------------Prototypes---------------------------------*/
+
+/**
+ * Get message priority
+ * @param msg message
+ * @return TPQCTL priority if set, else default priority
+ */
+expublic long tmq_sched_prio(tmq_msg_t *msg)
+{
+    return (msg->qctl.flags & TPQPRIORITY) ? msg->qctl.priority : TMQ_PRIO_DFLT;
+}
+
+/**
+ * Get message dequeue time (relative times are converted at enqueue)
+ * @param msg message
+ * @return UTC epoch second, message time if not set
+ */
+expublic long tmq_sched_deq_time(tmq_msg_t *msg)
+{
+    return (msg->qctl.flags & TPQTIME_ABS) ? msg->qctl.deq_time : msg->msgtstamp;
+}
+
+/**
+ * Compare two messages in dequeue order of the queue mode
+ * @param mode queue mode, see TMQ_MODE_*
+ * @param m1 first message
+ * @param m2 second message
+ * @return <0 if m1 shall be dequeued before m2
+ */
+expublic int tmq_sched_msg_cmp(char mode, tmq_msg_t *m1, tmq_msg_t *m2)
+{
+    int ret;
+    long v1, v2;
+
+    switch (mode)
+    {
+        case TMQ_MODE_PRIO:
+            /* highest first */
+            v1 = tmq_sched_prio(m1);
+            v2 = tmq_sched_prio(m2);
+
+            if (v1!=v2)
+            {
+                return v1 > v2 ? -1 : 1;
+            }
+            break;
+        case TMQ_MODE_TIME:
+            v1 = tmq_sched_deq_time(m1);
+            v2 = tmq_sched_deq_time(m2);
+
+            if (v1!=v2)
+            {
+                return v1 < v2 ? -1 : 1;
+            }
+            break;
+    }
+
+    ret = ndrx_compare3(m1->msgtstamp, m1->msgtstamp_usec, m1->msgtstamp_cntr,
+            m2->msgtstamp, m2->msgtstamp_usec, m2->msgtstamp_cntr);
+
+    if (TMQ_MODE_LIFO==mode)
+    {
+        ret = -ret;
+    }
+
+    return ret;
+}
+
+/**
+ * Compare two messages in the heap
+ * @param qhash queue
+ * @param heap TMQ_SCHED_WAIT or TMQ_SCHED_READY
+ * @param m1 first message
+ * @param m2 second message
+ * @return <0 if m1 shall be taken before m2
+ */
+exprivate int sched_cmp(tmq_qhash_t *qhash, char heap, tmq_memmsg_t *m1,
+        tmq_memmsg_t *m2)
+{
+    if (TMQ_SCHED_WAIT==heap)
+    {
+        if (m1->fwd_next!=m2->fwd_next)
+        {
+            return m1->fwd_next < m2->fwd_next ? -1 : 1;
+        }
+
+        return tmq_sched_msg_cmp(TMQ_MODE_FIFO, m1->msg, m2->msg);
+    }
+
+    return tmq_sched_msg_cmp(qhash->sched.mode, m1->msg, m2->msg);
+}
+
+/**
+ * Get heap by id
+ * @param qhash queue
+ * @param heap TMQ_SCHED_WAIT or TMQ_SCHED_READY
+ * @return heap
+ */
+exprivate tmq_heap_t * sched_heap(tmq_qhash_t *qhash, char heap)
+{
+    return TMQ_SCHED_WAIT==heap ? &qhash->sched.wait : &qhash->sched.ready;
+}
+
+/**
+ * Place message in the heap slot
+ * @param h heap
+ * @param idx slot index
+ * @param mmsg message
+ */
+exprivate void sched_set(tmq_heap_t *h, int idx, tmq_memmsg_t *mmsg)
+{
+    h->arr[idx] = mmsg;
+    mmsg->fwd_idx = idx;
+}
+
+/**
+ * Move the message up to its place
+ * @param qhash queue
+ * @param heap heap id
+ * @param idx index of the message
+ */
+exprivate void sched_up(tmq_qhash_t *qhash, char heap, int idx)
+{
+    tmq_heap_t *h = sched_heap(qhash, heap);
+    tmq_memmsg_t *mmsg = h->arr[idx];
+    int parent;
+
+    while (idx > 0)
+    {
+        parent = (idx-1)/2;
+
+        if (sched_cmp(qhash, heap, mmsg, h->arr[parent]) >= 0)
+        {
+            break;
+        }
+
+        sched_set(h, idx, h->arr[parent]);
+        idx = parent;
+    }
+
+    sched_set(h, idx, mmsg);
+}
+
+/**
+ * Move the message down to its place
+ * @param qhash queue
+ * @param heap heap id
+ * @param idx index of the message
+ */
+exprivate void sched_down(tmq_qhash_t *qhash, char heap, int idx)
+{
+    tmq_heap_t *h = sched_heap(qhash, heap);
+    tmq_memmsg_t *mmsg = h->arr[idx];
+    int child;
+
+    while ((child = idx*2+1) < h->n)
+    {
+        if (child+1 < h->n &&
+                sched_cmp(qhash, heap, h->arr[child+1], h->arr[child]) < 0)
+        {
+            child++;
+        }
+
+        if (sched_cmp(qhash, heap, h->arr[child], mmsg) >= 0)
+        {
+            break;
+        }
+
+        sched_set(h, idx, h->arr[child]);
+        idx = child;
+    }
+
+    sched_set(h, idx, mmsg);
+}
+
+/**
+ * Add message to the heap
+ * @param qhash queue
+ * @param heap heap id
+ * @param mmsg message, must not be in any heap
+ * @return EXSUCCEED/EXFAIL (out of mem)
+ */
+exprivate int sched_push(tmq_qhash_t *qhash, char heap, tmq_memmsg_t *mmsg)
+{
+    int ret = EXSUCCEED;
+    tmq_heap_t *h = sched_heap(qhash, heap);
+    tmq_memmsg_t **arr;
+    int alloc;
+
+    if (h->n >= h->alloc)
+    {
+        alloc = h->alloc < SCHED_HEAP_MIN ? SCHED_HEAP_MIN : h->alloc*2;
+
+        if (NULL==(arr = NDRX_REALLOC(h->arr, sizeof(tmq_memmsg_t *)*alloc)))
+        {
+            int err = errno;
+            NDRX_LOG(log_error, "Failed to realloc %d bytes: %s",
+                    (int)(sizeof(tmq_memmsg_t *)*alloc), strerror(err));
+            userlog("Failed to realloc %d bytes: %s",
+                    (int)(sizeof(tmq_memmsg_t *)*alloc), strerror(err));
+            EXFAIL_OUT(ret);
+        }
+
+        h->arr = arr;
+        h->alloc = alloc;
+    }
+
+    mmsg->fwd_heap = heap;
+    h->arr[h->n] = mmsg;
+    h->n++;
+    sched_up(qhash, heap, h->n-1);
+
+out:
+    return ret;
+}
+
+/**
+ * Remove message from the heap it is in
+ * @param qhash queue
+ * @param mmsg message
+ */
+exprivate void sched_remove(tmq_qhash_t *qhash, tmq_memmsg_t *mmsg)
+{
+    char heap = mmsg->fwd_heap;
+    tmq_heap_t *h = sched_heap(qhash, heap);
+    int idx = mmsg->fwd_idx;
+
+    h->n--;
+    mmsg->fwd_heap = TMQ_SCHED_NONE;
+
+    if (idx < h->n)
+    {
+        /* last one goes to the hole */
+        sched_set(h, idx, h->arr[h->n]);
+        sched_up(qhash, heap, idx);
+        sched_down(qhash, heap, h->arr[idx]->fwd_idx);
+    }
+}
+
+/**
+ * Calculate next try time of the message
+ * @param msg message
+ * @param qconf queue config
+ * @return UTC epoch second when message may be dequeued/forwarded
+ */
+exprivate long sched_next_try(tmq_msg_t *msg, tmq_qconfig_t *qconf)
+{
+    long ret = 0;
+    long deq_time;
+    int retry_inc;
+
+    if (TMQ_AUTOQ_ISAUTO(qconf->autoq))
+    {
+        if (0==msg->trycounter)
+        {
+            ret = msg->trytstamp + qconf->waitinit;
+        }
+        else
+        {
+            retry_inc = qconf->waitretry*msg->trycounter;
+
+            if (retry_inc > qconf->waitretrymax)
+            {
+                retry_inc = qconf->waitretrymax;
+            }
+
+            ret = msg->trytstamp + retry_inc;
+        }
+    }
+
+    if (TMQ_MODE_TIME==qconf->mode && (deq_time=tmq_sched_deq_time(msg)) > ret)
+    {
+        ret = deq_time;
+    }
+
+    return ret;
+}
+
+/**
+ * Empty the heaps of the queue
+ * @param qhash queue
+ */
+exprivate void sched_clear(tmq_qhash_t *qhash)
+{
+    int i;
+
+    for (i=0; i<qhash->sched.wait.n; i++)
+    {
+        qhash->sched.wait.arr[i]->fwd_heap = TMQ_SCHED_NONE;
+    }
+
+    for (i=0; i<qhash->sched.ready.n; i++)
+    {
+        qhash->sched.ready.arr[i]->fwd_heap = TMQ_SCHED_NONE;
+    }
+
+    qhash->sched.wait.n = 0;
+    qhash->sched.ready.n = 0;
+}
+
+/**
+ * Rebuild the heaps from the queue, if queue config is changed
+ * @param qhash queue
+ * @param qconf queue config
+ */
+exprivate void sched_check(tmq_qhash_t *qhash, tmq_qconfig_t *qconf)
+{
+    tmq_memmsg_t *node;
+
+    if (qhash->sched.gen==M_sched_gen)
+    {
+        return;
+    }
+
+    NDRX_LOG(log_debug, "Rebuilding forward schedule of [%s]", qhash->qname);
+
+    sched_clear(qhash);
+    qhash->sched.gen = M_sched_gen;
+    qhash->sched.mode = qconf->mode;
+
+    if (!TMQ_AUTOQ_ISAUTO(qconf->autoq) && !TMQ_MODE_ISSCHED(qconf->mode))
+    {
+        return;
+    }
+
+    CDL_FOREACH(qhash->q, node)
+    {
+        if (!node->msg->lockthreadid)
+        {
+            node->fwd_next = sched_next_try(node->msg, qconf);
+
+            if (EXSUCCEED!=sched_push(qhash, TMQ_SCHED_WAIT, node))
+            {
+                /* retry on next use */
+                qhash->sched.gen = EXFAIL;
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * Move messages which are due from wait heap to ready heap. Drop locked
+ * messages from the tops of the heaps.
+ * @param qhash queue
+ * @param now current UTC epoch second
+ */
+exprivate void sched_promote(tmq_qhash_t *qhash, long now)
+{
+    tmq_memmsg_t *mmsg;
+
+    while (qhash->sched.wait.n > 0)
+    {
+        mmsg = qhash->sched.wait.arr[0];
+
+        if (!mmsg->msg->lockthreadid && mmsg->fwd_next > now)
+        {
+            break;
+        }
+
+        sched_remove(qhash, mmsg);
+
+        if (!mmsg->msg->lockthreadid &&
+                EXSUCCEED!=sched_push(qhash, TMQ_SCHED_READY, mmsg))
+        {
+            qhash->sched.gen = EXFAIL;
+        }
+    }
+
+    while (qhash->sched.ready.n > 0 &&
+            qhash->sched.ready.arr[0]->msg->lockthreadid)
+    {
+        sched_remove(qhash, qhash->sched.ready.arr[0]);
+    }
+}
+
+/**
+ * Put unlocked message in the schedule. If message is already
+ * scheduled, it is rescheduled (try counter might be changed).
+ * @param qhash queue of the message
+ * @param mmsg message
+ * @param qconf queue config
+ * @return EXTRUE if message is scheduled for forward (queue is automatic)
+ */
+expublic int tmq_sched_add(tmq_qhash_t *qhash, tmq_memmsg_t *mmsg,
+        tmq_qconfig_t *qconf)
+{
+    int ret = TMQ_AUTOQ_ISAUTO(qconf->autoq);
+
+    if (!ret && !TMQ_MODE_ISSCHED(qconf->mode))
+    {
+        return EXFALSE;
+    }
+
+    /* will be picked up by rebuild */
+    if (qhash->sched.gen!=M_sched_gen)
+    {
+        return ret;
+    }
+
+    if (TMQ_SCHED_NONE!=mmsg->fwd_heap)
+    {
+        sched_remove(qhash, mmsg);
+    }
+
+    mmsg->fwd_next = sched_next_try(mmsg->msg, qconf);
+
+    if (EXSUCCEED!=sched_push(qhash, TMQ_SCHED_WAIT, mmsg))
+    {
+        qhash->sched.gen = EXFAIL;
+    }
+
+    return ret;
+}
+
+/**
+ * Remove message from forward schedule (message is deleted)
+ * @param qhash queue of the message
+ * @param mmsg message
+ */
+expublic void tmq_sched_del(tmq_qhash_t *qhash, tmq_memmsg_t *mmsg)
+{
+    if (TMQ_SCHED_NONE!=mmsg->fwd_heap)
+    {
+        sched_remove(qhash, mmsg);
+    }
+}
+
+/**
+ * Take next message to forward/dequeue from the queue. The message is removed
+ * from the schedule, it is put back when unlocked.
+ * @param qhash queue
+ * @param qconf queue config
+ * @return message or NULL if none is due
+ */
+expublic tmq_memmsg_t * tmq_sched_get(tmq_qhash_t *qhash, tmq_qconfig_t *qconf)
+{
+    tmq_memmsg_t *ret = NULL;
+    long now, now_usec;
+
+    sched_check(qhash, qconf);
+
+    ndrx_utc_tstamp2(&now, &now_usec);
+    sched_promote(qhash, now);
+
+    if (qhash->sched.ready.n > 0)
+    {
+        ret = qhash->sched.ready.arr[0];
+        sched_remove(qhash, ret);
+    }
+
+    return ret;
+}
+
+/**
+ * Return time when next message of the queue will be due
+ * @param qhash queue
+ * @param qconf queue config
+ * @return UTC epoch second (0 if have ready message), EXFAIL if nothing
+ *  is scheduled
+ */
+expublic long tmq_sched_due(tmq_qhash_t *qhash, tmq_qconfig_t *qconf)
+{
+    long now, now_usec;
+
+    sched_check(qhash, qconf);
+
+    ndrx_utc_tstamp2(&now, &now_usec);
+    sched_promote(qhash, now);
+
+    if (qhash->sched.ready.n > 0)
+    {
+        return 0;
+    }
+
+    if (qhash->sched.wait.n > 0)
+    {
+        return qhash->sched.wait.arr[0]->fwd_next;
+    }
+
+    /* failed to build, retry later */
+    if (qhash->sched.gen!=M_sched_gen)
+    {
+        return now+1;
+    }
+
+    return EXFAIL;
+}
+
+/**
+ * Queue config is changed, reschedule all queues on next use
+ */
+expublic void tmq_sched_invalidate(void)
+{
+    M_sched_gen++;
+
+    /* keep off the failure mark */
+    if (EXFAIL==M_sched_gen || 0==M_sched_gen)
+    {
+        M_sched_gen = 1;
+    }
+}
+
+/* vim: set ts=4 sw=4 et smartindent: */
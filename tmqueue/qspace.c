@@ -307,10 +307,18 @@ exprivate int load_param(tmq_qconfig_t * qconf, char *key, char *value)
         {
             qconf->mode = TMQ_MODE_LIFO;
         }
+        else if (0==strcmp(value, "prio") || 0==strcmp(value, "PRIO") )
+        {
+            qconf->mode = TMQ_MODE_PRIO;
+        }
+        else if (0==strcmp(value, "time") || 0==strcmp(value, "TIME") )
+        {
+            qconf->mode = TMQ_MODE_TIME;
+        }
         else
         {
-            NDRX_LOG(log_error, "Not supported Q mode (must be fifo or lifo)", 
-                    value, key);
+            NDRX_LOG(log_error, "Not supported Q mode [%s] for key [%s] "
+                    "(must be fifo, lifo, prio or time)", value, key);
             EXFAIL_OUT(ret);
         }
     }
@@ -325,6 +333,26 @@ out:
     return ret;
 }
 
+/**
+ * Get queue mode name
+ * @param mode queue mode, see TMQ_MODE_*
+ * @return mode name as in config
+ */
+exprivate char *tmq_mode_str(char mode)
+{
+    switch (mode)
+    {
+        case TMQ_MODE_LIFO:
+            return "lifo";
+        case TMQ_MODE_PRIO:
+            return "prio";
+        case TMQ_MODE_TIME:
+            return "time";
+        default:
+            return "fifo";
+    }
+}
+
 /**
  * Get Q config by name
  * @param name queue name
@@ -401,7 +429,7 @@ expublic int tmq_build_q_def(char *qname, int *p_is_defaulted, char *out_buf, si
             qdef->waitretry,
             qdef->waitretryinc,
             qdef->waitretrymax,
-            qdef->mode == TMQ_MODE_LIFO?"lifo":"fifo",
+            tmq_mode_str(qdef->mode),
             qdef->txtout);
 
     if (EXEOS!=qdef->errorq[0])
@@ -467,6 +495,7 @@ exprivate int tmq_qconf_delete(char *qname)
     {
         EXHASH_DEL( G_qconf, qconf);
         NDRX_FREE(qconf);
+        tmq_sched_invalidate();
     }
     else
     {
@@ -583,6 +612,9 @@ expublic int tmq_qconf_addupd(char *qconfstr, char *name)
     
     MUTEX_LOCK_V(M_q_lock);
     
+    /* forward times & modes depend on config */
+    tmq_sched_invalidate();
+    
     if (NULL==name)
     {
         p = strtok (qconfstr,",");
@@ -744,6 +776,24 @@ out:
     return ret;
 }
 
+/**
+ * Put unlocked message back to the forward schedule
+ * @param mmsg message
+ * @return EXTRUE if message is in automatic queue (forwarder to be woken up)
+ */
+exprivate int tmq_msg_sched(tmq_memmsg_t *mmsg)
+{
+    tmq_qhash_t *qhash = tmq_qhash_get(mmsg->msg->hdr.qname);
+    tmq_qconfig_t *qconf = tmq_qconf_get_with_default(mmsg->msg->hdr.qname, NULL);
+    
+    if (NULL==qhash || NULL==qconf)
+    {
+        return EXFALSE;
+    }
+    
+    return tmq_sched_add(qhash, mmsg, qconf);
+}
+
 /**
  * Add message to queue
  * Think about TPQLOCKED so that other thread does not get message in progress..
@@ -763,6 +813,7 @@ expublic int tmq_msg_add(tmq_msg_t **msg, int is_recovery, TPQCTL *diag)
     char msgid_str[TMMSGIDLEN_STR+1];
     char corid_str[TMCORRIDLEN_STR+1];
     int hashed=EXFALSE, hashedcor=EXFALSE, cdl=EXFALSE;
+    int wake = EXFALSE;
     
     MUTEX_LOCK_V(M_q_lock);
     is_locked = EXTRUE;
@@ -857,6 +908,13 @@ expublic int tmq_msg_add(tmq_msg_t **msg, int is_recovery, TPQCTL *diag)
         EXHASH_ADD_STR_H2( G_corid_hash, corid_str, mmsg);
         hashedcor=EXTRUE;
     }
+    
+    /* new messages are locked till commit, recovered might be not */
+    if (!mmsg->msg->lockthreadid)
+    {
+        wake = tmq_sched_add(qhash, mmsg, qconf);
+    }
+    
     /* have to unlock here, because tmq_storage_write_cmd_newmsg() migth callback to
      * us and that might cause stall.
      */
@@ -908,6 +966,11 @@ expublic int tmq_msg_add(tmq_msg_t **msg, int is_recovery, TPQCTL *diag)
     /* message is in use */
     *msg = NULL;
     
+    if (wake)
+    {
+        forward_wake();
+    }
+    
 out:
      
                 
@@ -940,6 +1003,7 @@ out:
     
         if (cdl)
         {
+           tmq_sched_del(qhash, mmsg);
            CDL_DELETE(qhash->q, mmsg);
         }
         
@@ -960,59 +1024,6 @@ out:
     return ret;
 }
 
-/**
- * Tests is auto message valid for dequeue (calculate the counters)
- * @param node
- * @return 
- */
-exprivate int tmq_is_auto_valid_for_deq(tmq_memmsg_t *node, tmq_qconfig_t *qconf)
-{
-    int ret = EXFALSE;
-    int retry_inc;
-    unsigned long long next_try;
-    long utc_sec, utc_usec;
-    
-    if (0==node->msg->trycounter)
-    {
-        next_try = node->msg->trytstamp + 
-                ((unsigned long long)qconf->waitinit);
-        
-        NDRX_LOG(log_debug, "First try, sleep %d sec", qconf->waitinit);
-    }
-    else 
-    {
-        retry_inc = qconf->waitretry*node->msg->trycounter;
-    
-        if (retry_inc > qconf->waitretrymax)
-        {
-            retry_inc = qconf->waitretrymax;
-        }
-        
-        NDRX_LOG(log_debug, "Try no %d, sleep %d sec", 
-                node->msg->trycounter, retry_inc);
-        
-        next_try = node->msg->trytstamp + 
-                retry_inc;
-    }
-    
-    ndrx_utc_tstamp2(&utc_sec, &utc_usec);
-    NDRX_LOG(log_debug, "Next try at: %ld current clock: %ld",
-            next_try, utc_sec);
-            
-    if (next_try<=utc_sec)
-    {
-        NDRX_LOG(log_debug, "Message accepted for dequeue...");
-        ret=EXTRUE;
-    }
-    else
-    {
-        NDRX_LOG(log_debug, "Message NOT accepted for dequeue...");
-    }
-    
-out:
-    return ret;
-}
-
 /**
  * Get the fifo message from Q
  * @param qname queue to lookup.
@@ -1030,6 +1041,7 @@ expublic tmq_msg_t * tmq_msg_dequeue(char *qname, long flags, int is_auto, long
     char msgid_str[TMMSGIDLEN_STR+1];
     tmq_qconfig_t *qconf;
     int is_locked=EXFALSE;
+    int wake=EXFALSE;
     
     *diagnostic=EXSUCCEED;
     
@@ -1063,56 +1075,68 @@ expublic tmq_msg_t * tmq_msg_dequeue(char *qname, long flags, int is_auto, long
         goto out;
     }
     
-    NDRX_LOG(log_debug, "mode: %s", TMQ_MODE_LIFO == qconf->mode?"LIFO":"FIFO");
+    NDRX_LOG(log_debug, "mode: %s", tmq_mode_str(qconf->mode));
     
-    /* Start from first one & loop over the list while 
-     * - we get to the first non-locked message
-     * - or we get to the end with no msg, then return FAIL.
-     */
-    if (TMQ_MODE_LIFO == qconf->mode)
+    if (is_auto || TMQ_MODE_ISSCHED(qconf->mode))
     {
-        /* LIFO mode */
-        if (NULL!=qhash->q)
+        /* forwarder takes the message which try time has come, from the
+         * schedule (in queue mode order). Priority & time mode queues are
+         * dequeued from schedule too.
+         */
+        if (NULL!=(node = tmq_sched_get(qhash, qconf)))
         {
-            node = qhash->q->prev;
-            start = qhash->q->prev;
+            ret = node->msg;
         }
     }
     else
     {
-        /* FIFO */
-        node = qhash->q;
-        start = qhash->q;
-    }
-            
-    do
-    {
-        if (NULL!=node)
+        /* Start from first one & loop over the list while 
+         * - we get to the first non-locked message
+         * - or we get to the end with no msg, then return FAIL.
+         */
+        if (TMQ_MODE_LIFO == qconf->mode)
         {
-            NDRX_LOG(log_debug, "Testing: msg_str: [%s] locked: %llu is_auto: %d",
-                    tmq_msgid_serialize(node->msg->hdr.msgid, msgid_str),
-                    node->msg->lockthreadid,
-                    is_auto
-                    );
-            if (!node->msg->lockthreadid && (!is_auto || 
-                    tmq_is_auto_valid_for_deq(node, qconf)))
+            /* LIFO mode */
+            if (NULL!=qhash->q)
             {
-                ret = node->msg;
-                break;
+                node = qhash->q->prev;
+                start = qhash->q->prev;
             }
-            if (TMQ_MODE_LIFO == qconf->mode)
-            {
-                /* LIFO mode */
-                node = node->prev;
-            }
-            else
+        }
+        else
+        {
+            /* FIFO */
+            node = qhash->q;
+            start = qhash->q;
+        }
+
+        do
+        {
+            if (NULL!=node)
             {
-                /* default to FIFO */
-                node = node->next;
+                NDRX_LOG(log_debug, "Testing: msg_str: [%s] locked: %llu",
+                        tmq_msgid_serialize(node->msg->hdr.msgid, msgid_str),
+                        node->msg->lockthreadid);
+
+                if (!node->msg->lockthreadid)
+                {
+                    ret = node->msg;
+                    break;
+                }
+                if (TMQ_MODE_LIFO == qconf->mode)
+                {
+                    /* LIFO mode */
+                    node = node->prev;
+                }
+                else
+                {
+                    /* default to FIFO */
+                    node = node->next;
+                }
             }
         }
+        while (NULL!=node && node!=start);
     }
-    while (NULL!=node && node!=start);
     
     if (NULL==ret)
     {
@@ -1146,6 +1170,7 @@ expublic tmq_msg_t * tmq_msg_dequeue(char *qname, long flags, int is_auto, long
             /* unlock msg... */
             MUTEX_LOCK_V(M_q_lock);
             ret->lockthreadid = 0;
+            wake = tmq_msg_sched(node);
             MUTEX_UNLOCK_V(M_q_lock);
             
             ret = NULL;
@@ -1161,6 +1186,11 @@ out:
     {
         MUTEX_UNLOCK_V(M_q_lock);
     }
+    
+    if (wake)
+    {
+        forward_wake();
+    }
 
     /* set default error code */
     if (NULL==ret && EXSUCCEED==*diagnostic)
@@ -1185,6 +1215,7 @@ expublic tmq_msg_t * tmq_msg_dequeue_by_msgid(char *msgid, long flags, long *dia
     tmq_msg_del_t del;
     char msgid_str[TMMSGIDLEN_STR+1];
     tmq_memmsg_t *mmsg;
+    int wake=EXFALSE;
     
     *diagnostic=EXSUCCEED;
     
@@ -1224,6 +1255,7 @@ expublic tmq_msg_t * tmq_msg_dequeue_by_msgid(char *msgid, long flags, long *dia
             NDRX_LOG(log_error, "Failed to remove msg...");
             /* unlock msg... */
             ret->lockthreadid = 0;
+            wake = tmq_msg_sched(mmsg);
             ret = NULL;
             *diagnostic=QMEOS;
             NDRX_STRCPY_SAFE_DST(diagmsg, "tmq_dequeue: disk write error!", diagmsgsz);
@@ -1233,6 +1265,11 @@ expublic tmq_msg_t * tmq_msg_dequeue_by_msgid(char *msgid, long flags, long *dia
     
 out:
     MUTEX_UNLOCK_V(M_q_lock);
+    
+    if (wake)
+    {
+        forward_wake();
+    }
 
     /* set default error code */
     if (NULL==ret && EXSUCCEED==*diagnostic)
@@ -1257,6 +1294,7 @@ expublic tmq_msg_t * tmq_msg_dequeue_by_corid(char *corid, long flags, long *dia
     tmq_msg_del_t block;
     char corid_str[TMCORRIDLEN_STR+1];
     tmq_memmsg_t *mmsg;
+    int wake=EXFALSE;
     
     *diagnostic=EXSUCCEED;
     
@@ -1296,6 +1334,7 @@ expublic tmq_msg_t * tmq_msg_dequeue_by_corid(char *corid, long flags, long *dia
             NDRX_LOG(log_error, "Failed to remove msg...");
             /* unlock msg... */
             ret->lockthreadid = 0;
+            wake = tmq_msg_sched(mmsg);
             ret = NULL;
             *diagnostic=QMEOS;
             NDRX_STRCPY_SAFE_DST(diagmsg, "tmq_dequeue: disk write error!", diagmsgsz);
@@ -1305,6 +1344,11 @@ expublic tmq_msg_t * tmq_msg_dequeue_by_corid(char *corid, long flags, long *dia
     
 out:
     MUTEX_UNLOCK_V(M_q_lock);
+    
+    if (wake)
+    {
+        forward_wake();
+    }
 
     /* set default error code */
     if (NULL==ret && EXSUCCEED==*diagnostic)
@@ -1378,6 +1422,8 @@ exprivate void tmq_remove_msg(tmq_memmsg_t *mmsg)
     {
         qhash->numdeq++;
         
+        tmq_sched_del(qhash, mmsg);
+        
         /* Add the message to end of the queue */
         CDL_DELETE(qhash->q, mmsg);    
     }
@@ -1407,6 +1453,7 @@ expublic int tmq_unlock_msg(union tmq_upd_block *b)
     int ret = EXSUCCEED;
     char msgid_str[TMMSGIDLEN_STR+1];
     tmq_memmsg_t* mmsg;
+    int wake = EXFALSE;
     
     tmq_msgid_serialize(b->hdr.msgid, msgid_str);
     
@@ -1441,6 +1488,8 @@ expublic int tmq_unlock_msg(union tmq_upd_block *b)
         case TMQ_STORCMD_UNLOCK:
             NDRX_LOG(log_info, "Unlocking message...");
             mmsg->msg->lockthreadid = 0;
+            /* forward again (with updated try counter) */
+            wake = tmq_msg_sched(mmsg);
             break;
         default:
             NDRX_LOG(log_info, "Unknown command [%c]", b->hdr.command_code);
@@ -1450,6 +1499,12 @@ expublic int tmq_unlock_msg(union tmq_upd_block *b)
     
 out:
     MUTEX_UNLOCK_V(M_q_lock);
+    
+    if (wake)
+    {
+        forward_wake();
+    }
+    
     return ret;
 }
 
@@ -1463,6 +1518,7 @@ expublic int tmq_unlock_msg_by_msgid(char *msgid)
     int ret = EXSUCCEED;
     char msgid_str[TMMSGIDLEN_STR+1];
     tmq_memmsg_t* mmsg;
+    int wake = EXFALSE;
     
     tmq_msgid_serialize(msgid, msgid_str);
     
@@ -1479,9 +1535,16 @@ expublic int tmq_unlock_msg_by_msgid(char *msgid)
     }
     
     mmsg->msg->lockthreadid = 0;
+    wake = tmq_msg_sched(mmsg);
     
 out:
     MUTEX_UNLOCK_V(M_q_lock);
+    
+    if (wake)
+    {
+        forward_wake();
+    }
+    
     return ret;
 }
 
@@ -1583,6 +1646,28 @@ exprivate int q_msg_sort(tmq_memmsg_t *q1, tmq_memmsg_t *q2)
     
 }
 
+/**
+ * compare two Q entries, by priority (highest first) + time
+ * @param q1
+ * @param q2
+ * @return 
+ */
+exprivate int q_msg_sort_prio(tmq_memmsg_t *q1, tmq_memmsg_t *q2)
+{
+    return tmq_sched_msg_cmp(TMQ_MODE_PRIO, q1->msg, q2->msg);
+}
+
+/**
+ * compare two Q entries, by dequeue time + time
+ * @param q1
+ * @param q2
+ * @return 
+ */
+exprivate int q_msg_sort_time(tmq_memmsg_t *q1, tmq_memmsg_t *q2)
+{
+    return tmq_sched_msg_cmp(TMQ_MODE_TIME, q1->msg, q2->msg);
+}
+
 /**
  * Return list of auto queues
  * @return NULL or list
@@ -1666,6 +1751,7 @@ expublic tmq_memmsg_t *tmq_get_msglist(char *qname)
     tmq_memmsg_t * ret = NULL;
     tmq_memmsg_t * tmp = NULL;
     tmq_msg_t * msg = NULL;
+    tmq_qconfig_t *qconf;
     
     NDRX_LOG(log_debug, "tmq_get_msglist listing for [%s]", qname);
     MUTEX_LOCK_V(M_q_lock);
@@ -1715,6 +1801,19 @@ expublic tmq_memmsg_t *tmq_get_msglist(char *qname)
     }
     while (NULL!=node && node!=qhash->q);
     
+    /* list in dequeue order */
+    if (NULL!=(qconf=tmq_qconf_get_with_default(qname, NULL)))
+    {
+        if (TMQ_MODE_PRIO==qconf->mode)
+        {
+            DL_SORT(ret, q_msg_sort_prio);
+        }
+        else if (TMQ_MODE_TIME==qconf->mode)
+        {
+            DL_SORT(ret, q_msg_sort_time);
+        }
+    }
+    
 out:
     MUTEX_UNLOCK_V(M_q_lock);
     return ret;
@@ -1795,6 +1894,35 @@ out:
     return EXSUCCEED;
 }
 
+/**
+ * Return time when next message of automatic queues will be due for forward
+ * @return UTC epoch second (0 if have messages ready), EXFAIL if none scheduled
+ */
+expublic long tmq_fwd_due(void)
+{
+    long ret = EXFAIL;
+    long due;
+    tmq_qhash_t *q, *qtmp;
+    tmq_qconfig_t *qconf;
+    
+    MUTEX_LOCK_V(M_q_lock);
+    
+    EXHASH_ITER(hh, G_qhash, q, qtmp)
+    {
+        if (NULL!=(qconf=tmq_qconf_get_with_default(q->qname, NULL)) &&
+                TMQ_AUTOQ_ISAUTO(qconf->autoq) &&
+                EXFAIL!=(due=tmq_sched_due(q, qconf)) &&
+                (EXFAIL==ret || due < ret))
+        {
+            ret = due;
+        }
+    }
+    
+    MUTEX_UNLOCK_V(M_q_lock);
+    
+    return ret;
+}
+
 /**
  * Return infos about enqueued messages.
  * @param qname
@@ -210,6 +210,32 @@ expublic int tmq_enqueue(UBFH *p_ub)
         EXFAIL_OUT(ret);
     }
     
+    if ((p_msg->qctl.flags & TPQPRIORITY) && 
+            (p_msg->qctl.priority < TMQ_PRIO_MIN || 
+            p_msg->qctl.priority > TMQ_PRIO_MAX))
+    {
+        NDRX_LOG(log_error, "tmq_enqueue: invalid priority %ld", 
+                p_msg->qctl.priority);
+        
+        snprintf(qctl_out.diagmsg, sizeof(qctl_out.diagmsg), 
+                "tmq_enqueue: invalid priority %ld (must be %d..%d)!",
+                p_msg->qctl.priority, TMQ_PRIO_MIN, TMQ_PRIO_MAX);
+        qctl_out.diagnostic = QMEINVAL;
+        
+        EXFAIL_OUT(ret);
+    }
+    
+    if ((p_msg->qctl.flags & TPQTIME_ABS) && (p_msg->qctl.flags & TPQTIME_REL))
+    {
+        NDRX_LOG(log_error, "tmq_enqueue: both TPQTIME_ABS and TPQTIME_REL set");
+        
+        NDRX_STRCPY_SAFE(qctl_out.diagmsg, "tmq_enqueue: both TPQTIME_ABS "
+                "and TPQTIME_REL set!");
+        qctl_out.diagnostic = QMEINVAL;
+        
+        EXFAIL_OUT(ret);
+    }
+    
     /* Build up the message. */
     tmq_setup_cmdheader_newmsg(&p_msg->hdr, p_msg->hdr.qname, 
             tpgetnodeid(), G_server_conf.srv_id, G_tmqueue_cfg.qspace, p_msg->qctl.flags);
@@ -238,6 +264,14 @@ expublic int tmq_enqueue(UBFH *p_ub)
     p_msg->msgtstamp_cntr = t_cntr;
     MUTEX_UNLOCK_V(M_tstamp_lock);
     
+    /* relative dequeue time is stored as absolute */
+    if (p_msg->qctl.flags & TPQTIME_REL)
+    {
+        p_msg->qctl.deq_time += p_msg->msgtstamp;
+        p_msg->qctl.flags &= ~TPQTIME_REL;
+        p_msg->qctl.flags |= TPQTIME_ABS;
+    }
+    
     p_msg->status = TMQ_STATUS_ACTIVE;
     
     NDRX_LOG(log_info, "Messag prepared ok, about to enqueue to [%s] Q...",
@@ -735,6 +769,8 @@ expublic int tmq_mqlm(UBFH *p_ub, int cd)
     char qname[TMQNAMELEN+1];
     short is_locked;
     char msgid_str[TMMSGIDLEN_STR+1];
+    long prio;
+    long deq_time;
 
     /* Get list of queues */
     
@@ -766,6 +802,9 @@ expublic int tmq_mqlm(UBFH *p_ub, int cd)
         
         tmq_msgid_serialize(el->msg->hdr.msgid, msgid_str);
         
+        prio = tmq_sched_prio(el->msg);
+        deq_time = (el->msg->qctl.flags & TPQTIME_ABS) ? el->msg->qctl.deq_time : 0;
+        
         if (EXSUCCEED!=Bchg(p_ub, TMNODEID, 0, (char *)&nodeid, 0L) ||
             EXSUCCEED!=Bchg(p_ub, TMSRVID, 0, (char *)&srvid, 0L) ||
             EXSUCCEED!=Bchg(p_ub, EX_QMSGIDSTR, 0, msgid_str, 0L)  ||
@@ -774,7 +813,9 @@ expublic int tmq_mqlm(UBFH *p_ub, int cd)
             EXSUCCEED!=Bchg(p_ub, EX_TSTAMP2_STR, 0, 
                 ndrx_get_strtstamp2(1, el->msg->trytstamp, el->msg->trytstamp_usec), 0L) ||
             EXSUCCEED!=Bchg(p_ub, EX_QMSGTRIES, 0, (char *)&el->msg->trycounter, 0L) ||
-            EXSUCCEED!=Bchg(p_ub, EX_QMSGLOCKED, 0, (char *)&is_locked, 0L)
+            EXSUCCEED!=Bchg(p_ub, EX_QMSGLOCKED, 0, (char *)&is_locked, 0L) ||
+            EXSUCCEED!=Bchg(p_ub, EX_QPRIORITY, 0, (char *)&prio, 0L) ||
+            EXSUCCEED!=Bchg(p_ub, EX_QDEQ_TIME, 0, (char *)&deq_time, 0L)
                 )
         {
             NDRX_LOG(log_error, "failed to setup FB: %s", Bstrerror(Berror));
@@ -59,6 +59,14 @@ extern int G_forward_req_shutdown;    /* Is shutdown request? */
 
 #define TMQ_MODE_FIFO           'F' /**< fifo q mode                        */
 #define TMQ_MODE_LIFO           'L' /**< lifo q mode                        */
+#define TMQ_MODE_PRIO           'P' /**< priority q mode (TPQPRIORITY)      */
+#define TMQ_MODE_TIME           'T' /**< dequeue time q mode (TPQTIME_*)    */
+/** Queue mode served from schedule heaps */
+#define TMQ_MODE_ISSCHED(X) ((TMQ_MODE_PRIO==X) || (TMQ_MODE_TIME==X))
+
+#define TMQ_PRIO_MIN            1   /**< Lowest message priority            */
+#define TMQ_PRIO_MAX            100 /**< Highest message priority           */
+#define TMQ_PRIO_DFLT           50  /**< Priority if TPQPRIORITY not set    */
 
 /* Autoq flags: */
 #define TMQ_AUTOQ_MANUAL        'N' /**< Not automatic Q                    */
@@ -74,6 +82,11 @@ extern int G_forward_req_shutdown;    /* Is shutdown request? */
 
 #define TMQ_QUEUE_SERVICE       "@" /**< Special name when service matches queue name */
 
+/* Forward schedule heaps: */
+#define TMQ_SCHED_NONE          0   /**< Message is not scheduled           */
+#define TMQ_SCHED_WAIT          1   /**< Waiting for next try time          */
+#define TMQ_SCHED_READY         2   /**< Ready for forward                  */
+
 /*---------------------------Enums--------------------------------------*/
 /*---------------------------Typedefs-----------------------------------*/
 
@@ -128,8 +141,33 @@ struct tmq_memmsg
     tmq_memmsg_t *prev;
     
     tmq_msg_t *msg;
+    
+    long fwd_next;  /**< next try time (UTC epoch sec), when scheduled  */
+    int fwd_idx;    /**< index in the schedule heap                     */
+    char fwd_heap;  /**< schedule heap, see TMQ_SCHED_*                 */
 };
 
+/**
+ * Heap of messages
+ */
+typedef struct
+{
+    tmq_memmsg_t **arr; /**< heap array                                 */
+    int n;              /**< number of messages in heap                 */
+    int alloc;          /**< allocated slots                            */
+} tmq_heap_t;
+
+/**
+ * Schedule of automatic queue or priority/time mode queue
+ */
+typedef struct
+{
+    tmq_heap_t wait;    /**< unlocked msgs by next try time             */
+    tmq_heap_t ready;   /**< due msgs in dequeue order (see queue mode) */
+    int gen;            /**< config generation the heaps are built for  */
+    char mode;          /**< queue mode the ready heap is built for     */
+} tmq_qsched_t;
+
 /**
  * List of queues (for queued messages)
  */
@@ -145,6 +183,7 @@ struct tmq_qhash
     
     EX_hash_handle hh; /**< makes this structure hashable        */
     tmq_memmsg_t *q;
+    tmq_qsched_t sched; /**< forward/dequeue schedule           */
 };
 
 /**
@@ -215,6 +254,7 @@ extern int tex_mq_notify(UBFH *p_ub);
 /* Background API */
 extern int background_read_log(void);
 extern void forward_shutdown_wake(void);
+extern void forward_wake(void);
 extern int forward_process_init(void);
 extern void forward_lock(void);
 extern void forward_unlock(void);
@@ -237,6 +277,17 @@ extern tmq_memmsg_t *tmq_get_msglist(char *qname);
     
 extern int tmq_update_q_stats(char *qname, long succ_diff, long fail_diff);
 extern void tmq_get_q_stats(char *qname, long *p_msgs, long *p_locked);
+extern long tmq_fwd_due(void);
+
+/* Forward & dequeue schedule (called with queue space locked): */
+extern int tmq_sched_add(tmq_qhash_t *qhash, tmq_memmsg_t *mmsg, tmq_qconfig_t *qconf);
+extern void tmq_sched_del(tmq_qhash_t *qhash, tmq_memmsg_t *mmsg);
+extern tmq_memmsg_t * tmq_sched_get(tmq_qhash_t *qhash, tmq_qconfig_t *qconf);
+extern long tmq_sched_due(tmq_qhash_t *qhash, tmq_qconfig_t *qconf);
+extern void tmq_sched_invalidate(void);
+extern int tmq_sched_msg_cmp(char mode, tmq_msg_t *m1, tmq_msg_t *m2);
+extern long tmq_sched_prio(tmq_msg_t *msg);
+extern long tmq_sched_deq_time(tmq_msg_t *msg);
     
 #ifdef	__cplusplus
 }
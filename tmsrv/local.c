@@ -296,16 +296,20 @@ out:
 /*                         COMMIT SECTION                                   */
 /******************************************************************************/
 /**
- * Abort current RM transaction
+ * Commit current RM transaction
  * @param p_xai
+ * @param[in] btid branch tid
+ * @param[in] flags XA flags, TMONEPHASE if branch was not prepared
  * @return XA error code.
  */
-expublic int tm_commit_local(UBFH *p_ub, atmi_xa_tx_info_t *p_xai, long btid)
+expublic int tm_commit_local(UBFH *p_ub, atmi_xa_tx_info_t *p_xai, long btid,
+        long flags)
 {
     int ret = EXSUCCEED;
     
     /* we should start new transaction... */
-    if (EXSUCCEED!=(ret = atmi_xa_commit_entry(atmi_xa_get_branch_xid(p_xai, btid), 0)))
+    if (EXSUCCEED!=(ret = atmi_xa_commit_entry(atmi_xa_get_branch_xid(p_xai, btid), 
+            flags)))
     {
         NDRX_LOG(log_error, "Failed to commit transaction btid %ld!", btid);
         
@@ -326,16 +330,24 @@ out:
 /**
  * Do remote commit call
  * @param p_xai
+ * @param[in] flags XA flags, TMONEPHASE is passed to remote TM
  * @return SUCCEED/FAIL
  */
-expublic int tm_commit_remote_call(atmi_xa_tx_info_t *p_xai, short rmid, long btid)
+expublic int tm_commit_remote_call(atmi_xa_tx_info_t *p_xai, short rmid, long btid,
+        long flags)
 {
     UBFH* p_ub;
-            
+    long tmflags = 0;
+    
+    if (flags & TMONEPHASE)
+    {
+        tmflags|=TMFLAGS_ONEPHASE;
+    }
+    
     /* Call the remote TM.
      * TODO: How about error handling? 
      */
-    p_ub=atmi_xa_call_tm_generic(ATMI_XA_TMCOMMIT, EXTRUE, rmid, p_xai, 0L, btid);
+    p_ub=atmi_xa_call_tm_generic(ATMI_XA_TMCOMMIT, EXTRUE, rmid, p_xai, tmflags, btid);
 
     if (NULL==p_ub)    
         return EXFAIL;
@@ -349,19 +361,21 @@ expublic int tm_commit_remote_call(atmi_xa_tx_info_t *p_xai, short rmid, long bt
 /**
  * Combined commit of to commit. Selects automatically do the local commit or
  * remote depending on RMID.
+ * @param[in] flags XA flags, TMONEPHASE for single branch commit w/o prepare
  */
-expublic int tm_commit_combined(atmi_xa_tx_info_t *p_xai, short rmid, long btid)
+expublic int tm_commit_combined(atmi_xa_tx_info_t *p_xai, short rmid, long btid,
+        long flags)
 {
     int ret = EXSUCCEED;
     
     /* Check is this local */
     if (rmid == G_atmi_env.xa_rmid)
     {
-        ret  = tm_commit_local(NULL, p_xai, btid);
+        ret  = tm_commit_local(NULL, p_xai, btid, flags);
     }
     else
     {
-        ret = tm_commit_remote_call(p_xai, rmid, btid);
+        ret = tm_commit_remote_call(p_xai, rmid, btid, flags);
     }
     
 out:
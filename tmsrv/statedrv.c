@@ -73,6 +73,72 @@ typedef struct
 /*---------------------------Statics------------------------------------*/
 /*---------------------------Prototypes---------------------------------*/
 
+/**
+ * Check is transaction eligible for one-phase commit. That is the case
+ * when only one branch is joined and it is still active (i.e. not prepared
+ * already at the end of the work).
+ * @param p_tl transaction log
+ * @return EXTRUE - single active branch, EXFALSE - two-phase commit needed
+ */
+exprivate int tm_is_onephase(atmi_xa_log_t *p_tl)
+{
+    int i;
+    int cnt = 0;
+    int active = EXFALSE;
+    atmi_xa_rm_status_btid_t *el, *elt;
+    
+    for (i=0; i<NDRX_MAX_RMS; i++)
+    {
+        EXHASH_ITER(hh, p_tl->rmstatus[i].btid_hash, el, elt)
+        {
+            cnt++;
+            active = (XA_RM_STATUS_ACTIVE==el->rmstatus);
+        }
+    }
+    
+    return (1==cnt && active);
+}
+
+/**
+ * Check that all transaction branches are in given status
+ * @param p_tl transaction log
+ * @param rmstatus RM status to check
+ * @return EXTRUE - all branches (at least one) are in status, EXFALSE - not
+ */
+exprivate int tm_is_all_status(atmi_xa_log_t *p_tl, char rmstatus)
+{
+    int i;
+    int cnt = 0;
+    atmi_xa_rm_status_btid_t *el, *elt;
+    
+    for (i=0; i<NDRX_MAX_RMS; i++)
+    {
+        EXHASH_ITER(hh, p_tl->rmstatus[i].btid_hash, el, elt)
+        {
+            if (rmstatus!=el->rmstatus)
+            {
+                return EXFALSE;
+            }
+            cnt++;
+        }
+    }
+    
+    return cnt > 0;
+}
+
+/**
+ * Is the transaction stage final (transaction is completed in this stage)
+ * @param txstage stage to check
+ * @return EXTRUE/EXFALSE
+ */
+exprivate int tm_is_stage_complete(short txstage)
+{
+    txstage_descriptor_t* descr = xa_stage_get_descr(txstage);
+    
+    return (NULL!=descr && txstage>=descr->txs_min_complete && 
+            txstage<=descr->txs_max_complete);
+}
+
 /**
  * Do one try for transaciton processing using state machine defined in atmilib
  * @param p_xai - xa info structure
@@ -99,12 +165,23 @@ expublic int tm_drive(atmi_xa_tx_info_t *p_xai, atmi_xa_log_t *p_tl, int master_
     int try=0;
     int was_retry;
     int is_tx_finished = EXFALSE;
+    int is_onephase = EXFALSE;
     
     NDRX_LOG(log_info, "tm_drive() enter from xid=[%s] flags=%ld", 
             p_xai->tmxid, flags);
     
     memset(&stagearr, 0, sizeof(stagearr));
     
+    /* Single active branch: prepare and logging of the commit decision
+     * is not needed, the branch is committed with TMONEPHASE directly.
+     */
+    if (XA_OP_COMMIT==master_op && XA_TX_STAGE_PREPARING==p_tl->txstage &&
+            G_tmsrv_cfg.onephase && tm_is_onephase(p_tl))
+    {
+        NDRX_LOG(log_info, "Single branch joined - using one-phase commit");
+        is_onephase = EXTRUE;
+    }
+    
     do
     {
         short new_txstage = XA_TX_STAGE_MAX_NEVER;
@@ -112,6 +189,8 @@ expublic int tm_drive(atmi_xa_tx_info_t *p_xai, atmi_xa_log_t *p_tl, int master_
         int op_ret = 0;
         int op_reason = 0;
         int op_tperrno = 0;
+        /* one-phase is done only in place of prepare */
+        int do_onephase = (is_onephase && XA_TX_STAGE_PREPARING==p_tl->txstage);
         atmi_xa_rm_status_btid_t *el, *elt;
         was_retry = EXFALSE;
         
@@ -148,6 +227,12 @@ expublic int tm_drive(atmi_xa_tx_info_t *p_xai, atmi_xa_log_t *p_tl, int master_
                 op_reason = XA_OK;
                 op_tperrno = 0;
                 op_code = xa_status_get_op(p_tl->txstage, el->rmstatus);
+                
+                if (do_onephase && XA_OP_PREPARE==op_code)
+                {
+                    op_code = XA_OP_COMMIT;
+                }
+                
                 switch (op_code)
                 {
                     case XA_OP_NOP:
@@ -162,17 +247,20 @@ expublic int tm_drive(atmi_xa_tx_info_t *p_xai, atmi_xa_log_t *p_tl, int master_
                         }
                         break;
                     case XA_OP_COMMIT:
-                        NDRX_LOG(log_info, "Commit RMID %d", i+1);
+                        NDRX_LOG(log_info, "Commit RMID %d%s", i+1, 
+                                do_onephase?" (one-phase)":"");
                         
                         /* system test entry point
                          * for case when tmsrv is unable to complete...
                          */
-                        if (NDRX_SYSTEST_ENBLD && ndrx_systest_case(NDRX_SYSTEST_TMSCOMMIT))
+                        if (!do_onephase && NDRX_SYSTEST_ENBLD && 
+                                ndrx_systest_case(NDRX_SYSTEST_TMSCOMMIT))
                         {
                             op_reason = XAER_RMERR;
                             op_tperrno = TPESVCERR;
                         }
-                        else if (EXSUCCEED!=(op_ret = tm_commit_combined(p_xai, i+1, el->btid)))
+                        else if (EXSUCCEED!=(op_ret = tm_commit_combined(p_xai, i+1, el->btid,
+                                do_onephase?TMONEPHASE:TMNOFLAGS)))
                         {
                             op_reason = atmi_xa_get_reason();
                             op_tperrno = tperrno;
@@ -253,12 +341,24 @@ expublic int tm_drive(atmi_xa_tx_info_t *p_xai, atmi_xa_log_t *p_tl, int master_
                         goto out;
                     }
                     
+                    /* One-phase outcome is final, the log file is removed
+                     * right after. If we crash before that, recovery finds
+                     * active branch in preparing stage and rolls it back
+                     * (which is no-op for the RM).
+                     */
+                    if (do_onephase && tm_is_stage_complete(vote_txstage->next_txstage))
+                    {
+                        el->rmstatus = vote_txstage->next_rmstatus;
+                        el->rmerrorcode = tperrno;
+                        el->rmreason = op_reason;
+                        rm_vote_next_txstage = vote_txstage->next_txstage;
+                    }
                     /* Log RM status change... 
                      * not very critical, as we will retry with last op.
                      * if not logged.
                      * BUt if prepare logging fails, vote for aborting.
                      */
-                    if (EXSUCCEED!=tms_log_rmstatus(p_tl, el, vote_txstage->next_rmstatus, 
+                    else if (EXSUCCEED!=tms_log_rmstatus(p_tl, el, vote_txstage->next_rmstatus, 
                             tperrno, op_reason) && XA_TX_STAGE_PREPARING==p_tl->txstage)
                     {
                         /* vote for abort */
@@ -392,6 +492,17 @@ expublic int tm_drive(atmi_xa_tx_info_t *p_xai, atmi_xa_log_t *p_tl, int master_
             
         } /* calc stage */
         
+        /* All branches voted read-only - there is nothing to do in phase two,
+         * thus commit decision is not logged & synced to disk.
+         */
+        if (XA_TX_STAGE_PREPARING==descr->txstage && 
+                XA_TX_STAGE_COMMITTING==new_txstage &&
+                tm_is_all_status(p_tl, XA_RM_STATUS_COMMITTED_RO))
+        {
+            NDRX_LOG(log_info, "All branches read-only - skip commit phase");
+            new_txstage = XA_TX_STAGE_COMMITTED;
+        }
+        
         /* Finally switch the stage & run again! */
         if (new_txstage!=descr->txstage && new_txstage!=XA_TX_STAGE_MAX_NEVER)
         {
@@ -402,8 +513,15 @@ expublic int tm_drive(atmi_xa_tx_info_t *p_xai, atmi_xa_log_t *p_tl, int master_
                 is_forced = EXFALSE;
             }
             
+            if (do_onephase && tm_is_stage_complete(new_txstage))
+            {
+                /* final one-phase outcome, log is removed next */
+                NDRX_LOG(log_info, "One-phase commit completed in stage %hd", 
+                        new_txstage);
+                p_tl->txstage = new_txstage;
+            }
             /* this will return FAIL only if we are switching to committing: */
-            if (EXSUCCEED!=tms_log_stage(p_tl, new_txstage, is_forced))
+            else if (EXSUCCEED!=tms_log_stage(p_tl, new_txstage, is_forced))
             {
                 /* critical point here is if we decided to go for commit
                  * and we was not able to log that, then we must
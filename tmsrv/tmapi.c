@@ -635,6 +635,8 @@ expublic int tm_tmcommit(UBFH *p_ub)
 {
     int ret = EXSUCCEED;
     atmi_xa_tx_info_t xai;
+    long tmflags = 0;
+    long flags = TMNOFLAGS;
     
     NDRX_LOG(log_debug, "tm_tmcommit called.");
     /* read xai from FB... */
@@ -645,7 +647,15 @@ expublic int tm_tmcommit(UBFH *p_ub)
         EXFAIL_OUT(ret);
     }
     
-    if (EXSUCCEED!=(ret = tm_commit_local(p_ub, &xai, xai.btid)))
+    /* master TM asks for one-phase commit (optional field) */
+    if (EXSUCCEED==Bget(p_ub, TMTXFLAGS, 0, (char *)&tmflags, 0L)
+            && (tmflags & TMFLAGS_ONEPHASE))
+    {
+        NDRX_LOG(log_debug, "One-phase commit requested");
+        flags|=TMONEPHASE;
+    }
+    
+    if (EXSUCCEED!=(ret = tm_commit_local(p_ub, &xai, xai.btid, flags)))
     {
         EXFAIL_OUT(ret);
     }
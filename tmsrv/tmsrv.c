@@ -471,7 +471,7 @@ int tpsvrinit(int argc, char **argv)
     G_tmsrv_cfg.housekeeptime = TMSRV_HOUSEKEEP_DEFAULT;
     
     /* Parse command line  */
-    while ((c = getopt(argc, argv, "P:t:s:l:c:m:p:r:Rh:")) != -1)
+    while ((c = getopt(argc, argv, "P:t:s:l:c:m:p:r:Rh:O")) != -1)
     {
 
 	if (optarg)
@@ -519,6 +519,10 @@ int tpsvrinit(int argc, char **argv)
             case 'h':
                 G_tmsrv_cfg.housekeeptime = atoi(optarg);
                 break;
+            case 'O':
+                /* skip prepare for single branch transactions */
+                G_tmsrv_cfg.onephase = EXTRUE;
+                break;
             case 'P':
                 /* Ping will run with timeout timer interval...
                  * will work with RECON flags (which must be set for this case)
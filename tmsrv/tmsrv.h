@@ -87,6 +87,7 @@ typedef struct
     threadpool thpool;
     
     int housekeeptime;        /**< Number of seconds for corrupted log cleanup*/
+    int onephase;             /**< Use one-phase commit for single branch */
     
 } tmsrv_cfg_t;
 
@@ -153,9 +154,12 @@ extern int tm_forget_remote_call(atmi_xa_tx_info_t *p_xai, short rmid, long btid
 extern int tm_forget_combined(atmi_xa_tx_info_t *p_xai, short rmid, long btid);
 
 /* Commit API */
-extern int tm_commit_local(UBFH *p_ub, atmi_xa_tx_info_t *p_xai, long btid);
-extern int tm_commit_remote_call(atmi_xa_tx_info_t *p_xai, short rmid, long btid);
-extern int tm_commit_combined(atmi_xa_tx_info_t *p_xai, short rmid, long btid);
+extern int tm_commit_local(UBFH *p_ub, atmi_xa_tx_info_t *p_xai, long btid,
+        long flags);
+extern int tm_commit_remote_call(atmi_xa_tx_info_t *p_xai, short rmid, long btid,
+        long flags);
+extern int tm_commit_combined(atmi_xa_tx_info_t *p_xai, short rmid, long btid,
+        long flags);
 
 extern int tm_tpbegin(UBFH *p_ub);
 extern int tm_tpcommit(UBFH *p_ub);
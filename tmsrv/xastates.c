@@ -89,6 +89,24 @@ exprivate rmstatus_driver_t M_rm_status_driver_preparing[] =
     /* if restarted, vote for commit */
     {XA_TX_STAGE_PREPARING, XA_RM_STATUS_COMMITTED_RO,XA_OP_NOP,XA_OK,XA_OK,          XA_RM_STATUS_COMMITTED_RO,  XA_TX_STAGE_COMMITTING},
     
+    /* One-phase commit of single branch, prepare is skipped: */
+    {XA_TX_STAGE_PREPARING, XA_RM_STATUS_ACTIVE, XA_OP_COMMIT,  XA_OK,      XA_OK,      XA_RM_STATUS_COMMITTED,     XA_TX_STAGE_COMMITTED},
+    {XA_TX_STAGE_PREPARING, XA_RM_STATUS_ACTIVE, XA_OP_COMMIT,  XA_RDONLY,  XA_RDONLY,  XA_RM_STATUS_COMMITTED_RO,  XA_TX_STAGE_COMMITTED},
+    {XA_TX_STAGE_PREPARING, XA_RM_STATUS_ACTIVE, XA_OP_COMMIT,  XA_RBBASE,  XA_RBEND,   XA_RM_STATUS_ABORTED,       XA_TX_STAGE_ABORTED},
+    /* branch rolled back by RM: */
+    {XA_TX_STAGE_PREPARING, XA_RM_STATUS_ACTIVE, XA_OP_COMMIT,  XAER_RMERR, XAER_RMERR, XA_RM_STATUS_ABORTED,       XA_TX_STAGE_ABORTED},
+    {XA_TX_STAGE_PREPARING, XA_RM_STATUS_ACTIVE, XA_OP_COMMIT,  XAER_NOTA,  XAER_NOTA,  XA_RM_STATUS_ABORTED,       XA_TX_STAGE_ABORTED},
+    /* TPEHAZARD + xa_forget */
+    {XA_TX_STAGE_PREPARING, XA_RM_STATUS_ACTIVE, XA_OP_COMMIT,  XA_HEURHAZ, XA_HEURHAZ, XA_RM_STATUS_COMFORGET_HAZ, XA_TX_STAGE_COMFORGETTING},
+    /* TPEHEURISTIC + xa_forget */
+    {XA_TX_STAGE_PREPARING, XA_RM_STATUS_ACTIVE, XA_OP_COMMIT,  XA_HEURCOM, XA_HEURCOM, XA_RM_STATUS_COMFORGET_HEU, XA_TX_STAGE_COMFORGETTING},
+    {XA_TX_STAGE_PREPARING, XA_RM_STATUS_ACTIVE, XA_OP_COMMIT,  XA_HEURRB,  XA_HEURRB,  XA_RM_STATUS_COMFORGET_HEU, XA_TX_STAGE_COMFORGETTING},
+    {XA_TX_STAGE_PREPARING, XA_RM_STATUS_ACTIVE, XA_OP_COMMIT,  XA_HEURMIX, XA_HEURMIX, XA_RM_STATUS_COMFORGET_HEU, XA_TX_STAGE_COMFORGETTING},
+    /* RM failed, outcome is not known: */
+    {XA_TX_STAGE_PREPARING, XA_RM_STATUS_ACTIVE, XA_OP_COMMIT,  XAER_RMFAIL,XAER_RMFAIL,XA_RM_STATUS_COMMIT_HAZARD, XA_TX_STAGE_COMMITTED_HAZARD},
+    /* Any other error, branch not touched, run abort sequence */
+    {XA_TX_STAGE_PREPARING, XA_RM_STATUS_ACTIVE, XA_OP_COMMIT,  INT_MIN,    INT_MAX,    XA_RM_STATUS_ACT_AB,        XA_TX_STAGE_ABORTING},
+    
     {EXFAIL}
 };
 
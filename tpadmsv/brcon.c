@@ -79,6 +79,20 @@ typedef struct
     long timediffms;/**< time diff in seconds between hosts */
     long roundtrip; /**< roundtrip in milliseconds          */
     
+    /* Compression: */
+    char cmpr;      /**< Y - compression active             */
+    long cmprin;    /**< bytes before compression           */
+    long cmprout;   /**< bytes after compression            */
+    long cmprratio; /**< compressed size % of original      */
+    long cmprusec;  /**< CPU time compressing, microsec     */
+    long dcmprusec; /**< CPU time decompressing, microsec   */
+    
+    /* Flow control: */
+    long crwindow;  /**< credits granted to peer, 0 - off   */
+    long crpeer;    /**< credits granted by peer, 0 - off   */
+    long cravail;   /**< credits available for sending     */
+    long crwaits;   /**< calls waited for credit            */
+    long crrejects; /**< calls rejected with no credit      */
     
 } ndrx_adm_brcon_t;
 
@@ -98,6 +112,17 @@ expublic ndrx_adm_elmap_t ndrx_G_brcon_map[] =
     ,{TA_EX_TIMEDIFF,          TPADM_EL(ndrx_adm_brcon_t, timediff)}
     ,{TA_EX_TIMEDIFFF,         TPADM_EL(ndrx_adm_brcon_t, timediffms)}
     ,{TA_EX_ROUNDTRIP,         TPADM_EL(ndrx_adm_brcon_t, roundtrip)}
+    ,{TA_EX_CMPR,              TPADM_EL(ndrx_adm_brcon_t, cmpr)}
+    ,{TA_EX_CMPRIN,            TPADM_EL(ndrx_adm_brcon_t, cmprin)}
+    ,{TA_EX_CMPROUT,           TPADM_EL(ndrx_adm_brcon_t, cmprout)}
+    ,{TA_EX_CMPRRATIO,         TPADM_EL(ndrx_adm_brcon_t, cmprratio)}
+    ,{TA_EX_CMPRUSEC,          TPADM_EL(ndrx_adm_brcon_t, cmprusec)}
+    ,{TA_EX_DCMPRUSEC,         TPADM_EL(ndrx_adm_brcon_t, dcmprusec)}
+    ,{TA_EX_CRWINDOW,          TPADM_EL(ndrx_adm_brcon_t, crwindow)}
+    ,{TA_EX_CRPEER,            TPADM_EL(ndrx_adm_brcon_t, crpeer)}
+    ,{TA_EX_CRAVAIL,           TPADM_EL(ndrx_adm_brcon_t, cravail)}
+    ,{TA_EX_CRWAITS,           TPADM_EL(ndrx_adm_brcon_t, crwaits)}
+    ,{TA_EX_CRREJECTS,         TPADM_EL(ndrx_adm_brcon_t, crrejects)}
     ,{BBADFLDID}
 };
 
@@ -141,6 +166,19 @@ exprivate int ndrx_adm_brconinfo_proc_list(command_reply_t *reply, size_t reply_
     brcon.timediffms = info->timediffms;
     brcon.roundtrip = info->roundtrip;
     
+    brcon.cmpr = info->cmpr;
+    brcon.cmprin = info->cmprin;
+    brcon.cmprout = info->cmprout;
+    brcon.cmprratio = info->cmprin > 0?(info->cmprout*100/info->cmprin):100;
+    brcon.cmprusec = info->cmprusec;
+    brcon.dcmprusec = info->dcmprusec;
+    
+    brcon.crwindow = info->crwindow;
+    brcon.crpeer = info->crpeer;
+    brcon.cravail = info->cravail;
+    brcon.crwaits = info->crwaits;
+    brcon.crrejects = info->crrejects;
+    
     brcon.time = info->time;
        
     if (EXSUCCEED!=ndrx_growlist_add(&M_cursnew->list, (void *)&brcon, M_idx))
@@ -52,8 +52,10 @@
 
 #include <atmi_cache.h>
 #include "tpcached.h"
+#include "utlist.h"
 /*---------------------------Externs------------------------------------*/
 /*---------------------------Macros-------------------------------------*/    
+#define IDX_BATCH           1000    /* index entries popped per transaction */
 /*---------------------------Enums--------------------------------------*/
 /*---------------------------Typedefs-----------------------------------*/
 /*---------------------------Globals------------------------------------*/
@@ -688,6 +690,294 @@ out:
     return ret;
 }
 
+/**
+ * Pop batch of oldest/lowest index entries of given type in single RW
+ * transaction. Records for which popped entry is current are invalidated
+ * (with broadcast), stale entries (e.g. of older duplicates) are just removed.
+ * @param db cache db with index
+ * @param type index entry type
+ * @param maxv1 pop only entries with primary value less than this, -1 any
+ * @param max max number of entries to pop
+ * @param popped number of entries popped (out)
+ * @return EXSUCCEED/EXFAIL
+ */
+exprivate int proc_idx_pop(ndrx_tpcache_db_t *db, char type, long maxv1, 
+        long max, long *popped)
+{
+    int ret = EXSUCCEED;
+    EDB_txn *txn = NULL;
+    int tran_started = EXFALSE;
+    int cursor_open = EXFALSE;
+    EDB_cursor *cursor;
+    EDB_cursor_op op;
+    EDB_val ikey, ival, val;
+    ndrx_tpcached_msglist_t * pop_list = NULL;
+    ndrx_tpcached_msglist_t * el, *elt;
+    short nodeid = (short)tpgetnodeid();
+    long v1, v2;
+    long deleted = 0;
+    int align = 0;
+    int is_current;
+    int err;
+    char *key;
+    
+    *popped = 0;
+    
+    if (EXSUCCEED!=ndrx_cache_edb_begin(db, &txn, 0))
+    {
+        NDRX_LOG(log_error, "Failed start transaction: %s", 
+                tpstrerror(tperrno));
+        EXFAIL_OUT(ret);
+    }
+    tran_started = EXTRUE;
+    
+    if (EXSUCCEED!=(err=edb_cursor_open(txn, db->idxdbi, &cursor)))
+    {
+        NDRX_LOG(log_error, "Failed to open index cursor of [%s]: %s", 
+                db->cachedb, edb_strerror(err));
+        EXFAIL_OUT(ret);
+    }
+    cursor_open = EXTRUE;
+    
+    /* entries of the type are sorted by value */
+    ikey.mv_data = &type;
+    ikey.mv_size = 1;
+    op = EDB_SET_RANGE;
+    
+    while (*popped < max && 
+            EXSUCCEED==(err=edb_cursor_get(cursor, &ikey, &ival, op)))
+    {
+        op = EDB_NEXT;
+        
+        if (type!=ndrx_cache_idx_parse(&ikey, &v1, &v2) ||
+                (maxv1 >= 0 && v1 >= maxv1))
+        {
+            break;
+        }
+        
+        if (EXSUCCEED!=ndrx_tpcached_add_msg(&pop_list, &ikey, &ival))
+        {
+            NDRX_LOG(log_error, "Failed to add index entry to pop list!");
+            EXFAIL_OUT(ret);
+        }
+        
+        (*popped)++;
+    }
+    
+    if (EXSUCCEED!=err && EDB_NOTFOUND!=err)
+    {
+        NDRX_LOG(log_error, "Failed to loop over index of [%s]: %s", 
+                db->cachedb, edb_strerror(err));
+        EXFAIL_OUT(ret);
+    }
+    
+    cursor_open = EXFALSE;
+    edb_cursor_close(cursor);
+    
+    LL_FOREACH_SAFE(pop_list, el, elt)
+    {
+        key = (char *)el->val.mv_data;
+        
+        if (EXSUCCEED!=(err=edb_del(txn, db->idxdbi, &el->keydb, NULL)) &&
+                EDB_NOTFOUND!=err)
+        {
+            NDRX_LOG(log_error, "Failed to delete index entry of [%s]: %s", 
+                db->cachedb, edb_strerror(err));
+            EXFAIL_OUT(ret);
+        }
+        
+        is_current = EXFALSE;
+        
+        if (0==el->val.mv_size || EXEOS!=key[el->val.mv_size-1])
+        {
+            NDRX_LOG(log_error, "Invalid key in index of [%s] - dropped", 
+                    db->cachedb);
+        }
+        else if (EXSUCCEED==(err=ndrx_cache_edb_get(db, txn, key, &val, 
+                EXFALSE, &align)))
+        {
+            /* for timesync dbs this is the newest record */
+            is_current = ndrx_cache_idx_match(db, &el->keydb, key, &val);
+            
+            if (align)
+            {
+                NDRX_FREE(val.mv_data);
+            }
+        }
+        else if (EDB_NOTFOUND!=err)
+        {
+            NDRX_LOG(log_error, "Failed to get record [%s] of [%s]", 
+                    key, db->cachedb);
+            EXFAIL_OUT(ret);
+        }
+        
+        if (is_current)
+        {
+            NDRX_LOG(log_info, "About to delete: key=[%s]", key);
+            
+            if (EXSUCCEED!=ndrx_cache_inval_by_key(db->cachedb, db, 
+                    key, nodeid, txn, EXTRUE))
+            {
+                NDRX_LOG(log_debug, "Failed to delete record by key [%s]", 
+                        key);
+                EXFAIL_OUT(ret);
+            }
+            deleted++;
+        }
+        else
+        {
+            NDRX_LOG(log_debug, "Stale index entry for key [%s] - dropped", key);
+        }
+    }
+    
+    NDRX_LOG(log_info, "[%s] popped %ld index entries, deleted %ld records",
+            db->cachedb, *popped, deleted);
+    
+out:
+
+    if (cursor_open)
+    {
+        edb_cursor_close(cursor);
+    }
+
+    if (tran_started)
+    {
+        if (EXSUCCEED==ret)
+        {
+            if (EXSUCCEED!=ndrx_cache_edb_commit(db, txn))
+            {
+                NDRX_LOG(log_error, "%s: Failed to commit: %s", 
+                    __func__, tpstrerror(tperrno));
+                ndrx_cache_edb_abort(db, txn);
+                ret=EXFAIL;
+            }
+        }
+        else
+        {
+            ndrx_cache_edb_abort(db, txn);
+        }
+    }
+
+    if (NULL!=pop_list)
+    {
+        ndrx_tpcached_free_list(&pop_list);
+    }
+
+    return ret;
+}
+
+/**
+ * Process expiry of indexed db: pop put time entries older than expiry
+ * in bounded transactions.
+ * @param db cache db with index
+ * @return EXSUCCEED/EXFAIL
+ */
+exprivate int proc_db_expiry_idx(ndrx_tpcache_db_t *db)
+{
+    int ret = EXSUCCEED;
+    long t;
+    long tusec;
+    long popped;
+    
+    NDRX_LOG(log_debug, "%s enter dbname=[%s]", __func__, db->cachedb);
+    
+    ndrx_utc_tstamp2(&t, &tusec);
+    
+    do
+    {
+        if (EXSUCCEED!=proc_idx_pop(db, NDRX_TPCACHE_IDX_PUT, t - db->expiry, 
+                IDX_BATCH, &popped))
+        {
+            EXFAIL_OUT(ret);
+        }
+        
+    } while (IDX_BATCH==popped);
+    
+out:
+    return ret;
+}
+
+/**
+ * Process limit of indexed db: pop least recently used/least hit/oldest
+ * entries while db is over the limit, in bounded transactions.
+ * @param db cache db with index
+ * @return EXSUCCEED/EXFAIL
+ */
+exprivate int proc_db_limit_idx(ndrx_tpcache_db_t *db)
+{
+    int ret = EXSUCCEED;
+    EDB_stat stat;
+    EDB_txn *txn = NULL;
+    long excess;
+    long popped;
+    char type;
+    
+    NDRX_LOG(log_debug, "%s enter dbname=[%s]", __func__, db->cachedb);
+    
+    if (db->flags & NDRX_TPCACHE_FLAGS_LRU)
+    {
+        type = NDRX_TPCACHE_IDX_LRU;
+    }
+    else if (db->flags & NDRX_TPCACHE_FLAGS_HITS)
+    {
+        type = NDRX_TPCACHE_IDX_HITS;
+    }
+    else
+    {
+        type = NDRX_TPCACHE_IDX_PUT;
+    }
+    
+    while (1)
+    {
+        if (EXSUCCEED!=ndrx_cache_edb_begin(db, &txn, EDB_RDONLY))
+        {
+            NDRX_LOG(log_error, "Failed start transaction: %s", 
+                    tpstrerror(tperrno));
+            EXFAIL_OUT(ret);
+        }
+        
+        if (EXSUCCEED!=ndrx_cache_edb_stat (db, txn, &stat))
+        {
+            NDRX_LOG(log_error, "Failed to get db statistics: %s", 
+                    tpstrerror(tperrno));
+            ndrx_cache_edb_abort(db, txn);
+            EXFAIL_OUT(ret);
+        }
+        
+        ndrx_cache_edb_abort(db, txn);
+        
+        NDRX_LOG(log_debug, "number of keys in db: %ld, limit: %ld", 
+                (long)stat.ms_entries, db->limit);
+        
+        if (stat.ms_entries <= db->limit)
+        {
+            break;
+        }
+        
+        excess = (long)stat.ms_entries - db->limit;
+        
+        if (excess > IDX_BATCH)
+        {
+            excess = IDX_BATCH;
+        }
+        
+        if (EXSUCCEED!=proc_idx_pop(db, type, -1, excess, &popped))
+        {
+            EXFAIL_OUT(ret);
+        }
+        
+        if (0==popped)
+        {
+            NDRX_LOG(log_warn, "[%s] is over the limit, but index is empty",
+                    db->cachedb);
+            break;
+        }
+    }
+    
+out:
+    return ret;
+}
+
 /**
  * Scan for duplicates and remove them. This could be useful for services
  * for which there are lot of caching, but less later accessing. Thus have
@@ -977,8 +1267,22 @@ expublic int main(int argc, char** argv)
 
         EXHASH_ITER(hh, dbh, el, elt)
         {
-            /* process db */
-            if ( (el->flags & NDRX_TPCACHE_FLAGS_EXPIRY)
+            /* process db, indexed expiry pops only expired records,
+             * unadvertised services still needs full scan
+             */
+            if ( (el->flags & NDRX_TPCACHE_FLAGS_INDEX) &&
+                    (el->flags & NDRX_TPCACHE_FLAGS_EXPIRY))
+            {
+                if (EXSUCCEED!=proc_db_expiry_idx(el))
+                {
+                   NDRX_LOG(log_error, "Failed to process expiry cache: [%s]", 
+                           el->cachedb);
+                   EXFAIL_OUT(ret);
+                }
+            }
+            
+            if ( (!(el->flags & NDRX_TPCACHE_FLAGS_INDEX) &&
+                        (el->flags & NDRX_TPCACHE_FLAGS_EXPIRY))
                     ||
                     (el->flags & NDRX_TPCACHE_FLAGS_CLRNOSVC))
             {
@@ -997,7 +1301,8 @@ expublic int main(int argc, char** argv)
                     el->flags & NDRX_TPCACHE_FLAGS_FIFO
                  ) 
             {
-                if (EXSUCCEED!=proc_db_limit(el))
+                if (EXSUCCEED!=((el->flags & NDRX_TPCACHE_FLAGS_INDEX) ?
+                        proc_db_limit_idx(el) : proc_db_limit(el)))
                 {
                    NDRX_LOG(log_error, "Failed to process limit cache: [%s]", 
                            el->cachedb);
@@ -268,6 +268,169 @@ Ensure(test_Baddfast2)
     
 }
 
+/**
+ * Apply the same change list to the sequential API and to the bulk builder,
+ * result buffers shall have the same layout as append-built buffer
+ * @param p_ub target buffer for sequential API
+ * @param bld builder
+ */
+exprivate void bld_ops(UBFH *p_ub, Bbld_t *bld)
+{
+    short s = 44;
+    long l = 1000001;
+    char c = 'A';
+    float f = 1.5;
+    double d = 9999.25;
+    char carr[] = {0, 1, 2, 3, 4, 5, 6};
+    char str[32];
+    int i;
+    
+    /* fields in reverse type order, with gaps & overwrites */
+    assert_equal(Bchg(p_ub, T_CARRAY_FLD, 2, carr, sizeof(carr)), EXSUCCEED);
+    assert_equal(Bbldchg(bld, T_CARRAY_FLD, 2, carr, sizeof(carr)), EXSUCCEED);
+    
+    assert_equal(Badd(p_ub, T_STRING_2_FLD, "HELLO", 0), EXSUCCEED);
+    assert_equal(Bbldadd(bld, T_STRING_2_FLD, "HELLO", 0), EXSUCCEED);
+    
+    assert_equal(Badd(p_ub, T_DOUBLE_FLD, (char *)&d, 0), EXSUCCEED);
+    assert_equal(Bbldadd(bld, T_DOUBLE_FLD, (char *)&d, 0), EXSUCCEED);
+    
+    assert_equal(Bchg(p_ub, T_STRING_FLD, 3, "THREE", 0), EXSUCCEED);
+    assert_equal(Bbldchg(bld, T_STRING_FLD, 3, "THREE", 0), EXSUCCEED);
+    
+    assert_equal(Badd(p_ub, T_SHORT_FLD, (char *)&s, 0), EXSUCCEED);
+    assert_equal(Bbldadd(bld, T_SHORT_FLD, (char *)&s, 0), EXSUCCEED);
+    
+    assert_equal(Badd(p_ub, T_CARRAY_FLD, carr, 3), EXSUCCEED);
+    assert_equal(Bbldadd(bld, T_CARRAY_FLD, carr, 3), EXSUCCEED);
+    
+    assert_equal(Bchg(p_ub, T_FLOAT_FLD, 1, (char *)&f, 0), EXSUCCEED);
+    assert_equal(Bbldchg(bld, T_FLOAT_FLD, 1, (char *)&f, 0), EXSUCCEED);
+    
+    assert_equal(Bchg(p_ub, T_CHAR_FLD, 0, &c, 0), EXSUCCEED);
+    assert_equal(Bbldchg(bld, T_CHAR_FLD, 0, &c, 0), EXSUCCEED);
+    
+    assert_equal(Bchg(p_ub, T_LONG_FLD, 4, (char *)&l, 0), EXSUCCEED);
+    assert_equal(Bbldchg(bld, T_LONG_FLD, 4, (char *)&l, 0), EXSUCCEED);
+    
+    /* overwrite with longer & shorter values */
+    assert_equal(Bchg(p_ub, T_STRING_FLD, 1, "A LONGER VALUE", 0), EXSUCCEED);
+    assert_equal(Bbldchg(bld, T_STRING_FLD, 1, "A LONGER VALUE", 0), EXSUCCEED);
+    
+    assert_equal(Bchg(p_ub, T_STRING_FLD, 3, "3", 0), EXSUCCEED);
+    assert_equal(Bbldchg(bld, T_STRING_FLD, 3, "3", 0), EXSUCCEED);
+    
+    assert_equal(Bchg(p_ub, T_CARRAY_FLD, 0, carr, 0), EXSUCCEED);
+    assert_equal(Bbldchg(bld, T_CARRAY_FLD, 0, carr, 0), EXSUCCEED);
+    
+    c = 'B';
+    assert_equal(Bchg(p_ub, T_CHAR_FLD, 0, &c, 0), EXSUCCEED);
+    assert_equal(Bbldchg(bld, T_CHAR_FLD, 0, &c, 0), EXSUCCEED);
+    
+    for (i=0; i<50; i++)
+    {
+        snprintf(str, sizeof(str), "%d", i*37);
+        
+        assert_equal(Badd(p_ub, T_STRING_FLD, str, 0), EXSUCCEED);
+        assert_equal(Bbldadd(bld, T_STRING_FLD, str, 0), EXSUCCEED);
+        
+        l = i;
+        assert_equal(Bchg(p_ub, T_LONG_2_FLD, i, (char *)&l, 0), EXSUCCEED);
+        assert_equal(Bbldchg(bld, T_LONG_2_FLD, i, (char *)&l, 0), EXSUCCEED);
+    }
+}
+
+/**
+ * Bulk builder shall produce the same buffer as sequential API
+ */
+Ensure(test_Bbld)
+{
+    char buf1[56000];
+    UBFH *p_ub1 = (UBFH *)buf1;
+    char buf2[56000];
+    UBFH *p_ub2 = (UBFH *)buf2;
+    char buf3[56000];
+    UBFH *p_ub3 = (UBFH *)buf3;
+    UBFH *p_ub4;
+    Bbld_t *bld;
+    long sz;
+    long off1, off2;
+    short s = 1;
+    BFLDID fldid;
+    BFLDOCC occ;
+    BFLDLEN len;
+    char *p;
+    
+    memset(buf1, 0, sizeof(buf1));
+    memset(buf2, 0, sizeof(buf2));
+    memset(buf3, 0, sizeof(buf3));
+    
+    assert_equal(Binit(p_ub1, sizeof(buf1)), EXSUCCEED);
+    assert_equal(Binit(p_ub2, sizeof(buf2)), EXSUCCEED);
+    assert_equal(Binit(p_ub3, sizeof(buf3)), EXSUCCEED);
+    
+    /* small initial sizes, to test the growing */
+    bld = Bbldnew(2, 8);
+    assert_not_equal(bld, NULL);
+    
+    bld_ops(p_ub1, bld);
+    assert_equal(Bbldfinal(bld, p_ub2), EXSUCCEED);
+    
+    /* sequential changes leave the old data in the alignment padding,
+     * thus compare the layout (field offsets) and the values
+     */
+    assert_equal(Bused(p_ub1), Bused(p_ub2));
+    assert_equal(Bcmp(p_ub1, p_ub2), 0);
+    
+    fldid = BFIRSTFLDID;
+    while (1==Bnext(p_ub1, &fldid, &occ, NULL, NULL))
+    {
+        off1 = (long)(Bfind(p_ub1, fldid, occ, &len) - buf1);
+        off2 = (long)(Bfind(p_ub2, fldid, occ, &len) - buf2);
+        assert_equal(off1, off2);
+        
+        /* fresh buffer built by appends */
+        p = Bfind(p_ub1, fldid, occ, &len);
+        assert_equal(Badd(p_ub3, fldid, p, len), EXSUCCEED);
+    }
+    
+    assert_equal(memcmp(buf2, buf3, sizeof(buf2)), 0);
+    
+    /* buffer is not empty */
+    assert_equal(Bbldfinal(bld, p_ub2), EXFAIL);
+    assert_equal(Berror, BEINVAL);
+    
+    /* exact size */
+    sz = Bbldsize(bld);
+    p_ub4 = malloc(sz);
+    assert_not_equal(p_ub4, NULL);
+    
+    assert_equal(Binit(p_ub4, sz-1), EXSUCCEED);
+    assert_equal(Bbldfinal(bld, p_ub4), EXFAIL);
+    assert_equal(Berror, BNOSPACE);
+    
+    assert_equal(Binit(p_ub4, sz), EXSUCCEED);
+    assert_equal(Bbldfinal(bld, p_ub4), EXSUCCEED);
+    assert_equal(Bunused(p_ub4), 0);
+    assert_equal(Bcmp(p_ub1, p_ub4), 0);
+    free(p_ub4);
+    
+    /* delete is not supported & invalid fields */
+    assert_equal(Bbldchg(bld, T_SHORT_FLD, 0, NULL, 0), EXFAIL);
+    assert_equal(Berror, BEINVAL);
+    assert_equal(Bbldadd(bld, BBADFLDID, (char *)&s, 0), EXFAIL);
+    assert_equal(Berror, BBADFLD);
+    
+    /* reset & reuse */
+    Bbldreset(bld);
+    memset(buf2, 0, sizeof(buf2));
+    assert_equal(Binit(p_ub2, sizeof(buf2)), EXSUCCEED);
+    assert_equal(Bbldfinal(bld, p_ub2), EXSUCCEED);
+    assert_equal(Bnum(p_ub2), 0);
+    
+    Bbldfree(bld);
+}
+
 /**
  * Common suite entry
  * @return
@@ -282,6 +445,7 @@ TestSuite *ubf_Badd_tests(void)
     add_test(suite, test_Badd_str);
     add_test(suite, test_Baddfast1);
     add_test(suite, test_Baddfast2);
+    add_test(suite, test_Bbld);
 
     return suite;
 }
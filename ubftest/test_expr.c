@@ -43,6 +43,7 @@
 #include "test.fd.h"
 #include "ubfunit1.h"
 #include <ndebug.h>
+#include <ubf_int.h>
 
 
 void delete_fb_test_data(UBFH *p_ub)
@@ -1747,6 +1748,149 @@ Ensure(test_expr_longstr)
     
 }
 
+/**
+ * Callback which changes the buffer, string fields must not be taken
+ * in place by compiled expression.
+ */
+long callback_chg_buf(UBFH *p_ub, char *funcname)
+{
+    assert_equal(Bchg(p_ub, T_STRING_FLD, 0, "CHANGED AND LONGER VALUE", 0L), 
+            EXSUCCEED);
+    
+    return 1;
+}
+
+/**
+ * Test compiled expression evaluation (constant folding, field
+ * type resolution, short circuits and too deep trees)
+ */
+Ensure(test_expr_compiled)
+{
+    char buf[2048];
+    char expr[1024];
+    UBFH *p_ub = (UBFH *)buf;
+    char *tree = NULL;
+    long l = 5;
+    int i;
+    
+    assert_equal(Binit(p_ub, sizeof(buf)), EXSUCCEED);
+    load_field_table();
+    assert_equal(Bchg(p_ub, T_STRING_FLD, 0, "ABC", 0L), EXSUCCEED);
+    assert_equal(Bchg(p_ub, T_LONG_FLD, 0, (char *)&l, 0L), EXSUCCEED);
+    assert_equal(Bboolsetcbf ("callback_chg_buf", callback_chg_buf), EXSUCCEED);
+    
+    /* folded constants */
+    tree=Bboolco ("2+2*4==10 && 'abc' %% '.bc' && !(1.5 > 2)");
+    assert_not_equal(tree, NULL);
+    assert_equal(Bboolev(p_ub, tree), EXTRUE);
+    Btreefree(tree);
+    
+    /* field compares, string in place */
+    tree=Bboolco ("T_STRING_FLD=='ABC' && T_LONG_FLD+1==6 && T_LONG_FLD*1.5==7.5");
+    assert_not_equal(tree, NULL);
+    assert_equal(Bboolev(p_ub, tree), EXTRUE);
+    Btreefree(tree);
+    
+    /* missing fields are not equal */
+    tree=Bboolco ("T_STRING_2_FLD=='ABC' || T_LONG_2_FLD==0");
+    assert_not_equal(tree, NULL);
+    assert_equal(Bboolev(p_ub, tree), EXFALSE);
+    Btreefree(tree);
+    
+    tree=Bboolco ("T_STRING_2_FLD!='ABC' && T_STRING_FLD ^ T_LONG_2_FLD");
+    assert_not_equal(tree, NULL);
+    assert_equal(Bboolev(p_ub, tree), EXTRUE);
+    Btreefree(tree);
+    
+    /* buffer is changed by callback before the compare */
+    tree=Bboolco ("T_STRING_FLD=='ABC' && callback_chg_buf() && "
+            "T_STRING_FLD=='CHANGED AND LONGER VALUE'");
+    assert_not_equal(tree, NULL);
+    assert_equal(Bboolev(p_ub, tree), EXTRUE);
+    Btreefree(tree);
+    
+    /* deeper than value stack, evaluated by tree */
+    expr[0]=EXEOS;
+    for (i=0; i<100; i++)
+    {
+        strcat(expr, "1+(");
+    }
+    strcat(expr, "T_LONG_FLD");
+    for (i=0; i<100; i++)
+    {
+        strcat(expr, ")");
+    }
+    strcat(expr, "==105");
+    
+    tree=Bboolco (expr);
+    assert_not_equal(tree, NULL);
+    assert_equal(Bboolev(p_ub, tree), EXTRUE);
+    assert_equal(Bfloatev(p_ub, tree), 1.0);
+    Btreefree(tree);
+    
+    assert_equal(Bboolsetcbf ("callback_chg_buf", NULL), EXSUCCEED);
+}
+
+/**
+ * Test compiled expression cache
+ */
+Ensure(test_expr_cache)
+{
+    char buf[2048];
+    char expr[64];
+    UBFH *p_ub = (UBFH *)buf;
+    ndrx_ubf_exprc_t *ent, *ent2, *first;
+    long hits, misses, evictions, hits2, misses2, evictions2;
+    int entries;
+    long l = 5;
+    int i;
+    
+    assert_equal(Binit(p_ub, sizeof(buf)), EXSUCCEED);
+    load_field_table();
+    assert_equal(Bchg(p_ub, T_LONG_FLD, 0, (char *)&l, 0L), EXSUCCEED);
+    
+    ndrx_ubf_exprc_stats(&hits, &misses, &evictions, &entries);
+    
+    /* compiled once, then served from cache */
+    first=ndrx_ubf_exprc_get(NDRX_UBFEXPRC_UBF, "T_LONG_FLD==5");
+    assert_not_equal(first, NULL);
+    ent=ndrx_ubf_exprc_get(NDRX_UBFEXPRC_UBF, "T_LONG_FLD==5");
+    assert_equal(ent, first);
+    assert_equal(Bboolev(p_ub, ent->tree), EXTRUE);
+    ndrx_ubf_exprc_release(ent);
+    
+    /* the same text as regex is different entry */
+    ent=ndrx_ubf_exprc_get(NDRX_UBFEXPRC_REGEX, "T_LONG_FLD==5");
+    assert_not_equal(ent, NULL);
+    assert_not_equal(ent, first);
+    assert_equal(regexec(&ent->re, "T_LONG_FLD==5", 0, NULL, 0), 0);
+    ndrx_ubf_exprc_release(ent);
+    
+    /* compile errors are not cached */
+    assert_equal(ndrx_ubf_exprc_get(NDRX_UBFEXPRC_UBF, "T_LONG_FLD=="), NULL);
+    assert_equal(ndrx_ubf_exprc_get(NDRX_UBFEXPRC_REGEX, "(abc"), NULL);
+    
+    ndrx_ubf_exprc_stats(&hits2, &misses2, &evictions2, &entries);
+    assert_equal(hits2-hits, 1);
+    assert_equal(misses2-misses, 4);
+    
+    /* fill the cache, first entry is evicted while still in use */
+    for (i=0; i<NDRX_UBFEXPRC_DFLT; i++)
+    {
+        snprintf(expr, sizeof(expr), "T_LONG_FLD==%d", i+100);
+        ent2=ndrx_ubf_exprc_get(NDRX_UBFEXPRC_UBF, expr);
+        assert_not_equal(ent2, NULL);
+        ndrx_ubf_exprc_release(ent2);
+    }
+    
+    ndrx_ubf_exprc_stats(&hits2, &misses2, &evictions2, &entries);
+    assert_equal(entries, NDRX_UBFEXPRC_DFLT);
+    assert_equal(evictions2-evictions >= 2, EXTRUE);
+    
+    assert_equal(Bboolev(p_ub, first->tree), EXTRUE);
+    ndrx_ubf_exprc_release(first);
+}
+
 TestSuite *ubf_expr_tests(void)
 {
     TestSuite *suite = create_test_suite();
@@ -1776,6 +1920,9 @@ TestSuite *ubf_expr_tests(void)
     
     /* Support #633 */
     add_test(suite, test_expr_longstr);
+    
+    add_test(suite, test_expr_compiled);
+    add_test(suite, test_expr_cache);
         
     return suite;
 }
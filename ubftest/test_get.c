@@ -531,6 +531,162 @@ Ensure(test_cached_flds)
         
 }
 
+/**
+ * Batch read of the fields
+ */
+Ensure(test_bgetmulti)
+{
+    char fb[2048];
+    UBFH *p_ub = (UBFH *)fb;
+    short s;
+    long l1, l2;
+    char c;
+    double d;
+    char str1[64];
+    char str2[64];
+    char str3[64];
+    char carr[4];
+    char lstr[32];
+    char tmp[64];
+    BFLDLEN len;
+    Bfld_multi_t items[] = {
+        {T_SHORT_FLD,   0, EXFAIL,      (char *)&s,  0, 0},
+        {T_LONG_FLD,    1, BFLD_STRING, lstr,        sizeof(lstr), 0},
+        {T_LONG_FLD,    2, EXFAIL,      (char *)&l1, 0, 0},
+        {T_LONG_FLD,    4, EXFAIL,      (char *)&l2, 0, 0},
+        {T_LONG_FLD,    7, EXFAIL,      (char *)&l2, 0, 0},
+        {T_CHAR_FLD,    1, EXFAIL,      &c,          0, 0},
+        {T_DOUBLE_2_FLD,0, EXFAIL,      (char *)&d,  0, 0},
+        {T_STRING_FLD,  0, EXFAIL,      str1,        sizeof(str1), 0},
+        {T_STRING_FLD,  1, EXFAIL,      str2,        sizeof(str2), 0},
+        {T_STRING_FLD,  5, EXFAIL,      str2,        sizeof(str2), 0},
+        {T_STRING_2_FLD,0, EXFAIL,      str3,        sizeof(str3), 0},
+        {T_CARRAY_FLD,  0, EXFAIL,      carr,        sizeof(carr), 0}
+    };
+
+    assert_equal(Binit(p_ub, sizeof(fb)), EXSUCCEED);
+    load_get_test_data(p_ub);
+    
+    assert_equal(Bgetmulti(p_ub, items, N_DIM(items)), 9);
+    
+    assert_equal(items[0].err, 0);
+    assert_equal(s, 88);
+    /* len 0 - not checked, data len returned */
+    assert_equal(items[0].len, sizeof(short));
+    
+    assert_equal(items[1].err, 0);
+    assert_string_equal(lstr, "-1021");
+    
+    /* filled by Bchg() to occ 4 */
+    assert_equal(items[2].err, 0);
+    assert_equal(l1, 0);
+    assert_equal(items[3].err, 0);
+    assert_equal(l2, 888);
+    
+    assert_equal(items[4].err, BNOTPRES);
+    
+    assert_equal(items[5].err, 0);
+    assert_equal(c, '.');
+    
+    assert_equal(items[6].err, 0);
+    assert_double_equal(d, 1231232.1);
+    assert_equal(items[6].len, sizeof(double));
+    
+    assert_equal(items[7].err, 0);
+    assert_string_equal(str1, "TEST STR VAL");
+    assert_equal(items[7].len, strlen(str1)+1);
+    
+    assert_equal(items[8].err, 0);
+    assert_string_equal(str2, "TEST STRING ARRAY2");
+    
+    assert_equal(items[9].err, BNOTPRES);
+    
+    assert_equal(items[10].err, 0);
+    len = sizeof(tmp);
+    assert_equal(Bget(p_ub, T_STRING_2_FLD, 0, tmp, &len), EXSUCCEED);
+    assert_string_equal(str3, tmp);
+    
+    /* output buffer too short */
+    assert_equal(items[11].err, BNOSPACE);
+    
+    /* must be sorted */
+    items[1].bfldid = T_STRING_FLD;
+    assert_equal(Bgetmulti(p_ub, items, N_DIM(items)), EXFAIL);
+    assert_equal(Berror, BEINVAL);
+    assert_equal(items[2].err, BEINVAL);
+}
+
+/**
+ * Batch change of the fields shall give the same result as Bchg()
+ */
+Ensure(test_bchgmulti)
+{
+    char fb1[2048];
+    UBFH *p_ub1 = (UBFH *)fb1;
+    char fb2[2048];
+    UBFH *p_ub2 = (UBFH *)fb2;
+    char fb3[2048];
+    short s1 = 1;
+    short s3 = 3;
+    long l = 777;
+    char carr[] = {9, 8, 7};
+    Bfld_multi_t items[] = {
+        {T_SHORT_FLD,   1, EXFAIL,      (char *)&s1, 0, 0},
+        {T_SHORT_FLD,   3, EXFAIL,      (char *)&s3, 0, 0},
+        {T_LONG_FLD,    0, BFLD_STRING, "777",       0, 0},
+        {T_STRING_FLD,  0, EXFAIL,      "A MUCH LONGER STRING VALUE THAN BEFORE", 0, 0},
+        {T_STRING_FLD,  1, EXFAIL,      "S",         0, 0},
+        {T_STRING_3_FLD,0, EXFAIL,      "NEW",       0, 0},
+        {T_CARRAY_2_FLD,2, EXFAIL,      carr,        sizeof(carr), 0}
+    };
+    
+    assert_equal(Binit(p_ub1, sizeof(fb1)), EXSUCCEED);
+    assert_equal(Binit(p_ub2, sizeof(fb2)), EXSUCCEED);
+    load_get_test_data(p_ub1);
+    load_get_test_data(p_ub2);
+    
+    assert_equal(Bchg(p_ub1, T_SHORT_FLD, 1, (char *)&s1, 0), EXSUCCEED);
+    assert_equal(Bchg(p_ub1, T_SHORT_FLD, 3, (char *)&s3, 0), EXSUCCEED);
+    assert_equal(Bchg(p_ub1, T_LONG_FLD, 0, (char *)&l, 0), EXSUCCEED);
+    assert_equal(Bchg(p_ub1, T_STRING_FLD, 0, 
+            "A MUCH LONGER STRING VALUE THAN BEFORE", 0), EXSUCCEED);
+    assert_equal(Bchg(p_ub1, T_STRING_FLD, 1, "S", 0), EXSUCCEED);
+    assert_equal(Bchg(p_ub1, T_STRING_3_FLD, 0, "NEW", 0), EXSUCCEED);
+    assert_equal(Bchg(p_ub1, T_CARRAY_2_FLD, 2, carr, sizeof(carr)), EXSUCCEED);
+    
+    assert_equal(Bchgmulti(p_ub2, items, N_DIM(items)), EXSUCCEED);
+    
+    assert_equal(Bused(p_ub1), Bused(p_ub2));
+    assert_equal(Bcmp(p_ub1, p_ub2), 0);
+    assert_equal(Boccur(p_ub2, T_SHORT_FLD), 4);
+    
+    /* no space, buffer is not changed */
+    assert_equal(Binit(p_ub2, Bused(p_ub1)+8), EXSUCCEED);
+    assert_equal(Bconcat(p_ub2, p_ub1), EXSUCCEED);
+    
+    assert_equal(Bchgmulti(p_ub2, items, N_DIM(items)), EXSUCCEED);
+    assert_equal(Bcmp(p_ub1, p_ub2), 0);
+    memcpy(fb3, fb2, sizeof(fb3));
+    
+    items[3].buf = "A MUCH LONGER STRING VALUE THAN BEFORE, EVEN LONGER";
+    assert_equal(Bchgmulti(p_ub2, items, N_DIM(items)), EXFAIL);
+    assert_equal(Berror, BNOSPACE);
+    assert_equal(memcmp(fb2, fb3, Bused(p_ub2)), 0);
+    
+    /* must be sorted */
+    items[0].occ = 5;
+    assert_equal(Bchgmulti(p_ub2, items, N_DIM(items)), EXFAIL);
+    assert_equal(Berror, BEINVAL);
+    assert_equal(items[1].err, BEINVAL);
+    
+    /* no delete */
+    items[0].occ = 1;
+    items[1].buf = NULL;
+    assert_equal(Bchgmulti(p_ub2, items, N_DIM(items)), EXFAIL);
+    assert_equal(Berror, BEINVAL);
+    assert_equal(memcmp(fb2, fb3, Bused(p_ub2)), 0);
+}
+
 TestSuite *ubf_get_tests(void)
 {
     TestSuite *suite = create_test_suite();
@@ -540,6 +696,8 @@ TestSuite *ubf_get_tests(void)
     add_test(suite, test_bgetlast);
     
     add_test(suite, test_cached_flds);
+    add_test(suite, test_bgetmulti);
+    add_test(suite, test_bchgmulti);
 
     return suite;
 }
@@ -0,0 +1,172 @@
+/**
+ * @brief Common-config snapshot tests
+ *
+ * @file test_nstd_ccsnap.c
+ */
+/* -----------------------------------------------------------------------------
+ * Enduro/X Middleware Platform for Distributed Transaction Processing
+ * Copyright (C) 2009-2016, ATR Baltic, Ltd. All Rights Reserved.
+ * Copyright (C) 2017-2019, Mavimax, Ltd. All Rights Reserved.
+ * This software is released under one of the following licenses:
+ * AGPL (with Java and Go exceptions) or Mavimax's license for commercial use.
+ * See LICENSE file for full text.
+ * -----------------------------------------------------------------------------
+ * AGPL license:
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License, version 3 as published
+ * by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License, version 3
+ * for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * -----------------------------------------------------------------------------
+ * A commercial use license is available from Mavimax, Ltd
+ * contact@mavimax.com
+ * -----------------------------------------------------------------------------
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <cgreen/cgreen.h>
+#include <ubf.h>
+#include <ndrstandard.h>
+#include <string.h>
+#include <ndebug.h>
+#include <inicfg.h>
+#include <nstd_int.h>
+#include "test.fd.h"
+#include "ubfunit1.h"
+
+/**
+ * Load the snapshot into new config and return value of the key
+ * @param snap attached snapshot
+ * @param sections sections to load
+ * @param section section to lookup
+ * @param key key to lookup
+ * @param out value buffer (empty if not found)
+ * @param outsz buffer size
+ */
+exprivate void ccsnap_get(ndrx_ccsnap_t *snap, char **sections, 
+        char *section, char *key, char *out, size_t outsz)
+{
+    ndrx_inicfg_t *cfg = ndrx_inicfg_new2(EXTRUE);
+    ndrx_inicfg_section_keyval_t *vals = NULL, *val;
+    
+    out[0] = EXEOS;
+    assert_not_equal(cfg, NULL);
+    assert_equal(ndrx_ccsnap_load(snap, cfg, sections), EXSUCCEED);
+    assert_equal(ndrx_inicfg_get_subsect(cfg, NULL, section, &vals), EXSUCCEED);
+    
+    if (NULL!=(val=ndrx_keyval_hash_get(vals, key)))
+    {
+        NDRX_STRCPY_SAFE_DST(out, val->val, outsz);
+    }
+    
+    ndrx_keyval_hash_free(vals);
+    ndrx_inicfg_free(cfg);
+}
+
+/**
+ * Publish, attach, per process env substitution and stale detection
+ */
+Ensure(test_nstd_ccsnap_basic)
+{
+    char dir[PATH_MAX+1];
+    char ini[PATH_MAX+1];
+    char snapf[PATH_MAX+1];
+    char val[256];
+    char *resources[] = {dir, NULL};
+    char *other_res[] = {ini, NULL};
+    char *sections[] = {"@global", "@debug", NULL};
+    ndrx_ccsnap_t *snap;
+    uint64_t gen1, gen2;
+    FILE *f;
+    
+    snprintf(dir, sizeof(dir), "/tmp/ccsnap_%d", (int)getpid());
+    snprintf(ini, sizeof(ini), "%s/app.ini", dir);
+    snprintf(snapf, sizeof(snapf), "/tmp/ccsnap_%d.snap", (int)getpid());
+    
+    assert_equal(mkdir(dir, 0700), EXSUCCEED);
+    assert_not_equal((f=fopen(ini, "w")), NULL);
+    fprintf(f, "[@global]\nCCS_K1=${CCSNAP_TEST_ENV}/x\nCCS_K2=plain\n"
+            "[@debug]\nndrx=5\n[other]\nX=1\n");
+    fclose(f);
+    
+    setenv("CCSNAP_TEST_ENV", "val1", EXTRUE);
+    
+    assert_equal(ndrx_ccsnap_write(snapf, resources, sections), EXSUCCEED);
+    assert_equal(ndrx_ccsnap_gen_get(snapf, &gen1), EXSUCCEED);
+    
+    /* different resource list is not accepted */
+    assert_equal(ndrx_ccsnap_attach(snapf, other_res), NULL);
+    
+    assert_not_equal((snap=ndrx_ccsnap_attach(snapf, resources)), NULL);
+    
+    ccsnap_get(snap, sections, "@global", "CCS_K1", val, sizeof(val));
+    assert_string_equal(val, "val1/x");
+    ccsnap_get(snap, sections, "@global", "CCS_K2", val, sizeof(val));
+    assert_string_equal(val, "plain");
+    ccsnap_get(snap, sections, "@debug", "ndrx", val, sizeof(val));
+    assert_string_equal(val, "5");
+    
+    /* not published section */
+    ccsnap_get(snap, NULL, "other", "X", val, sizeof(val));
+    assert_string_equal(val, "");
+    
+    /* first pass filter */
+    ccsnap_get(snap, sections+1, "@global", "CCS_K2", val, sizeof(val));
+    assert_string_equal(val, "");
+    
+    /* value is resolved by reader's env */
+    setenv("CCSNAP_TEST_ENV", "val2", EXTRUE);
+    ccsnap_get(snap, sections, "@global", "CCS_K1", val, sizeof(val));
+    assert_string_equal(val, "val2/x");
+    
+    ndrx_ccsnap_detach(snap);
+    
+    /* changed file makes the snapshot stale */
+    assert_not_equal((f=fopen(ini, "a")), NULL);
+    fprintf(f, "Y=2\n");
+    fclose(f);
+    
+    assert_equal(ndrx_ccsnap_attach(snapf, resources), NULL);
+    
+    /* republish gives new generation */
+    assert_equal(ndrx_ccsnap_write(snapf, resources, sections), EXSUCCEED);
+    assert_equal(ndrx_ccsnap_gen_get(snapf, &gen2), EXSUCCEED);
+    assert_not_equal(gen1, gen2);
+    assert_not_equal((snap=ndrx_ccsnap_attach(snapf, resources)), NULL);
+    ndrx_ccsnap_detach(snap);
+    
+    /* corrupted snapshot is not used */
+    assert_equal(truncate(snapf, 40), EXSUCCEED);
+    assert_equal(ndrx_ccsnap_attach(snapf, resources), NULL);
+    
+    unsetenv("CCSNAP_TEST_ENV");
+    unlink(snapf);
+    unlink(ini);
+    rmdir(dir);
+}
+
+/**
+ * Common-config snapshot tests
+ * @return
+ */
+TestSuite *ubf_nstd_ccsnap(void)
+{
+    TestSuite *suite = create_test_suite();
+
+    add_test(suite, test_nstd_ccsnap_basic);
+            
+    return suite;
+}
+/* vim: set ts=4 sw=4 et smartindent: */
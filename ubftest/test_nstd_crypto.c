@@ -40,6 +40,8 @@
 #include <string.h>
 #include <ndebug.h>
 #include <excrypto.h>
+#include <exaesgcm.h>
+#include <nerror.h>
 #include "test.fd.h"
 #include "ubfunit1.h"
 
@@ -112,6 +114,176 @@ Ensure(test_crypto_subst_func)
     }
 }
 
+/**
+ * Convert hex string to bytes
+ * @param hex hex string
+ * @param out output buffer
+ * @return number of bytes
+ */
+exprivate size_t gcm_unhex(char *hex, uint8_t *out)
+{
+    size_t n = 0;
+    unsigned int b;
+    
+    while (EXEOS!=hex[0] && 1==sscanf(hex, "%2x", &b))
+    {
+        out[n++] = (uint8_t)b;
+        hex+=2;
+    }
+    
+    return n;
+}
+
+/**
+ * Run NIST GCM test case with given context flags
+ */
+exprivate void gcm_run_vector(long flags, char *key, char *iv, char *aad, 
+        char *pt, char *ct, char *tag)
+{
+    ndrx_aesgcm_ctx_t ctx;
+    uint8_t k[16], n[12], a[64], p[64], c[64], t[16], out[64], otag[16];
+    size_t alen, plen;
+    
+    gcm_unhex(key, k);
+    gcm_unhex(iv, n);
+    alen = gcm_unhex(aad, a);
+    plen = gcm_unhex(pt, p);
+    gcm_unhex(ct, c);
+    gcm_unhex(tag, t);
+    
+    ndrx_aesgcm_init(&ctx, k, flags);
+    
+    ndrx_aesgcm_encrypt(&ctx, n, a, alen, p, plen, out, otag);
+    assert_equal(memcmp(out, c, plen), 0);
+    assert_equal(memcmp(otag, t, sizeof(t)), 0);
+    
+    assert_equal(ndrx_aesgcm_decrypt(&ctx, n, a, alen, c, plen, out, t), 
+            EXSUCCEED);
+    assert_equal(memcmp(out, p, plen), 0);
+    
+    /* modified tag must be detected */
+    t[0]^=1;
+    assert_equal(ndrx_aesgcm_decrypt(&ctx, n, a, alen, c, plen, out, t), 
+            EXFAIL);
+}
+
+/**
+ * AES-GCM against NIST test vectors (test cases 1-4), portable and
+ * hardware implementations
+ */
+Ensure(test_crypto_gcm_vectors)
+{
+    long flags[] = {NDRX_AESGCM_NOHW, 0};
+    int i;
+    
+    for (i=0; i<N_DIM(flags); i++)
+    {
+        if (0==flags[i] && !ndrx_aesgcm_hw_supported())
+        {
+            NDRX_LOG(log_warn, "No AES-NI/PCLMUL - hardware GCM not tested");
+            continue;
+        }
+        
+        gcm_run_vector(flags[i], "00000000000000000000000000000000",
+                "000000000000000000000000", "", "", "",
+                "58e2fccefa7e3061367f1d57a4e7455a");
+        
+        gcm_run_vector(flags[i], "00000000000000000000000000000000",
+                "000000000000000000000000", "", 
+                "00000000000000000000000000000000",
+                "0388dace60b6a392f328c2b971b2fe78",
+                "ab6e47d42cec13bdf53a67b21257bddf");
+        
+        gcm_run_vector(flags[i], "feffe9928665731c6d6a8f9467308308",
+                "cafebabefacedbaddecaf888", "",
+                "d9313225f88406e5a55909c5aff5269a"
+                "86a7a9531534f7da2e4c303d8a318a72"
+                "1c3c0c95956809532fcf0e2449a6b525"
+                "b16aedf5aa0de657ba637b391aafd255",
+                "42831ec2217774244b7221b784d0d49c"
+                "e3aa212f2c02a4e035c17e2329aca12e"
+                "21d514b25466931c7d8f6a5aac84aa05"
+                "1ba30b396a0aac973d58e091473f5985",
+                "4d5c2af327cd64a62cf35abd2ba6fab4");
+        
+        gcm_run_vector(flags[i], "feffe9928665731c6d6a8f9467308308",
+                "cafebabefacedbaddecaf888", 
+                "feedfacedeadbeeffeedfacedeadbeefabaddad2",
+                "d9313225f88406e5a55909c5aff5269a"
+                "86a7a9531534f7da2e4c303d8a318a72"
+                "1c3c0c95956809532fcf0e2449a6b525"
+                "b16aedf5aa0de657ba637b39",
+                "42831ec2217774244b7221b784d0d49c"
+                "e3aa212f2c02a4e035c17e2329aca12e"
+                "21d514b25466931c7d8f6a5aac84aa05"
+                "1ba30b396a0aac973d58e091",
+                "5bc94fbc3221a5db94fae95ae7121a47");
+    }
+}
+
+/**
+ * GCM mode of the crypto API: round trip, tamper detection and
+ * reading of CBC data while GCM is enabled
+ */
+Ensure(test_crypto_gcm_mode)
+{
+    char cbc[1024];
+    char gcm[1024];
+    char out[1024];
+    char str[1024];
+    long cbclen, gcmlen, len;
+    int i;
+    
+#define ENC_GCM_STRING "HELLO GCM _ 123 hello test"
+
+    unsetenv(CONF_NDRX_CRYPTOMODE);
+    cbclen=sizeof(cbc);
+    assert_equal(ndrx_crypto_enc(ENC_GCM_STRING, sizeof(ENC_GCM_STRING), 
+            cbc, &cbclen), EXSUCCEED);
+    
+    assert_equal(setenv(CONF_NDRX_CRYPTOMODE, "GCM", EXTRUE), EXSUCCEED);
+    
+    for (i=0; i<100; i++)
+    {
+        gcmlen=sizeof(gcm);
+        assert_equal(ndrx_crypto_enc(ENC_GCM_STRING, sizeof(ENC_GCM_STRING), 
+                gcm, &gcmlen), EXSUCCEED);
+        /* 4 byte len + 12 byte nonce + data + 16 byte tag */
+        assert_equal(gcmlen, sizeof(ENC_GCM_STRING)+32);
+        
+        len=sizeof(out);
+        assert_equal(ndrx_crypto_dec(gcm, gcmlen, out, &len), EXSUCCEED);
+        assert_equal(len, sizeof(ENC_GCM_STRING));
+        assert_string_equal(out, ENC_GCM_STRING);
+    }
+    
+    /* nonce must differ between calls */
+    len=sizeof(out);
+    assert_equal(ndrx_crypto_enc(ENC_GCM_STRING, sizeof(ENC_GCM_STRING), 
+            out, &len), EXSUCCEED);
+    assert_not_equal(memcmp(out, gcm, gcmlen), 0);
+    
+    /* old format is still readable */
+    len=sizeof(out);
+    assert_equal(ndrx_crypto_dec(cbc, cbclen, out, &len), EXSUCCEED);
+    assert_string_equal(out, ENC_GCM_STRING);
+    
+    /* modified cipher text */
+    gcm[20]^=0x01;
+    len=sizeof(out);
+    assert_equal(ndrx_crypto_dec(gcm, gcmlen, out, &len), EXFAIL);
+    assert_equal(Nerror, NEINVALKEY);
+    
+    /* string mode */
+    len=sizeof(str);
+    assert_equal(ndrx_crypto_enc_string(ENC_GCM_STRING, str, &len), EXSUCCEED);
+    len=sizeof(out);
+    assert_equal(ndrx_crypto_dec_string(str, out, &len), EXSUCCEED);
+    assert_string_equal(out, ENC_GCM_STRING);
+    
+    unsetenv(CONF_NDRX_CRYPTOMODE);
+}
+
 /**
  * LMDB/EXDB tests
  * @return
@@ -127,6 +299,8 @@ TestSuite *ubf_nstd_crypto(void)
     
     add_test(suite, test_crypto_enc_string);
     add_test(suite, test_crypto_subst_func);
+    add_test(suite, test_crypto_gcm_vectors);
+    add_test(suite, test_crypto_gcm_mode);
             
     return suite;
 }
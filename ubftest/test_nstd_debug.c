@@ -32,6 +32,10 @@
  * -----------------------------------------------------------------------------
  */
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <cgreen/cgreen.h>
@@ -44,6 +48,7 @@
 #include "test.fd.h"
 #include "ubfunit1.h"
 #include "xatmi.h"
+#include <nstd_int.h>
 
 /**
  * Test base64 functions of Enduro/X standard library
@@ -107,6 +112,83 @@ Ensure(test_nstd_tplogqinfo)
     
 }
 
+/**
+ * Binary trace: lines written with deferred formatting shall be decoded
+ * to the same text as the text logger would print
+ */
+Ensure(test_nstd_dbgbin)
+{
+    char *tmpf = "/tmp/ubfunit1_dbgbin.log";
+    char orgfile[PATH_MAX+1];
+    unsigned char blob[16];
+    char big[5000];
+    char srcfile[32];
+    char *dec = NULL;
+    size_t decsz = 0;
+    char raw[16384];
+    size_t rawlen;
+    FILE *in;
+    FILE *out;
+    int i;
+    
+    NDRX_STRCPY_SAFE(orgfile, debug_get_tp_ptr()->filename);
+    unlink(tmpf);
+    
+    assert_equal(tplogconfig(LOG_FACILITY_TP, EXFAIL, "tp=5 binary=y", NULL, 
+            tmpf), EXSUCCEED);
+    
+    for (i=0; i<(int)sizeof(blob); i++)
+    {
+        blob[i] = (unsigned char)(0x3c+i);
+    }
+    
+    memset(big, 'Z', sizeof(big)-1);
+    big[sizeof(big)-1] = EXEOS;
+    
+    TP_LOG(log_debug, "int %d long %ld str [%s] prec [%.*s] dbl %.2f hex %04x%%", 
+            5, 777777777L, "hello", 3, "abcdef", 1.25, 0xab);
+    TP_LOG(log_error, "size %zu wide [%-6s] char %c", (size_t)99, "ab", 'Q');
+    TP_DUMP(log_debug, "blob", blob, sizeof(blob));
+    /* does not fit in binary record, goes as text */
+    TP_LOG(log_debug, "big [%s]", big);
+    /* caller provided file name, same buffer with other text */
+    NDRX_STRCPY_SAFE(srcfile, "srcaaaa1.c");
+    TP_LOGEX(log_debug, srcfile, 101, "ex %d", 1);
+    NDRX_STRCPY_SAFE(srcfile, "srcbbbb2.c");
+    TP_LOGEX(log_debug, srcfile, 102, "ex %d", 2);
+    
+    assert_equal(tplogconfig(LOG_FACILITY_TP, EXFAIL, "binary=n", NULL, 
+            orgfile), EXSUCCEED);
+    
+    /* raw file keeps format strings only */
+    assert_not_equal((in = fopen(tmpf, "r")), NULL);
+    rawlen = fread(raw, 1, sizeof(raw)-1, in);
+    raw[rawlen] = EXEOS;
+    assert_not_equal(memmem(raw, rawlen, "int %d long %ld", 15), NULL);
+    assert_equal(memmem(raw, rawlen, "int 5 long", 10), NULL);
+    
+    rewind(in);
+    assert_not_equal((out = open_memstream(&dec, &decsz)), NULL);
+    assert_equal(ndrx_dbgbin_decode(in, out), EXSUCCEED);
+    fclose(out);
+    fclose(in);
+    
+    assert_not_equal(strstr(dec, "t:USER:5:"), NULL);
+    assert_not_equal(strstr(dec, "t:USER:2:"), NULL);
+    assert_not_equal(strstr(dec, ":int 5 long 777777777 str [hello] prec [abc] "
+            "dbl 1.25 hex 00ab%\n"), NULL);
+    assert_not_equal(strstr(dec, ":size 99 wide [ab    ] char Q\n"), NULL);
+    assert_not_equal(strstr(dec, ":blob (nr bytes: 16)\n"
+            "  0000  3c 3d 3e 3f 40 41 42 43 44 45 46 47 48 49 4a 4b  "
+            "<=>?@ABCDEFGHIJK\n"), NULL);
+    assert_not_equal(strstr(dec, big), NULL);
+    assert_not_equal(strstr(dec, ":caaaa1.c:0101:ex 1\n"), NULL);
+    assert_not_equal(strstr(dec, ":cbbbb2.c:0102:ex 2\n"), NULL);
+    
+    free(dec);
+    unlink(tmpf);
+}
+
 /**
  * Debug routine tests
  * @return
@@ -116,6 +198,7 @@ TestSuite *ubf_nstd_debug(void)
     TestSuite *suite = create_test_suite();
 
     add_test(suite, test_nstd_tplogqinfo);
+    add_test(suite, test_nstd_dbgbin);
             
     return suite;
 }
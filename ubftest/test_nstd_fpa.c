@@ -421,6 +421,61 @@ Ensure(test_nstd_fpa_realloc)
     
 }
 
+/**
+ * Thread magazines: hits/misses are counted and pool depth grows when pool
+ * runs empty.
+ */
+Ensure(test_nstd_fpa_adapt)
+{
+    char *ptr[NDRX_FPA_0_DNUM*2];
+    int i, j;
+    ndrx_fpapool_t stats;
+    
+    unsetenv(CONF_NDRX_FPAOPTS);
+    
+    /* working set twice the pool depth */
+    for (j=0; j<100; j++)
+    {
+        for (i=0; i<N_DIM(ptr); i++)
+        {
+            ptr[i] = ndrx_fpmalloc(NDRX_FPA_0_SIZE, 0);
+        }
+        
+        assert_not_equal(ptr[N_DIM(ptr)-1], NULL);
+        
+        for (i=0; i<N_DIM(ptr); i++)
+        {
+            ndrx_fpfree(ptr[i]);
+        }
+    }
+    
+    ndrx_fpstats(0, &stats);
+    
+    assert_equal(stats.num_blocks, NDRX_FPA_0_DNUM);
+    assert_equal(stats.mag_size, NDRX_FPA_0_DNUM/2);
+    assert_equal(stats.contention, 0);
+    assert_equal(stats.hits+stats.misses, 100*N_DIM(ptr));
+    assert_true(stats.lim_blocks > stats.num_blocks);
+    assert_true(stats.lim_blocks <= stats.num_blocks*NDRX_FPA_ADAPT_MULT);
+    assert_true(stats.cur_blocks <= stats.lim_blocks);
+    
+    /* deeper pool serves the whole working set */
+    for (i=0; i<N_DIM(ptr); i++)
+    {
+        ptr[i] = ndrx_fpmalloc(NDRX_FPA_0_SIZE, 0);
+    }
+    
+    for (i=0; i<N_DIM(ptr); i++)
+    {
+        ndrx_fpfree(ptr[i]);
+    }
+    
+    ndrx_fpstats(0, &stats);
+    assert_equal(stats.hits+stats.misses, 101*N_DIM(ptr));
+    
+    ndrx_fpuninit();
+}
+
 /**
  * Standard library tests
  * @return
@@ -436,6 +491,7 @@ TestSuite *ubf_nstd_fpa(void)
     add_test(suite, test_nstd_fpa_config_limits);
     add_test(suite, test_nstd_fpa_config_inval);
     add_test(suite, test_nstd_fpa_realloc);
+    add_test(suite, test_nstd_fpa_adapt);
     
     return suite;
 }
@@ -0,0 +1,162 @@
+/**
+ * @brief LZ block compression tests
+ *
+ * @file test_nstd_lz.c
+ */
+/* -----------------------------------------------------------------------------
+ * Enduro/X Middleware Platform for Distributed Transaction Processing
+ * Copyright (C) 2009-2016, ATR Baltic, Ltd. All Rights Reserved.
+ * Copyright (C) 2017-2019, Mavimax, Ltd. All Rights Reserved.
+ * This software is released under one of the following licenses:
+ * AGPL (with Java and Go exceptions) or Mavimax's license for commercial use.
+ * See LICENSE file for full text.
+ * -----------------------------------------------------------------------------
+ * AGPL license:
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License, version 3 as published
+ * by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License, version 3
+ * for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * -----------------------------------------------------------------------------
+ * A commercial use license is available from Mavimax, Ltd
+ * contact@mavimax.com
+ * -----------------------------------------------------------------------------
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <cgreen/cgreen.h>
+#include <ubf.h>
+#include <ndrstandard.h>
+#include <string.h>
+#include <ndebug.h>
+#include <exlz.h>
+#include "test.fd.h"
+#include "ubfunit1.h"
+
+/**
+ * Compress, check ratio (if expected) and decompress back
+ * @param data data to test
+ * @param len data len
+ * @param max_cmpr max expected compressed len
+ */
+exprivate void lz_roundtrip(char *data, long len, long max_cmpr)
+{
+    char *cmpr = NDRX_MALLOC(NDRX_LZ_BOUND(len));
+    char *out = NDRX_MALLOC(len+1);
+    long cmpr_len;
+    
+    cmpr_len = ndrx_lz_compress(data, len, cmpr, NDRX_LZ_BOUND(len));
+    
+    assert_not_equal(cmpr_len, EXFAIL);
+    assert_true(cmpr_len <= max_cmpr);
+    
+    assert_equal(ndrx_lz_decompress(cmpr, cmpr_len, out, len+1), len);
+    assert_equal(memcmp(out, data, len), 0);
+    
+    NDRX_FREE(cmpr);
+    NDRX_FREE(out);
+}
+
+/**
+ * Repetitive, random and short inputs survive the round trip
+ */
+Ensure(test_nstd_lz_roundtrip)
+{
+    long len = 300000;
+    char *buf = NDRX_MALLOC(len);
+    long i;
+    
+    /* UBF like repeating records */
+    for (i=0; i<len; i++)
+    {
+        buf[i] = "T_STRING_FLD\0\0\0\x05HELLO WORLD 0123456789"[i%36];
+    }
+    lz_roundtrip(buf, len, len/20);
+    
+    /* single byte run, overlapping matches */
+    memset(buf, 'A', len);
+    lz_roundtrip(buf, len, len/100);
+    
+    /* noise, must not grow over the bound */
+    srand(1);
+    for (i=0; i<len; i++)
+    {
+        buf[i] = (char)rand();
+    }
+    lz_roundtrip(buf, len, NDRX_LZ_BOUND(len));
+    
+    /* short inputs are stored as literals */
+    for (i=0; i<20; i++)
+    {
+        lz_roundtrip(buf, i, NDRX_LZ_BOUND(i));
+    }
+    
+    NDRX_FREE(buf);
+}
+
+/**
+ * Output buffer limits and corrupted input are detected
+ */
+Ensure(test_nstd_lz_limits)
+{
+    char data[4096];
+    char cmpr[NDRX_LZ_BOUND(sizeof(data))];
+    char out[sizeof(data)];
+    long cmpr_len;
+    long i;
+    
+    memset(data, 'x', sizeof(data));
+    
+    cmpr_len = ndrx_lz_compress(data, sizeof(data), cmpr, sizeof(cmpr));
+    assert_not_equal(cmpr_len, EXFAIL);
+    
+    /* does not fit in output */
+    assert_equal(ndrx_lz_compress(data, sizeof(data), cmpr, 5), EXFAIL);
+    assert_equal(ndrx_lz_decompress(cmpr, cmpr_len, out, sizeof(out)-1), EXFAIL);
+    
+    /* truncated input */
+    assert_equal(ndrx_lz_decompress(cmpr, cmpr_len-1, out, sizeof(out)), EXFAIL);
+    
+    /* offset pointing before the start of output */
+    cmpr[0] = 0x04;
+    cmpr[1] = (char)0xff;
+    cmpr[2] = 0x00;
+    assert_equal(ndrx_lz_decompress(cmpr, 3, out, sizeof(out)), EXFAIL);
+    
+    /* garbage must not crash */
+    srand(2);
+    for (i=0; i<1000; i++)
+    {
+        long j;
+        for (j=0; j<64; j++)
+        {
+            cmpr[j] = (char)rand();
+        }
+        ndrx_lz_decompress(cmpr, 64, out, sizeof(out));
+    }
+}
+
+/**
+ * LZ compression tests from Enduro/X Standard Library
+ * @return
+ */
+TestSuite *ubf_nstd_lz(void)
+{
+    TestSuite *suite = create_test_suite();
+
+    add_test(suite, test_nstd_lz_roundtrip);
+    add_test(suite, test_nstd_lz_limits);
+            
+    return suite;
+}
+/* vim: set ts=4 sw=4 et smartindent: */
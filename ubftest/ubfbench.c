@@ -0,0 +1,1061 @@
+/**
+ * @brief UBF engine micro-benchmarks. Scenarios are run for each field type,
+ *   buffer size (number of fields) and occurrence count, with sequential and
+ *   random access. Result is CSV: name,iterations,ns_per_op,allocs_per_op.
+ *   Ops are counted per field for Badd/Bbld/Bchg/Bget/Bnext and the batch
+ *   Bgetmulti/Bchgmulti, and per call for the rest. Bchg/Bget and the batch
+ *   calls access at most BENCH_SAMPLE fields per round, as field lookup is
+ *   linear in the buffer size. Saved results can be used as
+ *   baseline for comparison (-b).
+ *
+ * @file ubfbench.c
+ */
+/* -----------------------------------------------------------------------------
+ * Enduro/X Middleware Platform for Distributed Transaction Processing
+ * Copyright (C) 2009-2016, ATR Baltic, Ltd. All Rights Reserved.
+ * Copyright (C) 2017-2019, Mavimax, Ltd. All Rights Reserved.
+ * This software is released under one of the following licenses:
+ * AGPL (with Java and Go exceptions) or Mavimax's license for commercial use.
+ * See LICENSE file for full text.
+ * -----------------------------------------------------------------------------
+ * AGPL license:
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License, version 3 as published
+ * by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License, version 3
+ * for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * -----------------------------------------------------------------------------
+ * A commercial use license is available from Mavimax, Ltd
+ * contact@mavimax.com
+ * -----------------------------------------------------------------------------
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <stdint.h>
+
+#include <ubf.h>
+#include <ndrstandard.h>
+#include <ndebug.h>
+#include "test.fd.h"
+
+/*---------------------------Externs------------------------------------*/
+#ifdef __GLIBC__
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+#endif
+/*---------------------------Macros-------------------------------------*/
+#define BENCH_FLDBASE       5000    /**< first field number used            */
+#define BENCH_CARRAY_LEN    16      /**< carray value size                  */
+#define BENCH_MINTIME_MS    200     /**< default run time per scenario      */
+#define BENCH_THRESHOLD     10.0    /**< default regression threshold, %    */
+#define BENCH_NAME_MAX      128     /**< scenario name length               */
+#define BENCH_SAMPLE        1000    /**< max fields accessed per round      */
+#define BENCH_HEADER        "name,iterations,ns_per_op,allocs_per_op"
+/*---------------------------Enums--------------------------------------*/
+/*---------------------------Typedefs-----------------------------------*/
+
+/**
+ * Scenario data
+ */
+typedef struct
+{
+    int type;           /**< BFLD_* type of the fields                      */
+    int nflds;          /**< total number of fields in buffer               */
+    int occ;            /**< occurrences per field id                       */
+    int rnd;            /**< random access order                            */
+    int nids;           /**< number of distinct field ids                   */
+    int nsample;        /**< fields accessed per Bchg/Bget round            */
+    int stride;         /**< step in access order for sampling              */
+    BFLDID *ids;        /**< field ids                                      */
+    int *order;         /**< access order, entry: id index * occ + occ      */
+    UBFH *p_ub;         /**< pre-built buffer                               */
+    UBFH *p_ub2;        /**< work buffer                                    */
+    long bufsz;         /**< buffer sizes                                   */
+    BFLDID *projlist;   /**< Bproj field list (half of ids)                 */
+    char *tree;         /**< compiled expression                            */
+    FILE *f;            /**< print/extread file                             */
+    Bbld_t *bld;        /**< bulk builder                                   */
+    Bfld_multi_t *items;/**< Bgetmulti/Bchgmulti items (sampled fields)     */
+    char *vals;         /**< item values                                    */
+} bench_ctx_t;
+
+/**
+ * Benchmark operation
+ * @return number of ops done, EXFAIL on error
+ */
+typedef long (*bench_op_t)(bench_ctx_t *ctx);
+
+/**
+ * Baseline entry
+ */
+typedef struct
+{
+    char name[BENCH_NAME_MAX];  /**< scenario name */
+    double ns;                  /**< ns/op         */
+} bench_base_t;
+
+/*---------------------------Globals------------------------------------*/
+/*---------------------------Statics------------------------------------*/
+exprivate long M_allocs = 0;                /**< allocation counter          */
+exprivate int M_mintime = BENCH_MINTIME_MS; /**< run time per scenario, ms   */
+exprivate char *M_filter = NULL;            /**< run only matching names     */
+exprivate FILE *M_out = NULL;               /**< results output (-o)         */
+exprivate bench_base_t *M_base = NULL;      /**< baseline results            */
+exprivate int M_nbase = 0;                  /**< number of baseline entries  */
+exprivate double M_threshold = BENCH_THRESHOLD; /**< regression threshold    */
+exprivate int M_regressions = 0;            /**< regressions found           */
+/** 100000 is supported with -n, but Badd/Bextread are quadratic there */
+exprivate int M_sizes[] = {10, 100, 1000, 10000, 0, 0, 0, 0};
+exprivate int M_nsizes = 4;
+exprivate char *M_typenames[] = {"short", "long", "char", "float", "double", 
+    "string", "carray"};
+/*---------------------------Prototypes---------------------------------*/
+
+#ifdef __GLIBC__
+/* count the allocations done by the engine, single threaded */
+void *malloc(size_t size)
+{
+    M_allocs++;
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t nmemb, size_t size)
+{
+    M_allocs++;
+    return __libc_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    M_allocs++;
+    return __libc_realloc(ptr, size);
+}
+#endif
+
+/**
+ * Monotonic time
+ * @return nanoseconds
+ */
+exprivate uint64_t now_ns(void)
+{
+    struct timespec t;
+    
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    
+    return (uint64_t)t.tv_sec*1000000000 + t.tv_nsec;
+}
+
+/**
+ * Build value of the field
+ * @param type field type
+ * @param i value seed
+ * @param buf value storage
+ * @param len value len (for carray)
+ */
+exprivate void mkval(int type, int i, char *buf, BFLDLEN *len)
+{
+    *len = 0;
+    
+    switch (type)
+    {
+        case BFLD_SHORT:
+            *((short *)buf) = (short)(i % 30000);
+            break;
+        case BFLD_LONG:
+            *((long *)buf) = (long)i;
+            break;
+        case BFLD_CHAR:
+            buf[0] = 'A' + i % 26;
+            break;
+        case BFLD_FLOAT:
+            *((float *)buf) = (float)i;
+            break;
+        case BFLD_DOUBLE:
+            *((double *)buf) = (double)i;
+            break;
+        case BFLD_STRING:
+            snprintf(buf, BENCH_CARRAY_LEN, "value%08d", i);
+            break;
+        case BFLD_CARRAY:
+            memset(buf, i, BENCH_CARRAY_LEN);
+            *len = BENCH_CARRAY_LEN;
+            break;
+    }
+}
+
+/**
+ * Fill buffer with all the fields of scenario
+ * @param ctx scenario
+ * @param p_ub buffer to fill
+ * @param seed value seed
+ * @param in_order add fields in access order (random order = inserts)
+ * @return EXSUCCEED/EXFAIL
+ */
+exprivate int fill(bench_ctx_t *ctx, UBFH *p_ub, int seed, int in_order)
+{
+    int i, e;
+    char val[BENCH_CARRAY_LEN+8];
+    BFLDLEN len;
+    
+    for (i=0; i<ctx->nflds; i++)
+    {
+        e = in_order ? ctx->order[i] : i;
+        mkval(ctx->type, e+seed, val, &len);
+        
+        if (EXSUCCEED!=Badd(p_ub, ctx->ids[e / ctx->occ], val, len))
+        {
+            NDRX_LOG(log_error, "Badd failed: %s", Bstrerror(Berror));
+            return EXFAIL;
+        }
+    }
+    
+    return EXSUCCEED;
+}
+
+/**
+ * Badd: build buffer, in order of access (random order is insert in middle)
+ */
+exprivate long op_badd(bench_ctx_t *ctx)
+{
+    if (EXSUCCEED!=Binit(ctx->p_ub2, ctx->bufsz) || 
+            EXSUCCEED!=fill(ctx, ctx->p_ub2, 0, ctx->rnd))
+    {
+        return EXFAIL;
+    }
+    
+    return ctx->nflds;
+}
+
+/**
+ * Bbld: build buffer with bulk builder, in order of access
+ */
+exprivate long op_bbld(bench_ctx_t *ctx)
+{
+    int i, e;
+    char val[BENCH_CARRAY_LEN+8];
+    BFLDLEN len;
+    
+    Bbldreset(ctx->bld);
+    
+    for (i=0; i<ctx->nflds; i++)
+    {
+        e = ctx->order[i];
+        mkval(ctx->type, e, val, &len);
+        
+        if (EXSUCCEED!=Bbldadd(ctx->bld, ctx->ids[e / ctx->occ], val, len))
+        {
+            NDRX_LOG(log_error, "Bbldadd failed: %s", Bstrerror(Berror));
+            return EXFAIL;
+        }
+    }
+    
+    if (EXSUCCEED!=Binit(ctx->p_ub2, ctx->bufsz) || 
+            EXSUCCEED!=Bbldfinal(ctx->bld, ctx->p_ub2))
+    {
+        NDRX_LOG(log_error, "Bbldfinal failed: %s", Bstrerror(Berror));
+        return EXFAIL;
+    }
+    
+    return ctx->nflds;
+}
+
+/**
+ * Bchg: change all existing occurrences
+ */
+exprivate long op_bchg(bench_ctx_t *ctx)
+{
+    int i, e;
+    char val[BENCH_CARRAY_LEN+8];
+    BFLDLEN len;
+    
+    for (i=0; i<ctx->nsample; i++)
+    {
+        e = ctx->order[i*ctx->stride];
+        mkval(ctx->type, e+1, val, &len);
+        
+        if (EXSUCCEED!=Bchg(ctx->p_ub, ctx->ids[e / ctx->occ], e % ctx->occ, 
+                val, len))
+        {
+            NDRX_LOG(log_error, "Bchg failed: %s", Bstrerror(Berror));
+            return EXFAIL;
+        }
+    }
+    
+    return ctx->nsample;
+}
+
+/**
+ * Bgetmulti: read the sampled fields in one call
+ */
+exprivate long op_bgetmulti(bench_ctx_t *ctx)
+{
+    int i;
+    
+    for (i=0; i<ctx->nsample; i++)
+    {
+        ctx->items[i].len = BENCH_CARRAY_LEN+8;
+    }
+    
+    if (ctx->nsample!=Bgetmulti(ctx->p_ub, ctx->items, ctx->nsample))
+    {
+        NDRX_LOG(log_error, "Bgetmulti failed: %s", Bstrerror(Berror));
+        return EXFAIL;
+    }
+    
+    return ctx->nsample;
+}
+
+/**
+ * Bchgmulti: change the sampled fields in one call
+ */
+exprivate long op_bchgmulti(bench_ctx_t *ctx)
+{
+    int i, e;
+    
+    for (i=0; i<ctx->nsample; i++)
+    {
+        e = ctx->order[i*ctx->stride];
+        mkval(ctx->type, e+1, ctx->items[i].buf, &ctx->items[i].len);
+    }
+    
+    if (EXSUCCEED!=Bchgmulti(ctx->p_ub, ctx->items, ctx->nsample))
+    {
+        NDRX_LOG(log_error, "Bchgmulti failed: %s", Bstrerror(Berror));
+        return EXFAIL;
+    }
+    
+    return ctx->nsample;
+}
+
+/**
+ * Bget: read all occurrences
+ */
+exprivate long op_bget(bench_ctx_t *ctx)
+{
+    int i, e;
+    char val[BENCH_CARRAY_LEN+8];
+    BFLDLEN len;
+    
+    for (i=0; i<ctx->nsample; i++)
+    {
+        e = ctx->order[i*ctx->stride];
+        len = sizeof(val);
+        
+        if (EXSUCCEED!=Bget(ctx->p_ub, ctx->ids[e / ctx->occ], e % ctx->occ, 
+                val, &len))
+        {
+            NDRX_LOG(log_error, "Bget failed: %s", Bstrerror(Berror));
+            return EXFAIL;
+        }
+    }
+    
+    return ctx->nsample;
+}
+
+/**
+ * Bnext: iterate over the buffer
+ */
+exprivate long op_bnext(bench_ctx_t *ctx)
+{
+    BFLDID fldid = BFIRSTFLDID;
+    BFLDOCC occ;
+    char val[BENCH_CARRAY_LEN+8];
+    BFLDLEN len = sizeof(val);
+    long n = 0;
+    int ret;
+    
+    while (1==(ret=Bnext(ctx->p_ub, &fldid, &occ, val, &len)))
+    {
+        len = sizeof(val);
+        n++;
+    }
+    
+    if (EXFAIL==ret)
+    {
+        NDRX_LOG(log_error, "Bnext failed: %s", Bstrerror(Berror));
+        return EXFAIL;
+    }
+    
+    return n;
+}
+
+/**
+ * Bproj preparation: restore the work buffer
+ */
+exprivate long prep_copy(bench_ctx_t *ctx)
+{
+    if (EXSUCCEED!=Bcpy(ctx->p_ub2, ctx->p_ub))
+    {
+        NDRX_LOG(log_error, "Bcpy failed: %s", Bstrerror(Berror));
+        return EXFAIL;
+    }
+    
+    return 0;
+}
+
+/**
+ * Bproj: keep half of the field ids
+ */
+exprivate long op_bproj(bench_ctx_t *ctx)
+{
+    if (EXSUCCEED!=Bproj(ctx->p_ub2, ctx->projlist))
+    {
+        NDRX_LOG(log_error, "Bproj failed: %s", Bstrerror(Berror));
+        return EXFAIL;
+    }
+    
+    return 1;
+}
+
+/**
+ * Bupdate: update all fields of destination
+ */
+exprivate long op_bupdate(bench_ctx_t *ctx)
+{
+    if (EXSUCCEED!=Bupdate(ctx->p_ub2, ctx->p_ub))
+    {
+        NDRX_LOG(log_error, "Bupdate failed: %s", Bstrerror(Berror));
+        return EXFAIL;
+    }
+    
+    return 1;
+}
+
+/**
+ * Bboolev: evaluate compiled expression
+ */
+exprivate long op_bboolev(bench_ctx_t *ctx)
+{
+    if (EXTRUE!=Bboolev(ctx->p_ub, ctx->tree))
+    {
+        NDRX_LOG(log_error, "Bboolev failed: %s", Bstrerror(Berror));
+        return EXFAIL;
+    }
+    
+    return 1;
+}
+
+/**
+ * Bboolco: compile & free expression
+ */
+exprivate long op_bboolco(bench_ctx_t *ctx)
+{
+    char *tree;
+    
+    if (NULL==(tree=Bboolco("T_LONG_FLD==123 && T_STRING_FLD=='HELLO' "
+            "|| T_DOUBLE_FLD > 5.5")))
+    {
+        NDRX_LOG(log_error, "Bboolco failed: %s", Bstrerror(Berror));
+        return EXFAIL;
+    }
+    
+    Btreefree(tree);
+    
+    return 1;
+}
+
+/**
+ * Bfprint: print to file
+ */
+exprivate long op_bfprint(bench_ctx_t *ctx)
+{
+    rewind(ctx->f);
+    
+    if (EXSUCCEED!=Bfprint(ctx->p_ub, ctx->f))
+    {
+        NDRX_LOG(log_error, "Bfprint failed: %s", Bstrerror(Berror));
+        return EXFAIL;
+    }
+    
+    return 1;
+}
+
+/**
+ * Bextread preparation: print buffer to file once
+ */
+exprivate long prep_extread(bench_ctx_t *ctx)
+{
+    if (EXSUCCEED!=Binit(ctx->p_ub2, ctx->bufsz))
+    {
+        return EXFAIL;
+    }
+    
+    rewind(ctx->f);
+    
+    return 0;
+}
+
+/**
+ * Bextread: parse printed buffer
+ */
+exprivate long op_bextread(bench_ctx_t *ctx)
+{
+    if (EXSUCCEED!=Bextread(ctx->p_ub2, ctx->f))
+    {
+        NDRX_LOG(log_error, "Bextread failed: %s", Bstrerror(Berror));
+        return EXFAIL;
+    }
+    
+    return 1;
+}
+
+/**
+ * Find baseline entry
+ * @param name scenario name
+ * @return entry or NULL
+ */
+exprivate bench_base_t *base_find(char *name)
+{
+    int i;
+    
+    for (i=0; i<M_nbase; i++)
+    {
+        if (0==strcmp(M_base[i].name, name))
+        {
+            return &M_base[i];
+        }
+    }
+    
+    return NULL;
+}
+
+/**
+ * Run single scenario & report
+ * @param name scenario name
+ * @param ctx scenario data
+ * @param prep untimed preparation before each round, may be NULL
+ * @param op timed operation
+ * @return EXSUCCEED/EXFAIL
+ */
+exprivate int run(char *name, bench_ctx_t *ctx, bench_op_t prep, bench_op_t op)
+{
+    uint64_t spent = 0;
+    uint64_t start;
+    uint64_t t0;
+    long ops = 0;
+    long allocs = 0;
+    long a0;
+    long n;
+    double ns;
+    double apo;
+    bench_base_t *base;
+    
+    if (NULL!=M_filter && NULL==strstr(name, M_filter))
+    {
+        return EXSUCCEED;
+    }
+    
+    start = now_ns();
+    
+    do
+    {
+        if (NULL!=prep && EXFAIL==prep(ctx))
+        {
+            return EXFAIL;
+        }
+        
+        a0 = M_allocs;
+        t0 = now_ns();
+        n = op(ctx);
+        spent += now_ns() - t0;
+        allocs += M_allocs - a0;
+        
+        if (EXFAIL==n)
+        {
+            fprintf(stderr, "%s: failed: %s\n", name, Bstrerror(Berror));
+            return EXFAIL;
+        }
+        
+        ops+=n;
+        
+    } while (now_ns() - start < (uint64_t)M_mintime*1000000);
+    
+    ns = (double)spent / (double)ops;
+#ifdef __GLIBC__
+    apo = (double)allocs / (double)ops;
+#else
+    apo = -1;
+#endif
+    
+    if (NULL!=M_base)
+    {
+        if (NULL!=(base=base_find(name)) && base->ns > 0)
+        {
+            double delta = (ns - base->ns) / base->ns * 100.0;
+            int regr = (delta > M_threshold);
+            
+            printf("%-45s %12.2lf %12.2lf %+8.1lf%%%s\n", name, base->ns, ns, 
+                    delta, regr?" REGRESSION":"");
+            
+            if (regr)
+            {
+                M_regressions++;
+            }
+        }
+        else
+        {
+            printf("%-45s %12s %12.2lf\n", name, "-", ns);
+        }
+    }
+    else
+    {
+        printf("%s,%ld,%.2lf,%.4lf\n", name, ops, ns, apo);
+    }
+    
+    if (NULL!=M_out)
+    {
+        fprintf(M_out, "%s,%ld,%.2lf,%.4lf\n", name, ops, ns, apo);
+    }
+    
+    fflush(stdout);
+    
+    return EXSUCCEED;
+}
+
+/**
+ * Prepare scenario data
+ * @param ctx scenario to fill
+ * @param type field type
+ * @param nflds number of fields
+ * @param occ occurrences per field id
+ * @param rnd random access order
+ * @return EXSUCCEED/EXFAIL
+ */
+exprivate int ctx_init(bench_ctx_t *ctx, int type, int nflds, int occ, int rnd)
+{
+    int ret = EXSUCCEED;
+    int i, j, tmp;
+    unsigned int seed = 1;
+    
+    memset(ctx, 0, sizeof(*ctx));
+    
+    ctx->type = type;
+    ctx->nflds = nflds;
+    ctx->occ = occ;
+    ctx->rnd = rnd;
+    ctx->nids = nflds / occ;
+    ctx->nsample = nflds < BENCH_SAMPLE ? nflds : BENCH_SAMPLE;
+    ctx->stride = nflds / ctx->nsample;
+    /* field header, value & alignment */
+    ctx->bufsz = 1024 + (long)nflds * (BENCH_CARRAY_LEN + 32);
+    
+    if (NULL==(ctx->ids = NDRX_MALLOC(sizeof(BFLDID)*ctx->nids)) ||
+            NULL==(ctx->projlist = NDRX_MALLOC(sizeof(BFLDID)*(ctx->nids/2+1))) ||
+            NULL==(ctx->order = NDRX_MALLOC(sizeof(int)*nflds)) ||
+            NULL==(ctx->p_ub = (UBFH *)NDRX_MALLOC(ctx->bufsz)) ||
+            NULL==(ctx->p_ub2 = (UBFH *)NDRX_MALLOC(ctx->bufsz)) ||
+            NULL==(ctx->bld = Bbldnew(nflds, nflds * BENCH_CARRAY_LEN)) ||
+            NULL==(ctx->items = NDRX_MALLOC(sizeof(Bfld_multi_t)*ctx->nsample)) ||
+            NULL==(ctx->vals = NDRX_MALLOC((BENCH_CARRAY_LEN+8)*ctx->nsample)))
+    {
+        fprintf(stderr, "malloc failed: %s\n", strerror(errno));
+        EXFAIL_OUT(ret);
+    }
+    
+    for (i=0; i<ctx->nids; i++)
+    {
+        ctx->ids[i] = Bmkfldid(type, BENCH_FLDBASE+i);
+        
+        if (i % 2 == 0)
+        {
+            ctx->projlist[i/2] = ctx->ids[i];
+        }
+    }
+    ctx->projlist[(ctx->nids+1)/2] = BBADFLDID;
+    
+    for (i=0; i<nflds; i++)
+    {
+        ctx->order[i] = i;
+    }
+    
+    /* fixed seed, so that runs are comparable */
+    if (rnd)
+    {
+        for (i=nflds-1; i>0; i--)
+        {
+            j = rand_r(&seed) % (i+1);
+            tmp = ctx->order[i];
+            ctx->order[i] = ctx->order[j];
+            ctx->order[j] = tmp;
+        }
+    }
+    
+    /* batch items, sorted for sequential order only */
+    for (i=0; i<ctx->nsample; i++)
+    {
+        j = ctx->order[i*ctx->stride];
+        ctx->items[i].bfldid = ctx->ids[j / ctx->occ];
+        ctx->items[i].occ = j % ctx->occ;
+        ctx->items[i].usrtype = EXFAIL;
+        ctx->items[i].buf = ctx->vals + i*(BENCH_CARRAY_LEN+8);
+        ctx->items[i].err = 0;
+    }
+    
+    if (EXSUCCEED!=Binit(ctx->p_ub, ctx->bufsz) ||
+            EXSUCCEED!=Binit(ctx->p_ub2, ctx->bufsz) ||
+            EXSUCCEED!=fill(ctx, ctx->p_ub, 0, EXFALSE))
+    {
+        fprintf(stderr, "Failed to prepare buffer: %s\n", Bstrerror(Berror));
+        EXFAIL_OUT(ret);
+    }
+    
+out:
+    return ret;
+}
+
+/**
+ * Free scenario data
+ * @param ctx scenario
+ */
+exprivate void ctx_free(bench_ctx_t *ctx)
+{
+    if (NULL!=ctx->ids)
+    {
+        NDRX_FREE(ctx->ids);
+    }
+    
+    if (NULL!=ctx->projlist)
+    {
+        NDRX_FREE(ctx->projlist);
+    }
+    
+    if (NULL!=ctx->order)
+    {
+        NDRX_FREE(ctx->order);
+    }
+    
+    if (NULL!=ctx->p_ub)
+    {
+        NDRX_FREE(ctx->p_ub);
+    }
+    
+    if (NULL!=ctx->p_ub2)
+    {
+        NDRX_FREE(ctx->p_ub2);
+    }
+    
+    if (NULL!=ctx->tree)
+    {
+        Btreefree(ctx->tree);
+    }
+    
+    if (NULL!=ctx->bld)
+    {
+        Bbldfree(ctx->bld);
+    }
+    
+    if (NULL!=ctx->items)
+    {
+        NDRX_FREE(ctx->items);
+    }
+    
+    if (NULL!=ctx->vals)
+    {
+        NDRX_FREE(ctx->vals);
+    }
+    
+    if (NULL!=ctx->f)
+    {
+        NDRX_FCLOSE(ctx->f);
+    }
+}
+
+/**
+ * Run all the scenarios
+ * @return EXSUCCEED/EXFAIL
+ */
+exprivate int run_all(void)
+{
+    int ret = EXSUCCEED;
+    int type, s, occ, rnd;
+    int occs[] = {1, 10};
+    char name[BENCH_NAME_MAX];
+    char *pattern;
+    bench_ctx_t ctx;
+    long lval = 123;
+    
+    memset(&ctx, 0, sizeof(ctx));
+    
+    for (s=0; s<M_nsizes; s++)
+    {
+        for (type=BFLD_MIN; type<=BFLD_MAX; type++)
+        {
+            for (occ=0; occ<N_DIM(occs); occ++)
+            {
+                for (rnd=0; rnd<2; rnd++)
+                {
+                    if (M_sizes[s] < occs[occ])
+                    {
+                        continue;
+                    }
+                    
+                    if (EXSUCCEED!=ctx_init(&ctx, type, M_sizes[s], occs[occ], rnd))
+                    {
+                        EXFAIL_OUT(ret);
+                    }
+                    
+                    pattern = rnd?"rnd":"seq";
+
+#define RUN(OPNM, PREP, OP) do {\
+        snprintf(name, sizeof(name), "%s/%s/n=%d/occ=%d/%s", OPNM, \
+                M_typenames[type], M_sizes[s], occs[occ], pattern);\
+        if (EXSUCCEED!=run(name, &ctx, PREP, OP)) {EXFAIL_OUT(ret);}\
+    } while (0)
+                    
+                    RUN("Badd", NULL, op_badd);
+                    RUN("Bbld", NULL, op_bbld);
+                    RUN("Bchg", NULL, op_bchg);
+                    RUN("Bget", NULL, op_bget);
+                    
+                    /* access order independent */
+                    if (!rnd)
+                    {
+                        RUN("Bgetmulti", NULL, op_bgetmulti);
+                        RUN("Bchgmulti", NULL, op_bchgmulti);
+                        RUN("Bnext", NULL, op_bnext);
+                        RUN("Bproj", prep_copy, op_bproj);
+                        
+                        /* update existing fields in dest */
+                        if (EXSUCCEED!=Bcpy(ctx.p_ub2, ctx.p_ub))
+                        {
+                            EXFAIL_OUT(ret);
+                        }
+                        RUN("Bupdate", NULL, op_bupdate);
+                        
+                        if (NULL==(ctx.f=tmpfile()))
+                        {
+                            fprintf(stderr, "tmpfile failed: %s\n", strerror(errno));
+                            EXFAIL_OUT(ret);
+                        }
+                        
+                        RUN("Bfprint", NULL, op_bfprint);
+                        RUN("Bextread", prep_extread, op_bextread);
+                    }
+                    
+                    ctx_free(&ctx);
+                    memset(&ctx, 0, sizeof(ctx));
+                }
+            }
+        }
+        
+        /* expressions: fields of the expression + n filler fields */
+        if (EXSUCCEED!=ctx_init(&ctx, BFLD_LONG, M_sizes[s], 1, EXFALSE))
+        {
+            EXFAIL_OUT(ret);
+        }
+        
+        if (EXSUCCEED!=Bchg(ctx.p_ub, T_LONG_FLD, 0, (char *)&lval, 0) ||
+                EXSUCCEED!=Bchg(ctx.p_ub, T_STRING_FLD, 0, "HELLO", 0) ||
+                NULL==(ctx.tree=Bboolco("T_LONG_FLD==123 && T_STRING_FLD=='HELLO' "
+                    "|| T_DOUBLE_FLD > 5.5")))
+        {
+            fprintf(stderr, "Failed to prepare expression: %s\n", 
+                    Bstrerror(Berror));
+            EXFAIL_OUT(ret);
+        }
+        
+        snprintf(name, sizeof(name), "Bboolev/n=%d", M_sizes[s]);
+        if (EXSUCCEED!=run(name, &ctx, NULL, op_bboolev))
+        {
+            EXFAIL_OUT(ret);
+        }
+        
+        ctx_free(&ctx);
+        memset(&ctx, 0, sizeof(ctx));
+    }
+    
+    if (EXSUCCEED!=run("Bboolco", &ctx, NULL, op_bboolco))
+    {
+        EXFAIL_OUT(ret);
+    }
+    
+out:
+    ctx_free(&ctx);
+    return ret;
+}
+
+/**
+ * Load baseline file
+ * @param fname file name
+ * @return EXSUCCEED/EXFAIL
+ */
+exprivate int base_load(char *fname)
+{
+    int ret = EXSUCCEED;
+    FILE *f = NULL;
+    char line[PATH_MAX];
+    char *p;
+    bench_base_t *tmp;
+    
+    if (NULL==(f=NDRX_FOPEN(fname, "r")))
+    {
+        fprintf(stderr, "Failed to open [%s]: %s\n", fname, strerror(errno));
+        EXFAIL_OUT(ret);
+    }
+    
+    while (NULL!=fgets(line, sizeof(line), f))
+    {
+        /* name,iterations,ns_per_op,allocs_per_op */
+        if ('#'==line[0] || 0==strncmp(line, BENCH_HEADER, strlen(BENCH_HEADER)) ||
+                NULL==(p=strchr(line, ',')))
+        {
+            continue;
+        }
+        
+        if (NULL==(tmp=NDRX_REALLOC(M_base, sizeof(bench_base_t)*(M_nbase+1))))
+        {
+            fprintf(stderr, "realloc failed: %s\n", strerror(errno));
+            EXFAIL_OUT(ret);
+        }
+        M_base = tmp;
+        
+        *p = EXEOS;
+        NDRX_STRCPY_SAFE(M_base[M_nbase].name, line);
+        
+        if (NULL==(p=strchr(p+1, ',')))
+        {
+            continue;
+        }
+        
+        M_base[M_nbase].ns = atof(p+1);
+        M_nbase++;
+    }
+    
+out:
+    if (NULL!=f)
+    {
+        NDRX_FCLOSE(f);
+    }
+
+    return ret;
+}
+
+/**
+ * Print usage
+ * @param bin binary name
+ */
+exprivate void usage(char *bin)
+{
+    fprintf(stderr, "Usage: %s [options]\n", bin);
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  -t <msec>        Run time per scenario, default %d\n", 
+            BENCH_MINTIME_MS);
+    fprintf(stderr, "  -n <n1,n2,..>    Buffer sizes (number of fields), default 10,100,1000,10000\n");
+    fprintf(stderr, "  -f <substr>      Run only scenarios containing the string\n");
+    fprintf(stderr, "  -o <file>        Save results (CSV) to file, can be used as baseline\n");
+    fprintf(stderr, "  -b <file>        Compare with baseline results\n");
+    fprintf(stderr, "  -T <pct>         Regression threshold in percents, default %.0lf\n", 
+            BENCH_THRESHOLD);
+}
+
+/**
+ * Benchmark entry. Exit code is 1 if regressions found against baseline
+ */
+int main(int argc, char** argv)
+{
+    int ret = EXSUCCEED;
+    int c;
+    char *tok;
+    
+    /* debug logging would dominate the timings */
+    if (NULL==getenv(CONF_NDRX_DEBUG_CONF))
+    {
+        tplogconfig(LOG_FACILITY_NDRX|LOG_FACILITY_UBF, log_error, NULL, 
+                NULL, NULL);
+    }
+    
+    while ((c = getopt (argc, argv, "t:n:f:o:b:T:h")) != -1)
+    {
+        switch (c)
+        {
+            case 't':
+                M_mintime = atoi(optarg);
+                break;
+            case 'n':
+                M_nsizes = 0;
+                for (tok=strtok(optarg, ","); NULL!=tok && M_nsizes < N_DIM(M_sizes); 
+                        tok=strtok(NULL, ","))
+                {
+                    if ((M_sizes[M_nsizes] = atoi(tok)) > 0)
+                    {
+                        M_nsizes++;
+                    }
+                }
+                break;
+            case 'f':
+                M_filter = optarg;
+                break;
+            case 'o':
+                if (NULL==(M_out=NDRX_FOPEN(optarg, "w")))
+                {
+                    fprintf(stderr, "Failed to open [%s]: %s\n", optarg, 
+                            strerror(errno));
+                    EXFAIL_OUT(ret);
+                }
+                fprintf(M_out, "%s\n", BENCH_HEADER);
+                break;
+            case 'b':
+                if (EXSUCCEED!=base_load(optarg))
+                {
+                    EXFAIL_OUT(ret);
+                }
+                break;
+            case 'T':
+                M_threshold = atof(optarg);
+                break;
+            default:
+                usage(argv[0]);
+                EXFAIL_OUT(ret);
+        }
+    }
+    
+    if (NULL!=M_base)
+    {
+        printf("%-45s %12s %12s %9s\n", "name", "base_ns", "ns_per_op", "delta");
+    }
+    else
+    {
+        printf("%s\n", BENCH_HEADER);
+    }
+    
+    if (EXSUCCEED!=run_all())
+    {
+        EXFAIL_OUT(ret);
+    }
+    
+    if (M_regressions > 0)
+    {
+        fprintf(stderr, "%d regressions over %.1lf%%\n", M_regressions, 
+                M_threshold);
+        ret = EXFAIL;
+    }
+    
+out:
+    if (NULL!=M_out)
+    {
+        NDRX_FCLOSE(M_out);
+    }
+
+    if (NULL!=M_base)
+    {
+        NDRX_FREE(M_base);
+    }
+
+    return EXSUCCEED==ret?EXSUCCEED:1;
+}
+
+/* vim: set ts=4 sw=4 et smartindent: */
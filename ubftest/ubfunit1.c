@@ -669,6 +669,8 @@ int main(int argc, char** argv)
     add_suite(suite, test_nstd_macros());
     add_suite(suite, ubf_nstd_crypto());
     add_suite(suite, ubf_nstd_base64());
+    add_suite(suite, ubf_nstd_lz());
+    add_suite(suite, ubf_nstd_ccsnap());
     add_suite(suite, ubf_nstd_growlist());
     
     add_suite(suite, ubf_nstd_mtest());
@@ -96,6 +96,8 @@ extern TestSuite *ubf_bojoin_tests(void);
 /* Standard library suites */
 extern TestSuite *ubf_nstd_crypto(void);
 extern TestSuite *ubf_nstd_base64(void);
+extern TestSuite *ubf_nstd_lz(void);
+extern TestSuite *ubf_nstd_ccsnap(void);
 extern TestSuite *ubf_nstd_growlist(void);
 
 extern TestSuite *ubf_nstd_mtest(void);
@@ -0,0 +1,200 @@
+/**
+ * @brief `calltrace' Print completed call traces
+ *
+ * @file cmd_calltrace.c
+ */
+/* -----------------------------------------------------------------------------
+ * Enduro/X Middleware Platform for Distributed Transaction Processing
+ * Copyright (C) 2009-2016, ATR Baltic, Ltd. All Rights Reserved.
+ * Copyright (C) 2017-2019, Mavimax, Ltd. All Rights Reserved.
+ * This software is released under one of the following licenses:
+ * AGPL (with Java and Go exceptions) or Mavimax's license for commercial use.
+ * See LICENSE file for full text.
+ * -----------------------------------------------------------------------------
+ * AGPL license:
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License, version 3 as published
+ * by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU Affero General Public License, version 3
+ * for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along 
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * -----------------------------------------------------------------------------
+ * A commercial use license is available from Mavimax, Ltd
+ * contact@mavimax.com
+ * -----------------------------------------------------------------------------
+ */
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <memory.h>
+#include <sys/types.h>
+#include <ndrstandard.h>
+#include <ndebug.h>
+
+#include <ndrx.h>
+#include <ndrxdcmn.h>
+#include <atmi_int.h>
+#include <nclopt.h>
+/*---------------------------Externs------------------------------------*/
+/*---------------------------Macros-------------------------------------*/
+#define READ_CHUNK      64      /**< Records read from ring at once */
+/*---------------------------Enums--------------------------------------*/
+/*---------------------------Typedefs-----------------------------------*/
+/*---------------------------Globals------------------------------------*/
+/*---------------------------Statics------------------------------------*/
+/*---------------------------Prototypes---------------------------------*/
+
+/**
+ * Print header
+ */
+exprivate void print_hdr(void)
+{
+    fprintf(stderr, "TRACE_ID            SPAN_ID             PARENT_ID           "
+            "SERVICE                         ND   TOTAL_US\n");
+    fprintf(stderr, "------------------- ------------------- ------------------- "
+            "------------------------------- --- ----------\n");
+}
+
+/**
+ * Hop kind name
+ * @param kind NDRX_TRACE_HOP_*
+ * @return name
+ */
+exprivate char *hop_name(short kind)
+{
+    switch (kind)
+    {
+        case NDRX_TRACE_HOP_ENQ:
+            return "enq";
+        case NDRX_TRACE_HOP_DEQ:
+            return "deq";
+        case NDRX_TRACE_HOP_SVCSTART:
+            return "start";
+        case NDRX_TRACE_HOP_SVCEND:
+            return "end";
+        case NDRX_TRACE_HOP_FWD:
+            return "fwd";
+        case NDRX_TRACE_HOP_BROUT:
+            return "brout";
+        case NDRX_TRACE_HOP_BRIN:
+            return "brin";
+        case NDRX_TRACE_HOP_RPLDEQ:
+            return "rply";
+        default:
+            return "?";
+    }
+}
+
+/**
+ * Print the call trace: summary line and hops, each with usec spent since
+ * the previous hop
+ * @param rec trace record
+ */
+exprivate void print_rec(ndrx_calltrace_rec_t *rec)
+{
+    int i;
+    int prev = 0;
+    
+    fprintf(stdout, "%-19ld %-19ld %-19ld %-31.31s %3hd %10d\n",
+            rec->trace_id, rec->span_id, rec->parent_id, rec->svcnm,
+            rec->nodeid, rec->nhops>0?rec->hops[rec->nhops-1].usec:0);
+    
+    fprintf(stdout, "   ");
+    
+    for (i=0; i<rec->nhops; i++)
+    {
+        fprintf(stdout, " %s@%hd+%d", hop_name(rec->hops[i].kind),
+                rec->hops[i].nodeid, rec->hops[i].usec - prev);
+        prev = rec->hops[i].usec;
+    }
+    
+    fprintf(stdout, "\n");
+}
+
+/**
+ * Print completed call traces from the local trace ring
+ * @param p_cmd_map
+ * @param argc
+ * @param argv
+ * @return SUCCEED
+ */
+expublic int cmd_calltrace(cmd_mapping_t *p_cmd_map, int argc, char **argv, int *p_have_next)
+{
+    int ret=EXSUCCEED;
+    long trace_id = 0;
+    unsigned long seq = 0;
+    ndrx_calltrace_rec_t *recs = NULL;
+    int n;
+    int i;
+    int total = 0;
+    ncloptmap_t clopt[] =
+    {
+        {'t', BFLD_LONG, (void *)&trace_id, sizeof(trace_id), 
+                                NCLOPT_OPT|NCLOPT_HAVE_VALUE, "Print given trace only"},
+        {0}
+    };
+    
+    /* parse command line */
+    if (nstd_parse_clopt(clopt, EXTRUE,  argc, argv, EXFALSE))
+    {
+        fprintf(stderr, XADMIN_INVALID_OPTIONS_MSG);
+        EXFAIL_OUT(ret);
+    }
+    
+    if (EXFAIL==tpinit(NULL))
+    {
+        fprintf(stderr, "* Failed to become client\n");
+        EXFAIL_OUT(ret);
+    }
+    
+    if (NULL==(recs=NDRX_MALLOC(sizeof(ndrx_calltrace_rec_t)*READ_CHUNK)))
+    {
+        fprintf(stderr, "* Failed to malloc: %s\n", strerror(errno));
+        EXFAIL_OUT(ret);
+    }
+    
+    print_hdr();
+    
+    while ((n=ndrx_calltrace_read(&seq, recs, READ_CHUNK)) > 0)
+    {
+        for (i=0; i<n; i++)
+        {
+            if (0==trace_id || recs[i].trace_id==trace_id)
+            {
+                print_rec(&recs[i]);
+                total++;
+            }
+        }
+    }
+    
+    if (EXFAIL==n)
+    {
+        fprintf(stderr, "* Failed to read call trace ring\n");
+        EXFAIL_OUT(ret);
+    }
+    
+    fprintf(stderr, "\nTOTAL: %d\n", total);
+    
+out:
+    
+    if (NULL!=recs)
+    {
+        NDRX_FREE(recs);
+    }
+
+    return ret;
+}
+/* vim: set ts=4 sw=4 et smartindent: */
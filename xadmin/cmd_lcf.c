@@ -133,6 +133,40 @@ expublic int ndrx_xadmin_lcf_init(void)
         EXFAIL_OUT(ret);
     }
     
+    /* fast pool allocator stats: */
+    memset(&xcmd, 0, sizeof(xcmd));
+    
+    xcmd.version = NDRX_LCF_XCMD_VERSION;
+    xcmd.command = NDRX_LCF_CMD_FPASTATS;
+    NDRX_STRCPY_SAFE(xcmd.cmdstr, NDRX_LCF_CMDSTR_FPASTATS);
+    xcmd.dfltslot = NDRX_LCF_SLOT_FPASTATS;
+    xcmd.dfltflags = NDRX_LCF_FLAG_ALL;
+    NDRX_STRCPY_SAFE(xcmd.helpstr, "Write memory pool stats to ULOG");
+
+    if (EXSUCCEED!=ndrx_lcf_xadmin_add_int(&xcmd))
+    {
+        NDRX_LOG(log_error, "Failed to register %d [%s] LCF command: %s",
+                xcmd.command, xcmd.cmdstr, Nstrerror(Nerror));
+        EXFAIL_OUT(ret);
+    }
+    
+    /* UBF expression cache stats: */
+    memset(&xcmd, 0, sizeof(xcmd));
+    
+    xcmd.version = NDRX_LCF_XCMD_VERSION;
+    xcmd.command = NDRX_LCF_CMD_EXPRSTATS;
+    NDRX_STRCPY_SAFE(xcmd.cmdstr, NDRX_LCF_CMDSTR_EXPRSTATS);
+    xcmd.dfltslot = NDRX_LCF_SLOT_EXPRSTATS;
+    xcmd.dfltflags = NDRX_LCF_FLAG_ALL;
+    NDRX_STRCPY_SAFE(xcmd.helpstr, "Write UBF expression cache stats to ULOG");
+
+    if (EXSUCCEED!=ndrx_lcf_xadmin_add_int(&xcmd))
+    {
+        NDRX_LOG(log_error, "Failed to register %d [%s] LCF command: %s",
+                xcmd.command, xcmd.cmdstr, Nstrerror(Nerror));
+        EXFAIL_OUT(ret);
+    }
+    
 out:
     return ret;
 }
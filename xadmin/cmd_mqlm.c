@@ -66,8 +66,8 @@ exprivate char M_qspace[XATMI_SERVICE_NAME_LENGTH+1] = "";
  */
 exprivate void print_hdr(void)
 {
-    fprintf(stderr, "Nd SRVID MSGID (STR/Base64 mod)                            TSTAMP (UTC) TRIES L\n");
-    fprintf(stderr, "-- ----- -------------------------------------------- ----------------- ----- -\n");
+    fprintf(stderr, "Nd SRVID MSGID (STR/Base64 mod)                            TSTAMP (UTC) TRIES L PRIO DEQ TIME (UTC)\n");
+    fprintf(stderr, "-- ----- -------------------------------------------- ----------------- ----- - ---- -----------------\n");
 }
 
 /**
@@ -89,6 +89,8 @@ exprivate int print_buffer(UBFH *p_ub, char *svcnm)
     char tstamp2[20];
     long tires;
     short is_locked;
+    long prio = 0;
+    long deq_time = 0;
     
     if (
             EXSUCCEED!=Bget(p_ub, TMNODEID, 0, (char *)&nodeid, 0L) ||
@@ -105,14 +107,20 @@ exprivate int print_buffer(UBFH *p_ub, char *svcnm)
                 Bstrerror(Berror));
         EXFAIL_OUT(ret);
     }    
+    
+    /* optional, not returned by older versions */
+    Bget(p_ub, EX_QPRIORITY, 0, (char *)&prio, 0L);
+    Bget(p_ub, EX_QDEQ_TIME, 0, (char *)&deq_time, 0L);
        
-    fprintf(stdout, "%2d %5d %-44.44s %17.17s %5.5s %s",
+    fprintf(stdout, "%2d %5d %-44.44s %17.17s %5.5s %s %4ld %17.17s",
             nodeid, 
             srvid, 
             msgid_str,
             tstamp1+2, 
             ndrx_decode_num(tires, 0, 0, 1),
-            is_locked?"Y":"N"
+            is_locked?"Y":"N",
+            prio,
+            deq_time > 0 ? ndrx_get_strtstamp2(0, deq_time, 0)+2 : "-"
             );
     
     printf("\n");
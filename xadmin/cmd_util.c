@@ -45,6 +45,7 @@
 #include <atmi_int.h>
 #include <gencall.h>
 #include <utlist.h>
+#include <nstd_int.h>
 
 #include "nclopt.h"
 /*---------------------------Externs------------------------------------*/
@@ -178,4 +179,64 @@ out:
 
     return ret;
 }
+/**
+ * Decode binary trace file to text log format
+ * @param p_cmd_map
+ * @param argc
+ * @param argv trace file, optional output file (default stdout)
+ * @return SUCCEED/FAIL
+ */
+expublic int cmd_logdec(cmd_mapping_t *p_cmd_map, int argc, char **argv, int *p_have_next)
+{
+    int ret=EXSUCCEED;
+    FILE *in = NULL;
+    FILE *out = stdout;
+    
+    if (argc < 2 || argc > 3)
+    {
+        fprintf(stderr, XADMIN_INVALID_OPTIONS_MSG);
+        EXFAIL_OUT(ret);
+    }
+    
+    if (NULL==(in = NDRX_FOPEN(argv[1], "r")))
+    {
+        fprintf(stderr, NDRX_XADMIN_ERR_FMT_PFX "Failed to open [%s]: %s\n", 
+                argv[1], strerror(errno));
+        EXFAIL_OUT(ret);
+    }
+    
+    if (3==argc && NULL==(out = NDRX_FOPEN(argv[2], "w")))
+    {
+        fprintf(stderr, NDRX_XADMIN_ERR_FMT_PFX "Failed to open [%s]: %s\n", 
+                argv[2], strerror(errno));
+        out = NULL;
+        EXFAIL_OUT(ret);
+    }
+    
+    if (EXSUCCEED!=ndrx_dbgbin_decode(in, out))
+    {
+        fprintf(stderr, NDRX_XADMIN_ERR_FMT_PFX "Failed to decode [%s]\n", 
+                argv[1]);
+        EXFAIL_OUT(ret);
+    }
+    
+out:
+    
+    if (NULL!=in)
+    {
+        NDRX_FCLOSE(in);
+    }
+
+    if (NULL!=out && stdout!=out)
+    {
+        NDRX_FCLOSE(out);
+    }
+    else if (NULL!=out)
+    {
+        fflush(out);
+    }
+
+    return ret;
+}
+
 /* vim: set ts=4 sw=4 et smartindent: */
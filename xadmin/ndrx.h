@@ -275,6 +275,7 @@ extern int cmd_svsemids(cmd_mapping_t *p_cmd_map, int argc, char **argv, int *p_
 
 /* Utils: */
 extern int cmd_ps(cmd_mapping_t *p_cmd_map, int argc, char **argv, int *p_have_next);
+extern int cmd_logdec(cmd_mapping_t *p_cmd_map, int argc, char **argv, int *p_have_next);
 
 /* appconfig: */
 extern int cmd_appconfig(cmd_mapping_t *p_cmd_map, int argc, char **argv, int *p_have_next);
@@ -293,6 +294,7 @@ extern int cmd_lcf_completion(linenoiseCompletions *lc, char *buf);
 
 extern int cmd_shmcfg(cmd_mapping_t *p_cmd_map, int argc, char **argv, int *p_have_next);
 extern int cmd_prtsvc(cmd_mapping_t *p_cmd_map, int argc, char **argv, int *p_have_next);
+extern int cmd_calltrace(cmd_mapping_t *p_cmd_map, int argc, char **argv, int *p_have_next);
 
 /* TMIB: */
 extern int cmd_mibget(cmd_mapping_t *p_cmd_map, int argc, char **argv, int *p_have_next);
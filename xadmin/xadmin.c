@@ -480,6 +480,16 @@ cmd_mapping_t M_command_map[] =
                 "\t\t -i\tPrint in use slots\n"
                 "\t\t -w\tPrint was in use slots",
                 NULL},
+    {"logdec",     cmd_logdec,   EXFAIL,    1,  0, 
+                "Decode binary trace file (debug.conf binary=Y) to text\n"
+                "\tUsage: logdec TRACE_FILE [OUTPUT_FILE]",
+                NULL},
+    {"calltrace",  cmd_calltrace, EXFAIL,   1,  0, 
+                "Print completed call traces (NDRX_TRACESAMPLE) of local node\n"
+                "\tUsage: calltrace [OPTION]...\n"
+                "\tOptional arguments: \n"
+                "\t\t -t\tPrint given TRACE_ID only",
+                NULL},
 };
 
 /*
@@ -496,6 +506,7 @@ char *M_noinit[] = {
     ,"gen"
     ,"ps"
     ,"pmode"
+    ,"logdec"
 };
 
 /**